@@ -71,6 +71,23 @@ endif
 # Addresses CVE-2017-5715 (aka Meltdown) known to affect Arm Cortex-A75
 CFG_CORE_UNMAP_CORE_AT_EL0 ?= y
 
+# Copies to and from user mode buffers with unprivileged loads and stores,
+# the MMU checks the user buffer during the copy instead of the buffer
+# being checked against the regions of the TA first. AArch64 only, not
+# supported with the pager.
+ifeq ($(CFG_ARM64_core)-$(CFG_WITH_PAGER)-$(CFG_WITH_USER_TA),y-n-y)
+CFG_CORE_USER_ACCESS_UNPRIV ?= y
+else
+$(call force,CFG_CORE_USER_ACCESS_UNPRIV,n)
+endif
+
+# Cache maintenance requested by TAs on buffers of at least this many
+# bytes cleans the whole cache instead of walking the buffer line by line.
+# The outer cache is always eligible, the inner caches only on single core
+# systems since set/way operations don't reach the caches of other CPUs.
+# Invalidation always works by range. 0 disables.
+CFG_CACHE_OP_FULL_THRESHOLD ?= (1024 * 1024)
+
 # Initialize PMCR.DP to 1 to prohibit cycle counting in secure state, and
 # save/restore PMCR during world switch.
 CFG_SM_NO_CYCLE_COUNTING ?= y
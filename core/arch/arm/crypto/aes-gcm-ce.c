@@ -27,24 +27,63 @@ static void put_be_block(void *dst, const void *src)
 	put_be64((uint8_t *)dst + 8, s[0]);
 }
 
-void internal_aes_gcm_set_key(struct internal_aes_gcm_state *state,
-			      const struct internal_aes_gcm_key *enc_key)
+/* Stores hash key @h in little endian and multiplied by 'x' in @k */
+static void ghash_reflect(uint8_t k[TEE_AES_BLOCK_SIZE],
+			  const uint8_t h[TEE_AES_BLOCK_SIZE])
 {
-	uint64_t k[2];
+	uint64_t r[2];
 	uint64_t a;
 	uint64_t b;
 
-	internal_aes_gcm_encrypt_block(enc_key, state->ctr, state->hash_subkey);
-
-	/* Store hash key in little endian and multiply by 'x' */
-	b = get_be64(state->hash_subkey);
-	a = get_be64(state->hash_subkey + 8);
-	k[0] = (a << 1) | (b >> 63);
-	k[1] = (b << 1) | (a >> 63);
+	b = get_be64(h);
+	a = get_be64(h + 8);
+	r[0] = (a << 1) | (b >> 63);
+	r[1] = (b << 1) | (a >> 63);
 	if (b >> 63)
-		k[1] ^= 0xc200000000000000UL;
+		r[1] ^= 0xc200000000000000UL;
 
-	memcpy(state->hash_subkey, k, TEE_AES_BLOCK_SIZE);
+	memcpy(k, r, TEE_AES_BLOCK_SIZE);
+}
+
+#if defined(ARM64) && defined(CFG_HWSUPP_PMULT_64)
+/*
+ * pmull_ghash_update_p64() aggregates four blocks with H^2, H^3 and H^4
+ * following H. GHASH of the single block H^n with a zero state is
+ * H^(n+1), so the powers are computed with the single block path of the
+ * function itself. @h is the hash subkey in big endian on entry.
+ */
+static void ghash_init_powers(struct internal_aes_gcm_state *state,
+			      uint8_t h[TEE_AES_BLOCK_SIZE])
+{
+	uint32_t vfp_state = 0;
+	uint64_t dg[2] = { 0 };
+	size_t n = 0;
+
+	vfp_state = thread_kernel_enable_vfp();
+	for (n = 0; n < ARRAY_SIZE(state->hash_subkey_pow); n++) {
+		dg[0] = 0;
+		dg[1] = 0;
+		pmull_ghash_update_p64(1, dg, h, (void *)state->hash_subkey,
+				       NULL);
+		put_be_block(h, dg);
+		ghash_reflect(state->hash_subkey_pow[n], h);
+	}
+	thread_kernel_disable_vfp(vfp_state);
+}
+#endif
+
+void internal_aes_gcm_set_key(struct internal_aes_gcm_state *state,
+			      const struct internal_aes_gcm_key *enc_key)
+{
+	uint8_t h[TEE_AES_BLOCK_SIZE];
+
+	internal_aes_gcm_encrypt_block(enc_key, state->ctr, h);
+	ghash_reflect(state->hash_subkey, h);
+
+#if defined(ARM64) && defined(CFG_HWSUPP_PMULT_64)
+	ghash_init_powers(state, h);
+#endif
+	memset(h, 0, sizeof(h));
 }
 
 void internal_aes_gcm_ghash_update(struct internal_aes_gcm_state *state,
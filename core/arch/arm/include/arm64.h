@@ -25,6 +25,10 @@
 
 #define CSSELR_LEVEL_SHIFT	1
 
+#define ID_AA64ISAR0_ATOMIC_SHIFT	20
+#define ID_AA64ISAR0_ATOMIC_MASK	0xf
+#define ID_AA64ISAR0_ATOMIC_LSE		0x2
+
 #define DAIFBIT_FIQ			BIT32(0)
 #define DAIFBIT_IRQ			BIT32(1)
 #define DAIFBIT_ABT			BIT32(2)
@@ -230,6 +234,21 @@ static inline void write_at_s1e1r(uint64_t va)
 	asm volatile ("at	S1E1R, %0" : : "r" (va));
 }
 
+static inline void write_at_s1e1w(uint64_t va)
+{
+	asm volatile ("at	S1E1W, %0" : : "r" (va));
+}
+
+static inline void write_at_s1e0r(uint64_t va)
+{
+	asm volatile ("at	S1E0R, %0" : : "r" (va));
+}
+
+static inline void write_at_s1e0w(uint64_t va)
+{
+	asm volatile ("at	S1E0W, %0" : : "r" (va));
+}
+
 static __always_inline uint64_t read_pc(void)
 {
 	uint64_t val;
@@ -317,6 +336,7 @@ DEFINE_U32_REG_READWRITE_FUNCS(fpsr)
 DEFINE_U32_REG_READ_FUNC(ctr_el0)
 DEFINE_U32_REG_READ_FUNC(contextidr_el1)
 DEFINE_U32_REG_READ_FUNC(sctlr_el1)
+DEFINE_U64_REG_READ_FUNC(id_aa64isar0_el1)
 
 /* ARM Generic timer functions */
 DEFINE_REG_READ_FUNC_(cntfrq, uint32_t, cntfrq_el0)
@@ -329,11 +349,20 @@ DEFINE_REG_READ_FUNC_(cntps_tval, uint32_t, cntps_tval_el1)
 DEFINE_REG_WRITE_FUNC_(cntps_tval, uint32_t, cntps_tval_el1)
 
 DEFINE_REG_READ_FUNC_(pmccntr, uint64_t, pmccntr_el0)
+DEFINE_REG_WRITE_FUNC_(pmccntr, uint64_t, pmccntr_el0)
+DEFINE_U32_REG_READWRITE_FUNCS(pmcr_el0)
+DEFINE_U32_REG_READWRITE_FUNCS(pmcntenset_el0)
+DEFINE_U32_REG_WRITE_FUNC(pmcntenclr_el0)
+DEFINE_U32_REG_READWRITE_FUNCS(pmselr_el0)
+DEFINE_U32_REG_READWRITE_FUNCS(pmxevtyper_el0)
+DEFINE_U32_REG_READWRITE_FUNCS(pmxevcntr_el0)
+DEFINE_U32_REG_READWRITE_FUNCS(pmccfiltr_el0)
 
 DEFINE_U64_REG_READWRITE_FUNCS(ttbr0_el1)
 DEFINE_U64_REG_READWRITE_FUNCS(ttbr1_el1)
 DEFINE_U64_REG_READWRITE_FUNCS(tcr_el1)
 
+DEFINE_U64_REG_READ_FUNC(elr_el1)
 DEFINE_U64_REG_READ_FUNC(esr_el1)
 DEFINE_U64_REG_READ_FUNC(far_el1)
 DEFINE_U64_REG_READ_FUNC(mpidr_el1)
@@ -341,6 +370,7 @@ DEFINE_U64_REG_READ_FUNC(midr_el1)
 /* Alias for reading this register to avoid ifdefs in code */
 #define read_midr() read_midr_el1()
 DEFINE_U64_REG_READ_FUNC(par_el1)
+DEFINE_U64_REG_READ_FUNC(spsr_el1)
 
 DEFINE_U64_REG_WRITE_FUNC(mair_el1)
 
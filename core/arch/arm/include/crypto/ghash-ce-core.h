@@ -8,6 +8,10 @@
 
 #include <inttypes.h>
 
+/*
+ * On ARM64 @k of pmull_ghash_update_p64() is followed by H^2, H^3 and H^4
+ * in the same format, used when four or more blocks are processed.
+ */
 void pmull_ghash_update_p64(int blocks, uint64_t dg[2], const uint8_t *src,
 			    const uint64_t k[2], const uint8_t *head);
 void pmull_ghash_update_p8(int blocks, uint64_t dg[2], const uint8_t *src,
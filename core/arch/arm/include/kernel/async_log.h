@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef KERNEL_ASYNC_LOG_H
+#define KERNEL_ASYNC_LOG_H
+
+/*
+ * With CFG_CORE_ASYNC_LOG=y, once boot is completed trace_ext_puts()
+ * queues the messages in a ring per CPU which is written to the console
+ * by deferred work, see <kernel/work_queue.h>.
+ */
+
+#ifdef CFG_CORE_ASYNC_LOG
+/*
+ * async_log_sync() - Write all queued messages to the console and write
+ * subsequent messages synchronously, used when panicking.
+ */
+void async_log_sync(void);
+#else
+static inline void async_log_sync(void)
+{
+}
+#endif
+
+#endif /*KERNEL_ASYNC_LOG_H*/
@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef KERNEL_BOOT_PROFILE_H
+#define KERNEL_BOOT_PROFILE_H
+
+#include <compiler.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+#define BOOT_PROFILE_NAME_LEN		32
+
+/*
+ * struct boot_profile_entry - Timing of a boot phase or an initcall
+ * @func:		Address of the initcall, 0 for a boot phase
+ * @name:		Name of the boot phase, empty for an initcall
+ * @depth:		Number of enclosing boot phases
+ * @result:		Return value of the initcall, TEE_SUCCESS for a boot
+ *			phase
+ * @start_ns:		Start time, relative to when the system counter
+ *			started counting
+ * @duration_ns:	Duration, 0 if the phase didn't complete
+ */
+struct boot_profile_entry {
+	uint64_t func;
+	char name[BOOT_PROFILE_NAME_LEN];
+	uint32_t depth;
+	uint32_t result;
+	uint64_t start_ns;
+	uint64_t duration_ns;
+};
+
+#ifdef CFG_BOOT_PROFILE
+/*
+ * boot_profile_begin() - Timestamp the start of a boot phase or initcall
+ * @name:	Name of the phase, a string literal, or NULL
+ * @func:	Address of the initcall, or 0
+ *
+ * Only the primary CPU is profiled, phases are expected to be properly
+ * nested. Returns the handle to pass to boot_profile_end().
+ */
+size_t boot_profile_begin(const char *name, vaddr_t func);
+
+/* Timestamp the end of a phase started with boot_profile_begin() */
+void boot_profile_end(size_t idx, TEE_Result result);
+
+/* Prints the timings recorded so far in the boot log */
+void boot_profile_print(void);
+
+/*
+ * boot_profile_get() - Get the timings recorded during boot
+ * @entries:	Output array
+ * @count:	[in] Number of entries in @entries, [out] number of entries
+ *		recorded
+ *
+ * Returns false if @entries is too small, @count is then updated with the
+ * required number of entries.
+ */
+bool boot_profile_get(struct boot_profile_entry *entries, size_t *count);
+#else
+static inline size_t boot_profile_begin(const char *name __unused,
+					vaddr_t func __unused)
+{
+	return 0;
+}
+
+static inline void boot_profile_end(size_t idx __unused,
+				    TEE_Result result __unused)
+{
+}
+
+static inline void boot_profile_print(void)
+{
+}
+
+static inline bool boot_profile_get(struct boot_profile_entry *entries
+					__unused, size_t *count)
+{
+	*count = 0;
+	return true;
+}
+#endif
+
+#endif /*KERNEL_BOOT_PROFILE_H*/
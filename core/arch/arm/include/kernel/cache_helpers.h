@@ -7,9 +7,21 @@
 #define __KERNEL_CACHE_HELPERS_H
 
 #ifndef __ASSEMBLER__
+#include <compiler.h>
 #include <types_ext.h>
 #endif
 
+/*
+ * Largest data cache line size of the supported cores. Data written by
+ * different cores is kept in separate lines of this size to avoid false
+ * sharing.
+ */
+#define CACHELINE_SIZE		64
+
+#ifndef __ASSEMBLER__
+#define __cacheline_aligned	__aligned(CACHELINE_SIZE)
+#endif
+
 /* Data Cache set/way op type defines */
 #define DCACHE_OP_INV		0x0
 #define DCACHE_OP_CLEAN_INV	0x1
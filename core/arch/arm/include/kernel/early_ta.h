@@ -6,6 +6,7 @@
 #define KERNEL_EARLY_TA_H
 
 #include <compiler.h>
+#include <util.h>
 #include <stdint.h>
 #include <tee_api_types.h>
 
@@ -13,9 +14,26 @@ struct early_ta {
 	TEE_UUID uuid;
 	uint32_t size;
 	uint32_t uncompressed_size; /* 0: not compressed */
-	const uint8_t ta[]; /* @size bytes */
+	const uint8_t *ta; /* @size bytes */
 };
 
+/*
+ * Uncompressed TAs are aligned on, and padded with zeroes up to,
+ * EARLY_TA_XIP_ALIGN bytes. With CFG_EARLY_TA_XIP=y their read-only
+ * segments are mapped directly into the TA.
+ */
+#define EARLY_TA_XIP_ALIGN		4096
+
+/*
+ * With CFG_EARLY_TA_COMPRESS_LZ4=y compressed TAs are made of blocks of
+ * EARLY_TA_LZ4_BLOCK_SIZE bytes, the last one may be shorter, compressed
+ * independently. Each block is preceded by a 32-bit little endian
+ * header, the length of the block and EARLY_TA_LZ4_STORED if the block
+ * is stored uncompressed.
+ */
+#define EARLY_TA_LZ4_BLOCK_SIZE		4096
+#define EARLY_TA_LZ4_STORED		BIT32(31)
+
 #define __early_ta __section(".rodata.early_ta" __SECTION_FLAGS_RODATA)
 
 #endif /* KERNEL_EARLY_TA_H */
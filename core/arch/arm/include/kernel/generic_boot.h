@@ -22,6 +22,30 @@ void generic_boot_init_primary(unsigned long pageable_part,
 void generic_boot_init_secondary(unsigned long nsec_entry);
 #endif
 
+typedef void (*boot_parallel_fn)(void *arg, size_t idx);
+
+/*
+ * boot_parallel_run() - Run a job on all CPUs available during boot
+ * @fn:		Called once for each index in [0, @count)
+ * @arg:	Argument passed to @fn
+ * @count:	Number of calls of @fn
+ *
+ * Called by the primary CPU during its initialization, which also takes
+ * part in the job. With CFG_BOOT_PARALLEL_INIT=y the secondary CPUs
+ * waiting in generic_boot_help_primary() take part too, @fn must then
+ * be safe to call concurrently and with CFG_WITH_PAGER=y only be called
+ * before paging starts. Returns when all calls of @fn have returned.
+ */
+void boot_parallel_run(boot_parallel_fn fn, void *arg, size_t count);
+
+#ifdef CFG_BOOT_PARALLEL_INIT
+/*
+ * Called by the secondary CPUs once their MMU is enabled, runs the jobs
+ * of boot_parallel_run() until the primary CPU is initialized.
+ */
+void generic_boot_help_primary(void);
+#endif
+
 void main_init_gic(void);
 void main_secondary_init_gic(void);
 
@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef KERNEL_LOCK_STATS_H
+#define KERNEL_LOCK_STATS_H
+
+#include <compiler.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOCK_STATS_TYPE_MUTEX		0
+#define LOCK_STATS_TYPE_MUTEX_READ	1
+#define LOCK_STATS_TYPE_SPINLOCK	2
+
+#define LOCK_STATS_FNAME_LEN		32
+
+/*
+ * struct lock_stats - Contention statistics of a lock taken at a site
+ * @lock:		Address of the lock
+ * @fname:		End of the file or function name of the site, empty
+ *			for the entry which accounts for the sites which
+ *			didn't fit
+ * @lineno:		Line number of the site
+ * @type:		LOCK_STATS_TYPE_*
+ * @acquired:		Number of times the lock was acquired
+ * @contended:		Number of times the lock was held by someone else
+ * @wait_ns:		Total time spent waiting for the lock
+ * @wait_max_ns:	Longest wait for the lock
+ * @hold_ns:		Total time the lock was held, not accounted for read
+ *			locks
+ * @hold_max_ns:	Longest time the lock was held
+ */
+struct lock_stats {
+	uint64_t lock;
+	char fname[LOCK_STATS_FNAME_LEN];
+	uint32_t lineno;
+	uint32_t type;
+	uint64_t acquired;
+	uint64_t contended;
+	uint64_t wait_ns;
+	uint64_t wait_max_ns;
+	uint64_t hold_ns;
+	uint64_t hold_max_ns;
+};
+
+struct lock_stats_site;
+
+#ifdef CFG_LOCK_STATS
+/* Timestamp in system counter ticks */
+uint64_t lock_stats_now(void);
+
+/*
+ * lock_stats_acquired() - Account for an acquisition of a lock
+ * @lock:	The lock
+ * @fname:	File or function name of the site taking the lock, or NULL
+ * @lineno:	Line number of the site
+ * @type:	LOCK_STATS_TYPE_*
+ * @begin:	Timestamp when the acquisition started
+ * @contended:	True if the lock was held by someone else
+ *
+ * Returns the site to pass to lock_stats_released() with the timestamp
+ * when the lock was acquired.
+ */
+struct lock_stats_site *lock_stats_acquired(const void *lock,
+					    const char *fname, int lineno,
+					    uint32_t type, uint64_t begin,
+					    bool contended);
+
+/* Accounts for the time @site held its lock since @acquired */
+void lock_stats_released(struct lock_stats_site *site, uint64_t acquired);
+
+/*
+ * lock_stats_get() - Get the statistics of all sites
+ * @stats:	Output array
+ * @count:	[in] Number of entries in @stats, [out] number of sites
+ * @reset:	If true, the statistics are cleared after being copied
+ *
+ * Returns false if @stats is too small, @count is then updated with the
+ * required number of entries.
+ */
+bool lock_stats_get(struct lock_stats *stats, size_t *count, bool reset);
+#else
+static inline uint64_t lock_stats_now(void)
+{
+	return 0;
+}
+
+static inline struct lock_stats_site *
+lock_stats_acquired(const void *lock __unused, const char *fname __unused,
+		    int lineno __unused, uint32_t type __unused,
+		    uint64_t begin __unused, bool contended __unused)
+{
+	return NULL;
+}
+
+static inline void lock_stats_released(struct lock_stats_site *site __unused,
+				       uint64_t acquired __unused)
+{
+}
+
+static inline bool lock_stats_get(struct lock_stats *stats __unused,
+				  size_t *count, bool reset __unused)
+{
+	*count = 0;
+	return true;
+}
+#endif
+
+#endif /*KERNEL_LOCK_STATS_H*/
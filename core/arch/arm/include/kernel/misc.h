@@ -9,6 +9,7 @@
 #include <arm.h>
 #include <assert.h>
 #include <kernel/thread.h>
+#include <string.h>
 #include <types_ext.h>
 
 size_t __get_core_pos(void);
@@ -25,6 +26,24 @@ static inline size_t get_core_pos(void)
 
 size_t get_core_pos_mpidr(uint32_t mpidr);
 
+/*
+ * zero_pages() - Zero whole pages
+ * @va:		Page aligned address of normal cacheable memory
+ * @len:	Number of bytes, a multiple of SMALL_PAGE_SIZE
+ *
+ * Uses DC ZVA on ARM64, which clears a cache line without reading it
+ * from memory, unless prohibited in which case it falls back to stores
+ * of pairs of zero registers. Must not be used with the MMU disabled.
+ */
+#ifdef ARM64
+void zero_pages(void *va, size_t len);
+#else
+static inline void zero_pages(void *va, size_t len)
+{
+	memset(va, 0, len);
+}
+#endif
+
 uint32_t read_mode_sp(int cpu_mode);
 uint32_t read_mode_lr(int cpu_mode);
 
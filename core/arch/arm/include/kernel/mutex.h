@@ -7,12 +7,21 @@
 
 #include <types_ext.h>
 #include <sys/queue.h>
+#include <kernel/lock_stats.h>
 #include <kernel/wait_queue.h>
 
 struct mutex {
 	unsigned spin_lock;	/* used when operating on this struct */
 	struct wait_queue wq;
 	short state;		/* -1: write, 0: unlocked, > 0: readers */
+#if CFG_MUTEX_SPIN_COUNT
+	short owner_id;		/* Thread holding the write lock */
+#endif
+#ifdef CFG_LOCK_STATS
+	/* Site and time of the write lock, only accessed by the owner */
+	struct lock_stats_site *stats_site;
+	uint64_t stats_time;
+#endif
 };
 #define MUTEX_INITIALIZER { .wq = WAIT_QUEUE_INITIALIZER }
 
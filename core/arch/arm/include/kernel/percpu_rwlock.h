@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+#ifndef KERNEL_PERCPU_RWLOCK_H
+#define KERNEL_PERCPU_RWLOCK_H
+
+#include <compiler.h>
+#include <kernel/cache_helpers.h>
+#include <kernel/mutex.h>
+#include <types_ext.h>
+
+/*
+ * Reader-writer lock for read-mostly data
+ *
+ * Readers only update a counter of the CPU they execute on, readers on
+ * different CPUs don't share any cache line as long as no writer is
+ * pending. A writer waits for the sum of the counters to reach zero and
+ * new readers wait for the writer, writers are preferred.
+ *
+ * A reader may be suspended and resumed on another CPU while holding the
+ * lock, only the sum of the counters is meaningful.
+ */
+struct percpu_rwlock_count {
+	long count;
+} __cacheline_aligned;
+
+struct percpu_rwlock {
+	struct mutex mu;
+	struct condvar cv;
+	bool writer;
+	struct percpu_rwlock_count cpu[CFG_TEE_CORE_NB_CORE];
+};
+
+#define PERCPU_RWLOCK_INITIALIZER \
+	{ .mu = MUTEX_INITIALIZER, .cv = CONDVAR_INITIALIZER }
+
+void percpu_rwlock_read_lock(struct percpu_rwlock *l);
+void percpu_rwlock_read_unlock(struct percpu_rwlock *l);
+void percpu_rwlock_write_lock(struct percpu_rwlock *l);
+void percpu_rwlock_write_unlock(struct percpu_rwlock *l);
+
+#endif /*KERNEL_PERCPU_RWLOCK_H*/
@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef KERNEL_PMU_H
+#define KERNEL_PMU_H
+
+#include <stdint.h>
+
+/* Architectural PMU events counted, in the order of pmu_stats::events */
+#define PMU_EVT_INST_RETIRED		0x08
+#define PMU_EVT_L1D_CACHE_REFILL	0x03
+#define PMU_EVT_L2D_CACHE_REFILL	0x17
+#define PMU_EVT_L1D_TLB_REFILL		0x05
+#define PMU_EVT_BR_MIS_PRED		0x10
+
+#define PMU_NUM_EVENTS			5
+
+/*
+ * struct pmu_stats - PMU counters accumulated while a session executes
+ * in user mode
+ * @cycles:	CPU cycles
+ * @events:	PMU_EVT_INST_RETIRED, PMU_EVT_L1D_CACHE_REFILL,
+ *		PMU_EVT_L2D_CACHE_REFILL, PMU_EVT_L1D_TLB_REFILL and
+ *		PMU_EVT_BR_MIS_PRED counts. Events beyond the number of
+ *		counters implemented by the CPU stay 0.
+ */
+struct pmu_stats {
+	uint64_t cycles;
+	uint64_t events[PMU_NUM_EVENTS];
+};
+
+/*
+ * Saves the PMU configuration of normal world and starts counting on the
+ * current CPU. Does nothing if counting is already started.
+ */
+void pmu_start(void);
+
+/*
+ * Stops counting on the current CPU, adds the counts to @stats unless
+ * NULL and restores the PMU configuration of normal world. Does nothing
+ * if counting isn't started.
+ */
+void pmu_stop(struct pmu_stats *stats);
+
+#endif /*KERNEL_PMU_H*/
@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef KERNEL_PROFILER_H
+#define KERNEL_PROFILER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <util.h>
+
+#define CORE_PROFILE_DEPTH		8
+
+/* The sampled PC is in a user TA, the call stack isn't unwound */
+#define CORE_PROFILE_FLAG_USER		BIT32(0)
+/* The timer fired while normal world was executing, no PC is recorded */
+#define CORE_PROFILE_FLAG_NSEC		BIT32(1)
+/* Samples which didn't fit in the table, no PC is recorded */
+#define CORE_PROFILE_FLAG_DROPPED	BIT32(2)
+
+/*
+ * struct core_profile_stack - Samples of a unique call stack
+ * @count:	Number of samples
+ * @thread:	Thread ID, -1 if no thread was active
+ * @depth:	Number of valid entries in @pc
+ * @session:	ID of the current session, 0 if none
+ * @flags:	CORE_PROFILE_FLAG_*
+ * @pc:		@pc[0] is the sampled PC followed by the return addresses
+ *		of the callers
+ *
+ * Each entry is one line of a folded stack profile once the PCs are
+ * resolved to symbols.
+ */
+struct core_profile_stack {
+	uint32_t count;
+	int16_t thread;
+	uint16_t depth;
+	uint32_t session;
+	uint32_t flags;
+	uint64_t pc[CORE_PROFILE_DEPTH];
+};
+
+#ifdef CFG_CORE_PROFILER
+/*
+ * core_profiler_get() - Get the sampled call stacks
+ * @stacks:	Output array of sampled call stacks
+ * @count:	[in] Number of entries in @stacks, [out] number of sampled
+ *		call stacks
+ * @reset:	If true, the samples are cleared after being copied
+ *
+ * Returns false if @stacks is too small, @count is then updated with
+ * the required number of entries.
+ */
+bool core_profiler_get(struct core_profile_stack *stacks, size_t *count,
+		       bool reset);
+#else
+static inline bool
+core_profiler_get(struct core_profile_stack *stacks __unused, size_t *count,
+		  bool reset __unused)
+{
+	*count = 0;
+	return true;
+}
+#endif
+
+#endif /*KERNEL_PROFILER_H*/
@@ -60,5 +60,14 @@ static inline struct pseudo_ta_ctx *to_pseudo_ta_ctx(struct tee_ta_ctx *ctx)
 TEE_Result tee_ta_init_pseudo_ta_session(const TEE_UUID *uuid,
 			struct tee_ta_session *s);
 
+/*
+ * Calls the command entry point of the pseudo TA of session @s directly,
+ * with @params already resolved by the caller. Only for pseudo TAs flagged
+ * TA_FLAG_CONCURRENT, the context isn't made busy.
+ */
+TEE_Result pseudo_ta_invoke_direct(struct tee_ta_session *s, uint32_t cmd,
+				   uint32_t param_types,
+				   TEE_Param params[TEE_NUM_PARAMS]);
+
 #endif /* KERNEL_PSEUDO_TA_H */
 
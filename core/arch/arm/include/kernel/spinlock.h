@@ -11,6 +11,7 @@
 #define SPINLOCK_UNLOCK     0
 
 #ifndef __ASSEMBLER__
+#include <arm.h>
 #include <assert.h>
 #include <compiler.h>
 #include <stdbool.h>
@@ -129,6 +130,71 @@ static inline void cpu_spin_unlock_xrestore(unsigned int *lock,
 	cpu_spin_unlock(lock);
 	thread_unmask_exceptions(exceptions);
 }
+
+/*
+ * Ticket lock, an alternative to the spinlock above for heavily contended
+ * locks. The lock is granted in the order it was requested in, which
+ * bounds the wait of each CPU, and waiters only read the owner field
+ * until it's their turn. The ticket is taken with a single LDADDA when
+ * compiled for ARMv8.1 or later, else with an exclusive load/store loop.
+ */
+struct cpu_ticket_lock {
+	unsigned int next;
+	unsigned int owner;
+};
+
+#define CPU_TICKET_LOCK_INITIALIZER { .next = 0, .owner = 0 }
+
+static inline void cpu_ticket_lock(struct cpu_ticket_lock *l)
+{
+	unsigned int ticket = 0;
+
+	assert(thread_foreign_intr_disabled());
+	ticket = __atomic_fetch_add(&l->next, 1, __ATOMIC_RELAXED);
+	while (__atomic_load_n(&l->owner, __ATOMIC_ACQUIRE) != ticket)
+		wfe();
+	spinlock_count_incr();
+}
+
+static inline bool cpu_ticket_trylock(struct cpu_ticket_lock *l)
+{
+	unsigned int owner = 0;
+	unsigned int next = 0;
+
+	assert(thread_foreign_intr_disabled());
+	owner = __atomic_load_n(&l->owner, __ATOMIC_RELAXED);
+	next = owner;
+	if (!__atomic_compare_exchange_n(&l->next, &next, owner + 1, false,
+					 __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return false;
+	spinlock_count_incr();
+	return true;
+}
+
+static inline void cpu_ticket_unlock(struct cpu_ticket_lock *l)
+{
+	assert(thread_foreign_intr_disabled());
+	__atomic_store_n(&l->owner, l->owner + 1, __ATOMIC_RELEASE);
+	/* Wake the waiters in wfe() */
+	dsb_ishst();
+	sev();
+	spinlock_count_decr();
+}
+
+static inline uint32_t cpu_ticket_lock_xsave(struct cpu_ticket_lock *l)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+
+	cpu_ticket_lock(l);
+	return exceptions;
+}
+
+static inline void cpu_ticket_unlock_xrestore(struct cpu_ticket_lock *l,
+					      uint32_t exceptions)
+{
+	cpu_ticket_unlock(l);
+	thread_unmask_exceptions(exceptions);
+}
 #endif /* __ASSEMBLER__ */
 
 #endif /* KERNEL_SPINLOCK_H */
@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef KERNEL_TELEMETRY_H
+#define KERNEL_TELEMETRY_H
+
+#include <compiler.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <tee_api_types.h>
+
+/*
+ * Counters in the telemetry page shared with normal world, see
+ * OPTEE_MSG_CMD_SET_TELEMETRY
+ */
+enum telemetry_counter {
+	TELEMETRY_RPC,
+	TELEMETRY_STORAGE,
+	TELEMETRY_NUM_COUNTERS,
+};
+
+#ifdef CFG_CORE_TELEMETRY
+/*
+ * Starts, or stops if @cookie is 0, updating the telemetry page at
+ * offset @offs in the registered shared memory named @cookie. On entry
+ * @size is the size of the buffer, if it's too small
+ * TEE_ERROR_SHORT_BUFFER is returned and @size updated with the size
+ * needed.
+ */
+TEE_Result telemetry_set_page(uint64_t cookie, size_t offs, size_t *size);
+
+/*
+ * Refreshes the telemetry page if it's registered and at least
+ * CFG_CORE_TELEMETRY_PERIOD_MS has passed since the last refresh.
+ * Called in thread context.
+ */
+void telemetry_update(void);
+
+void telemetry_count(enum telemetry_counter counter);
+
+/*
+ * Accounts the time the current core spends in secure world, called
+ * with foreign interrupts masked when a thread starts (@new_call true)
+ * or resumes and when it's freed or suspended.
+ */
+void telemetry_core_enter(bool new_call);
+void telemetry_core_exit(void);
+#else
+static inline TEE_Result telemetry_set_page(uint64_t cookie __unused,
+					    size_t offs __unused,
+					    size_t *size __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline void telemetry_update(void)
+{
+}
+
+static inline void telemetry_count(enum telemetry_counter counter __unused)
+{
+}
+
+static inline void telemetry_core_enter(bool new_call __unused)
+{
+}
+
+static inline void telemetry_core_exit(void)
+{
+}
+#endif
+
+#endif /*KERNEL_TELEMETRY_H*/
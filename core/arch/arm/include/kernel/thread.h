@@ -11,6 +11,7 @@
 #include <arm.h>
 #include <types_ext.h>
 #include <compiler.h>
+#include <kernel/cache_helpers.h>
 #include <kernel/mutex.h>
 #include <kernel/vfp.h>
 #include <mm/pgt_cache.h>
@@ -23,15 +24,12 @@
 
 #ifndef __ASSEMBLER__
 
-#ifdef ARM64
 /*
  * struct thread_core_local needs to have alignment suitable for a stack
- * pointer since SP_EL1 points to this
+ * pointer since SP_EL1 points to this. Each entry is written by its own
+ * core only, a cache line of its own keeps the cores from false sharing.
  */
-#define THREAD_CORE_LOCAL_ALIGNED __aligned(16)
-#else
-#define THREAD_CORE_LOCAL_ALIGNED __aligned(8)
-#endif
+#define THREAD_CORE_LOCAL_ALIGNED __cacheline_aligned
 
 struct thread_core_local {
 #ifdef ARM32
@@ -45,6 +43,10 @@ struct thread_core_local {
 	int curr_thread;
 	uint32_t flags;
 	vaddr_t abt_stack_va_end;
+#if defined(ARM64) && defined(CFG_CORE_PROFILER)
+	/* Frame pointer of the context interrupted by a native interrupt */
+	vaddr_t intr_fp;
+#endif
 #ifdef CFG_TEE_CORE_DEBUG
 	unsigned int locked_count; /* Number of spinlocks held */
 #endif
@@ -194,13 +196,20 @@ struct thread_svc_regs {
 } __aligned(16);
 #endif /*ARM64*/
 
+struct thread_rpc_fs_payload {
+	void *va;
+	struct mobj *mobj;
+	size_t size;
+	unsigned int last_use;
+};
+
 struct thread_specific_data {
 	TAILQ_HEAD(, tee_ta_session) sess_stack;
 	struct tee_ta_ctx *ctx;
 	struct pgt_cache pgt_cache;
-	void *rpc_fs_payload;
-	struct mobj *rpc_fs_payload_mobj;
-	size_t rpc_fs_payload_size;
+	struct thread_rpc_fs_payload rpc_fs_payload[
+					CFG_TEE_FS_RPC_CACHE_ENTRIES];
+	unsigned int rpc_fs_payload_tick;
 
 	uint32_t abort_type;
 	uint32_t abort_descr;
@@ -267,9 +276,50 @@ int thread_get_id(void);
  */
 int thread_get_id_may_fail(void);
 
+/*
+ * Returns true if thread @thread_id is currently executing on a CPU, the
+ * result is only a hint as the thread may be suspended at any time.
+ */
+bool thread_is_active(int thread_id);
+
 /* Returns Thread Specific Data (TSD) pointer. */
 struct thread_specific_data *thread_get_tsd(void);
 
+#ifdef CFG_THREAD_QUANTUM
+/*
+ * Returns true if the current thread has run at least
+ * CFG_THREAD_QUANTUM_US since it last entered secure world.
+ */
+bool thread_quantum_expired(void);
+
+/*
+ * Returns to normal world, as for a foreign interrupt, if the quantum of
+ * the current thread has expired. Does nothing if not called from a std
+ * call thread with foreign interrupts unmasked. Meant to be called at
+ * safe points of long operations.
+ */
+void thread_yield(void);
+
+/*
+ * Accounts the time run by the current thread so far to the current
+ * session, called before the current session changes.
+ */
+void thread_account_run_time(void);
+#else
+static inline bool thread_quantum_expired(void)
+{
+	return false;
+}
+
+static inline void thread_yield(void)
+{
+}
+
+static inline void thread_account_run_time(void)
+{
+}
+#endif
+
 /*
  * Sets foreign interrupts status for current thread, must only be called
  * from an active thread context.
@@ -343,8 +393,12 @@ static inline bool thread_foreign_intr_disabled(void)
  * entered before thread_kernel_disable_vfp() has been called to disable VFP
  * and restore the foreign interrupt status.
  *
- * This function may only be called from an active thread context and may
- * not be called again before thread_kernel_disable_vfp() has been called.
+ * This function may only be called from an active thread context. Calls
+ * may be nested, only the outermost call saves the VFP state and enables
+ * VFP, and VFP remains enabled until the matching outermost
+ * thread_kernel_disable_vfp(). A sequence of small operations each
+ * enabling VFP can be wrapped in an outer call to keep VFP enabled in
+ * between.
  *
  * VFP state is saved as needed.
  *
@@ -358,7 +412,7 @@ uint32_t thread_kernel_enable_vfp(void);
  * @state:	state variable returned by thread_kernel_enable_vfp()
  *
  * Disables usage of VFP and restores foreign interrupt status after a call to
- * thread_kernel_enable_vfp().
+ * thread_kernel_enable_vfp(). Nested calls leave VFP enabled.
  *
  * This function may only be called after a call to
  * thread_kernel_enable_vfp().
@@ -546,6 +600,58 @@ bool thread_disable_prealloc_rpc_cache(uint64_t *cookie);
  */
 bool thread_enable_prealloc_rpc_cache(void);
 
+struct thread_alloc_stats {
+	uint32_t num_threads;	/* CFG_NUM_THREADS */
+	uint32_t free_threads;	/* Threads currently free */
+	uint32_t limit_count;	/* Rejected with ETHREAD_LIMIT */
+	uint32_t heap_stacks;	/* Thread stacks allocated from the heap */
+};
+
+/* Returns statistics on allocation of thread contexts */
+void thread_get_alloc_stats(struct thread_alloc_stats *stats);
+
+struct thread_rpc_cache_stats {
+	uint32_t arg_allocs;	/* RPC arguments allocated with an RPC */
+};
+
+/* Returns statistics on the prealloc RPC cache */
+void thread_get_rpc_cache_stats(struct thread_rpc_cache_stats *stats);
+
+/*
+ * Statistics of the RPCs issued with thread_rpc_cmd(), indexed by
+ * OPTEE_RPC_CMD_* up to OPTEE_RPC_CMD_FTRACE, all other commands are
+ * accounted in the last entry.
+ */
+#define THREAD_RPC_STATS_NUM_CMDS	13
+
+struct thread_rpc_cmd_stats {
+	uint32_t count;		/* Number of RPCs */
+	uint32_t max_us;	/* Longest RPC */
+	uint64_t time_us;	/* Total time spent in normal world */
+};
+
+struct thread_rpc_stats {
+	struct thread_rpc_cmd_stats cmd[THREAD_RPC_STATS_NUM_CMDS];
+};
+
+#ifdef CFG_THREAD_RPC_STATS
+/*
+ * Returns statistics on the RPCs of all sessions if @session_id is 0, else
+ * of the normal world session @session_id. If @reset is true, the
+ * statistics are cleared after being copied.
+ */
+TEE_Result thread_get_rpc_stats(uint32_t session_id,
+				struct thread_rpc_stats *stats, bool reset);
+#else
+static inline TEE_Result
+thread_get_rpc_stats(uint32_t session_id __unused,
+		     struct thread_rpc_stats *stats __unused,
+		     bool reset __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
 /**
  * Allocates data for payload buffers.
  *
@@ -9,12 +9,16 @@ struct time_source {
 	const char *name;
 	uint32_t protection_level;
 	TEE_Result (*get_sys_time)(TEE_Time *time);
+	/* Optional, called once when the time source is registered */
+	void (*init)(void);
 };
 void time_source_init(void);
 
 #define REGISTER_TIME_SOURCE(source)	\
 	void time_source_init(void) { \
 		_time_source = source; \
+		if (_time_source.init) \
+			_time_source.init(); \
 	}
 
 extern struct time_source _time_source;
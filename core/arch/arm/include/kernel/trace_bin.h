@@ -0,0 +1,29 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef KERNEL_TRACE_BIN_H
+#define KERNEL_TRACE_BIN_H
+
+#include <stddef.h>
+#include <tee_api_types.h>
+
+/*
+ * With CFG_CORE_BINARY_TRACE=y, trace_bin_printf() logs IMSG(), DMSG()
+ * and FMSG() messages as binary records in a ring per CPU.
+ */
+
+/*
+ * trace_bin_read() - Move logged records out of the rings
+ * @buf:	Output buffer
+ * @len:	On entry size of @buf, on return the number of bytes written
+ *
+ * Writes for each CPU a struct pta_trace_log_hdr followed by as many
+ * complete records as fit, see PTA_TRACE_GET_LOG. Returns
+ * TEE_ERROR_SHORT_BUFFER with the size needed for the headers in @len if
+ * @buf can't hold them. Only one caller at a time.
+ */
+TEE_Result trace_bin_read(void *buf, size_t *len);
+
+#endif /*KERNEL_TRACE_BIN_H*/
@@ -0,0 +1,29 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef KERNEL_USER_ACCESS_H
+#define KERNEL_USER_ACCESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef CFG_CORE_USER_ACCESS_UNPRIV
+/*
+ * Copies between a kernel buffer and a buffer of the current user mode
+ * context using unprivileged loads and stores. The user buffer is checked
+ * by the MMU while copying instead of against the regions of the context
+ * beforehand. Returns the number of bytes not copied, 0 on success.
+ */
+size_t __copy_from_user_unpriv(void *kaddr, const void *uaddr, size_t len);
+size_t __copy_to_user_unpriv(void *uaddr, const void *kaddr, size_t len);
+
+/* The copy functions above are between these labels */
+extern const uint8_t __user_access_start[];
+extern const uint8_t __user_access_end[];
+/* Where a fault in the copy functions returns to */
+extern const uint8_t __user_access_fixup[];
+#endif
+
+#endif /*KERNEL_USER_ACCESS_H*/
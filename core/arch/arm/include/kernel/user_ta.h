@@ -6,6 +6,7 @@
 #define KERNEL_USER_TA_H
 
 #include <assert.h>
+#include <kernel/handle.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread.h>
 #include <mm/file.h>
@@ -20,20 +21,27 @@ TAILQ_HEAD(tee_obj_head, tee_obj);
 TAILQ_HEAD(tee_storage_enum_head, tee_storage_enum);
 SLIST_HEAD(load_seg_head, load_seg);
 
+struct tee_file_operations;
+
 /*
  * struct user_ta_ctx - user TA context
  * @entry_func:		Entry address in TA
  * @dump_entry_func:	Entry address in TA for dumping address mappings
  *			and stack trace
  * @ftrace_entry_func:	Entry address in ldelf for dumping ftrace data
+ * @ftrace_stream:	State of the drain of the ftrace ring
  * @ldelf_stack_ptr:	Stack pointer used for dumping address mappings and
  *			stack trace
  * @is_32bit:		True if 32-bit TA, false if 64-bit TA
  * @is_initializing:	True if TA is not fully loaded
  * @open_sessions:	List of sessions opened by this TA
  * @cryp_states:	List of cryp states created by this TA
+ * @cryp_state_db:	Handles of the cryp states in @cryp_states
  * @objects:		List of storage objects opened by this TA
+ * @object_db:		Handles of the objects in @objects
  * @storage_enums:	List of storage enumerators opened by this TA
+ * @storage_txn_fops:	File system with a storage transaction started by
+ *			this TA or NULL
  * @stack_ptr:		Stack pointer
  * @load_addr:		ELF load addr (from TA address space)
  * @vm_info:		Virtual memory map of this context
@@ -47,6 +55,9 @@ struct user_ta_ctx {
 	uaddr_t dump_entry_func;
 #ifdef CFG_TA_FTRACE_SUPPORT
 	uaddr_t ftrace_entry_func;
+#endif
+#ifdef CFG_TA_FTRACE_STREAM
+	struct ftrace_stream *ftrace_stream;
 #endif
 	uaddr_t dl_entry_func;
 	uaddr_t ldelf_stack_ptr;
@@ -54,8 +65,11 @@ struct user_ta_ctx {
 	bool is_initializing;
 	struct tee_ta_session_head open_sessions;
 	struct tee_cryp_state_head cryp_states;
+	struct handle_db cryp_state_db;
 	struct tee_obj_head objects;
+	struct handle_db object_db;
 	struct tee_storage_enum_head storage_enums;
+	const struct tee_file_operations *storage_txn_fops;
 	vaddr_t stack_ptr;
 	vaddr_t load_addr;
 	struct vm_info *vm_info;
@@ -63,6 +77,9 @@ struct user_ta_ctx {
 	struct tee_pager_area_head *areas;
 #if defined(CFG_WITH_VFP)
 	struct thread_user_vfp_state vfp;
+#endif
+#if defined(CFG_SYSCALL_STATS)
+	struct syscall_stats *syscall_stats;
 #endif
 	struct tee_ta_ctx ctx;
 
@@ -85,6 +102,20 @@ static inline struct user_ta_ctx *to_user_ta_ctx(struct tee_ta_ctx *ctx)
 
 struct user_ta_store_ops;
 
+#ifdef CFG_TA_FTRACE_STREAM
+/*
+ * Drains the ftrace ring of the TA of session @s to normal world. Unless
+ * @force is true the ring is only drained if at least half full. Must be
+ * called with the TA mapped.
+ */
+void user_ta_ftrace_drain(struct tee_ta_session *s, bool force);
+#else
+static inline void user_ta_ftrace_drain(struct tee_ta_session *s __unused,
+					bool force __unused)
+{
+}
+#endif
+
 #ifdef CFG_WITH_USER_TA
 TEE_Result tee_ta_init_user_ta_session(const TEE_UUID *uuid,
 			struct tee_ta_session *s);
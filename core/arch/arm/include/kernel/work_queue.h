@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+#ifndef KERNEL_WORK_QUEUE_H
+#define KERNEL_WORK_QUEUE_H
+
+#include <sys/queue.h>
+#include <types_ext.h>
+
+/*
+ * Deferred work
+ *
+ * Work queued with work_queue() is run later in thread context, either
+ * by a thread normal world lends with OPTEE_MSG_CMD_DO_WORK or, as long
+ * as normal world hasn't shown it can do that, at the end of the next
+ * standard call. With CFG_CORE_ASYNC_NOTIF=y normal world is notified
+ * with NOTIF_VALUE_DO_WORK when work is queued.
+ *
+ * The work function runs in thread context and may sleep, for instance
+ * on a mutex. It's called with the work dequeued so it may
+ * queue the work again or free it.
+ */
+struct work;
+typedef void (*work_func_t)(struct work *work);
+
+struct work {
+	work_func_t func;
+	bool queued;
+	TAILQ_ENTRY(work) link;
+};
+
+#define WORK_INITIALIZER(_func) { .func = (_func) }
+
+static inline void work_init(struct work *work, work_func_t func)
+{
+	*work = (struct work)WORK_INITIALIZER(func);
+}
+
+/*
+ * Queues @work, returns false if it was already queued. May be called
+ * from any context, including interrupt handlers.
+ */
+bool work_queue(struct work *work);
+
+/* Removes @work from the queue, returns false if it wasn't queued */
+bool work_cancel(struct work *work);
+
+/*
+ * Waits until @work is neither queued nor running. Must be called from a
+ * thread which can sleep and not from a work function.
+ */
+void work_flush(struct work *work);
+
+/* Runs queued work in the calling thread until the queue is empty */
+void work_run_queued(void);
+
+/*
+ * Called at the end of each standard call, runs queued work unless
+ * normal world is known to lend threads for it.
+ */
+void work_run_on_std_exit(void);
+
+/* Called when normal world lends a thread with OPTEE_MSG_CMD_DO_WORK */
+void work_run_worker(void);
+
+#endif /*KERNEL_WORK_QUEUE_H*/
@@ -515,6 +515,21 @@ static inline bool core_mmu_is_dynamic_vaspace(struct tee_mmap_region *mm)
 TEE_Result core_mmu_map_pages(vaddr_t vstart, paddr_t *pages, size_t num_pages,
 			      enum teecore_memtypes memtype);
 
+/*
+ * core_mmu_map_pages_cattr() - map list of pages with given cache attributes
+ * @vstart:	Virtual address where mapping begins
+ * @pages:	Array of page addresses
+ * @num_pages:	Number of pages
+ * @memtype:	Type of memmory to be mapped
+ * @cattr:	Cache attributes, TEE_MATTR_CACHE_*, overriding the ones of
+ *		@memtype
+ * @returns:	TEE_SUCCESS on success, TEE_ERROR_XXX on error
+ */
+TEE_Result core_mmu_map_pages_cattr(vaddr_t vstart, paddr_t *pages,
+				    size_t num_pages,
+				    enum teecore_memtypes memtype,
+				    uint32_t cattr);
+
 /*
  * core_mmu_unmap_pages() - remove mapping at given virtual address
  * @vstart:	Virtual address where mapping begins
@@ -522,6 +537,18 @@ TEE_Result core_mmu_map_pages(vaddr_t vstart, paddr_t *pages, size_t num_pages,
  */
 void core_mmu_unmap_pages(vaddr_t vstart, size_t num_pages);
 
+/*
+ * core_mmu_probe_access() - Check an access against the current mapping
+ * @va:		Virtual address to check
+ * @user:	true for an unprivileged access, false for a privileged
+ * @write:	true for a write access, false for a read
+ *
+ * Uses the address translation instructions so the result reflects the
+ * translation tables as currently seen by this CPU.
+ * @returns true if the access would succeed, false if it would fault
+ */
+bool core_mmu_probe_access(vaddr_t va, bool user, bool write);
+
 /*
  * core_mmu_user_mapping_is_active() - Report if user mapping is active
  * @returns true if a user VA space is active, false if user VA space is
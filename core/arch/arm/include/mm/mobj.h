@@ -10,6 +10,7 @@
 #include <mm/core_memprot.h>
 #include <mm/file.h>
 #include <mm/fobj.h>
+#include <mm/tee_mm.h>
 #include <string_ext.h>
 #include <sys/queue.h>
 #include <tee_api_types.h>
@@ -133,9 +134,13 @@ struct mobj *mobj_phys_alloc(paddr_t pa, size_t size, uint32_t cattr,
 			     enum buf_is_attr battr);
 
 #ifdef CFG_CORE_DYN_SHM
-/* reg_shm represents TEE shared memory */
+/*
+ * reg_shm represents TEE shared memory, @cattr is TEE_MATTR_CACHE_CACHED
+ * or TEE_MATTR_CACHE_WC and must match how normal world maps the memory
+ */
 struct mobj *mobj_reg_shm_alloc(paddr_t *pages, size_t num_pages,
-				paddr_t page_offset, uint64_t cookie);
+				paddr_t page_offset, uint64_t cookie,
+				uint32_t cattr);
 
 /**
  * mobj_reg_shm_get_by_cookie() - get a MOBJ based on cookie
@@ -160,6 +165,48 @@ void mobj_reg_shm_put(struct mobj *mobj);
 
 TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie);
 
+#ifdef CFG_SDP_POOL
+/*
+ * mobj_sdp_pool_alloc() - allocate a buffer from the SDP pool
+ * @size:	Requested size, rounded up to a size class
+ * @cookie:	Cookie normal world names the buffer with, must be unique
+ *		among the registered shared memory and SDP pool buffers
+ *
+ * The buffer is physically contiguous and held by normal world until
+ * mobj_sdp_pool_release_by_cookie() is called. Returns NULL if out of
+ * memory or if @cookie is already in use.
+ */
+struct mobj *mobj_sdp_pool_alloc(size_t size, uint64_t cookie);
+
+/*
+ * mobj_sdp_pool_get_by_cookie() - get a buffer of the SDP pool
+ * @cookie:	Cookie supplied to mobj_sdp_pool_alloc()
+ *
+ * The reference taken is dropped with mobj_free(). Returns NULL if the
+ * cookie doesn't name a buffer held by normal world.
+ */
+struct mobj *mobj_sdp_pool_get_by_cookie(uint64_t cookie);
+
+/*
+ * Drops the reference of normal world, the buffer is recycled once the
+ * last reference is dropped.
+ */
+TEE_Result mobj_sdp_pool_release_by_cookie(uint64_t cookie);
+
+bool mobj_is_sdp_pool(struct mobj *mobj);
+#else
+static inline struct mobj *
+mobj_sdp_pool_get_by_cookie(uint64_t cookie __unused)
+{
+	return NULL;
+}
+
+static inline bool mobj_is_sdp_pool(struct mobj *mobj __unused)
+{
+	return false;
+}
+#endif
+
 /**
  * mobj_reg_shm_inc_map() - increase map count
  * @mobj:	pointer to a registered shared memory MOBJ
@@ -201,6 +248,13 @@ void mobj_reg_shm_unguard(struct mobj *mobj);
  */
 struct mobj *mobj_mapped_shm_alloc(paddr_t *pages, size_t num_pages,
 				   paddr_t page_offset, uint64_t cookie);
+
+/*
+ * Allocates @num_pages pages of the virtual address range where shared
+ * memory is mapped, idle mappings are removed if needed. The caller maps
+ * and unmaps the pages, the range is freed with tee_mm_free().
+ */
+tee_mm_entry_t *mobj_mapped_shm_alloc_va(size_t num_pages);
 #else
 static inline TEE_Result mobj_reg_shm_inc_map(struct mobj *mobj __unused)
 {
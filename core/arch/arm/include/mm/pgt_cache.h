@@ -35,9 +35,12 @@ struct pgt {
 };
 
 /*
- * Reserve 2 page tables per thread, but at least 4 page tables in total
+ * Reserve CFG_PGT_CACHE_ENTRIES page tables if configured, else 2 page
+ * tables per thread, but at least 4 page tables in total
  */
-#if CFG_NUM_THREADS < 2
+#if CFG_PGT_CACHE_ENTRIES
+#define PGT_CACHE_SIZE	ROUNDUP(CFG_PGT_CACHE_ENTRIES, PGT_NUM_PGT_PER_PAGE)
+#elif CFG_NUM_THREADS < 2
 #define PGT_CACHE_SIZE	4
 #else
 #define PGT_CACHE_SIZE	ROUNDUP(CFG_NUM_THREADS * 2, PGT_NUM_PGT_PER_PAGE)
@@ -68,6 +71,29 @@ static inline void pgt_flush_ctx_range(struct pgt_cache *pgt_cache __unused,
 
 void pgt_init(void);
 
+/*
+ * struct pgt_cache_stats - statistics of page tables of paged user TAs
+ * @hits:	Page tables found with their entries kept for the context
+ * @misses:	Page tables which had to be populated from scratch
+ * @evictions:	Kept page tables taken from another context
+ * @cached:	Number of page tables currently kept
+ */
+struct pgt_cache_stats {
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t evictions;
+	uint32_t cached;
+};
+
+#if defined(CFG_PAGED_USER_TA)
+void pgt_get_stats(struct pgt_cache_stats *stats);
+#else
+static inline void pgt_get_stats(struct pgt_cache_stats *stats)
+{
+	*stats = (struct pgt_cache_stats){ };
+}
+#endif
+
 #if defined(CFG_PAGED_USER_TA)
 void pgt_flush_ctx(struct tee_ta_ctx *ctx);
 
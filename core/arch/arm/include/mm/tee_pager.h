@@ -7,6 +7,7 @@
 #ifndef MM_TEE_PAGER_H
 #define MM_TEE_PAGER_H
 
+#include <bitstring.h>
 #include <kernel/abort.h>
 #include <kernel/panic.h>
 #include <kernel/user_ta.h>
@@ -15,6 +16,19 @@
 #include <string.h>
 #include <trace.h>
 
+/*
+ * Profile of a page in a core area, recorded with CFG_PAGER_PROFILE=y
+ * @va:		Virtual address of the page
+ * @faults:	Number of times the page has been loaded on a fault
+ * @first_fault: Order of the first fault on the page among all profiled
+ *		pages, starting at 1
+ */
+struct tee_pager_page_profile {
+	uint64_t va;
+	uint32_t faults;
+	uint32_t first_fault;
+};
+
 enum tee_pager_area_type {
 	PAGER_AREA_TYPE_RO,
 	PAGER_AREA_TYPE_RW,
@@ -29,6 +43,12 @@ struct tee_pager_area {
 	vaddr_t base;
 	size_t size;
 	struct pgt *pgt;
+#ifdef CFG_PAGED_USER_TA
+	bitstr_t *pinned;	/* Pages pinned with tee_pager_pin_uta_range() */
+#endif
+#ifdef CFG_PAGER_PROFILE
+	struct tee_pager_page_profile *profile;
+#endif
 	TAILQ_ENTRY(tee_pager_area) link;
 	TAILQ_ENTRY(tee_pager_area) fobj_link;
 };
@@ -151,6 +171,57 @@ static inline void tee_pager_rem_uta_region(struct user_ta_ctx *utc __unused,
 }
 #endif
 
+/*
+ * tee_pager_pin_uta_range() - Keep the pages of a user TA range resident
+ * @utc:	user ta context
+ * @base:	page aligned base of the range
+ * @size:	size of the range, a multiple of the page size
+ *
+ * The pages are loaded if needed and aren't evicted or hidden by the
+ * pager until unpinned, so accessing them doesn't cause page faults
+ * except after the translation table of the range has been recycled.
+ * Writable pages are marked dirty to avoid the write permission fault
+ * too. Pinning a page already pinned by @utc has no effect. Each user TA
+ * can pin at most CFG_PAGED_USER_TA_PIN_QUOTA pages and at most half of
+ * the pages of the pager can be pinned in total.
+ *
+ * Pins are released with tee_pager_unpin_uta_range() or when the area is
+ * removed. The user TA mapping of @utc must be active.
+ *
+ * Returns TEE_ERROR_OUT_OF_MEMORY if a limit would be exceeded.
+ */
+#ifdef CFG_PAGED_USER_TA
+TEE_Result tee_pager_pin_uta_range(struct user_ta_ctx *utc, vaddr_t base,
+				   size_t size);
+#else
+static inline TEE_Result
+tee_pager_pin_uta_range(struct user_ta_ctx *utc __unused,
+			vaddr_t base __unused, size_t size __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+/*
+ * tee_pager_unpin_uta_range() - Release pages pinned with
+ * tee_pager_pin_uta_range()
+ * @utc:	user ta context
+ * @base:	page aligned base of the range
+ * @size:	size of the range, a multiple of the page size
+ *
+ * Pages in the range which aren't pinned by @utc are ignored.
+ */
+#ifdef CFG_PAGED_USER_TA
+void tee_pager_unpin_uta_range(struct user_ta_ctx *utc, vaddr_t base,
+			       size_t size);
+#else
+static inline void tee_pager_unpin_uta_range(struct user_ta_ctx *utc __unused,
+					     vaddr_t base __unused,
+					     size_t size __unused)
+{
+}
+#endif
+
 /*
  * tee_pager_rem_uta_areas() - Remove all user ta areas
  * @utc:	user ta context
@@ -241,6 +312,8 @@ struct tee_pager_stats {
 	size_t zi_released;
 	size_t npages;		/* number of load pages */
 	size_t npages_all;	/* number of pages */
+	size_t fault_around_loads; /* pages loaded ahead, also in ro/rw_hits */
+	size_t fault_around_hits; /* pages loaded ahead and then used */
 };
 
 #ifdef CFG_WITH_PAGER
@@ -258,6 +331,31 @@ static inline void tee_pager_get_stats(struct tee_pager_stats *stats)
 }
 #endif /*CFG_WITH_PAGER*/
 
+#ifdef CFG_PAGER_PROFILE
+/*
+ * tee_pager_get_profile() - Get the profile of the pages of core areas
+ * @prof:	Array of *@count elements to fill in, may be NULL if *@count
+ *		is 0
+ * @count:	Number of elements in @prof on entry, number of pages which
+ *		have faulted on return
+ * @reset:	If true clear the profile once copied
+ *
+ * Only pages which have faulted are reported. @prof may be paged memory,
+ * it's only written once the pager lock is released.
+ * Returns TEE_SUCCESS, TEE_ERROR_SHORT_BUFFER if @prof is too small or
+ * TEE_ERROR_OUT_OF_MEMORY.
+ */
+TEE_Result tee_pager_get_profile(struct tee_pager_page_profile *prof,
+				 size_t *count, bool reset);
+#else
+static inline TEE_Result
+tee_pager_get_profile(struct tee_pager_page_profile *prof __unused,
+		      size_t *count __unused, bool reset __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
 void tee_pager_invalidate_fobj(struct fobj *fobj);
 
 #endif /*MM_TEE_PAGER_H*/
@@ -70,6 +70,13 @@
  */
 #define OPTEE_SMC_SHM_CACHED		1
 
+/*
+ * Normal non-cacheable memory, writes may be buffered and combined. Only
+ * accepted when registering shared memory, see
+ * OPTEE_SMC_SEC_CAP_SHM_WRITE_COMBINE.
+ */
+#define OPTEE_SMC_SHM_WRITE_COMBINE	2
+
 /*
  * a0..a7 is used as register names in the descriptions below, on arm32
  * that translates to r0..r7 and on arm64 to w0..w7. In both cases it's
@@ -265,6 +272,11 @@
  */
 /* Normal world works as a uniprocessor system */
 #define OPTEE_SMC_NSEC_CAP_UNIPROCESSOR		(1 << 0)
+/*
+ * Normal world wakes threads sleeping in a wait queue on asynchronous
+ * notifications, see OPTEE_SMC_SEC_CAP_WQ_ASYNC_NOTIF
+ */
+#define OPTEE_SMC_NSEC_CAP_WQ_ASYNC_NOTIF	(1 << 1)
 /* Secure world has reserved shared memory for normal world to use */
 #define OPTEE_SMC_SEC_CAP_HAVE_RESERVED_SHM	(1 << 0)
 /* Secure world can communicate via previously unregistered shared memory */
@@ -278,6 +290,41 @@
  */
 #define OPTEE_SMC_SEC_CAP_DYNAMIC_SHM		(1 << 2)
 
+/* Secure world supports OPTEE_MSG_CMD_INVOKE_BATCH */
+#define OPTEE_SMC_SEC_CAP_BATCH_INVOKE		(1 << 3)
+/*
+ * Secure world supports asynchronous notification of normal world and
+ * OPTEE_MSG_CMD_INVOKE_ASYNC
+ */
+#define OPTEE_SMC_SEC_CAP_ASYNC_NOTIF		(1 << 4)
+
+/* Secure world supports OPTEE_MSG_CMD_DO_WORK */
+#define OPTEE_SMC_SEC_CAP_WORK_QUEUE		(1 << 5)
+/* Secure world supports OPTEE_SMC_GET_RANDOM */
+#define OPTEE_SMC_SEC_CAP_FAST_RANDOM		(1 << 6)
+/* Secure world supports OPTEE_SMC_GET_SYSTEM_TIME */
+#define OPTEE_SMC_SEC_CAP_FAST_SYSTEM_TIME	(1 << 7)
+/* Secure world supports OPTEE_MSG_CMD_SDP_ALLOC and OPTEE_MSG_CMD_SDP_FREE */
+#define OPTEE_SMC_SEC_CAP_SDP_POOL		(1 << 8)
+/* Secure world accepts OPTEE_SMC_SHM_WRITE_COMBINE for registered memory */
+#define OPTEE_SMC_SEC_CAP_SHM_WRITE_COMBINE	(1 << 9)
+/*
+ * Secure world can wake threads sleeping in a wait queue with an
+ * asynchronous notification. Once normal world has set
+ * OPTEE_SMC_NSEC_CAP_WQ_ASYNC_NOTIF, a notification value retrieved with
+ * OPTEE_SMC_GET_ASYNC_NOTIF_VALUE above 63 is to be handled as an
+ * OPTEE_RPC_WAIT_QUEUE_WAKEUP request with the value as key, including a
+ * wakeup delivered before the matching OPTEE_RPC_WAIT_QUEUE_SLEEP.
+ */
+#define OPTEE_SMC_SEC_CAP_WQ_ASYNC_NOTIF	(1 << 10)
+/*
+ * Secure world supports OPTEE_MSG_CMD_REGISTER_SHM_BATCH and
+ * OPTEE_MSG_CMD_UNREGISTER_SHM_BATCH
+ */
+#define OPTEE_SMC_SEC_CAP_BATCH_SHM		(1 << 11)
+/* Secure world supports OPTEE_MSG_CMD_SET_TELEMETRY */
+#define OPTEE_SMC_SEC_CAP_TELEMETRY		(1 << 12)
+
 #define OPTEE_SMC_FUNCID_EXCHANGE_CAPABILITIES	9
 #define OPTEE_SMC_EXCHANGE_CAPABILITIES \
 	OPTEE_SMC_FAST_CALL_VAL(OPTEE_SMC_FUNCID_EXCHANGE_CAPABILITIES)
@@ -449,6 +496,98 @@
 #define OPTEE_SMC_GET_THREAD_COUNT \
 	OPTEE_SMC_FAST_CALL_VAL(OPTEE_SMC_FUNCID_GET_THREAD_COUNT)
 
+/*
+ * Retrieve a value of notifications pending since the last call of this
+ * function.
+ *
+ * OP-TEE keeps a record of all posted values. When an interrupt is
+ * received which indicates that there are posted values this function
+ * should be called until all pended values have been retrieved. When a
+ * value is retrieved, it's cleared from the record in secure world.
+ *
+ * Call requests usage:
+ * a0	SMC Function ID, OPTEE_SMC_GET_ASYNC_NOTIF_VALUE
+ * a1-6	Not used
+ * a7	Hypervisor Client ID register
+ *
+ * Normal return register usage:
+ * a0	OPTEE_SMC_RETURN_OK
+ * a1	value
+ * a2	Bit[0]: OPTEE_SMC_ASYNC_NOTIF_VALUE_VALID if the value in a1 is
+ *		valid, else 0 if no values where pending
+ * a2	Bit[1]: OPTEE_SMC_ASYNC_NOTIF_PENDING if another value is pending,
+ *		else 0.
+ *	Bit[31:2]: MBZ
+ * a3-7	Preserved
+ *
+ * Not supported return register usage:
+ * a0	OPTEE_SMC_RETURN_ENOTAVAIL
+ * a1-7	Preserved
+ */
+#define OPTEE_SMC_ASYNC_NOTIF_VALUE_VALID	(1 << 0)
+#define OPTEE_SMC_ASYNC_NOTIF_PENDING		(1 << 1)
+
+#define OPTEE_SMC_FUNCID_GET_ASYNC_NOTIF_VALUE	16
+#define OPTEE_SMC_GET_ASYNC_NOTIF_VALUE \
+	OPTEE_SMC_FAST_CALL_VAL(OPTEE_SMC_FUNCID_GET_ASYNC_NOTIF_VALUE)
+
+/*
+ * Read random bytes from secure world without a std call
+ *
+ * The bytes are taken from a pool which secure world refills from its
+ * RNG in the background, each byte is only returned once. Normal world
+ * is expected to fall back to the RNG pseudo TA if the pool is empty.
+ *
+ * Call requests usage:
+ * a0	SMC Function ID, OPTEE_SMC_GET_RANDOM
+ * a1-6	Not used
+ * a7	Hypervisor Client ID register
+ *
+ * Normal return register usage:
+ * a0	OPTEE_SMC_RETURN_OK
+ * a1-3	OPTEE_SMC_GET_RANDOM_SIZE random bytes, the lower 32 bits of
+ *	each register are used
+ * a4-7	Preserved
+ *
+ * Pool empty return register usage:
+ * a0	OPTEE_SMC_RETURN_EBUSY
+ * a1-7	Preserved
+ *
+ * Not supported return register usage:
+ * a0	OPTEE_SMC_RETURN_UNKNOWN_FUNCTION
+ * a1-7	Preserved
+ */
+#define OPTEE_SMC_GET_RANDOM_SIZE		12
+
+#define OPTEE_SMC_FUNCID_GET_RANDOM		17
+#define OPTEE_SMC_GET_RANDOM \
+	OPTEE_SMC_FAST_CALL_VAL(OPTEE_SMC_FUNCID_GET_RANDOM)
+
+/*
+ * Read the secure system time without a std call
+ *
+ * Returns the same time as TEE_GetSystemTime() called from a TA, only
+ * supported if the time source doesn't depend on normal world.
+ *
+ * Call requests usage:
+ * a0	SMC Function ID, OPTEE_SMC_GET_SYSTEM_TIME
+ * a1-6	Not used
+ * a7	Hypervisor Client ID register
+ *
+ * Normal return register usage:
+ * a0	OPTEE_SMC_RETURN_OK
+ * a1	Seconds
+ * a2	Milliseconds
+ * a3-7	Preserved
+ *
+ * Not supported return register usage:
+ * a0	OPTEE_SMC_RETURN_UNKNOWN_FUNCTION
+ * a1-7	Preserved
+ */
+#define OPTEE_SMC_FUNCID_GET_SYSTEM_TIME	18
+#define OPTEE_SMC_GET_SYSTEM_TIME \
+	OPTEE_SMC_FAST_CALL_VAL(OPTEE_SMC_FUNCID_GET_SYSTEM_TIME)
+
 /*
  * Resume from RPC (for example after processing a foreign interrupt)
  *
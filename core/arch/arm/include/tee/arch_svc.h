@@ -5,8 +5,58 @@
 #ifndef TEE_ARCH_SVC_H
 #define TEE_ARCH_SVC_H
 
+#include <tee_api_types.h>
+#include <tee_syscall_numbers.h>
+
 struct thread_svc_regs;
 
+#define SYSCALL_STATS_NUM_BUCKETS	16
+
+/*
+ * struct syscall_scn_stats - Statistics of one system call
+ * @count:	Number of calls
+ * @hist:	Latency histogram, @hist[0] counts calls completed in less
+ *		than 1 us and @hist[n] calls which took [2^(n - 1), 2^n) us.
+ *		The last bucket also counts all longer calls.
+ * @time_us:	Total time spent in the calls
+ */
+struct syscall_scn_stats {
+	uint32_t count;
+	uint32_t hist[SYSCALL_STATS_NUM_BUCKETS];
+	uint64_t time_us;
+};
+
+/*
+ * struct syscall_stats - Statistics of the system calls of a TA
+ * @uuid:	UUID of the TA, instances of the same TA share statistics
+ * @scn:	Statistics indexed by system call number
+ */
+struct syscall_stats {
+	TEE_UUID uuid;
+	struct syscall_scn_stats scn[TEE_SCN_MAX + 1];
+};
+
+#ifdef CFG_SYSCALL_STATS
+/*
+ * syscall_stats_get() - Get the system call statistics of a TA
+ * @idx:	Index of the TA, in the order the TAs made their first
+ *		system call
+ * @stats:	Output statistics
+ * @reset:	If true, the statistics are cleared after being copied
+ *
+ * Returns TEE_ERROR_ITEM_NOT_FOUND if @idx is beyond the last TA.
+ */
+TEE_Result syscall_stats_get(size_t idx, struct syscall_stats *stats,
+			     bool reset);
+#else
+static inline TEE_Result
+syscall_stats_get(size_t idx __unused, struct syscall_stats *stats __unused,
+		  bool reset __unused)
+{
+	return TEE_ERROR_ITEM_NOT_FOUND;
+}
+#endif
+
 void tee_svc_handler(struct thread_svc_regs *regs);
 
 /*
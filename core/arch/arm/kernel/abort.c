@@ -10,6 +10,7 @@
 #include <kernel/panic.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/unwind.h>
+#include <kernel/user_access.h>
 #include <kernel/user_ta.h>
 #include <mm/core_mmu.h>
 #include <mm/mobj.h>
@@ -443,6 +444,31 @@ static bool is_vfp_fault(struct abort_info *ai __unused)
 }
 #endif  /*CFG_WITH_VFP && CFG_WITH_USER_TA*/
 
+#ifdef CFG_CORE_USER_ACCESS_UNPRIV
+/*
+ * A kernel mode abort in __copy_from_user_unpriv() or
+ * __copy_to_user_unpriv() is due to an invalid user buffer, the copy is
+ * aborted and returns the number of bytes not copied.
+ */
+static bool handle_user_access_fault(struct abort_info *ai)
+{
+	vaddr_t pc = ai->regs->elr;
+
+	if (abort_is_user_exception(ai) ||
+	    pc < (vaddr_t)__user_access_start ||
+	    pc >= (vaddr_t)__user_access_end)
+		return false;
+
+	ai->regs->elr = (vaddr_t)__user_access_fixup;
+	return true;
+}
+#else
+static bool handle_user_access_fault(struct abort_info *ai __unused)
+{
+	return false;
+}
+#endif
+
 static enum fault_type get_fault_type(struct abort_info *ai)
 {
 	if (abort_is_user_exception(ai)) {
@@ -536,6 +562,8 @@ void abort_handler(uint32_t abort_type, struct thread_abort_regs *regs)
 		thread_kernel_save_vfp();
 		handled = tee_pager_handle_fault(&ai);
 		thread_kernel_restore_vfp();
+		if (!handled && handle_user_access_fault(&ai))
+			break;
 		if (!handled) {
 			if (!abort_is_user_exception(&ai)) {
 				abort_print_error(&ai);
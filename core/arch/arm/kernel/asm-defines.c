@@ -80,6 +80,10 @@ DEFINES
 	/* struct thread_core_local */
 	DEFINE(THREAD_CORE_LOCAL_X0, offsetof(struct thread_core_local, x[0]));
 	DEFINE(THREAD_CORE_LOCAL_X2, offsetof(struct thread_core_local, x[2]));
+#ifdef CFG_CORE_PROFILER
+	DEFINE(THREAD_CORE_LOCAL_INTR_FP,
+		offsetof(struct thread_core_local, intr_fp));
+#endif
 #endif /*ARM64*/
 
 	/* struct thread_core_local */
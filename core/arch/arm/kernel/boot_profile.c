@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <arm.h>
+#include <inttypes.h>
+#include <kernel/boot_profile.h>
+#include <string.h>
+#include <string_ext.h>
+#include <trace.h>
+#include <util.h>
+
+/*
+ * Only the primary CPU records timings, before normal world is booted,
+ * so there's no concurrent access. Timestamps are kept as system counter
+ * ticks and converted when reported since CNTFRQ may not be initialized
+ * when the first phases start.
+ */
+
+#define NUM_ENTRIES	CFG_BOOT_PROFILE_ENTRIES
+
+struct boot_profile_record {
+	const char *name;
+	vaddr_t func;
+	uint32_t depth;
+	TEE_Result result;
+	uint64_t start;
+	uint64_t end;
+};
+
+static struct boot_profile_record boot_records[NUM_ENTRIES];
+static size_t boot_num_records;
+static size_t boot_num_dropped;
+static uint32_t boot_depth;
+
+size_t boot_profile_begin(const char *name, vaddr_t func)
+{
+	struct boot_profile_record *r = NULL;
+
+	boot_depth++;
+	if (boot_num_records == NUM_ENTRIES) {
+		boot_num_dropped++;
+		return NUM_ENTRIES;
+	}
+
+	r = boot_records + boot_num_records;
+	r->name = name;
+	r->func = func;
+	r->depth = boot_depth - 1;
+	r->start = read_cntpct();
+
+	return boot_num_records++;
+}
+
+void boot_profile_end(size_t idx, TEE_Result result)
+{
+	uint64_t now = read_cntpct();
+
+	if (boot_depth)
+		boot_depth--;
+	if (idx >= boot_num_records)
+		return;
+
+	boot_records[idx].end = now;
+	boot_records[idx].result = result;
+}
+
+static uint64_t ticks_to_ns(uint64_t ticks, uint64_t freq)
+{
+	if (!freq)
+		return 0;
+	return (ticks / freq) * 1000000000 +
+	       ((ticks % freq) * 1000000000) / freq;
+}
+
+static void record_to_entry(const struct boot_profile_record *r,
+			    struct boot_profile_entry *e, uint64_t freq)
+{
+	memset(e, 0, sizeof(*e));
+	e->func = r->func;
+	if (r->name)
+		strlcpy(e->name, r->name, sizeof(e->name));
+	e->depth = r->depth;
+	e->result = r->result;
+	e->start_ns = ticks_to_ns(r->start, freq);
+	if (r->end)
+		e->duration_ns = ticks_to_ns(r->end - r->start, freq);
+}
+
+void boot_profile_print(void)
+{
+	struct boot_profile_entry e = { };
+	uint64_t freq = read_cntfrq();
+	size_t n = 0;
+
+	IMSG("Boot profile (start, duration in us):");
+	for (n = 0; n < boot_num_records; n++) {
+		record_to_entry(boot_records + n, &e, freq);
+		if (e.func)
+			IMSG("%10"PRIu64" %8"PRIu64" %*sinitcall %#"PRIx64"%s",
+			     e.start_ns / 1000, e.duration_ns / 1000,
+			     (int)e.depth * 2, "", e.func,
+			     e.result ? " failed" : "");
+		else
+			IMSG("%10"PRIu64" %8"PRIu64" %*s%s",
+			     e.start_ns / 1000, e.duration_ns / 1000,
+			     (int)e.depth * 2, "", e.name);
+	}
+	if (boot_num_dropped)
+		IMSG("%zu boot phases not recorded, increase CFG_BOOT_PROFILE_ENTRIES",
+		     boot_num_dropped);
+}
+
+bool boot_profile_get(struct boot_profile_entry *entries, size_t *count)
+{
+	uint64_t freq = read_cntfrq();
+	size_t n = 0;
+
+	if (*count < boot_num_records) {
+		*count = boot_num_records;
+		return false;
+	}
+
+	for (n = 0; n < boot_num_records; n++)
+		record_to_entry(boot_records + n, entries + n, freq);
+	*count = boot_num_records;
+
+	return true;
+}
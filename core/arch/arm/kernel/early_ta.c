@@ -2,30 +2,62 @@
 /*
  * Copyright (c) 2017, Linaro Limited
  */
+#include <config.h>
 #include <crypto/crypto.h>
 #include <initcall.h>
+#include <io.h>
 #include <kernel/early_ta.h>
 #include <kernel/linker.h>
 #include <kernel/user_ta.h>
 #include <kernel/user_ta_store.h>
+#include <mm/core_memprot.h>
+#include <mm/mobj.h>
 #include <stdio.h>
 #include <string.h>
 #include <trace.h>
 #include <utee_defines.h>
 #include <util.h>
+#ifdef CFG_EARLY_TA_COMPRESS_LZ4
+#include <lz4.h>
+#else
 #include <zlib.h>
+#endif
+
+#ifdef CFG_EARLY_TA_COMPRESS_LZ4
+/*
+ * @in_offs:	Offset of the next block header in the compressed TA
+ * @block:	Last decompressed block, when it couldn't be decompressed
+ *		directly into the caller's buffer
+ * @block_len:	Number of bytes in @block
+ * @block_offs:	Number of bytes of @block already read
+ */
+struct lz4_stream {
+	size_t in_offs;
+	uint8_t *block;
+	size_t block_len;
+	size_t block_offs;
+};
+#endif
 
 struct user_ta_store_handle {
 	const struct early_ta *early_ta;
 	size_t offs;
+#ifdef CFG_EARLY_TA_COMPRESS_LZ4
+	struct lz4_stream strm;
+#else
 	z_stream strm;
+#endif
 };
 
 #define for_each_early_ta(_ta) \
 	for (_ta = &__rodata_early_ta_start; _ta < &__rodata_early_ta_end; \
-	     _ta = (const struct early_ta *)				   \
-		   ROUNDUP((vaddr_t)_ta + sizeof(*_ta) + _ta->size,	   \
-			   __alignof__(struct early_ta)))
+	     _ta++)
+
+/* With CFG_EARLY_TA_XIP=y the decompression code is left out */
+static bool is_compressed(const struct early_ta *ta)
+{
+	return !IS_ENABLED(CFG_EARLY_TA_XIP) && ta->uncompressed_size;
+}
 
 static const struct early_ta *find_early_ta(const TEE_UUID *uuid)
 {
@@ -38,6 +70,24 @@ static const struct early_ta *find_early_ta(const TEE_UUID *uuid)
 	return NULL;
 }
 
+#ifdef CFG_EARLY_TA_COMPRESS_LZ4
+static bool decompression_init(struct lz4_stream *strm,
+			       const struct early_ta *ta __unused)
+{
+	strm->block = malloc(EARLY_TA_LZ4_BLOCK_SIZE);
+	if (!strm->block) {
+		EMSG("Out of memory");
+		return false;
+	}
+
+	return true;
+}
+
+static void decompression_end(struct lz4_stream *strm)
+{
+	free(strm->block);
+}
+#else
 static void *zalloc(void *opaque __unused, unsigned int items,
 		    unsigned int size)
 {
@@ -67,6 +117,12 @@ static bool decompression_init(z_stream *strm,
 	return true;
 }
 
+static void decompression_end(z_stream *strm)
+{
+	inflateEnd(strm);
+}
+#endif /*CFG_EARLY_TA_COMPRESS_LZ4*/
+
 static TEE_Result early_ta_open(const TEE_UUID *uuid,
 				struct user_ta_store_handle **h)
 {
@@ -82,7 +138,7 @@ static TEE_Result early_ta_open(const TEE_UUID *uuid,
 	if (!handle)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
-	if (ta->uncompressed_size) {
+	if (is_compressed(ta)) {
 		st = decompression_init(&handle->strm, ta);
 		if (!st) {
 			free(handle);
@@ -100,7 +156,7 @@ static TEE_Result early_ta_get_size(const struct user_ta_store_handle *h,
 {
 	const struct early_ta *ta = h->early_ta;
 
-	if (ta->uncompressed_size)
+	if (is_compressed(ta))
 		*size = ta->uncompressed_size;
 	else
 		*size = ta->size;
@@ -150,6 +206,99 @@ static TEE_Result read_uncompressed(struct user_ta_store_handle *h, void *data,
 	return TEE_SUCCESS;
 }
 
+#ifdef CFG_EARLY_TA_COMPRESS_LZ4
+/*
+ * Decompresses the next block into @dst, or only skips it if @dst is
+ * NULL. @len is the expected length of the decompressed block.
+ */
+static TEE_Result read_block(struct user_ta_store_handle *h, void *dst,
+			     size_t len)
+{
+	const struct early_ta *ta = h->early_ta;
+	struct lz4_stream *strm = &h->strm;
+	uint32_t hdr = 0;
+	size_t blen = 0;
+	size_t out = 0;
+
+	if (ta->size - strm->in_offs < sizeof(hdr))
+		return TEE_ERROR_BAD_FORMAT;
+	/* The header may be unaligned */
+	memcpy(&hdr, ta->ta + strm->in_offs, sizeof(hdr));
+	hdr = get_le32(&hdr);
+	strm->in_offs += sizeof(hdr);
+	blen = hdr & ~EARLY_TA_LZ4_STORED;
+	if (blen > ta->size - strm->in_offs)
+		return TEE_ERROR_BAD_FORMAT;
+
+	if (!dst) {
+		out = len;
+	} else if (hdr & EARLY_TA_LZ4_STORED) {
+		out = blen;
+		if (out == len)
+			memcpy(dst, ta->ta + strm->in_offs, len);
+	} else if (lz4_decompress(ta->ta + strm->in_offs, blen, dst, len,
+				  &out)) {
+		EMSG("Decompression error");
+		return TEE_ERROR_BAD_FORMAT;
+	}
+	if (out != len)
+		return TEE_ERROR_BAD_FORMAT;
+	strm->in_offs += blen;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result read_compressed(struct user_ta_store_handle *h, void *data,
+				  size_t len)
+{
+	struct lz4_stream *strm = &h->strm;
+	uint8_t *dst = data;
+	TEE_Result res = TEE_SUCCESS;
+	size_t block_len = 0;
+	size_t n = 0;
+
+	if (len > h->early_ta->uncompressed_size - h->offs)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	while (len) {
+		if (strm->block_offs == strm->block_len) {
+			block_len = MIN(h->early_ta->uncompressed_size -
+					h->offs, (size_t)EARLY_TA_LZ4_BLOCK_SIZE);
+			/*
+			 * Whole blocks are decompressed directly into the
+			 * caller's buffer, or skipped without decompression.
+			 */
+			if (len >= block_len) {
+				res = read_block(h, dst, block_len);
+				if (res)
+					return res;
+				if (dst)
+					dst += block_len;
+				h->offs += block_len;
+				len -= block_len;
+				continue;
+			}
+
+			res = read_block(h, strm->block, block_len);
+			if (res)
+				return res;
+			strm->block_len = block_len;
+			strm->block_offs = 0;
+		}
+
+		n = MIN(len, strm->block_len - strm->block_offs);
+		if (dst) {
+			memcpy(dst, strm->block + strm->block_offs, n);
+			dst += n;
+		}
+		strm->block_offs += n;
+		h->offs += n;
+		len -= n;
+	}
+
+	return TEE_SUCCESS;
+}
+#else
 static TEE_Result read_compressed(struct user_ta_store_handle *h, void *data,
 				  size_t len)
 {
@@ -214,19 +363,51 @@ out:
 	return ret;
 }
 
+#endif /*CFG_EARLY_TA_COMPRESS_LZ4*/
+
 static TEE_Result early_ta_read(struct user_ta_store_handle *h, void *data,
 				size_t len)
 {
-	if (h->early_ta->uncompressed_size)
+	if (is_compressed(h->early_ta))
 		return read_compressed(h, data, len);
 	else
 		return read_uncompressed(h, data, len);
 }
 
+#ifdef CFG_EARLY_TA_XIP
+static TEE_Result early_ta_get_mobj(const struct user_ta_store_handle *h,
+				    size_t offs, size_t num_bytes,
+				    struct mobj **mobj, size_t *mobj_offs)
+{
+	const struct early_ta *ta = h->early_ta;
+	size_t end = 0;
+	paddr_t pa = 0;
+
+	/* The TA is padded with zeroes up to EARLY_TA_XIP_ALIGN */
+	if (((vaddr_t)ta->ta & (EARLY_TA_XIP_ALIGN - 1)) ||
+	    (offs & SMALL_PAGE_MASK) || offs > ta->size ||
+	    ADD_OVERFLOW(offs, num_bytes, &end) ||
+	    ROUNDUP(end, SMALL_PAGE_SIZE) >
+	    ROUNDUP(ta->size, EARLY_TA_XIP_ALIGN))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	pa = virt_to_phys((void *)(ta->ta + offs));
+	if (!pa || pa < TEE_RAM_START ||
+	    pa - TEE_RAM_START + ROUNDUP(num_bytes, SMALL_PAGE_SIZE) >
+	    mobj_tee_ram->size)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	*mobj = mobj_tee_ram;
+	*mobj_offs = pa - TEE_RAM_START;
+
+	return TEE_SUCCESS;
+}
+#endif
+
 static void early_ta_close(struct user_ta_store_handle *h)
 {
-	if (h->early_ta->uncompressed_size)
-		inflateEnd(&h->strm);
+	if (is_compressed(h->early_ta))
+		decompression_end(&h->strm);
 	free(h);
 }
 
@@ -236,6 +417,9 @@ TEE_TA_REGISTER_TA_STORE(2) = {
 	.get_size = early_ta_get_size,
 	.get_tag = early_ta_get_tag,
 	.read = early_ta_read,
+#ifdef CFG_EARLY_TA_XIP
+	.get_mobj = early_ta_get_mobj,
+#endif
 	.close = early_ta_close,
 };
 
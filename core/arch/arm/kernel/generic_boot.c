@@ -5,18 +5,22 @@
 
 #include <arm.h>
 #include <assert.h>
+#include <atomic.h>
 #include <compiler.h>
+#include <config.h>
 #include <console.h>
 #include <crypto/crypto.h>
 #include <inttypes.h>
 #include <keep.h>
 #include <kernel/asan.h>
+#include <kernel/boot_profile.h>
 #include <kernel/generic_boot.h>
 #include <kernel/linker.h>
 #include <kernel/misc.h>
 #include <kernel/panic.h>
 #include <kernel/tee_misc.h>
 #include <kernel/thread.h>
+#include <kernel/work_queue.h>
 #include <malloc.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
@@ -203,6 +207,43 @@ static void secondary_init_cntfrq(void)
 }
 #endif
 
+#ifdef ARM64
+static bool cpu_has_lse(void)
+{
+	uint64_t isar0 = read_id_aa64isar0_el1();
+
+	return ((isar0 >> ID_AA64ISAR0_ATOMIC_SHIFT) &
+		ID_AA64ISAR0_ATOMIC_MASK) >= ID_AA64ISAR0_ATOMIC_LSE;
+}
+
+/*
+ * LSE atomics and exclusive load/store loops operate coherently on the
+ * same data, so a secondary CPU without LSE can turn them off at any time
+ * for all CPUs.
+ */
+static void primary_init_atomics(void)
+{
+	if (cpu_has_lse()) {
+		atomic_have_lse = 1;
+		DMSG("Using LSE atomics");
+	}
+}
+
+static void secondary_init_atomics(void)
+{
+	if (!cpu_has_lse())
+		atomic_have_lse = 0;
+}
+#else
+static void primary_init_atomics(void)
+{
+}
+
+static void secondary_init_atomics(void)
+{
+}
+#endif
+
 #ifdef CFG_CORE_SANITIZE_KADDRESS
 static void init_run_constructors(void)
 {
@@ -264,6 +305,108 @@ static void init_asan(void)
 }
 #endif /*CFG_CORE_SANITIZE_KADDRESS*/
 
+#ifdef CFG_BOOT_PARALLEL_INIT
+/*
+ * The secondary CPUs are released by the primary CPU once its MMU is
+ * enabled and wait for jobs in generic_boot_help_primary() until the
+ * primary CPU is done with its initialization.
+ *
+ * @gen is odd while a job is posted, @helpers counts the secondary CPUs
+ * which may still access the job.
+ */
+static struct {
+	boot_parallel_fn fn;
+	void *arg;
+	size_t count;
+	size_t next;
+	size_t done;
+	unsigned int gen;
+	unsigned int helpers;
+	bool end;
+} boot_job;
+
+static void run_boot_job(void)
+{
+	size_t idx = 0;
+
+	while (true) {
+		idx = __atomic_fetch_add(&boot_job.next, 1, __ATOMIC_RELAXED);
+		if (idx >= boot_job.count)
+			break;
+		boot_job.fn(boot_job.arg, idx);
+		__atomic_add_fetch(&boot_job.done, 1, __ATOMIC_RELEASE);
+		dsb();
+		sev();
+	}
+}
+
+void generic_boot_help_primary(void)
+{
+	unsigned int served = 0;
+	unsigned int gen = 0;
+
+	/* The jobs may use SIMD instructions, for hashing for instance */
+	init_vfp_sec();
+
+	while (!__atomic_load_n(&boot_job.end, __ATOMIC_ACQUIRE)) {
+		gen = __atomic_load_n(&boot_job.gen, __ATOMIC_ACQUIRE);
+		if (!(gen & 1) || gen == served) {
+			wfe();
+			continue;
+		}
+
+		__atomic_add_fetch(&boot_job.helpers, 1, __ATOMIC_SEQ_CST);
+		/* The job may have been completed in between */
+		if (__atomic_load_n(&boot_job.gen, __ATOMIC_SEQ_CST) == gen)
+			run_boot_job();
+		__atomic_sub_fetch(&boot_job.helpers, 1, __ATOMIC_SEQ_CST);
+		dsb();
+		sev();
+		served = gen;
+	}
+}
+KEEP_PAGER(generic_boot_help_primary);
+
+void boot_parallel_run(boot_parallel_fn fn, void *arg, size_t count)
+{
+	boot_job.fn = fn;
+	boot_job.arg = arg;
+	boot_job.count = count;
+	boot_job.next = 0;
+	boot_job.done = 0;
+	__atomic_add_fetch(&boot_job.gen, 1, __ATOMIC_SEQ_CST);
+	dsb();
+	sev();
+
+	run_boot_job();
+
+	while (__atomic_load_n(&boot_job.done, __ATOMIC_ACQUIRE) != count)
+		wfe();
+	__atomic_add_fetch(&boot_job.gen, 1, __ATOMIC_SEQ_CST);
+	while (__atomic_load_n(&boot_job.helpers, __ATOMIC_SEQ_CST))
+		wfe();
+}
+
+static void boot_parallel_end(void)
+{
+	__atomic_store_n(&boot_job.end, true, __ATOMIC_RELEASE);
+	dsb();
+	sev();
+}
+#else
+void boot_parallel_run(boot_parallel_fn fn, void *arg, size_t count)
+{
+	size_t n = 0;
+
+	for (n = 0; n < count; n++)
+		fn(arg, n);
+}
+
+static void boot_parallel_end(void)
+{
+}
+#endif
+
 #ifdef CFG_WITH_PAGER
 
 #ifdef CFG_CORE_SANITIZE_KADDRESS
@@ -328,9 +471,92 @@ static void init_vcore(tee_mm_pool_t *mm_vcore)
 		panic("tee_mm_vcore init failed");
 }
 
+static void check_pageable_hashes(const uint8_t *hashes,
+				  const uint8_t *paged_store, size_t first,
+				  size_t last)
+{
+	size_t n = 0;
+
+	for (n = first; n < last; n++) {
+		const uint8_t *hash = hashes + n * TEE_SHA256_HASH_SIZE;
+		const uint8_t *page = paged_store + n * SMALL_PAGE_SIZE;
+		TEE_Result res;
+
+		DMSG("hash pg_idx %zu hash %p page %p", n, hash, page);
+		res = hash_sha256_check(hash, page, SMALL_PAGE_SIZE);
+		if (res != TEE_SUCCESS) {
+			EMSG("Hash failed for page %zu at %p: res 0x%x",
+			     n, (void *)page, res);
+			panic();
+		}
+	}
+}
+
+#ifdef CFG_PAGER_BG_HASH_CHECK
+/* Pages checked each time the work runs, to keep the runs short */
+#define BG_HASH_CHECK_CHUNK	16
+
+static const uint8_t *bg_hashes;
+static const uint8_t *bg_paged_store;
+static size_t bg_next_page;
+static size_t bg_num_pages;
+
+static void bg_hash_check_func(struct work *work)
+{
+	size_t last = MIN(bg_next_page + BG_HASH_CHECK_CHUNK, bg_num_pages);
+
+	check_pageable_hashes(bg_hashes, bg_paged_store, bg_next_page, last);
+	bg_next_page = last;
+
+	if (bg_next_page < bg_num_pages)
+		work_queue(work);
+	else
+		IMSG("Hashes of pageable area checked");
+}
+
+static struct work bg_hash_check_work = WORK_INITIALIZER(bg_hash_check_func);
+
+static void start_bg_hash_check(const uint8_t *hashes,
+				const uint8_t *paged_store, size_t first,
+				size_t num_pages)
+{
+	bg_hashes = hashes;
+	bg_paged_store = paged_store;
+	bg_next_page = first;
+	bg_num_pages = num_pages;
+	if (first < num_pages)
+		work_queue(&bg_hash_check_work);
+}
+#else
+static void start_bg_hash_check(const uint8_t *hashes __unused,
+				const uint8_t *paged_store __unused,
+				size_t first __unused, size_t num_pages __unused)
+{
+}
+#endif
+
+/* Pages checked by each call of check_hashes_job() */
+#define HASH_CHECK_JOB_PAGES	16
+
+struct hash_check_job {
+	const uint8_t *hashes;
+	const uint8_t *paged_store;
+	size_t num_pages;
+};
+
+static void check_hashes_job(void *arg, size_t idx)
+{
+	struct hash_check_job *job = arg;
+	size_t first = idx * HASH_CHECK_JOB_PAGES;
+
+	check_pageable_hashes(job->hashes, job->paged_store, first,
+			      MIN(first + HASH_CHECK_JOB_PAGES, job->num_pages));
+}
+
 static void init_runtime(unsigned long pageable_part)
 {
-	size_t n;
+	struct hash_check_job hash_job = { };
+	size_t num_checked = 0;
 	size_t init_size = (size_t)__init_size;
 	size_t pageable_start = (size_t)__pageable_start;
 	size_t pageable_end = (size_t)__pageable_end;
@@ -342,6 +568,7 @@ static void init_runtime(unsigned long pageable_part)
 	struct fobj *fobj = NULL;
 	uint8_t *paged_store = NULL;
 	uint8_t *hashes = NULL;
+	size_t prof = 0;
 
 	assert(pageable_size % SMALL_PAGE_SIZE == 0);
 	assert(hash_size == (size_t)__tmp_hashes_size);
@@ -386,21 +613,27 @@ static void init_runtime(unsigned long pageable_part)
 		__pageable_part_end - __pageable_part_start);
 	asan_memcpy_unchecked(paged_store, __init_start, init_size);
 
-	/* Check that hashes of what's in pageable area is OK */
+	/*
+	 * Check that hashes of what's in pageable area is OK. With
+	 * CFG_PAGER_LAZY_HASH_CHECK only the init part is checked, it
+	 * stays mapped below. The other pages are checked by the fobj
+	 * below each time they're loaded on a page fault.
+	 */
 	DMSG("Checking hashes of pageable area");
-	for (n = 0; (n * SMALL_PAGE_SIZE) < pageable_size; n++) {
-		const uint8_t *hash = hashes + n * TEE_SHA256_HASH_SIZE;
-		const uint8_t *page = paged_store + n * SMALL_PAGE_SIZE;
-		TEE_Result res;
-
-		DMSG("hash pg_idx %zu hash %p page %p", n, hash, page);
-		res = hash_sha256_check(hash, page, SMALL_PAGE_SIZE);
-		if (res != TEE_SUCCESS) {
-			EMSG("Hash failed for page %zu at %p: res 0x%x",
-			     n, (void *)page, res);
-			panic();
-		}
-	}
+	prof = boot_profile_begin("pager_hash_check", 0);
+	if (IS_ENABLED(CFG_PAGER_LAZY_HASH_CHECK))
+		num_checked = init_size / SMALL_PAGE_SIZE;
+	else
+		num_checked = pageable_size / SMALL_PAGE_SIZE;
+	hash_job.hashes = hashes;
+	hash_job.paged_store = paged_store;
+	hash_job.num_pages = num_checked;
+	boot_parallel_run(check_hashes_job, &hash_job,
+			  ROUNDUP(num_checked, HASH_CHECK_JOB_PAGES) /
+			  HASH_CHECK_JOB_PAGES);
+	boot_profile_end(prof, TEE_SUCCESS);
+	start_bg_hash_check(hashes, paged_store, num_checked,
+			    pageable_size / SMALL_PAGE_SIZE);
 
 	/*
 	 * Assert prepaged init sections are page aligned so that nothing
@@ -1105,6 +1338,9 @@ void init_tee_runtime(void)
 static void init_primary_helper(unsigned long pageable_part,
 				unsigned long nsec_entry, unsigned long fdt)
 {
+	size_t boot_prof = 0;
+	size_t prof = 0;
+
 	/*
 	 * Mask asynchronous exceptions before switch to the thread vector
 	 * as the thread handler requires those to be masked while
@@ -1113,9 +1349,13 @@ static void init_primary_helper(unsigned long pageable_part,
 	 * its functions.
 	 */
 	thread_set_exceptions(THREAD_EXCP_ALL);
+	boot_prof = boot_profile_begin("init_primary", 0);
+	primary_init_atomics();
 	primary_save_cntfrq();
 	init_vfp_sec();
+	prof = boot_profile_begin("init_runtime", 0);
 	init_runtime(pageable_part);
+	boot_profile_end(prof, TEE_SUCCESS);
 
 #ifndef CFG_VIRTUALIZATION
 	thread_init_boot_thread();
@@ -1123,23 +1363,34 @@ static void init_primary_helper(unsigned long pageable_part,
 	thread_init_primary(generic_boot_get_handlers());
 	thread_init_per_cpu();
 	init_sec_mon(nsec_entry);
+	prof = boot_profile_begin("init_external_dt", 0);
 	init_external_dt(fdt);
+	boot_profile_end(prof, TEE_SUCCESS);
+	prof = boot_profile_begin("discover_nsec_memory", 0);
 	discover_nsec_memory();
+	boot_profile_end(prof, TEE_SUCCESS);
 	update_external_dt();
 	configure_console_from_dt();
 
 	IMSG("OP-TEE version: %s", core_v_str);
 
+	prof = boot_profile_begin("main_init_gic", 0);
 	main_init_gic();
+	boot_profile_end(prof, TEE_SUCCESS);
 	init_vfp_nsec();
 #ifndef CFG_VIRTUALIZATION
+	prof = boot_profile_begin("init_tee_runtime", 0);
 	init_tee_runtime();
+	boot_profile_end(prof, TEE_SUCCESS);
 #endif
 	release_external_dt();
 #ifdef CFG_VIRTUALIZATION
 	IMSG("Initializing virtualization support");
 	core_mmu_init_virtualization();
 #endif
+	boot_parallel_end();
+	boot_profile_end(boot_prof, TEE_SUCCESS);
+	boot_profile_print();
 	DMSG("Primary CPU switching to normal world boot");
 }
 
@@ -1157,6 +1408,7 @@ static void init_secondary_helper(unsigned long nsec_entry)
 	 */
 	thread_set_exceptions(THREAD_EXCP_ALL);
 
+	secondary_init_atomics();
 	secondary_init_cntfrq();
 	thread_init_per_cpu();
 	init_sec_mon(nsec_entry);
@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <arm.h>
+#include <kernel/lock_stats.h>
+#include <kernel/spinlock.h>
+#include <string.h>
+#include <util.h>
+
+/*
+ * Sites are identified by the lock and the file name and line number, or
+ * function name and line number, of the code taking it. The names are
+ * string literals so their addresses are compared. The last entry of the
+ * table accounts for the sites which didn't fit.
+ */
+
+#define NUM_SITES	CFG_LOCK_STATS_SITES
+
+struct lock_stats_site {
+	const void *lock;
+	const char *fname;
+	int lineno;
+	uint32_t type;
+	uint64_t acquired;
+	uint64_t contended;
+	uint64_t wait;
+	uint64_t wait_max;
+	uint64_t hold;
+	uint64_t hold_max;
+};
+
+static struct lock_stats_site lock_sites[NUM_SITES];
+/* Not accounted, it would recurse */
+static unsigned int lock_sites_lock = SPINLOCK_UNLOCK;
+
+uint64_t lock_stats_now(void)
+{
+	return read_cntpct();
+}
+
+static struct lock_stats_site *get_site(const void *lock, const char *fname,
+				       int lineno, uint32_t type)
+{
+	uint32_t h = ((vaddr_t)lock ^ (vaddr_t)fname) * 0x01000193 ^ lineno;
+	struct lock_stats_site *s = NULL;
+	size_t n = 0;
+
+	/* Linear probing in all entries but the last */
+	for (n = 0; n < NUM_SITES - 1; n++) {
+		s = lock_sites + (h + n) % (NUM_SITES - 1);
+		if (!s->lock) {
+			s->lock = lock;
+			s->fname = fname;
+			s->lineno = lineno;
+			s->type = type;
+			return s;
+		}
+		if (s->lock == lock && s->fname == fname &&
+		    s->lineno == lineno && s->type == type)
+			return s;
+	}
+
+	return lock_sites + NUM_SITES - 1;
+}
+
+struct lock_stats_site *lock_stats_acquired(const void *lock,
+					    const char *fname, int lineno,
+					    uint32_t type, uint64_t begin,
+					    bool contended)
+{
+	uint64_t wait = lock_stats_now() - begin;
+	struct lock_stats_site *s = NULL;
+	uint32_t exceptions = 0;
+
+	exceptions = cpu_spin_lock_xsave(&lock_sites_lock);
+	s = get_site(lock, fname, lineno, type);
+	s->acquired++;
+	if (contended)
+		s->contended++;
+	s->wait += wait;
+	s->wait_max = MAX(s->wait_max, wait);
+	cpu_spin_unlock_xrestore(&lock_sites_lock, exceptions);
+
+	return s;
+}
+
+void lock_stats_released(struct lock_stats_site *s, uint64_t acquired)
+{
+	uint64_t hold = lock_stats_now() - acquired;
+	uint32_t exceptions = 0;
+
+	if (!s)
+		return;
+
+	exceptions = cpu_spin_lock_xsave(&lock_sites_lock);
+	s->hold += hold;
+	s->hold_max = MAX(s->hold_max, hold);
+	cpu_spin_unlock_xrestore(&lock_sites_lock, exceptions);
+}
+
+static uint64_t ticks_to_ns(uint64_t ticks, uint64_t freq)
+{
+	return (ticks / freq) * 1000000000 +
+	       ((ticks % freq) * 1000000000) / freq;
+}
+
+static void site_to_stats(const struct lock_stats_site *s,
+			  struct lock_stats *st, uint64_t freq)
+{
+	size_t len = 0;
+
+	memset(st, 0, sizeof(*st));
+	st->lock = (vaddr_t)s->lock;
+	if (s->fname) {
+		/* Keep the end of the name, the start is the least useful */
+		len = strlen(s->fname);
+		if (len >= sizeof(st->fname))
+			memcpy(st->fname, s->fname + len - sizeof(st->fname) + 1,
+			       sizeof(st->fname) - 1);
+		else
+			memcpy(st->fname, s->fname, len);
+	}
+	st->lineno = s->lineno;
+	st->type = s->type;
+	st->acquired = s->acquired;
+	st->contended = s->contended;
+	st->wait_ns = ticks_to_ns(s->wait, freq);
+	st->wait_max_ns = ticks_to_ns(s->wait_max, freq);
+	st->hold_ns = ticks_to_ns(s->hold, freq);
+	st->hold_max_ns = ticks_to_ns(s->hold_max, freq);
+}
+
+bool lock_stats_get(struct lock_stats *stats, size_t *count, bool reset)
+{
+	uint64_t freq = read_cntfrq();
+	uint32_t exceptions = 0;
+	bool ret = true;
+	size_t num = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&lock_sites_lock);
+
+	for (n = 0; n < NUM_SITES; n++)
+		if (lock_sites[n].acquired)
+			num++;
+	if (*count < num) {
+		ret = false;
+		goto out;
+	}
+
+	num = 0;
+	for (n = 0; n < NUM_SITES; n++) {
+		if (!lock_sites[n].acquired)
+			continue;
+		site_to_stats(lock_sites + n, stats + num, freq);
+		num++;
+	}
+	/*
+	 * Sites are kept since the holders of the locks refer to them,
+	 * only the counters are cleared.
+	 */
+	if (reset) {
+		for (n = 0; n < NUM_SITES; n++) {
+			lock_sites[n].acquired = 0;
+			lock_sites[n].contended = 0;
+			lock_sites[n].wait = 0;
+			lock_sites[n].wait_max = 0;
+			lock_sites[n].hold = 0;
+			lock_sites[n].hold_max = 0;
+		}
+	}
+out:
+	*count = num;
+	cpu_spin_unlock_xrestore(&lock_sites_lock, exceptions);
+
+	return ret;
+}
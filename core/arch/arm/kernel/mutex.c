@@ -3,6 +3,8 @@
  * Copyright (c) 2015-2017, Linaro Limited
  */
 
+#include <io.h>
+#include <kernel/lock_stats.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/spinlock.h>
@@ -16,8 +18,98 @@ void mutex_init(struct mutex *m)
 	*m = (struct mutex)MUTEX_INITIALIZER;
 }
 
+#ifdef CFG_LOCK_STATS
+static void mutex_stats_locked(struct mutex *m, const char *fname,
+			       int lineno, uint64_t begin, bool contended)
+{
+	m->stats_site = lock_stats_acquired(m, fname, lineno,
+					    LOCK_STATS_TYPE_MUTEX, begin,
+					    contended);
+	m->stats_time = lock_stats_now();
+}
+
+static void mutex_stats_unlocked(struct lock_stats_site *site, uint64_t time)
+{
+	lock_stats_released(site, time);
+}
+#else
+static void mutex_stats_locked(struct mutex *m __unused,
+			       const char *fname __unused,
+			       int lineno __unused, uint64_t begin __unused,
+			       bool contended __unused)
+{
+}
+
+static void mutex_stats_unlocked(struct lock_stats_site *site __unused,
+				 uint64_t time __unused)
+{
+}
+#endif
+
+/* Site and time of the write lock of @m, to be accounted once unlocked */
+static void mutex_stats_owner(struct mutex *m __maybe_unused,
+			      struct lock_stats_site **site, uint64_t *time)
+{
+#ifdef CFG_LOCK_STATS
+	*site = m->stats_site;
+	*time = m->stats_time;
+#else
+	*site = NULL;
+	*time = 0;
+#endif
+}
+
+#if CFG_MUTEX_SPIN_COUNT
+static void mutex_set_owner(struct mutex *m)
+{
+	m->owner_id = thread_get_id();
+}
+
+/*
+ * Called with the spinlock held and @m write locked, returns true if the
+ * owner is executing on another CPU and there's spin budget left.
+ */
+static bool mutex_can_spin(struct mutex *m, unsigned int budget)
+{
+	return budget && m->owner_id != thread_get_id() &&
+	       thread_is_active(m->owner_id);
+}
+
+/*
+ * Spins until @m isn't write locked any longer, the owner is suspended or
+ * @budget is exhausted.
+ */
+static void mutex_spin(struct mutex *m, unsigned int *budget)
+{
+	short owner_id = READ_ONCE(m->owner_id);
+
+	while (*budget && READ_ONCE(m->state) == -1 &&
+	       thread_is_active(owner_id))
+		(*budget)--;
+}
+#else
+static void mutex_set_owner(struct mutex *m __unused)
+{
+}
+
+static bool mutex_can_spin(struct mutex *m __unused,
+			   unsigned int budget __unused)
+{
+	return false;
+}
+
+static void mutex_spin(struct mutex *m __unused,
+		       unsigned int *budget __unused)
+{
+}
+#endif
+
 static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 {
+	uint64_t begin = lock_stats_now();
+	unsigned int budget = CFG_MUTEX_SPIN_COUNT;
+	bool contended = false;
+
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != -1);
 	assert(thread_is_in_normal_mode());
@@ -27,6 +119,7 @@ static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 	while (true) {
 		uint32_t old_itr_status;
 		bool can_lock;
+		bool can_spin = false;
 		struct wait_queue_elem wqe;
 
 		/*
@@ -42,33 +135,53 @@ static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 
 		can_lock = !m->state;
 		if (!can_lock) {
-			wq_wait_init(&m->wq, &wqe, false /* wait_read */);
+			can_spin = m->state == -1 && mutex_can_spin(m, budget);
+			if (!can_spin)
+				wq_wait_init(&m->wq, &wqe,
+					     false /* wait_read */);
 		} else {
 			m->state = -1; /* write locked */
+			mutex_set_owner(m);
 		}
 
 		cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
-		if (!can_lock) {
+		if (can_spin) {
+			/*
+			 * The owner is running on another CPU and is likely
+			 * to release the lock soon, cheaper than a round
+			 * trip to normal world.
+			 */
+			mutex_spin(m, &budget);
+			contended = true;
+		} else if (!can_lock) {
 			/*
 			 * Someone else is holding the lock, wait in normal
 			 * world for the lock to become available.
 			 */
 			wq_wait_final(&m->wq, &wqe, m, fname, lineno);
-		} else
+			contended = true;
+		} else {
+			mutex_stats_locked(m, fname, lineno, begin, contended);
 			return;
+		}
 	}
 }
 
 static void __mutex_unlock(struct mutex *m, const char *fname, int lineno)
 {
 	uint32_t old_itr_status;
+	struct lock_stats_site *site = NULL;
+	uint64_t time = 0;
 
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != -1);
 
 	mutex_unlock_check(m);
 
+	/* Read before unlocking, the next owner overwrites them */
+	mutex_stats_owner(m, &site, &time);
+
 	old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
 	if (!m->state)
@@ -78,12 +191,14 @@ static void __mutex_unlock(struct mutex *m, const char *fname, int lineno)
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
+	mutex_stats_unlocked(site, time);
 	wq_wake_next(&m->wq, m, fname, lineno);
 }
 
-static bool __mutex_trylock(struct mutex *m, const char *fname __unused,
-			int lineno __unused)
+static bool __mutex_trylock(struct mutex *m, const char *fname __maybe_unused,
+			    int lineno __maybe_unused)
 {
+	uint64_t begin = lock_stats_now();
 	uint32_t old_itr_status;
 	bool can_lock_write;
 
@@ -93,13 +208,17 @@ static bool __mutex_trylock(struct mutex *m, const char *fname __unused,
 	old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
 	can_lock_write = !m->state;
-	if (can_lock_write)
+	if (can_lock_write) {
 		m->state = -1;
+		mutex_set_owner(m);
+	}
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
-	if (can_lock_write)
+	if (can_lock_write) {
 		mutex_trylock_check(m);
+		mutex_stats_locked(m, fname, lineno, begin, false);
+	}
 
 	return can_lock_write;
 }
@@ -128,6 +247,9 @@ static void __mutex_read_unlock(struct mutex *m, const char *fname, int lineno)
 
 static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 {
+	uint64_t begin = lock_stats_now();
+	bool contended = false;
+
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != -1);
 	assert(thread_is_in_normal_mode());
@@ -163,14 +285,21 @@ static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 			 * world for the lock to become available.
 			 */
 			wq_wait_final(&m->wq, &wqe, m, fname, lineno);
-		} else
+			contended = true;
+		} else {
+			lock_stats_acquired(m, fname, lineno,
+					    LOCK_STATS_TYPE_MUTEX_READ, begin,
+					    contended);
 			return;
+		}
 	}
 }
 
-static bool __mutex_read_trylock(struct mutex *m, const char *fname __unused,
-				 int lineno __unused)
+static bool __mutex_read_trylock(struct mutex *m,
+				 const char *fname __maybe_unused,
+				 int lineno __maybe_unused)
 {
+	uint64_t begin = lock_stats_now();
 	uint32_t old_itr_status;
 	bool can_lock;
 
@@ -186,6 +315,10 @@ static bool __mutex_read_trylock(struct mutex *m, const char *fname __unused,
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
+	if (can_lock)
+		lock_stats_acquired(m, fname, lineno,
+				    LOCK_STATS_TYPE_MUTEX_READ, begin, false);
+
 	return can_lock;
 }
 
@@ -320,6 +453,8 @@ static void __condvar_wait(struct condvar *cv, struct mutex *m,
 {
 	uint32_t old_itr_status;
 	struct wait_queue_elem wqe;
+	struct lock_stats_site *site = NULL;
+	uint64_t time = 0;
 	short old_state;
 	short new_state;
 
@@ -338,6 +473,8 @@ static void __condvar_wait(struct condvar *cv, struct mutex *m,
 	if (!m->state)
 		panic();
 	old_state = m->state;
+	if (old_state < 0)
+		mutex_stats_owner(m, &site, &time);
 	/* Add to mutex wait queue as a condvar waiter */
 	wq_wait_init_condvar(&m->wq, &wqe, cv, m->state > 0);
 
@@ -352,16 +489,18 @@ static void __condvar_wait(struct condvar *cv, struct mutex *m,
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
+	mutex_stats_unlocked(site, time);
 	/* Wake eventual waiters if the mutex was unlocked */
 	if (!new_state)
 		wq_wake_next(&m->wq, m, fname, lineno);
 
 	wq_wait_final(&m->wq, &wqe, m, fname, lineno);
 
+	/* Relocked on behalf of the caller, accounted to the same site */
 	if (old_state > 0)
-		mutex_read_lock(m);
+		__mutex_read_lock(m, fname, lineno);
 	else
-		mutex_lock(m);
+		__mutex_lock(m, fname, lineno);
 }
 
 #ifdef CFG_MUTEX_DEBUG
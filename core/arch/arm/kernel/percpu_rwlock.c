@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <assert.h>
+#include <io.h>
+#include <kernel/misc.h>
+#include <kernel/percpu_rwlock.h>
+#include <kernel/thread.h>
+
+/*
+ * A reader increments its counter and then checks for a writer, a writer
+ * sets its flag and then sums the counters. With a full barrier between
+ * the two steps on both sides at least one of them sees the other.
+ */
+
+static void add_count(struct percpu_rwlock *l, long v)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+
+	/* Only modified by the local CPU with foreign interrupts masked */
+	l->cpu[get_core_pos()].count += v;
+	thread_unmask_exceptions(exceptions);
+}
+
+static long sum_counts(struct percpu_rwlock *l)
+{
+	long sum = 0;
+	size_t n = 0;
+
+	for (n = 0; n < CFG_TEE_CORE_NB_CORE; n++)
+		sum += READ_ONCE(l->cpu[n].count);
+
+	return sum;
+}
+
+void percpu_rwlock_read_lock(struct percpu_rwlock *l)
+{
+	assert(thread_is_in_normal_mode());
+
+	add_count(l, 1);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (!READ_ONCE(l->writer))
+		return;
+
+	/* Back off, the writer may be waiting for this counter */
+	add_count(l, -1);
+
+	mutex_lock(&l->mu);
+	condvar_broadcast(&l->cv);
+	while (l->writer)
+		condvar_wait(&l->cv, &l->mu);
+	/* No writer can start while the mutex is held */
+	add_count(l, 1);
+	mutex_unlock(&l->mu);
+}
+
+void percpu_rwlock_read_unlock(struct percpu_rwlock *l)
+{
+	add_count(l, -1);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (!READ_ONCE(l->writer))
+		return;
+
+	mutex_lock(&l->mu);
+	condvar_broadcast(&l->cv);
+	mutex_unlock(&l->mu);
+}
+
+void percpu_rwlock_write_lock(struct percpu_rwlock *l)
+{
+	mutex_lock(&l->mu);
+	while (l->writer)
+		condvar_wait(&l->cv, &l->mu);
+	l->writer = true;
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	while (sum_counts(l))
+		condvar_wait(&l->cv, &l->mu);
+	mutex_unlock(&l->mu);
+}
+
+void percpu_rwlock_write_unlock(struct percpu_rwlock *l)
+{
+	mutex_lock(&l->mu);
+	assert(l->writer);
+	l->writer = false;
+	condvar_broadcast(&l->cv);
+	mutex_unlock(&l->mu);
+}
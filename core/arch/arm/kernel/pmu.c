@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <arm.h>
+#include <assert.h>
+#include <kernel/misc.h>
+#include <kernel/pmu.h>
+#include <kernel/thread.h>
+#include <util.h>
+
+/*
+ * The PMU is shared with normal world. Its configuration is saved when
+ * counting starts and restored when counting stops, so counting in
+ * secure world is invisible to normal world except for the events lost
+ * in between.
+ */
+
+#define PMCR_E			BIT32(0)
+#define PMCR_N_SHIFT		11
+#define PMCR_N_MASK		0x1f
+#define PMCNTEN_C		BIT32(31)
+
+struct pmu_cpu_state {
+	bool active;
+	uint32_t num_events;
+	uint32_t pmcr;
+	uint32_t pmcnten;
+	uint32_t pmselr;
+	uint32_t pmccfiltr;
+	uint64_t pmccntr;
+	uint32_t evtyper[PMU_NUM_EVENTS];
+	uint32_t evcntr[PMU_NUM_EVENTS];
+};
+
+static const uint32_t pmu_events[PMU_NUM_EVENTS] = {
+	PMU_EVT_INST_RETIRED, PMU_EVT_L1D_CACHE_REFILL,
+	PMU_EVT_L2D_CACHE_REFILL, PMU_EVT_L1D_TLB_REFILL,
+	PMU_EVT_BR_MIS_PRED,
+};
+
+static struct pmu_cpu_state pmu_cpu_state[CFG_TEE_CORE_NB_CORE];
+
+static void select_counter(uint32_t n)
+{
+	write_pmselr_el0(n);
+	isb();
+}
+
+void pmu_start(void)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	struct pmu_cpu_state *st = pmu_cpu_state + get_core_pos();
+	uint32_t n = 0;
+
+	if (st->active)
+		goto out;
+
+	st->pmcr = read_pmcr_el0();
+	st->num_events = MIN((st->pmcr >> PMCR_N_SHIFT) & PMCR_N_MASK,
+			     (uint32_t)PMU_NUM_EVENTS);
+
+	/* Stop all counters before saving them */
+	write_pmcr_el0(st->pmcr & ~PMCR_E);
+	isb();
+	st->pmcnten = read_pmcntenset_el0();
+	write_pmcntenclr_el0(UINT32_MAX);
+	st->pmselr = read_pmselr_el0();
+	st->pmccfiltr = read_pmccfiltr_el0();
+	st->pmccntr = read_pmccntr();
+	for (n = 0; n < st->num_events; n++) {
+		select_counter(n);
+		st->evtyper[n] = read_pmxevtyper_el0();
+		st->evcntr[n] = read_pmxevcntr_el0();
+		/* No filtering, counting in secure state is set by EL3 */
+		write_pmxevtyper_el0(pmu_events[n]);
+		write_pmxevcntr_el0(0);
+	}
+
+	write_pmccfiltr_el0(0);
+	write_pmccntr(0);
+	write_pmcntenset_el0(PMCNTEN_C | (BIT32(st->num_events) - 1));
+	write_pmcr_el0(st->pmcr | PMCR_E);
+	isb();
+
+	st->active = true;
+out:
+	thread_unmask_exceptions(exceptions);
+}
+
+void pmu_stop(struct pmu_stats *stats)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	struct pmu_cpu_state *st = pmu_cpu_state + get_core_pos();
+	uint32_t n = 0;
+
+	if (!st->active)
+		goto out;
+
+	write_pmcr_el0(st->pmcr & ~PMCR_E);
+	isb();
+	write_pmcntenclr_el0(UINT32_MAX);
+
+	if (stats)
+		stats->cycles += read_pmccntr();
+	write_pmccntr(st->pmccntr);
+	write_pmccfiltr_el0(st->pmccfiltr);
+	for (n = 0; n < st->num_events; n++) {
+		select_counter(n);
+		if (stats)
+			stats->events[n] += read_pmxevcntr_el0();
+		write_pmxevtyper_el0(st->evtyper[n]);
+		write_pmxevcntr_el0(st->evcntr[n]);
+	}
+	write_pmselr_el0(st->pmselr);
+	write_pmcntenset_el0(st->pmcnten);
+	write_pmcr_el0(st->pmcr);
+	isb();
+
+	st->active = false;
+out:
+	thread_unmask_exceptions(exceptions);
+}
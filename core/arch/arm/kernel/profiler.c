@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <arm.h>
+#include <initcall.h>
+#include <kernel/interrupt.h>
+#include <kernel/profiler.h>
+#include <kernel/spinlock.h>
+#include <kernel/tee_misc.h>
+#include <kernel/tee_ta_manager.h>
+#include <kernel/thread.h>
+#include <kernel/timer.h>
+#include <kernel/unwind.h>
+#include <string.h>
+#include <util.h>
+
+#include "thread_private.h"
+
+/*
+ * Statistical sampler of the core driven by the secure physical timer.
+ * Each sample is folded into a table of unique call stacks. The last
+ * entry of the table accounts for the samples which didn't fit.
+ */
+
+#define NUM_STACKS	CFG_CORE_PROFILER_STACKS
+
+static struct core_profile_stack profiler_stacks[NUM_STACKS];
+static unsigned int profiler_lock = SPINLOCK_UNLOCK;
+
+static uint32_t hash_stack(const struct core_profile_stack *st)
+{
+	uint32_t h = st->flags ^ st->session ^ (uint16_t)st->thread;
+	size_t n = 0;
+
+	for (n = 0; n < st->depth; n++)
+		h = (h ^ st->pc[n] ^ (st->pc[n] >> 32)) * 0x01000193;
+
+	return h;
+}
+
+static bool stack_equal(const struct core_profile_stack *a,
+			const struct core_profile_stack *b)
+{
+	return a->thread == b->thread && a->depth == b->depth &&
+	       a->session == b->session && a->flags == b->flags &&
+	       !memcmp(a->pc, b->pc, a->depth * sizeof(a->pc[0]));
+}
+
+static void add_sample(struct core_profile_stack *st)
+{
+	size_t idx = hash_stack(st) % (NUM_STACKS - 1);
+	struct core_profile_stack *e = NULL;
+	size_t n = 0;
+
+	/* Linear probing in all entries but the last */
+	for (n = 0; n < NUM_STACKS - 1; n++) {
+		e = profiler_stacks + (idx + n) % (NUM_STACKS - 1);
+		if (!e->count) {
+			*e = *st;
+			break;
+		}
+		if (stack_equal(e, st))
+			break;
+	}
+	if (n == NUM_STACKS - 1) {
+		e = profiler_stacks + NUM_STACKS - 1;
+		e->flags = CORE_PROFILE_FLAG_DROPPED;
+		e->thread = -1;
+	}
+	e->count++;
+}
+
+static void unwind_sample(struct core_profile_stack *st, vaddr_t pc,
+			  vaddr_t fp)
+{
+	struct unwind_state_arm64 state = { .pc = pc, .fp = fp };
+	vaddr_t stack = thread_stack_start();
+	size_t stack_size = thread_stack_size();
+
+	st->pc[0] = pc;
+	st->depth = 1;
+
+	/* Only thread stacks are unwound, frames on other stacks are lost */
+	if (!stack)
+		return;
+
+	while (st->depth < CORE_PROFILE_DEPTH &&
+	       unwind_stack_arm64(&state, stack, stack_size)) {
+		st->pc[st->depth] = state.pc;
+		st->depth++;
+	}
+}
+
+static void sample(void)
+{
+	struct thread_core_local *l = thread_get_core_local();
+	struct core_profile_stack st = { .thread = l->curr_thread };
+	struct tee_ta_session *s = NULL;
+	uint32_t exceptions = 0;
+	uint64_t spsr = 0;
+
+	/*
+	 * THREAD_CLF_IRQ or THREAD_CLF_FIQ is only set when the interrupt
+	 * was taken in secure world, else the interrupt was forwarded by
+	 * the secure monitor while normal world was executing.
+	 */
+	if (!(l->flags & (THREAD_CLF_IRQ | THREAD_CLF_FIQ))) {
+		st.flags = CORE_PROFILE_FLAG_NSEC;
+	} else {
+		spsr = read_spsr_el1();
+		if ((spsr & (SPSR_MODE_RW_32 << SPSR_MODE_RW_SHIFT)) ||
+		    ((spsr >> SPSR_64_MODE_EL_SHIFT) & SPSR_64_MODE_EL_MASK) ==
+		    SPSR_64_MODE_EL0) {
+			st.flags = CORE_PROFILE_FLAG_USER;
+			st.pc[0] = read_elr_el1();
+			st.depth = 1;
+		} else {
+			unwind_sample(&st, read_elr_el1(), l->intr_fp);
+		}
+	}
+
+	if (st.thread != -1 && !tee_ta_get_current_session(&s))
+		st.session = s->id;
+
+	exceptions = cpu_spin_lock_xsave(&profiler_lock);
+	add_sample(&st);
+	cpu_spin_unlock_xrestore(&profiler_lock, exceptions);
+}
+
+static enum itr_return profiler_itr_cb(struct itr_handler *h __unused)
+{
+	/* Rearm the timer for the next sample */
+	generic_timer_handler(CFG_CORE_PROFILER_PERIOD_MS);
+	sample();
+
+	return ITRR_HANDLED;
+}
+
+static struct itr_handler profiler_itr = {
+	.it = CFG_CORE_PROFILER_IT,
+	.flags = ITRF_TRIGGER_LEVEL,
+	.handler = profiler_itr_cb,
+};
+
+bool core_profiler_get(struct core_profile_stack *stacks, size_t *count,
+		       bool reset)
+{
+	uint32_t exceptions = 0;
+	bool ret = true;
+	size_t num = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&profiler_lock);
+
+	for (n = 0; n < NUM_STACKS; n++)
+		if (profiler_stacks[n].count)
+			num++;
+	if (*count < num) {
+		ret = false;
+		goto out;
+	}
+
+	num = 0;
+	for (n = 0; n < NUM_STACKS; n++) {
+		if (!profiler_stacks[n].count)
+			continue;
+		stacks[num] = profiler_stacks[n];
+		num++;
+	}
+	if (reset)
+		memset(profiler_stacks, 0, sizeof(profiler_stacks));
+out:
+	*count = num;
+	cpu_spin_unlock_xrestore(&profiler_lock, exceptions);
+
+	return ret;
+}
+
+static TEE_Result init_profiler(void)
+{
+	COMPILE_TIME_ASSERT(NUM_STACKS > 1);
+
+	itr_add(&profiler_itr);
+	itr_enable(CFG_CORE_PROFILER_IT);
+	generic_timer_start(CFG_CORE_PROFILER_PERIOD_MS);
+
+	return TEE_SUCCESS;
+}
+driver_init(init_profiler);
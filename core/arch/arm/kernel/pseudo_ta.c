@@ -202,6 +202,23 @@ out:
 	return res;
 }
 
+TEE_Result pseudo_ta_invoke_direct(struct tee_ta_session *s, uint32_t cmd,
+				   uint32_t param_types,
+				   TEE_Param params[TEE_NUM_PARAMS])
+{
+	struct pseudo_ta_ctx *stc = to_pseudo_ta_ctx(s->ctx);
+	TEE_Result res = TEE_SUCCESS;
+
+	assert(s->ctx->flags & TA_FLAG_CONCURRENT);
+
+	tee_ta_push_current_session(s);
+	res = stc->pseudo_ta->invoke_command_entry_point(s->user_ctx, cmd,
+							 param_types, params);
+	tee_ta_pop_current_session();
+
+	return res;
+}
+
 static void pseudo_ta_enter_close_session(struct tee_ta_session *s)
 {
 	struct pseudo_ta_ctx *stc = to_pseudo_ta_ctx(s->ctx);
@@ -302,7 +319,10 @@ TEE_Result tee_ta_init_pseudo_ta_session(const TEE_UUID *uuid,
 	stc->pseudo_ta = ta;
 	ctx->uuid = ta->uuid;
 	ctx->ops = &pseudo_ta_ops;
-	TAILQ_INSERT_TAIL(&tee_ctxes, ctx, link);
+	mutex_init(&ctx->busy_mutex);
+	condvar_init(&ctx->busy_cv);
+	TAILQ_INIT(&ctx->busy_waiters);
+	tee_ta_link_ctx(ctx);
 
 	DMSG("%s : %pUl", stc->pseudo_ta->name, (void *)&ctx->uuid);
 
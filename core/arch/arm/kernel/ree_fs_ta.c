@@ -5,6 +5,7 @@
 #include <assert.h>
 #include <crypto/crypto.h>
 #include <initcall.h>
+#include <kernel/mutex.h>
 #include <kernel/thread.h>
 #include <kernel/user_ta_store.h>
 #include <mm/core_memprot.h>
@@ -14,9 +15,11 @@
 #include <signed_hdr.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/queue.h>
 #include <tee_api_types.h>
 #include <tee/uuid.h>
 #include <utee_defines.h>
+#include <util.h>
 
 struct ree_fs_ta_handle {
 	struct shdr *nw_ta; /* Non-secure (shared memory) */
@@ -234,6 +237,12 @@ out:
 	return res;
 }
 
+/*
+ * Number of bytes copied before they are hashed, small enough for the copy
+ * to still be in the data cache when the hash function reads it back.
+ */
+#define REE_FS_TA_READ_CHUNK	SMALL_PAGE_SIZE
+
 static TEE_Result ree_fs_ta_read(struct user_ta_store_handle *h, void *data,
 				 size_t len)
 {
@@ -241,17 +250,23 @@ static TEE_Result ree_fs_ta_read(struct user_ta_store_handle *h, void *data,
 
 	uint8_t *src = (uint8_t *)handle->nw_ta + handle->offs;
 	uint8_t *dst = src;
-	TEE_Result res;
+	size_t chunk = 0;
+	size_t n = 0;
+	TEE_Result res = TEE_SUCCESS;
 
 	if (handle->offs + len > handle->nw_ta_size)
 		return TEE_ERROR_BAD_PARAMETERS;
-	if (data) {
+	if (data)
 		dst = data; /* Hash secure buffer (shm might be modified) */
-		memcpy(dst, src, len);
+	for (n = 0; n < len; n += chunk) {
+		chunk = MIN(len - n, (size_t)REE_FS_TA_READ_CHUNK);
+		if (data)
+			memcpy(dst + n, src + n, chunk);
+		res = crypto_hash_update(handle->hash_ctx, handle->hash_algo,
+					 dst + n, chunk);
+		if (res != TEE_SUCCESS)
+			return TEE_ERROR_SECURITY;
 	}
-	res = crypto_hash_update(handle->hash_ctx, handle->hash_algo, dst, len);
-	if (res != TEE_SUCCESS)
-		return TEE_ERROR_SECURITY;
 	handle->offs += len;
 	if (handle->offs == handle->nw_ta_size) {
 		/*
@@ -295,78 +310,226 @@ TEE_TA_REGISTER_TA_STORE(9) = {
  * by the upper layer (ELF loader).
  */
 
-struct buf_ree_fs_ta_handle {
-	struct user_ta_store_handle *h; /* Note: a REE FS TA store handle */
+/*
+ * A verified TA binary in secure memory, shared by all the handles opened
+ * on it while it is kept in the cache.
+ */
+struct buf_ta_image {
+	TEE_UUID uuid;
 	size_t ta_size;
 	tee_mm_entry_t *mm;
 	uint8_t *buf;
-	size_t offs;
 	uint8_t *tag;
 	unsigned int tag_len;
+	unsigned int refcount;
+	bool cached;
+	TAILQ_ENTRY(buf_ta_image) link;
 };
 
-static TEE_Result buf_ta_open(const TEE_UUID *uuid,
-			      struct user_ta_store_handle **h)
+struct buf_ree_fs_ta_handle {
+	struct buf_ta_image *img;
+	size_t offs;
+};
+
+/*
+ * Least recently used images are at the tail. Cached images with a zero
+ * refcount are only held by the cache and may be evicted at any time.
+ */
+static TAILQ_HEAD(buf_ta_image_head, buf_ta_image) buf_ta_cache =
+	TAILQ_HEAD_INITIALIZER(buf_ta_cache);
+static size_t buf_ta_cache_count;
+static struct mutex buf_ta_cache_mutex = MUTEX_INITIALIZER;
+
+static void free_buf_ta_image(struct buf_ta_image *img)
 {
-	struct buf_ree_fs_ta_handle *handle = NULL;
+	if (!img)
+		return;
+	tee_mm_free(img->mm);
+	free(img->tag);
+	free(img);
+}
+
+/* Must be called with buf_ta_cache_mutex held */
+static bool evict_buf_ta_image(void)
+{
+	struct buf_ta_image *img = NULL;
+
+	TAILQ_FOREACH_REVERSE(img, &buf_ta_cache, buf_ta_image_head, link) {
+		if (!img->refcount) {
+			TAILQ_REMOVE(&buf_ta_cache, img, link);
+			buf_ta_cache_count--;
+			free_buf_ta_image(img);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static struct buf_ta_image *get_cached_buf_ta_image(const TEE_UUID *uuid)
+{
+	struct buf_ta_image *img = NULL;
+
+	mutex_lock(&buf_ta_cache_mutex);
+	TAILQ_FOREACH(img, &buf_ta_cache, link) {
+		if (!memcmp(&img->uuid, uuid, sizeof(*uuid))) {
+			img->refcount++;
+			TAILQ_REMOVE(&buf_ta_cache, img, link);
+			TAILQ_INSERT_HEAD(&buf_ta_cache, img, link);
+			break;
+		}
+	}
+	mutex_unlock(&buf_ta_cache_mutex);
+
+	return img;
+}
+
+static void put_buf_ta_image(struct buf_ta_image *img)
+{
+	bool do_free = false;
+
+	mutex_lock(&buf_ta_cache_mutex);
+	assert(img->refcount);
+	img->refcount--;
+	do_free = !img->refcount && !img->cached;
+	mutex_unlock(&buf_ta_cache_mutex);
+
+	if (do_free)
+		free_buf_ta_image(img);
+}
+
+/*
+ * Inserts @img in the cache unless another image of the same TA was added
+ * meanwhile or all the entries are in use, in which case @img is freed on
+ * its last put_buf_ta_image().
+ */
+static void add_buf_ta_image(struct buf_ta_image *img)
+{
+	struct buf_ta_image *i = NULL;
+
+	mutex_lock(&buf_ta_cache_mutex);
+	TAILQ_FOREACH(i, &buf_ta_cache, link)
+		if (!memcmp(&i->uuid, &img->uuid, sizeof(img->uuid)))
+			goto out;
+	if (buf_ta_cache_count == CFG_REE_FS_TA_CACHE_ENTRIES &&
+	    !evict_buf_ta_image())
+		goto out;
+	img->cached = true;
+	TAILQ_INSERT_HEAD(&buf_ta_cache, img, link);
+	buf_ta_cache_count++;
+out:
+	mutex_unlock(&buf_ta_cache_mutex);
+}
+
+static tee_mm_entry_t *alloc_buf_ta_mem(size_t size)
+{
+	tee_mm_entry_t *mm = NULL;
+	bool evicted = false;
+
+	/* Drop unused cached images until the binary fits in TA RAM */
+	while (true) {
+		mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
+		if (mm)
+			return mm;
+
+		mutex_lock(&buf_ta_cache_mutex);
+		evicted = evict_buf_ta_image();
+		mutex_unlock(&buf_ta_cache_mutex);
+		if (!evicted)
+			return NULL;
+	}
+}
+
+static TEE_Result load_buf_ta_image(const TEE_UUID *uuid,
+				    struct buf_ta_image **img_ret)
+{
+	struct user_ta_store_handle *h = NULL;
+	struct buf_ta_image *img = NULL;
 	TEE_Result res = TEE_SUCCESS;
 
-	handle = calloc(1, sizeof(*handle));
-	if (!handle)
+	img = calloc(1, sizeof(*img));
+	if (!img)
 		return TEE_ERROR_OUT_OF_MEMORY;
-	res = ree_fs_ta_open(uuid, &handle->h);
+	img->uuid = *uuid;
+	img->refcount = 1;
+
+	res = ree_fs_ta_open(uuid, &h);
 	if (res)
 		goto err2;
-	res = ree_fs_ta_get_size(handle->h, &handle->ta_size);
+	res = ree_fs_ta_get_size(h, &img->ta_size);
 	if (res)
 		goto err;
 
-	res = ree_fs_ta_get_tag(handle->h, NULL, &handle->tag_len);
+	res = ree_fs_ta_get_tag(h, NULL, &img->tag_len);
 	if (res != TEE_ERROR_SHORT_BUFFER) {
 		res = TEE_ERROR_GENERIC;
 		goto err;
 	}
-	handle->tag = malloc(handle->tag_len);
-	if (!handle->tag) {
+	img->tag = malloc(img->tag_len);
+	if (!img->tag) {
 		res = TEE_ERROR_OUT_OF_MEMORY;
 		goto err;
 	}
-	res = ree_fs_ta_get_tag(handle->h, handle->tag, &handle->tag_len);
+	res = ree_fs_ta_get_tag(h, img->tag, &img->tag_len);
 	if (res)
 		goto err;
 
-	handle->mm = tee_mm_alloc(&tee_mm_sec_ddr, handle->ta_size);
-	if (!handle->mm) {
+	img->mm = alloc_buf_ta_mem(img->ta_size);
+	if (!img->mm) {
 		res = TEE_ERROR_OUT_OF_MEMORY;
 		goto err;
 	}
-	handle->buf = phys_to_virt(tee_mm_get_smem(handle->mm),
-				   MEM_AREA_TA_RAM);
-	if (!handle->buf) {
+	img->buf = phys_to_virt(tee_mm_get_smem(img->mm), MEM_AREA_TA_RAM);
+	if (!img->buf) {
 		res = TEE_ERROR_OUT_OF_MEMORY;
 		goto err;
 	}
-	res = ree_fs_ta_read(handle->h, handle->buf, handle->ta_size);
+	res = ree_fs_ta_read(h, img->buf, img->ta_size);
 	if (res)
 		goto err;
-	*h = (struct user_ta_store_handle *)handle;
+	*img_ret = img;
 err:
-	ree_fs_ta_close(handle->h);
+	ree_fs_ta_close(h);
 err2:
-	if (res) {
-		tee_mm_free(handle->mm);
-		free(handle->tag);
-		free(handle);
-	}
+	if (res)
+		free_buf_ta_image(img);
 	return res;
 }
 
+static TEE_Result buf_ta_open(const TEE_UUID *uuid,
+			      struct user_ta_store_handle **h)
+{
+	struct buf_ree_fs_ta_handle *handle = NULL;
+	TEE_Result res = TEE_SUCCESS;
+
+	handle = calloc(1, sizeof(*handle));
+	if (!handle)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	/*
+	 * A cached image has already been authenticated, the RPC load and
+	 * the signature check can be skipped.
+	 */
+	handle->img = get_cached_buf_ta_image(uuid);
+	if (!handle->img) {
+		res = load_buf_ta_image(uuid, &handle->img);
+		if (res) {
+			free(handle);
+			return res;
+		}
+		add_buf_ta_image(handle->img);
+	}
+
+	*h = (struct user_ta_store_handle *)handle;
+	return TEE_SUCCESS;
+}
+
 static TEE_Result buf_ta_get_size(const struct user_ta_store_handle *h,
 				  size_t *size)
 {
 	struct buf_ree_fs_ta_handle *handle = (struct buf_ree_fs_ta_handle *)h;
 
-	*size = handle->ta_size;
+	*size = handle->img->ta_size;
 	return TEE_SUCCESS;
 }
 
@@ -374,9 +537,9 @@ static TEE_Result buf_ta_read(struct user_ta_store_handle *h, void *data,
 			      size_t len)
 {
 	struct buf_ree_fs_ta_handle *handle = (struct buf_ree_fs_ta_handle *)h;
-	uint8_t *src = handle->buf + handle->offs;
+	uint8_t *src = handle->img->buf + handle->offs;
 
-	if (handle->offs + len > handle->ta_size)
+	if (handle->offs + len > handle->img->ta_size)
 		return TEE_ERROR_BAD_PARAMETERS;
 	if (data)
 		memcpy(data, src, len);
@@ -389,11 +552,11 @@ static TEE_Result buf_ta_get_tag(const struct user_ta_store_handle *h,
 {
 	struct buf_ree_fs_ta_handle *handle = (struct buf_ree_fs_ta_handle *)h;
 
-	*tag_len = handle->tag_len;
-	if (!tag || *tag_len < handle->tag_len)
+	*tag_len = handle->img->tag_len;
+	if (!tag || *tag_len < handle->img->tag_len)
 		return TEE_ERROR_SHORT_BUFFER;
 
-	memcpy(tag, handle->tag, handle->tag_len);
+	memcpy(tag, handle->img->tag, handle->img->tag_len);
 
 	return TEE_SUCCESS;
 }
@@ -404,8 +567,7 @@ static void buf_ta_close(struct user_ta_store_handle *h)
 
 	if (!handle)
 		return;
-	tee_mm_free(handle->mm);
-	free(handle->tag);
+	put_buf_ta_image(handle->img);
 	free(handle);
 }
 
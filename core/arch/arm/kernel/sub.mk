@@ -38,14 +38,22 @@ srcs-$(CFG_ARM32_core) += vfp_a32.S
 srcs-$(CFG_ARM64_core) += vfp_a64.S
 endif
 srcs-y += trace_ext.c
+srcs-$(CFG_CORE_BINARY_TRACE) += trace_bin.c
+srcs-$(CFG_CORE_TRACEPOINTS) += tracepoint.c
 srcs-$(CFG_ARM32_core) += misc_a32.S
 srcs-$(CFG_ARM64_core) += misc_a64.S
+srcs-$(CFG_CORE_USER_ACCESS_UNPRIV) += user_access_a64.S
 srcs-y += mutex.c
+srcs-y += percpu_rwlock.c
 srcs-$(CFG_LOCKDEP) += mutex_lockdep.c
+srcs-$(CFG_LOCK_STATS) += lock_stats.c
 srcs-y += wait_queue.c
+srcs-y += work_queue.c
+srcs-$(CFG_CORE_TELEMETRY) += telemetry.c
 srcs-$(CFG_PM_STUBS) += pm_stubs.c
 
 srcs-$(CFG_GENERIC_BOOT) += generic_boot.c
+srcs-$(CFG_BOOT_PROFILE) += boot_profile.c
 ifeq ($(CFG_GENERIC_BOOT),y)
 srcs-$(CFG_ARM32_core) += generic_entry_a32.S
 srcs-$(CFG_ARM64_core) += generic_entry_a64.S
@@ -54,7 +62,9 @@ endif
 ifeq ($(CFG_UNWIND),y)
 srcs-y += unwind_arm32.c
 srcs-$(CFG_ARM64_core) += unwind_arm64.c
+srcs-$(CFG_CORE_PROFILER) += profiler.c
 endif
+srcs-$(CFG_TA_PMU_STATS) += pmu.c
 
 srcs-$(CFG_VIRTUALIZATION) += virtualization.c
 
@@ -7,11 +7,13 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include <kernel/spinlock.h>
 #include <kernel/tee_time.h>
 #include <kernel/time_source.h>
 #include <kernel/thread.h>
 #include <optee_rpc_cmd.h>
 #include <mm/core_mmu.h>
+#include <utee_defines.h>
 
 struct time_source _time_source;
 
@@ -33,6 +35,72 @@ void tee_time_wait(uint32_t milliseconds_delay)
 	thread_rpc_cmd(OPTEE_RPC_CMD_SUSPEND, 1, &params);
 }
 
+#if CFG_CORE_REE_TIME_CACHE_MS
+/*
+ * The offset between REE time and system time is cached for
+ * CFG_CORE_REE_TIME_CACHE_MS milliseconds of system time, REE time is
+ * derived from system time in the meantime, saving the RPC.
+ */
+static unsigned int ree_time_lock = SPINLOCK_UNLOCK;
+static uint64_t ree_time_offset_ms;
+static uint64_t ree_time_refresh_ms;
+static bool ree_time_cached;
+
+static uint64_t time_to_ms(const TEE_Time *time)
+{
+	return (uint64_t)time->seconds * TEE_TIME_MILLIS_BASE + time->millis;
+}
+
+static bool get_cached_ree_time(TEE_Time *time, uint64_t *sys_ms)
+{
+	uint32_t exceptions = 0;
+	TEE_Time t = { };
+	bool ret = false;
+	uint64_t ms = 0;
+
+	if (tee_time_get_sys_time(&t))
+		return false;
+	*sys_ms = time_to_ms(&t);
+
+	exceptions = cpu_spin_lock_xsave(&ree_time_lock);
+	if (ree_time_cached &&
+	    *sys_ms - ree_time_refresh_ms < CFG_CORE_REE_TIME_CACHE_MS) {
+		ms = *sys_ms + ree_time_offset_ms;
+		ret = true;
+	}
+	cpu_spin_unlock_xrestore(&ree_time_lock, exceptions);
+
+	if (ret) {
+		time->seconds = ms / TEE_TIME_MILLIS_BASE;
+		time->millis = ms % TEE_TIME_MILLIS_BASE;
+	}
+
+	return ret;
+}
+
+static void cache_ree_time(const TEE_Time *time, uint64_t sys_ms)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&ree_time_lock);
+
+	/* Unsigned wrap around gives back REE time when added */
+	ree_time_offset_ms = time_to_ms(time) - sys_ms;
+	ree_time_refresh_ms = sys_ms;
+	ree_time_cached = true;
+	cpu_spin_unlock_xrestore(&ree_time_lock, exceptions);
+}
+#else
+static bool get_cached_ree_time(TEE_Time *time __unused,
+				uint64_t *sys_ms __unused)
+{
+	return false;
+}
+
+static void cache_ree_time(const TEE_Time *time __unused,
+			   uint64_t sys_ms __unused)
+{
+}
+#endif
+
 /*
  * tee_time_get_ree_time(): this function implements the GP Internal API
  * function TEE_GetREETime()
@@ -42,16 +110,21 @@ void tee_time_wait(uint32_t milliseconds_delay)
 TEE_Result tee_time_get_ree_time(TEE_Time *time)
 {
 	TEE_Result res;
+	uint64_t sys_ms = 0;
 
 	if (!time)
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	if (get_cached_ree_time(time, &sys_ms))
+		return TEE_SUCCESS;
+
 	struct thread_param params = THREAD_PARAM_VALUE(OUT, 0, 0, 0);
 
 	res = thread_rpc_cmd(OPTEE_RPC_CMD_GET_TIME, 1, &params);
 	if (res == TEE_SUCCESS) {
 		time->seconds = params.u.value.a;
 		time->millis = params.u.value.b / 1000000;
+		cache_ree_time(time, sys_ms);
 	}
 
 	return res;
@@ -9,18 +9,28 @@
 #include <kernel/tee_time.h>
 #include <kernel/time_source.h>
 #include <mm/core_mmu.h>
+#include <reciprocal_div.h>
 #include <stdint.h>
 #include <tee/tee_cryp_utl.h>
 #include <trace.h>
 #include <utee_defines.h>
 
+/* CNTFRQ is the same on all cores and doesn't change once booted */
+static struct reciprocal_div cntfrq_div;
+
+static void arm_cntpct_init(void)
+{
+	reciprocal_div_init(&cntfrq_div, read_cntfrq());
+}
+
 static TEE_Result arm_cntpct_get_sys_time(TEE_Time *time)
 {
 	uint64_t cntpct = read_cntpct();
-	uint32_t cntfrq = read_cntfrq();
+	uint32_t rem = 0;
 
-	time->seconds = cntpct / cntfrq;
-	time->millis = (cntpct % cntfrq) / (cntfrq / TEE_TIME_MILLIS_BASE);
+	time->seconds = reciprocal_divide(cntpct, &cntfrq_div, &rem);
+	time->millis = reciprocal_divide((uint64_t)rem * TEE_TIME_MILLIS_BASE,
+					 &cntfrq_div, NULL);
 
 	return TEE_SUCCESS;
 }
@@ -29,6 +39,7 @@ static const struct time_source arm_cntpct_time_source = {
 	.name = "arm cntpct",
 	.protection_level = 1000,
 	.get_sys_time = arm_cntpct_get_sys_time,
+	.init = arm_cntpct_init,
 };
 
 REGISTER_TIME_SOURCE(arm_cntpct_time_source)
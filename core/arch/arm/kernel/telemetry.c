@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <arm.h>
+#include <assert.h>
+#include <kernel/misc.h>
+#include <kernel/mutex.h>
+#include <kernel/telemetry.h>
+#include <kernel/thread.h>
+#include <malloc.h>
+#include <mm/mobj.h>
+#include <mm/tee_pager.h>
+#include <optee_msg.h>
+#include <string.h>
+#include <trace.h>
+#include <util.h>
+
+struct telemetry_core {
+	uint64_t enter_time;	/* 0 when not running a thread */
+	uint64_t busy_ticks;
+	uint64_t std_calls;
+	uint64_t count[TELEMETRY_NUM_COUNTERS];
+};
+
+static struct telemetry_core telemetry_cores[CFG_TEE_CORE_NB_CORE];
+
+/* Protects the fields below */
+static struct mutex telemetry_mu = MUTEX_INITIALIZER;
+static struct mobj *telemetry_mobj;
+static struct optee_msg_telemetry *telemetry_page;
+static uint64_t telemetry_last_update;
+
+#define TELEMETRY_PAGE_SIZE \
+	(sizeof(struct optee_msg_telemetry) + \
+	 CFG_TEE_CORE_NB_CORE * sizeof(struct optee_msg_telemetry_core))
+
+void telemetry_core_enter(bool new_call)
+{
+	struct telemetry_core *c = telemetry_cores + get_core_pos();
+
+	assert(thread_get_exceptions() & THREAD_EXCP_FOREIGN_INTR);
+
+	c->enter_time = read_cntpct();
+	if (new_call)
+		c->std_calls++;
+}
+
+void telemetry_core_exit(void)
+{
+	struct telemetry_core *c = telemetry_cores + get_core_pos();
+
+	assert(thread_get_exceptions() & THREAD_EXCP_FOREIGN_INTR);
+
+	if (c->enter_time)
+		c->busy_ticks += read_cntpct() - c->enter_time;
+	c->enter_time = 0;
+}
+
+void telemetry_count(enum telemetry_counter counter)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+
+	telemetry_cores[get_core_pos()].count[counter]++;
+
+	thread_unmask_exceptions(exceptions);
+}
+
+/*
+ * The counters of the other cores are read without synchronization,
+ * each one is written by a single core so at worst a value is slightly
+ * stale.
+ */
+static void fill_page(struct optee_msg_telemetry *t, uint64_t now)
+{
+	struct thread_alloc_stats thread_stats = { };
+	struct tee_pager_stats pager_stats = { };
+	size_t n = 0;
+
+	thread_get_alloc_stats(&thread_stats);
+	tee_pager_get_stats(&pager_stats);
+
+	t->num_cores = CFG_TEE_CORE_NB_CORE;
+	t->timestamp = now;
+	t->cntfrq = read_cntfrq();
+	t->num_threads = thread_stats.num_threads;
+	t->free_threads = thread_stats.free_threads;
+	t->thread_limit_count = thread_stats.limit_count;
+#ifdef CFG_WITH_STATS
+	{
+		struct malloc_stats heap_stats = { };
+
+		malloc_get_stats(&heap_stats);
+		t->heap_alloc_fails = heap_stats.num_alloc_fail;
+		t->heap_size = heap_stats.size;
+		t->heap_allocated = heap_stats.allocated;
+		t->heap_max_allocated = heap_stats.max_allocated;
+	}
+#endif
+	t->pager_npages = pager_stats.npages;
+	t->pager_loads = pager_stats.ro_hits + pager_stats.rw_hits;
+	t->pager_hidden_hits = pager_stats.hidden_hits;
+	t->rpc_count = 0;
+	t->storage_ops = 0;
+
+	for (n = 0; n < CFG_TEE_CORE_NB_CORE; n++) {
+		struct telemetry_core *c = telemetry_cores + n;
+
+		t->core[n].busy_ticks = c->busy_ticks;
+		t->core[n].std_calls = c->std_calls;
+		t->rpc_count += c->count[TELEMETRY_RPC];
+		t->storage_ops += c->count[TELEMETRY_STORAGE];
+	}
+}
+
+static void update_page(struct optee_msg_telemetry *t, uint64_t now)
+{
+	uint32_t seq = t->seq | 1;
+
+	/* Odd while updating, a reader retries if it sees an odd value */
+	__atomic_store_n(&t->seq, seq, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	fill_page(t, now);
+	__atomic_store_n(&t->seq, seq + 1, __ATOMIC_RELEASE);
+}
+
+void telemetry_update(void)
+{
+	uint64_t now = 0;
+
+	/* Another thread is updating or changing the page, skip this time */
+	if (!mutex_trylock(&telemetry_mu))
+		return;
+
+	if (telemetry_page) {
+		now = read_cntpct();
+		if ((now - telemetry_last_update) * 1000 >=
+		    (uint64_t)CFG_CORE_TELEMETRY_PERIOD_MS * read_cntfrq()) {
+			update_page(telemetry_page, now);
+			telemetry_last_update = now;
+		}
+	}
+
+	mutex_unlock(&telemetry_mu);
+}
+
+static void release_page(void)
+{
+	if (!telemetry_mobj)
+		return;
+
+	mobj_reg_shm_dec_map(telemetry_mobj);
+	mobj_reg_shm_put(telemetry_mobj);
+	telemetry_mobj = NULL;
+	telemetry_page = NULL;
+}
+
+TEE_Result telemetry_set_page(uint64_t cookie, size_t offs, size_t *size)
+{
+	struct mobj *mobj = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t end = 0;
+	void *va = NULL;
+
+	if (!cookie) {
+		mutex_lock(&telemetry_mu);
+		release_page();
+		mutex_unlock(&telemetry_mu);
+		return TEE_SUCCESS;
+	}
+
+	if (*size < TELEMETRY_PAGE_SIZE) {
+		*size = TELEMETRY_PAGE_SIZE;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	if (offs & (sizeof(uint64_t) - 1))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mobj = mobj_reg_shm_get_by_cookie(cookie);
+	if (!mobj)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (ADD_OVERFLOW(offs, TELEMETRY_PAGE_SIZE, &end) ||
+	    end > mobj->size) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto err_put;
+	}
+
+	res = mobj_reg_shm_inc_map(mobj);
+	if (res)
+		goto err_put;
+
+	/* Registered shared memory is mapped in one contiguous range */
+	va = mobj_get_va(mobj, offs);
+	if (!va) {
+		res = TEE_ERROR_GENERIC;
+		goto err_unmap;
+	}
+
+	memset(va, 0, TELEMETRY_PAGE_SIZE);
+
+	mutex_lock(&telemetry_mu);
+	release_page();
+	telemetry_mobj = mobj;
+	telemetry_page = va;
+	telemetry_last_update = read_cntpct();
+	update_page(telemetry_page, telemetry_last_update);
+	mutex_unlock(&telemetry_mu);
+
+	*size = TELEMETRY_PAGE_SIZE;
+	return TEE_SUCCESS;
+
+err_unmap:
+	mobj_reg_shm_dec_map(mobj);
+err_put:
+	mobj_reg_shm_put(mobj);
+	return res;
+}
@@ -8,6 +8,7 @@
 
 #include <arm.h>
 #include <assert.h>
+#include <atomic.h>
 #include <io.h>
 #include <keep.h>
 #include <kernel/asan.h>
@@ -16,6 +17,7 @@
 #include <kernel/panic.h>
 #include <kernel/spinlock.h>
 #include <kernel/tee_ta_manager.h>
+#include <kernel/telemetry.h>
 #include <kernel/thread_defs.h>
 #include <kernel/thread.h>
 #include <kernel/virtualization.h>
@@ -67,6 +69,28 @@
 
 struct thread_ctx threads[CFG_NUM_THREADS];
 
+/*
+ * Bitmap of free entries in threads[], a set bit means that the thread
+ * context is free. Threads are allocated and released with atomic
+ * operations on this bitmap only, so entering a new std SMC doesn't have
+ * to take the global thread lock.
+ */
+#define THREAD_FREE_MAP_WORDS	((CFG_NUM_THREADS + 31) / 32)
+static uint32_t thread_free_map[THREAD_FREE_MAP_WORDS];
+
+/*
+ * Index of the thread last released on each core, tried first when the
+ * core allocates a thread again.
+ */
+struct thread_alloc_hint {
+	size_t idx;
+} __cacheline_aligned;
+
+static struct thread_alloc_hint thread_alloc_hint[CFG_TEE_CORE_NB_CORE];
+
+/* Number of std SMCs rejected with OPTEE_SMC_RETURN_ETHREAD_LIMIT */
+static uint32_t thread_limit_count;
+
 struct thread_core_local thread_core_local[CFG_TEE_CORE_NB_CORE] __nex_bss;
 
 #ifdef CFG_WITH_STACK_CANARIES
@@ -99,10 +123,34 @@ linkage uint32_t name[num_stacks] \
 
 DECLARE_STACK(stack_tmp, CFG_TEE_CORE_NB_CORE, STACK_TMP_SIZE, static);
 DECLARE_STACK(stack_abt, CFG_TEE_CORE_NB_CORE, STACK_ABT_SIZE, static);
-#ifndef CFG_WITH_PAGER
-DECLARE_STACK(stack_thread, CFG_NUM_THREADS, STACK_THREAD_SIZE, static);
+/*
+ * Without the pager only the first CFG_NUM_THREADS_STATIC threads have a
+ * stack reserved, the stacks of the other threads are allocated from the
+ * heap when needed. With CFG_VIRTUALIZATION=y each guest has its own
+ * threads, so that's the heap of the guest. With the pager all threads
+ * have a stack reserved in virtual memory, physical pages are only used
+ * while a thread is busy.
+ */
+#ifdef CFG_WITH_PAGER
+#define NUM_STATIC_STACKS	CFG_NUM_THREADS
+#else
+#if CFG_NUM_THREADS_STATIC < 1 || CFG_NUM_THREADS_STATIC > CFG_NUM_THREADS
+#error CFG_NUM_THREADS_STATIC must be in the range [1, CFG_NUM_THREADS]
+#endif
+#define NUM_STATIC_STACKS	CFG_NUM_THREADS_STATIC
+DECLARE_STACK(stack_thread, CFG_NUM_THREADS_STATIC, STACK_THREAD_SIZE, static);
 #endif
 
+/* Number of threads with a stack allocated from the heap */
+static uint32_t thread_heap_stack_count;
+/*
+ * Started and ended claims of free threads that are taken out of the free
+ * bitmap without being run. While a claim is in progress a std SMC
+ * finding no free thread doesn't mean that all threads are busy.
+ */
+static uint32_t thread_claim_begin_count;
+static uint32_t thread_claim_end_count;
+
 const void *stack_tmp_export = (uint8_t *)stack_tmp + sizeof(stack_tmp[0]) -
 			       (STACK_TMP_OFFS + STACK_CANARY_SIZE / 2);
 const uint32_t stack_tmp_stride = sizeof(stack_tmp[0]);
@@ -140,7 +188,13 @@ static uint8_t thread_user_kdata_page[
 #endif
 #endif
 
-static unsigned int thread_global_lock __nex_bss = SPINLOCK_UNLOCK;
+/*
+ * Only protects the state of threads[]. With CFG_VIRTUALIZATION both live
+ * in the .bss of each guest partition, guests have separate thread pools
+ * and don't contend on this lock.
+ */
+/* Taken by all CPUs on each entry and exit, granted in arrival order */
+static struct cpu_ticket_lock thread_global_lock = CPU_TICKET_LOCK_INITIALIZER;
 
 static void init_canaries(void)
 {
@@ -202,14 +256,84 @@ void thread_check_canaries(void)
 #endif/*CFG_WITH_STACK_CANARIES*/
 }
 
+#ifdef CFG_THREAD_QUANTUM
+static void begin_slice(struct thread_ctx *thr)
+{
+	uint64_t now = read_cntpct();
+
+	if (!now)
+		now++; /* 0 is reserved */
+	thr->slice_start = now;
+	thr->run_start = now;
+}
+
+static void account_run_time(struct thread_ctx *thr)
+{
+	struct tee_ta_session *s = NULL;
+	uint64_t now = 0;
+
+	/* The boot thread isn't accounted */
+	if (!thr->slice_start)
+		return;
+
+	now = read_cntpct();
+	if (!tee_ta_get_current_session(&s))
+		s->run_ticks += now - thr->run_start;
+	thr->run_start = now;
+}
+
+static void end_slice(struct thread_ctx *thr)
+{
+	account_run_time(thr);
+	thr->slice_start = 0;
+}
+
+void thread_account_run_time(void)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+	struct thread_core_local *l = thread_get_core_local();
+
+	if (l->curr_thread >= 0)
+		account_run_time(threads + l->curr_thread);
+
+	thread_unmask_exceptions(exceptions);
+}
+
+bool thread_quantum_expired(void)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+	struct thread_core_local *l = thread_get_core_local();
+	uint64_t start = 0;
+
+	if (l->curr_thread >= 0)
+		start = threads[l->curr_thread].slice_start;
+
+	thread_unmask_exceptions(exceptions);
+
+	if (!start)
+		return false;
+
+	return (read_cntpct() - start) * 1000000 >=
+	       (uint64_t)CFG_THREAD_QUANTUM_US * read_cntfrq();
+}
+#else
+static void begin_slice(struct thread_ctx *thr __unused)
+{
+}
+
+static void end_slice(struct thread_ctx *thr __unused)
+{
+}
+#endif /*CFG_THREAD_QUANTUM*/
+
 void thread_lock_global(void)
 {
-	cpu_spin_lock(&thread_global_lock);
+	cpu_ticket_lock(&thread_global_lock);
 }
 
 void thread_unlock_global(void)
 {
-	cpu_spin_unlock(&thread_global_lock);
+	cpu_ticket_unlock(&thread_global_lock);
 }
 
 #ifdef ARM32
@@ -380,6 +504,193 @@ static void init_regs(struct thread_ctx *thread, uint32_t a0, uint32_t a1,
 }
 #endif /*ARM64*/
 
+static uint32_t free_map_word_mask(size_t w)
+{
+	if (w == THREAD_FREE_MAP_WORDS - 1 && (CFG_NUM_THREADS % 32))
+		return BIT32(CFG_NUM_THREADS % 32) - 1;
+	return UINT32_MAX;
+}
+
+static bool claim_free_thread(size_t n)
+{
+	uint32_t *w = thread_free_map + n / 32;
+	uint32_t bit = BIT32(n % 32);
+	uint32_t old = atomic_load_u32(w);
+
+	while (old & bit)
+		if (atomic_cas_u32(w, &old, old & ~bit))
+			return true;
+
+	return false;
+}
+
+static int alloc_free_thread(size_t hint)
+{
+	size_t n = 0;
+	size_t w = 0;
+	uint32_t old = 0;
+
+	if (claim_free_thread(hint))
+		return hint;
+
+	for (n = 0; n < THREAD_FREE_MAP_WORDS; n++) {
+		w = (hint / 32 + n) % THREAD_FREE_MAP_WORDS;
+		old = atomic_load_u32(thread_free_map + w);
+		while (old) {
+			uint32_t bit = __builtin_ctz(old);
+
+			if (atomic_cas_u32(thread_free_map + w, &old,
+					   old & ~BIT32(bit)))
+				return w * 32 + bit;
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * Threads briefly taken out of the free bitmap by
+ * thread_claim_all_free() or reclaim_thread_stacks() are still free, so
+ * the allocation is retried if a claim overlapped it. Normal world only
+ * gets OPTEE_SMC_RETURN_ETHREAD_LIMIT when all threads are busy.
+ */
+static int alloc_free_thread_wait_claims(size_t hint)
+{
+	uint32_t end = 0;
+	int n = 0;
+
+	while (true) {
+		end = atomic_load_u32(&thread_claim_end_count);
+		n = alloc_free_thread(hint);
+		if (n >= 0 ||
+		    atomic_load_u32(&thread_claim_begin_count) == end)
+			return n;
+	}
+}
+
+static void release_thread(size_t n)
+{
+	uint32_t old __maybe_unused = 0;
+
+	old = atomic_fetch_or_u32(thread_free_map + n / 32, BIT32(n % 32));
+	assert(!(old & BIT32(n % 32)));
+}
+
+/*
+ * Takes all thread contexts out of the free bitmap, succeeds only if all
+ * threads are free. While held std SMCs wait for a free thread instead of
+ * being allocated one, which gives the caller exclusive access to the
+ * state of all threads.
+ */
+bool thread_claim_all_free(void)
+{
+	uint32_t old = 0;
+	size_t n = 0;
+
+	atomic_inc32(&thread_claim_begin_count);
+	for (n = 0; n < THREAD_FREE_MAP_WORDS; n++) {
+		old = free_map_word_mask(n);
+		if (!atomic_cas_u32(thread_free_map + n, &old, 0)) {
+			while (n) {
+				n--;
+				atomic_fetch_or_u32(thread_free_map + n,
+						    free_map_word_mask(n));
+			}
+			atomic_inc32(&thread_claim_end_count);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void thread_release_all_free(void)
+{
+	size_t n = 0;
+
+	for (n = 0; n < THREAD_FREE_MAP_WORDS; n++)
+		atomic_fetch_or_u32(thread_free_map + n,
+				    free_map_word_mask(n));
+	atomic_inc32(&thread_claim_end_count);
+}
+
+static size_t num_free_threads(void)
+{
+	size_t count = 0;
+	size_t n = 0;
+
+	for (n = 0; n < THREAD_FREE_MAP_WORDS; n++)
+		count += __builtin_popcount(atomic_load_u32(thread_free_map + n));
+
+	return count;
+}
+
+static bool alloc_thread_stack(size_t n)
+{
+	uint8_t *buf = NULL;
+	vaddr_t stack = 0;
+
+	if (n < NUM_STATIC_STACKS || threads[n].stack_va_end)
+		return true;
+
+	/* Same alignment as the stacks from DECLARE_STACK() */
+	buf = malloc(STACK_THREAD_SIZE + STACK_ALIGNMENT - 1);
+	if (!buf)
+		return false;
+	stack = ROUNDUP((vaddr_t)buf, STACK_ALIGNMENT);
+	threads[n].stack_heap = buf;
+	threads[n].stack_va_end = stack + STACK_THREAD_SIZE;
+	atomic_inc32(&thread_heap_stack_count);
+
+	return true;
+}
+
+static void free_thread_stack(size_t n)
+{
+	free(threads[n].stack_heap);
+	threads[n].stack_heap = NULL;
+	threads[n].stack_va_end = 0;
+	atomic_dec32(&thread_heap_stack_count);
+}
+
+/*
+ * Frees the heap allocated stacks of the free threads and of the thread
+ * @ct being freed, once fewer than NUM_STATIC_STACKS threads are busy.
+ * Stacks are kept while a burst of calls lasts. Called on the temporary
+ * stack before @ct is released.
+ */
+static void reclaim_thread_stacks(size_t ct)
+{
+	size_t n = 0;
+
+	if (!atomic_load_u32(&thread_heap_stack_count) ||
+	    CFG_NUM_THREADS - num_free_threads() > NUM_STATIC_STACKS)
+		return;
+
+	if (ct >= NUM_STATIC_STACKS && threads[ct].stack_va_end)
+		free_thread_stack(ct);
+
+	for (n = NUM_STATIC_STACKS; n < CFG_NUM_THREADS; n++) {
+		if (n == ct || !READ_ONCE(threads[n].stack_va_end))
+			continue;
+		atomic_inc32(&thread_claim_begin_count);
+		if (claim_free_thread(n)) {
+			if (threads[n].stack_va_end)
+				free_thread_stack(n);
+			release_thread(n);
+		}
+		atomic_inc32(&thread_claim_end_count);
+	}
+}
+
+void thread_get_alloc_stats(struct thread_alloc_stats *stats)
+{
+	stats->num_threads = CFG_NUM_THREADS;
+	stats->free_threads = num_free_threads();
+	stats->limit_count = atomic_load_u32(&thread_limit_count);
+	stats->heap_stacks = atomic_load_u32(&thread_heap_stack_count);
+}
+
 void thread_init_boot_thread(void)
 {
 	struct thread_core_local *l = thread_get_core_local();
@@ -387,6 +698,8 @@ void thread_init_boot_thread(void)
 	thread_init_threads();
 
 	l->curr_thread = 0;
+	if (!claim_free_thread(0))
+		panic();
 	threads[0].state = THREAD_STATE_ACTIVE;
 }
 
@@ -397,36 +710,37 @@ void thread_clr_boot_thread(void)
 	assert(l->curr_thread >= 0 && l->curr_thread < CFG_NUM_THREADS);
 	assert(threads[l->curr_thread].state == THREAD_STATE_ACTIVE);
 	threads[l->curr_thread].state = THREAD_STATE_FREE;
+	release_thread(l->curr_thread);
 	l->curr_thread = -1;
 }
 
 void thread_alloc_and_run(uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
 {
-	size_t n;
 	struct thread_core_local *l = thread_get_core_local();
-	bool found_thread = false;
+	size_t pos = get_core_pos();
+	int n = 0;
 
 	assert(l->curr_thread == -1);
 
-	thread_lock_global();
-
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
-		if (threads[n].state == THREAD_STATE_FREE) {
-			threads[n].state = THREAD_STATE_ACTIVE;
-			found_thread = true;
-			break;
-		}
+	n = alloc_free_thread_wait_claims(thread_alloc_hint[pos].idx);
+	if (n >= 0 && !alloc_thread_stack(n)) {
+		release_thread(n);
+		n = -1;
 	}
-
-	thread_unlock_global();
-
-	if (!found_thread)
+	if (n < 0) {
+		atomic_inc32(&thread_limit_count);
 		return;
+	}
+
+	assert(threads[n].state == THREAD_STATE_FREE);
+	threads[n].state = THREAD_STATE_ACTIVE;
 
 	l->curr_thread = n;
 
 	threads[n].flags = 0;
 	init_regs(threads + n, a0, a1, a2, a3);
+	begin_slice(threads + n);
+	telemetry_core_enter(true);
 
 	thread_lazy_save_ns_vfp();
 	thread_resume(&threads[n].regs);
@@ -510,6 +824,8 @@ void thread_resume_from_rpc(uint32_t thread_id, uint32_t a0, uint32_t a1,
 		return;
 
 	l->curr_thread = n;
+	begin_slice(threads + n);
+	telemetry_core_enter(false);
 
 	if (threads[n].have_user_map) {
 		core_mmu_set_user_map(&threads[n].user_map);
@@ -612,17 +928,19 @@ void thread_state_free(void)
 		(void *)(threads[ct].stack_va_end - STACK_THREAD_SIZE),
 		STACK_THREAD_SIZE);
 
-	thread_lock_global();
-
+	end_slice(threads + ct);
+	telemetry_core_exit();
 	assert(threads[ct].state == THREAD_STATE_ACTIVE);
 	threads[ct].state = THREAD_STATE_FREE;
 	threads[ct].flags = 0;
 	l->curr_thread = -1;
+	thread_alloc_hint[get_core_pos()].idx = ct;
+	reclaim_thread_stacks(ct);
+	release_thread(ct);
 
 #ifdef CFG_VIRTUALIZATION
 	virt_unset_guest();
 #endif
-	thread_unlock_global();
 }
 
 #ifdef CFG_WITH_PAGER
@@ -670,6 +988,9 @@ int thread_state_suspend(uint32_t flags, uint32_t cpsr, vaddr_t pc)
 	}
 	thread_lazy_restore_ns_vfp();
 
+	end_slice(threads + ct);
+	telemetry_core_exit();
+
 	thread_lock_global();
 
 	assert(threads[ct].state == THREAD_STATE_ACTIVE);
@@ -688,12 +1009,13 @@ int thread_state_suspend(uint32_t flags, uint32_t cpsr, vaddr_t pc)
 
 	l->curr_thread = -1;
 
+	/* The lock is in the guest partition, release it before leaving */
+	thread_unlock_global();
+
 #ifdef CFG_VIRTUALIZATION
 	virt_unset_guest();
 #endif
 
-	thread_unlock_global();
-
 	return ct;
 }
 
@@ -759,6 +1081,12 @@ int thread_get_id(void)
 	return ct;
 }
 
+bool thread_is_active(int thread_id)
+{
+	assert(thread_id >= 0 && thread_id < CFG_NUM_THREADS);
+	return READ_ONCE(threads[thread_id].state) == THREAD_STATE_ACTIVE;
+}
+
 static void init_handlers(const struct thread_handlers *handlers)
 {
 	thread_cpu_on_handler_ptr = handlers->cpu_on;
@@ -812,8 +1140,8 @@ static void init_thread_stacks(void)
 {
 	size_t n;
 
-	/* Assign the thread stacks */
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
+	/* Assign the reserved thread stacks, the others are allocated later */
+	for (n = 0; n < NUM_STATIC_STACKS; n++) {
 		if (!thread_init_stack(n, GET_STACK(stack_thread[n])))
 			panic("thread_init_stack failed");
 	}
@@ -859,8 +1187,15 @@ void thread_init_threads(void)
 		SLIST_INIT(&threads[n].tsd.pgt_cache);
 	}
 
-	for (n = 0; n < CFG_TEE_CORE_NB_CORE; n++)
+	for (n = 0; n < THREAD_FREE_MAP_WORDS; n++)
+		thread_free_map[n] = free_map_word_mask(n);
+
+	/* Spread the cores over the threads to start with */
+	for (n = 0; n < CFG_TEE_CORE_NB_CORE; n++) {
 		thread_core_local[n].curr_thread = -1;
+		thread_alloc_hint[n].idx = (n * CFG_NUM_THREADS) /
+					   CFG_TEE_CORE_NB_CORE;
+	}
 }
 
 void thread_init_primary(const struct thread_handlers *handlers)
@@ -972,11 +1307,12 @@ void thread_init_per_cpu(void)
 
 	thread_init_vbar(get_excp_vect());
 
-#ifdef CFG_TA_FTRACE_SUPPORT
+#if defined(CFG_TA_FTRACE_SUPPORT) || defined(CFG_TA_FAST_SYSTEM_TIME)
 	/*
 	 * Enable accesses to frequency register and physical counter
 	 * register in EL0/PL0 required for timestamping during
-	 * function tracing.
+	 * function tracing and for reading the system time without a
+	 * syscall.
 	 */
 	write_cntkctl(read_cntkctl() | CNTKCTL_PL0PCTEN);
 #endif
@@ -1040,6 +1376,13 @@ uint32_t thread_kernel_enable_vfp(void)
 	struct thread_ctx *thr = threads + thread_get_id();
 	struct thread_user_vfp_state *tuv = thr->vfp_state.uvfp;
 
+	/* Already enabled by an outer call, nothing to save */
+	if (thr->vfp_state.kern_depth) {
+		assert(vfp_is_enabled());
+		thr->vfp_state.kern_depth++;
+		return exceptions;
+	}
+
 	assert(!vfp_is_enabled());
 
 	if (!thr->vfp_state.ns_saved) {
@@ -1064,17 +1407,21 @@ uint32_t thread_kernel_enable_vfp(void)
 		tuv->saved = true;
 	}
 
+	thr->vfp_state.kern_depth = 1;
 	vfp_enable();
 	return exceptions;
 }
 
 void thread_kernel_disable_vfp(uint32_t state)
 {
+	struct thread_ctx *thr = threads + thread_get_id();
 	uint32_t exceptions;
 
-	assert(vfp_is_enabled());
+	assert(vfp_is_enabled() && thr->vfp_state.kern_depth);
 
-	vfp_disable();
+	thr->vfp_state.kern_depth--;
+	if (!thr->vfp_state.kern_depth)
+		vfp_disable();
 	exceptions = thread_get_exceptions();
 	assert(exceptions & THREAD_EXCP_FOREIGN_INTR);
 	exceptions &= ~THREAD_EXCP_FOREIGN_INTR;
@@ -1090,6 +1437,9 @@ void thread_kernel_save_vfp(void)
 	if (vfp_is_enabled()) {
 		vfp_lazy_save_state_init(&thr->vfp_state.sec);
 		thr->vfp_state.sec_lazy_saved = true;
+		/* The abort handler starts with VFP disabled */
+		thr->vfp_state.sec_depth = thr->vfp_state.kern_depth;
+		thr->vfp_state.kern_depth = 0;
 	}
 }
 
@@ -1104,6 +1454,7 @@ void thread_kernel_restore_vfp(void)
 				       thr->vfp_state.sec_saved);
 		thr->vfp_state.sec_saved = false;
 		thr->vfp_state.sec_lazy_saved = false;
+		thr->vfp_state.kern_depth = thr->vfp_state.sec_depth;
 	}
 }
 
@@ -1203,6 +1554,7 @@ uint32_t thread_enter_user_mode(unsigned long a0, unsigned long a1,
 		uint32_t *exit_status0, uint32_t *exit_status1)
 {
 	uint32_t spsr;
+	uint32_t rc = 0;
 
 	tee_ta_update_session_utime_resume();
 
@@ -1211,8 +1563,12 @@ uint32_t thread_enter_user_mode(unsigned long a0, unsigned long a1,
 		*exit_status1 = 0xbadbadba;
 		return 0;
 	}
-	return __thread_enter_user_mode(a0, a1, a2, a3, user_sp, entry_func,
-					spsr, exit_status0, exit_status1);
+	rc = __thread_enter_user_mode(a0, a1, a2, a3, user_sp, entry_func,
+				      spsr, exit_status0, exit_status1);
+	/* Counting is still active if user mode was left with an abort */
+	tee_ta_pmu_stop();
+
+	return rc;
 }
 
 #ifdef CFG_CORE_UNMAP_CORE_AT_EL0
@@ -4,17 +4,24 @@
  */
 
 #include <assert.h>
+#include <atomic.h>
 #include <compiler.h>
 #include <io.h>
 #include <kernel/misc.h>
 #include <kernel/msg_param.h>
+#include <kernel/spinlock.h>
+#include <kernel/tee_ta_manager.h>
+#include <kernel/telemetry.h>
 #include <kernel/thread.h>
+#include <kernel/tracepoint.h>
 #include <kernel/virtualization.h>
+#include <kernel/work_queue.h>
 #include <mm/core_mmu.h>
 #include <optee_msg.h>
 #include <optee_rpc_cmd.h>
 #include <sm/optee_smc.h>
 #include <sm/sm.h>
+#include <stdlib.h>
 #include <string.h>
 #include <tee/entry_std.h>
 #include <tee/entry_fast.h>
@@ -25,6 +32,116 @@
 
 static bool thread_prealloc_rpc_cache;
 static unsigned int thread_rpc_pnum;
+static struct thread_rpc_cache_stats thread_rpc_cache_stats;
+
+
+#ifdef CFG_THREAD_RPC_STATS
+static unsigned int thread_rpc_stats_lock = SPINLOCK_UNLOCK;
+static struct thread_rpc_stats thread_rpc_stats;
+
+static void rpc_stats_add(struct thread_rpc_stats *stats, size_t idx,
+			  uint64_t us)
+{
+	struct thread_rpc_cmd_stats *cs = stats->cmd + idx;
+
+	cs->count++;
+	cs->time_us += us;
+	if (us > cs->max_us)
+		cs->max_us = MIN(us, (uint64_t)UINT32_MAX);
+}
+
+/*
+ * Does the RPC and accounts the time spent in normal world to @cmd, both
+ * globally and for the current session, if any.
+ */
+static void rpc_cmd(uint32_t cmd, uint32_t rpc_args[THREAD_RPC_NUM_ARGS])
+{
+	size_t idx = MIN(cmd, (uint32_t)THREAD_RPC_STATS_NUM_CMDS - 1);
+	struct thread_rpc_stats *sess_stats = NULL;
+	struct tee_ta_session *s = NULL;
+	uint32_t exceptions = 0;
+	uint64_t start = 0;
+	uint64_t us = 0;
+
+	start = read_cntpct();
+	thread_rpc(rpc_args);
+	us = ((read_cntpct() - start) * 1000000) / read_cntfrq();
+
+	if (!tee_ta_get_current_session(&s)) {
+		sess_stats = s->rpc_stats;
+		if (!sess_stats)
+			sess_stats = calloc(1, sizeof(*sess_stats));
+	}
+
+	exceptions = cpu_spin_lock_xsave(&thread_rpc_stats_lock);
+	rpc_stats_add(&thread_rpc_stats, idx, us);
+	if (sess_stats) {
+		s->rpc_stats = sess_stats;
+		rpc_stats_add(sess_stats, idx, us);
+	}
+	cpu_spin_unlock_xrestore(&thread_rpc_stats_lock, exceptions);
+}
+
+TEE_Result thread_get_rpc_stats(uint32_t session_id,
+				struct thread_rpc_stats *stats, bool reset)
+{
+	struct tee_ta_session_head *open_sessions = NULL;
+	struct thread_rpc_stats *src = &thread_rpc_stats;
+	struct tee_ta_session *s = NULL;
+	uint32_t exceptions = 0;
+
+	if (session_id) {
+		nsec_sessions_list_head(&open_sessions);
+		s = tee_ta_get_session(session_id, false, open_sessions);
+		if (!s)
+			return TEE_ERROR_ITEM_NOT_FOUND;
+	}
+
+	exceptions = cpu_spin_lock_xsave(&thread_rpc_stats_lock);
+	if (s)
+		src = s->rpc_stats;
+	if (src) {
+		*stats = *src;
+		if (reset)
+			memset(src, 0, sizeof(*src));
+	} else {
+		memset(stats, 0, sizeof(*stats));
+	}
+	cpu_spin_unlock_xrestore(&thread_rpc_stats_lock, exceptions);
+
+	if (s)
+		tee_ta_put_session(s);
+
+	return TEE_SUCCESS;
+}
+#else
+static void rpc_cmd(uint32_t cmd __unused,
+		    uint32_t rpc_args[THREAD_RPC_NUM_ARGS])
+{
+	thread_rpc(rpc_args);
+}
+#endif /*CFG_THREAD_RPC_STATS*/
+
+#ifdef CFG_THREAD_QUANTUM
+void thread_yield(void)
+{
+	uint32_t rpc_args[THREAD_RPC_NUM_ARGS] = {
+		OPTEE_SMC_RETURN_RPC_FOREIGN_INTR
+	};
+
+	if (thread_get_id_may_fail() < 0 ||
+	    (thread_get_exceptions() & THREAD_EXCP_FOREIGN_INTR))
+		return;
+
+	/*
+	 * Normal world handles this as a foreign interrupt which has
+	 * already been served and resumes the thread when it's scheduled
+	 * again.
+	 */
+	if (thread_quantum_expired())
+		thread_rpc(rpc_args);
+}
+#endif
 
 void thread_handle_fast_smc(struct thread_smc_args *args)
 {
@@ -215,6 +332,9 @@ uint32_t __weak __thread_std_smc_entry(uint32_t a0, uint32_t a1, uint32_t a2,
 	if (rv == OPTEE_SMC_RETURN_OK) {
 		struct thread_ctx *thr = threads + thread_get_id();
 
+		/* Done before the RPC caches below are released */
+		work_run_on_std_exit();
+
 		tee_fs_rpc_cache_clear(&thr->tsd);
 		if (!thread_prealloc_rpc_cache) {
 			thread_rpc_free_arg(mobj_get_cookie(thr->rpc_mobj));
@@ -235,11 +355,9 @@ bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
 
 	thread_lock_global();
 
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
-		if (threads[n].state != THREAD_STATE_FREE) {
-			rv = false;
-			goto out;
-		}
+	if (!thread_claim_all_free()) {
+		rv = false;
+		goto out;
 	}
 
 	rv = true;
@@ -248,12 +366,14 @@ bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
 			*cookie = mobj_get_cookie(threads[n].rpc_mobj);
 			mobj_free(threads[n].rpc_mobj);
 			threads[n].rpc_arg = NULL;
-			goto out;
+			goto out_release;
 		}
 	}
 
 	*cookie = 0;
 	thread_prealloc_rpc_cache = false;
+out_release:
+	thread_release_all_free();
 out:
 	thread_unlock_global();
 	thread_unmask_exceptions(exceptions);
@@ -263,20 +383,18 @@ out:
 bool thread_enable_prealloc_rpc_cache(void)
 {
 	bool rv;
-	size_t n;
 	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
 
 	thread_lock_global();
 
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
-		if (threads[n].state != THREAD_STATE_FREE) {
-			rv = false;
-			goto out;
-		}
+	if (!thread_claim_all_free()) {
+		rv = false;
+		goto out;
 	}
 
 	rv = true;
 	thread_prealloc_rpc_cache = true;
+	thread_release_all_free();
 out:
 	thread_unlock_global();
 	thread_unmask_exceptions(exceptions);
@@ -299,6 +417,7 @@ static struct mobj *thread_rpc_alloc_arg(size_t size)
 	};
 	struct mobj *mobj = NULL;
 
+	atomic_inc32(&thread_rpc_cache_stats.arg_allocs);
 	thread_rpc(rpc_args);
 
 	/* Registers 1 and 2 passed from normal world */
@@ -481,13 +600,16 @@ uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 	/* The source CRYPTO_RNG_SRC_JITTER_RPC is safe to use here */
 	plat_prng_add_jitter_entropy(CRYPTO_RNG_SRC_JITTER_RPC,
 				     &thread_rpc_pnum);
+	telemetry_count(TELEMETRY_RPC);
 
 	ret = get_rpc_arg(cmd, num_params, params, &arg, &carg);
 	if (ret)
 		return ret;
 
 	reg_pair_from_64(carg, rpc_args + 1, rpc_args + 2);
-	thread_rpc(rpc_args);
+	TRACEPOINT(PTA_TRACE_CAT_RPC, "rpc_out", cmd, num_params);
+	rpc_cmd(cmd, rpc_args);
+	TRACEPOINT(PTA_TRACE_CAT_RPC, "rpc_in", cmd, 0);
 
 	return get_rpc_arg_res(arg, num_params, params);
 }
@@ -514,7 +636,7 @@ static void thread_rpc_free(unsigned int bt, uint64_t cookie, struct mobj *mobj)
 
 	if (!ret) {
 		reg_pair_from_64(carg, rpc_args + 1, rpc_args + 2);
-		thread_rpc(rpc_args);
+		rpc_cmd(OPTEE_RPC_CMD_SHM_FREE, rpc_args);
 	}
 }
 
@@ -538,7 +660,8 @@ static struct mobj *get_rpc_alloc_res(struct optee_msg_arg *arg,
 		size_t sz = arg->params[0].u.tmem.size;
 
 		cookie = arg->params[0].u.tmem.shm_ref;
-		mobj = msg_param_mobj_from_noncontig(p, sz, cookie, true);
+		mobj = msg_param_mobj_from_noncontig(p, sz, cookie, true,
+						     TEE_MATTR_CACHE_CACHED);
 	} else {
 		return NULL;
 	}
@@ -575,11 +698,16 @@ static struct mobj *thread_rpc_alloc(size_t size, size_t align, unsigned int bt)
 		return NULL;
 
 	reg_pair_from_64(carg, rpc_args + 1, rpc_args + 2);
-	thread_rpc(rpc_args);
+	rpc_cmd(OPTEE_RPC_CMD_SHM_ALLOC, rpc_args);
 
 	return get_rpc_alloc_res(arg, bt);
 }
 
+void thread_get_rpc_cache_stats(struct thread_rpc_cache_stats *stats)
+{
+	stats->arg_allocs = atomic_load_u32(&thread_rpc_cache_stats.arg_allocs);
+}
+
 struct mobj *thread_rpc_alloc_payload(size_t size)
 {
 	return thread_rpc_alloc(size, 8, OPTEE_RPC_SHM_TYPE_APPL);
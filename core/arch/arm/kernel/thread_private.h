@@ -68,6 +68,8 @@ struct thread_vfp_state {
 	bool ns_saved;
 	bool sec_saved;
 	bool sec_lazy_saved;
+	unsigned int kern_depth;	/* Nesting of thread_kernel_enable_vfp() */
+	unsigned int sec_depth;		/* kern_depth when sec was saved */
 	struct vfp_state ns;
 	struct vfp_state sec;
 	struct thread_user_vfp_state *uvfp;
@@ -79,6 +81,7 @@ struct thread_ctx {
 	struct thread_ctx_regs regs;
 	enum thread_state state;
 	vaddr_t stack_va_end;
+	void *stack_heap;	/* Heap buffer holding the stack, if any */
 	uint32_t flags;
 	struct core_mmu_user_map user_map;
 	bool have_user_map;
@@ -91,7 +94,11 @@ struct thread_ctx {
 	void *rpc_arg;
 	struct mobj *rpc_mobj;
 	struct thread_specific_data tsd;
-};
+#ifdef CFG_THREAD_QUANTUM
+	uint64_t slice_start;	/* Entry in secure world, 0 if not running */
+	uint64_t run_start;	/* Start of the run time not yet accounted */
+#endif
+} __cacheline_aligned;
 #endif /*__ASSEMBLER__*/
 
 #ifdef ARM64
@@ -218,6 +225,17 @@ void thread_resume_from_rpc(uint32_t thread_id, uint32_t a0, uint32_t a1,
 void thread_lock_global(void);
 void thread_unlock_global(void);
 
+/*
+ * Takes all threads out of the free list if all of them are free,
+ * returns false if at least one thread is in use. Must be matched by a
+ * call to thread_release_all_free() on success. Fast calls that fail to
+ * claim all threads return OPTEE_SMC_RETURN_EBUSY as before, std SMCs
+ * arriving while the threads are claimed wait for them to be released
+ * instead of returning OPTEE_SMC_RETURN_ETHREAD_LIMIT.
+ */
+bool thread_claim_all_free(void);
+void thread_release_all_free(void);
+
 
 /*
  * Suspends current thread and temorarily exits to non-secure world.
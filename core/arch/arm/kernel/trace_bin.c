@@ -0,0 +1,335 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <arm.h>
+#include <keep.h>
+#include <kernel/misc.h>
+#include <kernel/thread.h>
+#include <kernel/trace_bin.h>
+#include <pta_trace.h>
+#include <stdarg.h>
+#include <string.h>
+#include <tee_api_types.h>
+#include <trace.h>
+#include <types_ext.h>
+#include <unistd.h>
+#include <util.h>
+
+/*
+ * Each CPU only adds records to its own ring, with exceptions masked, so
+ * the rings have a single producer. trace_bin_read() is the single
+ * consumer, the head and tail indexes are the only synchronization.
+ */
+
+#define RING_SIZE	CFG_CORE_BINARY_TRACE_SIZE
+#define REC_MAX_SIZE	MAX_PRINT_SIZE
+/* Longest string argument logged, longer strings are truncated */
+#define STR_MAX_LEN	64
+
+#if !IS_POWER_OF_TWO(RING_SIZE) || RING_SIZE < REC_MAX_SIZE
+#error CFG_CORE_BINARY_TRACE_SIZE must be a power of two >= MAX_PRINT_SIZE
+#endif
+
+struct bin_ring {
+	uint32_t head;
+	uint32_t tail;
+	uint32_t dropped;
+	uint8_t buf[RING_SIZE];
+};
+
+struct rec_buf {
+	size_t len;
+	bool full;
+	uint8_t data[REC_MAX_SIZE] __aligned(8);
+};
+
+/* Flags of the integer conversions, as in snprintk() */
+#define SHORTINT	BIT(0)
+#define LONGINT		BIT(1)
+#define QUADINT		BIT(2)
+#define MAXINT		BIT(3)
+#define PTRINT		BIT(4)
+#define SIZEINT		BIT(5)
+
+static struct bin_ring bin_rings[CFG_TEE_CORE_NB_CORE];
+
+static void put(struct rec_buf *b, const void *data, size_t len)
+{
+	if (b->full || len > sizeof(b->data) - b->len) {
+		/* The decoder stops at the first missing argument */
+		b->full = true;
+		return;
+	}
+
+	memcpy(b->data + b->len, data, len);
+	b->len += len;
+}
+
+static void put_u64(struct rec_buf *b, uint64_t v)
+{
+	put(b, &v, sizeof(v));
+}
+
+static void put_str(struct rec_buf *b, const char *str, int prec)
+{
+	uint16_t len = 0;
+
+	if (!str)
+		str = "(null)";
+	if (prec >= 0)
+		len = strnlen(str, MIN(prec, STR_MAX_LEN));
+	else
+		len = strnlen(str, STR_MAX_LEN);
+
+	put(b, &len, sizeof(len));
+	put(b, str, len);
+}
+
+static int64_t get_sarg(va_list *ap, unsigned int flags)
+{
+	if (flags & MAXINT)
+		return va_arg(*ap, intmax_t);
+	if (flags & PTRINT)
+		return va_arg(*ap, intptr_t);
+	if (flags & SIZEINT)
+		return va_arg(*ap, ssize_t);
+	if (flags & QUADINT)
+		return va_arg(*ap, int64_t);
+	if (flags & LONGINT)
+		return va_arg(*ap, long);
+	if (flags & SHORTINT)
+		return (short)va_arg(*ap, int);
+	return va_arg(*ap, int);
+}
+
+static uint64_t get_uarg(va_list *ap, unsigned int flags)
+{
+	if (flags & MAXINT)
+		return va_arg(*ap, uintmax_t);
+	if (flags & PTRINT)
+		return va_arg(*ap, uintptr_t);
+	if (flags & SIZEINT)
+		return va_arg(*ap, size_t);
+	if (flags & QUADINT)
+		return va_arg(*ap, uint64_t);
+	if (flags & LONGINT)
+		return va_arg(*ap, unsigned long);
+	if (flags & SHORTINT)
+		return (unsigned short)va_arg(*ap, int);
+	return va_arg(*ap, unsigned int);
+}
+
+/*
+ * Adds the arguments to the record in the order of the conversions in
+ * @fmt. Only the conversions are parsed, flags and widths are left to
+ * the decoder.
+ */
+static void put_args(struct rec_buf *b, const char *fmt, va_list *ap)
+{
+	unsigned int flags = 0;
+	int prec = 0;
+
+	while (*fmt) {
+		if (*fmt++ != '%')
+			continue;
+
+		flags = 0;
+		prec = -1;
+next:
+		switch (*fmt++) {
+		case ' ':
+		case '#':
+		case '-':
+		case '+':
+		case '0':
+		case '1': case '2': case '3': case '4':
+		case '5': case '6': case '7': case '8': case '9':
+			goto next;
+		case '*':
+			put_u64(b, va_arg(*ap, int));
+			goto next;
+		case '.':
+			if (*fmt == '*') {
+				fmt++;
+				prec = va_arg(*ap, int);
+				put_u64(b, prec);
+			} else {
+				for (prec = 0; *fmt >= '0' && *fmt <= '9'; fmt++)
+					prec = prec * 10 + *fmt - '0';
+			}
+			goto next;
+		case 'h':
+			flags |= SHORTINT;
+			goto next;
+		case 'j':
+			flags |= MAXINT;
+			goto next;
+		case 'l':
+			if (*fmt == 'l') {
+				fmt++;
+				flags |= QUADINT;
+			} else {
+				flags |= LONGINT;
+			}
+			goto next;
+		case 'q':
+			flags |= QUADINT;
+			goto next;
+		case 't':
+			flags |= PTRINT;
+			goto next;
+		case 'z':
+			flags |= SIZEINT;
+			goto next;
+		case 'c':
+			put_u64(b, va_arg(*ap, int));
+			break;
+		case 'D':
+			flags |= LONGINT;
+			/*FALLTHROUGH*/
+		case 'd':
+		case 'i':
+			put_u64(b, get_sarg(ap, flags));
+			break;
+		case 'O':
+		case 'U':
+			flags |= LONGINT;
+			/*FALLTHROUGH*/
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+			put_u64(b, get_uarg(ap, flags));
+			break;
+		case 'p':
+			if (fmt[0] == 'U' && fmt[1] == 'l') {
+				fmt += 2;
+				put(b, va_arg(*ap, void *), sizeof(TEE_UUID));
+			} else {
+				put_u64(b, (vaddr_t)va_arg(*ap, void *));
+			}
+			break;
+		case 's':
+			put_str(b, va_arg(*ap, const char *), prec);
+			break;
+		case '%':
+			break;
+		default:
+			/* %n or end of string, nothing more can be decoded */
+			return;
+		}
+	}
+}
+
+static void ring_put(const void *rec, size_t len)
+{
+	struct bin_ring *r = bin_rings + get_core_pos();
+	const uint8_t *p = rec;
+	uint32_t head = r->head;
+	uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+	size_t n = 0;
+
+	if (len > RING_SIZE - (head - tail)) {
+		r->dropped++;
+		return;
+	}
+
+	for (n = 0; n < len; n++)
+		r->buf[(head + n) & (RING_SIZE - 1)] = p[n];
+	__atomic_store_n(&r->head, head + len, __ATOMIC_RELEASE);
+}
+
+void trace_bin_printf(const char *func, int line, int level,
+		      const char *fmt, ...)
+{
+	struct pta_trace_log_rec *hdr = NULL;
+	struct rec_buf b = { };
+	uint32_t exceptions = 0;
+	int thread_id = 0;
+	va_list ap;
+
+	if (level > trace_level)
+		return;
+
+	thread_id = trace_ext_get_thread_id();
+	hdr = (struct pta_trace_log_rec *)b.data;
+	*hdr = (struct pta_trace_log_rec){
+		.level = level,
+		.thread = thread_id < 0 ? UINT8_MAX : thread_id,
+		.line = line,
+		.fmt = (vaddr_t)fmt,
+		.func = (vaddr_t)func,
+	};
+	b.len = sizeof(*hdr);
+
+	va_start(ap, fmt);
+	put_args(&b, fmt, &ap);
+	va_end(ap);
+
+	/* Keeps the next record 8 bytes aligned in the output */
+	hdr->len = ROUNDUP(b.len, 8);
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	hdr->stamp = read_cntpct();
+	ring_put(hdr, hdr->len);
+	thread_unmask_exceptions(exceptions);
+}
+KEEP_PAGER(trace_bin_printf);
+
+static size_t read_ring(struct bin_ring *r, uint8_t *buf, size_t len)
+{
+	uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+	uint32_t tail = r->tail;
+	uint16_t rec_len = 0;
+	size_t offs = 0;
+	size_t n = 0;
+
+	while (tail != head) {
+		rec_len = r->buf[tail & (RING_SIZE - 1)] |
+			  r->buf[(tail + 1) & (RING_SIZE - 1)] << 8;
+		if (rec_len > len - offs)
+			break;
+		for (n = 0; n < rec_len; n++)
+			buf[offs + n] = r->buf[(tail + n) & (RING_SIZE - 1)];
+		offs += rec_len;
+		tail += rec_len;
+	}
+	__atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+
+	return offs;
+}
+
+TEE_Result trace_bin_read(void *buf, size_t *len)
+{
+	struct pta_trace_log_hdr hdr = { };
+	uint8_t *p = buf;
+	size_t offs = 0;
+	size_t n = 0;
+
+	if (*len < CFG_TEE_CORE_NB_CORE * sizeof(hdr)) {
+		*len = CFG_TEE_CORE_NB_CORE * sizeof(hdr);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	for (n = 0; n < CFG_TEE_CORE_NB_CORE; n++) {
+		/* Leaves room for the headers of the remaining CPUs */
+		size_t avail = *len - offs -
+			       (CFG_TEE_CORE_NB_CORE - n) * sizeof(hdr);
+
+		hdr = (struct pta_trace_log_hdr){
+			.cpu = n,
+			.len = read_ring(bin_rings + n, p + offs + sizeof(hdr),
+					 avail),
+			.dropped = __atomic_load_n(&bin_rings[n].dropped,
+						   __ATOMIC_RELAXED),
+			.cntfrq = read_cntfrq(),
+		};
+		memcpy(p + offs, &hdr, sizeof(hdr));
+		offs += sizeof(hdr) + hdr.len;
+	}
+	*len = offs;
+
+	return TEE_SUCCESS;
+}
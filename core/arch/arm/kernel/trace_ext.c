@@ -2,23 +2,31 @@
 /*
  * Copyright (c) 2014, Linaro Limited
  */
+#include <inttypes.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
 #include <trace.h>
 #include <console.h>
+#include <initcall.h>
+#include <kernel/async_log.h>
+#include <kernel/misc.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
+#include <kernel/work_queue.h>
 #include <mm/core_mmu.h>
+#include <util.h>
 
 const char trace_ext_prefix[] = "TC";
 int trace_level __nex_data = TRACE_LEVEL;
 static unsigned int puts_lock __nex_bss = SPINLOCK_UNLOCK;
 
-void trace_ext_puts(const char *str)
+static void console_write(const char *str, size_t len)
 {
 	uint32_t itr_status = thread_mask_exceptions(THREAD_EXCP_ALL);
 	bool mmu_enabled = cpu_mmu_enabled();
 	bool was_contended = false;
-	const char *p;
+	size_t n = 0;
 
 	if (mmu_enabled && !cpu_spin_trylock(&puts_lock)) {
 		was_contended = true;
@@ -30,8 +38,8 @@ void trace_ext_puts(const char *str)
 	if (was_contended)
 		console_putc('*');
 
-	for (p = str; *p; p++)
-		console_putc(*p);
+	for (n = 0; n < len; n++)
+		console_putc(str[n]);
 
 	console_flush();
 
@@ -41,6 +49,160 @@ void trace_ext_puts(const char *str)
 	thread_unmask_exceptions(itr_status);
 }
 
+#ifdef CFG_CORE_ASYNC_LOG
+/*
+ * Each CPU only adds messages to its own ring, with exceptions masked, so
+ * the rings have a single producer. The drain work is the single
+ * consumer, the head and tail indexes are the only synchronization.
+ * Messages from different CPUs may be reordered on the console.
+ */
+
+#define RING_SIZE	CFG_CORE_ASYNC_LOG_SIZE
+/* Largest chunk written to the console with exceptions masked */
+#define DRAIN_CHUNK	64
+
+struct log_ring {
+	uint32_t head;
+	uint32_t tail;
+	uint32_t dropped;
+	uint32_t dropped_reported;
+	bool busy;
+	char buf[RING_SIZE];
+};
+
+static struct log_ring log_rings[CFG_TEE_CORE_NB_CORE];
+static bool log_async;
+static bool log_draining;
+
+static void drain_work_func(struct work *work);
+static struct work drain_work = WORK_INITIALIZER(drain_work_func);
+
+static bool async_log_puts(const char *str)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	struct log_ring *r = log_rings + get_core_pos();
+	size_t len = strlen(str);
+	bool ret = false;
+	uint32_t head = 0;
+	uint32_t tail = 0;
+	size_t n = 0;
+
+	/* Messages logged while queueing one, by work_queue() for instance */
+	if (!__atomic_load_n(&log_async, __ATOMIC_ACQUIRE) || r->busy)
+		goto out;
+	r->busy = true;
+
+	head = r->head;
+	tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+	if (len > RING_SIZE - (head - tail)) {
+		r->dropped++;
+	} else {
+		for (n = 0; n < len; n++)
+			r->buf[(head + n) % RING_SIZE] = str[n];
+		__atomic_store_n(&r->head, head + len, __ATOMIC_RELEASE);
+	}
+	work_queue(&drain_work);
+
+	r->busy = false;
+	ret = true;
+out:
+	thread_unmask_exceptions(exceptions);
+	return ret;
+}
+
+static void drain_ring(struct log_ring *r)
+{
+	char buf[DRAIN_CHUNK] = { };
+	uint32_t dropped = __atomic_load_n(&r->dropped, __ATOMIC_RELAXED);
+	uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+	uint32_t tail = r->tail;
+	size_t len = 0;
+	size_t n = 0;
+
+	while (tail != head) {
+		len = MIN(head - tail, (uint32_t)sizeof(buf));
+		for (n = 0; n < len; n++)
+			buf[n] = r->buf[(tail + n) % RING_SIZE];
+		tail += len;
+		__atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+		console_write(buf, len);
+	}
+
+	if (dropped != r->dropped_reported) {
+		len = snprintf(buf, sizeof(buf),
+			       "*** %"PRIu32" log messages dropped\n",
+			       dropped - r->dropped_reported);
+		console_write(buf, MIN(len, sizeof(buf) - 1));
+		r->dropped_reported = dropped;
+	}
+}
+
+static void drain_rings(void)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(log_rings); n++)
+		drain_ring(log_rings + n);
+}
+
+static bool rings_pending(void)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(log_rings); n++)
+		if (__atomic_load_n(&log_rings[n].head, __ATOMIC_ACQUIRE) !=
+		    log_rings[n].tail ||
+		    log_rings[n].dropped != log_rings[n].dropped_reported)
+			return true;
+
+	return false;
+}
+
+static void drain_work_func(struct work *work __unused)
+{
+	do {
+		/* Another thread is draining, it picks up new messages */
+		if (__atomic_exchange_n(&log_draining, true, __ATOMIC_ACQUIRE))
+			return;
+
+		drain_rings();
+
+		__atomic_store_n(&log_draining, false, __ATOMIC_RELEASE);
+		/* Messages queued while another run of the work returned */
+	} while (rings_pending());
+}
+
+void async_log_sync(void)
+{
+	__atomic_store_n(&log_async, false, __ATOMIC_RELEASE);
+	/* A drain in progress may never complete, @log_draining is ignored */
+	drain_rings();
+}
+
+static TEE_Result async_log_init(void)
+{
+	/*
+	 * Until boot is completed there's no thread to drain the rings, a
+	 * hang during boot must not hide the messages leading to it.
+	 */
+	__atomic_store_n(&log_async, true, __ATOMIC_RELEASE);
+
+	return TEE_SUCCESS;
+}
+driver_init_late(async_log_init);
+#else
+static bool async_log_puts(const char *str __unused)
+{
+	return false;
+}
+#endif /*CFG_CORE_ASYNC_LOG*/
+
+void trace_ext_puts(const char *str)
+{
+	if (!async_log_puts(str))
+		console_write(str, strlen(str));
+}
+
 int trace_ext_get_thread_id(void)
 {
 	return thread_get_id_may_fail();
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <arm.h>
+#include <assert.h>
+#include <keep.h>
+#include <kernel/misc.h>
+#include <kernel/thread.h>
+#include <kernel/tracepoint.h>
+#include <string.h>
+#include <util.h>
+
+uint32_t tracepoint_categories;
+
+static struct pta_trace_buf *trace_buf;
+static size_t trace_ring_size;
+
+static struct pta_trace_ring *get_ring(size_t cpu)
+{
+	uint8_t *rings = (uint8_t *)(trace_buf + 1);
+
+	return (struct pta_trace_ring *)(rings + cpu * trace_ring_size);
+}
+
+/*
+ * Called with the tracepoint defined in the calling function. The
+ * tracepoint itself isn't accessed since it may be paged out, this
+ * function is also called from the pager.
+ */
+void tracepoint_log(const struct tracepoint *tp, uint64_t arg0, uint64_t arg1)
+{
+	const struct tracepoint *first = SCATTERED_ARRAY_BEGIN(tracepoints,
+							       struct tracepoint);
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	struct pta_trace_ring *ring = NULL;
+	struct pta_trace_rec *rec = NULL;
+	int thread_id = 0;
+
+	if (!trace_buf)
+		goto out;
+
+	thread_id = thread_get_id_may_fail();
+	ring = get_ring(get_core_pos());
+	rec = ring->recs + (ring->head & (trace_buf->num_recs - 1));
+	*rec = (struct pta_trace_rec){
+		.stamp = read_cntpct(),
+		.id = tp - first,
+		.thread = thread_id < 0 ? UINT16_MAX : thread_id,
+		.arg0 = arg0,
+		.arg1 = arg1,
+	};
+	/* Make the record visible before it's included by the head */
+	dsb_ishst();
+	ring->head++;
+out:
+	thread_unmask_exceptions(exceptions);
+}
+KEEP_PAGER(tracepoint_log);
+
+size_t tracepoint_get_buf_size(size_t num_recs)
+{
+	return sizeof(struct pta_trace_buf) +
+	       CFG_TEE_CORE_NB_CORE * (sizeof(struct pta_trace_ring) +
+				       num_recs * sizeof(struct pta_trace_rec));
+}
+
+void tracepoint_set_buf(void *buf, size_t num_recs)
+{
+	struct pta_trace_buf *tb = buf;
+
+	assert(!trace_buf && IS_POWER_OF_TWO(num_recs));
+
+	memset(tb, 0, tracepoint_get_buf_size(num_recs));
+	tb->num_cpus = CFG_TEE_CORE_NB_CORE;
+	tb->num_recs = num_recs;
+	tb->cntfrq = read_cntfrq();
+
+	trace_ring_size = sizeof(struct pta_trace_ring) +
+			  num_recs * sizeof(struct pta_trace_rec);
+	/* Publish the buffer only once it's initialized */
+	dsb_ishst();
+	trace_buf = tb;
+}
@@ -9,12 +9,15 @@
 #include <crypto/crypto.h>
 #include <ctype.h>
 #include <elf_common.h>
+#include <inttypes.h>
 #include <initcall.h>
+#include <io.h>
 #include <keep.h>
 #include <kernel/panic.h>
 #include <kernel/tee_misc.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread.h>
+#include <kernel/tracepoint.h>
 #include <kernel/user_ta.h>
 #include <kernel/user_ta_store.h>
 #include <ldelf.h>
@@ -30,8 +33,10 @@
 #include <optee_rpc_cmd.h>
 #include <printk.h>
 #include <signed_hdr.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/queue.h>
 #include <ta_pub_key.h>
 #include <tee/tee_cryp_utl.h>
@@ -146,12 +151,15 @@ static TEE_Result user_ta_enter(TEE_ErrorOrigin *err,
 	usr_params = (struct utee_params *)usr_stack;
 	init_utee_param(usr_params, param, param_va);
 
+	TRACEPOINT(PTA_TRACE_CAT_TA, "ta_enter", func, cmd);
 	res = thread_enter_user_mode(func, tee_svc_kaddr_to_uref(session),
 				     (vaddr_t)usr_params, cmd, usr_stack,
 				     utc->entry_func, utc->is_32bit,
 				     &utc->ctx.panicked, &utc->ctx.panic_code);
+	TRACEPOINT(PTA_TRACE_CAT_TA, "ta_exit", func, res);
 
 	clear_vfp_state(utc);
+	user_ta_ftrace_drain(session, true);
 	/*
 	 * According to GP spec the origin should allways be set to the
 	 * TA after TA execution
@@ -249,6 +257,16 @@ static TEE_Result init_with_ldelf(struct tee_ta_session *sess,
 	utc->entry_func = arg->entry_func;
 	utc->stack_ptr = arg->stack_ptr;
 	utc->ctx.flags = arg->flags;
+	if (utc->ctx.flags & TA_FLAG_CONCURRENT) {
+		/*
+		 * A user TA has a single stack and libutee isn't thread
+		 * safe, entering it concurrently would corrupt its state.
+		 * Multi-instance TAs get one context per session to run
+		 * on several cores.
+		 */
+		DMSG("Ignoring TA_FLAG_CONCURRENT of user TA");
+		utc->ctx.flags &= ~TA_FLAG_CONCURRENT;
+	}
 	utc->dump_entry_func = arg->dump_entry;
 #ifdef CFG_TA_FTRACE_SUPPORT
 	utc->ftrace_entry_func = arg->ftrace_entry;
@@ -455,6 +473,224 @@ static void user_ta_dump_state(struct tee_ta_ctx *ctx)
 	dump_state_no_ldelf_dbg(utc);
 }
 
+#ifdef CFG_TA_FTRACE_STREAM
+#define FTRACE_STREAM_PL_SIZE	(4 * SMALL_PAGE_SIZE)
+/* Duration, indentation and "0x<pc>() {" */
+#define FTRACE_LINE_MAX_LEN	(16 + FTRACE_RETFUNC_DEPTH + 32)
+/* Upper bound of the header written by ldelf, including padding */
+#define FTRACE_HEADER_MAX_LEN	256
+
+/*
+ * struct ftrace_stream - State of the drain of the ftrace ring of a TA
+ * @file_id:	File identifier returned by OPTEE_RPC_CMD_FTRACE
+ * @begin:	Entry timestamps of the functions being traced
+ * @depth:	Number of functions being traced
+ * @pending_pc:	Function entered which line isn't output yet
+ * @pending:	True if @pending_pc is valid
+ * @lost:	Function entries lost, as last reported
+ * @header_sent: True once the header of the buffer is sent
+ * @mobj:	RPC payload of the current drain
+ * @buf:	Text data in @mobj, preceded by the TA UUID
+ * @len:	Length of the text data in @buf
+ */
+struct ftrace_stream {
+	uint64_t file_id;
+	uint64_t begin[FTRACE_RETFUNC_DEPTH];
+	uint32_t depth;
+	uint64_t pending_pc;
+	bool pending;
+	uint32_t lost;
+	bool header_sent;
+	struct mobj *mobj;
+	char *buf;
+	size_t len;
+};
+
+static void ftrace_stream_flush(struct tee_ta_ctx *ctx,
+				struct ftrace_stream *st)
+{
+	struct thread_param params[3] = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!st->len)
+		return;
+
+	params[0] = THREAD_PARAM_VALUE(INOUT, st->file_id, 0, 0);
+	params[1] = THREAD_PARAM_MEMREF(IN, st->mobj, 0, sizeof(TEE_UUID));
+	params[2] = THREAD_PARAM_MEMREF(IN, st->mobj, sizeof(TEE_UUID),
+					st->len);
+
+	memcpy(mobj_get_va(st->mobj, 0), &ctx->uuid, sizeof(TEE_UUID));
+	res = thread_rpc_cmd(OPTEE_RPC_CMD_FTRACE, 3, params);
+	if (res)
+		EMSG("Ftrace thread_rpc_cmd res: %#"PRIx32, res);
+	else
+		st->file_id = params[0].u.value.a;
+	st->len = 0;
+}
+
+static void __printf(3, 4) ftrace_stream_printf(struct tee_ta_ctx *ctx,
+						struct ftrace_stream *st,
+						const char *fmt, ...)
+{
+	size_t sz = FTRACE_STREAM_PL_SIZE - sizeof(TEE_UUID);
+	va_list ap;
+	int n = 0;
+
+	if (st->len + FTRACE_LINE_MAX_LEN > sz)
+		ftrace_stream_flush(ctx, st);
+
+	va_start(ap, fmt);
+	n = vsnprintf(st->buf + st->len, sz - st->len, fmt, ap);
+	va_end(ap);
+	if (n > 0)
+		st->len += MIN((size_t)n, sz - st->len - 1);
+}
+
+/* Formats a duration the same way as the TA does without streaming */
+static void ftrace_stream_line(struct tee_ta_ctx *ctx,
+			       struct ftrace_stream *st, uint64_t ticks,
+			       bool with_duration, const char *fmt,
+			       uint64_t pc)
+{
+	uint64_t ns = ticks * 1000000000 / read_cntfrq();
+	uint32_t us = ns / 1000;
+	char dur[16] = { };
+
+	if (!with_duration)
+		dur[0] = '\0';
+	else if (CFG_FTRACE_US_MS && us >= CFG_FTRACE_US_MS)
+		snprintf(dur, sizeof(dur), "%"PRIu32".%03"PRIu32" ms",
+			 us / 1000, us % 1000);
+	else
+		snprintf(dur, sizeof(dur), "%"PRIu32".%03"PRIu32" us", us,
+			 (uint32_t)(ns % 1000));
+
+	ftrace_stream_printf(ctx, st, "%13s | %*s", dur, (int)st->depth, "");
+	ftrace_stream_printf(ctx, st, fmt, (int)(2 * sizeof(long)), pc);
+}
+
+static void ftrace_stream_rec(struct tee_ta_ctx *ctx,
+			      struct ftrace_stream *st,
+			      const struct ftrace_rec *rec)
+{
+	if (rec->pc) {
+		/* Entry of a function, its line is output on next record */
+		if (st->pending) {
+			st->depth--;
+			ftrace_stream_line(ctx, st, 0, false, "0x%0*"PRIx64"() {\n",
+					   st->pending_pc);
+			st->depth++;
+		}
+		if (st->depth < FTRACE_RETFUNC_DEPTH) {
+			st->begin[st->depth] = rec->ts;
+			st->depth++;
+		}
+		st->pending_pc = rec->pc;
+		st->pending = true;
+		return;
+	}
+
+	/* Return from a function */
+	if (!st->depth) {
+		ftrace_stream_line(ctx, st, 0, false, "}\n", 0);
+		return;
+	}
+	st->depth--;
+	if (st->pending)
+		ftrace_stream_line(ctx, st, rec->ts - st->begin[st->depth],
+				   true, "0x%0*"PRIx64"();\n", st->pending_pc);
+	else
+		ftrace_stream_line(ctx, st, rec->ts - st->begin[st->depth],
+				   true, "}\n", 0);
+	st->pending = false;
+}
+
+void user_ta_ftrace_drain(struct tee_ta_session *s, bool force)
+{
+	struct user_ta_ctx *utc = to_user_ta_ctx(s->ctx);
+	struct ftrace_buf *fbuf = s->fbuf;
+	struct ftrace_stream *st = utc->ftrace_stream;
+	struct ftrace_rec *rec = NULL;
+	uint32_t ring_size = 0;
+	uint32_t head = 0;
+	uint32_t tail = 0;
+	uint32_t lost = 0;
+	size_t sz = 0;
+
+	if (!fbuf)
+		return;
+
+	if (tee_mmu_check_access_rights(utc, TEE_MEMORY_ACCESS_READ |
+					TEE_MEMORY_ACCESS_WRITE |
+					TEE_MEMORY_ACCESS_ANY_OWNER,
+					(uaddr_t)fbuf, sizeof(*fbuf)))
+		return;
+
+	/* The TA may have changed any field, they're all checked */
+	ring_size = READ_ONCE(fbuf->ring_size);
+	rec = (void *)((vaddr_t)fbuf + READ_ONCE(fbuf->buf_off));
+	head = __atomic_load_n(&fbuf->ring_head, __ATOMIC_ACQUIRE);
+	tail = READ_ONCE(fbuf->ring_tail);
+	lost = READ_ONCE(fbuf->ring_lost);
+	if (!ring_size || !ALIGNMENT_IS_OK(rec, struct ftrace_rec) ||
+	    MUL_OVERFLOW(ring_size, sizeof(*rec), &sz) ||
+	    tee_mmu_check_access_rights(utc, TEE_MEMORY_ACCESS_READ |
+					TEE_MEMORY_ACCESS_ANY_OWNER,
+					(uaddr_t)rec, sz))
+		return;
+	if (head - tail > ring_size)
+		tail = head - ring_size;
+	if (!force && head - tail < ring_size / 2)
+		return;
+	if (st && st->header_sent && head == tail && lost == st->lost)
+		return;
+
+	if (!st) {
+		st = calloc(1, sizeof(*st));
+		if (!st)
+			return;
+		utc->ftrace_stream = st;
+	}
+
+	st->mobj = thread_rpc_alloc_payload(FTRACE_STREAM_PL_SIZE);
+	if (!st->mobj)
+		return;
+	st->buf = (char *)mobj_get_va(st->mobj, 0) + sizeof(TEE_UUID);
+	st->len = 0;
+
+	if (!st->header_sent) {
+		uint32_t head_off = READ_ONCE(fbuf->head_off);
+		const char *hdr = (const char *)fbuf + head_off;
+		size_t hlen = (vaddr_t)rec - (vaddr_t)hdr;
+
+		if (hlen < FTRACE_HEADER_MAX_LEN &&
+		    !tee_mmu_check_access_rights(utc, TEE_MEMORY_ACCESS_READ |
+						 TEE_MEMORY_ACCESS_ANY_OWNER,
+						 (uaddr_t)hdr, hlen))
+			ftrace_stream_printf(&utc->ctx, st, "%.*s",
+					     (int)strnlen(hdr, hlen), hdr);
+		st->header_sent = true;
+	}
+
+	if (lost != st->lost) {
+		ftrace_stream_printf(&utc->ctx, st,
+				     "# %"PRIu32" function entries lost\n",
+				     lost - st->lost);
+		st->lost = lost;
+	}
+
+	for (; tail != head; tail++)
+		ftrace_stream_rec(&utc->ctx, st, rec + tail % ring_size);
+	__atomic_store_n(&fbuf->ring_tail, tail, __ATOMIC_RELEASE);
+
+	ftrace_stream_flush(&utc->ctx, st);
+	thread_rpc_free_payload(st->mobj);
+	st->mobj = NULL;
+	st->buf = NULL;
+}
+#endif /*CFG_TA_FTRACE_STREAM*/
+
 #ifdef CFG_TA_FTRACE_SUPPORT
 static TEE_Result dump_ftrace(struct user_ta_ctx *utc, void *buf, size_t *blen)
 {
@@ -509,6 +745,7 @@ static void user_ta_dump_ftrace(struct tee_ta_ctx *ctx)
 	struct mobj *mobj = NULL;
 	uint8_t *ubuf = NULL;
 	void *buf = NULL;
+	uint64_t file_id = 0;
 	size_t pl_sz = 0;
 	size_t blen = 0;
 	vaddr_t va = 0;
@@ -543,7 +780,12 @@ static void user_ta_dump_ftrace(struct tee_ta_ctx *ctx)
 		goto out_unmap_pl;
 	}
 
-	params[0] = THREAD_PARAM_VALUE(INOUT, 0, 0, 0);
+#ifdef CFG_TA_FTRACE_STREAM
+	/* Appended to the function graph streamed so far */
+	if (utc->ftrace_stream)
+		file_id = utc->ftrace_stream->file_id;
+#endif
+	params[0] = THREAD_PARAM_VALUE(INOUT, file_id, 0, 0);
 	params[1] = THREAD_PARAM_MEMREF(IN, mobj, 0, sizeof(TEE_UUID));
 	params[2] = THREAD_PARAM_MEMREF(IN, mobj, sizeof(TEE_UUID), blen);
 
@@ -581,12 +823,20 @@ static void free_utc(struct user_ta_ctx *utc)
 	tee_obj_close_all(utc);
 	/* Free emums created by this TA */
 	tee_svc_storage_close_all_enum(utc);
+	/* Commit what's left of a storage transaction of this TA */
+	tee_svc_storage_end_txn(utc);
+#ifdef CFG_TA_FTRACE_STREAM
+	free(utc->ftrace_stream);
+#endif
 	free(utc);
 }
 
+static void fill_ctx_pool(void);
+
 static void user_ta_ctx_destroy(struct tee_ta_ctx *ctx)
 {
 	free_utc(to_user_ta_ctx(ctx));
+	fill_ctx_pool();
 }
 
 static uint32_t user_ta_get_instance_id(struct tee_ta_ctx *ctx)
@@ -660,6 +910,61 @@ static TEE_Result alloc_and_map_ldelf_fobj(struct user_ta_ctx *utc, size_t sz,
 	return res;
 }
 
+/*
+ * The code of ldelf is copied once into ldelf_code_fobj by the first
+ * context loading ldelf, the following contexts map the same pages.
+ */
+static struct fobj *ldelf_code_fobj;
+static struct mutex ldelf_code_mu = MUTEX_INITIALIZER;
+
+static TEE_Result map_ldelf_code(struct user_ta_ctx *utc, vaddr_t *va)
+{
+	size_t num_pgs = ROUNDUP(ldelf_code_size, SMALL_PAGE_SIZE) /
+			 SMALL_PAGE_SIZE;
+	TEE_Result res = TEE_SUCCESS;
+	struct mobj *mobj = NULL;
+	bool copy = false;
+
+	mutex_lock(&ldelf_code_mu);
+
+	if (!ldelf_code_fobj) {
+		ldelf_code_fobj = fobj_ta_mem_alloc(num_pgs);
+		if (!ldelf_code_fobj) {
+			res = TEE_ERROR_OUT_OF_MEMORY;
+			goto out;
+		}
+		copy = true;
+	}
+
+	mobj = mobj_with_fobj_alloc(ldelf_code_fobj, NULL);
+	if (!mobj) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+	res = vm_map(utc, va, num_pgs * SMALL_PAGE_SIZE,
+		     copy ? TEE_MATTR_PRW : TEE_MATTR_URX,
+		     VM_FLAG_LDELF | VM_FLAG_EXCLUSIVE_MOBJ, mobj, 0);
+	if (res) {
+		mobj_free(mobj);
+		goto out;
+	}
+
+	if (copy) {
+		tee_mmu_set_ctx(&utc->ctx);
+		memcpy((void *)*va, ldelf_data, ldelf_code_size);
+		res = vm_set_prot(utc, *va, num_pgs * SMALL_PAGE_SIZE,
+				  TEE_MATTR_URX);
+	}
+out:
+	if (res && copy) {
+		fobj_put(ldelf_code_fobj);
+		ldelf_code_fobj = NULL;
+	}
+	mutex_unlock(&ldelf_code_mu);
+
+	return res;
+}
+
 /*
  * This function may leave a few mappings behind on error, but that's taken
  * care of by tee_ta_init_user_ta_session() since the entire context is
@@ -681,8 +986,7 @@ static TEE_Result load_ldelf(struct user_ta_ctx *utc)
 		return res;
 	utc->ldelf_stack_ptr = stack_addr + LDELF_STACK_SIZE;
 
-	res = alloc_and_map_ldelf_fobj(utc, ldelf_code_size, TEE_MATTR_PRW,
-				       &code_addr);
+	res = map_ldelf_code(utc, &code_addr);
 	if (res)
 		return res;
 	utc->entry_func = code_addr + ldelf_entry;
@@ -695,30 +999,20 @@ static TEE_Result load_ldelf(struct user_ta_ctx *utc)
 
 	tee_mmu_set_ctx(&utc->ctx);
 
-	memcpy((void *)code_addr, ldelf_data, ldelf_code_size);
 	memcpy((void *)rw_addr, ldelf_data + ldelf_code_size, ldelf_data_size);
 
-	res = vm_set_prot(utc, code_addr,
-			  ROUNDUP(ldelf_code_size, SMALL_PAGE_SIZE),
-			  TEE_MATTR_URX);
-	if (res)
-		return res;
-
 	DMSG("ldelf load address %#"PRIxVA, code_addr);
 
 	return TEE_SUCCESS;
 }
 
-TEE_Result tee_ta_init_user_ta_session(const TEE_UUID *uuid,
-				       struct tee_ta_session *s)
+/*
+ * Initializes a new context @utc with ldelf loaded, on error @utc must be
+ * freed with free_utc().
+ */
+static TEE_Result init_utc(struct user_ta_ctx *utc, struct tee_ta_session *s)
 {
-	TEE_Result res;
-	struct user_ta_ctx *utc = NULL;
-
-	/* Register context */
-	utc = calloc(1, sizeof(struct user_ta_ctx));
-	if (!utc)
-		return TEE_ERROR_OUT_OF_MEMORY;
+	TEE_Result res = TEE_SUCCESS;
 
 	utc->ctx.initializing = true;
 	utc->is_initializing = true;
@@ -733,21 +1027,105 @@ TEE_Result tee_ta_init_user_ta_session(const TEE_UUID *uuid,
 	 */
 	set_ta_ctx_ops(&utc->ctx);
 
-	utc->ctx.uuid = *uuid;
 	res = vm_info_init(utc);
 	if (res)
-		goto err;
+		return res;
 
 	s->ctx = &utc->ctx;
 	tee_ta_push_current_session(s);
 	res = load_ldelf(utc);
 	tee_ta_pop_current_session();
-	if (res)
-		goto err;
 
+	return res;
+}
+
+#if CFG_USER_TA_CTX_POOL_SIZE > 0
+/* Contexts with ldelf loaded, ready to be used for a new session */
+static struct user_ta_ctx *ctx_pool[CFG_USER_TA_CTX_POOL_SIZE];
+static struct mutex ctx_pool_mutex = MUTEX_INITIALIZER;
+
+static struct user_ta_ctx *get_pool_ctx(void)
+{
+	struct user_ta_ctx *utc = NULL;
+	size_t n = 0;
+
+	mutex_lock(&ctx_pool_mutex);
+	for (n = 0; n < ARRAY_SIZE(ctx_pool) && !utc; n++) {
+		utc = ctx_pool[n];
+		ctx_pool[n] = NULL;
+	}
+	mutex_unlock(&ctx_pool_mutex);
+
+	return utc;
+}
+
+static void fill_ctx_pool(void)
+{
+	struct tee_ta_session s = { };
+	struct user_ta_ctx *utc = NULL;
+	size_t n = 0;
+
+	mutex_lock(&ctx_pool_mutex);
+	for (n = 0; n < ARRAY_SIZE(ctx_pool); n++) {
+		if (ctx_pool[n])
+			continue;
+
+		utc = calloc(1, sizeof(*utc));
+		if (!utc)
+			break;
+
+		/*
+		 * The dummy session only makes the new context current
+		 * while ldelf is copied, popping it restores the context
+		 * of the caller.
+		 */
+		if (init_utc(utc, &s)) {
+			pgt_flush_ctx(&utc->ctx);
+			free_utc(utc);
+			break;
+		}
+
+		ctx_pool[n] = utc;
+	}
+	mutex_unlock(&ctx_pool_mutex);
+}
+#else
+static struct user_ta_ctx *get_pool_ctx(void)
+{
+	return NULL;
+}
+
+static void fill_ctx_pool(void)
+{
+}
+#endif
+
+TEE_Result tee_ta_init_user_ta_session(const TEE_UUID *uuid,
+				       struct tee_ta_session *s)
+{
+	TEE_Result res;
+	struct user_ta_ctx *utc = NULL;
+
+	/* Register context */
+	utc = get_pool_ctx();
+	if (utc) {
+		s->ctx = &utc->ctx;
+	} else {
+		utc = calloc(1, sizeof(struct user_ta_ctx));
+		if (!utc)
+			return TEE_ERROR_OUT_OF_MEMORY;
+
+		res = init_utc(utc, s);
+		if (res)
+			goto err;
+	}
+
+	utc->ctx.uuid = *uuid;
 	utc->ctx.ref_count = 1;
+	mutex_init(&utc->ctx.busy_mutex);
 	condvar_init(&utc->ctx.busy_cv);
-	TAILQ_INSERT_TAIL(&tee_ctxes, &utc->ctx, link);
+	TAILQ_INIT(&utc->ctx.busy_waiters);
+	tee_ta_link_ctx(&utc->ctx);
 
 	tee_mmu_set_ctx(NULL);
 	return TEE_SUCCESS;
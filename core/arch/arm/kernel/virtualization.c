@@ -21,8 +21,16 @@
 
 static unsigned int prtn_list_lock __nex_data = SPINLOCK_UNLOCK;
 
-static LIST_HEAD(prtn_list_head, guest_partition) prtn_list __nex_data =
-	LIST_HEAD_INITIALIZER(prtn_list_head);
+/*
+ * Guests are hashed on their ID, guest IDs are usually allocated
+ * sequentially by the hypervisor so each bucket holds at most a few guests
+ * and the lookup on each call from normal world doesn't depend on the
+ * number of guests.
+ */
+#define PRTN_HASH_SIZE	CFG_VIRT_GUEST_COUNT
+
+static LIST_HEAD(prtn_list_head, guest_partition)
+	prtn_hash[PRTN_HASH_SIZE] __nex_bss;
 
 /* Free pages used for guest partitions */
 tee_mm_pool_t virt_mapper_pool __nex_bss;
@@ -44,6 +52,23 @@ struct guest_partition {
 	struct refcount refc;
 };
 
+static struct prtn_list_head *prtn_bucket(uint16_t guest_id)
+{
+	return prtn_hash + guest_id % PRTN_HASH_SIZE;
+}
+
+/* Called with prtn_list_lock held */
+static struct guest_partition *find_prtn(uint16_t guest_id)
+{
+	struct guest_partition *prtn = NULL;
+
+	LIST_FOREACH(prtn, prtn_bucket(guest_id), link)
+		if (prtn->id == guest_id)
+			return prtn;
+
+	return NULL;
+}
+
 struct guest_partition *current_partition[CFG_TEE_CORE_NB_CORE] __nex_bss;
 
 static struct guest_partition *get_current_prtn(void)
@@ -266,7 +291,7 @@ uint32_t virt_guest_created(uint16_t guest_id)
 	thread_init_threads();
 
 	exceptions = cpu_spin_lock_xsave(&prtn_list_lock);
-	LIST_INSERT_HEAD(&prtn_list, prtn, link);
+	LIST_INSERT_HEAD(prtn_bucket(guest_id), prtn, link);
 	cpu_spin_unlock_xrestore(&prtn_list_lock, exceptions);
 
 	IMSG("Added guest %d", guest_id);
@@ -284,13 +309,9 @@ uint32_t virt_guest_destroyed(uint16_t guest_id)
 	IMSG("Removing guest %d", guest_id);
 
 	exceptions = cpu_spin_lock_xsave(&prtn_list_lock);
-
-	LIST_FOREACH(prtn, &prtn_list, link) {
-		if (prtn->id == guest_id) {
-			LIST_REMOVE(prtn, link);
-			break;
-		}
-	}
+	prtn = find_prtn(guest_id);
+	if (prtn)
+		LIST_REMOVE(prtn, link);
 	cpu_spin_unlock_xrestore(&prtn_list_lock, exceptions);
 
 	if (prtn) {
@@ -327,15 +348,13 @@ bool virt_set_guest(uint16_t guest_id)
 		panic("Virtual guest partition is already set");
 
 	exceptions = cpu_spin_lock_xsave(&prtn_list_lock);
-	LIST_FOREACH(prtn, &prtn_list, link) {
-		if (prtn->id == guest_id) {
-			set_current_prtn(prtn);
-			core_mmu_set_prtn(prtn->mmu_prtn);
-			refcount_inc(&prtn->refc);
-			cpu_spin_unlock_xrestore(&prtn_list_lock,
-						 exceptions);
-			return true;
-		}
+	prtn = find_prtn(guest_id);
+	if (prtn) {
+		set_current_prtn(prtn);
+		core_mmu_set_prtn(prtn->mmu_prtn);
+		refcount_inc(&prtn->refc);
+		cpu_spin_unlock_xrestore(&prtn_list_lock, exceptions);
+		return true;
 	}
 	cpu_spin_unlock_xrestore(&prtn_list_lock, exceptions);
 
@@ -2,7 +2,9 @@
 /*
  * Copyright (c) 2015-2016, Linaro Limited
  */
+#include <assert.h>
 #include <compiler.h>
+#include <kernel/notif.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
 #include <kernel/wait_queue.h>
@@ -11,6 +13,7 @@
 #include <tee_api_defines.h>
 #include <trace.h>
 #include <types_ext.h>
+#include <util.h>
 
 static unsigned wq_spin_lock;
 
@@ -44,6 +47,47 @@ void __weak __wq_rpc(uint32_t func, int id, const void *sync_obj __maybe_unused,
 		DMSG("%s thread %u ret 0x%x", cmd_str, id, ret);
 }
 
+/*
+ * Returns the key normal world sleeps on for the thread @handle, it
+ * matches the notification value waking it up if enabled.
+ */
+static int wq_key(int handle)
+{
+	if (notif_wq_wakeup_enabled())
+		return NOTIF_VALUE_WQ_BASE + handle;
+	return handle;
+}
+
+/*
+ * Wakes the @count threads in @handles. With notifications the sleeping
+ * threads are resumed by normal world without an RPC from the calling
+ * thread and all of them are signalled with a single interrupt, else an
+ * RPC is needed for each of them.
+ */
+static void wq_wakeup(const int *handles, size_t count, const void *sync_obj,
+		      const char *fname, int lineno)
+{
+	uint32_t values[CFG_NUM_THREADS] = { };
+	size_t n = 0;
+
+	if (!notif_wq_wakeup_enabled()) {
+		for (n = 0; n < count; n++)
+			__wq_rpc(OPTEE_RPC_WAIT_QUEUE_WAKEUP, handles[n],
+				 sync_obj, fname, lineno);
+		return;
+	}
+
+	for (n = 0; n < count; n++) {
+		if (fname)
+			DMSG("notify thread %u %p %s:%d", handles[n], sync_obj,
+			     fname, lineno);
+		else
+			DMSG("notify thread %u %p", handles[n], sync_obj);
+		values[n] = NOTIF_VALUE_WQ_BASE + handles[n];
+	}
+	notif_send_async_multi(values, count);
+}
+
 static void slist_add_tail(struct wait_queue *wq, struct wait_queue_elem *wqe)
 {
 	struct wait_queue_elem *wqe_iter;
@@ -82,7 +126,7 @@ void wq_wait_final(struct wait_queue *wq, struct wait_queue_elem *wqe,
 	unsigned done;
 
 	do {
-		__wq_rpc(OPTEE_RPC_WAIT_QUEUE_SLEEP, wqe->handle,
+		__wq_rpc(OPTEE_RPC_WAIT_QUEUE_SLEEP, wq_key(wqe->handle),
 			 sync_obj, fname, lineno);
 
 		old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
@@ -100,8 +144,8 @@ void wq_wake_next(struct wait_queue *wq, const void *sync_obj,
 {
 	uint32_t old_itr_status;
 	struct wait_queue_elem *wqe;
-	int handle = -1;
-	bool do_wakeup = false;
+	int handles[CFG_NUM_THREADS] = { };
+	size_t num_handles = 0;
 	bool wake_type_assigned = false;
 	bool wake_read = false; /* avoid gcc warning */
 
@@ -109,40 +153,37 @@ void wq_wake_next(struct wait_queue *wq, const void *sync_obj,
 	 * If next type is wait_read wakeup all wqe with wait_read true.
 	 * If next type isn't wait_read wakeup only the first wqe which isn't
 	 * done.
+	 *
+	 * The waiters are all selected in one pass and woken up together
+	 * after the spinlock is released.
 	 */
 
-	while (true) {
-		old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
+	old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
 
-		SLIST_FOREACH(wqe, wq, link) {
-			if (wqe->cv)
-				continue;
-			if (wqe->done)
-				continue;
-			if (!wake_type_assigned) {
-				wake_read = wqe->wait_read;
-				wake_type_assigned = true;
-			}
-
-			if (wqe->wait_read != wake_read)
-				continue;
-
-			wqe->done = true;
-			handle = wqe->handle;
-			do_wakeup = true;
-			break;
+	SLIST_FOREACH(wqe, wq, link) {
+		if (wqe->cv)
+			continue;
+		if (wqe->done)
+			continue;
+		if (!wake_type_assigned) {
+			wake_read = wqe->wait_read;
+			wake_type_assigned = true;
 		}
 
-		cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
-
-		if (do_wakeup)
-			__wq_rpc(OPTEE_RPC_WAIT_QUEUE_WAKEUP, handle,
-				 sync_obj, fname, lineno);
+		if (wqe->wait_read != wake_read)
+			continue;
 
-		if (!do_wakeup || !wake_read)
+		wqe->done = true;
+		assert(num_handles < ARRAY_SIZE(handles));
+		handles[num_handles++] = wqe->handle;
+		if (!wake_read)
 			break;
-		do_wakeup = false;
 	}
+
+	cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+
+	if (num_handles)
+		wq_wakeup(handles, num_handles, sync_obj, fname, lineno);
 }
 
 void wq_promote_condvar(struct wait_queue *wq, struct condvar *cv,
@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <config.h>
+#include <kernel/mutex.h>
+#include <kernel/notif.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <kernel/work_queue.h>
+
+static TAILQ_HEAD(work_head, work) work_head =
+	TAILQ_HEAD_INITIALIZER(work_head);
+static unsigned int work_lock = SPINLOCK_UNLOCK;
+/* Work currently being run by each thread, only compared, never used */
+static struct work *work_running[CFG_NUM_THREADS];
+/* Set once normal world has lent a thread with OPTEE_MSG_CMD_DO_WORK */
+static bool work_have_worker;
+
+static struct mutex work_flush_mu = MUTEX_INITIALIZER;
+static struct condvar work_flush_cv = CONDVAR_INITIALIZER;
+
+bool work_queue(struct work *work)
+{
+	uint32_t exceptions = 0;
+	bool was_empty = false;
+
+	exceptions = cpu_spin_lock_xsave(&work_lock);
+	if (work->queued) {
+		cpu_spin_unlock_xrestore(&work_lock, exceptions);
+		return false;
+	}
+	was_empty = TAILQ_EMPTY(&work_head);
+	work->queued = true;
+	TAILQ_INSERT_TAIL(&work_head, work, link);
+	cpu_spin_unlock_xrestore(&work_lock, exceptions);
+
+	/* A worker already running will pick up the work anyway */
+	if (was_empty && work_have_worker)
+		notif_send_async(NOTIF_VALUE_DO_WORK);
+
+	return true;
+}
+
+bool work_cancel(struct work *work)
+{
+	uint32_t exceptions = 0;
+	bool ret = false;
+
+	exceptions = cpu_spin_lock_xsave(&work_lock);
+	if (work->queued) {
+		TAILQ_REMOVE(&work_head, work, link);
+		work->queued = false;
+		ret = true;
+	}
+	cpu_spin_unlock_xrestore(&work_lock, exceptions);
+
+	return ret;
+}
+
+static bool work_is_busy(struct work *work)
+{
+	uint32_t exceptions = 0;
+	bool ret = false;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&work_lock);
+	ret = work->queued;
+	for (n = 0; n < CFG_NUM_THREADS && !ret; n++)
+		ret = work_running[n] == work;
+	cpu_spin_unlock_xrestore(&work_lock, exceptions);
+
+	return ret;
+}
+
+void work_flush(struct work *work)
+{
+	mutex_lock(&work_flush_mu);
+	while (work_is_busy(work))
+		condvar_wait(&work_flush_cv, &work_flush_mu);
+	mutex_unlock(&work_flush_mu);
+}
+
+void work_run_queued(void)
+{
+	size_t ct = thread_get_id();
+	uint32_t exceptions = 0;
+	struct work *work = NULL;
+	work_func_t func = NULL;
+
+	while (true) {
+		exceptions = cpu_spin_lock_xsave(&work_lock);
+		work = TAILQ_FIRST(&work_head);
+		if (!work) {
+			cpu_spin_unlock_xrestore(&work_lock, exceptions);
+			return;
+		}
+		TAILQ_REMOVE(&work_head, work, link);
+		work->queued = false;
+		func = work->func;
+		work_running[ct] = work;
+		cpu_spin_unlock_xrestore(&work_lock, exceptions);
+
+		/* The work may be freed or queued again by the function */
+		func(work);
+
+		exceptions = cpu_spin_lock_xsave(&work_lock);
+		work_running[ct] = NULL;
+		cpu_spin_unlock_xrestore(&work_lock, exceptions);
+
+		mutex_lock(&work_flush_mu);
+		condvar_broadcast(&work_flush_cv);
+		mutex_unlock(&work_flush_mu);
+	}
+}
+
+void work_run_on_std_exit(void)
+{
+	if (!work_have_worker)
+		work_run_queued();
+}
+
+void work_run_worker(void)
+{
+	/*
+	 * Normal world can only be asked for a worker when it can be
+	 * notified, else queued work keeps being run at the end of
+	 * standard calls.
+	 */
+	if (IS_ENABLED(CFG_CORE_ASYNC_NOTIF))
+		work_have_worker = true;
+
+	work_run_queued();
+}
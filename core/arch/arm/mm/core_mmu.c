@@ -7,9 +7,11 @@
 #include <arm.h>
 #include <assert.h>
 #include <bitstring.h>
+#include <config.h>
 #include <kernel/cache_helpers.h>
 #include <kernel/generic_boot.h>
 #include <kernel/linker.h>
+#include <kernel/misc.h>
 #include <kernel/panic.h>
 #include <kernel/virtualization.h>
 #include <kernel/spinlock.h>
@@ -132,6 +134,22 @@ register_phys_mem(MEM_AREA_NSEC_SHM, TEE_SHMEM_START, TEE_SHMEM_SIZE);
 static bitstr_t bit_decl(g_asid, MMU_NUM_ASID_PAIRS) __nex_bss;
 static unsigned int g_asid_spinlock __nex_bss = SPINLOCK_UNLOCK;
 
+/*
+ * The user map translation tables of a thread get a new generation each
+ * time they're populated. TLB entries of an ASID can be kept when the
+ * ASID is activated again on a core with the same tables as last time,
+ * as when a thread returning from an RPC is resumed. Any change to the
+ * user map of a context is done by populating the tables again.
+ */
+struct asid_user_map {
+	uint32_t gen;
+	uint16_t thread_id;
+};
+
+static uint32_t user_map_gen[CFG_NUM_THREADS] __nex_bss;
+static struct asid_user_map
+	asid_user_maps[CFG_TEE_CORE_NB_CORE][MMU_NUM_ASID_PAIRS] __nex_bss;
+
 static unsigned int mmu_spinlock;
 
 static uint32_t mmu_lock(void)
@@ -1002,6 +1020,106 @@ static void init_mem_map(struct tee_mmap_region *memory_map, size_t num_elems)
 	dump_mmap_table(memory_map);
 }
 
+/*
+ * Translations of the regions of the boot memory map which are never
+ * remapped, sorted by virtual address and by type and physical address.
+ * virt_to_phys() and phys_to_virt() look them up before searching the
+ * memory map or walking the translation tables. They're set up once by
+ * core_init_mmu_map() and only read afterwards, regions added later with
+ * core_mmu_add_mapping() take the slow path.
+ */
+struct va_pa_range {
+	vaddr_t va;
+	paddr_t pa;
+	size_t size;
+	enum teecore_memtypes type;
+};
+
+static struct va_pa_range va_pa_by_va[CFG_MMAP_REGIONS] __nex_bss;
+static struct va_pa_range va_pa_by_pa[CFG_MMAP_REGIONS] __nex_bss;
+static size_t va_pa_count __nex_bss;
+
+/*
+ * Index of the last range found, per CPU. It's only a hint checked before
+ * use, so it's read and updated without masking foreign interrupts.
+ */
+static size_t va_pa_last_va[CFG_TEE_CORE_NB_CORE] __nex_bss;
+static size_t va_pa_last_pa[CFG_TEE_CORE_NB_CORE] __nex_bss;
+
+static bool va_pa_type_is_fixed(enum teecore_memtypes type)
+{
+	switch (type) {
+	case MEM_AREA_TEE_RAM:
+	case MEM_AREA_TEE_RAM_RX:
+	case MEM_AREA_TEE_RAM_RO:
+	case MEM_AREA_TEE_RAM_RW:
+		/* Partly paged */
+		return !IS_ENABLED(CFG_WITH_PAGER) &&
+		       /* Each guest has its own TEE_RAM_RW */
+		       (!IS_ENABLED(CFG_VIRTUALIZATION) ||
+			type != MEM_AREA_TEE_RAM_RW);
+	case MEM_AREA_NEX_RAM_RW:
+	case MEM_AREA_IO_NSEC:
+	case MEM_AREA_IO_SEC:
+		return true;
+	case MEM_AREA_TEE_COHERENT:
+	case MEM_AREA_TEE_ASAN:
+	case MEM_AREA_TA_RAM:
+	case MEM_AREA_NSEC_SHM:
+	case MEM_AREA_RAM_NSEC:
+	case MEM_AREA_RAM_SEC:
+	case MEM_AREA_SDP_MEM:
+	case MEM_AREA_DDR_OVERALL:
+	case MEM_AREA_SEC_RAM_OVERALL:
+		/* Guests have their own copy of the memory map */
+		return !IS_ENABLED(CFG_VIRTUALIZATION);
+	default:
+		return false;
+	}
+}
+
+static int cmp_va_pa_by_va(const void *a, const void *b)
+{
+	const struct va_pa_range *ra = a;
+	const struct va_pa_range *rb = b;
+
+	return CMP_TRILEAN(ra->va, rb->va);
+}
+
+static int cmp_va_pa_by_pa(const void *a, const void *b)
+{
+	const struct va_pa_range *ra = a;
+	const struct va_pa_range *rb = b;
+
+	if (ra->type != rb->type)
+		return CMP_TRILEAN(ra->type, rb->type);
+	return CMP_TRILEAN(ra->pa, rb->pa);
+}
+
+static void init_va_pa_ranges(void)
+{
+	struct tee_mmap_region *map = NULL;
+	size_t n = 0;
+
+	for (map = static_memory_map; !core_mmap_is_end_of_table(map); map++) {
+		if (!map->pa || !map->size || !va_pa_type_is_fixed(map->type))
+			continue;
+		assert(n < ARRAY_SIZE(va_pa_by_va));
+		va_pa_by_va[n] = (struct va_pa_range){
+			.va = map->va,
+			.pa = map->pa,
+			.size = map->size,
+			.type = map->type,
+		};
+		n++;
+	}
+
+	memcpy(va_pa_by_pa, va_pa_by_va, n * sizeof(*va_pa_by_pa));
+	qsort(va_pa_by_va, n, sizeof(*va_pa_by_va), cmp_va_pa_by_va);
+	qsort(va_pa_by_pa, n, sizeof(*va_pa_by_pa), cmp_va_pa_by_pa);
+	va_pa_count = n;
+}
+
 /*
  * core_init_mmu_map - init tee core default memory mapping
  *
@@ -1062,6 +1180,7 @@ void core_init_mmu_map(void)
 
 	core_init_mmu(static_memory_map);
 	dump_xlat_table(0x0, 1);
+	init_va_pa_ranges();
 }
 
 bool core_mmu_mattr_is_ok(uint32_t mattr)
@@ -1074,6 +1193,7 @@ bool core_mmu_mattr_is_ok(uint32_t mattr)
 	switch ((mattr >> TEE_MATTR_CACHE_SHIFT) & TEE_MATTR_CACHE_MASK) {
 	case TEE_MATTR_CACHE_NONCACHE:
 	case TEE_MATTR_CACHE_CACHED:
+	case TEE_MATTR_CACHE_WC:
 		return true;
 	default:
 		return false;
@@ -1168,6 +1288,81 @@ static void *map_pa2va(struct tee_mmap_region *map, paddr_t pa)
 	return (void *)(vaddr_t)(map->va + pa - map->pa);
 }
 
+static const struct va_pa_range *find_va_pa_by_va(vaddr_t va)
+{
+	size_t *last = va_pa_last_va + __get_core_pos();
+	const struct va_pa_range *r = NULL;
+	size_t hi = va_pa_count;
+	size_t lo = 0;
+	size_t mid = 0;
+
+	if (*last < va_pa_count) {
+		r = va_pa_by_va + *last;
+		if (va >= r->va && va - r->va < r->size)
+			return r;
+	}
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		r = va_pa_by_va + mid;
+		if (va < r->va) {
+			hi = mid;
+		} else if (va - r->va >= r->size) {
+			lo = mid + 1;
+		} else {
+			*last = mid;
+			return r;
+		}
+	}
+
+	return NULL;
+}
+
+static const struct va_pa_range *find_va_pa_by_pa(enum teecore_memtypes type,
+						  paddr_t pa)
+{
+	size_t *last = va_pa_last_pa + __get_core_pos();
+	const struct va_pa_range *r = NULL;
+	size_t hi = va_pa_count;
+	size_t lo = 0;
+	size_t mid = 0;
+
+	if (*last < va_pa_count) {
+		r = va_pa_by_pa + *last;
+		if (r->type == type && pa >= r->pa && pa - r->pa < r->size)
+			return r;
+	}
+
+	/* Find the last range starting at or below @pa */
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		r = va_pa_by_pa + mid;
+		if (r->type < type || (r->type == type && r->pa <= pa))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (!lo)
+		return NULL;
+
+	r = va_pa_by_pa + lo - 1;
+	if (r->type != type || pa - r->pa >= r->size)
+		return NULL;
+	*last = lo - 1;
+
+	return r;
+}
+
+static void *pa2va_by_type(enum teecore_memtypes type, paddr_t pa)
+{
+	const struct va_pa_range *r = find_va_pa_by_pa(type, pa);
+
+	if (r)
+		return (void *)(vaddr_t)(r->va + pa - r->pa);
+
+	return map_pa2va(find_map_by_type_and_pa(type, pa), pa);
+}
+
 /*
  * teecore gets some memory area definitions
  */
@@ -1355,6 +1550,81 @@ static void set_region(struct core_mmu_table_info *tbl_info,
 	}
 }
 
+#ifdef CFG_WITH_LPAE
+/* Number of small page entries covered by the contiguous hint */
+#define CONTIG_HINT_ENTRIES	16
+#endif
+
+/*
+ * Like set_region(), but with LPAE each naturally aligned group of
+ * CONTIG_HINT_ENTRIES entries where the physical address is aligned
+ * likewise gets the contiguous hint, allowing it to be cached in a single
+ * TLB entry. This is only used for the user mapping, which is always
+ * rebuilt as a whole so these entries are never updated one by one.
+ */
+static void set_user_region(struct core_mmu_table_info *tbl_info,
+			    struct tee_mmap_region *region)
+{
+#ifdef CFG_WITH_LPAE
+	size_t contig_size = CONTIG_HINT_ENTRIES << tbl_info->shift;
+	unsigned int first = core_mmu_va2idx(tbl_info, region->va);
+	unsigned int end = core_mmu_va2idx(tbl_info,
+					   region->va + region->size);
+	unsigned int group = 0;
+	unsigned int idx = 0;
+	paddr_t pa = region->pa;
+	uint32_t attr = 0;
+
+	if (tbl_info->shift != SMALL_PAGE_SHIFT ||
+	    ((region->pa - region->va) & (contig_size - 1))) {
+		set_region(tbl_info, region);
+		return;
+	}
+
+	for (idx = first; idx < end; idx++) {
+		group = ROUNDDOWN(idx, CONTIG_HINT_ENTRIES);
+		attr = region->attr;
+		if (group >= first && group + CONTIG_HINT_ENTRIES <= end)
+			attr |= TEE_MATTR_CONTIG;
+		core_mmu_set_entry(tbl_info, idx, pa, attr);
+		pa += BIT(tbl_info->shift);
+	}
+#else
+	set_region(tbl_info, region);
+#endif
+}
+
+/*
+ * Returns true if the part of @region at @va, aligned to the size of an
+ * entry in @dir_info, can be mapped with a block entry in @dir_info
+ * instead of with a translation table. The physical address is returned
+ * in @pa.
+ */
+static bool can_map_user_block(struct core_mmu_table_info *dir_info,
+			       struct vm_region *region, vaddr_t va,
+			       paddr_t *pa)
+{
+	size_t block_size = BIT(dir_info->shift);
+	size_t offset = va - region->va + region->offset;
+	size_t granule = 0;
+
+	if (mobj_is_paged(region->mobj))
+		return false;
+	if ((va & (block_size - 1)) ||
+	    region->va + region->size - va < block_size)
+		return false;
+
+	/* The block must not cross a physically contiguous granule */
+	granule = mobj_get_phys_granule(region->mobj);
+	if (offset / granule != (offset + block_size - 1) / granule)
+		return false;
+
+	if (mobj_get_pa(region->mobj, offset, 0, pa))
+		return false;
+
+	return !(*pa & (block_size - 1));
+}
+
 static void set_pg_region(struct core_mmu_table_info *dir_info,
 			struct vm_region *region, struct pgt **pgt,
 			struct core_mmu_table_info *pg_info)
@@ -1368,6 +1638,19 @@ static void set_pg_region(struct core_mmu_table_info *dir_info,
 	uint32_t pgt_attr = (r.attr & TEE_MATTR_SECURE) | TEE_MATTR_TABLE;
 
 	while (r.va < end) {
+		if (can_map_user_block(dir_info, region, r.va, &r.pa)) {
+			/*
+			 * Physically contiguous and aligned, map with a
+			 * single block entry. The page table allocated for
+			 * this range is left unused.
+			 */
+			core_mmu_set_entry(dir_info,
+					   core_mmu_va2idx(dir_info, r.va),
+					   r.pa, r.attr);
+			r.va += CORE_MMU_PGDIR_SIZE;
+			continue;
+		}
+
 		if (!pg_info->table ||
 		     r.va >= (pg_info->va_base + CORE_MMU_PGDIR_SIZE)) {
 			/*
@@ -1419,7 +1702,7 @@ static void set_pg_region(struct core_mmu_table_info *dir_info,
 			if (mobj_get_pa(region->mobj, offset, granule,
 					&r.pa) != TEE_SUCCESS)
 				panic("Failed to get PA of unpaged mobj");
-			set_region(pg_info, &r);
+			set_user_region(pg_info, &r);
 		}
 		r.va += r.size;
 	}
@@ -1506,6 +1789,18 @@ void core_mmu_map_region(struct mmu_partition *prtn, struct tee_mmap_region *mm)
 
 TEE_Result core_mmu_map_pages(vaddr_t vstart, paddr_t *pages, size_t num_pages,
 			      enum teecore_memtypes memtype)
+{
+	uint32_t cattr = (core_mmu_type_to_attr(memtype) >>
+			  TEE_MATTR_CACHE_SHIFT) & TEE_MATTR_CACHE_MASK;
+
+	return core_mmu_map_pages_cattr(vstart, pages, num_pages, memtype,
+					cattr);
+}
+
+TEE_Result core_mmu_map_pages_cattr(vaddr_t vstart, paddr_t *pages,
+				    size_t num_pages,
+				    enum teecore_memtypes memtype,
+				    uint32_t cattr)
 {
 	TEE_Result ret;
 	struct core_mmu_table_info tbl_info;
@@ -1516,10 +1811,15 @@ TEE_Result core_mmu_map_pages(vaddr_t vstart, paddr_t *pages, size_t num_pages,
 	vaddr_t vaddr = vstart;
 	size_t i;
 	bool secure;
+	uint32_t attr = core_mmu_type_to_attr(memtype);
 
-	assert(!(core_mmu_type_to_attr(memtype) & TEE_MATTR_PX));
+	assert(!(attr & TEE_MATTR_PX));
 
-	secure = core_mmu_type_to_attr(memtype) & TEE_MATTR_SECURE;
+	secure = attr & TEE_MATTR_SECURE;
+	attr &= ~(TEE_MATTR_CACHE_MASK << TEE_MATTR_CACHE_SHIFT);
+	attr |= cattr << TEE_MATTR_CACHE_SHIFT;
+	if (!core_mmu_mattr_is_ok(attr))
+		return TEE_ERROR_BAD_PARAMETERS;
 
 	if (vaddr & SMALL_PAGE_MASK)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -1558,8 +1858,7 @@ TEE_Result core_mmu_map_pages(vaddr_t vstart, paddr_t *pages, size_t num_pages,
 		if (old_attr)
 			panic("Page is already mapped");
 
-		core_mmu_set_entry(&tbl_info, idx, pages[i],
-				   core_mmu_type_to_attr(memtype));
+		core_mmu_set_entry(&tbl_info, idx, pages[i], attr);
 		vaddr += SMALL_PAGE_SIZE;
 	}
 
@@ -1613,6 +1912,20 @@ void core_mmu_unmap_pages(vaddr_t vstart, size_t num_pages)
 	mmu_unlock(exceptions);
 }
 
+/* Called each time the user map tables of the current thread change */
+static void user_map_new_gen(void)
+{
+	size_t thread_id = thread_get_id();
+
+	user_map_gen[thread_id]++;
+	/*
+	 * On rollover a recorded generation could match again, flush all
+	 * TLB entries so they can't belong to a recorded generation.
+	 */
+	if (!user_map_gen[thread_id])
+		tlbi_all();
+}
+
 void core_mmu_populate_user_map(struct core_mmu_table_info *dir_info,
 				struct user_ta_ctx *utc)
 {
@@ -1622,6 +1935,8 @@ void core_mmu_populate_user_map(struct core_mmu_table_info *dir_info,
 	struct vm_region *r;
 	struct vm_region *r_last;
 
+	user_map_new_gen();
+
 	/* Find the first and last valid entry */
 	r = TAILQ_FIRST(&utc->vm_info->regions);
 	if (!r)
@@ -1641,14 +1956,69 @@ void core_mmu_populate_user_map(struct core_mmu_table_info *dir_info,
 		set_pg_region(dir_info, r, &pgt, &pg_info);
 }
 
+/*
+ * Maps @mm with the largest entries its alignment and size allows, tables
+ * are split as needed. Returns false if a table can't be split, what was
+ * mapped of @mm is then unmapped again.
+ */
+static bool map_added_region(struct tee_mmap_region *mm)
+{
+	struct core_mmu_table_info tbl_info = { };
+	bool secure = mm->attr & TEE_MATTR_SECURE;
+	vaddr_t end = mm->va + mm->size;
+	vaddr_t va = mm->va;
+	paddr_t pa = mm->pa;
+	unsigned int idx = 0;
+	uint32_t old_attr = 0;
+	vaddr_t v = 0;
+
+	while (va < end) {
+		if (!core_mmu_find_table(NULL, va, UINT_MAX, &tbl_info))
+			goto err;
+		/* The level 1 tables are per CPU with LPAE */
+		if (IS_ENABLED(CFG_WITH_LPAE) && tbl_info.level == 1)
+			goto err;
+
+		idx = core_mmu_va2idx(&tbl_info, va);
+		if (!can_map_at_level(pa, va, end - va, BIT(tbl_info.shift),
+				      mm)) {
+			if (tbl_info.shift == SMALL_PAGE_SHIFT ||
+			    !core_mmu_entry_to_finer_grained(&tbl_info, idx,
+							     secure))
+				goto err;
+			continue;
+		}
+
+		core_mmu_get_entry(&tbl_info, idx, NULL, &old_attr);
+		if (old_attr)
+			panic("Page is already mapped");
+
+		core_mmu_set_entry(&tbl_info, idx, pa, mm->attr);
+		va += BIT(tbl_info.shift);
+		pa += BIT(tbl_info.shift);
+	}
+
+	return true;
+err:
+	for (v = mm->va; v < va; v += BIT(tbl_info.shift)) {
+		if (!core_mmu_find_table(NULL, v, UINT_MAX, &tbl_info))
+			panic("Can't find pagetable");
+		core_mmu_set_entry(&tbl_info, core_mmu_va2idx(&tbl_info, v),
+				   0, 0);
+	}
+	tlbi_all();
+
+	return false;
+}
+
 bool core_mmu_add_mapping(enum teecore_memtypes type, paddr_t addr, size_t len)
 {
-	struct core_mmu_table_info tbl_info;
+	struct tee_mmap_region r = { };
 	struct tee_mmap_region *map;
+	uint32_t exceptions;
+	size_t pad = 0;
 	size_t n;
-	size_t granule;
-	paddr_t p;
-	size_t l;
+	bool mapped;
 
 	if (!len)
 		return true;
@@ -1663,23 +2033,41 @@ bool core_mmu_add_mapping(enum teecore_memtypes type, paddr_t addr, size_t len)
 	if (!map)
 		return false;
 
-	if (!core_mmu_find_table(NULL, map->va, UINT_MAX, &tbl_info))
-		return false;
+	r.type = type;
+	r.attr = core_mmu_type_to_attr(type);
+	r.pa = ROUNDDOWN(addr, SMALL_PAGE_SIZE);
+	r.size = ROUNDUP(len + addr - r.pa, SMALL_PAGE_SIZE);
+	r.region_size = SMALL_PAGE_SIZE;
 
-	granule = 1 << tbl_info.shift;
-	p = ROUNDDOWN(addr, granule);
-	l = ROUNDUP(len + addr - p, granule);
+	/*
+	 * If the range covers at least one pgdir block, pick a va with the
+	 * same offset in a pgdir block as the pa so the aligned part can
+	 * be mapped with block entries. This costs up to a block of the
+	 * reserved va space, if there isn't enough left small pages are
+	 * used instead.
+	 */
+	if (r.size >= CORE_MMU_PGDIR_SIZE &&
+	    ROUNDUP(r.pa, CORE_MMU_PGDIR_SIZE) + CORE_MMU_PGDIR_SIZE <=
+	    r.pa + r.size) {
+		pad = (r.pa - map->va) & CORE_MMU_PGDIR_MASK;
+		if (pad < map->size && r.size <= map->size - pad)
+			r.region_size = CORE_MMU_PGDIR_SIZE;
+		else
+			pad = 0;
+	}
 
 	/* Ban overflowing virtual addresses */
-	if (map->size < l)
+	if (map->size - pad < r.size)
 		return false;
+	r.va = map->va + pad;
 
-	/*
-	 * Something is wrong, we can't fit the va range into the selected
-	 * table. The reserved va range is possibly missaligned with
-	 * granule.
-	 */
-	if (core_mmu_va2idx(&tbl_info, map->va + len) >= tbl_info.num_entries)
+	/* Update TCR_EL1 with possiable maximum physical address change */
+	core_mmu_set_max_pa(r.pa + r.size);
+
+	exceptions = mmu_lock();
+	mapped = map_added_region(&r);
+	mmu_unlock(exceptions);
+	if (!mapped)
 		return false;
 
 	/* Find end of the memory map */
@@ -1689,28 +2077,17 @@ bool core_mmu_add_mapping(enum teecore_memtypes type, paddr_t addr, size_t len)
 
 	if (n < (ARRAY_SIZE(static_memory_map) - 1)) {
 		/* There's room for another entry */
-		static_memory_map[n].va = map->va;
-		static_memory_map[n].size = l;
+		static_memory_map[n] = r;
 		static_memory_map[n + 1].type = MEM_AREA_END;
-		map->va += l;
-		map->size -= l;
-		map = static_memory_map + n;
+		map->va += pad + r.size;
+		map->size -= pad + r.size;
 	} else {
 		/*
 		 * There isn't room for another entry, steal the reserved
 		 * entry as it's not useful for anything else any longer.
 		 */
-		map->size = l;
+		*map = r;
 	}
-	map->type = type;
-	map->region_size = granule;
-	map->attr = core_mmu_type_to_attr(type);
-	map->pa = p;
-
-	/* Update TCR_EL1 with possiable maximum physical address change */
-	core_mmu_set_max_pa(map->pa + map->size);
-
-	set_region(&tbl_info, map);
 
 	/* Make sure the new entry is visible before continuing. */
 	dsb_ishst();
@@ -1736,6 +2113,23 @@ unsigned int asid_alloc(void)
 	return r;
 }
 
+bool core_mmu_user_map_asid_is_stale(unsigned int asid)
+{
+	size_t thread_id = thread_get_id();
+	struct asid_user_map *m = NULL;
+
+	assert(thread_get_exceptions() & THREAD_EXCP_FOREIGN_INTR);
+	assert(asid && !(asid & 1) && (asid - 1) / 2 < MMU_NUM_ASID_PAIRS);
+
+	m = &asid_user_maps[get_core_pos()][(asid - 1) / 2];
+	if (m->thread_id == thread_id && m->gen == user_map_gen[thread_id])
+		return false;
+
+	m->thread_id = thread_id;
+	m->gen = user_map_gen[thread_id];
+	return true;
+}
+
 void asid_free(unsigned int asid)
 {
 	uint32_t exceptions = cpu_spin_lock_xsave(&g_asid_spinlock);
@@ -1789,6 +2183,45 @@ out:
 	return ret;
 }
 
+bool core_mmu_probe_access(vaddr_t va, bool user, bool write)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	uint64_t par = 0;
+
+#ifdef ARM32
+	if (user && write)
+		write_ats1cuw(va);
+	else if (user)
+		write_ats1cur(va);
+	else if (write)
+		write_ats1cpw(va);
+	else
+		write_ats1cpr(va);
+	isb();
+#ifdef CFG_WITH_LPAE
+	par = read_par64();
+#else
+	par = read_par32();
+#endif
+#endif /*ARM32*/
+
+#ifdef ARM64
+	if (user && write)
+		write_at_s1e0w(va);
+	else if (user)
+		write_at_s1e0r(va);
+	else if (write)
+		write_at_s1e1w(va);
+	else
+		write_at_s1e1r(va);
+	isb();
+	par = read_par_el1();
+#endif
+
+	thread_unmask_exceptions(exceptions);
+	return !(par & PAR_F);
+}
+
 #ifdef CFG_WITH_PAGER
 static vaddr_t get_linear_map_end(void)
 {
@@ -1879,11 +2312,32 @@ static void check_pa_matches_va(void *va __unused, paddr_t pa __unused)
 }
 #endif
 
+static bool virt_to_phys_fast(vaddr_t va, paddr_t *pa)
+{
+	const struct va_pa_range *r = NULL;
+
+#ifdef CFG_WITH_PAGER
+	/* The unpaged part of TEE RAM is identity mapped */
+	if (va >= TEE_LOAD_ADDR && va < get_linear_map_end()) {
+		*pa = va;
+		return true;
+	}
+#endif
+
+	r = find_va_pa_by_va(va);
+	if (!r)
+		return false;
+
+	*pa = r->pa + va - r->va;
+	return true;
+}
+
 paddr_t virt_to_phys(void *va)
 {
 	paddr_t pa;
 
-	if (!arm_va2pa_helper(va, &pa))
+	if (!virt_to_phys_fast((vaddr_t)va, &pa) &&
+	    !arm_va2pa_helper(va, &pa))
 		pa = 0;
 	check_pa_matches_va(va, pa);
 	return pa;
@@ -1934,19 +2388,18 @@ static void *phys_to_virt_tee_ram(paddr_t pa)
 #else
 static void *phys_to_virt_tee_ram(paddr_t pa)
 {
-	struct tee_mmap_region *mmap;
+	void *va = pa2va_by_type(MEM_AREA_TEE_RAM, pa);
 
-	mmap = find_map_by_type_and_pa(MEM_AREA_TEE_RAM, pa);
-	if (!mmap)
-		mmap = find_map_by_type_and_pa(MEM_AREA_NEX_RAM_RW, pa);
-	if (!mmap)
-		mmap = find_map_by_type_and_pa(MEM_AREA_TEE_RAM_RW, pa);
-	if (!mmap)
-		mmap = find_map_by_type_and_pa(MEM_AREA_TEE_RAM_RO, pa);
-	if (!mmap)
-		mmap = find_map_by_type_and_pa(MEM_AREA_TEE_RAM_RX, pa);
+	if (!va)
+		va = pa2va_by_type(MEM_AREA_NEX_RAM_RW, pa);
+	if (!va)
+		va = pa2va_by_type(MEM_AREA_TEE_RAM_RW, pa);
+	if (!va)
+		va = pa2va_by_type(MEM_AREA_TEE_RAM_RO, pa);
+	if (!va)
+		va = pa2va_by_type(MEM_AREA_TEE_RAM_RX, pa);
 
-	return map_pa2va(mmap, pa);
+	return va;
 }
 #endif
 
@@ -1970,7 +2423,7 @@ void *phys_to_virt(paddr_t pa, enum teecore_memtypes m)
 		va = NULL;
 		break;
 	default:
-		va = map_pa2va(find_map_by_type_and_pa(m, pa), pa);
+		va = pa2va_by_type(m, pa);
 	}
 	if (m != MEM_AREA_SEC_RAM_OVERALL)
 		check_va_matches_pa(pa, va);
@@ -1979,15 +2432,12 @@ void *phys_to_virt(paddr_t pa, enum teecore_memtypes m)
 
 void *phys_to_virt_io(paddr_t pa)
 {
-	struct tee_mmap_region *map;
-	void *va;
+	void *va = pa2va_by_type(MEM_AREA_IO_SEC, pa);
 
-	map = find_map_by_type_and_pa(MEM_AREA_IO_SEC, pa);
-	if (!map)
-		map = find_map_by_type_and_pa(MEM_AREA_IO_NSEC, pa);
-	if (!map)
+	if (!va)
+		va = pa2va_by_type(MEM_AREA_IO_NSEC, pa);
+	if (!va)
 		return NULL;
-	va = map_pa2va(map, pa);
 	check_va_matches_pa(pa, va);
 	return va;
 }
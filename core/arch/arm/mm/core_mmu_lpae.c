@@ -120,10 +120,12 @@
 
 #define ATTR_DEVICE_INDEX		0x0
 #define ATTR_IWBWA_OWBWA_NTR_INDEX	0x1
+#define ATTR_INC_ONC_INDEX		0x2
 #define ATTR_INDEX_MASK			0x7
 
 #define ATTR_DEVICE			(0x4)
 #define ATTR_IWBWA_OWBWA_NTR		(0xff)
+#define ATTR_INC_ONC			(0x44)
 
 #define MAIR_ATTR_SET(attr, index)	(((uint64_t)attr) << ((index) << 3))
 
@@ -282,6 +284,7 @@ static uint32_t desc_to_mattr(unsigned level, uint64_t desc)
 	COMPILE_TIME_ASSERT(ATTR_DEVICE_INDEX == TEE_MATTR_CACHE_NONCACHE);
 	COMPILE_TIME_ASSERT(ATTR_IWBWA_OWBWA_NTR_INDEX ==
 			    TEE_MATTR_CACHE_CACHED);
+	COMPILE_TIME_ASSERT(ATTR_INC_ONC_INDEX == TEE_MATTR_CACHE_WC);
 
 	a |= ((desc & LOWER_ATTRS(ATTR_INDEX_MASK)) >> LOWER_ATTRS_SHIFT) <<
 	     TEE_MATTR_CACHE_SHIFT;
@@ -324,6 +327,8 @@ static uint64_t mattr_to_desc(unsigned level, uint32_t attr)
 		desc |= UPPER_ATTRS(XN);
 	if (!(a & TEE_MATTR_PX))
 		desc |= UPPER_ATTRS(PXN);
+	if (a & TEE_MATTR_CONTIG)
+		desc |= UPPER_ATTRS(CONT_HINT);
 
 	if (a & TEE_MATTR_UR)
 		desc |= LOWER_ATTRS(AP_UNPRIV);
@@ -339,6 +344,9 @@ static uint64_t mattr_to_desc(unsigned level, uint32_t attr)
 	case TEE_MATTR_CACHE_CACHED:
 		desc |= LOWER_ATTRS(ATTR_IWBWA_OWBWA_NTR_INDEX | ISH);
 		break;
+	case TEE_MATTR_CACHE_WC:
+		desc |= LOWER_ATTRS(ATTR_INC_ONC_INDEX | OSH);
+		break;
 	default:
 		/*
 		 * "Can't happen" the attribute is supposed to be checked
@@ -412,6 +420,8 @@ struct mmu_partition *core_alloc_mmu_prtn(void *tables)
 
 void core_free_mmu_prtn(struct mmu_partition *prtn)
 {
+	/* clear MMU entries to avoid clash when asid is reused */
+	tlbi_asid(prtn->asid);
 	asid_free(prtn->asid);
 	nex_free(prtn);
 }
@@ -429,9 +439,15 @@ void core_mmu_set_prtn(struct mmu_partition *prtn)
 
 	ttbr = virt_to_phys(prtn->l1_tables[0][get_core_pos()]);
 
+	/*
+	 * Core mappings are non-global and each partition has its own
+	 * ASID, TLB entries of other partitions can't be hit so there's
+	 * no need to invalidate the TLB. The ASID of a partition is only
+	 * reused after its entries have been invalidated in
+	 * core_free_mmu_prtn().
+	 */
 	write_ttbr0_el1(ttbr | ((paddr_t)prtn->asid << TTBR_ASID_SHIFT));
 	isb();
-	tlbi_all();
 }
 
 void core_mmu_set_default_prtn(void)
@@ -539,6 +555,7 @@ void core_init_mmu_regs(void)
 
 	mair  = MAIR_ATTR_SET(ATTR_DEVICE, ATTR_DEVICE_INDEX);
 	mair |= MAIR_ATTR_SET(ATTR_IWBWA_OWBWA_NTR, ATTR_IWBWA_OWBWA_NTR_INDEX);
+	mair |= MAIR_ATTR_SET(ATTR_INC_ONC, ATTR_INC_ONC_INDEX);
 	write_mair0(mair);
 
 	ttbcr |= TTBCR_XRGNX_WBWA << TTBCR_IRGN0_SHIFT;
@@ -597,6 +614,7 @@ void core_init_mmu_regs(void)
 
 	mair  = MAIR_ATTR_SET(ATTR_DEVICE, ATTR_DEVICE_INDEX);
 	mair |= MAIR_ATTR_SET(ATTR_IWBWA_OWBWA_NTR, ATTR_IWBWA_OWBWA_NTR_INDEX);
+	mair |= MAIR_ATTR_SET(ATTR_INC_ONC, ATTR_INC_ONC_INDEX);
 	write_mair_el1(mair);
 
 	tcr = TCR_RES1;
@@ -883,8 +901,12 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 	assert(user_va_idx != -1);
 
 	ttbr = read_ttbr0_64bit();
-	/* Clear ASID */
+	/*
+	 * Fall back to the ASID of the partition, the core mappings of
+	 * the partition must not be cached with the ASID of another one.
+	 */
 	ttbr &= ~((uint64_t)TTBR_ASID_MASK << TTBR_ASID_SHIFT);
+	ttbr |= (uint64_t)prtn->asid << TTBR_ASID_SHIFT;
 	write_ttbr0_64bit(ttbr);
 	isb();
 
@@ -897,6 +919,9 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 			map->user_map;
 #endif
 		dsb();	/* Make sure the write above is visible */
+		if (core_mmu_user_map_asid_is_stale(map->asid))
+			tlbi_asid(map->asid);
+		ttbr &= ~((uint64_t)TTBR_ASID_MASK << TTBR_ASID_SHIFT);
 		ttbr |= ((uint64_t)map->asid << TTBR_ASID_SHIFT);
 		write_ttbr0_64bit(ttbr);
 		isb();
@@ -906,9 +931,9 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 		prtn->l1_tables[1][get_core_pos()][user_va_idx] = 0;
 #endif
 		dsb();	/* Make sure the write above is visible */
+		isb();
 	}
 
-	tlbi_all();
 	icache_inv_all();
 
 	thread_unmask_exceptions(exceptions);
@@ -967,8 +992,12 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 	struct mmu_partition *prtn = get_prtn();
 
 	ttbr = read_ttbr0_el1();
-	/* Clear ASID */
+	/*
+	 * Fall back to the ASID of the partition, the core mappings of
+	 * the partition must not be cached with the ASID of another one.
+	 */
 	ttbr &= ~((uint64_t)TTBR_ASID_MASK << TTBR_ASID_SHIFT);
+	ttbr |= (uint64_t)prtn->asid << TTBR_ASID_SHIFT;
 	write_ttbr0_el1(ttbr);
 	isb();
 
@@ -981,6 +1010,9 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 			map->user_map;
 #endif
 		dsb();	/* Make sure the write above is visible */
+		if (core_mmu_user_map_asid_is_stale(map->asid))
+			tlbi_asid(map->asid);
+		ttbr &= ~((uint64_t)TTBR_ASID_MASK << TTBR_ASID_SHIFT);
 		ttbr |= ((uint64_t)map->asid << TTBR_ASID_SHIFT);
 		write_ttbr0_el1(ttbr);
 		isb();
@@ -990,9 +1022,9 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 		prtn->l1_tables[1][get_core_pos()][user_va_idx] = 0;
 #endif
 		dsb();	/* Make sure the write above is visible */
+		isb();
 	}
 
-	tlbi_all();
 	icache_inv_all();
 
 	thread_unmask_exceptions(exceptions);
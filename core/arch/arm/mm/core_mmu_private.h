@@ -15,6 +15,14 @@ void core_mmu_set_info_table(struct core_mmu_table_info *tbl_info,
 			     unsigned level, vaddr_t va_base, void *table);
 void core_mmu_populate_user_map(struct core_mmu_table_info *dir_info,
 				struct user_ta_ctx *utc);
+/*
+ * Returns true if TLB entries tagged with @asid on this core may be stale
+ * when the user map of the current thread is activated with @asid, that
+ * is, unless the same generation of these translation tables was the last
+ * one used with @asid on this core. Records the tables as the last ones.
+ * Must be called with exceptions masked.
+ */
+bool core_mmu_user_map_asid_is_stale(unsigned int asid);
 void core_mmu_map_region(struct mmu_partition *prtn,
 			 struct tee_mmap_region *mm);
 
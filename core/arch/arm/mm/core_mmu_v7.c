@@ -126,6 +126,7 @@
 /* The TEX, C and B bits concatenated */
 #define ATTR_DEVICE_INDEX		0x0
 #define ATTR_NORMAL_CACHED_INDEX	0x1
+#define ATTR_NORMAL_NC_INDEX		0x2
 
 #define PRRR_IDX(idx, tr, nos)		(((tr) << (2 * (idx))) | \
 					 ((uint32_t)(nos) << ((idx) + 24)))
@@ -147,6 +148,9 @@
 #define ATTR_NORMAL_CACHED_NMRR		NMRR_IDX(ATTR_NORMAL_CACHED_INDEX, 3, 3)
 #endif
 
+#define ATTR_NORMAL_NC_PRRR		PRRR_IDX(ATTR_NORMAL_NC_INDEX, 2, 0)
+#define ATTR_NORMAL_NC_NMRR		NMRR_IDX(ATTR_NORMAL_NC_INDEX, 0, 0)
+
 #define NUM_L1_ENTRIES		4096
 #define NUM_L2_ENTRIES		256
 
@@ -308,6 +312,7 @@ static uint32_t texcb_to_mattr(uint32_t texcb)
 {
 	COMPILE_TIME_ASSERT(ATTR_DEVICE_INDEX == TEE_MATTR_CACHE_NONCACHE);
 	COMPILE_TIME_ASSERT(ATTR_NORMAL_CACHED_INDEX == TEE_MATTR_CACHE_CACHED);
+	COMPILE_TIME_ASSERT(ATTR_NORMAL_NC_INDEX == TEE_MATTR_CACHE_WC);
 
 	return texcb << TEE_MATTR_CACHE_SHIFT;
 }
@@ -661,6 +666,8 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 	isb();
 
 	if (map) {
+		if (core_mmu_user_map_asid_is_stale(map->ctxid))
+			tlbi_asid(map->ctxid);
 		write_ttbr0(map->ttbr0);
 		isb();
 		write_contextidr(map->ctxid);
@@ -670,7 +677,6 @@ void core_mmu_set_user_map(struct core_mmu_user_map *map)
 		isb();
 	}
 
-	tlbi_all();
 	icache_inv_all();
 
 	/* Restore interrupts */
@@ -778,8 +784,8 @@ void core_init_mmu_regs(void)
 	/* Enable Access flag (simplified access permissions) and TEX remap */
 	write_sctlr(read_sctlr() | SCTLR_AFE | SCTLR_TRE);
 
-	prrr = ATTR_DEVICE_PRRR | ATTR_NORMAL_CACHED_PRRR;
-	nmrr = ATTR_DEVICE_NMRR | ATTR_NORMAL_CACHED_NMRR;
+	prrr = ATTR_DEVICE_PRRR | ATTR_NORMAL_CACHED_PRRR | ATTR_NORMAL_NC_PRRR;
+	nmrr = ATTR_DEVICE_NMRR | ATTR_NORMAL_CACHED_NMRR | ATTR_NORMAL_NC_NMRR;
 
 	prrr |= PRRR_NS1 | PRRR_DS1;
 
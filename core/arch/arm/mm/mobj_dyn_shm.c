@@ -34,13 +34,16 @@ static size_t shm_release_waiters;
 struct mobj_reg_shm {
 	struct mobj mobj;
 	SLIST_ENTRY(mobj_reg_shm) next;
+	TAILQ_ENTRY(mobj_reg_shm) idle_link;
 	uint64_t cookie;
 	tee_mm_entry_t *mm;
 	paddr_t page_offset;
 	struct refcount refcount;
 	struct refcount mapcount;
 	int num_pages;
+	uint32_t cattr;
 	bool guarded;
+	bool idle;
 	paddr_t pages[];
 };
 
@@ -55,12 +58,41 @@ static size_t mobj_reg_shm_size(size_t nr_pages)
 	return s;
 }
 
-static SLIST_HEAD(reg_shm_head, mobj_reg_shm) reg_shm_list =
-	SLIST_HEAD_INITIALIZER(reg_shm_head);
+/*
+ * Registered shared memory objects are hashed on their cookie. Each bucket
+ * has its own lock protecting the list, the refcount and the guarded
+ * flag of its objects.
+ */
+#define REG_SHM_HASH_BUCKETS	64
+
+struct reg_shm_bucket {
+	SLIST_HEAD(reg_shm_head, mobj_reg_shm) list;
+	unsigned int lock;
+};
 
-static unsigned int reg_shm_slist_lock = SPINLOCK_UNLOCK;
+static struct reg_shm_bucket reg_shm_buckets[REG_SHM_HASH_BUCKETS];
+
+/*
+ * A mapping isn't removed when the map count of its object drops to zero,
+ * instead the object is added last in reg_shm_idle. If the object is
+ * mapped again the mapping is reused as is, if tee_mm_shm runs out of
+ * space the mappings of the objects first in reg_shm_idle are removed.
+ * reg_shm_map_lock protects the mm field, the idle flag and
+ * reg_shm_idle.
+ */
+static TAILQ_HEAD(reg_shm_idle_head, mobj_reg_shm) reg_shm_idle =
+	TAILQ_HEAD_INITIALIZER(reg_shm_idle);
 static unsigned int reg_shm_map_lock = SPINLOCK_UNLOCK;
 
+static struct reg_shm_bucket *reg_shm_bucket(uint64_t cookie)
+{
+	uint64_t h = cookie * 0x9e3779b97f4a7c15ULL;
+
+	COMPILE_TIME_ASSERT(IS_POWER_OF_TWO(REG_SHM_HASH_BUCKETS));
+
+	return reg_shm_buckets + (h >> 32) % REG_SHM_HASH_BUCKETS;
+}
+
 static struct mobj_reg_shm *to_mobj_reg_shm(struct mobj *mobj);
 
 static TEE_Result mobj_reg_shm_get_pa(struct mobj *mobj, size_t offst,
@@ -112,9 +144,12 @@ static void *mobj_reg_shm_get_va(struct mobj *mobj, size_t offst)
 				 mrs->page_offset);
 }
 
-static void reg_shm_unmap_helper(struct mobj_reg_shm *r)
+static void reg_shm_unmap_locked(struct mobj_reg_shm *r)
 {
-	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_map_lock);
+	if (r->idle) {
+		TAILQ_REMOVE(&reg_shm_idle, r, idle_link);
+		r->idle = false;
+	}
 
 	if (r->mm) {
 		core_mmu_unmap_pages(tee_mm_get_smem(r->mm),
@@ -122,14 +157,34 @@ static void reg_shm_unmap_helper(struct mobj_reg_shm *r)
 		tee_mm_free(r->mm);
 		r->mm = NULL;
 	}
+}
+
+static void reg_shm_unmap_helper(struct mobj_reg_shm *r)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_map_lock);
 
+	reg_shm_unmap_locked(r);
 	cpu_spin_unlock_xrestore(&reg_shm_map_lock, exceptions);
 }
 
+/* Removes the least recently used idle mapping, false if there's none */
+static bool reg_shm_reclaim_idle_locked(void)
+{
+	struct mobj_reg_shm *r = TAILQ_FIRST(&reg_shm_idle);
+
+	if (!r)
+		return false;
+
+	reg_shm_unmap_locked(r);
+	return true;
+}
+
 static void reg_shm_free_helper(struct mobj_reg_shm *mobj_reg_shm)
 {
+	struct reg_shm_bucket *b = reg_shm_bucket(mobj_reg_shm->cookie);
+
 	reg_shm_unmap_helper(mobj_reg_shm);
-	SLIST_REMOVE(&reg_shm_list, mobj_reg_shm, mobj_reg_shm, next);
+	SLIST_REMOVE(&b->list, mobj_reg_shm, mobj_reg_shm, next);
 	free(mobj_reg_shm);
 }
 
@@ -138,13 +193,14 @@ static void mobj_reg_shm_free(struct mobj *mobj)
 	mobj_reg_shm_put(mobj);
 }
 
-static TEE_Result mobj_reg_shm_get_cattr(struct mobj *mobj __unused,
-					 uint32_t *cattr)
+static struct mobj_reg_shm *to_mobj_reg_shm(struct mobj *mobj);
+
+static TEE_Result mobj_reg_shm_get_cattr(struct mobj *mobj, uint32_t *cattr)
 {
 	if (!cattr)
 		return TEE_ERROR_GENERIC;
 
-	*cattr = TEE_MATTR_CACHE_CACHED;
+	*cattr = to_mobj_reg_shm(mobj)->cattr;
 
 	return TEE_SUCCESS;
 }
@@ -188,15 +244,50 @@ static struct mobj_reg_shm *to_mobj_reg_shm_may_fail(struct mobj *mobj)
 	return container_of(mobj, struct mobj_reg_shm, mobj);
 }
 
+/*
+ * Returns true if the pages are page aligned and in non-secure memory.
+ * Physically contiguous runs of pages are checked at once, buffers of
+ * normal world are usually made of a few large runs.
+ */
+static bool pages_are_non_sec(const paddr_t *pages, size_t num_pages)
+{
+	size_t i = 0;
+	size_t n = 0;
+	size_t m = 0;
+
+	for (i = 0; i < num_pages; i += n) {
+		if (pages[i] & SMALL_PAGE_MASK)
+			return false;
+
+		for (n = 1; i + n < num_pages; n++)
+			if (pages[i + n] != pages[i] + n * SMALL_PAGE_SIZE)
+				break;
+
+		if (core_pbuf_is(CORE_MEM_NON_SEC, pages[i],
+				 n * SMALL_PAGE_SIZE))
+			continue;
+
+		/* The run may span adjacent non-secure areas */
+		for (m = 0; m < n; m++)
+			if (!core_pbuf_is(CORE_MEM_NON_SEC, pages[i + m],
+					  SMALL_PAGE_SIZE))
+				return false;
+	}
+
+	return true;
+}
+
 struct mobj *mobj_reg_shm_alloc(paddr_t *pages, size_t num_pages,
-				paddr_t page_offset, uint64_t cookie)
+				paddr_t page_offset, uint64_t cookie,
+				uint32_t cattr)
 {
 	struct mobj_reg_shm *mobj_reg_shm = NULL;
-	size_t i = 0;
+	struct reg_shm_bucket *b = reg_shm_bucket(cookie);
 	uint32_t exceptions = 0;
 	size_t s = 0;
 
-	if (!num_pages)
+	if (!num_pages ||
+	    (cattr != TEE_MATTR_CACHE_CACHED && cattr != TEE_MATTR_CACHE_WC))
 		return NULL;
 
 	s = mobj_reg_shm_size(num_pages);
@@ -212,24 +303,18 @@ struct mobj *mobj_reg_shm_alloc(paddr_t *pages, size_t num_pages,
 	mobj_reg_shm->cookie = cookie;
 	mobj_reg_shm->guarded = true;
 	mobj_reg_shm->num_pages = num_pages;
+	mobj_reg_shm->cattr = cattr;
 	mobj_reg_shm->page_offset = page_offset;
 	memcpy(mobj_reg_shm->pages, pages, sizeof(*pages) * num_pages);
 	refcount_set(&mobj_reg_shm->refcount, 1);
 
 	/* Ensure loaded references match format and security constraints */
-	for (i = 0; i < num_pages; i++) {
-		if (mobj_reg_shm->pages[i] & SMALL_PAGE_MASK)
-			goto err;
-
-		/* Only Non-secure memory can be mapped there */
-		if (!core_pbuf_is(CORE_MEM_NON_SEC, mobj_reg_shm->pages[i],
-				  SMALL_PAGE_SIZE))
-			goto err;
-	}
+	if (!pages_are_non_sec(mobj_reg_shm->pages, num_pages))
+		goto err;
 
-	exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
-	SLIST_INSERT_HEAD(&reg_shm_list, mobj_reg_shm, next);
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	exceptions = cpu_spin_lock_xsave(&b->lock);
+	SLIST_INSERT_HEAD(&b->list, mobj_reg_shm, next);
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 
 	return &mobj_reg_shm->mobj;
 err:
@@ -239,17 +324,20 @@ err:
 
 void mobj_reg_shm_unguard(struct mobj *mobj)
 {
-	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+	struct mobj_reg_shm *r = to_mobj_reg_shm(mobj);
+	struct reg_shm_bucket *b = reg_shm_bucket(r->cookie);
+	uint32_t exceptions = cpu_spin_lock_xsave(&b->lock);
 
-	to_mobj_reg_shm(mobj)->guarded = false;
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	r->guarded = false;
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 }
 
-static struct mobj_reg_shm *reg_shm_find_unlocked(uint64_t cookie)
+static struct mobj_reg_shm *reg_shm_find_unlocked(struct reg_shm_bucket *b,
+						  uint64_t cookie)
 {
 	struct mobj_reg_shm *mobj_reg_shm = NULL;
 
-	SLIST_FOREACH(mobj_reg_shm, &reg_shm_list, next)
+	SLIST_FOREACH(mobj_reg_shm, &b->list, next)
 		if (mobj_reg_shm->cookie == cookie)
 			return mobj_reg_shm;
 
@@ -258,8 +346,9 @@ static struct mobj_reg_shm *reg_shm_find_unlocked(uint64_t cookie)
 
 struct mobj *mobj_reg_shm_get_by_cookie(uint64_t cookie)
 {
-	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
-	struct mobj_reg_shm *r = reg_shm_find_unlocked(cookie);
+	struct reg_shm_bucket *b = reg_shm_bucket(cookie);
+	uint32_t exceptions = cpu_spin_lock_xsave(&b->lock);
+	struct mobj_reg_shm *r = reg_shm_find_unlocked(b, cookie);
 
 	if (r) {
 		/*
@@ -270,7 +359,7 @@ struct mobj *mobj_reg_shm_get_by_cookie(uint64_t cookie)
 			panic();
 	}
 
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 
 	if (r)
 		return &r->mobj;
@@ -281,7 +370,8 @@ struct mobj *mobj_reg_shm_get_by_cookie(uint64_t cookie)
 void mobj_reg_shm_put(struct mobj *mobj)
 {
 	struct mobj_reg_shm *r = to_mobj_reg_shm(mobj);
-	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+	struct reg_shm_bucket *b = reg_shm_bucket(r->cookie);
+	uint32_t exceptions = cpu_spin_lock_xsave(&b->lock);
 
 	/*
 	 * A put is supposed to match a get or the initial alloc, once
@@ -291,7 +381,7 @@ void mobj_reg_shm_put(struct mobj *mobj)
 	if (refcount_dec(&r->refcount))
 		reg_shm_free_helper(r);
 
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 
 	/*
 	 * Note that we're reading this mutex protected variable without the
@@ -309,8 +399,9 @@ void mobj_reg_shm_put(struct mobj *mobj)
 static TEE_Result try_release_reg_shm(uint64_t cookie)
 {
 	TEE_Result res = TEE_ERROR_BAD_PARAMETERS;
-	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
-	struct mobj_reg_shm *r = reg_shm_find_unlocked(cookie);
+	struct reg_shm_bucket *b = reg_shm_bucket(cookie);
+	uint32_t exceptions = cpu_spin_lock_xsave(&b->lock);
+	struct mobj_reg_shm *r = reg_shm_find_unlocked(b, cookie);
 
 	if (!r || r->guarded)
 		goto out;
@@ -321,7 +412,7 @@ static TEE_Result try_release_reg_shm(uint64_t cookie)
 		res = TEE_SUCCESS;
 	}
 out:
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 
 	return res;
 }
@@ -367,14 +458,31 @@ TEE_Result mobj_reg_shm_inc_map(struct mobj *mobj)
 	if (refcount_val(&r->mapcount))
 		goto out;
 
-	r->mm = tee_mm_alloc(&tee_mm_shm, SMALL_PAGE_SIZE * r->num_pages);
-	if (!r->mm) {
-		res = TEE_ERROR_OUT_OF_MEMORY;
+	if (r->mm) {
+		/* Still mapped since last use */
+		if (r->idle) {
+			TAILQ_REMOVE(&reg_shm_idle, r, idle_link);
+			r->idle = false;
+		}
+		refcount_set(&r->mapcount, 1);
 		goto out;
 	}
 
-	res = core_mmu_map_pages(tee_mm_get_smem(r->mm), r->pages,
-				 r->num_pages, MEM_AREA_NSEC_SHM);
+	while (true) {
+		r->mm = tee_mm_alloc(&tee_mm_shm,
+				     SMALL_PAGE_SIZE * r->num_pages);
+		if (r->mm)
+			break;
+		if (!reg_shm_reclaim_idle_locked()) {
+			res = TEE_ERROR_OUT_OF_MEMORY;
+			goto out;
+		}
+	}
+
+	/* Mapped as normal world mapped it to avoid mismatched aliases */
+	res = core_mmu_map_pages_cattr(tee_mm_get_smem(r->mm), r->pages,
+				       r->num_pages, MEM_AREA_NSEC_SHM,
+				       r->cattr);
 	if (res) {
 		tee_mm_free(r->mm);
 		r->mm = NULL;
@@ -400,11 +508,10 @@ TEE_Result mobj_reg_shm_dec_map(struct mobj *mobj)
 
 	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_map_lock);
 
-	if (refcount_val(&r->mapcount)) {
-		core_mmu_unmap_pages(tee_mm_get_smem(r->mm),
-				     r->mobj.size / SMALL_PAGE_SIZE);
-		tee_mm_free(r->mm);
-		r->mm = NULL;
+	/* Keep the mapping unless the object has been mapped again */
+	if (!refcount_val(&r->mapcount) && r->mm && !r->idle) {
+		TAILQ_INSERT_TAIL(&reg_shm_idle, r, idle_link);
+		r->idle = true;
 	}
 
 	cpu_spin_unlock_xrestore(&reg_shm_map_lock, exceptions);
@@ -417,7 +524,8 @@ struct mobj *mobj_mapped_shm_alloc(paddr_t *pages, size_t num_pages,
 				  paddr_t page_offset, uint64_t cookie)
 {
 	struct mobj *mobj = mobj_reg_shm_alloc(pages, num_pages,
-					       page_offset, cookie);
+					       page_offset, cookie,
+					       TEE_MATTR_CACHE_CACHED);
 
 	if (!mobj)
 		return NULL;
@@ -430,6 +538,22 @@ struct mobj *mobj_mapped_shm_alloc(paddr_t *pages, size_t num_pages,
 	return mobj;
 }
 
+tee_mm_entry_t *mobj_mapped_shm_alloc_va(size_t num_pages)
+{
+	tee_mm_entry_t *mm = NULL;
+	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_map_lock);
+
+	while (true) {
+		mm = tee_mm_alloc(&tee_mm_shm, SMALL_PAGE_SIZE * num_pages);
+		if (mm || !reg_shm_reclaim_idle_locked())
+			break;
+	}
+
+	cpu_spin_unlock_xrestore(&reg_shm_map_lock, exceptions);
+
+	return mm;
+}
+
 static TEE_Result mobj_mapped_shm_init(void)
 {
 	vaddr_t pool_start = 0;
@@ -0,0 +1,320 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <assert.h>
+#include <initcall.h>
+#include <kernel/mutex.h>
+#include <kernel/panic.h>
+#include <kernel/refcount.h>
+#include <mm/core_mmu.h>
+#include <mm/mobj.h>
+#include <mm/tee_mm.h>
+#include <stdlib.h>
+#include <sys/queue.h>
+#include <trace.h>
+#include <util.h>
+
+/*
+ * Contiguous buffers allocated from the Secure Data Path carve-outs on
+ * request of normal world, which names them with a cookie it supplies.
+ *
+ * Sizes are rounded up to a size class, small buffers to a number of
+ * pages and larger ones in four steps per power of two, so that released
+ * buffers can be handed out again as is. Released buffers are kept idle
+ * until a buffer of the same class is requested or the carve-outs are
+ * exhausted, a pipeline allocating the same frame sizes over and over
+ * ends up recycling the same buffers.
+ *
+ * The content of a recycled buffer isn't cleared, the carve-outs may not
+ * be mapped in core and the buffers are only accessible to TAs flagged
+ * with TA_FLAG_SECURE_DATA_PATH.
+ */
+
+struct mobj_sdp_pool {
+	struct mobj mobj;
+	tee_mm_entry_t *mm;
+	uint64_t cookie;
+	bool released;
+	struct refcount refcount;
+	TAILQ_ENTRY(mobj_sdp_pool) link;
+};
+
+static TAILQ_HEAD(sdp_pool_head, mobj_sdp_pool) sdp_pool_used =
+	TAILQ_HEAD_INITIALIZER(sdp_pool_used);
+static struct sdp_pool_head sdp_pool_idle =
+	TAILQ_HEAD_INITIALIZER(sdp_pool_idle);
+static struct mutex sdp_pool_mu = MUTEX_INITIALIZER;
+
+static tee_mm_pool_t *sdp_pool_mm;
+static size_t sdp_pool_num_mm;
+
+static const struct mobj_ops mobj_sdp_pool_ops;
+
+static struct mobj_sdp_pool *to_mobj_sdp_pool(struct mobj *mobj)
+{
+	assert(mobj->ops == &mobj_sdp_pool_ops);
+	return container_of(mobj, struct mobj_sdp_pool, mobj);
+}
+
+static TEE_Result mobj_sdp_pool_get_pa(struct mobj *mobj, size_t offs,
+				       size_t granule, paddr_t *pa)
+{
+	struct mobj_sdp_pool *m = to_mobj_sdp_pool(mobj);
+	paddr_t p = 0;
+
+	if (!pa || offs >= mobj->size)
+		return TEE_ERROR_GENERIC;
+
+	p = tee_mm_get_smem(m->mm) + offs;
+	if (granule) {
+		if (granule != SMALL_PAGE_SIZE &&
+		    granule != CORE_MMU_PGDIR_SIZE)
+			return TEE_ERROR_GENERIC;
+		p &= ~(granule - 1);
+	}
+
+	*pa = p;
+	return TEE_SUCCESS;
+}
+
+static TEE_Result mobj_sdp_pool_get_cattr(struct mobj *mobj __unused,
+					  uint32_t *cattr)
+{
+	if (!cattr)
+		return TEE_ERROR_GENERIC;
+
+	*cattr = TEE_MATTR_CACHE_CACHED;
+	return TEE_SUCCESS;
+}
+
+static bool mobj_sdp_pool_matches(struct mobj *mobj __unused,
+				  enum buf_is_attr attr)
+{
+	return attr == CORE_MEM_SEC || attr == CORE_MEM_SDP_MEM;
+}
+
+static uint64_t mobj_sdp_pool_get_cookie(struct mobj *mobj)
+{
+	return to_mobj_sdp_pool(mobj)->cookie;
+}
+
+/* Drops a reference, the last one moves the buffer to the idle list */
+static void mobj_sdp_pool_free(struct mobj *mobj)
+{
+	struct mobj_sdp_pool *m = to_mobj_sdp_pool(mobj);
+
+	if (!refcount_dec(&m->refcount))
+		return;
+
+	mutex_lock(&sdp_pool_mu);
+	/* Guard against the buffer having been looked up again */
+	if (!refcount_val(&m->refcount)) {
+		TAILQ_REMOVE(&sdp_pool_used, m, link);
+		TAILQ_INSERT_HEAD(&sdp_pool_idle, m, link);
+	}
+	mutex_unlock(&sdp_pool_mu);
+}
+
+static const struct mobj_ops mobj_sdp_pool_ops = {
+	.get_pa = mobj_sdp_pool_get_pa,
+	.get_cattr = mobj_sdp_pool_get_cattr,
+	.matches = mobj_sdp_pool_matches,
+	.free = mobj_sdp_pool_free,
+	.get_cookie = mobj_sdp_pool_get_cookie,
+};
+
+bool mobj_is_sdp_pool(struct mobj *mobj)
+{
+	return mobj && mobj->ops == &mobj_sdp_pool_ops;
+}
+
+/* Returns @size rounded up to its size class, 0 on overflow */
+static size_t size_class(size_t size)
+{
+	size_t pages = ROUNDUP(size, SMALL_PAGE_SIZE) / SMALL_PAGE_SIZE;
+	size_t step = 0;
+
+	if (!pages)
+		return 0;
+	if (pages > 4) {
+		step = BIT(sizeof(long) * 8 - __builtin_clzl(pages - 1) - 3);
+		pages = ROUNDUP(pages, step);
+	}
+	if (MUL_OVERFLOW(pages, SMALL_PAGE_SIZE, &size))
+		return 0;
+
+	return size;
+}
+
+static struct mobj_sdp_pool *find_unlocked(struct sdp_pool_head *head,
+					   uint64_t cookie)
+{
+	struct mobj_sdp_pool *m = NULL;
+
+	TAILQ_FOREACH(m, head, link)
+		if (m->cookie == cookie && !m->released)
+			return m;
+
+	return NULL;
+}
+
+static void free_idle_unlocked(void)
+{
+	struct mobj_sdp_pool *m = NULL;
+
+	while ((m = TAILQ_FIRST(&sdp_pool_idle))) {
+		TAILQ_REMOVE(&sdp_pool_idle, m, link);
+		tee_mm_free(m->mm);
+		free(m);
+	}
+}
+
+static tee_mm_entry_t *alloc_mm_unlocked(size_t size)
+{
+	tee_mm_entry_t *mm = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < sdp_pool_num_mm; n++) {
+		mm = tee_mm_alloc(sdp_pool_mm + n, size);
+		if (mm)
+			return mm;
+	}
+
+	return NULL;
+}
+
+static struct mobj_sdp_pool *alloc_unlocked(size_t size)
+{
+	struct mobj_sdp_pool *m = NULL;
+	tee_mm_entry_t *mm = NULL;
+
+	TAILQ_FOREACH(m, &sdp_pool_idle, link) {
+		if (m->mobj.size == size) {
+			TAILQ_REMOVE(&sdp_pool_idle, m, link);
+			return m;
+		}
+	}
+
+	mm = alloc_mm_unlocked(size);
+	if (!mm && !TAILQ_EMPTY(&sdp_pool_idle)) {
+		/* The idle buffers may be of the wrong classes */
+		free_idle_unlocked();
+		mm = alloc_mm_unlocked(size);
+	}
+	if (!mm)
+		return NULL;
+
+	m = calloc(1, sizeof(*m));
+	if (!m) {
+		tee_mm_free(mm);
+		return NULL;
+	}
+	m->mobj.ops = &mobj_sdp_pool_ops;
+	m->mobj.size = size;
+	m->mobj.phys_granule = 0;
+	m->mm = mm;
+
+	return m;
+}
+
+struct mobj *mobj_sdp_pool_alloc(size_t size, uint64_t cookie)
+{
+	struct mobj_sdp_pool *m = NULL;
+	struct mobj *mobj = NULL;
+
+	size = size_class(size);
+	if (!size)
+		return NULL;
+
+	/* The cookie must not already name a buffer */
+	mobj = mobj_reg_shm_get_by_cookie(cookie);
+	if (mobj) {
+		mobj_reg_shm_put(mobj);
+		return NULL;
+	}
+
+	mutex_lock(&sdp_pool_mu);
+
+	if (find_unlocked(&sdp_pool_used, cookie))
+		goto out;
+
+	m = alloc_unlocked(size);
+	if (!m)
+		goto out;
+
+	m->cookie = cookie;
+	m->released = false;
+	refcount_set(&m->refcount, 1);
+	TAILQ_INSERT_TAIL(&sdp_pool_used, m, link);
+out:
+	mutex_unlock(&sdp_pool_mu);
+
+	if (!m)
+		return NULL;
+	return &m->mobj;
+}
+
+struct mobj *mobj_sdp_pool_get_by_cookie(uint64_t cookie)
+{
+	struct mobj_sdp_pool *m = NULL;
+
+	mutex_lock(&sdp_pool_mu);
+	m = find_unlocked(&sdp_pool_used, cookie);
+	if (m && !refcount_inc(&m->refcount)) {
+		/* Last reference just dropped, it's about to be idle */
+		m = NULL;
+	}
+	mutex_unlock(&sdp_pool_mu);
+
+	if (!m)
+		return NULL;
+	return &m->mobj;
+}
+
+TEE_Result mobj_sdp_pool_release_by_cookie(uint64_t cookie)
+{
+	struct mobj_sdp_pool *m = NULL;
+
+	/* The cookie can't be used again, nor released twice */
+	mutex_lock(&sdp_pool_mu);
+	m = find_unlocked(&sdp_pool_used, cookie);
+	if (m)
+		m->released = true;
+	mutex_unlock(&sdp_pool_mu);
+
+	if (!m)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+
+	/* Drop the reference of normal world */
+	mobj_free(&m->mobj);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result mobj_sdp_pool_init(void)
+{
+	const struct core_mmu_phys_mem *mem = NULL;
+	size_t n = phys_sdp_mem_end - phys_sdp_mem_begin;
+
+	if (!n)
+		return TEE_SUCCESS;
+
+	sdp_pool_mm = calloc(n, sizeof(*sdp_pool_mm));
+	if (!sdp_pool_mm)
+		panic("Out of memory");
+
+	for (mem = phys_sdp_mem_begin; mem < phys_sdp_mem_end; mem++) {
+		if (!tee_mm_init(sdp_pool_mm + sdp_pool_num_mm, mem->addr,
+				 mem->addr + mem->size, SMALL_PAGE_SHIFT,
+				 TEE_MM_POOL_NO_FLAGS))
+			panic("Failed to init SDP pool");
+		sdp_pool_num_mm++;
+	}
+
+	DMSG("SDP pool: %zu carve-outs", sdp_pool_num_mm);
+
+	return TEE_SUCCESS;
+}
+service_init(mobj_sdp_pool_init);
@@ -4,6 +4,7 @@
  */
 
 #include <assert.h>
+#include <kernel/misc.h>
 #include <kernel/mutex.h>
 #include <kernel/tee_misc.h>
 #include <mm/core_mmu.h>
@@ -51,9 +52,11 @@ static struct pgt_cache pgt_free_list = SLIST_HEAD_INITIALIZER(pgt_free_list);
  * When a user TA context is temporarily unmapped the used struct pgt's of
  * the context (page tables holding valid physical pages) are saved in this
  * cache in the hope that some of the valid physical pages may still be
- * valid when the context is mapped again.
+ * valid when the context is mapped again. The most recently saved tables
+ * are first in the list.
  */
 static struct pgt_cache pgt_cache_list = SLIST_HEAD_INITIALIZER(pgt_cache_list);
+static struct pgt_cache_stats pgt_stats;
 #endif
 
 static struct pgt pgt_entries[PGT_CACHE_SIZE];
@@ -124,7 +127,7 @@ static struct pgt *pop_from_free_list(void)
 
 	if (p) {
 		SLIST_REMOVE_HEAD(&pgt_free_list, link);
-		memset(p->tbl, 0, PGT_SIZE);
+		zero_pages(p->tbl, PGT_SIZE);
 	}
 	return p;
 }
@@ -171,6 +174,7 @@ static void push_to_free_list(struct pgt *p)
 static void push_to_cache_list(struct pgt *pgt)
 {
 	SLIST_INSERT_HEAD(&pgt_cache_list, pgt, link);
+	pgt_stats.cached++;
 }
 
 static bool match_pgt(struct pgt *pgt, vaddr_t vabase, void *ctx)
@@ -188,6 +192,7 @@ static struct pgt *pop_from_cache_list(vaddr_t vabase, void *ctx)
 		return NULL;
 	if (match_pgt(pgt, vabase, ctx)) {
 		SLIST_REMOVE_HEAD(&pgt_cache_list, link);
+		pgt_stats.cached--;
 		return pgt;
 	}
 
@@ -197,6 +202,7 @@ static struct pgt *pop_from_cache_list(vaddr_t vabase, void *ctx)
 			break;
 		if (match_pgt(p, vabase, ctx)) {
 			SLIST_REMOVE_AFTER(pgt, link);
+			pgt_stats.cached--;
 			break;
 		}
 		pgt = p;
@@ -204,38 +210,45 @@ static struct pgt *pop_from_cache_list(vaddr_t vabase, void *ctx)
 	return p;
 }
 
-static struct pgt *pop_least_used_from_cache_list(void)
+/*
+ * Takes a table from the least recently active context other than @ctx,
+ * or from @ctx if there's no other. Among the tables of that context the
+ * one with the fewest used entries is taken as it's the cheapest to
+ * release. Tables of recently active contexts are this way kept as long
+ * as possible.
+ */
+static struct pgt *pop_lru_from_cache_list(void *ctx)
 {
-	struct pgt *pgt;
-	struct pgt *p_prev = NULL;
-	size_t least_used;
+	struct tee_ta_ctx *victim_ctx = ctx;
+	struct pgt *victim_prev = NULL;
+	struct pgt *victim = NULL;
+	struct pgt *prev = NULL;
+	struct pgt *p = NULL;
 
-	pgt = SLIST_FIRST(&pgt_cache_list);
-	if (!pgt)
-		return NULL;
-	if (!pgt->num_used_entries)
-		goto out;
-	least_used = pgt->num_used_entries;
-
-	while (true) {
-		if (!SLIST_NEXT(pgt, link))
-			break;
-		if (SLIST_NEXT(pgt, link)->num_used_entries <= least_used) {
-			p_prev = pgt;
-			least_used = SLIST_NEXT(pgt, link)->num_used_entries;
+	SLIST_FOREACH(p, &pgt_cache_list, link)
+		if (p->ctx != ctx)
+			victim_ctx = p->ctx;
+
+	SLIST_FOREACH(p, &pgt_cache_list, link) {
+		if (p->ctx == victim_ctx &&
+		    (!victim ||
+		     p->num_used_entries <= victim->num_used_entries)) {
+			victim = p;
+			victim_prev = prev;
 		}
-		pgt = SLIST_NEXT(pgt, link);
+		prev = p;
 	}
 
-out:
-	if (p_prev) {
-		pgt = SLIST_NEXT(p_prev, link);
-		SLIST_REMOVE_AFTER(p_prev, link);
-	} else {
-		pgt = SLIST_FIRST(&pgt_cache_list);
+	if (!victim)
+		return NULL;
+
+	if (victim_prev)
+		SLIST_REMOVE_AFTER(victim_prev, link);
+	else
 		SLIST_REMOVE_HEAD(&pgt_cache_list, link);
-	}
-	return pgt;
+	pgt_stats.cached--;
+
+	return victim;
 }
 
 static void pgt_free_unlocked(struct pgt_cache *pgt_cache, bool save_ctx)
@@ -261,16 +274,20 @@ static struct pgt *pop_from_some_list(vaddr_t vabase, void *ctx)
 {
 	struct pgt *p = pop_from_cache_list(vabase, ctx);
 
-	if (p)
+	if (p) {
+		pgt_stats.hits++;
 		return p;
+	}
 	p = pop_from_free_list();
 	if (!p) {
-		p = pop_least_used_from_cache_list();
+		p = pop_lru_from_cache_list(ctx);
 		if (!p)
 			return NULL;
+		pgt_stats.evictions++;
 		tee_pager_pgt_save_and_release_entries(p);
-		memset(p->tbl, 0, PGT_SIZE);
+		zero_pages(p->tbl, PGT_SIZE);
 	}
+	pgt_stats.misses++;
 	assert(!p->num_used_entries);
 	p->ctx = ctx;
 	p->vabase = vabase;
@@ -291,6 +308,7 @@ void pgt_flush_ctx(struct tee_ta_ctx *ctx)
 		if (p->ctx != ctx)
 			break;
 		SLIST_REMOVE_HEAD(&pgt_cache_list, link);
+		pgt_stats.cached--;
 		tee_pager_pgt_save_and_release_entries(p);
 		assert(!p->num_used_entries);
 		p->ctx = NULL;
@@ -305,6 +323,7 @@ void pgt_flush_ctx(struct tee_ta_ctx *ctx)
 			break;
 		if (p->ctx == ctx) {
 			SLIST_REMOVE_AFTER(pp, link);
+			pgt_stats.cached--;
 			tee_pager_pgt_save_and_release_entries(p);
 			assert(!p->num_used_entries);
 			p->ctx = NULL;
@@ -346,6 +365,7 @@ static bool pgt_entry_matches(struct pgt *p, void *ctx, vaddr_t begin,
 static void flush_ctx_range_from_list(struct pgt_cache *pgt_cache, void *ctx,
 				      vaddr_t begin, vaddr_t last)
 {
+	const bool is_cache_list = pgt_cache == &pgt_cache_list;
 	struct pgt *p;
 	struct pgt *next_p;
 
@@ -357,6 +377,8 @@ static void flush_ctx_range_from_list(struct pgt_cache *pgt_cache, void *ctx,
 	while (pgt_entry_matches(p, ctx, begin, last)) {
 		flush_pgt_entry(p);
 		SLIST_REMOVE_HEAD(pgt_cache, link);
+		if (is_cache_list)
+			pgt_stats.cached--;
 		push_to_free_list(p);
 		p = SLIST_FIRST(pgt_cache);
 	}
@@ -379,6 +401,8 @@ static void flush_ctx_range_from_list(struct pgt_cache *pgt_cache, void *ctx,
 		if (pgt_entry_matches(next_p, ctx, begin, last)) {
 			flush_pgt_entry(next_p);
 			SLIST_REMOVE_AFTER(p, link);
+			if (is_cache_list)
+				pgt_stats.cached--;
 			push_to_free_list(next_p);
 			continue;
 		}
@@ -400,6 +424,13 @@ void pgt_flush_ctx_range(struct pgt_cache *pgt_cache, void *ctx,
 	mutex_unlock(&pgt_mu);
 }
 
+void pgt_get_stats(struct pgt_cache_stats *stats)
+{
+	mutex_lock(&pgt_mu);
+	*stats = pgt_stats;
+	mutex_unlock(&pgt_mu);
+}
+
 #else /*!CFG_PAGED_USER_TA*/
 
 static void pgt_free_unlocked(struct pgt_cache *pgt_cache,
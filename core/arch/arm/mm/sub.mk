@@ -10,3 +10,4 @@ srcs-y += tee_mm.c
 srcs-y += pgt_cache.c
 srcs-y += mobj.c
 srcs-$(CFG_CORE_DYN_SHM) += mobj_dyn_shm.c
+srcs-$(CFG_SDP_POOL) += mobj_sdp_pool.c
@@ -11,6 +11,9 @@
 #include <trace.h>
 #include <util.h>
 
+/* Any non-zero value will do, it's only the state of an xorshift */
+#define TEE_MM_PRIO_SEED	0x9e3779b9
+
 static void *pmalloc(tee_mm_pool_t *pool, size_t size)
 {
 	if (pool->flags & TEE_MM_POOL_NEX_MALLOC)
@@ -19,20 +22,204 @@ static void *pmalloc(tee_mm_pool_t *pool, size_t size)
 		return malloc(size);
 }
 
-static void *pcalloc(tee_mm_pool_t *pool, size_t num_el, size_t size)
+static void pfree(tee_mm_pool_t *pool, void *ptr)
 {
 	if (pool->flags & TEE_MM_POOL_NEX_MALLOC)
-		return nex_calloc(num_el, size);
+		nex_free(ptr);
 	else
-		return calloc(num_el, size);
+		free(ptr);
 }
 
-static void pfree(tee_mm_pool_t *pool, void *ptr)
+static bool pool_is_init(const tee_mm_pool_t *pool)
 {
-	if (pool->flags & TEE_MM_POOL_NEX_MALLOC)
-		nex_free(ptr);
+	return pool && pool->seed;
+}
+
+/* Size of the pool in pages/sections */
+static uint32_t pool_units(const tee_mm_pool_t *pool)
+{
+	return (pool->hi - pool->lo) >> pool->shift;
+}
+
+/*
+ * Start and end of an entry counted in allocation order, that is from
+ * the end of the pool with TEE_MM_POOL_HI_ALLOC.
+ */
+static uint32_t ent_start(const tee_mm_entry_t *e)
+{
+	if (e->pool->flags & TEE_MM_POOL_HI_ALLOC)
+		return pool_units(e->pool) - e->offset - e->size;
+	return e->offset;
+}
+
+static uint32_t ent_end(const tee_mm_entry_t *e)
+{
+	if (e->pool->flags & TEE_MM_POOL_HI_ALLOC)
+		return pool_units(e->pool) - e->offset;
+	return e->offset + e->size;
+}
+
+/* Order of the entries in the tree, the address breaks ties */
+static bool ent_before(const tee_mm_entry_t *a, const tee_mm_entry_t *b)
+{
+	if (ent_start(a) != ent_start(b))
+		return ent_start(a) < ent_start(b);
+	if (ent_end(a) != ent_end(b))
+		return ent_end(a) < ent_end(b);
+	return (vaddr_t)a < (vaddr_t)b;
+}
+
+static uint32_t next_prio(tee_mm_pool_t *pool)
+{
+	uint32_t x = pool->seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	pool->seed = x;
+
+	return x;
+}
+
+/* Updates the description of the subtree of @t from its children */
+static void tree_update(tee_mm_entry_t *t)
+{
+	uint32_t start = ent_start(t);
+	uint32_t end = ent_end(t);
+	uint32_t gap = 0;
+
+	t->first = start;
+	t->last = end;
+	if (t->left) {
+		t->first = t->left->first;
+		gap = MAX(t->left->max_gap, start - t->left->last);
+	}
+	if (t->right) {
+		t->last = t->right->last;
+		gap = MAX(gap, t->right->max_gap);
+		gap = MAX(gap, t->right->first - end);
+	}
+	t->max_gap = gap;
+}
+
+/* Joins two trees where all entries in @a are before those in @b */
+static tee_mm_entry_t *tree_merge(tee_mm_entry_t *a, tee_mm_entry_t *b)
+{
+	if (!a)
+		return b;
+	if (!b)
+		return a;
+
+	if (a->prio > b->prio) {
+		a->right = tree_merge(a->right, b);
+		tree_update(a);
+		return a;
+	}
+
+	b->left = tree_merge(a, b->left);
+	tree_update(b);
+	return b;
+}
+
+/* Splits @t into the entries before @e and the entries after @e */
+static void tree_split(tee_mm_entry_t *t, const tee_mm_entry_t *e,
+		       tee_mm_entry_t **l, tee_mm_entry_t **r)
+{
+	if (!t) {
+		*l = NULL;
+		*r = NULL;
+		return;
+	}
+
+	if (ent_before(t, e)) {
+		tree_split(t->right, e, &t->right, r);
+		*l = t;
+	} else {
+		tree_split(t->left, e, l, &t->left);
+		*r = t;
+	}
+	tree_update(t);
+}
+
+static void tree_insert(tee_mm_pool_t *pool, tee_mm_entry_t *e)
+{
+	tee_mm_entry_t *l = NULL;
+	tee_mm_entry_t *r = NULL;
+
+	e->left = NULL;
+	e->right = NULL;
+	e->prio = next_prio(pool);
+	tree_update(e);
+
+	tree_split(pool->root, e, &l, &r);
+	pool->root = tree_merge(tree_merge(l, e), r);
+}
+
+static tee_mm_entry_t *tree_remove(tee_mm_entry_t *t, tee_mm_entry_t *e)
+{
+	if (!t)
+		panic("invalid mm_entry");
+
+	if (t == e)
+		return tree_merge(t->left, t->right);
+
+	if (ent_before(e, t))
+		t->left = tree_remove(t->left, e);
 	else
-		free(ptr);
+		t->right = tree_remove(t->right, e);
+	tree_update(t);
+
+	return t;
+}
+
+/*
+ * Finds the first gap of at least @psize in allocation order between
+ * @prev_end, the end of the entry before the subtree, and the last
+ * entry of the subtree. Returns the start of the gap in @pos.
+ */
+static bool tree_find_gap(const tee_mm_entry_t *t, uint32_t prev_end,
+			  uint32_t psize, uint32_t *pos)
+{
+	uint32_t end = 0;
+
+	while (t) {
+		if (t->left && (t->left->first - prev_end >= psize ||
+				t->left->max_gap >= psize)) {
+			t = t->left;
+			continue;
+		}
+
+		if (t->left)
+			end = t->left->last;
+		else
+			end = prev_end;
+		if (ent_start(t) - end >= psize) {
+			*pos = end;
+			return true;
+		}
+
+		prev_end = ent_end(t);
+		t = t->right;
+	}
+
+	return false;
+}
+
+/* Returns the last entry in allocation order which starts before @pos */
+static tee_mm_entry_t *tree_find_before(tee_mm_entry_t *t, uint32_t pos)
+{
+	tee_mm_entry_t *e = NULL;
+
+	while (t) {
+		if (ent_start(t) < pos) {
+			e = t;
+			t = t->right;
+		} else {
+			t = t->left;
+		}
+	}
+
+	return e;
 }
 
 bool tee_mm_init(tee_mm_pool_t *pool, paddr_t lo, paddr_t hi, uint8_t shift,
@@ -50,14 +237,8 @@ bool tee_mm_init(tee_mm_pool_t *pool, paddr_t lo, paddr_t hi, uint8_t shift,
 	pool->hi = hi;
 	pool->shift = shift;
 	pool->flags = flags;
-	pool->entry = pcalloc(pool, 1, sizeof(tee_mm_entry_t));
-
-	if (pool->entry == NULL)
-		return false;
-
-	if (pool->flags & TEE_MM_POOL_HI_ALLOC)
-		pool->entry->offset = ((hi - lo - 1) >> shift) + 1;
-	pool->entry->pool = pool;
+	pool->root = NULL;
+	pool->seed = TEE_MM_PRIO_SEED;
 	pool->lock = SPINLOCK_UNLOCK;
 
 	return true;
@@ -65,40 +246,15 @@ bool tee_mm_init(tee_mm_pool_t *pool, paddr_t lo, paddr_t hi, uint8_t shift,
 
 void tee_mm_final(tee_mm_pool_t *pool)
 {
-	if (pool == NULL || pool->entry == NULL)
+	if (!pool_is_init(pool))
 		return;
 
-	while (pool->entry->next != NULL)
-		tee_mm_free(pool->entry->next);
-	pfree(pool, pool->entry);
-	pool->entry = NULL;
-}
-
-static void tee_mm_add(tee_mm_entry_t *p, tee_mm_entry_t *nn)
-{
-	/* add to list */
-	nn->next = p->next;
-	p->next = nn;
+	while (pool->root)
+		tee_mm_free(pool->root);
+	pool->seed = 0;
 }
 
 #ifdef CFG_WITH_STATS
-static size_t tee_mm_stats_allocated(tee_mm_pool_t *pool)
-{
-	tee_mm_entry_t *entry;
-	uint32_t sz = 0;
-
-	if (!pool)
-		return 0;
-
-	entry = pool->entry;
-	while (entry) {
-		sz += entry->size;
-		entry = entry->next;
-	}
-
-	return sz << pool->shift;
-}
-
 void tee_mm_get_pool_stats(tee_mm_pool_t *pool, struct malloc_stats *stats,
 			   bool reset)
 {
@@ -113,22 +269,31 @@ void tee_mm_get_pool_stats(tee_mm_pool_t *pool, struct malloc_stats *stats,
 
 	stats->size = pool->hi - pool->lo;
 	stats->max_allocated = pool->max_allocated;
-	stats->allocated = tee_mm_stats_allocated(pool);
+	stats->allocated = pool->allocated << pool->shift;
 
 	if (reset)
 		pool->max_allocated = 0;
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 }
 
-static void update_max_allocated(tee_mm_pool_t *pool)
+static void update_allocated(tee_mm_pool_t *pool, tee_mm_entry_t *mm,
+			     bool alloc)
 {
-	size_t sz = tee_mm_stats_allocated(pool);
+	size_t sz = 0;
 
+	if (alloc)
+		pool->allocated += mm->size;
+	else
+		pool->allocated -= mm->size;
+
+	sz = pool->allocated << pool->shift;
 	if (sz > pool->max_allocated)
 		pool->max_allocated = sz;
 }
 #else /* CFG_WITH_STATS */
-static inline void update_max_allocated(tee_mm_pool_t *pool __unused)
+static inline void update_allocated(tee_mm_pool_t *pool __unused,
+				    tee_mm_entry_t *mm __unused,
+				    bool alloc __unused)
 {
 }
 #endif /* CFG_WITH_STATS */
@@ -136,80 +301,49 @@ static inline void update_max_allocated(tee_mm_pool_t *pool __unused)
 tee_mm_entry_t *tee_mm_alloc(tee_mm_pool_t *pool, size_t size)
 {
 	size_t psize;
-	tee_mm_entry_t *entry;
 	tee_mm_entry_t *nn;
-	size_t remaining;
+	uint32_t units;
+	uint32_t pos = 0;
 	uint32_t exceptions;
 
 	/* Check that pool is initialized */
-	if (!pool || !pool->entry)
+	if (!pool_is_init(pool))
 		return NULL;
 
-	nn = pmalloc(pool, sizeof(tee_mm_entry_t));
-	if (!nn)
-		return NULL;
-
-	exceptions = cpu_spin_lock_xsave(&pool->lock);
-
-	entry = pool->entry;
+	units = pool_units(pool);
 	if (size == 0)
 		psize = 0;
 	else
 		psize = ((size - 1) >> pool->shift) + 1;
+	if (psize > units)
+		return NULL;
 
-	/* find free slot */
-	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
-		while (entry->next != NULL && psize >
-		       (entry->offset - entry->next->offset -
-			entry->next->size))
-			entry = entry->next;
-	} else {
-		while (entry->next != NULL && psize >
-		       (entry->next->offset - entry->size - entry->offset))
-			entry = entry->next;
-	}
-
-	/* check if we have enough memory */
-	if (entry->next == NULL) {
-		if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
-			/*
-			 * entry->offset is a "block count" offset from
-			 * pool->lo. The byte offset is
-			 * (entry->offset << pool->shift).
-			 * In the HI_ALLOC allocation scheme the memory is
-			 * allocated from the end of the segment, thus to
-			 * validate there is sufficient memory validate that
-			 * (entry->offset << pool->shift) > size.
-			 */
-			if ((entry->offset << pool->shift) < size) {
-				/* out of memory */
-				goto err;
-			}
-		} else {
-			if (pool->hi <= pool->lo)
-				panic("invalid pool");
+	nn = pmalloc(pool, sizeof(tee_mm_entry_t));
+	if (!nn)
+		return NULL;
 
-			remaining = (pool->hi - pool->lo);
-			remaining -= ((entry->offset + entry->size) <<
-				      pool->shift);
+	exceptions = cpu_spin_lock_xsave(&pool->lock);
 
-			if (remaining < size) {
-				/* out of memory */
-				goto err;
-			}
+	/* find free slot, first fit in allocation order */
+	if (!tree_find_gap(pool->root, 0, psize, &pos)) {
+		if (pool->root)
+			pos = pool->root->last;
+		/* check if we have enough memory */
+		if (units - pos < psize) {
+			/* out of memory */
+			goto err;
 		}
 	}
 
-	tee_mm_add(entry, nn);
-
 	if (pool->flags & TEE_MM_POOL_HI_ALLOC)
-		nn->offset = entry->offset - psize;
+		nn->offset = units - pos - psize;
 	else
-		nn->offset = entry->offset + entry->size;
+		nn->offset = pos;
 	nn->size = psize;
 	nn->pool = pool;
 
-	update_max_allocated(pool);
+	tree_insert(pool, nn);
+	update_allocated(pool, nn, true);
 
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 	return nn;
@@ -219,74 +353,61 @@ err:
 	return NULL;
 }
 
-static inline bool fit_in_gap(tee_mm_pool_t *pool, tee_mm_entry_t *e,
-			      paddr_t offslo, paddr_t offshi)
-{
-	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
-		if (offshi > e->offset ||
-		    (e->next != NULL &&
-		     (offslo < e->next->offset + e->next->size)) ||
-		    (offshi << pool->shift) - 1 > (pool->hi - pool->lo))
-			/* memory not available */
-			return false;
-	} else {
-		if (offslo < (e->offset + e->size) ||
-		    (e->next != NULL && (offshi > e->next->offset)) ||
-		    (offshi << pool->shift) > (pool->hi - pool->lo))
-			/* memory not available */
-			return false;
-	}
-
-	return true;
-}
-
 tee_mm_entry_t *tee_mm_alloc2(tee_mm_pool_t *pool, paddr_t base, size_t size)
 {
 	tee_mm_entry_t *entry;
 	paddr_t offslo;
 	paddr_t offshi;
+	uint32_t start;
+	uint32_t end;
+	uint32_t units;
 	tee_mm_entry_t *mm;
 	uint32_t exceptions;
 
 	/* Check that pool is initialized */
-	if (!pool || !pool->entry)
+	if (!pool_is_init(pool))
 		return NULL;
 
 	/* Wrapping and sanity check */
 	if ((base + size) < base || base < pool->lo)
 		return NULL;
 
-	mm = pmalloc(pool, sizeof(tee_mm_entry_t));
-	if (!mm)
-		return NULL;
-
-	exceptions = cpu_spin_lock_xsave(&pool->lock);
-
-	entry = pool->entry;
+	units = pool_units(pool);
 	offslo = (base - pool->lo) >> pool->shift;
 	offshi = ((base - pool->lo + size - 1) >> pool->shift) + 1;
+	if (offshi > units)
+		return NULL;
 
-	/* find slot */
 	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
-		while (entry->next != NULL &&
-		       offshi < entry->next->offset + entry->next->size)
-			entry = entry->next;
+		start = units - offshi;
+		end = units - offslo;
 	} else {
-		while (entry->next != NULL && offslo > entry->next->offset)
-			entry = entry->next;
+		start = offslo;
+		end = offshi;
 	}
 
-	/* Check that memory is available */
-	if (!fit_in_gap(pool, entry, offslo, offshi))
-		goto err;
+	mm = pmalloc(pool, sizeof(tee_mm_entry_t));
+	if (!mm)
+		return NULL;
 
-	tee_mm_add(entry, mm);
+	exceptions = cpu_spin_lock_xsave(&pool->lock);
+
+	/*
+	 * Check that memory is available, since the entries don't overlap
+	 * only the last entry starting before the end of the range can
+	 * reach into it.
+	 */
+	entry = tree_find_before(pool->root, end);
+	if (entry && ent_end(entry) > start)
+		goto err;
 
 	mm->offset = offslo;
 	mm->size = offshi - offslo;
 	mm->pool = pool;
 
-	update_max_allocated(pool);
+	tree_insert(pool, mm);
+	update_allocated(pool, mm, true);
+
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 	return mm;
 err:
@@ -297,23 +418,14 @@ err:
 
 void tee_mm_free(tee_mm_entry_t *p)
 {
-	tee_mm_entry_t *entry;
 	uint32_t exceptions;
 
 	if (!p || !p->pool)
 		return;
 
 	exceptions = cpu_spin_lock_xsave(&p->pool->lock);
-	entry = p->pool->entry;
-
-	/* remove entry from list */
-	while (entry->next != NULL && entry->next != p)
-		entry = entry->next;
-
-	if (!entry->next)
-		panic("invalid mm_entry");
-
-	entry->next = entry->next->next;
+	p->pool->root = tree_remove(p->pool->root, p);
+	update_allocated(p->pool, p, false);
 	cpu_spin_unlock_xrestore(&p->pool->lock, exceptions);
 
 	pfree(p->pool, p);
@@ -337,11 +449,11 @@ bool tee_mm_is_empty(tee_mm_pool_t *pool)
 	bool ret;
 	uint32_t exceptions;
 
-	if (pool == NULL || pool->entry == NULL)
+	if (!pool_is_init(pool))
 		return true;
 
 	exceptions = cpu_spin_lock_xsave(&pool->lock);
-	ret = pool->entry == NULL || pool->entry->next == NULL;
+	ret = !pool->root;
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 
 	return ret;
@@ -358,28 +470,27 @@ tee_mm_pool_t tee_mm_shm;
 
 tee_mm_entry_t *tee_mm_find(const tee_mm_pool_t *pool, paddr_t addr)
 {
-	tee_mm_entry_t *entry = pool->entry;
-	uint16_t offset = (addr - pool->lo) >> pool->shift;
+	tee_mm_entry_t *entry = NULL;
+	uint32_t offset = 0;
 	uint32_t exceptions;
 
-	if (addr > pool->hi || addr < pool->lo)
+	if (!pool_is_init(pool))
+		return NULL;
+	if (addr >= pool->hi || addr < pool->lo)
 		return NULL;
 
-	exceptions = cpu_spin_lock_xsave(&((tee_mm_pool_t *)pool)->lock);
+	offset = (addr - pool->lo) >> pool->shift;
+	if (pool->flags & TEE_MM_POOL_HI_ALLOC)
+		offset = pool_units(pool) - 1 - offset;
 
-	while (entry->next != NULL) {
-		entry = entry->next;
+	exceptions = cpu_spin_lock_xsave(&((tee_mm_pool_t *)pool)->lock);
 
-		if ((offset >= entry->offset) &&
-		    (offset < (entry->offset + entry->size))) {
-			cpu_spin_unlock_xrestore(&((tee_mm_pool_t *)pool)->lock,
-						 exceptions);
-			return entry;
-		}
-	}
+	entry = tree_find_before(pool->root, offset + 1);
+	if (entry && ent_end(entry) <= offset)
+		entry = NULL;
 
 	cpu_spin_unlock_xrestore(&((tee_mm_pool_t *)pool)->lock, exceptions);
-	return NULL;
+	return entry;
 }
 
 uintptr_t tee_mm_get_smem(const tee_mm_entry_t *mm)
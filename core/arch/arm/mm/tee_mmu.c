@@ -43,10 +43,42 @@
 #define TEE_MMU_UCACHE_DEFAULT_ATTR	(TEE_MATTR_CACHE_CACHED << \
 					 TEE_MATTR_CACHE_SHIFT)
 
+/*
+ * Returns true if @reg is unpaged, physically contiguous and covers at
+ * least one naturally aligned block of CORE_MMU_PGDIR_SIZE bytes. If it's
+ * mapped at a virtual address congruent with the returned physical
+ * address @pa modulo CORE_MMU_PGDIR_SIZE such blocks are mapped with
+ * block entries instead of translation tables.
+ */
+static bool get_block_pa(struct vm_region *reg, paddr_t *pa)
+{
+	size_t granule = 0;
+
+	if (mobj_is_paged(reg->mobj) || reg->size < CORE_MMU_PGDIR_SIZE)
+		return false;
+
+	granule = mobj_get_phys_granule(reg->mobj);
+	if (reg->offset / granule != (reg->offset + reg->size - 1) / granule)
+		return false;
+
+	if (mobj_get_pa(reg->mobj, reg->offset, 0, pa))
+		return false;
+
+	return ROUNDUP(*pa, CORE_MMU_PGDIR_SIZE) + CORE_MMU_PGDIR_SIZE <=
+	       *pa + reg->size;
+}
+
+/*
+ * If @pgdir_align is true the region is moved to the next translation
+ * table boundary, @pad_begin is added after the boundary to keep the ASLR
+ * offset.
+ */
 static vaddr_t select_va_in_range(const struct vm_region *prev_reg,
 				  const struct vm_region *next_reg,
 				  const struct vm_region *reg,
-				  size_t pad_begin, size_t pad_end)
+				  size_t pad_begin, size_t pad_end,
+				  size_t block_size, paddr_t block_pa,
+				  bool pgdir_align)
 {
 	const uint32_t f = VM_FLAG_EPHEMERAL | VM_FLAG_PERMANENT |
 			    VM_FLAG_SHAREABLE;
@@ -71,12 +103,18 @@ static vaddr_t select_va_in_range(const struct vm_region *prev_reg,
 	    (reg->attr & TEE_MATTR_SECURE))
 		granul = CORE_MMU_PGDIR_SIZE;
 #endif
-	begin_va = ROUNDUP(prev_reg->va + prev_reg->size + pad_begin + pad,
-			   granul);
+	if (pgdir_align)
+		begin_va = ROUNDUP(prev_reg->va + prev_reg->size + pad,
+				   CORE_MMU_PGDIR_SIZE) + pad_begin;
+	else
+		begin_va = ROUNDUP(prev_reg->va + prev_reg->size + pad_begin +
+				   pad, granul);
 	if (reg->va) {
 		if (reg->va < begin_va)
 			return 0;
 		begin_va = reg->va;
+	} else if (block_size) {
+		begin_va += (block_pa - begin_va) & (block_size - 1);
 	}
 
 	if (next_reg->flags && (next_reg->flags & f) != (reg->flags & f))
@@ -181,22 +219,194 @@ static void maybe_free_pgt(struct user_ta_ctx *utc, struct vm_region *r)
 	pgt_flush_ctx_range(pgt_cache, &utc->ctx, r->va, r->va + r->size);
 }
 
-static TEE_Result umap_add_region(struct vm_info *vmi, struct vm_region *reg,
-				  size_t pad_begin, size_t pad_end)
+/* Returns the index of the first region in @vmi ending after @va */
+static size_t vm_region_lower_bound(const struct vm_info *vmi, vaddr_t va)
+{
+	const struct vm_region *r = NULL;
+	size_t hi = vmi->num_regions;
+	size_t lo = 0;
+	size_t mid = 0;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		r = vmi->regions_by_va[mid];
+		if (va >= r->va && va - r->va >= r->size)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/* Returns the region of @vmi containing @va or NULL */
+static struct vm_region *find_vm_region(const struct vm_info *vmi,
+					vaddr_t va)
+{
+	size_t n = vm_region_lower_bound(vmi, va);
+	struct vm_region *r = NULL;
+
+	if (n == vmi->num_regions)
+		return NULL;
+	r = vmi->regions_by_va[n];
+	if (va < r->va)
+		return NULL;
+
+	return r;
+}
+
+/* Makes room for one more region in @vmi->regions_by_va */
+static TEE_Result vm_index_reserve(struct vm_info *vmi)
+{
+	struct vm_region **p = NULL;
+	size_t max = 0;
+
+	if (vmi->num_regions < vmi->max_regions)
+		return TEE_SUCCESS;
+
+	max = MAX(vmi->max_regions * 2, (size_t)8);
+	p = realloc(vmi->regions_by_va, max * sizeof(*p));
+	if (!p)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	vmi->regions_by_va = p;
+	vmi->max_regions = max;
+
+	return TEE_SUCCESS;
+}
+
+/* Room must have been reserved with vm_index_reserve() */
+static void vm_index_insert(struct vm_info *vmi, struct vm_region *reg)
+{
+	size_t n = vm_region_lower_bound(vmi, reg->va);
+
+	assert(vmi->num_regions < vmi->max_regions);
+	memmove(vmi->regions_by_va + n + 1, vmi->regions_by_va + n,
+		(vmi->num_regions - n) * sizeof(*vmi->regions_by_va));
+	vmi->regions_by_va[n] = reg;
+	vmi->num_regions++;
+}
+
+/* Removes @reg from @vmi->regions, the region itself is kept */
+static void umap_unlink_region(struct vm_info *vmi, struct vm_region *reg)
+{
+	size_t n = vm_region_lower_bound(vmi, reg->va);
+
+	/* An empty region ends where it starts, it's before index @n */
+	while (n && (n == vmi->num_regions || vmi->regions_by_va[n] != reg))
+		n--;
+	assert(vmi->regions_by_va[n] == reg);
+	vmi->num_regions--;
+	memmove(vmi->regions_by_va + n, vmi->regions_by_va + n + 1,
+		(vmi->num_regions - n) * sizeof(*vmi->regions_by_va));
+	TAILQ_REMOVE(&vmi->regions, reg, link);
+}
+
+/*
+ * Returns the number of translation tables needed to map @size bytes at
+ * @va between @prev_reg and @next_reg which aren't already needed for
+ * those regions.
+ */
+static size_t num_new_pgts(const struct vm_region *prev_reg,
+			   const struct vm_region *next_reg,
+			   vaddr_t va, size_t size)
+{
+	size_t first = va >> CORE_MMU_PGDIR_SHIFT;
+	size_t last = (va + size - 1) >> CORE_MMU_PGDIR_SHIFT;
+	size_t n = last - first + 1;
+	bool prev_shares = false;
+
+	if (prev_reg->size &&
+	    (prev_reg->va + prev_reg->size - 1) >> CORE_MMU_PGDIR_SHIFT ==
+	    first) {
+		prev_shares = true;
+		n--;
+	}
+	if (next_reg->size && next_reg->va >> CORE_MMU_PGDIR_SHIFT == last &&
+	    (first != last || !prev_shares))
+		n--;
+
+	return n;
+}
+
+/*
+ * Regions with a fixed address or mapped with block entries take the
+ * first free range. Other regions are packed to use as few translation
+ * tables as possible, each free range is tried both directly after the
+ * previous region and at the next table boundary, the lowest address
+ * needing the fewest new tables is selected.
+ */
+static TEE_Result umap_insert_region(struct vm_info *vmi,
+				     struct vm_region *reg,
+				     size_t pad_begin, size_t pad_end,
+				     size_t block_size, paddr_t block_pa)
 {
 	struct vm_region dummy_first_reg = { };
 	struct vm_region dummy_last_reg = { };
-	struct vm_region *r = NULL;
+	struct vm_region *best_next = NULL;
 	struct vm_region *prev_r = NULL;
+	struct vm_region *r = NULL;
+	bool first_fit = reg->va || block_size;
+	size_t best_cost = SIZE_MAX;
 	vaddr_t va_range_base = 0;
 	size_t va_range_size = 0;
+	vaddr_t best_va = 0;
 	vaddr_t va = 0;
-	size_t offs_plus_size = 0;
+	size_t cost = 0;
+	unsigned int n = 0;
 
 	core_mmu_get_user_va_range(&va_range_base, &va_range_size);
 	dummy_first_reg.va = va_range_base;
 	dummy_last_reg.va = va_range_base + va_range_size;
 
+	prev_r = &dummy_first_reg;
+	r = TAILQ_FIRST(&vmi->regions);
+	while (true) {
+		if (!r)
+			r = &dummy_last_reg;
+
+		for (n = 0; n < (first_fit ? 1 : 2); n++) {
+			va = select_va_in_range(prev_r, r, reg, pad_begin,
+						pad_end, block_size, block_pa,
+						n == 1);
+			if (!va)
+				continue;
+			if (first_fit)
+				cost = 0;
+			else
+				cost = num_new_pgts(prev_r, r, va, reg->size);
+			if (cost < best_cost) {
+				best_cost = cost;
+				best_va = va;
+				best_next = r;
+			}
+		}
+		if (!best_cost || r == &dummy_last_reg)
+			break;
+
+		prev_r = r;
+		r = TAILQ_NEXT(r, link);
+	}
+
+	if (!best_va)
+		return TEE_ERROR_ACCESS_CONFLICT;
+
+	reg->va = best_va;
+	if (best_next == &dummy_last_reg)
+		TAILQ_INSERT_TAIL(&vmi->regions, reg, link);
+	else
+		TAILQ_INSERT_BEFORE(best_next, reg, link);
+	vm_index_insert(vmi, reg);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result umap_add_region(struct vm_info *vmi, struct vm_region *reg,
+				  size_t pad_begin, size_t pad_end)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t offs_plus_size = 0;
+	paddr_t pa = 0;
+
 	/* Check alignment, it has to be at least SMALL_PAGE based */
 	if ((reg->va | reg->size | pad_begin | pad_end) & SMALL_PAGE_MASK)
 		return TEE_ERROR_ACCESS_CONFLICT;
@@ -207,51 +417,43 @@ static TEE_Result umap_add_region(struct vm_info *vmi, struct vm_region *reg,
 	if (offs_plus_size > ROUNDUP(reg->mobj->size, SMALL_PAGE_SIZE))
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	prev_r = &dummy_first_reg;
-	TAILQ_FOREACH(r, &vmi->regions, link) {
-		va = select_va_in_range(prev_r, r, reg, pad_begin, pad_end);
-		if (va) {
-			reg->va = va;
-			TAILQ_INSERT_BEFORE(r, reg, link);
-			return TEE_SUCCESS;
-		}
-		prev_r = r;
-	}
+	res = vm_index_reserve(vmi);
+	if (res)
+		return res;
 
-	r = TAILQ_LAST(&vmi->regions, vm_region_head);
-	if (!r)
-		r = &dummy_first_reg;
-	va = select_va_in_range(r, &dummy_last_reg, reg, pad_begin, pad_end);
-	if (va) {
-		reg->va = va;
-		TAILQ_INSERT_TAIL(&vmi->regions, reg, link);
+	/*
+	 * Try to place large physically contiguous regions so they can be
+	 * mapped with block entries, fall back to any free range.
+	 */
+	if (!reg->va && get_block_pa(reg, &pa) &&
+	    !umap_insert_region(vmi, reg, pad_begin, pad_end,
+				CORE_MMU_PGDIR_SIZE, pa))
 		return TEE_SUCCESS;
-	}
 
-	return TEE_ERROR_ACCESS_CONFLICT;
+	return umap_insert_region(vmi, reg, pad_begin, pad_end, 0, 0);
 }
 
-TEE_Result vm_map_pad(struct user_ta_ctx *utc, vaddr_t *va, size_t len,
-		      uint32_t prot, uint32_t flags, struct mobj *mobj,
-		      size_t offs, size_t pad_begin, size_t pad_end)
+/*
+ * Maps @mobj using the supplied @reg which is initialized here, @reg is
+ * not freed on error.
+ */
+static TEE_Result vm_map_reg(struct user_ta_ctx *utc, struct vm_region *reg,
+			     vaddr_t *va, size_t len, uint32_t prot,
+			     uint32_t flags, struct mobj *mobj, size_t offs,
+			     size_t pad_begin, size_t pad_end)
 {
 	TEE_Result res = TEE_SUCCESS;
-	struct vm_region *reg = NULL;
 	uint32_t attr = 0;
 
 	if (prot & ~TEE_MATTR_PROT_MASK)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	reg = calloc(1, sizeof(*reg));
-	if (!reg)
-		return TEE_ERROR_OUT_OF_MEMORY;
-
 	if (!mobj_is_paged(mobj)) {
 		uint32_t cattr;
 
 		res = mobj_get_cattr(mobj, &cattr);
 		if (res)
-			goto err_free_reg;
+			return res;
 		attr |= cattr << TEE_MATTR_CACHE_SHIFT;
 	}
 	attr |= TEE_MATTR_VALID_BLOCK;
@@ -267,7 +469,7 @@ TEE_Result vm_map_pad(struct user_ta_ctx *utc, vaddr_t *va, size_t len,
 
 	res = umap_add_region(utc->vm_info, reg, pad_begin, pad_end);
 	if (res)
-		goto err_free_reg;
+		return res;
 
 	res = alloc_pgt(utc);
 	if (res)
@@ -299,28 +501,47 @@ TEE_Result vm_map_pad(struct user_ta_ctx *utc, vaddr_t *va, size_t len,
 	return TEE_SUCCESS;
 
 err_rem_reg:
-	TAILQ_REMOVE(&utc->vm_info->regions, reg, link);
-err_free_reg:
-	free(reg);
+	umap_unlink_region(utc->vm_info, reg);
+	return res;
+}
+
+TEE_Result vm_map_pad(struct user_ta_ctx *utc, vaddr_t *va, size_t len,
+		      uint32_t prot, uint32_t flags, struct mobj *mobj,
+		      size_t offs, size_t pad_begin, size_t pad_end)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct vm_region *reg = calloc(1, sizeof(*reg));
+
+	if (!reg)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	res = vm_map_reg(utc, reg, va, len, prot, flags, mobj, offs,
+			 pad_begin, pad_end);
+	if (res)
+		free(reg);
+
 	return res;
 }
 
 static TEE_Result find_exact_vm_region(struct user_ta_ctx *utc, vaddr_t va,
 				       size_t len, struct vm_region **r_ret)
 {
+	struct vm_info *vmi = utc->vm_info;
+	size_t n = vm_region_lower_bound(vmi, va);
 	struct vm_region *r = NULL;
 
-	TAILQ_FOREACH(r, &utc->vm_info->regions, link) {
-		if (core_is_buffer_intersect(r->va, r->size, va, len)) {
-			if (r->va != va || r->size != len)
-				return TEE_ERROR_BAD_PARAMETERS;
+	if (n == vmi->num_regions)
+		return TEE_ERROR_ITEM_NOT_FOUND;
 
-			*r_ret = r;
-			return TEE_SUCCESS;
-		}
-	}
+	/* The first region ending after @va is the first one intersecting */
+	r = vmi->regions_by_va[n];
+	if (!core_is_buffer_intersect(r->va, r->size, va, len))
+		return TEE_ERROR_ITEM_NOT_FOUND;
+	if (r->va != va || r->size != len)
+		return TEE_ERROR_BAD_PARAMETERS;
 
-	return TEE_ERROR_ITEM_NOT_FOUND;
+	*r_ret = r;
+	return TEE_SUCCESS;
 }
 
 TEE_Result vm_remap(struct user_ta_ctx *utc, vaddr_t *new_va, vaddr_t old_va,
@@ -344,7 +565,7 @@ TEE_Result vm_remap(struct user_ta_ctx *utc, vaddr_t *new_va, vaddr_t old_va,
 	}
 	maybe_free_pgt(utc, r);
 
-	TAILQ_REMOVE(&utc->vm_info->regions, r, link);
+	umap_unlink_region(utc->vm_info, r);
 
 	/*
 	 * Synchronize change to translation tables. Even though the pager
@@ -374,7 +595,7 @@ TEE_Result vm_remap(struct user_ta_ctx *utc, vaddr_t *new_va, vaddr_t old_va,
 	return TEE_SUCCESS;
 
 err_restore_map_rem_reg:
-	TAILQ_REMOVE(&utc->vm_info->regions, r, link);
+	umap_unlink_region(utc->vm_info, r);
 err_restore_map:
 	r->va = old_va;
 	if (umap_add_region(utc->vm_info, r, 0, 0))
@@ -451,7 +672,7 @@ TEE_Result vm_set_prot(struct user_ta_ctx *utc, vaddr_t va, size_t len,
 
 static void umap_remove_region(struct vm_info *vmi, struct vm_region *reg)
 {
-	TAILQ_REMOVE(&vmi->regions, reg, link);
+	umap_unlink_region(vmi, reg);
 	if (reg->flags & VM_FLAG_EXCLUSIVE_MOBJ)
 		mobj_free(reg->mobj);
 	free(reg);
@@ -526,6 +747,7 @@ TEE_Result vm_info_init(struct user_ta_ctx *utc)
 		return TEE_ERROR_OUT_OF_MEMORY;
 	}
 	TAILQ_INIT(&utc->vm_info->regions);
+	TAILQ_INIT(&utc->vm_info->param_cache);
 	utc->vm_info->asid = asid;
 
 	res = map_kinit(utc);
@@ -534,21 +756,93 @@ TEE_Result vm_info_init(struct user_ta_ctx *utc)
 	return res;
 }
 
+static void free_param_cache(struct vm_info *vmi)
+{
+	struct vm_region *r = NULL;
+
+	while ((r = TAILQ_FIRST(&vmi->param_cache))) {
+		TAILQ_REMOVE(&vmi->param_cache, r, link);
+		free(r);
+	}
+}
+
+/*
+ * Returns a region of the last invoke which mapped the same range of
+ * @mobj. Only the mobj pointer is compared, the mobj of the last invoke
+ * may have been freed since.
+ */
+static struct vm_region *get_cached_param_reg(struct vm_info *vmi,
+					      struct mobj *mobj, size_t offs,
+					      size_t size)
+{
+	struct vm_region *r = NULL;
+
+	TAILQ_FOREACH(r, &vmi->param_cache, link) {
+		if (r->mobj == mobj && r->offset == offs &&
+		    r->size == ROUNDUP(size, SMALL_PAGE_SIZE)) {
+			TAILQ_REMOVE(&vmi->param_cache, r, link);
+			return r;
+		}
+	}
+
+	return NULL;
+}
+
 void tee_mmu_clean_param(struct user_ta_ctx *utc)
 {
 	struct vm_region *next_r;
 	struct vm_region *r;
 
+	free_param_cache(utc->vm_info);
+
 	TAILQ_FOREACH_SAFE(r, &utc->vm_info->regions, link, next_r) {
 		if (r->flags & VM_FLAG_EPHEMERAL) {
-			if (mobj_is_paged(r->mobj))
+			if (mobj_is_paged(r->mobj)) {
 				tee_pager_rem_uta_region(utc, r->va, r->size);
+				maybe_free_pgt(utc, r);
+				umap_remove_region(utc->vm_info, r);
+				continue;
+			}
 			maybe_free_pgt(utc, r);
-			umap_remove_region(utc->vm_info, r);
+			umap_unlink_region(utc->vm_info, r);
+			TAILQ_INSERT_TAIL(&utc->vm_info->param_cache, r, link);
 		}
 	}
 }
 
+static TEE_Result map_param_mem(struct user_ta_ctx *utc,
+				struct param_mem *mem)
+{
+	uint32_t prot = TEE_MATTR_PRW | TEE_MATTR_URW;
+	const uint32_t flags = VM_FLAG_EPHEMERAL | VM_FLAG_SHAREABLE;
+	TEE_Result res = TEE_SUCCESS;
+	struct vm_region *reg = NULL;
+	vaddr_t va = 0;
+
+	if (mem->read_only)
+		prot = TEE_MATTR_PR | TEE_MATTR_UR;
+
+	reg = get_cached_param_reg(utc->vm_info, mem->mobj, mem->offs,
+				   mem->size);
+	if (!reg)
+		return vm_map(utc, &va, mem->size, prot, flags, mem->mobj,
+			      mem->offs);
+
+	/* Try the address used last time, else any free address */
+	va = reg->va;
+	res = vm_map_reg(utc, reg, &va, mem->size, prot, flags, mem->mobj,
+			 mem->offs, 0, 0);
+	if (res == TEE_ERROR_ACCESS_CONFLICT) {
+		va = 0;
+		res = vm_map_reg(utc, reg, &va, mem->size, prot, flags,
+				 mem->mobj, mem->offs, 0, 0);
+	}
+	if (res)
+		free(reg);
+
+	return res;
+}
+
 static void check_param_map_empty(struct user_ta_ctx *utc __maybe_unused)
 {
 	struct vm_region *r = NULL;
@@ -570,6 +864,9 @@ static TEE_Result param_mem_to_user_va(struct user_ta_ctx *utc,
 			continue;
 		if (mem->mobj != region->mobj)
 			continue;
+		/* Overlapping entries with different permissions */
+		if (mem->read_only == !!(region->attr & TEE_MATTR_UW))
+			continue;
 		if (mem->offs < region->offset)
 			continue;
 		if (mem->offs >= (region->offset + region->size))
@@ -637,6 +934,7 @@ TEE_Result tee_mmu_map_param(struct user_ta_ctx *utc,
 		mem[n].size = ROUNDUP(phys_offs + param->u[n].mem.offs -
 				      mem[n].offs + param->u[n].mem.size,
 				      CORE_MMU_USER_PARAM_SIZE);
+		mem[n].read_only = param->u[n].mem.read_only;
 	}
 
 	/*
@@ -649,12 +947,21 @@ TEE_Result tee_mmu_map_param(struct user_ta_ctx *utc,
 	 */
 	qsort(mem, TEE_NUM_PARAMS, sizeof(struct param_mem), cmp_param_mem);
 
+	/*
+	 * Adjacent or overlapping entries are only merged if they're mapped
+	 * with the same permissions. A read-only entry overlapping a
+	 * read-write entry is mapped separately, or the pages only covered
+	 * by the read-only entry would become writable.
+	 */
 	for (n = 1, m = 0; n < TEE_NUM_PARAMS && mem[n].size; n++) {
 		if (mem[n].mobj == mem[m].mobj &&
+		    mem[n].read_only == mem[m].read_only &&
 		    (mem[n].offs == (mem[m].offs + mem[m].size) ||
 		     core_is_buffer_intersect(mem[m].offs, mem[m].size,
 					      mem[n].offs, mem[n].size))) {
-			mem[m].size = mem[n].offs + mem[n].size - mem[m].offs;
+			mem[m].size = MAX(mem[m].offs + mem[m].size,
+					  mem[n].offs + mem[n].size) -
+				      mem[m].offs;
 			continue;
 		}
 		m++;
@@ -672,12 +979,7 @@ TEE_Result tee_mmu_map_param(struct user_ta_ctx *utc,
 	check_param_map_empty(utc);
 
 	for (n = 0; n < m; n++) {
-		vaddr_t va = 0;
-
-		res = vm_map(utc, &va, mem[n].size,
-			     TEE_MATTR_PRW | TEE_MATTR_URW,
-			     VM_FLAG_EPHEMERAL | VM_FLAG_SHAREABLE,
-			     mem[n].mobj, mem[n].offs);
+		res = map_param_mem(utc, mem + n);
 		if (res)
 			goto out;
 	}
@@ -762,9 +1064,11 @@ void vm_info_final(struct user_ta_ctx *utc)
 	tlbi_asid(utc->vm_info->asid);
 
 	asid_free(utc->vm_info->asid);
+	free_param_cache(utc->vm_info);
 	while (!TAILQ_EMPTY(&utc->vm_info->regions))
 		umap_remove_region(utc->vm_info,
 				   TAILQ_FIRST(&utc->vm_info->regions));
+	free(utc->vm_info->regions_by_va);
 	free(utc->vm_info);
 	utc->vm_info = NULL;
 }
@@ -773,25 +1077,26 @@ void vm_info_final(struct user_ta_ctx *utc)
 bool tee_mmu_is_vbuf_inside_ta_private(const struct user_ta_ctx *utc,
 				  const void *va, size_t size)
 {
-	struct vm_region *r = NULL;
-
-	TAILQ_FOREACH(r, &utc->vm_info->regions, link) {
-		if (r->flags & VM_FLAGS_NONPRIV)
-			continue;
-		if (core_is_buffer_inside(va, size, r->va, r->size))
-			return true;
-	}
+	struct vm_region *r = find_vm_region(utc->vm_info, (vaddr_t)va);
 
-	return false;
+	/* Regions don't overlap, only the one containing @va can match */
+	return r && !(r->flags & VM_FLAGS_NONPRIV) &&
+	       core_is_buffer_inside(va, size, r->va, r->size);
 }
 
 /* return true only if buffer intersects TA private memory */
 bool tee_mmu_is_vbuf_intersect_ta_private(const struct user_ta_ctx *utc,
 					  const void *va, size_t size)
 {
+	const struct vm_info *vmi = utc->vm_info;
 	struct vm_region *r = NULL;
+	size_t n = 0;
 
-	TAILQ_FOREACH(r, &utc->vm_info->regions, link) {
+	for (n = vm_region_lower_bound(vmi, (vaddr_t)va);
+	     n < vmi->num_regions; n++) {
+		r = vmi->regions_by_va[n];
+		if (r->va >= (vaddr_t)va && r->va - (vaddr_t)va >= size)
+			break;
 		if (r->attr & VM_FLAGS_NONPRIV)
 			continue;
 		if (core_is_buffer_intersect(va, size, r->va, r->size))
@@ -805,68 +1110,57 @@ TEE_Result tee_mmu_vbuf_to_mobj_offs(const struct user_ta_ctx *utc,
 				     const void *va, size_t size,
 				     struct mobj **mobj, size_t *offs)
 {
-	struct vm_region *r;
+	struct vm_region *r = find_vm_region(utc->vm_info, (vaddr_t)va);
+	size_t poffs;
 
-	TAILQ_FOREACH(r, &utc->vm_info->regions, link) {
-		if (!r->mobj)
-			continue;
-		if (core_is_buffer_inside(va, size, r->va, r->size)) {
-			size_t poffs;
-
-			poffs = mobj_get_phys_offs(r->mobj,
-						   CORE_MMU_USER_PARAM_SIZE);
-			*mobj = r->mobj;
-			*offs = (vaddr_t)va - r->va + r->offset - poffs;
-			return TEE_SUCCESS;
-		}
-	}
+	if (!r || !r->mobj || !core_is_buffer_inside(va, size, r->va, r->size))
+		return TEE_ERROR_BAD_PARAMETERS;
 
-	return TEE_ERROR_BAD_PARAMETERS;
+	poffs = mobj_get_phys_offs(r->mobj, CORE_MMU_USER_PARAM_SIZE);
+	*mobj = r->mobj;
+	*offs = (vaddr_t)va - r->va + r->offset - poffs;
+	return TEE_SUCCESS;
 }
 
 static TEE_Result tee_mmu_user_va2pa_attr(const struct user_ta_ctx *utc,
 			void *ua, paddr_t *pa, uint32_t *attr)
 {
-	struct vm_region *region;
+	struct vm_region *region = find_vm_region(utc->vm_info, (vaddr_t)ua);
 
-	TAILQ_FOREACH(region, &utc->vm_info->regions, link) {
-		if (!core_is_buffer_inside(ua, 1, region->va, region->size))
-			continue;
+	if (!region)
+		return TEE_ERROR_ACCESS_DENIED;
 
-		if (pa) {
-			TEE_Result res;
-			paddr_t p;
-			size_t offset;
-			size_t granule;
-
-			/*
-			 * mobj and input user address may each include
-			 * a specific offset-in-granule position.
-			 * Drop both to get target physical page base
-			 * address then apply only user address
-			 * offset-in-granule.
-			 * Mapping lowest granule is the small page.
-			 */
-			granule = MAX(region->mobj->phys_granule,
-				      (size_t)SMALL_PAGE_SIZE);
-			assert(!granule || IS_POWER_OF_TWO(granule));
-
-			offset = region->offset +
-				 ROUNDDOWN((vaddr_t)ua - region->va, granule);
-
-			res = mobj_get_pa(region->mobj, offset, granule, &p);
-			if (res != TEE_SUCCESS)
-				return res;
+	if (pa) {
+		TEE_Result res;
+		paddr_t p;
+		size_t offset;
+		size_t granule;
 
-			*pa = p | ((vaddr_t)ua & (granule - 1));
-		}
-		if (attr)
-			*attr = region->attr;
+		/*
+		 * mobj and input user address may each include
+		 * a specific offset-in-granule position.
+		 * Drop both to get target physical page base
+		 * address then apply only user address
+		 * offset-in-granule.
+		 * Mapping lowest granule is the small page.
+		 */
+		granule = MAX(region->mobj->phys_granule,
+			      (size_t)SMALL_PAGE_SIZE);
+		assert(!granule || IS_POWER_OF_TWO(granule));
 
-		return TEE_SUCCESS;
+		offset = region->offset +
+			 ROUNDDOWN((vaddr_t)ua - region->va, granule);
+
+		res = mobj_get_pa(region->mobj, offset, granule, &p);
+		if (res != TEE_SUCCESS)
+			return res;
+
+		*pa = p | ((vaddr_t)ua & (granule - 1));
 	}
+	if (attr)
+		*attr = region->attr;
 
-	return TEE_ERROR_ACCESS_DENIED;
+	return TEE_SUCCESS;
 }
 
 TEE_Result tee_mmu_user_va2pa_helper(const struct user_ta_ctx *utc, void *ua,
@@ -930,6 +1224,7 @@ TEE_Result tee_mmu_check_access_rights(const struct user_ta_ctx *utc,
 				       uint32_t flags, uaddr_t uaddr,
 				       size_t len)
 {
+	struct vm_region *r = NULL;
 	uaddr_t a;
 	uaddr_t end_addr = 0;
 	size_t addr_incr = MIN(CORE_MMU_USER_CODE_SIZE,
@@ -950,26 +1245,36 @@ TEE_Result tee_mmu_check_access_rights(const struct user_ta_ctx *utc,
 	   !tee_mmu_is_vbuf_inside_ta_private(utc, (void *)uaddr, len))
 		return TEE_ERROR_ACCESS_DENIED;
 
-	for (a = ROUNDDOWN(uaddr, addr_incr); a < end_addr; a += addr_incr) {
-		uint32_t attr;
-		TEE_Result res;
-
-		res = tee_mmu_user_va2pa_attr(utc, (void *)a, NULL, &attr);
-		if (res != TEE_SUCCESS)
-			return res;
+	/*
+	 * Regions are sorted by address, so the range is checked with a
+	 * single pass over the regions, a whole region at a time, starting
+	 * with the one found with a binary search.
+	 */
+	a = ROUNDDOWN(uaddr, addr_incr);
+	r = find_vm_region(utc->vm_info, a);
+	while (a < end_addr) {
+		while (r && a >= r->va && a - r->va >= r->size)
+			r = TAILQ_NEXT(r, link);
+		if (!r || a < r->va)
+			return TEE_ERROR_ACCESS_DENIED;
 
 		if ((flags & TEE_MEMORY_ACCESS_NONSECURE) &&
-		    (attr & TEE_MATTR_SECURE))
+		    (r->attr & TEE_MATTR_SECURE))
 			return TEE_ERROR_ACCESS_DENIED;
 
 		if ((flags & TEE_MEMORY_ACCESS_SECURE) &&
-		    !(attr & TEE_MATTR_SECURE))
+		    !(r->attr & TEE_MATTR_SECURE))
 			return TEE_ERROR_ACCESS_DENIED;
 
-		if ((flags & TEE_MEMORY_ACCESS_WRITE) && !(attr & TEE_MATTR_UW))
+		if ((flags & TEE_MEMORY_ACCESS_WRITE) &&
+		    !(r->attr & TEE_MATTR_UW))
 			return TEE_ERROR_ACCESS_DENIED;
-		if ((flags & TEE_MEMORY_ACCESS_READ) && !(attr & TEE_MATTR_UR))
+		if ((flags & TEE_MEMORY_ACCESS_READ) &&
+		    !(r->attr & TEE_MATTR_UR))
 			return TEE_ERROR_ACCESS_DENIED;
+
+		if (ADD_OVERFLOW(r->va, r->size, &a))
+			break;
 	}
 
 	return TEE_SUCCESS;
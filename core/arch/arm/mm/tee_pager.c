@@ -6,17 +6,20 @@
 
 #include <arm.h>
 #include <assert.h>
+#include <config.h>
 #include <io.h>
 #include <keep.h>
 #include <kernel/abort.h>
 #include <kernel/asan.h>
 #include <kernel/cache_helpers.h>
+#include <kernel/lock_stats.h>
 #include <kernel/panic.h>
 #include <kernel/spinlock.h>
 #include <kernel/tee_misc.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread.h>
 #include <kernel/tlb_helpers.h>
+#include <kernel/tracepoint.h>
 #include <mm/core_memprot.h>
 #include <mm/fobj.h>
 #include <mm/tee_mm.h>
@@ -36,11 +39,14 @@ static struct tee_pager_area_head tee_pager_area_head =
 #define INVALID_PGIDX		UINT_MAX
 #define PMEM_FLAG_DIRTY		BIT(0)
 #define PMEM_FLAG_HIDDEN	BIT(1)
+#define PMEM_FLAG_FAULT_AROUND	BIT(2)
 
 /*
  * struct tee_pager_pmem - Represents a physical page used for paging.
  *
  * @flags	flags defined by PMEM_FLAG_* above
+ * @pin_count	number of user TA areas which pinned the page, a pinned
+ *		page is neither hidden nor evicted
  * @fobj_pgidx	index of the page in the @fobj
  * @fobj	File object of which a page is made visible.
  * @va_alias	Virtual address where the physical page always is aliased.
@@ -49,6 +55,7 @@ static struct tee_pager_area_head tee_pager_area_head =
  */
 struct tee_pager_pmem {
 	unsigned int flags;
+	unsigned int pin_count;
 	unsigned int fobj_pgidx;
 	struct fobj *fobj;
 	void *va_alias;
@@ -98,6 +105,16 @@ static inline void incr_npages_all(void)
 	pager_stats.npages_all++;
 }
 
+static inline void incr_fault_around_loads(void)
+{
+	pager_stats.fault_around_loads++;
+}
+
+static inline void incr_fault_around_hits(void)
+{
+	pager_stats.fault_around_hits++;
+}
+
 static inline void set_npages(void)
 {
 	pager_stats.npages = tee_pager_npages;
@@ -111,6 +128,8 @@ void tee_pager_get_stats(struct tee_pager_stats *stats)
 	pager_stats.ro_hits = 0;
 	pager_stats.rw_hits = 0;
 	pager_stats.zi_released = 0;
+	pager_stats.fault_around_loads = 0;
+	pager_stats.fault_around_hits = 0;
 }
 
 #else /* CFG_WITH_STATS */
@@ -119,6 +138,8 @@ static inline void incr_rw_hits(void) { }
 static inline void incr_hidden_hits(void) { }
 static inline void incr_zi_released(void) { }
 static inline void incr_npages_all(void) { }
+static inline void incr_fault_around_loads(void) { }
+static inline void incr_fault_around_hits(void) { }
 static inline void set_npages(void) { }
 
 void tee_pager_get_stats(struct tee_pager_stats *stats)
@@ -127,6 +148,44 @@ void tee_pager_get_stats(struct tee_pager_stats *stats)
 }
 #endif /* CFG_WITH_STATS */
 
+#ifdef CFG_PAGER_PROFILE
+/* Order of the last first fault on a profiled page */
+static uint32_t profile_seq;
+
+static void profile_alloc(struct tee_pager_area *area)
+{
+	area->profile = calloc(area->size / SMALL_PAGE_SIZE,
+			       sizeof(*area->profile));
+	if (!area->profile)
+		panic("alloc_profile");
+}
+
+static void profile_page_fault(struct tee_pager_area *area, vaddr_t page_va)
+{
+	struct tee_pager_page_profile *prof = NULL;
+
+	if (!area->profile)
+		return;
+
+	prof = area->profile + ((page_va - area->base) >> SMALL_PAGE_SHIFT);
+	if (!prof->faults) {
+		prof->va = page_va;
+		prof->first_fault = ++profile_seq;
+	}
+	if (prof->faults < UINT32_MAX)
+		prof->faults++;
+}
+#else
+static void profile_alloc(struct tee_pager_area *area __unused)
+{
+}
+
+static void profile_page_fault(struct tee_pager_area *area __unused,
+			       vaddr_t page_va __unused)
+{
+}
+#endif /*CFG_PAGER_PROFILE*/
+
 #define TBL_NUM_ENTRIES	(CORE_MMU_PGDIR_SIZE / SMALL_PAGE_SIZE)
 #define TBL_LEVEL	CORE_MMU_PGDIR_LEVEL
 #define TBL_SHIFT	SMALL_PAGE_SHIFT
@@ -152,12 +211,42 @@ static tee_mm_entry_t *pager_alias_area;
  */
 static uintptr_t pager_alias_next_free;
 
-#ifdef CFG_TEE_CORE_DEBUG
-#define pager_lock(ai) pager_lock_dldetect(__func__, __LINE__, ai)
+#ifdef CFG_LOCK_STATS
+/* Site and time pager_spinlock was taken, protected by the lock itself */
+static struct lock_stats_site *pager_lock_site;
+static uint64_t pager_lock_time;
+
+static void pager_lock_stats(const char *func, int line, uint64_t begin,
+			     bool contended)
+{
+	pager_lock_site = lock_stats_acquired(&pager_spinlock, func, line,
+					      LOCK_STATS_TYPE_SPINLOCK,
+					      begin, contended);
+	pager_lock_time = lock_stats_now();
+}
+
+static void pager_unlock_stats(void)
+{
+	lock_stats_released(pager_lock_site, pager_lock_time);
+}
+#else
+static void pager_lock_stats(const char *func __unused, int line __unused,
+			     uint64_t begin __unused, bool contended __unused)
+{
+}
+
+static void pager_unlock_stats(void)
+{
+}
+#endif
 
-static uint32_t pager_lock_dldetect(const char *func, const int line,
-				    struct abort_info *ai)
+#define pager_lock(ai) pager_lock_at(__func__, __LINE__, ai)
+
+#ifdef CFG_TEE_CORE_DEBUG
+static uint32_t pager_lock_at(const char *func, const int line,
+			      struct abort_info *ai)
 {
+	uint64_t begin = lock_stats_now();
 	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
 	unsigned int retries = 0;
 	unsigned int reminder = 0;
@@ -175,17 +264,37 @@ static uint32_t pager_lock_dldetect(const char *func, const int line,
 				abort_print(ai);
 		}
 	}
+	pager_lock_stats(func, line, begin, retries || reminder);
 
 	return exceptions;
 }
 #else
-static uint32_t pager_lock(struct abort_info __unused *ai)
+static uint32_t pager_lock_at(const char *func __maybe_unused,
+			      const int line __maybe_unused,
+			      struct abort_info __unused *ai)
 {
-	return cpu_spin_lock_xsave(&pager_spinlock);
+	uint64_t begin = lock_stats_now();
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	bool contended = false;
+
+	if (IS_ENABLED(CFG_LOCK_STATS)) {
+		contended = !cpu_spin_trylock(&pager_spinlock);
+		if (contended)
+			cpu_spin_lock(&pager_spinlock);
+	} else {
+		cpu_spin_lock(&pager_spinlock);
+	}
+	pager_lock_stats(func, line, begin, contended);
+
+	return exceptions;
 }
 #endif
 
-static uint32_t pager_lock_check_stack(size_t stack_size)
+#define pager_lock_check_stack(stack_size) \
+	pager_lock_check_stack_at(__func__, __LINE__, (stack_size))
+
+static uint32_t pager_lock_check_stack_at(const char *func, const int line,
+					  size_t stack_size)
 {
 	if (stack_size) {
 		int8_t buf[stack_size];
@@ -204,11 +313,12 @@ static uint32_t pager_lock_check_stack(size_t stack_size)
 		io_write8((vaddr_t)buf + stack_size - 1, 1);
 	}
 
-	return pager_lock(NULL);
+	return pager_lock_at(func, line, NULL);
 }
 
 static void pager_unlock(uint32_t exceptions)
 {
+	pager_unlock_stats();
 	cpu_spin_unlock_xrestore(&pager_spinlock, exceptions);
 }
 
@@ -427,7 +537,93 @@ static void area_tlbi_entry(struct tee_pager_area *area, size_t idx)
 	tlbi_mva_allasid(va);
 }
 
-static void pmem_unmap(struct tee_pager_pmem *pmem, struct pgt *only_this_pgt)
+#define TLBI_BATCH_MAX_ENTRIES	16
+#define TLBI_BATCH_ALL_ASID	UINT32_MAX
+
+/*
+ * struct tlbi_batch - TLB invalidations collected while unmapping pages
+ * @count:	number of invalidations, only the first TLBI_BATCH_MAX_ENTRIES
+ *		are recorded in @va and @asid
+ * @common_asid: ASID shared by all invalidations or TLBI_BATCH_ALL_ASID
+ *		if they're for core mappings or different ASIDs
+ * @va:		virtual address to invalidate
+ * @asid:	ASID of @va or TLBI_BATCH_ALL_ASID for a core mapping
+ *
+ * The invalidations are issued with a single set of barriers by
+ * tlbi_batch_flush(). If there are more than TLBI_BATCH_MAX_ENTRIES the
+ * whole ASID, or everything, is invalidated instead. Only used with the
+ * pager lock held.
+ */
+struct tlbi_batch {
+	size_t count;
+	uint32_t common_asid;
+	vaddr_t va[TLBI_BATCH_MAX_ENTRIES];
+	uint32_t asid[TLBI_BATCH_MAX_ENTRIES];
+};
+
+static struct tlbi_batch pager_tlbi_batch;
+
+static void tlbi_batch_add(struct tlbi_batch *b, vaddr_t va, uint32_t asid)
+{
+	if (b->count < TLBI_BATCH_MAX_ENTRIES) {
+		b->va[b->count] = va;
+		b->asid[b->count] = asid;
+	}
+	if (!b->count)
+		b->common_asid = asid;
+	else if (b->common_asid != asid)
+		b->common_asid = TLBI_BATCH_ALL_ASID;
+	b->count++;
+}
+
+static void tlbi_batch_flush(struct tlbi_batch *b)
+{
+	size_t n = 0;
+
+	if (!b->count)
+		return;
+
+	if (b->count > TLBI_BATCH_MAX_ENTRIES) {
+		if (b->common_asid == TLBI_BATCH_ALL_ASID)
+			tlbi_all();
+		else
+			tlbi_asid(b->common_asid);
+	} else {
+		dsb_ishst();
+		for (n = 0; n < b->count; n++) {
+			if (b->asid[n] == TLBI_BATCH_ALL_ASID)
+				tlbi_mva_allasid_nosync(b->va[n]);
+			else
+				tlbi_mva_asid_nosync(b->va[n], b->asid[n]);
+		}
+		dsb_ish();
+		isb();
+	}
+
+	b->count = 0;
+}
+
+static void area_tlbi_entry_batch(struct tee_pager_area *area, size_t idx,
+				  struct tlbi_batch *b)
+{
+	uint32_t asid = TLBI_BATCH_ALL_ASID;
+
+#if defined(CFG_PAGED_USER_TA)
+	assert(area->pgt);
+	if (area->pgt->ctx)
+		asid = to_user_ta_ctx(area->pgt->ctx)->vm_info->asid;
+#endif
+	tlbi_batch_add(b, area_idx2va(area, idx), asid);
+}
+
+/*
+ * Unmaps @pmem from all areas, or only the one using @only_this_pgt if
+ * not NULL. The TLB invalidations are added to @batch if not NULL,
+ * otherwise they're done before returning.
+ */
+static void pmem_unmap_batch(struct tee_pager_pmem *pmem,
+			     struct pgt *only_this_pgt,
+			     struct tlbi_batch *batch)
 {
 	struct tee_pager_area *area = NULL;
 	size_t tblidx = 0;
@@ -447,11 +643,19 @@ static void pmem_unmap(struct tee_pager_pmem *pmem, struct pgt *only_this_pgt)
 		if (a & TEE_MATTR_VALID_BLOCK) {
 			area_set_entry(area, tblidx, 0, 0);
 			pgt_dec_used_entries(area->pgt);
-			area_tlbi_entry(area, tblidx);
+			if (batch)
+				area_tlbi_entry_batch(area, tblidx, batch);
+			else
+				area_tlbi_entry(area, tblidx);
 		}
 	}
 }
 
+static void pmem_unmap(struct tee_pager_pmem *pmem, struct pgt *only_this_pgt)
+{
+	pmem_unmap_batch(pmem, only_this_pgt, NULL);
+}
+
 void tee_pager_early_init(void)
 {
 	size_t n;
@@ -555,6 +759,7 @@ void tee_pager_add_core_area(vaddr_t base, enum tee_pager_area_type type,
 		area->base = b;
 		area->size = s2;
 		area->flags = flags;
+		profile_alloc(area);
 		area_insert_tail(area);
 
 		b += s2;
@@ -674,6 +879,44 @@ static void tee_pager_save_page(struct tee_pager_pmem *pmem)
 }
 
 #ifdef CFG_PAGED_USER_TA
+/* Number of pages with a non-zero pin_count */
+static size_t pager_pinned_pages;
+
+static void pmem_pin(struct tee_pager_pmem *pmem)
+{
+	if (!pmem->pin_count)
+		pager_pinned_pages++;
+	pmem->pin_count++;
+}
+
+static void pmem_unpin(struct tee_pager_pmem *pmem)
+{
+	assert(pmem->pin_count);
+	pmem->pin_count--;
+	if (!pmem->pin_count)
+		pager_pinned_pages--;
+}
+
+/* Releases the pages pinned in @area, called with the pager lock held */
+static void unpin_area(struct tee_pager_area *area)
+{
+	struct tee_pager_pmem *pmem = NULL;
+	size_t n = 0;
+
+	if (!area->pinned)
+		return;
+
+	TAILQ_FOREACH(pmem, &tee_pager_pmem_head, link) {
+		if (!pmem_is_covered_by_area(pmem, area))
+			continue;
+		n = pmem->fobj_pgidx - area->fobj_pgoffs;
+		if (bit_test(area->pinned, n)) {
+			bit_clear(area->pinned, n);
+			pmem_unpin(pmem);
+		}
+	}
+}
+
 static void unlink_area(struct tee_pager_area_head *area_head,
 			struct tee_pager_area *area)
 {
@@ -681,6 +924,7 @@ static void unlink_area(struct tee_pager_area_head *area_head,
 
 	TAILQ_REMOVE(area_head, area, link);
 	TAILQ_REMOVE(&area->fobj->areas, area, fobj_link);
+	unpin_area(area);
 
 	pager_unlock(exceptions);
 }
@@ -689,6 +933,7 @@ KEEP_PAGER(unlink_area);
 static void free_area(struct tee_pager_area *area)
 {
 	fobj_put(area->fobj);
+	free(area->pinned);
 	free(area);
 }
 
@@ -822,6 +1067,7 @@ static void rem_area(struct tee_pager_area_head *area_head,
 
 	TAILQ_REMOVE(area_head, area, link);
 	TAILQ_REMOVE(&area->fobj->areas, area, fobj_link);
+	unpin_area(area);
 
 	TAILQ_FOREACH(pmem, &tee_pager_pmem_head, link) {
 		if (pmem->fobj != area->fobj ||
@@ -1079,7 +1325,12 @@ static bool tee_pager_unhide_page(struct tee_pager_area *area,
 
 	TAILQ_REMOVE(&tee_pager_pmem_head, pmem, link);
 	TAILQ_INSERT_TAIL(&tee_pager_pmem_head, pmem, link);
-	incr_hidden_hits();
+	if (pmem->flags & PMEM_FLAG_FAULT_AROUND) {
+		pmem->flags &= ~PMEM_FLAG_FAULT_AROUND;
+		incr_fault_around_hits();
+	} else {
+		incr_hidden_hits();
+	}
 	return true;
 }
 
@@ -1094,15 +1345,17 @@ static void tee_pager_hide_pages(void)
 		n++;
 
 		/* we cannot hide pages when pmem->fobj is not defined. */
-		if (!pmem->fobj)
+		if (!pmem->fobj || pmem->pin_count)
 			continue;
 
 		if (pmem_is_hidden(pmem))
 			continue;
 
 		pmem->flags |= PMEM_FLAG_HIDDEN;
-		pmem_unmap(pmem, NULL);
+		pmem_unmap_batch(pmem, NULL, &pager_tlbi_batch);
 	}
+
+	tlbi_batch_flush(&pager_tlbi_batch);
 }
 
 /*
@@ -1145,12 +1398,57 @@ static bool tee_pager_release_one_phys(struct tee_pager_area *area,
 	return false;
 }
 
-/* Finds the oldest page and unmaps it from all tables */
+/* Returns the oldest page which isn't pinned by a user TA */
+static struct tee_pager_pmem *first_unpinned(void)
+{
+	struct tee_pager_pmem *pmem = NULL;
+
+	TAILQ_FOREACH(pmem, &tee_pager_pmem_head, link)
+		if (!pmem->pin_count)
+			break;
+
+	return pmem;
+}
+
+/*
+ * With CFG_PAGER_CLOCK pages are only hidden when they're considered for
+ * eviction. A page at the head of the list which is mapped has been used
+ * since it was last considered, it's hidden and given a second chance at
+ * the tail. A free or hidden page at the head is the one to evict. This
+ * takes at most one pass over the list since each page passed is hidden.
+ *
+ * Without CFG_PAGER_CLOCK the oldest third of the pages is hidden on each
+ * fault and the page at the head is evicted.
+ *
+ * Pages pinned by user TAs are skipped in both cases.
+ */
+static struct tee_pager_pmem *pager_select_page(void)
+{
+	struct tee_pager_pmem *pmem = first_unpinned();
+
+	if (!IS_ENABLED(CFG_PAGER_CLOCK))
+		return pmem;
+
+	while (pmem && pmem->fobj && !pmem_is_hidden(pmem)) {
+		pmem->flags |= PMEM_FLAG_HIDDEN;
+		pmem_unmap_batch(pmem, NULL, &pager_tlbi_batch);
+		TAILQ_REMOVE(&tee_pager_pmem_head, pmem, link);
+		TAILQ_INSERT_TAIL(&tee_pager_pmem_head, pmem, link);
+		pmem = first_unpinned();
+	}
+
+	/* The selected page may be one just hidden, it's about to be reused */
+	tlbi_batch_flush(&pager_tlbi_batch);
+
+	return pmem;
+}
+
+/* Finds the page to evict and unmaps it from all tables */
 static struct tee_pager_pmem *tee_pager_get_page(enum tee_pager_area_type at)
 {
 	struct tee_pager_pmem *pmem;
 
-	pmem = TAILQ_FIRST(&tee_pager_pmem_head);
+	pmem = pager_select_page();
 	if (!pmem) {
 		EMSG("No pmem entries");
 		return NULL;
@@ -1268,6 +1566,179 @@ static bool pager_update_permissions(struct tee_pager_area *area,
 	return true;
 }
 
+static unsigned int area_va2fobj_pgidx(struct tee_pager_area *area,
+				       vaddr_t va)
+{
+	return area_va2idx(area, va) + area->fobj_pgoffs -
+	       ((area->base & CORE_MMU_PGDIR_MASK) >> SMALL_PAGE_SHIFT);
+}
+
+/*
+ * Loads the page at @page_va in @area into a page selected for eviction
+ * and maps it. Returns NULL if there's no page to use.
+ */
+static struct tee_pager_pmem *pager_map_new_page(struct tee_pager_area *area,
+						 vaddr_t page_va,
+						 bool clean_user_cache)
+{
+	struct tee_pager_pmem *pmem = NULL;
+	size_t tblidx = 0;
+	uint32_t attr = 0;
+	paddr_t pa = 0;
+
+	pmem = tee_pager_get_page(area->type);
+	if (!pmem)
+		return NULL;
+
+	/* load page code & data */
+	tee_pager_load_page(area, page_va, pmem->va_alias);
+
+	pmem->fobj = area->fobj;
+	pmem->fobj_pgidx = area_va2fobj_pgidx(area, page_va);
+	tblidx = pmem_get_area_tblidx(pmem, area);
+	attr = get_area_mattr(area->flags);
+	/*
+	 * Pages from PAGER_AREA_TYPE_RW starts read-only to be
+	 * able to tell when they are updated and should be tagged
+	 * as dirty.
+	 */
+	if (area->type == PAGER_AREA_TYPE_RW)
+		attr &= ~(TEE_MATTR_PW | TEE_MATTR_UW);
+	pa = get_pmem_pa(pmem);
+
+	/*
+	 * We've updated the page using the aliased mapping and
+	 * some cache maintenence is now needed if it's an
+	 * executable page.
+	 *
+	 * Since the d-cache is a Physically-indexed,
+	 * physically-tagged (PIPT) cache we can clean either the
+	 * aliased address or the real virtual address. In this
+	 * case we choose the real virtual address.
+	 *
+	 * The i-cache can also be PIPT, but may be something else
+	 * too like VIPT. The current code requires the caches to
+	 * implement the IVIPT extension, that is:
+	 * "instruction cache maintenance is required only after
+	 * writing new data to a physical address that holds an
+	 * instruction."
+	 *
+	 * To portably invalidate the icache the page has to
+	 * be mapped at the final virtual address but not
+	 * executable.
+	 */
+	if (area->flags & (TEE_MATTR_PX | TEE_MATTR_UX)) {
+		uint32_t mask = TEE_MATTR_PX | TEE_MATTR_UX |
+				TEE_MATTR_PW | TEE_MATTR_UW;
+		void *va = (void *)page_va;
+
+		/* Set a temporary read-only mapping */
+		area_set_entry(area, tblidx, pa, attr & ~mask);
+		area_tlbi_entry(area, tblidx);
+
+		dcache_clean_range_pou(va, SMALL_PAGE_SIZE);
+		if (clean_user_cache)
+			icache_inv_user_range(va, SMALL_PAGE_SIZE);
+		else
+			icache_inv_range(va, SMALL_PAGE_SIZE);
+
+		/* Set the final mapping */
+		area_set_entry(area, tblidx, pa, attr);
+		area_tlbi_entry(area, tblidx);
+	} else {
+		area_set_entry(area, tblidx, pa, attr);
+		/*
+		 * No need to flush TLB for this entry, it was
+		 * invalid. We should use a barrier though, to make
+		 * sure that the change is visible.
+		 */
+		dsb_ishst();
+	}
+	pgt_inc_used_entries(area->pgt);
+
+	FMSG("Mapped 0x%" PRIxVA " -> 0x%" PRIxPA, page_va, pa);
+
+	return pmem;
+}
+
+/*
+ * Loads the pages following @page_va in @area, as many as configured for
+ * the type of area, as long as there are free physical pages. Nothing
+ * mapped is evicted for this. The pages are left hidden, so the first
+ * access only has to map the page instead of loading it and is counted as
+ * a fault-around hit.
+ */
+static void fault_around(struct tee_pager_area *area, vaddr_t page_va,
+			 bool clean_user_cache)
+{
+	struct tee_pager_pmem *pmem = NULL;
+	size_t num = 0;
+	size_t n = 0;
+
+	switch (area->type) {
+	case PAGER_AREA_TYPE_RO:
+		num = CFG_PAGER_FAULT_AROUND_RO;
+		break;
+	case PAGER_AREA_TYPE_RW:
+		num = CFG_PAGER_FAULT_AROUND_RW;
+		break;
+	default:
+		/* Locked pages are never released, don't take more */
+		return;
+	}
+
+	for (n = 1; n <= num; n++) {
+		vaddr_t va = page_va + n * SMALL_PAGE_SIZE;
+		size_t tblidx = 0;
+		uint32_t attr = 0;
+
+		if (va >= area->base + area->size)
+			break;
+
+		pmem = TAILQ_FIRST(&tee_pager_pmem_head);
+		if (!pmem || pmem->fobj)
+			break;
+
+		tblidx = area_va2idx(area, va);
+		area_get_entry(area, tblidx, NULL, &attr);
+		if ((attr & TEE_MATTR_VALID_BLOCK) || pmem_find(area, tblidx))
+			break;
+
+		pmem = tee_pager_get_page(area->type);
+		tee_pager_load_page(area, va, pmem->va_alias);
+		pmem->fobj = area->fobj;
+		pmem->fobj_pgidx = area_va2fobj_pgidx(area, va);
+		pmem->flags = PMEM_FLAG_HIDDEN | PMEM_FLAG_FAULT_AROUND;
+
+		/*
+		 * Maintain the caches now as the page is only mapped with
+		 * its final permissions when unhidden, see the comment in
+		 * tee_pager_handle_fault().
+		 */
+		if (area->flags & (TEE_MATTR_PX | TEE_MATTR_UX)) {
+			uint32_t mask = TEE_MATTR_PX | TEE_MATTR_UX |
+					TEE_MATTR_PW | TEE_MATTR_UW;
+
+			attr = get_area_mattr(area->flags) & ~mask;
+			area_set_entry(area, tblidx, get_pmem_pa(pmem), attr);
+			area_tlbi_entry(area, tblidx);
+
+			dcache_clean_range_pou((void *)va, SMALL_PAGE_SIZE);
+			if (clean_user_cache)
+				icache_inv_user_range((void *)va,
+						      SMALL_PAGE_SIZE);
+			else
+				icache_inv_range((void *)va, SMALL_PAGE_SIZE);
+
+			area_set_entry(area, tblidx, 0, 0);
+			area_tlbi_entry(area, tblidx);
+		}
+
+		incr_fault_around_loads();
+		FMSG("Loaded 0x%" PRIxVA " around fault", va);
+	}
+}
+
 #ifdef CFG_TEE_CORE_DEBUG
 static void stat_handle_fault(void)
 {
@@ -1292,6 +1763,34 @@ static void stat_handle_fault(void)
 }
 #endif
 
+/*
+ * Returns true if the data access which faulted would succeed if retried
+ * now, because another CPU has mapped the page while this CPU was
+ * trapping. This is checked before taking the pager lock so CPUs faulting
+ * on the same page don't queue up behind the one loading it only to find
+ * the work already done. If the page happens to be unmapped again before
+ * the access is retried it will just fault again.
+ */
+static bool fault_already_resolved(struct abort_info *ai)
+{
+	bool write = false;
+
+	if (ai->abort_type != ABORT_TYPE_DATA ||
+	    core_mmu_get_fault_type(ai->fault_descr) !=
+	    CORE_MMU_FAULT_TRANSLATION)
+		return false;
+
+#ifdef ARM32
+	write = ai->fault_descr & FSR_WNR;
+#endif
+#ifdef ARM64
+	write = ai->fault_descr & ESR_ABT_WNR;
+#endif
+
+	return core_mmu_probe_access(ai->va, abort_is_user_exception(ai),
+				     write);
+}
+
 bool tee_pager_handle_fault(struct abort_info *ai)
 {
 	struct tee_pager_area *area;
@@ -1300,11 +1799,16 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 	bool ret;
 	bool clean_user_cache = false;
 
+	TRACEPOINT(PTA_TRACE_CAT_PAGER, "pager_fault", ai->va, ai->pc);
+
 #ifdef TEE_PAGER_DEBUG_PRINT
 	if (!abort_is_user_exception(ai))
 		abort_print(ai);
 #endif
 
+	if (fault_already_resolved(ai))
+		return true;
+
 	/*
 	 * We're updating pages that can affect several active CPUs at a
 	 * time below. We end up here because a thread tries to access some
@@ -1338,9 +1842,6 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 
 	if (!tee_pager_unhide_page(area, area_va2idx(area, page_va))) {
 		struct tee_pager_pmem *pmem = NULL;
-		uint32_t attr = 0;
-		paddr_t pa = 0;
-		size_t tblidx = 0;
 
 		/*
 		 * The page wasn't hidden, but some other core may have
@@ -1356,92 +1857,96 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 			goto out;
 		}
 
-		pmem = tee_pager_get_page(area->type);
+		pmem = pager_map_new_page(area, page_va, clean_user_cache);
 		if (!pmem) {
 			abort_print(ai);
 			panic();
 		}
+		profile_page_fault(area, page_va);
 
-		/* load page code & data */
-		tee_pager_load_page(area, page_va, pmem->va_alias);
-
-
-		pmem->fobj = area->fobj;
-		pmem->fobj_pgidx = area_va2idx(area, page_va) +
-				   area->fobj_pgoffs -
-				   ((area->base & CORE_MMU_PGDIR_MASK) >>
-					SMALL_PAGE_SHIFT);
-		tblidx = pmem_get_area_tblidx(pmem, area);
-		attr = get_area_mattr(area->flags);
-		/*
-		 * Pages from PAGER_AREA_TYPE_RW starts read-only to be
-		 * able to tell when they are updated and should be tagged
-		 * as dirty.
-		 */
-		if (area->type == PAGER_AREA_TYPE_RW)
-			attr &= ~(TEE_MATTR_PW | TEE_MATTR_UW);
-		pa = get_pmem_pa(pmem);
+		fault_around(area, page_va, clean_user_cache);
+	}
 
-		/*
-		 * We've updated the page using the aliased mapping and
-		 * some cache maintenence is now needed if it's an
-		 * executable page.
-		 *
-		 * Since the d-cache is a Physically-indexed,
-		 * physically-tagged (PIPT) cache we can clean either the
-		 * aliased address or the real virtual address. In this
-		 * case we choose the real virtual address.
-		 *
-		 * The i-cache can also be PIPT, but may be something else
-		 * too like VIPT. The current code requires the caches to
-		 * implement the IVIPT extension, that is:
-		 * "instruction cache maintenance is required only after
-		 * writing new data to a physical address that holds an
-		 * instruction."
-		 *
-		 * To portably invalidate the icache the page has to
-		 * be mapped at the final virtual address but not
-		 * executable.
-		 */
-		if (area->flags & (TEE_MATTR_PX | TEE_MATTR_UX)) {
-			uint32_t mask = TEE_MATTR_PX | TEE_MATTR_UX |
-					TEE_MATTR_PW | TEE_MATTR_UW;
-			void *va = (void *)page_va;
+	if (!IS_ENABLED(CFG_PAGER_CLOCK))
+		tee_pager_hide_pages();
+	ret = true;
+out:
+	pager_unlock(exceptions);
+	return ret;
+}
 
-			/* Set a temporary read-only mapping */
-			area_set_entry(area, tblidx, pa, attr & ~mask);
-			area_tlbi_entry(area, tblidx);
+#ifdef CFG_PAGER_PROFILE
+TEE_Result tee_pager_get_profile(struct tee_pager_page_profile *prof,
+				 size_t *count, bool reset)
+{
+	struct tee_pager_page_profile *buf = NULL;
+	struct tee_pager_area *area = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t exceptions = 0;
+	size_t num_pages = 0;
+	size_t sz = 0;
+	size_t n = 0;
+	size_t m = 0;
 
-			dcache_clean_range_pou(va, SMALL_PAGE_SIZE);
-			if (clean_user_cache)
-				icache_inv_user_range(va, SMALL_PAGE_SIZE);
-			else
-				icache_inv_range(va, SMALL_PAGE_SIZE);
+	/*
+	 * @prof may be paged memory, a fault while holding the pager lock
+	 * would deadlock. The profile is collected in a kernel buffer and
+	 * copied out once the lock is released.
+	 */
+	if (*count) {
+		if (MUL_OVERFLOW(*count, sizeof(*buf), &sz))
+			return TEE_ERROR_BAD_PARAMETERS;
+		buf = malloc(sz);
+		if (!buf)
+			return TEE_ERROR_OUT_OF_MEMORY;
+	}
 
-			/* Set the final mapping */
-			area_set_entry(area, tblidx, pa, attr);
-			area_tlbi_entry(area, tblidx);
-		} else {
-			area_set_entry(area, tblidx, pa, attr);
-			/*
-			 * No need to flush TLB for this entry, it was
-			 * invalid. We should use a barrier though, to make
-			 * sure that the change is visible.
-			 */
-			dsb_ishst();
-		}
-		pgt_inc_used_entries(area->pgt);
+	exceptions = pager_lock_check_stack(32);
 
-		FMSG("Mapped 0x%" PRIxVA " -> 0x%" PRIxPA, page_va, pa);
+	TAILQ_FOREACH(area, &tee_pager_area_head, link) {
+		if (!area->profile)
+			continue;
+		num_pages = area->size / SMALL_PAGE_SIZE;
+		for (m = 0; m < num_pages; m++)
+			if (area->profile[m].faults)
+				n++;
+	}
 
+	if (n > *count) {
+		*count = n;
+		res = TEE_ERROR_SHORT_BUFFER;
+		goto out;
 	}
+	*count = n;
 
-	tee_pager_hide_pages();
-	ret = true;
+	n = 0;
+	TAILQ_FOREACH(area, &tee_pager_area_head, link) {
+		if (!area->profile)
+			continue;
+		num_pages = area->size / SMALL_PAGE_SIZE;
+		for (m = 0; m < num_pages; m++) {
+			if (!area->profile[m].faults)
+				continue;
+			buf[n] = area->profile[m];
+			n++;
+		}
+		if (reset)
+			memset(area->profile, 0,
+			       num_pages * sizeof(*area->profile));
+	}
+	if (reset)
+		profile_seq = 0;
 out:
 	pager_unlock(exceptions);
-	return ret;
+
+	if (!res && n)
+		memcpy(prof, buf, n * sizeof(*buf));
+	free(buf);
+
+	return res;
 }
+KEEP_PAGER(tee_pager_get_profile);
+#endif /*CFG_PAGER_PROFILE*/
 
 void tee_pager_add_pages(vaddr_t vaddr, size_t npages, bool unmap)
 {
@@ -1572,6 +2077,144 @@ out:
 	pager_unlock(exceptions);
 }
 KEEP_PAGER(tee_pager_pgt_save_and_release_entries);
+
+static size_t count_pinned(struct user_ta_ctx *utc)
+{
+	struct tee_pager_area *area = NULL;
+	size_t count = 0;
+	size_t n = 0;
+
+	TAILQ_FOREACH(area, utc->areas, link) {
+		if (!area->pinned)
+			continue;
+		for (n = 0; n < area->size / SMALL_PAGE_SIZE; n++)
+			if (bit_test(area->pinned, n))
+				count++;
+	}
+
+	return count;
+}
+
+static size_t area_va2pin_idx(struct tee_pager_area *area, vaddr_t va)
+{
+	return (va - area->base) >> SMALL_PAGE_SHIFT;
+}
+
+static void pin_page(struct tee_pager_area *area, vaddr_t va)
+{
+	size_t tblidx = area_va2idx(area, va);
+	struct tee_pager_pmem *pmem = NULL;
+	uint32_t attr = 0;
+	paddr_t pa = 0;
+
+	if (!tee_pager_unhide_page(area, tblidx)) {
+		area_get_entry(area, tblidx, NULL, &attr);
+		if (!(attr & TEE_MATTR_VALID_BLOCK) &&
+		    !pager_map_new_page(area, va, true))
+			panic();
+	}
+
+	pmem = pmem_find(area, tblidx);
+	assert(pmem);
+
+	/* Skip the fault which would have tagged the page as dirty */
+	if (area->type == PAGER_AREA_TYPE_RW &&
+	    (area->flags & TEE_MATTR_UW) && !pmem_is_dirty(pmem)) {
+		pmem->flags |= PMEM_FLAG_DIRTY;
+		pa = get_pmem_pa(pmem);
+		area_set_entry(area, tblidx, pa, get_area_mattr(area->flags));
+		area_tlbi_entry(area, tblidx);
+	}
+
+	pmem_pin(pmem);
+	bit_set(area->pinned, area_va2pin_idx(area, va));
+}
+
+TEE_Result tee_pager_pin_uta_range(struct user_ta_ctx *utc, vaddr_t base,
+				   size_t size)
+{
+	struct tee_pager_area *area = NULL;
+	uint32_t exceptions = 0;
+	TEE_Result res = TEE_SUCCESS;
+	size_t num_new = 0;
+	vaddr_t end = 0;
+	vaddr_t va = 0;
+
+	if ((base | size) & SMALL_PAGE_MASK || !size ||
+	    ADD_OVERFLOW(base, size, &end))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	for (va = base; va < end; va += SMALL_PAGE_SIZE) {
+		area = find_area(utc->areas, va);
+		if (!area)
+			return TEE_ERROR_BAD_PARAMETERS;
+		if (!area->pgt)
+			return TEE_ERROR_BAD_STATE;
+		if (!area->pinned) {
+			area->pinned = bit_alloc(area->size / SMALL_PAGE_SIZE);
+			if (!area->pinned)
+				return TEE_ERROR_OUT_OF_MEMORY;
+		}
+		if (!bit_test(area->pinned, area_va2pin_idx(area, va)))
+			num_new++;
+	}
+
+	if (count_pinned(utc) + num_new > CFG_PAGED_USER_TA_PIN_QUOTA)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	exceptions = pager_lock_check_stack(SMALL_PAGE_SIZE);
+
+	/*
+	 * Pages shared with other areas may already be pinned so this
+	 * check is conservative, but it guarantees that there's always
+	 * an unpinned page left to evict.
+	 */
+	if (pager_pinned_pages + num_new > tee_pager_npages / 2) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+
+	for (va = base; va < end; va += SMALL_PAGE_SIZE) {
+		area = find_area(utc->areas, va);
+		if (!bit_test(area->pinned, area_va2pin_idx(area, va)))
+			pin_page(area, va);
+	}
+out:
+	pager_unlock(exceptions);
+
+	return res;
+}
+KEEP_PAGER(tee_pager_pin_uta_range);
+
+void tee_pager_unpin_uta_range(struct user_ta_ctx *utc, vaddr_t base,
+			       size_t size)
+{
+	struct tee_pager_area *area = NULL;
+	struct tee_pager_pmem *pmem = NULL;
+	uint32_t exceptions = 0;
+	vaddr_t end = base + size;
+	vaddr_t va = 0;
+	size_t n = 0;
+
+	exceptions = pager_lock_check_stack(64);
+
+	for (va = base; va < end; va += SMALL_PAGE_SIZE) {
+		area = find_area(utc->areas, va);
+		if (!area || !area->pinned)
+			continue;
+		n = area_va2pin_idx(area, va);
+		if (!bit_test(area->pinned, n))
+			continue;
+		bit_clear(area->pinned, n);
+		/* Pinned pages are never evicted so the page is still there */
+		pmem = pmem_find(area, area_va2idx(area, va));
+		assert(pmem);
+		pmem_unpin(pmem);
+	}
+
+	pager_unlock(exceptions);
+}
+KEEP_PAGER(tee_pager_unpin_uta_range);
 #endif /*CFG_PAGED_USER_TA*/
 
 void tee_pager_release_phys(void *addr, size_t size)
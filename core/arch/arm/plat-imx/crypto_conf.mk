@@ -77,6 +77,14 @@ endif
 ifneq ($(filter y, $(CFG_MX8QM) $(CFG_MX8QX) $(CFG_MX8DXL)), y)
 $(call force, CFG_CAAM_JR_DISABLE_NODE,y)
 endif
+#
+# The CAAM DMA is coherent with the CPU caches, for instance when its master
+# port goes through the CCI with snooping enabled. The cache maintenance of
+# the buffers exchanged with the CAAM and their realignment on cache lines
+# are then skipped.
+#
+CFG_CAAM_DMA_COHERENT ?= n
+
 #
 # Enable HUK CAAM Generation
 #
@@ -89,6 +97,16 @@ ifeq ($(CFG_CRYPTO_DRIVER), y)
 
 $(call force, CFG_NXP_CAAM_RUNTIME_JR, y)
 
+# Dequeue the completed jobs and run their callbacks from the Job Ring
+# interrupt handler, so that asynchronous jobs complete without polling.
+ifneq ($(CFG_CAAM_NO_ITR),y)
+CFG_NXP_CAAM_JR_ASYNC ?= y
+endif
+
+# Size in algorithm blocks of the hash buffer accumulating the updates
+# before they're hashed in one job.
+CFG_NXP_CAAM_HASH_BUF_BLOCKS ?= 8
+
 #
 # Definition of all HW accelerations for all i.MX
 #
@@ -145,4 +163,11 @@ endif
 #
 CFG_CRYPTO_DRV_ACIPHER ?= $(CFG_NXP_CAAM_ACIPHER_DRV)
 $(call force, CFG_CRYPTO_DRV_MAC, $(call cryphw-one-enabled, HMAC CMAC))
+
+# Hash and cipher operations smaller than a threshold are done in software,
+# faster than a CAAM job with the Cryptographic Extensions. A threshold of 0
+# is calibrated for each algorithm once boot is completed.
+CFG_CRYPTO_DRV_SW_DISPATCH ?= $(CFG_CRYPTO_WITH_CE)
+CFG_CRYPTO_DRV_HASH_SW_THRESHOLD ?= 0
+CFG_CRYPTO_DRV_CIPHER_SW_THRESHOLD ?= 0
 endif
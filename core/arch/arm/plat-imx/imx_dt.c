@@ -5,6 +5,7 @@
  */
 #include <trace.h>
 #include <libfdt.h>
+#include <kernel/dt.h>
 #include <kernel/generic_boot.h>
 #include <imx.h>
 
@@ -55,7 +56,7 @@ void dt_overwrite(const char *node_str, const char *prop_str,
 	}
 
 	/* Get offset of node_str */
-	offset = fdt_node_offset_by_compatible(fdt, 0, node_str);
+	offset = dt_node_offset_by_compatible(fdt, 0, node_str);
 	if (offset < 0) {
 		EMSG("Cannot find %s node in the device tree", node_str);
 		return;
@@ -80,7 +81,7 @@ void dt_overwrite(const char *node_str, const char *prop_str,
 			sub[j] = fdt_overw_node[i*size_prop+j+1];
 
 		/* Get offset based on the phandle */
-		offset = fdt_node_offset_by_phandle(fdt, phandle);
+		offset = dt_node_offset_by_phandle(fdt, phandle);
 		if (offset < 0) {
 			EMSG("Cannot find offset based on phandle");
 			return;
@@ -122,7 +123,7 @@ void dt_debug(const char *node_str, const char *prop)
 	}
 
 	/* Get offset of node_str */
-	offset = fdt_node_offset_by_compatible(fdt, 0, node_str);
+	offset = dt_node_offset_by_compatible(fdt, 0, node_str);
 	if (offset < 0) {
 		EMSG("Cannot find %s node in the device tree", node_str);
 		return;
@@ -65,8 +65,8 @@ static void dt_find_ocram_tz_addr(void)
 
 	while (tz_ocram_match[idx] != NULL) {
 		/* Get node */
-		offset = fdt_node_offset_by_compatible(fdt, 0,
-							tz_ocram_match[idx]);
+		offset = dt_node_offset_by_compatible(fdt, 0,
+						      tz_ocram_match[idx]);
 		if (offset < 0) {
 			EMSG("Cannot find %s node in the device tree",
 							tz_ocram_match[idx]);
@@ -1224,7 +1224,7 @@ static TEE_Result stm32mp1_clk_early_init(void)
 	int ignored = 0;
 
 	fdt = get_embedded_dt();
-	node = fdt_node_offset_by_compatible(fdt, -1, DT_RCC_CLK_COMPAT);
+	node = dt_node_offset_by_compatible(fdt, -1, DT_RCC_CLK_COMPAT);
 
 	if (node < 0 || _fdt_reg_base_address(fdt, node) != RCC_BASE)
 		panic();
@@ -5,6 +5,8 @@ $(call force,CFG_SECURE_TIME_SOURCE_CNTPCT,y)
 $(call force,CFG_GIC,y)
 $(call force,CFG_PL011,y)
 $(call force,CFG_PM_STUBS,y)
+# The secure physical timer is used to collect entropy
+$(call force,CFG_CORE_PROFILER,n)
 
 include core/arch/arm/cpu/cortex-armv8-0.mk
 $(call force,CFG_TEE_CORE_NB_CORE,24)
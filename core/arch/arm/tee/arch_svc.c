@@ -5,15 +5,20 @@
 
 #include <arm.h>
 #include <assert.h>
+#include <config.h>
 #include <kernel/abort.h>
 #include <kernel/misc.h>
 #include <kernel/panic.h>
+#include <kernel/spinlock.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/thread.h>
 #include <kernel/trace_ta.h>
+#include <kernel/tracepoint.h>
 #include <kernel/user_ta.h>
 #include <mm/tee_mmu.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/queue.h>
 #include <tee/tee_svc.h>
 #include <tee/arch_svc.h>
 #include <tee/tee_svc_cryp.h>
@@ -117,6 +122,12 @@ static const struct syscall_entry tee_svc_syscall_table[] = {
 	SYSCALL_ENTRY(syscall_not_supported),
 	SYSCALL_ENTRY(syscall_not_supported),
 	SYSCALL_ENTRY(syscall_cache_operation),
+	SYSCALL_ENTRY(syscall_cryp_update_vec),
+	SYSCALL_ENTRY(syscall_hash_init_final),
+	SYSCALL_ENTRY(syscall_storage_obj_submit),
+	SYSCALL_ENTRY(syscall_storage_obj_wait),
+	SYSCALL_ENTRY(syscall_storage_txn),
+	SYSCALL_ENTRY(syscall_storage_next_enum_batch),
 };
 
 #ifdef TRACE_SYSCALLS
@@ -132,6 +143,130 @@ static void trace_syscall(size_t num __unused)
 }
 #endif
 
+#ifdef CFG_SYSCALL_STATS
+struct syscall_stats_entry {
+	struct syscall_stats stats;
+	SLIST_ENTRY(syscall_stats_entry) link;
+};
+
+static SLIST_HEAD(, syscall_stats_entry) syscall_stats_head =
+	SLIST_HEAD_INITIALIZER(syscall_stats_head);
+static struct syscall_stats_entry *syscall_stats_last;
+static unsigned int syscall_stats_lock = SPINLOCK_UNLOCK;
+
+static struct syscall_stats *find_syscall_stats(const TEE_UUID *uuid)
+{
+	struct syscall_stats_entry *e = NULL;
+
+	SLIST_FOREACH(e, &syscall_stats_head, link)
+		if (!memcmp(&e->stats.uuid, uuid, sizeof(*uuid)))
+			return &e->stats;
+
+	return NULL;
+}
+
+/*
+ * Returns the statistics of the TA of the current session. The statistics
+ * are kept per UUID for the lifetime of the system and cached in the user
+ * TA context.
+ */
+static struct syscall_stats *get_syscall_stats(void)
+{
+	struct syscall_stats_entry *e = NULL;
+	struct syscall_stats *stats = NULL;
+	struct tee_ta_session *s = NULL;
+	struct user_ta_ctx *utc = NULL;
+	uint32_t exceptions = 0;
+
+	if (tee_ta_get_current_session(&s) || !is_user_ta_ctx(s->ctx))
+		return NULL;
+	utc = to_user_ta_ctx(s->ctx);
+	if (utc->syscall_stats)
+		return utc->syscall_stats;
+
+	/* Allocated here since malloc() can't be called with the lock held */
+	e = calloc(1, sizeof(*e));
+
+	exceptions = cpu_spin_lock_xsave(&syscall_stats_lock);
+	stats = find_syscall_stats(&s->ctx->uuid);
+	if (!stats && e) {
+		e->stats.uuid = s->ctx->uuid;
+		/* Appended to keep the indexes used by syscall_stats_get() */
+		if (syscall_stats_last)
+			SLIST_INSERT_AFTER(syscall_stats_last, e, link);
+		else
+			SLIST_INSERT_HEAD(&syscall_stats_head, e, link);
+		syscall_stats_last = e;
+		stats = &e->stats;
+		e = NULL;
+	}
+	cpu_spin_unlock_xrestore(&syscall_stats_lock, exceptions);
+
+	free(e);
+	utc->syscall_stats = stats;
+
+	return stats;
+}
+
+static void account_syscall(struct syscall_stats *stats, size_t scn,
+			    uint64_t start)
+{
+	uint64_t us = ((read_cntpct() - start) * 1000000) / read_cntfrq();
+	struct syscall_scn_stats *scs = NULL;
+	uint32_t exceptions = 0;
+	size_t b = 0;
+
+	if (!stats || scn > TEE_SCN_MAX)
+		return;
+
+	if (us)
+		b = MIN(64 - __builtin_clzll(us),
+			SYSCALL_STATS_NUM_BUCKETS - 1);
+
+	exceptions = cpu_spin_lock_xsave(&syscall_stats_lock);
+	scs = stats->scn + scn;
+	scs->count++;
+	scs->hist[b]++;
+	scs->time_us += us;
+	cpu_spin_unlock_xrestore(&syscall_stats_lock, exceptions);
+}
+
+TEE_Result syscall_stats_get(size_t idx, struct syscall_stats *stats,
+			     bool reset)
+{
+	struct syscall_stats_entry *e = NULL;
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&syscall_stats_lock);
+	SLIST_FOREACH(e, &syscall_stats_head, link) {
+		if (n == idx)
+			break;
+		n++;
+	}
+	if (e) {
+		*stats = e->stats;
+		if (reset)
+			memset(e->stats.scn, 0, sizeof(e->stats.scn));
+	}
+	cpu_spin_unlock_xrestore(&syscall_stats_lock, exceptions);
+
+	if (!e)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+	return TEE_SUCCESS;
+}
+#else
+static struct syscall_stats *get_syscall_stats(void)
+{
+	return NULL;
+}
+
+static void account_syscall(struct syscall_stats *stats __unused,
+			    size_t scn __unused, uint64_t start __unused)
+{
+}
+#endif /*CFG_SYSCALL_STATS*/
+
 #ifdef ARM32
 static void get_scn_max_args(struct thread_svc_regs *regs, size_t *scn,
 		size_t *max_args)
@@ -161,6 +296,11 @@ static void set_svc_retval(struct thread_svc_regs *regs, uint32_t ret_val)
 {
 	regs->r0 = ret_val;
 }
+
+static unsigned long get_svc_arg0(struct thread_svc_regs *regs)
+{
+	return regs->r0;
+}
 #endif /*ARM32*/
 
 #ifdef ARM64
@@ -168,8 +308,38 @@ static void set_svc_retval(struct thread_svc_regs *regs, uint64_t ret_val)
 {
 	regs->x0 = ret_val;
 }
+
+static unsigned long get_svc_arg0(struct thread_svc_regs *regs)
+{
+	return regs->x0;
+}
 #endif /*ARM64*/
 
+/*
+ * Short syscalls which can't suspend the thread, that is don't do RPC,
+ * don't wait on a mutex and don't use VFP in kernel mode, are served with
+ * foreign interrupts kept masked. The VFP state of the TA is then left
+ * live in the registers instead of being saved and having the TA trap to
+ * restore it once back in user mode.
+ */
+static bool is_fast_syscall(struct thread_svc_regs *regs, size_t scn)
+{
+	if (IS_ENABLED(CFG_TA_FTRACE_STREAM))
+		return false;
+
+	/*
+	 * TEE_SCN_LOG isn't fast, the time spent writing to the console
+	 * depends on the length of the message chosen by the TA.
+	 */
+	switch (scn) {
+	case TEE_SCN_GET_TIME:
+		return IS_ENABLED(CFG_SECURE_TIME_SOURCE_CNTPCT) &&
+		       get_svc_arg0(regs) == UTEE_TIME_CAT_SYSTEM;
+	default:
+		return false;
+	}
+}
+
 /*
  * Note: this function is weak just to make it possible to exclude it from
  * the unpaged area.
@@ -180,6 +350,10 @@ void __weak tee_svc_handler(struct thread_svc_regs *regs)
 	size_t max_args;
 	syscall_t scf;
 	uint32_t state;
+	uint32_t res = 0;
+	struct syscall_stats *stats = NULL;
+	uint64_t start = 0;
+	bool fast = false;
 
 	COMPILE_TIME_ASSERT(ARRAY_SIZE(tee_svc_syscall_table) ==
 				(TEE_SCN_MAX + 1));
@@ -188,17 +362,29 @@ void __weak tee_svc_handler(struct thread_svc_regs *regs)
 	state = thread_get_exceptions();
 	thread_unmask_exceptions(state & ~THREAD_EXCP_NATIVE_INTR);
 
-	thread_user_save_vfp();
+	get_scn_max_args(regs, &scn, &max_args);
+	fast = is_fast_syscall(regs, scn);
+
+	if (!fast)
+		thread_user_save_vfp();
 
 	/* TA has just entered kernel mode */
 	tee_ta_update_session_utime_suspend();
 
 	/* Restore foreign interrupts which are disabled on exception entry */
-	thread_restore_foreign_intr();
-
-	get_scn_max_args(regs, &scn, &max_args);
+	if (!fast)
+		thread_restore_foreign_intr();
 
 	trace_syscall(scn);
+	TRACEPOINT(PTA_TRACE_CAT_SYSCALL, "syscall_enter", scn, 0);
+
+	if (IS_ENABLED(CFG_TA_FTRACE_STREAM)) {
+		struct tee_ta_session *s = NULL;
+
+		/* Keeps the ftrace ring of a long running TA from filling */
+		if (!tee_ta_get_current_session(&s))
+			user_ta_ftrace_drain(s, false);
+	}
 
 	if (max_args > TEE_SVC_MAX_ARGS) {
 		DMSG("Too many arguments for SCN %zu (%zu)", scn, max_args);
@@ -211,7 +397,17 @@ void __weak tee_svc_handler(struct thread_svc_regs *regs)
 	else
 		scf = tee_svc_syscall_table[scn].fn;
 
-	set_svc_retval(regs, tee_svc_do_call(regs, scf));
+	if (IS_ENABLED(CFG_SYSCALL_STATS)) {
+		stats = get_syscall_stats();
+		start = read_cntpct();
+	}
+
+	res = tee_svc_do_call(regs, scf);
+
+	if (IS_ENABLED(CFG_SYSCALL_STATS))
+		account_syscall(stats, scn, start);
+	TRACEPOINT(PTA_TRACE_CAT_SYSCALL, "syscall_exit", scn, res);
+	set_svc_retval(regs, res);
 
 	if (scn != TEE_SCN_RETURN) {
 		/* We're about to switch back to user mode */
@@ -8,6 +8,39 @@
 #include <mm/core_mmu.h>
 #include <tee/cache.h>
 
+/*
+ * Widens a range clean operation to the whole cache when the range is
+ * large enough for that to be cheaper. Invalidating more than the range
+ * would discard data of others. @shared is false for caches private to
+ * each CPU, set/way operations only reach the caches of the calling CPU.
+ */
+static enum cache_op widen_op(enum cache_op op, size_t len, bool shared)
+{
+	if (!CFG_CACHE_OP_FULL_THRESHOLD || len < CFG_CACHE_OP_FULL_THRESHOLD)
+		return op;
+	if (!shared && CFG_TEE_CORE_NB_CORE > 1)
+		return op;
+
+	switch (op) {
+	case DCACHE_AREA_CLEAN:
+		return DCACHE_CLEAN;
+	case DCACHE_AREA_CLEAN_INV:
+		return DCACHE_CLEAN_INV;
+	default:
+		return op;
+	}
+}
+
+static TEE_Result inner_op(enum cache_op op, void *va, size_t len)
+{
+	return cache_op_inner(widen_op(op, len, false), va, len);
+}
+
+static TEE_Result outer_op(enum cache_op op, paddr_t pa, size_t len)
+{
+	return cache_op_outer(widen_op(op, len, true), pa, len);
+}
+
 /*
  * tee_uta_cache_operation - dynamic cache clean/inval request from a TA.
  * It follows ARM recommendation:
@@ -28,28 +61,28 @@ TEE_Result cache_operation(enum utee_cache_operation op, void *va, size_t len)
 	case TEE_CACHEFLUSH:
 #ifdef CFG_PL310 /* prevent initial L1 clean in case there is no outer L2 */
 		/* Clean L1, Flush L2, Flush L1 */
-		res = cache_op_inner(DCACHE_AREA_CLEAN, va, len);
+		res = inner_op(DCACHE_AREA_CLEAN, va, len);
 		if (res != TEE_SUCCESS)
 			return res;
-		res = cache_op_outer(DCACHE_AREA_CLEAN_INV, pa, len);
+		res = outer_op(DCACHE_AREA_CLEAN_INV, pa, len);
 		if (res != TEE_SUCCESS)
 			return res;
 #endif
-		return cache_op_inner(DCACHE_AREA_CLEAN_INV, va, len);
+		return inner_op(DCACHE_AREA_CLEAN_INV, va, len);
 
 	case TEE_CACHECLEAN:
 		/* Clean L1, Clean L2 */
-		res = cache_op_inner(DCACHE_AREA_CLEAN, va, len);
+		res = inner_op(DCACHE_AREA_CLEAN, va, len);
 		if (res != TEE_SUCCESS)
 			return res;
-		return cache_op_outer(DCACHE_AREA_CLEAN, pa, len);
+		return outer_op(DCACHE_AREA_CLEAN, pa, len);
 
 	case TEE_CACHEINVALIDATE:
 		/* Inval L2, Inval L1 */
-		res = cache_op_outer(DCACHE_AREA_INVALIDATE, pa, len);
+		res = outer_op(DCACHE_AREA_INVALIDATE, pa, len);
 		if (res != TEE_SUCCESS)
 			return res;
-		return cache_op_inner(DCACHE_AREA_INVALIDATE, va, len);
+		return inner_op(DCACHE_AREA_INVALIDATE, va, len);
 
 	default:
 		return TEE_ERROR_NOT_SUPPORTED;
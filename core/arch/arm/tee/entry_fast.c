@@ -4,14 +4,24 @@
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
 
+#include <config.h>
+#include <crypto/crypto.h>
 #include <tee/entry_fast.h>
+#include <initcall.h>
 #include <optee_msg.h>
 #include <sm/optee_smc.h>
 #include <kernel/generic_boot.h>
+#include <kernel/spinlock.h>
 #include <kernel/tee_l2cc_mutex.h>
+#include <kernel/tee_time.h>
 #include <kernel/virtualization.h>
 #include <kernel/misc.h>
+#include <kernel/notif.h>
+#include <kernel/work_queue.h>
 #include <mm/core_mmu.h>
+#include <string.h>
+#include <string_ext.h>
+#include <util.h>
 
 #ifdef CFG_CORE_RESERVED_SHM
 static void tee_entry_get_shm_config(struct thread_smc_args *args)
@@ -62,6 +72,7 @@ static void tee_entry_fastcall_l2cc_mutex(struct thread_smc_args *args)
 
 static void tee_entry_exchange_capabilities(struct thread_smc_args *args)
 {
+	uint32_t nsec_caps = OPTEE_SMC_NSEC_CAP_UNIPROCESSOR;
 	bool dyn_shm_en = false;
 
 	/*
@@ -77,25 +88,50 @@ static void tee_entry_exchange_capabilities(struct thread_smc_args *args)
 	 * OPTEE_SMC_NSEC_CAP_UNIPROCESSOR.
 	 */
 
-	if (args->a1 & ~OPTEE_SMC_NSEC_CAP_UNIPROCESSOR) {
+	if (IS_ENABLED(CFG_CORE_ASYNC_NOTIF))
+		nsec_caps |= OPTEE_SMC_NSEC_CAP_WQ_ASYNC_NOTIF;
+
+	if (args->a1 & ~nsec_caps) {
 		/* Unknown capability. */
 		args->a0 = OPTEE_SMC_RETURN_ENOTAVAIL;
 		return;
 	}
 
+	notif_set_wq_wakeup(args->a1 & OPTEE_SMC_NSEC_CAP_WQ_ASYNC_NOTIF);
+
 	args->a0 = OPTEE_SMC_RETURN_OK;
-	args->a1 = 0;
+	args->a1 = OPTEE_SMC_SEC_CAP_BATCH_INVOKE |
+		   OPTEE_SMC_SEC_CAP_WORK_QUEUE;
 #ifdef CFG_CORE_RESERVED_SHM
 	args->a1 |= OPTEE_SMC_SEC_CAP_HAVE_RESERVED_SHM;
 #endif
 #ifdef CFG_VIRTUALIZATION
 	args->a1 |= OPTEE_SMC_SEC_CAP_VIRTUALIZATION;
 #endif
+#ifdef CFG_CORE_ASYNC_NOTIF
+	args->a1 |= OPTEE_SMC_SEC_CAP_ASYNC_NOTIF |
+		    OPTEE_SMC_SEC_CAP_WQ_ASYNC_NOTIF;
+#endif
+#ifdef CFG_CORE_FAST_RANDOM
+	args->a1 |= OPTEE_SMC_SEC_CAP_FAST_RANDOM;
+#endif
+#ifdef CFG_SECURE_TIME_SOURCE_CNTPCT
+	args->a1 |= OPTEE_SMC_SEC_CAP_FAST_SYSTEM_TIME;
+#endif
+#ifdef CFG_SDP_POOL
+	args->a1 |= OPTEE_SMC_SEC_CAP_SDP_POOL;
+#endif
 
 #if defined(CFG_CORE_DYN_SHM)
 	dyn_shm_en = core_mmu_nsec_ddr_is_defined();
 	if (dyn_shm_en)
-		args->a1 |= OPTEE_SMC_SEC_CAP_DYNAMIC_SHM;
+		args->a1 |= OPTEE_SMC_SEC_CAP_DYNAMIC_SHM |
+			    OPTEE_SMC_SEC_CAP_SHM_WRITE_COMBINE |
+			    OPTEE_SMC_SEC_CAP_BATCH_SHM;
+#endif
+#ifdef CFG_CORE_TELEMETRY
+	if (dyn_shm_en)
+		args->a1 |= OPTEE_SMC_SEC_CAP_TELEMETRY;
 #endif
 
 	DMSG("Dynamic shared memory is %sabled", dyn_shm_en ? "en" : "dis");
@@ -146,6 +182,111 @@ static void tee_entry_get_thread_count(struct thread_smc_args *args)
 	args->a1 = CFG_NUM_THREADS;
 }
 
+#if defined(CFG_CORE_ASYNC_NOTIF)
+static void tee_entry_get_async_notif_value(struct thread_smc_args *args)
+{
+	uint32_t value = 0;
+	bool more_pending = false;
+
+	args->a0 = OPTEE_SMC_RETURN_OK;
+	args->a2 = 0;
+	if (notif_get_value(&value, &more_pending)) {
+		args->a1 = value;
+		args->a2 = OPTEE_SMC_ASYNC_NOTIF_VALUE_VALID;
+		if (more_pending)
+			args->a2 |= OPTEE_SMC_ASYNC_NOTIF_PENDING;
+	}
+}
+#endif
+
+#if defined(CFG_CORE_FAST_RANDOM)
+/*
+ * Fast calls can't take the mutex of the RNG, the bytes are read in
+ * advance by a work and the pool is only accessed with a spinlock held.
+ * Bytes are served from the end of the pool and cleared once returned.
+ */
+static uint8_t fast_rng_pool[CFG_CORE_FAST_RANDOM_POOL_SIZE];
+static size_t fast_rng_avail;
+static unsigned int fast_rng_lock = SPINLOCK_UNLOCK;
+
+static void fast_rng_refill(struct work *work __unused)
+{
+	uint8_t buf[CFG_CORE_FAST_RANDOM_POOL_SIZE] = { };
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&fast_rng_lock);
+	n = sizeof(fast_rng_pool) - fast_rng_avail;
+	cpu_spin_unlock_xrestore(&fast_rng_lock, exceptions);
+
+	if (!n || crypto_rng_read(buf, n))
+		goto out;
+
+	exceptions = cpu_spin_lock_xsave(&fast_rng_lock);
+	n = MIN(n, sizeof(fast_rng_pool) - fast_rng_avail);
+	memcpy(fast_rng_pool + fast_rng_avail, buf, n);
+	fast_rng_avail += n;
+	cpu_spin_unlock_xrestore(&fast_rng_lock, exceptions);
+out:
+	memzero_explicit(buf, sizeof(buf));
+}
+
+static struct work fast_rng_work = WORK_INITIALIZER(fast_rng_refill);
+
+static TEE_Result fast_rng_init(void)
+{
+	fast_rng_refill(NULL);
+
+	return TEE_SUCCESS;
+}
+service_init_late(fast_rng_init);
+
+static void tee_entry_get_random(struct thread_smc_args *args)
+{
+	uint32_t val[OPTEE_SMC_GET_RANDOM_SIZE / sizeof(uint32_t)] = { };
+	uint32_t exceptions = 0;
+	bool low = false;
+
+	exceptions = cpu_spin_lock_xsave(&fast_rng_lock);
+	if (fast_rng_avail >= sizeof(val)) {
+		fast_rng_avail -= sizeof(val);
+		memcpy(val, fast_rng_pool + fast_rng_avail, sizeof(val));
+		memzero_explicit(fast_rng_pool + fast_rng_avail, sizeof(val));
+		args->a0 = OPTEE_SMC_RETURN_OK;
+	} else {
+		args->a0 = OPTEE_SMC_RETURN_EBUSY;
+	}
+	low = fast_rng_avail < sizeof(fast_rng_pool) / 2;
+	cpu_spin_unlock_xrestore(&fast_rng_lock, exceptions);
+
+	if (low)
+		work_queue(&fast_rng_work);
+
+	if (args->a0 == OPTEE_SMC_RETURN_OK) {
+		args->a1 = val[0];
+		args->a2 = val[1];
+		args->a3 = val[2];
+		memzero_explicit(val, sizeof(val));
+	}
+}
+#endif
+
+#if defined(CFG_SECURE_TIME_SOURCE_CNTPCT)
+static void tee_entry_get_system_time(struct thread_smc_args *args)
+{
+	TEE_Time t = { };
+
+	if (tee_time_get_sys_time(&t)) {
+		args->a0 = OPTEE_SMC_RETURN_ENOTAVAIL;
+		return;
+	}
+
+	args->a0 = OPTEE_SMC_RETURN_OK;
+	args->a1 = t.seconds;
+	args->a2 = t.millis;
+}
+#endif
+
 #if defined(CFG_VIRTUALIZATION)
 static void tee_entry_vm_created(struct thread_smc_args *args)
 {
@@ -229,6 +370,21 @@ void __tee_entry_fast(struct thread_smc_args *args)
 	case OPTEE_SMC_GET_THREAD_COUNT:
 		tee_entry_get_thread_count(args);
 		break;
+#if defined(CFG_CORE_ASYNC_NOTIF)
+	case OPTEE_SMC_GET_ASYNC_NOTIF_VALUE:
+		tee_entry_get_async_notif_value(args);
+		break;
+#endif
+#if defined(CFG_CORE_FAST_RANDOM)
+	case OPTEE_SMC_GET_RANDOM:
+		tee_entry_get_random(args);
+		break;
+#endif
+#if defined(CFG_SECURE_TIME_SOURCE_CNTPCT)
+	case OPTEE_SMC_GET_SYSTEM_TIME:
+		tee_entry_get_system_time(args);
+		break;
+#endif
 
 #if defined(CFG_VIRTUALIZATION)
 	case OPTEE_SMC_VM_CREATED:
@@ -257,6 +413,15 @@ size_t tee_entry_generic_get_api_call_count(void)
 #if defined(CFG_VIRTUALIZATION)
 	ret += 2;
 #endif
+#if defined(CFG_CORE_ASYNC_NOTIF)
+	ret += 1;
+#endif
+#if defined(CFG_CORE_FAST_RANDOM)
+	ret += 1;
+#endif
+#if defined(CFG_SECURE_TIME_SOURCE_CNTPCT)
+	ret += 1;
+#endif
 
 	return ret;
 }
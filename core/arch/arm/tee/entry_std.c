@@ -11,14 +11,22 @@
 #include <io.h>
 #include <kernel/linker.h>
 #include <kernel/msg_param.h>
+#include <kernel/mutex.h>
+#include <kernel/notif.h>
 #include <kernel/panic.h>
 #include <kernel/tee_misc.h>
+#include <kernel/tee_time.h>
+#include <kernel/telemetry.h>
+#include <kernel/tracepoint.h>
+#include <kernel/work_queue.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
 #include <mm/mobj.h>
 #include <optee_msg.h>
 #include <sm/optee_smc.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/queue.h>
 #include <tee/entry_std.h>
 #include <tee/tee_cryp_utl.h>
 #include <tee/uuid.h>
@@ -79,8 +87,8 @@ static TEE_Result set_tmem_param(const struct optee_msg_param_tmem *tmem,
 	if (attr & OPTEE_MSG_ATTR_NONCONTIG) {
 		uint64_t shm_ref = READ_ONCE(tmem->shm_ref);
 
-		mem->mobj = msg_param_mobj_from_noncontig(pa, sz, shm_ref,
-							  false);
+		mem->mobj = msg_param_mobj_from_noncontig(pa, sz, shm_ref, false,
+						TEE_MATTR_CACHE_CACHED);
 		if (!mem->mobj)
 			return TEE_ERROR_BAD_PARAMETERS;
 		mem->offs = 0;
@@ -112,6 +120,8 @@ static TEE_Result set_rmem_param(const struct optee_msg_param_rmem *rmem,
 	uint64_t shm_ref = READ_ONCE(rmem->shm_ref);
 
 	mem->mobj = mobj_reg_shm_get_by_cookie(shm_ref);
+	if (!mem->mobj)
+		mem->mobj = mobj_sdp_pool_get_by_cookie(shm_ref);
 	if (!mem->mobj)
 		return TEE_ERROR_BAD_PARAMETERS;
 
@@ -145,10 +155,19 @@ static TEE_Result copy_in_params(const struct optee_msg_param *params,
 	memset(ta_param, 0, sizeof(*ta_param));
 
 	for (n = 0; n < num_params; n++) {
+		const uint64_t prio_mask = SHIFT_U64(OPTEE_MSG_ATTR_PRIO_MASK,
+						     OPTEE_MSG_ATTR_PRIO_SHIFT);
+		uint8_t prio;
 		uint32_t attr;
 
 		saved_attr[n] = READ_ONCE(params[n].attr);
 
+		/* The priority isn't a property of the parameter itself */
+		prio = (saved_attr[n] >> OPTEE_MSG_ATTR_PRIO_SHIFT) &
+		       OPTEE_MSG_ATTR_PRIO_MASK;
+		ta_param->prio = MAX(ta_param->prio, prio);
+		saved_attr[n] &= ~prio_mask;
+
 		if (saved_attr[n] & OPTEE_MSG_ATTR_META)
 			return TEE_ERROR_BAD_PARAMETERS;
 
@@ -214,7 +233,10 @@ static void cleanup_shm_refs(const uint64_t *saved_attr,
 		case OPTEE_MSG_ATTR_TYPE_RMEM_INPUT:
 		case OPTEE_MSG_ATTR_TYPE_RMEM_OUTPUT:
 		case OPTEE_MSG_ATTR_TYPE_RMEM_INOUT:
-			mobj_reg_shm_put(param->u[n].mem.mobj);
+			if (mobj_is_sdp_pool(param->u[n].mem.mobj))
+				mobj_free(param->u[n].mem.mobj);
+			else
+				mobj_reg_shm_put(param->u[n].mem.mobj);
 			break;
 #endif
 		default:
@@ -347,6 +369,14 @@ out:
 	arg->ret_origin = err_orig;
 }
 
+#ifdef CFG_CORE_ASYNC_NOTIF
+static void drop_async_cmds(uint32_t session);
+#else
+static void drop_async_cmds(uint32_t session __unused)
+{
+}
+#endif
+
 static void entry_close_session(struct optee_msg_arg *arg, uint32_t num_params)
 {
 	TEE_Result res;
@@ -362,6 +392,8 @@ static void entry_close_session(struct optee_msg_arg *arg, uint32_t num_params)
 
 	s = tee_ta_find_session(arg->session, &tee_open_sessions);
 	res = tee_ta_close_session(s, &tee_open_sessions, NSAPP_IDENTITY);
+	if (res == TEE_SUCCESS)
+		drop_async_cmds(arg->session);
 out:
 	arg->ret = res;
 	arg->ret_origin = TEE_ORIGIN_TEE;
@@ -403,6 +435,238 @@ out:
 	arg->ret_origin = err_orig;
 }
 
+static void entry_invoke_batch(struct optee_msg_arg *arg, uint32_t num_params)
+{
+	uint8_t *buf = (uint8_t *)arg->params;
+	size_t buf_size = num_params * sizeof(struct optee_msg_param);
+	uint32_t num_cmds = READ_ONCE(arg->func);
+	struct optee_msg_arg *sub = NULL;
+	uint32_t sub_num_params = 0;
+	size_t sub_size = 0;
+	size_t offs = 0;
+	uint32_t n = 0;
+
+	for (n = 0; n < num_cmds; n++) {
+		if (buf_size - offs < sizeof(struct optee_msg_arg))
+			goto err;
+
+		sub = (struct optee_msg_arg *)(buf + offs);
+		sub_num_params = READ_ONCE(sub->num_params);
+		if (sub_num_params > TEE_NUM_PARAMS ||
+		    READ_ONCE(sub->cmd) != OPTEE_MSG_CMD_INVOKE_COMMAND)
+			goto err;
+
+		sub_size = OPTEE_MSG_GET_ARG_SIZE(sub_num_params);
+		if (buf_size - offs < sub_size)
+			goto err;
+
+		entry_invoke_command(sub, sub_num_params);
+		offs += sub_size;
+	}
+
+	arg->ret = TEE_SUCCESS;
+	arg->ret_origin = TEE_ORIGIN_TEE;
+	return;
+err:
+	EMSG("Malformed sub command %"PRIu32" in batch", n);
+	arg->ret = TEE_ERROR_BAD_PARAMETERS;
+	arg->ret_origin = TEE_ORIGIN_TEE;
+}
+
+#ifdef CFG_CORE_ASYNC_NOTIF
+/*
+ * Asynchronously invoked commands, the ticket of a command is also the
+ * notification value posted when the command has completed. Commands are
+ * dropped when their session is closed, unless running, and results not
+ * retrieved within CFG_CORE_ASYNC_RESULT_TIMEOUT seconds are discarded.
+ */
+struct async_cmd {
+	uint32_t ticket;
+	uint32_t num_params;
+	bool running;
+	bool done;
+	uint32_t done_time;
+	struct optee_msg_arg *arg;
+	TAILQ_ENTRY(async_cmd) link;
+};
+
+static TAILQ_HEAD(async_cmd_head, async_cmd) async_cmds =
+	TAILQ_HEAD_INITIALIZER(async_cmds);
+static struct mutex async_cmd_mu = MUTEX_INITIALIZER;
+static uint64_t async_tickets;
+
+static struct async_cmd *find_async_cmd(uint32_t ticket)
+{
+	struct async_cmd *ac = NULL;
+
+	TAILQ_FOREACH(ac, &async_cmds, link)
+		if (ac->ticket == ticket)
+			return ac;
+
+	return NULL;
+}
+
+static void free_async_cmd(struct async_cmd *ac)
+{
+	TAILQ_REMOVE(&async_cmds, ac, link);
+	async_tickets &= ~BIT64(ac->ticket);
+	free(ac->arg);
+	free(ac);
+}
+
+static uint32_t async_time(void)
+{
+	TEE_Time t = { };
+
+	if (tee_time_get_sys_time(&t))
+		return 0;
+	return t.seconds;
+}
+
+/* Called with async_cmd_mu held */
+static void expire_async_cmds(void)
+{
+	uint32_t now = async_time();
+	struct async_cmd *next = NULL;
+	struct async_cmd *ac = NULL;
+
+	TAILQ_FOREACH_SAFE(ac, &async_cmds, link, next)
+		if (ac->done &&
+		    now - ac->done_time >= CFG_CORE_ASYNC_RESULT_TIMEOUT)
+			free_async_cmd(ac);
+}
+
+static void drop_async_cmds(uint32_t session)
+{
+	struct async_cmd *next = NULL;
+	struct async_cmd *ac = NULL;
+
+	mutex_lock(&async_cmd_mu);
+	TAILQ_FOREACH_SAFE(ac, &async_cmds, link, next)
+		if (!ac->running && ac->arg->session == session)
+			free_async_cmd(ac);
+	mutex_unlock(&async_cmd_mu);
+}
+
+static void entry_invoke_async(struct optee_msg_arg *arg, uint32_t num_params)
+{
+	size_t arg_size = OPTEE_MSG_GET_ARG_SIZE(num_params);
+	TEE_Result res = TEE_ERROR_BAD_PARAMETERS;
+	struct async_cmd *ac = NULL;
+	uint64_t free_tickets = 0;
+
+	if (num_params > TEE_NUM_PARAMS)
+		goto out;
+	if (!tee_ta_find_session(arg->session, &tee_open_sessions))
+		goto out;
+
+	res = TEE_ERROR_OUT_OF_MEMORY;
+	ac = calloc(1, sizeof(*ac));
+	if (!ac)
+		goto out;
+	ac->arg = malloc(arg_size);
+	if (!ac->arg)
+		goto err;
+	memcpy(ac->arg, arg, arg_size);
+	ac->arg->cmd = OPTEE_MSG_CMD_INVOKE_COMMAND;
+	ac->num_params = num_params;
+
+	mutex_lock(&async_cmd_mu);
+	expire_async_cmds();
+	/* Tickets 0 and NOTIF_VALUE_DO_WORK are reserved */
+	free_tickets = ~async_tickets & GENMASK_64(NOTIF_ASYNC_VALUE_MAX,
+						   NOTIF_VALUE_DO_WORK + 1);
+	if (!free_tickets) {
+		mutex_unlock(&async_cmd_mu);
+		res = TEE_ERROR_BUSY;
+		goto err;
+	}
+	ac->ticket = __builtin_ctzll(free_tickets);
+	async_tickets |= BIT64(ac->ticket);
+	TAILQ_INSERT_TAIL(&async_cmds, ac, link);
+	mutex_unlock(&async_cmd_mu);
+
+	arg->cancel_id = ac->ticket;
+	res = TEE_SUCCESS;
+	goto out;
+err:
+	free(ac->arg);
+	free(ac);
+out:
+	arg->ret = res;
+	arg->ret_origin = TEE_ORIGIN_TEE;
+}
+
+static void entry_do_async(struct optee_msg_arg *arg, uint32_t num_params)
+{
+	struct async_cmd *ac = NULL;
+
+	if (num_params) {
+		arg->ret = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	mutex_lock(&async_cmd_mu);
+	TAILQ_FOREACH(ac, &async_cmds, link)
+		if (!ac->running && !ac->done)
+			break;
+	if (ac)
+		ac->running = true;
+	mutex_unlock(&async_cmd_mu);
+
+	if (!ac) {
+		arg->ret = TEE_ERROR_ITEM_NOT_FOUND;
+		goto out;
+	}
+
+	entry_invoke_command(ac->arg, ac->num_params);
+
+	mutex_lock(&async_cmd_mu);
+	ac->running = false;
+	ac->done = true;
+	ac->done_time = async_time();
+	mutex_unlock(&async_cmd_mu);
+
+	arg->cancel_id = ac->ticket;
+	arg->ret = TEE_SUCCESS;
+	notif_send_async(ac->ticket);
+out:
+	arg->ret_origin = TEE_ORIGIN_TEE;
+}
+
+static void entry_get_async_result(struct optee_msg_arg *arg,
+				   uint32_t num_params)
+{
+	struct async_cmd *ac = NULL;
+
+	mutex_lock(&async_cmd_mu);
+	ac = find_async_cmd(arg->cancel_id);
+	if (!ac || ac->num_params != num_params) {
+		mutex_unlock(&async_cmd_mu);
+		arg->ret = TEE_ERROR_BAD_PARAMETERS;
+		arg->ret_origin = TEE_ORIGIN_TEE;
+		return;
+	}
+	if (!ac->done) {
+		mutex_unlock(&async_cmd_mu);
+		arg->ret = TEE_ERROR_BUSY;
+		arg->ret_origin = TEE_ORIGIN_TEE;
+		return;
+	}
+	TAILQ_REMOVE(&async_cmds, ac, link);
+	async_tickets &= ~BIT64(ac->ticket);
+	mutex_unlock(&async_cmd_mu);
+
+	memcpy(arg->params, ac->arg->params,
+	       num_params * sizeof(struct optee_msg_param));
+	arg->ret = ac->arg->ret;
+	arg->ret_origin = ac->arg->ret_origin;
+
+	free(ac->arg);
+	free(ac);
+}
+#endif /*CFG_CORE_ASYNC_NOTIF*/
+
 static void entry_cancel(struct optee_msg_arg *arg, uint32_t num_params)
 {
 	TEE_Result res;
@@ -429,25 +693,101 @@ out:
 }
 
 #ifdef CFG_CORE_DYN_SHM
+/* Cache attributes from the OPTEE_MSG_ATTR_CACHE_* bits of @attr */
+static bool get_shm_cattr(uint32_t attr, uint32_t *cattr)
+{
+	switch ((attr >> OPTEE_MSG_ATTR_CACHE_SHIFT) &
+		OPTEE_MSG_ATTR_CACHE_MASK) {
+	case OPTEE_MSG_ATTR_CACHE_PREDEFINED:
+	case OPTEE_SMC_SHM_CACHED:
+		*cattr = TEE_MATTR_CACHE_CACHED;
+		return true;
+	case OPTEE_SMC_SHM_WRITE_COMBINE:
+		*cattr = TEE_MATTR_CACHE_WC;
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Registers the buffer described by @param, on success @cookie is
+ * updated with the cookie of the registered buffer.
+ */
+static TEE_Result register_shm_param(struct optee_msg_param *param,
+				     uint64_t *cookie)
+{
+	const uint32_t cache_mask = OPTEE_MSG_ATTR_CACHE_MASK <<
+				    OPTEE_MSG_ATTR_CACHE_SHIFT;
+	struct optee_msg_param_tmem *tmem = &param->u.tmem;
+	uint32_t attr = READ_ONCE(param->attr);
+	struct mobj *mobj = NULL;
+	uint32_t cattr = 0;
+
+	if (((attr & ~cache_mask) !=
+	     (OPTEE_MSG_ATTR_TYPE_TMEM_OUTPUT | OPTEE_MSG_ATTR_NONCONTIG)) ||
+	    !get_shm_cattr(attr, &cattr))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mobj = msg_param_mobj_from_noncontig(READ_ONCE(tmem->buf_ptr),
+					     READ_ONCE(tmem->size),
+					     READ_ONCE(tmem->shm_ref), false,
+					     cattr);
+	if (!mobj)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Read before unguarding, the buffer may be released after that */
+	*cookie = mobj_get_cookie(mobj);
+	mobj_reg_shm_unguard(mobj);
+
+	return TEE_SUCCESS;
+}
+
 static void register_shm(struct optee_msg_arg *arg, uint32_t num_params)
 {
-	arg->ret = TEE_ERROR_BAD_PARAMETERS;
+	uint64_t cookie = 0;
 
-	if (num_params != 1 ||
-	    (arg->params[0].attr !=
-	     (OPTEE_MSG_ATTR_TYPE_TMEM_OUTPUT | OPTEE_MSG_ATTR_NONCONTIG)))
-		return;
+	if (num_params != 1)
+		arg->ret = TEE_ERROR_BAD_PARAMETERS;
+	else
+		arg->ret = register_shm_param(arg->params, &cookie);
+}
 
-	struct optee_msg_param_tmem *tmem = &arg->params[0].u.tmem;
-	struct mobj *mobj = msg_param_mobj_from_noncontig(tmem->buf_ptr,
-							  tmem->size,
-							  tmem->shm_ref, false);
+static void register_shm_batch(struct optee_msg_arg *arg,
+			       uint32_t num_params)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t *cookies = NULL;
+	size_t n = 0;
 
-	if (!mobj)
+	arg->ret_origin = TEE_ORIGIN_TEE;
+	if (!num_params) {
+		arg->ret = TEE_ERROR_BAD_PARAMETERS;
 		return;
+	}
 
-	mobj_reg_shm_unguard(mobj);
-	arg->ret = TEE_SUCCESS;
+	cookies = calloc(num_params, sizeof(*cookies));
+	if (!cookies) {
+		arg->ret = TEE_ERROR_OUT_OF_MEMORY;
+		return;
+	}
+
+	for (n = 0; n < num_params; n++) {
+		res = register_shm_param(arg->params + n, cookies + n);
+		if (res)
+			break;
+	}
+
+	/* All or nothing, release what was registered before the error */
+	if (res) {
+		while (n) {
+			n--;
+			mobj_reg_shm_release_by_cookie(cookies[n]);
+		}
+	}
+
+	free(cookies);
+	arg->ret = res;
 }
 
 static void unregister_shm(struct optee_msg_arg *arg, uint32_t num_params)
@@ -464,8 +804,126 @@ static void unregister_shm(struct optee_msg_arg *arg, uint32_t num_params)
 		arg->ret_origin = TEE_ORIGIN_TEE;
 	}
 }
+
+static void unregister_shm_batch(struct optee_msg_arg *arg,
+				 uint32_t num_params)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t cookie = 0;
+	size_t n = 0;
+
+	arg->ret_origin = TEE_ORIGIN_TEE;
+	arg->ret = TEE_ERROR_BAD_PARAMETERS;
+	if (!num_params)
+		return;
+
+	arg->ret = TEE_SUCCESS;
+	for (n = 0; n < num_params; n++) {
+		if (READ_ONCE(arg->params[n].attr) !=
+		    OPTEE_MSG_ATTR_TYPE_RMEM_INPUT) {
+			res = TEE_ERROR_BAD_PARAMETERS;
+		} else {
+			cookie = READ_ONCE(arg->params[n].u.rmem.shm_ref);
+			res = mobj_reg_shm_release_by_cookie(cookie);
+			if (res)
+				EMSG("Can't find mapping with cookie %#"PRIx64,
+				     cookie);
+		}
+		/* Carry on with the rest, the first error is returned */
+		if (res && !arg->ret)
+			arg->ret = res;
+	}
+}
 #endif /*CFG_CORE_DYN_SHM*/
 
+#ifdef CFG_CORE_TELEMETRY
+static void set_telemetry(struct optee_msg_arg *arg, uint32_t num_params)
+{
+	struct optee_msg_param_rmem *rmem = &arg->params[0].u.rmem;
+	uint64_t cookie = 0;
+	size_t offs = 0;
+	size_t size = 0;
+
+	arg->ret_origin = TEE_ORIGIN_TEE;
+	if (!num_params) {
+		arg->ret = telemetry_set_page(0, 0, &size);
+		return;
+	}
+	if (num_params != 1 ||
+	    READ_ONCE(arg->params[0].attr) != OPTEE_MSG_ATTR_TYPE_RMEM_INOUT) {
+		arg->ret = TEE_ERROR_BAD_PARAMETERS;
+		return;
+	}
+
+	cookie = READ_ONCE(rmem->shm_ref);
+	offs = READ_ONCE(rmem->offs);
+	size = READ_ONCE(rmem->size);
+	if (!cookie) {
+		arg->ret = TEE_ERROR_BAD_PARAMETERS;
+		return;
+	}
+
+	arg->ret = telemetry_set_page(cookie, offs, &size);
+	if (arg->ret == TEE_ERROR_SHORT_BUFFER)
+		rmem->size = size;
+}
+#endif /*CFG_CORE_TELEMETRY*/
+
+#ifdef CFG_SDP_POOL
+static void sdp_alloc(struct optee_msg_arg *arg, uint32_t num_params)
+{
+	struct optee_msg_param_value *val = &arg->params[0].u.value;
+	struct mobj *mobj = NULL;
+	paddr_t pa = 0;
+
+	arg->ret_origin = TEE_ORIGIN_TEE;
+	arg->ret = TEE_ERROR_BAD_PARAMETERS;
+	if (num_params != 1 ||
+	    arg->params[0].attr != OPTEE_MSG_ATTR_TYPE_VALUE_INOUT ||
+	    val->a > SIZE_MAX)
+		return;
+
+	mobj = mobj_sdp_pool_alloc(val->a, val->b);
+	if (!mobj) {
+		arg->ret = TEE_ERROR_OUT_OF_MEMORY;
+		return;
+	}
+	if (mobj_get_pa(mobj, 0, 0, &pa))
+		panic();
+
+	val->a = pa;
+	val->b = mobj->size;
+	arg->ret = TEE_SUCCESS;
+}
+
+static void sdp_free(struct optee_msg_arg *arg, uint32_t num_params)
+{
+	arg->ret_origin = TEE_ORIGIN_TEE;
+	if (num_params != 1 ||
+	    arg->params[0].attr != OPTEE_MSG_ATTR_TYPE_VALUE_INPUT) {
+		arg->ret = TEE_ERROR_BAD_PARAMETERS;
+		return;
+	}
+
+	arg->ret = mobj_sdp_pool_release_by_cookie(arg->params[0].u.value.a);
+	if (arg->ret)
+		EMSG("Can't find SDP buffer with given cookie");
+}
+#endif /*CFG_SDP_POOL*/
+
+static void entry_do_work(struct optee_msg_arg *arg, uint32_t num_params)
+{
+	if (num_params) {
+		arg->ret = TEE_ERROR_BAD_PARAMETERS;
+		arg->ret_origin = TEE_ORIGIN_TEE;
+		return;
+	}
+
+	work_run_worker();
+	arg->ret = TEE_SUCCESS;
+	arg->ret_origin = TEE_ORIGIN_TEE;
+}
+
 void nsec_sessions_list_head(struct tee_ta_session_head **open_sessions)
 {
 	*open_sessions = &tee_open_sessions;
@@ -485,6 +943,8 @@ uint32_t __tee_entry_std(struct optee_msg_arg *arg, uint32_t num_params)
 {
 	uint32_t rv = OPTEE_SMC_RETURN_OK;
 
+	TRACEPOINT(PTA_TRACE_CAT_SMC, "std_entry", arg->cmd, arg->func);
+
 	/* Enable foreign interrupts for STD calls */
 	thread_set_foreign_intr(true);
 	switch (arg->cmd) {
@@ -497,9 +957,26 @@ uint32_t __tee_entry_std(struct optee_msg_arg *arg, uint32_t num_params)
 	case OPTEE_MSG_CMD_INVOKE_COMMAND:
 		entry_invoke_command(arg, num_params);
 		break;
+	case OPTEE_MSG_CMD_INVOKE_BATCH:
+		entry_invoke_batch(arg, num_params);
+		break;
+#ifdef CFG_CORE_ASYNC_NOTIF
+	case OPTEE_MSG_CMD_INVOKE_ASYNC:
+		entry_invoke_async(arg, num_params);
+		break;
+	case OPTEE_MSG_CMD_DO_ASYNC:
+		entry_do_async(arg, num_params);
+		break;
+	case OPTEE_MSG_CMD_GET_ASYNC_RESULT:
+		entry_get_async_result(arg, num_params);
+		break;
+#endif
 	case OPTEE_MSG_CMD_CANCEL:
 		entry_cancel(arg, num_params);
 		break;
+	case OPTEE_MSG_CMD_DO_WORK:
+		entry_do_work(arg, num_params);
+		break;
 #ifdef CFG_CORE_DYN_SHM
 	case OPTEE_MSG_CMD_REGISTER_SHM:
 		register_shm(arg, num_params);
@@ -507,12 +984,34 @@ uint32_t __tee_entry_std(struct optee_msg_arg *arg, uint32_t num_params)
 	case OPTEE_MSG_CMD_UNREGISTER_SHM:
 		unregister_shm(arg, num_params);
 		break;
+	case OPTEE_MSG_CMD_REGISTER_SHM_BATCH:
+		register_shm_batch(arg, num_params);
+		break;
+	case OPTEE_MSG_CMD_UNREGISTER_SHM_BATCH:
+		unregister_shm_batch(arg, num_params);
+		break;
+#endif
+#ifdef CFG_SDP_POOL
+	case OPTEE_MSG_CMD_SDP_ALLOC:
+		sdp_alloc(arg, num_params);
+		break;
+	case OPTEE_MSG_CMD_SDP_FREE:
+		sdp_free(arg, num_params);
+		break;
+#endif
+#ifdef CFG_CORE_TELEMETRY
+	case OPTEE_MSG_CMD_SET_TELEMETRY:
+		set_telemetry(arg, num_params);
+		break;
 #endif
 	default:
 		EMSG("Unknown cmd 0x%x", arg->cmd);
 		rv = OPTEE_SMC_RETURN_EBADCMD;
 	}
 
+	TRACEPOINT(PTA_TRACE_CAT_SMC, "std_exit", arg->cmd, arg->ret);
+	telemetry_update();
+
 	return rv;
 }
 
@@ -4,9 +4,13 @@
  */
 
 #include <initcall.h>
+#include <kernel/boot_profile.h>
 #include <kernel/linker.h>
+#include <kernel/mutex.h>
+#include <kernel/thread.h>
 #include <kernel/tee_misc.h>
 #include <kernel/time_source.h>
+#include <kernel/work_queue.h>
 #include <malloc.h>		/* required for inits */
 #include <mm/core_memprot.h>
 #include <mm/fobj.h>
@@ -26,8 +30,10 @@ static void call_initcalls(void)
 	const initcall_t *call;
 
 	for (call = initcall_begin; call < initcall_end; call++) {
+		size_t prof = boot_profile_begin(NULL, (vaddr_t)*call);
 		TEE_Result ret;
 		ret = (*call)();
+		boot_profile_end(prof, ret);
 		if (ret != TEE_SUCCESS) {
 			EMSG("Initial call 0x%08" PRIxVA " failed",
 			     (vaddr_t)call);
@@ -35,6 +41,47 @@ static void call_initcalls(void)
 	}
 }
 
+static struct mutex deferred_mu = MUTEX_INITIALIZER;
+static bool deferred_done;
+static int deferred_thread_id = -1;
+
+void initcall_run_deferred(void)
+{
+	const initcall_t *call = NULL;
+	TEE_Result ret = TEE_SUCCESS;
+
+	if (__atomic_load_n(&deferred_done, __ATOMIC_ACQUIRE))
+		return;
+	/* A deferred initcall depending on another one */
+	if (__atomic_load_n(&deferred_thread_id, __ATOMIC_RELAXED) ==
+	    thread_get_id())
+		return;
+
+	mutex_lock(&deferred_mu);
+	if (!deferred_done) {
+		__atomic_store_n(&deferred_thread_id, thread_get_id(),
+				 __ATOMIC_RELAXED);
+		for (call = deferred_initcall_begin;
+		     call < deferred_initcall_end; call++) {
+			ret = (*call)();
+			if (ret != TEE_SUCCESS)
+				EMSG("Deferred initcall 0x%08" PRIxVA " failed",
+				     (vaddr_t)call);
+		}
+		__atomic_store_n(&deferred_thread_id, -1, __ATOMIC_RELAXED);
+		__atomic_store_n(&deferred_done, true, __ATOMIC_RELEASE);
+	}
+	mutex_unlock(&deferred_mu);
+}
+
+static void deferred_initcalls_func(struct work *work __unused)
+{
+	initcall_run_deferred();
+}
+
+static struct work deferred_initcalls_work =
+	WORK_INITIALIZER(deferred_initcalls_func);
+
 /*
  * Note: this function is weak just to make it possible to exclude it from
  * the unpaged area.
@@ -42,6 +89,7 @@ static void call_initcalls(void)
 TEE_Result __weak init_teecore(void)
 {
 	static int is_first = 1;
+	size_t prof = 0;
 
 	/* (DEBUG) for inits at 1st TEE service: when UART is setup */
 	if (!is_first)
@@ -58,16 +106,24 @@ TEE_Result __weak init_teecore(void)
 #endif
 
 	/* time initialization */
+	prof = boot_profile_begin("time_source_init", 0);
 	time_source_init();
+	boot_profile_end(prof, TEE_SUCCESS);
 
 	/* call pre-define initcall routines */
+	prof = boot_profile_begin("initcalls", 0);
 	call_initcalls();
+	boot_profile_end(prof, TEE_SUCCESS);
+	/* Run when the first thread is available after boot */
+	work_queue(&deferred_initcalls_work);
 
 	/*
 	 * Now that RNG is initialized generate the key needed for r/w
 	 * paging.
 	 */
+	prof = boot_profile_begin("fobj_generate_authenc_key", 0);
 	fobj_generate_authenc_key();
+	boot_profile_end(prof, TEE_SUCCESS);
 
 	IMSG("Initialized");
 	return TEE_SUCCESS;
@@ -142,6 +142,12 @@ libdir = core/lib/zlib
 include mk/lib.mk
 endif
 
+ifeq ($(CFG_LZ4),y)
+libname = lz4
+libdir = core/lib/lz4
+include mk/lib.mk
+endif
+
 #
 # Do main source
 #
@@ -36,12 +36,24 @@ CFG_CRYPTO_DSA ?= y
 CFG_CRYPTO_RSA ?= y
 CFG_CRYPTO_DH ?= y
 CFG_CRYPTO_ECC ?= y
+# Precomputed multiples of the NIST P-256 and P-384 generators for ECC key
+# generation and ECDSA signing with LibTomCrypt. The tables are computed on
+# first use and take 1 kB (P-256) and 3 kB (P-384) of heap.
+CFG_CRYPTO_ECC_FIXED_BASE ?= y
+# X25519 key agreement (RFC 7748) and Ed25519 signatures (RFC 8032) as
+# TEE_ALG_X25519 and TEE_ALG_ED25519 from the GlobalPlatform TEE Internal
+# Core API v1.3. Implemented by LibTomCrypt with both crypto libraries.
+CFG_CRYPTO_X25519 ?= y
+CFG_CRYPTO_ED25519 ?= y
 
 # Authenticated encryption
 CFG_CRYPTO_CCM ?= y
 CFG_CRYPTO_GCM ?= y
 # Default uses the OP-TEE internal AES-GCM implementation
 CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB ?= n
+# ChaCha20-Poly1305 (RFC 8439), TEE_ALG_CHACHA20_POLY1305 is an OP-TEE
+# extension
+CFG_CRYPTO_CHACHA20_POLY1305 ?= y
 
 endif
 
@@ -74,6 +86,10 @@ ifeq ($(CFG_ARM64_core),y)
 CFG_CRYPTO_AES_ARM64_CE ?= $(CFG_CRYPTO_AES)
 CFG_CRYPTO_SHA1_ARM64_CE ?= $(CFG_CRYPTO_SHA1)
 CFG_CRYPTO_SHA256_ARM64_CE ?= $(CFG_CRYPTO_SHA256)
+# The SHA512 instructions are an optional ARMv8.2 extension (ID_AA64ISAR0_EL1
+# SHA2 field == 2), not part of the base Cryptographic Extensions, so they
+# have to be enabled explicitly for CPUs known to implement them.
+CFG_CRYPTO_SHA512_ARM64_CE ?= n
 endif
 
 else #CFG_CRYPTO_WITH_CE
@@ -82,6 +98,17 @@ CFG_AES_GCM_TABLE_BASED ?= y
 
 endif #!CFG_CRYPTO_WITH_CE
 
+# The ChaCha20 keystream only needs NEON, not the Cryptographic Extensions.
+# NEON is mandatory with AArch64 but optional on ARMv7-A, so there it has to
+# be enabled for cores known to have it.
+ifeq ($(CFG_ARM64_core),y)
+ifeq ($(CFG_WITH_VFP),y)
+CFG_CRYPTO_CHACHA20_ARM64_NEON ?= $(CFG_CRYPTO_CHACHA20_POLY1305)
+endif
+endif
+ifeq ($(CFG_ARM32_core),y)
+CFG_CRYPTO_CHACHA20_ARM32_NEON ?= n
+endif
 
 # Cryptographic extensions can only be used safely when OP-TEE knows how to
 # preserve the VFP context
@@ -91,6 +118,9 @@ endif
 ifeq ($(CFG_CRYPTO_SHA256_ARM64_CE),y)
 $(call force,CFG_WITH_VFP,y,required by CFG_CRYPTO_SHA256_ARM64_CE)
 endif
+ifeq ($(CFG_CRYPTO_SHA512_ARM64_CE),y)
+$(call force,CFG_WITH_VFP,y,required by CFG_CRYPTO_SHA512_ARM64_CE)
+endif
 ifeq ($(CFG_CRYPTO_SHA1_ARM32_CE),y)
 $(call force,CFG_WITH_VFP,y,required by CFG_CRYPTO_SHA1_ARM32_CE)
 endif
@@ -100,6 +130,12 @@ endif
 ifeq ($(CFG_CRYPTO_AES_ARM64_CE),y)
 $(call force,CFG_WITH_VFP,y,required by CFG_CRYPTO_AES_ARM64_CE)
 endif
+ifeq ($(CFG_CRYPTO_CHACHA20_ARM32_NEON),y)
+$(call force,CFG_WITH_VFP,y,required by CFG_CRYPTO_CHACHA20_ARM32_NEON)
+endif
+ifeq ($(CFG_CRYPTO_CHACHA20_ARM64_NEON),y)
+$(call force,CFG_WITH_VFP,y,required by CFG_CRYPTO_CHACHA20_ARM64_NEON)
+endif
 
 cryp-enable-all-depends = $(call cfg-enable-all-depends,$(strip $(1)),$(foreach v,$(2),CFG_CRYPTO_$(v)))
 $(eval $(call cryp-enable-all-depends,CFG_REE_FS, AES ECB CTR HMAC SHA256 GCM))
@@ -121,6 +157,9 @@ $(eval $(call cryp-dep-one, HMAC, MD5 SHA1 SHA224 SHA256 SHA384 SHA512))
 $(eval $(call cryp-dep-one, CMAC, AES))
 $(eval $(call cryp-dep-one, CBC_MAC, AES DES))
 $(eval $(call cryp-dep-one, CCM, AES))
+$(eval $(call cryp-dep-one, ECC_FIXED_BASE, ECC))
+# Ed25519 hashes the key and the message with SHA-512
+$(eval $(call cryp-dep-one, ED25519, SHA512))
 $(eval $(call cryp-dep-one, GCM, AES))
 # If no AES cipher mode is left, disable AES
 $(eval $(call cryp-dep-one, AES, ECB CBC CTR CTS XTS))
@@ -147,14 +186,16 @@ core-ltc-vars = AES DES
 core-ltc-vars += ECB CBC CTR CTS XTS
 core-ltc-vars += MD5 SHA1 SHA224 SHA256 SHA384 SHA512 SHA512_256
 core-ltc-vars += HMAC CMAC CBC_MAC
-core-ltc-vars += CCM
+core-ltc-vars += CCM CHACHA20_POLY1305
 ifeq ($(CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB),y)
 core-ltc-vars += GCM
 endif
-core-ltc-vars += RSA DSA DH ECC
+core-ltc-vars += RSA DSA DH ECC ECC_FIXED_BASE X25519 ED25519
 core-ltc-vars += AES_ARM64_CE AES_ARM32_CE
 core-ltc-vars += SHA1_ARM32_CE SHA1_ARM64_CE
 core-ltc-vars += SHA256_ARM32_CE SHA256_ARM64_CE
+core-ltc-vars += SHA512_ARM64_CE
+core-ltc-vars += CHACHA20_ARM32_NEON CHACHA20_ARM64_NEON
 core-ltc-vars += SIZE_OPTIMIZATION
 # Assigned selected CFG_CRYPTO_xxx as _CFG_CORE_LTC_xxx
 $(foreach v, $(core-ltc-vars), $(eval _CFG_CORE_LTC_$(v) := $(CFG_CRYPTO_$(v))))
@@ -172,10 +213,20 @@ _CFG_CORE_LTC_DSA := $(CFG_CRYPTO_DSA)
 _CFG_CORE_LTC_MPI := $(CFG_CRYPTO_DSA)
 _CFG_CORE_LTC_SHA256_DESC := $(CFG_CRYPTO_DSA)
 _CFG_CORE_LTC_SHA384_DESC := $(CFG_CRYPTO_DSA)
-_CFG_CORE_LTC_SHA512_DESC := $(CFG_CRYPTO_DSA)
+_CFG_CORE_LTC_SHA512_DESC := $(call cfg-one-enabled, CFG_CRYPTO_DSA \
+						       CFG_CRYPTO_ED25519)
 _CFG_CORE_LTC_XTS := $(CFG_CRYPTO_XTS)
 _CFG_CORE_LTC_CCM := $(CFG_CRYPTO_CCM)
+_CFG_CORE_LTC_CHACHA20_POLY1305 := $(CFG_CRYPTO_CHACHA20_POLY1305)
+_CFG_CORE_LTC_X25519 := $(CFG_CRYPTO_X25519)
+_CFG_CORE_LTC_ED25519 := $(CFG_CRYPTO_ED25519)
 _CFG_CORE_LTC_AES_DESC := $(call cfg-one-enabled, CFG_CRYPTO_XTS CFG_CRYPTO_CCM)
+# The Cryptographic Extensions kernels in core/arch/arm/crypto are shared
+# with the mbedTLS glue, let the LTC parts use them too
+_CFG_CORE_LTC_AES_ARM64_CE := $(CFG_CRYPTO_AES_ARM64_CE)
+_CFG_CORE_LTC_AES_ARM32_CE := $(CFG_CRYPTO_AES_ARM32_CE)
+_CFG_CORE_LTC_SHA256_ARM64_CE := $(CFG_CRYPTO_SHA256_ARM64_CE)
+_CFG_CORE_LTC_SHA256_ARM32_CE := $(CFG_CRYPTO_SHA256_ARM32_CE)
 endif
 
 ###############################################################
@@ -193,12 +244,15 @@ _CFG_CORE_LTC_HWSUPP_PMULL := $(CFG_HWSUPP_PMULL)
 # Assign aggregated variables
 ltc-one-enabled = $(call cfg-one-enabled,$(foreach v,$(1),_CFG_CORE_LTC_$(v)))
 _CFG_CORE_LTC_ACIPHER := $(call ltc-one-enabled, RSA DSA DH ECC)
-_CFG_CORE_LTC_AUTHENC := $(and $(filter y,$(_CFG_CORE_LTC_AES) \
-					  $(_CFG_CORE_LTC_AES_DESC)), \
-			       $(filter y,$(call ltc-one-enabled, CCM GCM)))
+_CFG_CORE_LTC_AUTHENC := $(or $(and $(filter y,$(_CFG_CORE_LTC_AES) \
+					      $(_CFG_CORE_LTC_AES_DESC)), \
+				   $(filter y,$(call ltc-one-enabled, CCM GCM))), \
+			       $(_CFG_CORE_LTC_CHACHA20_POLY1305))
 _CFG_CORE_LTC_CIPHER := $(call ltc-one-enabled, AES AES_DESC DES)
 _CFG_CORE_LTC_HASH := $(call ltc-one-enabled, MD5 SHA1 SHA224 SHA256 SHA384 \
 					      SHA512)
-_CFG_CORE_LTC_MAC := $(call ltc-one-enabled, HMAC CMAC CBC_MAC)
+_CFG_CORE_LTC_MAC := $(call ltc-one-enabled, HMAC CMAC CBC_MAC \
+					     CHACHA20_POLY1305)
 _CFG_CORE_LTC_CBC := $(call ltc-one-enabled, CBC CBC_MAC)
 _CFG_CORE_LTC_ASN1 := $(call ltc-one-enabled, RSA DSA ECC)
+_CFG_CORE_LTC_EC25519 := $(call ltc-one-enabled, X25519 ED25519)
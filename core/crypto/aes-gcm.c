@@ -67,20 +67,16 @@ static void ghash_update_lengths(struct internal_aes_gcm_state *state,
 	internal_aes_gcm_ghash_update(state, (uint8_t *)len_fields, NULL, 0);
 }
 
-static TEE_Result __gcm_init(struct internal_aes_gcm_state *state,
+/*
+ * Starts a new message, @state only holds what internal_aes_gcm_set_key()
+ * derived from the key and is cleared otherwise.
+ */
+static void __gcm_init_nonce(struct internal_aes_gcm_state *state,
 			     const struct internal_aes_gcm_key *ek,
 			     TEE_OperationMode mode, const void *nonce,
 			     size_t nonce_len, size_t tag_len)
 {
-	COMPILE_TIME_ASSERT(sizeof(state->ctr) == TEE_AES_BLOCK_SIZE);
-
-	if (tag_len > sizeof(state->buf_tag))
-		return TEE_ERROR_BAD_PARAMETERS;
-
-	memset(state, 0, sizeof(*state));
-
 	state->tag_len = tag_len;
-	internal_aes_gcm_set_key(state, ek);
 
 	if (nonce_len == (96 / 8)) {
 		memcpy(state->ctr, nonce, nonce_len);
@@ -116,6 +112,36 @@ static TEE_Result __gcm_init(struct internal_aes_gcm_state *state,
 		internal_aes_gcm_encrypt_block(ek, state->ctr, state->buf_cryp);
 		internal_aes_gcm_inc_ctr(state);
 	}
+}
+
+static TEE_Result __gcm_init(struct internal_aes_gcm_state *state,
+			     const struct internal_aes_gcm_key *ek,
+			     TEE_OperationMode mode, const void *nonce,
+			     size_t nonce_len, size_t tag_len)
+{
+	COMPILE_TIME_ASSERT(sizeof(state->ctr) == TEE_AES_BLOCK_SIZE);
+
+	if (tag_len > sizeof(state->buf_tag))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	memset(state, 0, sizeof(*state));
+	internal_aes_gcm_set_key(state, ek);
+	__gcm_init_nonce(state, ek, mode, nonce, nonce_len, tag_len);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result
+__gcm_init_prepared(struct internal_aes_gcm_state *state,
+		    const struct internal_aes_gcm_prepared_key *pk,
+		    TEE_OperationMode mode, const void *nonce,
+		    size_t nonce_len, size_t tag_len)
+{
+	if (tag_len > sizeof(state->buf_tag))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	*state = pk->state;
+	__gcm_init_nonce(state, &pk->key, mode, nonce, nonce_len, tag_len);
 
 	return TEE_SUCCESS;
 }
@@ -355,6 +381,40 @@ void internal_aes_gcm_inc_ctr(struct internal_aes_gcm_state *state)
 	}
 }
 
+static TEE_Result __gcm_enc(struct internal_aes_gcm_state *state,
+			    const struct internal_aes_gcm_key *enc_key,
+			    const void *aad, size_t aad_len,
+			    const void *src, size_t len, void *dst,
+			    void *tag, size_t *tag_len)
+{
+	TEE_Result res;
+
+	if (aad) {
+		res = __gcm_update_aad(state, aad, aad_len);
+		if (res)
+			return res;
+	}
+
+	return __gcm_enc_final(state, enc_key, src, len, dst, tag, tag_len);
+}
+
+static TEE_Result __gcm_dec(struct internal_aes_gcm_state *state,
+			    const struct internal_aes_gcm_key *enc_key,
+			    const void *aad, size_t aad_len,
+			    const void *src, size_t len, void *dst,
+			    const void *tag, size_t tag_len)
+{
+	TEE_Result res;
+
+	if (aad) {
+		res = __gcm_update_aad(state, aad, aad_len);
+		if (res)
+			return res;
+	}
+
+	return __gcm_dec_final(state, enc_key, src, len, dst, tag, tag_len);
+}
+
 TEE_Result internal_aes_gcm_enc(const struct internal_aes_gcm_key *enc_key,
 				const void *nonce, size_t nonce_len,
 				const void *aad, size_t aad_len,
@@ -369,13 +429,8 @@ TEE_Result internal_aes_gcm_enc(const struct internal_aes_gcm_key *enc_key,
 	if (res)
 		return res;
 
-	if (aad) {
-		res = __gcm_update_aad(&state, aad, aad_len);
-		if (res)
-			return res;
-	}
-
-	return __gcm_enc_final(&state, enc_key, src, len, dst, tag, tag_len);
+	return __gcm_enc(&state, enc_key, aad, aad_len, src, len, dst, tag,
+			 tag_len);
 }
 
 TEE_Result internal_aes_gcm_dec(const struct internal_aes_gcm_key *enc_key,
@@ -392,13 +447,62 @@ TEE_Result internal_aes_gcm_dec(const struct internal_aes_gcm_key *enc_key,
 	if (res)
 		return res;
 
-	if (aad) {
-		res = __gcm_update_aad(&state, aad, aad_len);
-		if (res)
-			return res;
-	}
+	return __gcm_dec(&state, enc_key, aad, aad_len, src, len, dst, tag,
+			 tag_len);
+}
 
-	return __gcm_dec_final(&state, enc_key, src, len, dst, tag, tag_len);
+TEE_Result
+internal_aes_gcm_prepare_key(const void *key, size_t key_len,
+			     struct internal_aes_gcm_prepared_key *pk)
+{
+	TEE_Result res = internal_aes_gcm_expand_enc_key(key, key_len,
+							 &pk->key);
+
+	if (res)
+		return res;
+
+	memset(&pk->state, 0, sizeof(pk->state));
+	internal_aes_gcm_set_key(&pk->state, &pk->key);
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result
+internal_aes_gcm_enc_prepared(const struct internal_aes_gcm_prepared_key *pk,
+			      const void *nonce, size_t nonce_len,
+			      const void *aad, size_t aad_len,
+			      const void *src, size_t len, void *dst,
+			      void *tag, size_t *tag_len)
+{
+	TEE_Result res;
+	struct internal_aes_gcm_state state;
+
+	res = __gcm_init_prepared(&state, pk, TEE_MODE_ENCRYPT, nonce,
+				  nonce_len, *tag_len);
+	if (res)
+		return res;
+
+	return __gcm_enc(&state, &pk->key, aad, aad_len, src, len, dst, tag,
+			 tag_len);
+}
+
+TEE_Result
+internal_aes_gcm_dec_prepared(const struct internal_aes_gcm_prepared_key *pk,
+			      const void *nonce, size_t nonce_len,
+			      const void *aad, size_t aad_len,
+			      const void *src, size_t len, void *dst,
+			      const void *tag, size_t tag_len)
+{
+	TEE_Result res;
+	struct internal_aes_gcm_state state;
+
+	res = __gcm_init_prepared(&state, pk, TEE_MODE_DECRYPT, nonce,
+				  nonce_len, tag_len);
+	if (res)
+		return res;
+
+	return __gcm_dec(&state, &pk->key, aad, aad_len, src, len, dst, tag,
+			 tag_len);
 }
 
 
@@ -409,6 +513,9 @@ TEE_Result internal_aes_gcm_dec(const struct internal_aes_gcm_key *enc_key,
 struct aes_gcm_ctx {
 	struct crypto_authenc_ctx aec;
 	struct internal_aes_gcm_ctx ctx;
+	/* Key of the last init, aes_gcm_reinit() starts from it */
+	struct internal_aes_gcm_prepared_key pk;
+	bool keyed;
 };
 
 static const struct crypto_authenc_ops aes_gcm_ops;
@@ -436,24 +543,61 @@ TEE_Result crypto_aes_gcm_alloc_ctx(struct crypto_authenc_ctx **ctx_ret)
 
 static void aes_gcm_free_ctx(struct crypto_authenc_ctx *aec)
 {
-	free(to_aes_gcm_ctx(aec));
+	struct aes_gcm_ctx *ctx = to_aes_gcm_ctx(aec);
+
+	memzero_explicit(&ctx->pk, sizeof(ctx->pk));
+	free(ctx);
 }
 
 static void aes_gcm_copy_state(struct crypto_authenc_ctx *dst_ctx,
 			       struct crypto_authenc_ctx *src_ctx)
 {
-	to_aes_gcm_ctx(dst_ctx)->ctx = to_aes_gcm_ctx(src_ctx)->ctx;
+	struct aes_gcm_ctx *src = to_aes_gcm_ctx(src_ctx);
+	struct aes_gcm_ctx *dst = to_aes_gcm_ctx(dst_ctx);
+
+	dst->ctx = src->ctx;
+	dst->pk = src->pk;
+	dst->keyed = src->keyed;
+}
+
+static TEE_Result aes_gcm_reinit(struct crypto_authenc_ctx *aec,
+				 TEE_OperationMode mode,
+				 const uint8_t *nonce, size_t nonce_len,
+				 size_t tag_len, size_t aad_len __unused,
+				 size_t payload_len __unused)
+{
+	struct aes_gcm_ctx *ctx = to_aes_gcm_ctx(aec);
+
+	if (!ctx->keyed)
+		return TEE_ERROR_BAD_STATE;
+
+	ctx->ctx.key = ctx->pk.key;
+	return __gcm_init_prepared(&ctx->ctx.state, &ctx->pk, mode, nonce,
+				   nonce_len, tag_len);
 }
 
+/*
+ * The key is expanded and the hash subkey derived once into ctx->pk, so
+ * that aes_gcm_reinit() only has to process the nonce.
+ */
 static TEE_Result aes_gcm_init(struct crypto_authenc_ctx *aec,
 			       TEE_OperationMode mode,
 			       const uint8_t *key, size_t key_len,
 			       const uint8_t *nonce, size_t nonce_len,
-			       size_t tag_len, size_t aad_len __unused,
-			       size_t payload_len __unused)
+			       size_t tag_len, size_t aad_len,
+			       size_t payload_len)
 {
-	return internal_aes_gcm_init(&to_aes_gcm_ctx(aec)->ctx, mode, key,
-				     key_len, nonce, nonce_len, tag_len);
+	struct aes_gcm_ctx *ctx = to_aes_gcm_ctx(aec);
+	TEE_Result res = TEE_SUCCESS;
+
+	ctx->keyed = false;
+	res = internal_aes_gcm_prepare_key(key, key_len, &ctx->pk);
+	if (res)
+		return res;
+	ctx->keyed = true;
+
+	return aes_gcm_reinit(aec, mode, nonce, nonce_len, tag_len, aad_len,
+			      payload_len);
 }
 
 static TEE_Result aes_gcm_update_aad(struct crypto_authenc_ctx *aec,
@@ -502,5 +646,6 @@ static const struct crypto_authenc_ops aes_gcm_ops = {
 	.final = aes_gcm_final,
 	.free_ctx = aes_gcm_free_ctx,
 	.copy_state = aes_gcm_copy_state,
+	.reinit = aes_gcm_reinit,
 };
 #endif /*!CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB*/
@@ -10,8 +10,30 @@
 #include <kernel/panic.h>
 #include <stdlib.h>
 #include <string.h>
+#include <tee_api_defines_extensions.h>
 #include <utee_defines.h>
 
+TEE_Result crypto_sw_hash_alloc_ctx(struct crypto_hash_ctx **ctx,
+				    uint32_t algo)
+{
+	switch (algo) {
+	case TEE_ALG_MD5:
+		return crypto_md5_alloc_ctx(ctx);
+	case TEE_ALG_SHA1:
+		return crypto_sha1_alloc_ctx(ctx);
+	case TEE_ALG_SHA224:
+		return crypto_sha224_alloc_ctx(ctx);
+	case TEE_ALG_SHA256:
+		return crypto_sha256_alloc_ctx(ctx);
+	case TEE_ALG_SHA384:
+		return crypto_sha384_alloc_ctx(ctx);
+	case TEE_ALG_SHA512:
+		return crypto_sha512_alloc_ctx(ctx);
+	default:
+		return TEE_ERROR_NOT_IMPLEMENTED;
+	}
+}
+
 TEE_Result crypto_hash_alloc_ctx(void **ctx, uint32_t algo)
 {
 	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
@@ -23,30 +45,10 @@ TEE_Result crypto_hash_alloc_ctx(void **ctx, uint32_t algo)
 	 */
 	res = drvcrypt_hash_alloc_ctx(&c, algo);
 
-	if (res == TEE_ERROR_NOT_IMPLEMENTED) {
-		switch (algo) {
-		case TEE_ALG_MD5:
-			res = crypto_md5_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA1:
-			res = crypto_sha1_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA224:
-			res = crypto_sha224_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA256:
-			res = crypto_sha256_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA384:
-			res = crypto_sha384_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA512:
-			res = crypto_sha512_alloc_ctx(&c);
-			break;
-		default:
-			break;
-		}
-	}
+	if (res == TEE_ERROR_NOT_IMPLEMENTED)
+		res = crypto_sw_hash_alloc_ctx(&c, algo);
+	else if (!res)
+		res = drvcrypt_hash_dispatch_ctx(&c, algo);
 
 	if (!res)
 		*ctx = c;
@@ -92,6 +94,33 @@ TEE_Result crypto_hash_final(void *ctx, uint32_t algo __unused,
 	return hash_ops(ctx)->final(ctx, digest, len);
 }
 
+TEE_Result crypto_sw_cipher_alloc_ctx(struct crypto_cipher_ctx **ctx,
+				      uint32_t algo)
+{
+	switch (algo) {
+	case TEE_ALG_AES_ECB_NOPAD:
+		return crypto_aes_ecb_alloc_ctx(ctx);
+	case TEE_ALG_AES_CBC_NOPAD:
+		return crypto_aes_cbc_alloc_ctx(ctx);
+	case TEE_ALG_AES_CTR:
+		return crypto_aes_ctr_alloc_ctx(ctx);
+	case TEE_ALG_AES_CTS:
+		return crypto_aes_cts_alloc_ctx(ctx);
+	case TEE_ALG_AES_XTS:
+		return crypto_aes_xts_alloc_ctx(ctx);
+	case TEE_ALG_DES_ECB_NOPAD:
+		return crypto_des_ecb_alloc_ctx(ctx);
+	case TEE_ALG_DES3_ECB_NOPAD:
+		return crypto_des3_ecb_alloc_ctx(ctx);
+	case TEE_ALG_DES_CBC_NOPAD:
+		return crypto_des_cbc_alloc_ctx(ctx);
+	case TEE_ALG_DES3_CBC_NOPAD:
+		return crypto_des3_cbc_alloc_ctx(ctx);
+	default:
+		return TEE_ERROR_NOT_IMPLEMENTED;
+	}
+}
+
 TEE_Result crypto_cipher_alloc_ctx(void **ctx, uint32_t algo)
 {
 	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
@@ -103,39 +132,10 @@ TEE_Result crypto_cipher_alloc_ctx(void **ctx, uint32_t algo)
 	 */
 	res = drvcrypt_cipher_alloc_ctx(&c, algo);
 
-	if (res == TEE_ERROR_NOT_IMPLEMENTED) {
-		switch (algo) {
-		case TEE_ALG_AES_ECB_NOPAD:
-			res = crypto_aes_ecb_alloc_ctx(&c);
-			break;
-		case TEE_ALG_AES_CBC_NOPAD:
-			res = crypto_aes_cbc_alloc_ctx(&c);
-			break;
-		case TEE_ALG_AES_CTR:
-			res = crypto_aes_ctr_alloc_ctx(&c);
-			break;
-		case TEE_ALG_AES_CTS:
-			res = crypto_aes_cts_alloc_ctx(&c);
-			break;
-		case TEE_ALG_AES_XTS:
-			res = crypto_aes_xts_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES_ECB_NOPAD:
-			res = crypto_des_ecb_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES3_ECB_NOPAD:
-			res = crypto_des3_ecb_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES_CBC_NOPAD:
-			res = crypto_des_cbc_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES3_CBC_NOPAD:
-			res = crypto_des3_cbc_alloc_ctx(&c);
-			break;
-		default:
-			return TEE_ERROR_NOT_IMPLEMENTED;
-		}
-	}
+	if (res == TEE_ERROR_NOT_IMPLEMENTED)
+		res = crypto_sw_cipher_alloc_ctx(&c, algo);
+	else if (!res)
+		res = drvcrypt_cipher_dispatch_ctx(&c, algo);
 
 	if (!res)
 		*ctx = c;
@@ -189,6 +189,51 @@ void crypto_cipher_final(void *ctx, uint32_t algo __unused)
 	cipher_ops(ctx)->final(ctx);
 }
 
+TEE_Result crypto_cipher_reinit(void *ctx, uint32_t algo __unused,
+				TEE_OperationMode mode, const uint8_t *iv,
+				size_t iv_len)
+{
+	if (mode != TEE_MODE_DECRYPT && mode != TEE_MODE_ENCRYPT)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!cipher_ops(ctx)->reinit)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	return cipher_ops(ctx)->reinit(ctx, mode, iv, iv_len);
+}
+
+TEE_Result crypto_cipher_update_multi(void *ctx[], uint32_t algo __unused,
+				      TEE_OperationMode mode __unused,
+				      size_t num, const uint8_t *data[],
+				      size_t len, uint8_t *dst[])
+{
+	struct crypto_cipher_ctx *c[CRYPTO_CIPHER_UPDATE_MULTI_MAX] = { };
+	const struct crypto_cipher_ops *ops = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	if (!num || num > CRYPTO_CIPHER_UPDATE_MULTI_MAX)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	ops = cipher_ops(ctx[0]);
+	for (n = 0; n < num; n++) {
+		c[n] = ctx[n];
+		if (cipher_ops(c[n]) != ops)
+			return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (num > 1 && ops->update_multi)
+		return ops->update_multi(c, num, data, len, dst);
+
+	for (n = 0; n < num; n++) {
+		res = ops->update(c[n], false, data[n], len, dst[n]);
+		if (res)
+			return res;
+	}
+
+	return TEE_SUCCESS;
+}
+
 TEE_Result crypto_cipher_get_block_size(uint32_t algo, size_t *size)
 {
 	uint32_t class = TEE_ALG_GET_CLASS(algo);
@@ -315,6 +360,14 @@ TEE_Result crypto_mac_final(void *ctx, uint32_t algo __unused,
 	return mac_ops(ctx)->final(ctx, digest, digest_len);
 }
 
+TEE_Result crypto_mac_reinit(void *ctx, uint32_t algo __unused)
+{
+	if (!mac_ops(ctx)->reinit)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	return mac_ops(ctx)->reinit(ctx);
+}
+
 TEE_Result crypto_authenc_alloc_ctx(void **ctx, uint32_t algo)
 {
 	TEE_Result res = TEE_SUCCESS;
@@ -330,6 +383,11 @@ TEE_Result crypto_authenc_alloc_ctx(void **ctx, uint32_t algo)
 	case TEE_ALG_AES_GCM:
 		res = crypto_aes_gcm_alloc_ctx(&c);
 		break;
+#endif
+#if defined(CFG_CRYPTO_CHACHA20_POLY1305)
+	case TEE_ALG_CHACHA20_POLY1305:
+		res = crypto_chacha20_poly1305_alloc_ctx(&c);
+		break;
 #endif
 	default:
 		return TEE_ERROR_NOT_IMPLEMENTED;
@@ -361,6 +419,19 @@ TEE_Result crypto_authenc_init(void *ctx, uint32_t algo __unused,
 				 tag_len, aad_len, payload_len);
 }
 
+TEE_Result crypto_authenc_reinit(void *ctx, uint32_t algo __unused,
+				 TEE_OperationMode mode,
+				 const uint8_t *nonce, size_t nonce_len,
+				 size_t tag_len, size_t aad_len,
+				 size_t payload_len)
+{
+	if (!ae_ops(ctx)->reinit)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	return ae_ops(ctx)->reinit(ctx, mode, nonce, nonce_len, tag_len,
+				   aad_len, payload_len);
+}
+
 TEE_Result crypto_authenc_update_aad(void *ctx, uint32_t algo __unused,
 				     TEE_OperationMode mode __unused,
 				     const uint8_t *data, size_t len)
@@ -515,6 +586,10 @@ void crypto_acipher_free_rsa_public_key(struct rsa_public_key *s __unused)
 {
 }
 
+void crypto_acipher_clear_rsa_keypair_cache(struct rsa_keypair *s __unused)
+{
+}
+
 TEE_Result crypto_acipher_gen_rsa_key(struct rsa_keypair *key __unused,
 				      size_t key_size __unused)
 {
@@ -702,3 +777,43 @@ crypto_acipher_ecc_shared_secret(struct ecc_keypair *private_key __unused,
 	return TEE_ERROR_NOT_IMPLEMENTED;
 }
 #endif /*!CFG_CRYPTO_ECC*/
+
+#if !defined(CFG_CRYPTO_X25519)
+TEE_Result crypto_acipher_gen_x25519_key(struct x25519_keypair *key __unused)
+{
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+
+TEE_Result
+crypto_acipher_x25519_shared_secret(struct x25519_keypair *private_key __unused,
+				    const uint8_t *public_key __unused,
+				    uint8_t *secret __unused)
+{
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+#endif /*!CFG_CRYPTO_X25519*/
+
+#if !defined(CFG_CRYPTO_ED25519)
+TEE_Result crypto_acipher_gen_ed25519_key(struct ed25519_keypair *key __unused)
+{
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+
+TEE_Result crypto_acipher_ed25519_sign(struct ed25519_keypair *key __unused,
+				       const uint8_t *msg __unused,
+				       size_t msg_len __unused,
+				       uint8_t *sig __unused,
+				       size_t *sig_len __unused)
+{
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+
+TEE_Result crypto_acipher_ed25519_verify(struct ed25519_public_key *key __unused,
+					 const uint8_t *msg __unused,
+					 size_t msg_len __unused,
+					 const uint8_t *sig __unused,
+					 size_t sig_len __unused)
+{
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+#endif /*!CFG_CRYPTO_ED25519*/
@@ -13,7 +13,9 @@
 #include <kernel/refcount.h>
 #include <kernel/spinlock.h>
 #include <kernel/tee_time.h>
+#include <kernel/thread.h>
 #include <string.h>
+#include <string_ext.h>
 #include <types_ext.h>
 #include <utee_defines.h>
 #include <util.h>
@@ -26,6 +28,8 @@
 #define MIN_POOL_SIZE		64
 #define MAX_EVENT_DATA_LEN	32U
 #define RING_BUF_DATA_SIZE	4U
+#define GEN_BUF_SIZE		CFG_CORE_RNG_BUF_SIZE
+#define GEN_BUF_MAX_REQ		(GEN_BUF_SIZE / 4)
 
 /*
  * struct fortuna_state - state of the Fortuna PRNG
@@ -58,6 +62,39 @@ static struct fortuna_state {
 
 static struct mutex state_mu = MUTEX_INITIALIZER;
 
+/*
+ * struct fortuna_gen - Output generator of a thread
+ * @ctx:		Cipher context used to produce the random numbers
+ * @counter:		Counter which is encrypted to produce the random numbers
+ * @reseed_count:	Value of @state.reseed_count when the key was taken
+ *			from the central generator
+ * @seeded:		True if @ctx is keyed
+ * @buf_offs:		Offset of the first byte of @buf not handed out yet
+ * @buf:		Random bytes generated ahead for small requests
+ *
+ * Each thread produces random numbers with its own generator, keyed with
+ * output of the central generator in @state. @state_mu is only taken to
+ * replace the key, which is done when the central generator has been
+ * reseeded from the pools or when pool 0 is ready for a reseed. As with
+ * the central generator the key is replaced with generated data after
+ * each request, so the state of a generator doesn't reveal earlier
+ * output.
+ *
+ * Small requests are served from @buf, filled with a single request to
+ * the generator, and the bytes handed out are wiped. The bytes left in
+ * @buf are discarded when the key is replaced from the central generator.
+ *
+ * A generator is only used by its own thread.
+ */
+static struct fortuna_gen {
+	void *ctx;
+	uint64_t counter[2];
+	uint32_t reseed_count;
+	bool seeded;
+	size_t buf_offs;
+	uint8_t buf[GEN_BUF_SIZE];
+} gens[CFG_NUM_THREADS];
+
 static struct {
 	struct {
 		uint8_t snum;
@@ -312,15 +349,16 @@ void crypto_rng_add_event(enum crypto_rng_src sid, unsigned int *pnum,
 }
 
 /* GenerateBlocks */
-static TEE_Result generate_blocks(void *block, size_t nblocks)
+static TEE_Result generate_blocks(void *ctx, uint64_t counter[2], void *block,
+				  size_t nblocks)
 {
 	uint8_t *b = block;
 	size_t n;
 
 	for (n = 0; n < nblocks; n++) {
-		TEE_Result res = crypto_cipher_update(state.ctx, CIPHER_ALGO,
+		TEE_Result res = crypto_cipher_update(ctx, CIPHER_ALGO,
 						      TEE_MODE_ENCRYPT, false,
-						      (void *)state.counter,
+						      (void *)counter,
 						      BLOCK_SIZE,
 						      b + n * BLOCK_SIZE);
 
@@ -329,7 +367,7 @@ static TEE_Result generate_blocks(void *block, size_t nblocks)
 		 * eventual errors, we must never re-use the counter with
 		 * the same key.
 		 */
-		inc_counter(state.counter);
+		inc_counter(counter);
 		if (res)
 			return res;
 	}
@@ -338,24 +376,33 @@ static TEE_Result generate_blocks(void *block, size_t nblocks)
 }
 
 /* GenerateRandomData */
-static TEE_Result generate_random_data(void *buf, size_t blen)
+static TEE_Result generate_random_data(void *ctx, uint64_t counter[2],
+				       void *buf, size_t blen)
 {
 	TEE_Result res;
+	uint8_t new_key[KEY_SIZE];
 
-	res = generate_blocks(buf, blen / BLOCK_SIZE);
+	res = generate_blocks(ctx, counter, buf, blen / BLOCK_SIZE);
 	if (res)
 		return res;
 	if (blen % BLOCK_SIZE) {
 		uint8_t block[BLOCK_SIZE];
 		uint8_t *b = (uint8_t *)buf + ROUNDDOWN(blen, BLOCK_SIZE);
 
-		res = generate_blocks(block, 1);
+		res = generate_blocks(ctx, counter, block, 1);
 		if (res)
 			return res;
 		memcpy(b, block, blen % BLOCK_SIZE);
 	}
 
-	return TEE_SUCCESS;
+	res = generate_blocks(ctx, counter, new_key, KEY_SIZE / BLOCK_SIZE);
+	if (res)
+		return res;
+	crypto_cipher_final(ctx, CIPHER_ALGO);
+	res = cipher_init(ctx, new_key);
+	memzero_explicit(new_key, sizeof(new_key));
+
+	return res;
 }
 
 #ifdef CFG_SECURE_TIME_SOURCE_REE
@@ -487,30 +534,113 @@ static TEE_Result fortuna_read(void *buf, size_t blen)
 		goto out;
 
 	if (blen) {
-		uint8_t new_key[KEY_SIZE];
-
-		res = generate_random_data(buf, blen);
+		res = generate_random_data(state.ctx, state.counter, buf, blen);
 		if (res)
 			goto out;
+	}
 
-		res = generate_blocks(new_key, KEY_SIZE / BLOCK_SIZE);
+	res = drain_ring_buffer();
+out:
+	if (res)
+		fortuna_done();
+	mutex_unlock(&state_mu);
+
+	return res;
+}
+
+static bool gen_need_seed(struct fortuna_gen *gen)
+{
+	/* Unlocked reads, at worst the key is replaced once too often */
+	return !gen->seeded ||
+	       gen->reseed_count != atomic_load_uint(&state.reseed_count) ||
+	       atomic_load_uint(&state.pool0_length) >= MIN_POOL_SIZE;
+}
+
+static TEE_Result gen_seed(struct fortuna_gen *gen)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t key[KEY_SIZE];
+
+	if (!gen->ctx) {
+		res = crypto_cipher_alloc_ctx(&gen->ctx, CIPHER_ALGO);
 		if (res)
-			goto out;
-		crypto_cipher_final(state.ctx, CIPHER_ALGO);
-		res = cipher_init(state.ctx, new_key);
+			return res;
+	} else if (gen->seeded) {
+		crypto_cipher_final(gen->ctx, CIPHER_ALGO);
+	}
+	gen->seeded = false;
+	memzero_explicit(gen->buf, sizeof(gen->buf));
+	gen->buf_offs = sizeof(gen->buf);
+
+	/* Reseeds the central generator from the pools when possible */
+	res = fortuna_read(key, sizeof(key));
+	if (res)
+		goto out;
+	res = cipher_init(gen->ctx, key);
+	if (res)
+		goto out;
+
+	gen->reseed_count = atomic_load_uint(&state.reseed_count);
+	inc_counter(gen->counter);
+	gen->seeded = true;
+out:
+	memzero_explicit(key, sizeof(key));
+	return res;
+}
+
+static TEE_Result gen_read(struct fortuna_gen *gen, void *buf, size_t blen)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!state.ctx)
+		return TEE_ERROR_BAD_STATE;
+
+	if (gen_need_seed(gen)) {
+		res = gen_seed(gen);
+		if (res)
+			return res;
+	} else if (atomic_load_uint(&ring_buffer.begin) !=
+		   atomic_load_uint(&ring_buffer.end) &&
+		   mutex_trylock(&state_mu)) {
+		/* Feed the pools with the quick events pushed meanwhile */
+		drain_ring_buffer();
+		mutex_unlock(&state_mu);
+	}
+
+	if (blen > GEN_BUF_MAX_REQ) {
+		res = generate_random_data(gen->ctx, gen->counter, buf, blen);
+		goto out;
+	}
+
+	if (sizeof(gen->buf) - gen->buf_offs < blen) {
+		res = generate_random_data(gen->ctx, gen->counter, gen->buf,
+					   sizeof(gen->buf));
 		if (res)
 			goto out;
+		gen->buf_offs = 0;
 	}
 
-	res = drain_ring_buffer();
+	memcpy(buf, gen->buf + gen->buf_offs, blen);
+	memzero_explicit(gen->buf + gen->buf_offs, blen);
+	gen->buf_offs += blen;
 out:
 	if (res)
-		fortuna_done();
-	mutex_unlock(&state_mu);
+		gen->seeded = false;
 
 	return res;
 }
 
+static TEE_Result rng_read(void *buf, size_t blen)
+{
+	int ct = thread_get_id_may_fail();
+
+	/* The central generator is used before threads are available */
+	if (ct < 0)
+		return fortuna_read(buf, blen);
+
+	return gen_read(gens + ct, buf, blen);
+}
+
 TEE_Result crypto_rng_read(void *buf, size_t blen)
 {
 	size_t offs = 0;
@@ -523,7 +653,7 @@ TEE_Result crypto_rng_read(void *buf, size_t blen)
 		n = MIN(blen - offs, SIZE_1M);
 		if (!n)
 			return TEE_SUCCESS;
-		res = fortuna_read((uint8_t *)buf + offs, n);
+		res = rng_read((uint8_t *)buf + offs, n);
 		if (res)
 			return res;
 		offs += n;
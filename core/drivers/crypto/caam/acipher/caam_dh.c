@@ -64,7 +64,7 @@ static enum caam_status do_keypair_conv_p_g(struct caam_dh_keypair *outkey,
 		return CAAM_OUT_MEMORY;
 
 	crypto_bignum_bn2bin(inkey->p, outkey->p.data);
-	cache_operation(TEE_CACHECLEAN, outkey->p.data, outkey->p.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->p.data, outkey->p.length);
 
 	/* Generator */
 	retstatus = caam_calloc_buf(&outkey->g, p_size);
@@ -74,7 +74,7 @@ static enum caam_status do_keypair_conv_p_g(struct caam_dh_keypair *outkey,
 	/* Get the number of bytes of g to pad with 0's */
 	field_size = crypto_bignum_num_bytes(inkey->g);
 	crypto_bignum_bn2bin(inkey->g, outkey->g.data + p_size - field_size);
-	cache_operation(TEE_CACHECLEAN, outkey->g.data, outkey->g.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->g.data, outkey->g.length);
 
 	return CAAM_NO_ERROR;
 }
@@ -105,7 +105,7 @@ static enum caam_status do_keypriv_conv(struct caam_dh_keypair *outkey,
 		return CAAM_OUT_MEMORY;
 
 	crypto_bignum_bn2bin(inkey->p, outkey->p.data);
-	cache_operation(TEE_CACHECLEAN, outkey->p.data, outkey->p.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->p.data, outkey->p.length);
 
 	/* Private Key X */
 	retstatus = caam_calloc_buf(&outkey->x, key_size);
@@ -113,7 +113,7 @@ static enum caam_status do_keypriv_conv(struct caam_dh_keypair *outkey,
 		return CAAM_OUT_MEMORY;
 
 	crypto_bignum_bn2bin(inkey->x, outkey->x.data);
-	cache_operation(TEE_CACHECLEAN, outkey->x.data, outkey->x.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->x.data, outkey->x.length);
 
 	return CAAM_NO_ERROR;
 }
@@ -140,7 +140,7 @@ static enum caam_status do_keypub_conv(struct caam_dh_keypair *outkey,
 		return CAAM_OUT_MEMORY;
 
 	crypto_bignum_bn2bin(inkey, outkey->y.data);
-	cache_operation(TEE_CACHECLEAN, outkey->y.data, outkey->y.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->y.data, outkey->y.length);
 
 	return CAAM_NO_ERROR;
 }
@@ -261,8 +261,8 @@ static TEE_Result do_gen_keypair(struct dh_keypair *key,
 		ret = TEE_ERROR_OUT_OF_MEMORY;
 		goto out;
 	}
-	cache_operation(TEE_CACHEFLUSH, caam_dh_key.x.data,
-			caam_dh_key.x.length);
+	caam_cache_op(TEE_CACHEFLUSH, caam_dh_key.x.data,
+		      caam_dh_key.x.length);
 
 	/* Allocate Public Key to be generated */
 	retstatus = caam_calloc_align_buf(&caam_dh_key.y, l_bytes);
@@ -270,8 +270,8 @@ static TEE_Result do_gen_keypair(struct dh_keypair *key,
 		ret = TEE_ERROR_OUT_OF_MEMORY;
 		goto out;
 	}
-	cache_operation(TEE_CACHEFLUSH, caam_dh_key.y.data,
-			caam_dh_key.y.length);
+	caam_cache_op(TEE_CACHEFLUSH, caam_dh_key.y.data,
+		      caam_dh_key.y.length);
 
 	/* Allocate Private Key modulus (r) and fill it with one's */
 	retstatus = caam_calloc_buf(&dh_r, n_bytes);
@@ -281,7 +281,7 @@ static TEE_Result do_gen_keypair(struct dh_keypair *key,
 	}
 
 	memset(dh_r.data, UINT8_MAX, dh_r.length);
-	cache_operation(TEE_CACHECLEAN, dh_r.data, dh_r.length);
+	caam_cache_op(TEE_CACHECLEAN, dh_r.data, dh_r.length);
 
 	/* Generator and Prime */
 	retstatus = do_keypair_conv_p_g(&caam_dh_key, key);
@@ -321,10 +321,10 @@ static TEE_Result do_gen_keypair(struct dh_keypair *key,
 		retstatus = caam_jr_enqueue(&jobctx, NULL);
 
 		if (retstatus == CAAM_NO_ERROR) {
-			cache_operation(TEE_CACHEINVALIDATE, caam_dh_key.x.data,
-					caam_dh_key.x.length);
-			cache_operation(TEE_CACHEINVALIDATE, caam_dh_key.y.data,
-					caam_dh_key.y.length);
+			caam_cache_op(TEE_CACHEINVALIDATE, caam_dh_key.x.data,
+				      caam_dh_key.x.length);
+			caam_cache_op(TEE_CACHEINVALIDATE, caam_dh_key.y.data,
+				      caam_dh_key.y.length);
 
 			/* Copy Private and Public keypair */
 			ret = crypto_bignum_bin2bn(caam_dh_key.x.data,
@@ -112,20 +112,20 @@ static TEE_Result get_keypair_domain_params(struct caam_dsa_keypair *outkey,
 
 		crypto_bignum_bn2bin(key->q,
 				     outkey->q.data + n_bytes - in_q_size);
-		cache_operation(TEE_CACHECLEAN, outkey->q.data,
-				outkey->q.length);
+		caam_cache_op(TEE_CACHECLEAN, outkey->q.data,
+			      outkey->q.length);
 
 		DSA_TRACE("Prime G is defined");
 		crypto_bignum_bn2bin(key->g,
 				     outkey->g.data + l_bytes - in_g_size);
-		cache_operation(TEE_CACHECLEAN, outkey->g.data,
-				outkey->g.length);
+		caam_cache_op(TEE_CACHECLEAN, outkey->g.data,
+			      outkey->g.length);
 
 		DSA_TRACE("Prime P is defined");
 		crypto_bignum_bn2bin(key->p,
 				     outkey->p.data + l_bytes - in_p_size);
-		cache_operation(TEE_CACHECLEAN, outkey->p.data,
-				outkey->p.length);
+		caam_cache_op(TEE_CACHECLEAN, outkey->p.data,
+			      outkey->p.length);
 	}
 
 	return TEE_SUCCESS;
@@ -186,10 +186,10 @@ static enum caam_status do_keypriv_conv(struct caam_dsa_keypair *outkey,
 	field_size = crypto_bignum_num_bytes(inkey->x);
 	crypto_bignum_bn2bin(inkey->x, outkey->x.data + n_bytes - field_size);
 
-	cache_operation(TEE_CACHECLEAN, outkey->g.data, outkey->g.length);
-	cache_operation(TEE_CACHECLEAN, outkey->p.data, outkey->p.length);
-	cache_operation(TEE_CACHECLEAN, outkey->q.data, outkey->q.length);
-	cache_operation(TEE_CACHECLEAN, outkey->x.data, outkey->x.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->g.data, outkey->g.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->p.data, outkey->p.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->q.data, outkey->q.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->x.data, outkey->x.length);
 
 	return CAAM_NO_ERROR;
 }
@@ -249,10 +249,10 @@ static enum caam_status do_keypub_conv(struct caam_dsa_keypair *outkey,
 	field_size = crypto_bignum_num_bytes(inkey->y);
 	crypto_bignum_bn2bin(inkey->y, outkey->y.data + l_bytes - field_size);
 
-	cache_operation(TEE_CACHECLEAN, outkey->g.data, outkey->g.length);
-	cache_operation(TEE_CACHECLEAN, outkey->p.data, outkey->p.length);
-	cache_operation(TEE_CACHECLEAN, outkey->q.data, outkey->q.length);
-	cache_operation(TEE_CACHECLEAN, outkey->y.data, outkey->y.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->g.data, outkey->g.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->p.data, outkey->p.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->q.data, outkey->q.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->y.data, outkey->y.length);
 
 	return CAAM_NO_ERROR;
 }
@@ -401,8 +401,8 @@ static TEE_Result do_gen_keypair(struct dsa_keypair *key, size_t l_bits,
 		ret = TEE_ERROR_OUT_OF_MEMORY;
 		goto exit_gen_keypair;
 	}
-	cache_operation(TEE_CACHEFLUSH, caam_dsa_key.x.data,
-			caam_dsa_key.x.length);
+	caam_cache_op(TEE_CACHEFLUSH, caam_dsa_key.x.data,
+		      caam_dsa_key.x.length);
 
 	/* Allocate Public Key to be generated */
 	retstatus = caam_calloc_align_buf(&caam_dsa_key.y, l_bytes);
@@ -410,8 +410,8 @@ static TEE_Result do_gen_keypair(struct dsa_keypair *key, size_t l_bits,
 		ret = TEE_ERROR_OUT_OF_MEMORY;
 		goto exit_gen_keypair;
 	}
-	cache_operation(TEE_CACHEFLUSH, caam_dsa_key.y.data,
-			caam_dsa_key.y.length);
+	caam_cache_op(TEE_CACHEFLUSH, caam_dsa_key.y.data,
+		      caam_dsa_key.y.length);
 
 	/* Generator and Prime */
 	ret = get_keypair_domain_params(&caam_dsa_key, key, l_bytes, n_bytes);
@@ -442,10 +442,10 @@ static TEE_Result do_gen_keypair(struct dsa_keypair *key, size_t l_bits,
 	retstatus = caam_jr_enqueue(&jobctx, NULL);
 
 	if (retstatus == CAAM_NO_ERROR) {
-		cache_operation(TEE_CACHEINVALIDATE, caam_dsa_key.x.data,
-				caam_dsa_key.x.length);
-		cache_operation(TEE_CACHEINVALIDATE, caam_dsa_key.y.data,
-				caam_dsa_key.y.length);
+		caam_cache_op(TEE_CACHEINVALIDATE, caam_dsa_key.x.data,
+			      caam_dsa_key.x.length);
+		caam_cache_op(TEE_CACHEINVALIDATE, caam_dsa_key.y.data,
+			      caam_dsa_key.y.length);
 
 		/* Copy Private and Public keypair */
 		ret = crypto_bignum_bin2bn(caam_dsa_key.x.data,
@@ -748,7 +748,7 @@ static TEE_Result do_verify(struct drvcrypt_sign_data *sdata, size_t l_bytes,
 
 	jobctx.desc = desc;
 
-	cache_operation(TEE_CACHEFLUSH, tmp.data, tmp.length);
+	caam_cache_op(TEE_CACHEFLUSH, tmp.data, tmp.length);
 	retstatus = caam_jr_enqueue(&jobctx, NULL);
 
 	if (retstatus == CAAM_JOB_STATUS && !jobctx.status) {
@@ -74,7 +74,7 @@ static enum caam_status do_keypub_conv(struct caam_ecc_keypair *outkey,
 	y_size = crypto_bignum_num_bytes(inkey->y);
 	crypto_bignum_bn2bin(inkey->y, outkey->xy.data + 2 * size_sec - y_size);
 
-	cache_operation(TEE_CACHECLEAN, outkey->xy.data, outkey->xy.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->xy.data, outkey->xy.length);
 
 	return CAAM_NO_ERROR;
 }
@@ -106,7 +106,7 @@ static enum caam_status do_keypair_conv(struct caam_ecc_keypair *outkey,
 	d_size = crypto_bignum_num_bytes(inkey->d);
 	crypto_bignum_bn2bin(inkey->d, outkey->d.data + size_sec - d_size);
 
-	cache_operation(TEE_CACHECLEAN, outkey->d.data, outkey->d.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->d.data, outkey->d.length);
 
 	return CAAM_NO_ERROR;
 }
@@ -286,11 +286,11 @@ static TEE_Result do_gen_keypair(struct ecc_keypair *key, size_t key_size)
 	ECC_DUMPDESC(desc);
 
 	jobctx.desc = desc;
-	cache_operation(TEE_CACHEFLUSH, d.data, d.length);
+	caam_cache_op(TEE_CACHEFLUSH, d.data, d.length);
 	retstatus = caam_jr_enqueue(&jobctx, NULL);
 
 	if (retstatus == CAAM_NO_ERROR) {
-		cache_operation(TEE_CACHEINVALIDATE, d.data, d.length);
+		caam_cache_op(TEE_CACHEINVALIDATE, d.data, d.length);
 
 		/* Copy all keypair parameters */
 		ret = crypto_bignum_bin2bn(d.data, key_size / 8, key->d);
@@ -588,7 +588,7 @@ static TEE_Result do_verify(struct drvcrypt_sign_data *sdata)
 
 	jobctx.desc = desc;
 
-	cache_operation(TEE_CACHEFLUSH, tmp.data, tmp.length);
+	caam_cache_op(TEE_CACHEFLUSH, tmp.data, tmp.length);
 	retstatus = caam_jr_enqueue(&jobctx, NULL);
 
 	if (retstatus == CAAM_JOB_STATUS && !jobctx.status) {
@@ -491,7 +491,7 @@ static void do_desc_prime_p(uint32_t *desc, struct prime_dsa *prime,
 	 * Ensure descriptor is pushed in physical memory because it's
 	 * called from another descriptor.
 	 */
-	cache_operation(TEE_CACHECLEAN, desc, DESC_SZBYTES(PRIME_DESC_ENTRIES));
+	caam_cache_op(TEE_CACHECLEAN, desc, DESC_SZBYTES(PRIME_DESC_ENTRIES));
 }
 
 /*
@@ -504,7 +504,7 @@ static enum caam_status run_prime_q(uint32_t *desc, struct prime_dsa *prime)
 	enum caam_status retstatus = CAAM_FAILURE;
 	struct caam_jobctx jobctx = {};
 
-	cache_operation(TEE_CACHEFLUSH, prime->q->data, prime->q->length);
+	caam_cache_op(TEE_CACHEFLUSH, prime->q->data, prime->q->length);
 
 	jobctx.desc = desc;
 	retstatus = caam_jr_enqueue(&jobctx, NULL);
@@ -514,8 +514,8 @@ static enum caam_status run_prime_q(uint32_t *desc, struct prime_dsa *prime)
 			  jobctx.status, retstatus);
 		retstatus = CAAM_FAILURE;
 	} else {
-		cache_operation(TEE_CACHEINVALIDATE, prime->q->data,
-				prime->q->length);
+		caam_cache_op(TEE_CACHEINVALIDATE, prime->q->data,
+			      prime->q->length);
 		DSA_DUMPBUF("Prime Q", prime->q->data, prime->q->length);
 	}
 
@@ -534,7 +534,7 @@ static enum caam_status run_prime_p(uint32_t *desc, struct prime_dsa *prime)
 	struct caam_jobctx jobctx = {};
 	size_t counter = 0;
 
-	cache_operation(TEE_CACHEFLUSH, prime->p->data, prime->p->length);
+	caam_cache_op(TEE_CACHEFLUSH, prime->p->data, prime->p->length);
 
 	jobctx.desc = desc;
 	for (counter = 0; counter < 4 * prime->p->length * 8; counter++) {
@@ -542,8 +542,8 @@ static enum caam_status run_prime_p(uint32_t *desc, struct prime_dsa *prime)
 
 		if (retstatus == CAAM_NO_ERROR) {
 			DSA_TRACE("Prime P try: counter=%zu", counter);
-			cache_operation(TEE_CACHEINVALIDATE, prime->p->data,
-					prime->p->length);
+			caam_cache_op(TEE_CACHEINVALIDATE, prime->p->data,
+				      prime->p->length);
 			DSA_DUMPBUF("Prime P", prime->p->data,
 				    prime->p->length);
 
@@ -649,7 +649,7 @@ static enum caam_status do_generator(uint32_t *desc, struct prime_dsa *prime,
 
 	DSA_DUMPDESC(desc);
 
-	cache_operation(TEE_CACHEFLUSH, prime->g->data, prime->g->length);
+	caam_cache_op(TEE_CACHEFLUSH, prime->g->data, prime->g->length);
 
 	jobctx.desc = desc;
 	retstatus = caam_jr_enqueue(&jobctx, NULL);
@@ -660,7 +660,7 @@ static enum caam_status do_generator(uint32_t *desc, struct prime_dsa *prime,
 		return CAAM_FAILURE;
 	}
 
-	cache_operation(TEE_CACHEINVALIDATE, prime->g->data, prime->g->length);
+	caam_cache_op(TEE_CACHEINVALIDATE, prime->g->data, prime->g->length);
 	DSA_DUMPBUF("Generator G", prime->g->data, prime->g->length);
 	return CAAM_NO_ERROR;
 }
@@ -693,7 +693,7 @@ enum caam_status caam_prime_dsa_gen(struct prime_dsa *data)
 		goto end_gen_prime;
 
 	memset(mod_n.data, 0xFF, mod_n.length);
-	cache_operation(TEE_CACHECLEAN, mod_n.data, mod_n.length);
+	caam_cache_op(TEE_CACHECLEAN, mod_n.data, mod_n.length);
 
 	retstatus = caam_calloc_align_buf(&seed, data->q->length);
 	if (retstatus != CAAM_NO_ERROR)
@@ -721,9 +721,9 @@ enum caam_status caam_prime_dsa_gen(struct prime_dsa *data)
 		      virt_to_phys(desc_p));
 	do_desc_prime_p(desc_p, data, &x, &mod_n);
 
-	cache_operation(TEE_CACHEFLUSH, data->p->data, data->p->length);
-	cache_operation(TEE_CACHEFLUSH, seed.data, seed.length);
-	cache_operation(TEE_CACHEFLUSH, x.data, x.length);
+	caam_cache_op(TEE_CACHEFLUSH, data->p->data, data->p->length);
+	caam_cache_op(TEE_CACHEFLUSH, seed.data, seed.length);
+	caam_cache_op(TEE_CACHEFLUSH, x.data, x.length);
 
 	for (; nb_tries > 0; nb_tries--) {
 		retstatus = run_prime_q(desc_q, data);
@@ -467,7 +467,7 @@ static enum caam_status do_desc_setup(uint32_t *desc, struct prime_rsa *data,
 	caam_desc_add_ptr(desc, desc_prime);
 
 	RSA_DUMPDESC(desc);
-	cache_operation(TEE_CACHECLEAN, (void *)sqrt_value, data->p->length);
+	caam_cache_op(TEE_CACHECLEAN, (void *)sqrt_value, data->p->length);
 
 	return CAAM_NO_ERROR;
 }
@@ -775,7 +775,7 @@ enum caam_status caam_prime_rsa_gen(struct prime_rsa *data)
 
 		/* Set the max_n with 0xFFF... to operate the check P and Q */
 		memset(max_n.data, UINT8_MAX, max_n.length);
-		cache_operation(TEE_CACHECLEAN, max_n.data, max_n.length);
+		caam_cache_op(TEE_CACHECLEAN, max_n.data, max_n.length);
 	} else {
 		size_all_descs = SETUP_RSA_DESC_ENTRIES + GEN_RSA_DESC_ENTRIES;
 	}
@@ -829,17 +829,17 @@ enum caam_status caam_prime_rsa_gen(struct prime_rsa *data)
 		do_desc_prime(desc_p, data, &small_prime, false, 0);
 	}
 
-	cache_operation(TEE_CACHECLEAN, small_prime.data, data->p->length);
-	cache_operation(TEE_CACHECLEAN, data->e->data, data->e->length);
-	cache_operation(TEE_CACHEFLUSH, data->p->data, data->p->length);
+	caam_cache_op(TEE_CACHECLEAN, small_prime.data, data->p->length);
+	caam_cache_op(TEE_CACHECLEAN, data->e->data, data->e->length);
+	caam_cache_op(TEE_CACHEFLUSH, data->p->data, data->p->length);
 
 	if (data->q)
-		cache_operation(TEE_CACHEFLUSH, data->q->data, data->q->length);
+		caam_cache_op(TEE_CACHEFLUSH, data->q->data, data->q->length);
 
 	jobctx.desc = all_descs;
 
-	cache_operation(TEE_CACHECLEAN, (void *)all_descs,
-			DESC_SZBYTES(size_all_descs));
+	caam_cache_op(TEE_CACHECLEAN, (void *)all_descs,
+		      DESC_SZBYTES(size_all_descs));
 
 	retstatus = caam_jr_enqueue(&jobctx, NULL);
 
@@ -851,10 +851,10 @@ enum caam_status caam_prime_rsa_gen(struct prime_rsa *data)
 		RSA_TRACE("Check Prime Q Status 0x%08" PRIx32, jobctx.status);
 
 		if (JRSTA_GET_HALT_USER(jobctx.status) == STATUS_GOOD_Q) {
-			cache_operation(TEE_CACHEINVALIDATE, data->p->data,
-					data->p->length);
-			cache_operation(TEE_CACHEINVALIDATE, data->q->data,
-					data->q->length);
+			caam_cache_op(TEE_CACHEINVALIDATE, data->p->data,
+				      data->p->length);
+			caam_cache_op(TEE_CACHEINVALIDATE, data->q->data,
+				      data->q->length);
 
 			RSA_DUMPBUF("Prime P", data->p->data, data->p->length);
 			RSA_DUMPBUF("Prime Q", data->q->data, data->q->length);
@@ -863,8 +863,8 @@ enum caam_status caam_prime_rsa_gen(struct prime_rsa *data)
 		}
 	} else if (retstatus == CAAM_NO_ERROR && !data->q) {
 		/* Ensure Prime value is correct */
-		cache_operation(TEE_CACHEINVALIDATE, data->p->data,
-				data->p->length);
+		caam_cache_op(TEE_CACHEINVALIDATE, data->p->data,
+			      data->p->length);
 
 		RSA_DUMPBUF("Prime", data->p->data, data->p->length);
 
@@ -134,7 +134,7 @@ static enum caam_status do_keypub_conv(struct caam_rsa_keypair *outkey,
 		goto exit_conv;
 
 	crypto_bignum_bn2bin(inkey->e, outkey->e.data);
-	cache_operation(TEE_CACHECLEAN, outkey->e.data, outkey->e.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->e.data, outkey->e.length);
 
 	retstatus = caam_calloc_align_buf(&outkey->n,
 					  crypto_bignum_num_bytes(inkey->n));
@@ -142,7 +142,7 @@ static enum caam_status do_keypub_conv(struct caam_rsa_keypair *outkey,
 		goto exit_conv;
 
 	crypto_bignum_bn2bin(inkey->n, outkey->n.data);
-	cache_operation(TEE_CACHECLEAN, outkey->n.data, outkey->n.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->n.data, outkey->n.length);
 
 	return CAAM_NO_ERROR;
 
@@ -185,7 +185,7 @@ static enum caam_status do_keypair_conv(struct caam_rsa_keypair *outkey,
 		goto exit_conv;
 
 	crypto_bignum_bn2bin(inkey->n, outkey->n.data);
-	cache_operation(TEE_CACHECLEAN, outkey->n.data, outkey->n.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->n.data, outkey->n.length);
 
 	retstatus = caam_calloc_align_buf(&outkey->d,
 					  crypto_bignum_num_bytes(inkey->d));
@@ -193,7 +193,7 @@ static enum caam_status do_keypair_conv(struct caam_rsa_keypair *outkey,
 		goto exit_conv;
 
 	crypto_bignum_bn2bin(inkey->d, outkey->d.data);
-	cache_operation(TEE_CACHECLEAN, outkey->d.data, outkey->d.length);
+	caam_cache_op(TEE_CACHECLEAN, outkey->d.data, outkey->d.length);
 
 	outkey->format = 1;
 
@@ -223,8 +223,8 @@ static enum caam_status do_keypair_conv(struct caam_rsa_keypair *outkey,
 		crypto_bignum_bn2bin(inkey->q, outkey->q.data);
 
 		/* Push fields value to the physical memory */
-		cache_operation(TEE_CACHECLEAN, outkey->p.data,
-				size_p + size_q);
+		caam_cache_op(TEE_CACHECLEAN, outkey->p.data,
+			      size_p + size_q);
 
 		outkey->format = 2;
 #if (RSA_PRIVATE_KEY_FORMAT > 2)
@@ -295,9 +295,9 @@ static enum caam_status do_keypair_conv(struct caam_rsa_keypair *outkey,
 					     size_qp);
 
 			/* Push fields value to the physical memory */
-			cache_operation(TEE_CACHECLEAN, outkey->dp.data,
-					outkey->dp.length + outkey->dq.length +
-						outkey->qp.length);
+			caam_cache_op(TEE_CACHECLEAN, outkey->dp.data,
+				      outkey->dp.length + outkey->dq.length +
+				      outkey->qp.length);
 
 			outkey->format = 3;
 		}
@@ -562,18 +562,18 @@ static TEE_Result do_gen_keypair(struct rsa_keypair *key, size_t key_size)
 	jobctx.desc = desc;
 	RSA_DUMPDESC(desc);
 
-	cache_operation(TEE_CACHECLEAN, e.data, e.length);
-	cache_operation(TEE_CACHEFLUSH, p.data, p.length + q.length);
-	cache_operation(TEE_CACHEFLUSH, d_n.data, size_d + size_n);
+	caam_cache_op(TEE_CACHECLEAN, e.data, e.length);
+	caam_cache_op(TEE_CACHEFLUSH, p.data, p.length + q.length);
+	caam_cache_op(TEE_CACHEFLUSH, d_n.data, size_d + size_n);
 #if (RSA_PRIVATE_KEY_FORMAT > 2)
-	cache_operation(TEE_CACHEFLUSH, dp.data,
-			dp.length + dq.length + qp.length);
+	caam_cache_op(TEE_CACHEFLUSH, dp.data,
+		      dp.length + dq.length + qp.length);
 #endif /* RSA_PRIVATE_KEY_FORMAT > 2 */
 
 	retstatus = caam_jr_enqueue(&jobctx, NULL);
 
 	if (retstatus == CAAM_NO_ERROR) {
-		cache_operation(TEE_CACHEINVALIDATE, d_n.data, size_d + size_n);
+		caam_cache_op(TEE_CACHEINVALIDATE, d_n.data, size_d + size_n);
 
 		size_d_gen = d_n.data[0] + (d_n.data[1] << 8);
 
@@ -591,8 +591,8 @@ static TEE_Result do_gen_keypair(struct rsa_keypair *key, size_t key_size)
 			goto exit_gen_keypair;
 
 #if (RSA_PRIVATE_KEY_FORMAT > 1)
-		cache_operation(TEE_CACHEINVALIDATE, p.data,
-				p.length + q.length);
+		caam_cache_op(TEE_CACHEINVALIDATE, p.data,
+			      p.length + q.length);
 
 		ret = crypto_bignum_bin2bn(p.data, p.length, key->p);
 		if (ret != TEE_SUCCESS)
@@ -603,8 +603,8 @@ static TEE_Result do_gen_keypair(struct rsa_keypair *key, size_t key_size)
 			goto exit_gen_keypair;
 
 #if (RSA_PRIVATE_KEY_FORMAT > 2)
-		cache_operation(TEE_CACHEINVALIDATE, dp.data,
-				dp.length + dq.length + qp.length);
+		caam_cache_op(TEE_CACHEINVALIDATE, dp.data,
+			      dp.length + dq.length + qp.length);
 
 		RSA_DUMPBUF("dp", dp.data, dp.length);
 		RSA_DUMPBUF("dq", dq.data, dq.length);
@@ -1252,7 +1252,7 @@ static TEE_Result do_caam_decrypt(struct drvcrypt_rsa_ed *rsa_data,
 		if (retstatus != CAAM_NO_ERROR)
 			goto exit_decrypt;
 
-		cache_operation(TEE_CACHEFLUSH, size_msg.data, size_msg.length);
+		caam_cache_op(TEE_CACHEFLUSH, size_msg.data, size_msg.length);
 	}
 
 	/* Prepare the input cipher CAAM descriptor entry */
@@ -1294,7 +1294,7 @@ static TEE_Result do_caam_decrypt(struct drvcrypt_rsa_ed *rsa_data,
 			goto exit_decrypt;
 		}
 
-		cache_operation(TEE_CACHEFLUSH, tmp.data, tmp.length);
+		caam_cache_op(TEE_CACHEFLUSH, tmp.data, tmp.length);
 		break;
 #endif /* RSA_PRIVATE_KEY_FORMAT > 1 */
 
@@ -1399,8 +1399,8 @@ static TEE_Result do_caam_decrypt(struct drvcrypt_rsa_ed *rsa_data,
 			caam_dmaobj_copy_ltrim_to_orig(&msg);
 		} else if (operation == RSA_DECRYPT(PKCS_V1_5)) {
 			/* PKCS 1 v1.5 */
-			cache_operation(TEE_CACHEINVALIDATE, size_msg.data,
-					size_msg.length);
+			caam_cache_op(TEE_CACHEINVALIDATE, size_msg.data,
+				      size_msg.length);
 
 			msg.orig.length = caam_read_val32(size_msg.data);
 			caam_dmaobj_copy_to_orig(&msg);
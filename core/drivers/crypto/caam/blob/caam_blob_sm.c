@@ -122,8 +122,8 @@ TEE_Result caam_blob_sm_encapsulate(struct crypto_blob *blob,
 
 	BLOB_DUMPDESC(desc);
 
-	cache_operation(TEE_CACHECLEAN, blob->payload.data,
-			blob->payload.length);
+	caam_cache_op(TEE_CACHECLEAN, blob->payload.data,
+		      blob->payload.length);
 
 	jobctx.desc = desc;
 	retstatus = caam_jr_enqueue(&jobctx, NULL);
@@ -100,15 +100,15 @@ static TEE_Result caam_master_key_verif(struct caambuf *outkey)
 
 	BLOB_DUMPDESC(desc);
 
-	cache_operation(TEE_CACHECLEAN, keymod_buf, BLOB_KEY_MODIFIER_SIZE);
-	cache_operation(TEE_CACHEFLUSH, outkey->data, outkey->length);
+	caam_cache_op(TEE_CACHECLEAN, keymod_buf, BLOB_KEY_MODIFIER_SIZE);
+	caam_cache_op(TEE_CACHEFLUSH, outkey->data, outkey->length);
 
 	jobctx.desc = desc;
 	retstatus = caam_jr_enqueue(&jobctx, NULL);
 
 	if (retstatus == CAAM_NO_ERROR) {
-		cache_operation(TEE_CACHEINVALIDATE, outkey->data,
-				outkey->length);
+		caam_cache_op(TEE_CACHEINVALIDATE, outkey->data,
+			      outkey->length);
 		BLOB_DUMPBUF("Master Key", outkey->data, outkey->length);
 
 		ret = TEE_SUCCESS;
@@ -60,6 +60,7 @@ struct jr_privdata {
 	/* Caller Information Variables */
 	struct caller_info *callers;    /* Job Ring Caller information */
 	unsigned int callers_lock;      /* Job Ring Caller spin lock */
+	uint32_t done_ids;              /* Completed jobs not yet reported */
 
 	struct itr_handler it_handler;  /* Interrupt handler */
 };
@@ -134,10 +135,10 @@ static enum caam_status do_jr_alloc(struct jr_privdata **privdata,
 	 * Ensure that allocated queue initialization is pushed to the physical
 	 * memory
 	 */
-	cache_operation(TEE_CACHEFLUSH, jr_priv->inrings,
-			nb_jobs * sizeof(struct caam_inring_entry));
-	cache_operation(TEE_CACHEFLUSH, jr_priv->outrings,
-			nb_jobs * sizeof(struct caam_outring_entry));
+	caam_cache_op(TEE_CACHEFLUSH, jr_priv->inrings,
+		      nb_jobs * sizeof(struct caam_inring_entry));
+	caam_cache_op(TEE_CACHEFLUSH, jr_priv->outrings,
+		      nb_jobs * sizeof(struct caam_outring_entry));
 
 	retstatus = CAAM_NO_ERROR;
 end_alloc:
@@ -149,6 +150,8 @@ end_alloc:
 	return retstatus;
 }
 
+static uint32_t do_jr_dequeue(uint32_t wait_job_ids);
+
 /*
  * Job Ring Interrupt handler
  *
@@ -156,8 +159,21 @@ end_alloc:
  */
 static enum itr_return caam_jr_irqhandler(struct itr_handler *handler)
 {
+#ifdef CFG_NXP_CAAM_JR_ASYNC
+	struct jr_privdata *jr_priv = handler->data;
+
+	/*
+	 * Acknowledge the interrupt before dequeuing so that a job
+	 * completing meanwhile raises a new interrupt. Then execute the
+	 * callbacks of all completed jobs, the job IDs are reported
+	 * later to caam_jr_dequeue()
+	 */
+	caam_hal_jr_check_ack_itr(jr_priv->baseaddr);
+	do_jr_dequeue(0);
+#else
 	JR_TRACE("Disable the interrupt");
 	itr_disable(handler->it);
+#endif
 
 	/* Send a signal to exit WFE loop */
 	sev();
@@ -165,12 +181,31 @@ static enum itr_return caam_jr_irqhandler(struct itr_handler *handler)
 	return ITRR_HANDLED;
 }
 
+/*
+ * Returns the jobs of the @wait_job_ids mask completed since last call and
+ * forget them.
+ *
+ * @wait_job_ids  Expected Jobs to be complete
+ */
+static uint32_t do_jr_get_done(uint32_t wait_job_ids)
+{
+	uint32_t ret_job_id = 0;
+
+	cpu_spin_lock(&jr_privdata->callers_lock);
+	ret_job_id = jr_privdata->done_ids & wait_job_ids;
+	jr_privdata->done_ids &= ~ret_job_id;
+	cpu_spin_unlock(&jr_privdata->callers_lock);
+
+	return ret_job_id;
+}
+
 /*
  * Returns all jobs completed depending on the input @wait_job_ids mask.
  *
  * Dequeues all Jobs completed. Call the job context callback
  * function. Function returns the bit mask of the expected completed job
- * (@wait_job_ids parameter)
+ * (@wait_job_ids parameter) including the ones dequeued before by the
+ * interrupt handler.
  *
  * @wait_job_ids  Expected Jobs to be complete
  */
@@ -191,6 +226,7 @@ static uint32_t do_jr_dequeue(uint32_t wait_job_ids)
 	nb_jobs_done = caam_hal_jr_get_nbjob_done(jr_privdata->baseaddr);
 
 	if (nb_jobs_done == 0) {
+		ret_job_id = do_jr_get_done(wait_job_ids);
 		cpu_spin_unlock_xrestore(&jr_privdata->outlock, exceptions);
 		return ret_job_id;
 	}
@@ -210,8 +246,8 @@ static uint32_t do_jr_dequeue(uint32_t wait_job_ids)
 		nb_jobs_inv = nb_jobs_done;
 	}
 
-	cache_operation(TEE_CACHEINVALIDATE, jr_out,
-			sizeof(struct caam_outring_entry) * nb_jobs_inv);
+	caam_cache_op(TEE_CACHEINVALIDATE, jr_out,
+		      sizeof(struct caam_outring_entry) * nb_jobs_inv);
 
 	for (; nb_jobs_done; nb_jobs_done--) {
 		jr_out = &jr_privdata->outrings[jr_privdata->outread_index];
@@ -235,9 +271,8 @@ static uint32_t do_jr_dequeue(uint32_t wait_job_ids)
 				jobctx = caller->jobctx;
 				jobctx->status = caam_read_jobstatus(jr_out);
 
-				/* Update return Job IDs mask */
-				if (caller->job_id & wait_job_ids)
-					ret_job_id |= caller->job_id;
+				/* Update completed Job IDs mask */
+				jr_privdata->done_ids |= caller->job_id;
 
 				JR_TRACE("JR id=%" PRId32
 					 ", context @0x%08" PRIxVA,
@@ -273,6 +308,8 @@ static uint32_t do_jr_dequeue(uint32_t wait_job_ids)
 		}
 	}
 
+	ret_job_id = do_jr_get_done(wait_job_ids);
+
 	cpu_spin_unlock_xrestore(&jr_privdata->outlock, exceptions);
 
 	return ret_job_id;
@@ -331,6 +368,7 @@ static enum caam_status do_jr_enqueue(struct caam_jobctx *jobctx,
 			caller = &jr_privdata->callers[idx_jr];
 			caller->job_id = job_mask;
 			caller->jobctx = jobctx;
+			jr_privdata->done_ids &= ~job_mask;
 			caller->pdesc = virt_to_phys((void *)jobctx->desc);
 
 			found = true;
@@ -354,8 +392,8 @@ static enum caam_status do_jr_enqueue(struct caam_jobctx *jobctx,
 	caam_desc_push(cur_inrings, caller->pdesc);
 
 	/* Ensure that physical memory is up to date */
-	cache_operation(TEE_CACHECLEAN, cur_inrings,
-			sizeof(struct caam_inring_entry));
+	caam_cache_op(TEE_CACHECLEAN, cur_inrings,
+		      sizeof(struct caam_inring_entry));
 
 	/*
 	 * Increment index to next JR input entry taking care that
@@ -365,8 +403,8 @@ static enum caam_status do_jr_enqueue(struct caam_jobctx *jobctx,
 	jr_privdata->inwrite_index %= jr_privdata->nb_jobs;
 
 	/* Ensure that input descriptor is pushed in physical memory */
-	cache_operation(TEE_CACHECLEAN, jobctx->desc,
-			DESC_SZBYTES(caam_desc_get_len(jobctx->desc)));
+	caam_cache_op(TEE_CACHECLEAN, jobctx->desc,
+		      DESC_SZBYTES(caam_desc_get_len(jobctx->desc)));
 
 	/* Inform HW that a new JR is available */
 	caam_hal_jr_add_newjob(jr_privdata->baseaddr);
@@ -401,6 +439,7 @@ void caam_jr_cancel(uint32_t job_id)
 		 * the job_id mask.
 		 */
 		if (jr_privdata->callers[idx].job_id == job_id) {
+			jr_privdata->done_ids &= ~job_id;
 			/* Clear the Entry Descriptor */
 			jr_privdata->callers[idx].pdesc = 0;
 			jr_privdata->callers[idx].job_id = JR_JOB_FREE;
@@ -577,6 +616,10 @@ enum caam_status caam_jr_init(struct caam_jrcfg *jrcfg)
 	itr_add(&jr_privdata->it_handler);
 #endif
 	caam_hal_jr_enable_itr(jr_privdata->baseaddr);
+#if defined(CFG_NXP_CAAM_RUNTIME_JR) && defined(CFG_NXP_CAAM_JR_ASYNC)
+	/* Job completions are handled by the interrupt handler */
+	itr_enable(jr_privdata->it_handler.it);
+#endif
 #endif
 	retstatus = CAAM_NO_ERROR;
 
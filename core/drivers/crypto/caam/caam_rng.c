@@ -137,7 +137,7 @@ static void rng_data_done(struct caam_jobctx *jobctx)
 		atomic_store_u32(&rng->status, DATA_OK);
 
 		/* Invalidate the data buffer to ensure software gets it */
-		cache_operation(TEE_CACHEINVALIDATE, rng->data, rng->size);
+		caam_cache_op(TEE_CACHEINVALIDATE, rng->data, rng->size);
 	} else {
 		RNG_TRACE("RNG Data completion in error 0x%" PRIx32,
 			  jobctx->status);
@@ -189,7 +189,7 @@ static enum caam_status do_rng_start(struct rngdata *rng)
 	enum caam_status ret = CAAM_FAILURE;
 
 	/* Ensure that data buffer is visible from the HW */
-	cache_operation(TEE_CACHEFLUSH, rng->data, rng->size);
+	caam_cache_op(TEE_CACHEFLUSH, rng->data, rng->size);
 
 	rng->job_id = 0;
 	atomic_store_u32(&rng->status, DATA_EMPTY);
@@ -559,6 +559,11 @@ TEE_Result crypto_rng_read(void *buf, size_t blen)
 	return do_rng_read(buf, blen);
 }
 
+TEE_Result hw_get_random_bytes(void *buf, size_t len)
+{
+	return do_rng_read(buf, len);
+}
+
 uint8_t hw_get_random_byte(void)
 {
 	uint8_t data = 0;
@@ -22,6 +22,22 @@
  */
 #define MAX_CIPHER_BUFFER (8 * 1024)
 
+/*
+ * Max number of Cipher Buffers of a same operation queued in the Job Ring
+ * when the buffers don't depend on each other
+ */
+#define MAX_CIPHER_JOBS 4
+
+/*
+ * Cipher Buffer asynchronous job
+ */
+struct cipher_job {
+	struct caam_jobctx jobctx; /* Job Ring context */
+	struct caamdmaobj src;     /* Source data */
+	struct caamdmaobj dst;     /* Destination data */
+	uint32_t job_id;           /* Job ID if queued, 0 otherwise */
+};
+
 /* Local Function declaration */
 static TEE_Result do_update_streaming(struct drvcrypt_cipher_update *dupdate);
 static TEE_Result do_update_cipher(struct drvcrypt_cipher_update *dupdate);
@@ -157,7 +173,7 @@ static enum caam_status copy_ctx_data(struct caambuf *dst,
 	memcpy(dst->data, src->data, dst->length);
 
 	/* Push data to physical memory */
-	cache_operation(TEE_CACHEFLUSH, dst->data, dst->length);
+	caam_cache_op(TEE_CACHEFLUSH, dst->data, dst->length);
 
 	return CAAM_NO_ERROR;
 }
@@ -179,15 +195,21 @@ static enum caam_status do_check_keysize(const struct caamdefkey *def,
 	return CAAM_BAD_PARAM;
 }
 
-enum caam_status caam_cipher_block(struct cipherdata *ctx, bool savectx,
-				   uint8_t keyid, bool encrypt,
-				   struct caamdmaobj *src,
-				   struct caamdmaobj *dst)
+/*
+ * Builds the descriptor of a cipher operation
+ *
+ * @ctx      Cipher context
+ * @desc     [out] Descriptor to build
+ * @savectx  Save or not the context
+ * @keyid    Id of the key to be used during operation
+ * @encrypt  Encrypt or decrypt direction
+ * @src      Source data to encrypt/decrypt
+ * @dst      [out] Destination data encrypted/decrypted
+ */
+static void do_cipher_desc(struct cipherdata *ctx, uint32_t *desc,
+			   bool savectx, uint8_t keyid, bool encrypt,
+			   struct caamdmaobj *src, struct caamdmaobj *dst)
 {
-	enum caam_status retstatus = CAAM_FAILURE;
-	struct caam_jobctx jobctx = {};
-	uint32_t *desc = ctx->descriptor;
-
 	caam_desc_init(desc);
 	caam_desc_add_word(desc, DESC_HEADER(0));
 
@@ -240,11 +262,23 @@ enum caam_status caam_cipher_block(struct cipherdata *ctx, bool savectx,
 		}
 
 		/* Ensure Context register data are not in cache */
-		cache_operation(TEE_CACHEINVALIDATE, ctx->ctx.data,
-				ctx->ctx.length);
+		caam_cache_op(TEE_CACHEINVALIDATE, ctx->ctx.data,
+			      ctx->ctx.length);
 	}
 
 	CIPHER_DUMPDESC(desc);
+}
+
+enum caam_status caam_cipher_block(struct cipherdata *ctx, bool savectx,
+				   uint8_t keyid, bool encrypt,
+				   struct caamdmaobj *src,
+				   struct caamdmaobj *dst)
+{
+	enum caam_status retstatus = CAAM_FAILURE;
+	struct caam_jobctx jobctx = {};
+	uint32_t *desc = ctx->descriptor;
+
+	do_cipher_desc(ctx, desc, savectx, keyid, encrypt, src, dst);
 
 	jobctx.desc = desc;
 	retstatus = caam_jr_enqueue(&jobctx, NULL);
@@ -547,9 +581,9 @@ TEE_Result caam_cipher_initialize(struct drvcrypt_cipher_init *dinit)
 				       cipherdata->tweak.length);
 
 				/* Push data to physical memory */
-				cache_operation(TEE_CACHEFLUSH,
-						cipherdata->tweak.data,
-						cipherdata->tweak.length);
+				caam_cache_op(TEE_CACHEFLUSH,
+					      cipherdata->tweak.data,
+					      cipherdata->tweak.length);
 			}
 		}
 	}
@@ -619,8 +653,8 @@ static TEE_Result do_update_streaming(struct drvcrypt_cipher_update *dupdate)
 		if (ret)
 			goto end_streaming;
 
-		ret = caam_dmaobj_init_output(&indst, dupdate->dst.data,
-					      size_indone, size_indone);
+		ret = caam_dmaobj_init_output_direct(&indst, dupdate->dst.data,
+						     size_indone);
 		if (ret)
 			goto end_streaming;
 
@@ -727,6 +761,193 @@ end_streaming:
 	return ret;
 }
 
+/*
+ * Asynchronous Cipher Buffer job completion callback
+ *
+ * @jobctx   Job context
+ */
+static void cipher_job_done(struct caam_jobctx *jobctx)
+{
+	jobctx->completion = true;
+}
+
+/*
+ * Releases the DMA objects of a Cipher Buffer job
+ *
+ * @job      Cipher Buffer job
+ */
+static void release_cipher_job(struct cipher_job *job)
+{
+	caam_dmaobj_free(&job->src);
+	caam_dmaobj_free(&job->dst);
+	memset(&job->src, 0, sizeof(job->src));
+	memset(&job->dst, 0, sizeof(job->dst));
+	job->job_id = 0;
+}
+
+/*
+ * Queues the Cipher Buffer of @size bytes at @offset of the update data
+ * in the Job Ring.
+ *
+ * @dupdate  Data update object
+ * @job      Cipher Buffer job
+ * @offset   Offset of the Cipher Buffer
+ * @size     Size of the Cipher Buffer
+ */
+static enum caam_status queue_cipher_job(struct drvcrypt_cipher_update *dupdate,
+					 struct cipher_job *job, size_t offset,
+					 size_t size)
+{
+	enum caam_status retstatus = CAAM_FAILURE;
+	struct cipherdata *ctx = dupdate->ctx;
+
+	if (caam_dmaobj_init_input(&job->src, dupdate->src.data + offset,
+				   size))
+		goto err_queue;
+
+	if (caam_dmaobj_init_output_direct(&job->dst,
+					   dupdate->dst.data + offset, size))
+		goto err_queue;
+
+	do_cipher_desc(ctx, job->jobctx.desc, false, NEED_KEY1, ctx->encrypt,
+		       &job->src, &job->dst);
+
+	retstatus = caam_jr_enqueue(&job->jobctx, &job->job_id);
+	if (retstatus == CAAM_PENDING)
+		return CAAM_NO_ERROR;
+
+	CIPHER_TRACE("CAAM return 0x%08x", retstatus);
+	if (retstatus != CAAM_BUSY)
+		retstatus = CAAM_FAILURE;
+
+err_queue:
+	release_cipher_job(job);
+
+	return retstatus;
+}
+
+/*
+ * Waits until at least one of the queued Cipher Buffer jobs completes and
+ * releases all the completed ones.
+ * Returns CAAM_JOB_STATUS if one of them failed.
+ *
+ * @jobs     Cipher Buffer jobs
+ */
+static enum caam_status wait_cipher_jobs(struct cipher_job *jobs)
+{
+	enum caam_status retstatus = CAAM_NO_ERROR;
+	struct cipher_job *job = NULL;
+	uint32_t job_ids = 0;
+	unsigned int idx = 0;
+	bool done = false;
+
+	for (idx = 0; idx < MAX_CIPHER_JOBS; idx++)
+		job_ids |= jobs[idx].job_id;
+
+	if (!job_ids)
+		return CAAM_NO_ERROR;
+
+	/*
+	 * As for a synchronous job, don't use a timeout because there
+	 * is no HW timer and so the timeout is not precise
+	 */
+	while (!done) {
+		for (idx = 0; idx < MAX_CIPHER_JOBS; idx++) {
+			if (jobs[idx].job_id && jobs[idx].jobctx.completion)
+				done = true;
+		}
+
+		if (!done)
+			caam_jr_dequeue(job_ids, 100);
+	}
+
+	for (idx = 0; idx < MAX_CIPHER_JOBS; idx++) {
+		job = &jobs[idx];
+		if (!job->job_id || !job->jobctx.completion)
+			continue;
+
+		if (JRSTA_SRC_GET(job->jobctx.status) != JRSTA_SRC(NONE)) {
+			CIPHER_TRACE("CAAM Status 0x%08" PRIx32,
+				     job->jobctx.status);
+			retstatus = CAAM_JOB_STATUS;
+		} else {
+			caam_dmaobj_copy_to_orig(&job->dst);
+		}
+
+		release_cipher_job(job);
+	}
+
+	return retstatus;
+}
+
+/*
+ * Update of the cipher operation without CAAM Context Register (ECB mode).
+ * The Cipher Buffers don't depend on each other, hence up to
+ * MAX_CIPHER_JOBS of them are queued in the Job Ring at the same time.
+ *
+ * @dupdate  Data update object
+ */
+static TEE_Result do_update_cipher_jobs(struct drvcrypt_cipher_update *dupdate)
+{
+	TEE_Result ret = TEE_SUCCESS;
+	enum caam_status retstatus = CAAM_FAILURE;
+	struct cipher_job jobs[MAX_CIPHER_JOBS] = {};
+	struct cipher_job *job = NULL;
+	unsigned int nb_queued = 0;
+	unsigned int idx = 0;
+	size_t offset = 0;
+	size_t size = 0;
+
+	for (idx = 0; idx < MAX_CIPHER_JOBS; idx++) {
+		jobs[idx].jobctx.desc = caam_calloc_desc(MAX_DESC_ENTRIES);
+		if (!jobs[idx].jobctx.desc) {
+			CIPHER_TRACE("Allocation descriptor error");
+			ret = TEE_ERROR_OUT_OF_MEMORY;
+			goto end_jobs;
+		}
+
+		jobs[idx].jobctx.callback = cipher_job_done;
+	}
+
+	/*
+	 * Once an error occurred, don't queue new Cipher Buffers but
+	 * wait the completion of the ones queued before releasing them
+	 */
+	do {
+		nb_queued = 0;
+		for (idx = 0; idx < MAX_CIPHER_JOBS; idx++) {
+			job = &jobs[idx];
+			if (!job->job_id && !ret &&
+			    offset < dupdate->src.length) {
+				size = MIN(dupdate->src.length - offset,
+					   (size_t)MAX_CIPHER_BUFFER);
+				retstatus = queue_cipher_job(dupdate, job,
+							     offset, size);
+				if (retstatus == CAAM_NO_ERROR)
+					offset += size;
+				else if (retstatus != CAAM_BUSY)
+					ret = TEE_ERROR_GENERIC;
+			}
+
+			if (job->job_id)
+				nb_queued++;
+		}
+
+		/* Job Ring full and no job of this operation to wait */
+		if (!nb_queued && !ret && offset < dupdate->src.length)
+			ret = TEE_ERROR_BUSY;
+
+		if (wait_cipher_jobs(jobs) != CAAM_NO_ERROR)
+			ret = TEE_ERROR_GENERIC;
+	} while (nb_queued);
+
+end_jobs:
+	for (idx = 0; idx < MAX_CIPHER_JOBS; idx++)
+		caam_free_desc(&jobs[idx].jobctx.desc);
+
+	return ret;
+}
+
 /*
  * Update of the cipher operation with complete block except
  * if last block. Last block can be partial block.
@@ -757,6 +978,10 @@ static TEE_Result do_update_cipher(struct drvcrypt_cipher_update *dupdate)
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
 
+	/* Without context, queue the Cipher Buffers all together */
+	if (!ctx->alg->size_ctx && dupdate->src.length > MAX_CIPHER_BUFFER)
+		return do_update_cipher_jobs(dupdate);
+
 	nb_buf = dupdate->dst.length / MAX_CIPHER_BUFFER;
 	for (; nb_buf; nb_buf--) {
 		ret = caam_dmaobj_init_input(&src, dupdate->src.data + offset,
@@ -764,9 +989,9 @@ static TEE_Result do_update_cipher(struct drvcrypt_cipher_update *dupdate)
 		if (ret)
 			goto end_cipher;
 
-		ret = caam_dmaobj_init_output(&dst, dupdate->dst.data + offset,
-					      dupdate->dst.length - offset,
-					      MAX_CIPHER_BUFFER);
+		ret = caam_dmaobj_init_output_direct(&dst,
+						     dupdate->dst.data + offset,
+						     MAX_CIPHER_BUFFER);
 		if (ret)
 			goto end_cipher;
 
@@ -800,9 +1025,10 @@ static TEE_Result do_update_cipher(struct drvcrypt_cipher_update *dupdate)
 		if (ret)
 			goto end_cipher;
 
-		ret = caam_dmaobj_init_output(&dst, dupdate->dst.data + offset,
-					      dupdate->dst.length - offset,
-					      dupdate->dst.length - offset);
+		ret = caam_dmaobj_init_output_direct(&dst,
+						     dupdate->dst.data + offset,
+						     dupdate->src.length -
+							     offset);
 		if (ret)
 			goto end_cipher;
 
@@ -360,8 +360,8 @@ static TEE_Result run_cmac_desc(struct cipherdata *ctx, struct caamdmaobj *src,
 		caam_desc_add_word(desc, ctx->blockbuf.filled);
 
 		/* Clean the circular buffer data to be loaded */
-		cache_operation(TEE_CACHECLEAN, ctx->blockbuf.buf.data,
-				ctx->blockbuf.filled);
+		caam_cache_op(TEE_CACHECLEAN, ctx->blockbuf.buf.data,
+			      ctx->blockbuf.filled);
 	}
 
 	if (src) {
@@ -396,8 +396,8 @@ static TEE_Result run_cmac_desc(struct cipherdata *ctx, struct caamdmaobj *src,
 
 	/* Invalidate Context register */
 	if (ctx->ctx.length)
-		cache_operation(TEE_CACHEINVALIDATE, ctx->ctx.data,
-				ctx->ctx.length);
+		caam_cache_op(TEE_CACHEINVALIDATE, ctx->ctx.data,
+			      ctx->ctx.length);
 
 	jobctx.desc = desc;
 	retstatus = caam_jr_enqueue(&jobctx, NULL);
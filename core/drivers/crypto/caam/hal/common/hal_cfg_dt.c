@@ -34,11 +34,11 @@ static const char *dt_jr_match_table = {
 static paddr_t find_jr_offset(void *fdt, int status, int *find_node)
 {
 	paddr_t jr_offset = 0;
-	int node = fdt_node_offset_by_compatible(fdt, 0, dt_jr_match_table);
+	int node = dt_node_offset_by_compatible(fdt, 0, dt_jr_match_table);
 
 	for (; node != -FDT_ERR_NOTFOUND;
-	     node = fdt_node_offset_by_compatible(fdt, node,
-						  dt_jr_match_table)) {
+	     node = dt_node_offset_by_compatible(fdt, node,
+						 dt_jr_match_table)) {
 		HAL_TRACE("Found Job Ring node status @%" PRId32, node);
 		if (_fdt_get_status(fdt, node) == status) {
 			HAL_TRACE("Found Job Ring node @%" PRId32, node);
@@ -60,7 +60,7 @@ void caam_hal_cfg_get_ctrl_dt(void *fdt, vaddr_t *ctrl_base)
 
 	*ctrl_base = 0;
 	/* Get the CAAM Node to get the controller base address */
-	node = fdt_node_offset_by_compatible(fdt, 0, dt_caam_match_table);
+	node = dt_node_offset_by_compatible(fdt, 0, dt_caam_match_table);
 
 	if (node < 0)
 		return;
@@ -124,12 +124,12 @@ void caam_hal_cfg_get_jobring_dt(void *fdt, struct caam_jrcfg *jrcfg)
 void caam_hal_cfg_disable_jobring_dt(void *fdt, struct caam_jrcfg *jrcfg)
 {
 	if (IS_ENABLED(CFG_CAAM_JR_DISABLE_NODE)) {
-		int node = fdt_node_offset_by_compatible(fdt, 0,
-							 dt_jr_match_table);
+		int node = dt_node_offset_by_compatible(fdt, 0,
+							dt_jr_match_table);
 
 		for (; node != -FDT_ERR_NOTFOUND;
-		     node = fdt_node_offset_by_compatible(fdt, node,
-							  dt_jr_match_table)) {
+		     node = dt_node_offset_by_compatible(fdt, node,
+							 dt_jr_match_table)) {
 			HAL_TRACE("Found Job Ring node @%" PRId32, node);
 			if (_fdt_reg_base_address(fdt, node) == jrcfg->offset) {
 				HAL_TRACE("Disable Job Ring node @%" PRId32,
@@ -21,7 +21,7 @@ void caam_hal_sm_get_base_dt(void *fdt, vaddr_t *sm_base)
 
 	*sm_base = 0;
 
-	node = fdt_node_offset_by_compatible(fdt, 0, dt_sm_match_table);
+	node = dt_node_offset_by_compatible(fdt, 0, dt_sm_match_table);
 
 	if (node < 0) {
 		DMSG("CAAM Node not found err = 0x%X", node);
@@ -68,7 +68,7 @@ static void do_desc_load_key(uint32_t *desc, struct caambuf *key)
 	caam_desc_add_word(desc, LD_KEY_SPLIT(key->length));
 	caam_desc_add_ptr(desc, key->paddr);
 
-	cache_operation(TEE_CACHECLEAN, key->data, key->length);
+	caam_cache_op(TEE_CACHECLEAN, key->data, key->length);
 }
 
 /*
@@ -115,7 +115,7 @@ static enum caam_status do_allocate_intern(struct hashctx *ctx)
 
 	/* Initialize the block buffer */
 	ctx->blockbuf.filled = 0;
-	ctx->blockbuf.max = ctx->alg->size_block;
+	ctx->blockbuf.max = ctx->alg->size_block * CFG_NXP_CAAM_HASH_BUF_BLOCKS;
 
 	/* Allocate the CAAM Context register */
 	ret = caam_calloc_align_buf(&ctx->ctx, ctx->alg->size_ctx);
@@ -125,7 +125,7 @@ static enum caam_status do_allocate_intern(struct hashctx *ctx)
 		goto exit_alloc;
 	}
 
-	cache_operation(TEE_CACHEFLUSH, ctx->ctx.data, ctx->ctx.length);
+	caam_cache_op(TEE_CACHEFLUSH, ctx->ctx.data, ctx->ctx.length);
 
 	/* Ensure buffer length is 0 */
 	ctx->ctx.length = 0;
@@ -339,6 +339,28 @@ TEE_Result caam_hash_hmac_update(struct hashctx *ctx, const uint8_t *data,
 	HASH_TRACE("Update Type 0x%" PRIX32 " - Input @%p-%zu", alg_type, data,
 		   len);
 
+	/*
+	 * Each job reloads and saves the running context, small updates are
+	 * accumulated in the block buffer to be hashed in one job.
+	 */
+	if (ctx->blockbuf.filled + len <= ctx->blockbuf.max) {
+		struct caambuf srcdata = {
+			.data = (uint8_t *)data,
+			.length = len,
+		};
+
+		if (!len)
+			return TEE_SUCCESS;
+
+		if (caam_cpy_block_src(&ctx->blockbuf, &srcdata, 0) !=
+		    CAAM_NO_ERROR) {
+			ret = TEE_ERROR_OUT_OF_MEMORY;
+			goto exit_update;
+		}
+
+		return TEE_SUCCESS;
+	}
+
 	/* Calculate the total data to be handled */
 	fullsize = ctx->blockbuf.filled + len;
 	size_topost = fullsize % alg->size_block;
@@ -388,8 +410,8 @@ TEE_Result caam_hash_hmac_update(struct hashctx *ctx, const uint8_t *data,
 			caam_desc_add_word(desc, FIFO_LD(CLASS_2, MSG, NOACTION,
 							 ctx->blockbuf.filled));
 			caam_desc_add_ptr(desc, ctx->blockbuf.buf.paddr);
-			cache_operation(TEE_CACHECLEAN, ctx->blockbuf.buf.data,
-					ctx->blockbuf.filled);
+			caam_cache_op(TEE_CACHECLEAN, ctx->blockbuf.buf.data,
+				      ctx->blockbuf.filled);
 		}
 
 		caam_desc_fifo_load(desc, &src, CLASS_2, MSG, LAST_C2);
@@ -405,8 +427,8 @@ TEE_Result caam_hash_hmac_update(struct hashctx *ctx, const uint8_t *data,
 		HASH_DUMPDESC(desc);
 
 		/* Ensure Context register data are not in cache */
-		cache_operation(TEE_CACHEINVALIDATE, ctx->ctx.data,
-				ctx->ctx.length);
+		caam_cache_op(TEE_CACHEINVALIDATE, ctx->ctx.data,
+			      ctx->ctx.length);
 
 		jobctx.desc = desc;
 		retstatus = caam_jr_enqueue(&jobctx, NULL);
@@ -501,8 +523,8 @@ TEE_Result caam_hash_hmac_final(struct hashctx *ctx, uint8_t *digest,
 				   LD_NOIMM(CLASS_2, REG_CTX, ctx->ctx.length));
 		caam_desc_add_ptr(desc, ctx->ctx.paddr);
 
-		cache_operation(TEE_CACHEINVALIDATE, ctx->ctx.data,
-				ctx->ctx.length);
+		caam_cache_op(TEE_CACHEINVALIDATE, ctx->ctx.data,
+			      ctx->ctx.length);
 		HASH_DUMPBUF("CTX", ctx->ctx.data, ctx->ctx.length);
 		ctx->ctx.length = 0;
 	} else {
@@ -521,8 +543,8 @@ TEE_Result caam_hash_hmac_final(struct hashctx *ctx, uint8_t *digest,
 	caam_desc_add_ptr(desc, ctx->blockbuf.buf.paddr);
 	caam_desc_add_word(desc, ctx->blockbuf.filled);
 
-	cache_operation(TEE_CACHECLEAN, ctx->blockbuf.buf.data,
-			ctx->blockbuf.filled);
+	caam_cache_op(TEE_CACHECLEAN, ctx->blockbuf.buf.data,
+		      ctx->blockbuf.filled);
 
 	ctx->blockbuf.filled = 0;
 
@@ -571,7 +593,7 @@ void caam_hash_hmac_copy_state(struct hashctx *dst, struct hashctx *src)
 
 	memcpy(dst->ctx.data, src->ctx.data, src->ctx.length);
 	dst->ctx.length = src->ctx.length;
-	cache_operation(TEE_CACHECLEAN, dst->ctx.data, dst->ctx.length);
+	caam_cache_op(TEE_CACHECLEAN, dst->ctx.data, dst->ctx.length);
 
 	if (src->blockbuf.filled) {
 		struct caambuf srcdata = {
@@ -196,8 +196,8 @@ static TEE_Result do_hmac_init(struct crypto_mac_ctx *ctx, const uint8_t *inkey,
 	HASH_DUMPDESC(desc);
 
 	caam_dmaobj_cache_push(&reduce_key);
-	cache_operation(TEE_CACHEFLUSH, hmac_ctx->key.data,
-			hmac_ctx->key.length);
+	caam_cache_op(TEE_CACHEFLUSH, hmac_ctx->key.data,
+		      hmac_ctx->key.length);
 
 	jobctx.desc = desc;
 	retstatus = caam_jr_enqueue(&jobctx, NULL);
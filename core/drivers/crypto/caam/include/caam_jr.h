@@ -89,6 +89,10 @@ enum caam_status caam_jr_dequeue(uint32_t job_ids, unsigned int timeout_ms);
  * completion or if job is asynchrnous, returns immediately (if status
  * success, the output parameter job_id is filled with the Job Id pushed)
  *
+ * With CFG_NXP_CAAM_JR_ASYNC, the callback of an asynchronous job may be
+ * called from the Job Ring interrupt handler, it must not sleep.
+ * Returns CAAM_BUSY if all Job Ring entries are in use.
+ *
  * @jobctx  Reference to the job context
  * @job_id  [out] If pointer not NULL, job is asynchronous and parameter is
  *                the Job Id enqueued
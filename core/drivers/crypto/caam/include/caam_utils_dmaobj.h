@@ -26,6 +26,11 @@ struct caamdmaobj {
 	struct caambuf dmabuf;	  /* DMA buffer - original or reallocated */
 	struct caamsgtbuf sgtbuf; /* CAAM SGT or Buffer object */
 	unsigned int type;	  /* Encoded type of the object */
+
+	struct {
+		struct caambuf head; /* Bounce buffer of the unaligned start */
+		struct caambuf tail; /* Bounce buffer of the unaligned end */
+	} edges;
 };
 
 /*
@@ -58,6 +63,23 @@ TEE_Result caam_dmaobj_init_input(struct caamdmaobj *obj, const void *data,
 TEE_Result caam_dmaobj_init_output(struct caamdmaobj *obj, void *data,
 				   size_t length, size_t min_length);
 
+/*
+ * Initialize a CAAM DMA object of type output data of @length bytes
+ * written directly in the given @data buffer.
+ * Only the start and the end of @data not aligned on a cache line, hence
+ * sharing a cache line with other data, are replaced by bounce buffers in
+ * the CAAM SGT Object. The object buffer is the original @data buffer, it
+ * must not be derived.
+ * If @data is too small or not accessible by the CAAM DMA, fall back to
+ * caam_dmaobj_init_output().
+ *
+ * @obj     [out] CAAM DMA object initialized
+ * @data    Output data pointer
+ * @length  Length in bytes of the output data
+ */
+TEE_Result caam_dmaobj_init_output_direct(struct caamdmaobj *obj, void *data,
+					  size_t length);
+
 /*
  * Push the data to physical memory with a cache clean or flush depending
  * on the type of data, respectively input or output.
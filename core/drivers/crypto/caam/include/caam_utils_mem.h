@@ -10,6 +10,8 @@
 #define __CAAM_UTILS_MEM_H__
 
 #include <caam_common.h>
+#include <config.h>
+#include <tee/cache.h>
 
 /*
  * Allocate normal memory and initialize it to 0's.
@@ -127,11 +129,32 @@ enum caam_status caam_cpy_block_src(struct caamblock *block,
 int caam_mem_get_pa_area(struct caambuf *buf, struct caambuf **pabufs);
 
 /*
- * Return if the buffer @buf is cacheable or not
+ * Return the system cache line size in bytes
+ */
+uint32_t caam_mem_get_cacheline_size(void);
+
+/*
+ * Return if the buffer @buf needs cache maintenance around CAAM jobs, that
+ * is if it's cacheable and the CAAM DMA isn't coherent with the caches.
  *
  * @buf  Buffer address
  * @size Buffer size
  */
 bool caam_mem_is_cached_buf(void *buf, size_t size);
 
+/*
+ * Cache maintenance of a buffer accessed by the CAAM, nothing to do if
+ * the CAAM DMA is coherent with the caches.
+ *
+ * @op   Cache operation
+ * @va   Buffer address
+ * @len  Buffer length
+ */
+static inline void caam_cache_op(enum utee_cache_operation op, void *va,
+				 size_t len)
+{
+	if (!IS_ENABLED(CFG_CAAM_DMA_COHERENT))
+		cache_operation(op, va, len);
+}
+
 #endif /* __CAAM_UTILS_MEM_H__ */
@@ -64,7 +64,7 @@ static enum caam_status do_mppriv_gen(const char *passphrase, size_t len)
 	if (!paddr)
 		goto exit_mppriv;
 
-	cache_operation(TEE_CACHECLEAN, (void *)passphrase, len);
+	caam_cache_op(TEE_CACHECLEAN, (void *)passphrase, len);
 
 	/* Allocate the job descriptor */
 	desc = caam_calloc_desc(MP_PRIV_DESC_ENTRIES);
@@ -29,11 +29,13 @@
  *  - reallocated buffer accessible by the CAAM
  *  - SGT object created because buffer is not physical contiguous
  *  - derived object (not buffer reallocation)
+ *  - original buffer with bounce buffers for the unaligned edges
  */
 #define DMAOBJ_INPUT   BIT(0)
 #define DMAOBJ_OUTPUT  BIT(1)
 #define DMAOBJ_REALLOC BIT(2)
 #define DMAOBJ_DERIVED BIT(3)
+#define DMAOBJ_EDGES   BIT(4)
 
 /*
  * Apply the cache operation @op to the DMA Object (SGT or buffer)
@@ -47,8 +49,8 @@ static inline void dmaobj_cache_operation(enum utee_cache_operation op,
 	if (obj->sgtbuf.sgt_type)
 		caam_sgt_cache_op(op, &obj->sgtbuf);
 	else if (!obj->sgtbuf.buf->nocache)
-		cache_operation(op, obj->sgtbuf.buf->data,
-				obj->sgtbuf.buf->length);
+		caam_cache_op(op, obj->sgtbuf.buf->data,
+			      obj->sgtbuf.buf->length);
 }
 
 /*
@@ -236,6 +238,112 @@ end:
 	return caam_status_to_tee_result(retstatus);
 }
 
+TEE_Result caam_dmaobj_init_output_direct(struct caamdmaobj *obj, void *data,
+					  size_t length)
+{
+	enum caam_status retstatus = CAAM_FAILURE;
+	struct caambuf *pabufs = NULL;
+	struct caambuf *bufs = NULL;
+	struct caambuf middle = {};
+	uint32_t cacheline_size = 0;
+	vaddr_t start = (vaddr_t)data;
+	vaddr_t end = 0;
+	vaddr_t mid_start = 0;
+	vaddr_t mid_end = 0;
+	int nb_pa_area = 0;
+	int idx = 0;
+
+	DMAOBJ_TRACE("Initialize Direct Output object @%p of %zu bytes",
+		     data, length);
+
+	if (!obj || !data || !length)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Nothing to bounce if the buffer is not cacheable */
+	if (!caam_mem_is_cached_buf(data, length) ||
+	    ADD_OVERFLOW(start, length, &end))
+		return caam_dmaobj_init_output(obj, data, length, length);
+
+	cacheline_size = caam_mem_get_cacheline_size();
+	mid_start = ROUNDUP(start, cacheline_size);
+	mid_end = ROUNDDOWN(end, cacheline_size);
+
+	/*
+	 * If the buffer is aligned, there is no copy in the normal path.
+	 * If it doesn't cover a full cache line, it's cheaper to reallocate.
+	 */
+	if ((mid_start == start && mid_end == end) || mid_end <= mid_start)
+		return caam_dmaobj_init_output(obj, data, length, length);
+
+	middle.data = (uint8_t *)mid_start;
+	middle.length = mid_end - mid_start;
+	middle.paddr = virt_to_phys(middle.data);
+	if (!middle.paddr)
+		return caam_dmaobj_init_output(obj, data, length, length);
+
+	nb_pa_area = check_buffer_boundary(&pabufs, &middle);
+	if (nb_pa_area == -1)
+		return caam_dmaobj_init_output(obj, data, length, length);
+
+	if (mid_start != start) {
+		retstatus = caam_alloc_align_buf(&obj->edges.head,
+						 mid_start - start);
+		if (retstatus != CAAM_NO_ERROR)
+			goto end;
+	}
+
+	if (mid_end != end) {
+		retstatus = caam_alloc_align_buf(&obj->edges.tail,
+						 end - mid_end);
+		if (retstatus != CAAM_NO_ERROR)
+			goto end;
+	}
+
+	/* Physical areas of the SGT: head, original buffer and tail */
+	bufs = caam_calloc((nb_pa_area + 2) * sizeof(*bufs));
+	if (!bufs) {
+		retstatus = CAAM_OUT_MEMORY;
+		goto end;
+	}
+
+	if (obj->edges.head.data)
+		bufs[idx++] = obj->edges.head;
+
+	memcpy(&bufs[idx], pabufs, nb_pa_area * sizeof(*bufs));
+	idx += nb_pa_area;
+
+	if (obj->edges.tail.data)
+		bufs[idx++] = obj->edges.tail;
+
+	obj->type = DMAOBJ_OUTPUT | DMAOBJ_EDGES;
+
+	/* Save the original data info */
+	obj->orig.data = data;
+	obj->orig.length = length;
+
+	obj->dmabuf.data = data;
+	obj->dmabuf.length = length;
+	obj->dmabuf.paddr = virt_to_phys(data);
+
+	obj->sgtbuf.number = idx;
+
+	retstatus = caam_sgt_build_data(&obj->sgtbuf, &obj->dmabuf, bufs);
+
+end:
+	if (retstatus != CAAM_NO_ERROR) {
+		caam_free_buf(&obj->edges.head);
+		caam_free_buf(&obj->edges.tail);
+	}
+
+	caam_free(bufs);
+	caam_free(pabufs);
+
+	DMAOBJ_TRACE("Object returns 0x%" PRIx32 " -> 0x%" PRIx32, retstatus,
+		     caam_status_to_tee_result(retstatus));
+
+	return caam_status_to_tee_result(retstatus);
+}
+
 void caam_dmaobj_cache_push(struct caamdmaobj *obj)
 {
 	enum utee_cache_operation op = TEE_CACHECLEAN;
@@ -259,6 +367,17 @@ void caam_dmaobj_copy_to_orig(struct caamdmaobj *obj)
 			copy_size = MIN(obj->orig.length, obj->dmabuf.length);
 			memcpy(obj->orig.data, obj->dmabuf.data, copy_size);
 			obj->orig.length = copy_size;
+		} else if (obj->type & DMAOBJ_EDGES) {
+			/* Only the unaligned edges were bounced */
+			if (obj->edges.head.data)
+				memcpy(obj->orig.data, obj->edges.head.data,
+				       obj->edges.head.length);
+
+			copy_size = obj->edges.tail.length;
+			if (obj->edges.tail.data)
+				memcpy(obj->orig.data + obj->orig.length -
+					       copy_size,
+				       obj->edges.tail.data, copy_size);
 		}
 	}
 }
@@ -297,6 +416,11 @@ void caam_dmaobj_free(struct caamdmaobj *obj)
 		if (obj->type & DMAOBJ_REALLOC && !(obj->type & DMAOBJ_DERIVED))
 			caam_free_buf(&obj->dmabuf);
 
+		if (obj->type & DMAOBJ_EDGES && !(obj->type & DMAOBJ_DERIVED)) {
+			caam_free_buf(&obj->edges.head);
+			caam_free_buf(&obj->edges.tail);
+		}
+
 		caam_sgtbuf_free(&obj->sgtbuf);
 	}
 }
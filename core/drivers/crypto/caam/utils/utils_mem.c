@@ -323,11 +323,20 @@ void caam_free_buf(struct caambuf *buf)
 	}
 }
 
+uint32_t caam_mem_get_cacheline_size(void)
+{
+	return read_cacheline_size();
+}
+
 bool caam_mem_is_cached_buf(void *buf, size_t size)
 {
 	enum teecore_memtypes mtype = MEM_AREA_MAXTYPE;
 	bool is_cached = false;
 
+	/* The CAAM snoops the caches, buffers are used as they are */
+	if (IS_ENABLED(CFG_CAAM_DMA_COHERENT))
+		return false;
+
 	/*
 	 * First check if the buffer is a known memory area mapped
 	 * with a type listed in the teecore_memtypes enum.
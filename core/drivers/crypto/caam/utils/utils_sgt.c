@@ -22,8 +22,8 @@ void caam_sgt_cache_op(enum utee_cache_operation op, struct caamsgtbuf *insgt)
 {
 	unsigned int idx = 0;
 
-	cache_operation(TEE_CACHECLEAN, (void *)insgt->sgt,
-			insgt->number * sizeof(struct caamsgt));
+	caam_cache_op(TEE_CACHECLEAN, (void *)insgt->sgt,
+		      insgt->number * sizeof(struct caamsgt));
 
 	SGT_TRACE("SGT @%p %d entries", insgt, insgt->number);
 	for (idx = 0; idx < insgt->number; idx++) {
@@ -40,8 +40,8 @@ void caam_sgt_cache_op(enum utee_cache_operation op, struct caamsgtbuf *insgt)
 		}
 
 		if (!insgt->buf[idx].nocache)
-			cache_operation(op, (void *)insgt->buf[idx].data,
-					insgt->buf[idx].length);
+			caam_cache_op(op, (void *)insgt->buf[idx].data,
+				      insgt->buf[idx].length);
 	}
 }
 
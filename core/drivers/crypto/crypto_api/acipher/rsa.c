@@ -68,6 +68,11 @@ void crypto_acipher_free_rsa_public_key(struct rsa_public_key *key)
 	}
 }
 
+void crypto_acipher_clear_rsa_keypair_cache(struct rsa_keypair *key __unused)
+{
+	/* The HW drivers don't keep any derived key values */
+}
+
 TEE_Result crypto_acipher_gen_rsa_key(struct rsa_keypair *key, size_t size_bits)
 {
 	TEE_Result ret = TEE_ERROR_NOT_IMPLEMENTED;
@@ -0,0 +1,477 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ *
+ * Brief   Dispatch of the small hash and cipher operations to the software
+ *         implementation.
+ *
+ * Setting up a job for the crypto driver costs much more than processing a
+ * few blocks with the Cryptographic Extensions. An operation is done in
+ * software if the size of its first update is below the threshold of the
+ * algorithm, the state can't be moved afterwards so the whole operation
+ * stays on the implementation selected.
+ *
+ * The thresholds are taken from the configuration or calibrated after boot
+ * by timing both implementations. Until then the driver is always used.
+ */
+#include <arm.h>
+#include <assert.h>
+#include <crypto/crypto.h>
+#include <crypto/crypto_impl.h>
+#include <initcall.h>
+#include <malloc.h>
+#include <trace.h>
+#include <utee_defines.h>
+#include <util.h>
+
+/* Calibration from 16 bytes to CALIB_MAX_SIZE bytes, doubling the size */
+#define CALIB_MIN_SIZE	16
+#define CALIB_MAX_SIZE	4096
+#define CALIB_NUM_ITER	4
+
+struct dispatch_threshold {
+	uint32_t algo;
+	size_t size;
+};
+
+static struct dispatch_threshold hash_thresholds[] = {
+	{ .algo = TEE_ALG_SHA1 },
+	{ .algo = TEE_ALG_SHA224 },
+	{ .algo = TEE_ALG_SHA256 },
+	{ .algo = TEE_ALG_SHA384 },
+	{ .algo = TEE_ALG_SHA512 },
+};
+
+static struct dispatch_threshold cipher_thresholds[] = {
+	{ .algo = TEE_ALG_AES_ECB_NOPAD },
+	{ .algo = TEE_ALG_AES_CBC_NOPAD },
+	{ .algo = TEE_ALG_AES_CTR },
+};
+
+struct dispatch_hash {
+	struct crypto_hash_ctx hash_ctx;
+	struct crypto_hash_ctx *hw;
+	struct crypto_hash_ctx *sw;
+	struct crypto_hash_ctx *cur;
+	size_t threshold;
+};
+
+struct dispatch_cipher {
+	struct crypto_cipher_ctx cipher_ctx;
+	struct crypto_cipher_ctx *hw;
+	struct crypto_cipher_ctx *sw;
+	struct crypto_cipher_ctx *cur;
+	size_t threshold;
+};
+
+static const struct crypto_hash_ops dispatch_hash_ops;
+static const struct crypto_cipher_ops dispatch_cipher_ops;
+
+/*
+ * Returns the threshold of @algo in @table, 0 if not known
+ *
+ * @table  Table of thresholds
+ * @num    Number of entries in @table
+ * @algo   Algorithm
+ */
+static size_t get_threshold(struct dispatch_threshold *table, size_t num,
+			    uint32_t algo)
+{
+	size_t n = 0;
+
+	for (n = 0; n < num; n++)
+		if (table[n].algo == algo)
+			return __atomic_load_n(&table[n].size,
+					       __ATOMIC_RELAXED);
+
+	return 0;
+}
+
+static struct dispatch_hash *to_dispatch_hash(struct crypto_hash_ctx *ctx)
+{
+	assert(ctx && ctx->ops == &dispatch_hash_ops);
+
+	return container_of(ctx, struct dispatch_hash, hash_ctx);
+}
+
+static TEE_Result dispatch_hash_init(struct crypto_hash_ctx *ctx)
+{
+	struct dispatch_hash *d = to_dispatch_hash(ctx);
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	d->cur = NULL;
+	res = d->hw->ops->init(d->hw);
+	if (res)
+		return res;
+
+	return d->sw->ops->init(d->sw);
+}
+
+static TEE_Result dispatch_hash_update(struct crypto_hash_ctx *ctx,
+				       const uint8_t *data, size_t len)
+{
+	struct dispatch_hash *d = to_dispatch_hash(ctx);
+
+	if (!d->cur)
+		d->cur = len < d->threshold ? d->sw : d->hw;
+
+	return d->cur->ops->update(d->cur, data, len);
+}
+
+static TEE_Result dispatch_hash_final(struct crypto_hash_ctx *ctx,
+				      uint8_t *digest, size_t len)
+{
+	struct dispatch_hash *d = to_dispatch_hash(ctx);
+
+	/* Nothing hashed, there's no job worth starting */
+	if (!d->cur)
+		d->cur = d->sw;
+
+	return d->cur->ops->final(d->cur, digest, len);
+}
+
+static void dispatch_hash_free_ctx(struct crypto_hash_ctx *ctx)
+{
+	struct dispatch_hash *d = to_dispatch_hash(ctx);
+
+	d->hw->ops->free_ctx(d->hw);
+	d->sw->ops->free_ctx(d->sw);
+	free(d);
+}
+
+static void dispatch_hash_copy_state(struct crypto_hash_ctx *dst_ctx,
+				     struct crypto_hash_ctx *src_ctx)
+{
+	struct dispatch_hash *dst = to_dispatch_hash(dst_ctx);
+	struct dispatch_hash *src = to_dispatch_hash(src_ctx);
+
+	if (src->cur != src->sw)
+		src->hw->ops->copy_state(dst->hw, src->hw);
+	if (src->cur != src->hw)
+		src->sw->ops->copy_state(dst->sw, src->sw);
+
+	dst->cur = NULL;
+	if (src->cur)
+		dst->cur = src->cur == src->hw ? dst->hw : dst->sw;
+}
+
+static const struct crypto_hash_ops dispatch_hash_ops = {
+	.init = dispatch_hash_init,
+	.update = dispatch_hash_update,
+	.final = dispatch_hash_final,
+	.free_ctx = dispatch_hash_free_ctx,
+	.copy_state = dispatch_hash_copy_state,
+};
+
+TEE_Result drvcrypt_hash_dispatch_ctx(struct crypto_hash_ctx **ctx,
+				      uint32_t algo)
+{
+	struct crypto_hash_ctx *sw = NULL;
+	struct dispatch_hash *d = NULL;
+	size_t threshold = 0;
+
+	threshold = get_threshold(hash_thresholds, ARRAY_SIZE(hash_thresholds),
+				  algo);
+	if (!threshold)
+		return TEE_SUCCESS;
+
+	/* Without the software implementation, the driver does it all */
+	if (crypto_sw_hash_alloc_ctx(&sw, algo))
+		return TEE_SUCCESS;
+
+	d = calloc(1, sizeof(*d));
+	if (!d) {
+		sw->ops->free_ctx(sw);
+		return TEE_SUCCESS;
+	}
+
+	d->hash_ctx.ops = &dispatch_hash_ops;
+	d->hw = *ctx;
+	d->sw = sw;
+	d->threshold = threshold;
+	*ctx = &d->hash_ctx;
+
+	return TEE_SUCCESS;
+}
+
+static struct dispatch_cipher *
+to_dispatch_cipher(struct crypto_cipher_ctx *ctx)
+{
+	assert(ctx && ctx->ops == &dispatch_cipher_ops);
+
+	return container_of(ctx, struct dispatch_cipher, cipher_ctx);
+}
+
+static TEE_Result dispatch_cipher_init(struct crypto_cipher_ctx *ctx,
+				       TEE_OperationMode mode,
+				       const uint8_t *key1, size_t key1_len,
+				       const uint8_t *key2, size_t key2_len,
+				       const uint8_t *iv, size_t iv_len)
+{
+	struct dispatch_cipher *d = to_dispatch_cipher(ctx);
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	d->cur = NULL;
+	res = d->hw->ops->init(d->hw, mode, key1, key1_len, key2, key2_len,
+			       iv, iv_len);
+	if (res)
+		return res;
+
+	return d->sw->ops->init(d->sw, mode, key1, key1_len, key2, key2_len,
+				iv, iv_len);
+}
+
+static TEE_Result dispatch_cipher_update(struct crypto_cipher_ctx *ctx,
+					 bool last_block, const uint8_t *data,
+					 size_t len, uint8_t *dst)
+{
+	struct dispatch_cipher *d = to_dispatch_cipher(ctx);
+
+	if (!d->cur)
+		d->cur = len < d->threshold ? d->sw : d->hw;
+
+	return d->cur->ops->update(d->cur, last_block, data, len, dst);
+}
+
+static void dispatch_cipher_final(struct crypto_cipher_ctx *ctx)
+{
+	struct dispatch_cipher *d = to_dispatch_cipher(ctx);
+
+	d->hw->ops->final(d->hw);
+	d->sw->ops->final(d->sw);
+}
+
+static void dispatch_cipher_free_ctx(struct crypto_cipher_ctx *ctx)
+{
+	struct dispatch_cipher *d = to_dispatch_cipher(ctx);
+
+	d->hw->ops->free_ctx(d->hw);
+	d->sw->ops->free_ctx(d->sw);
+	free(d);
+}
+
+static void dispatch_cipher_copy_state(struct crypto_cipher_ctx *dst_ctx,
+				       struct crypto_cipher_ctx *src_ctx)
+{
+	struct dispatch_cipher *dst = to_dispatch_cipher(dst_ctx);
+	struct dispatch_cipher *src = to_dispatch_cipher(src_ctx);
+
+	if (src->cur != src->sw)
+		src->hw->ops->copy_state(dst->hw, src->hw);
+	if (src->cur != src->hw)
+		src->sw->ops->copy_state(dst->sw, src->sw);
+
+	dst->cur = NULL;
+	if (src->cur)
+		dst->cur = src->cur == src->hw ? dst->hw : dst->sw;
+}
+
+static const struct crypto_cipher_ops dispatch_cipher_ops = {
+	.init = dispatch_cipher_init,
+	.update = dispatch_cipher_update,
+	.final = dispatch_cipher_final,
+	.free_ctx = dispatch_cipher_free_ctx,
+	.copy_state = dispatch_cipher_copy_state,
+};
+
+TEE_Result drvcrypt_cipher_dispatch_ctx(struct crypto_cipher_ctx **ctx,
+					uint32_t algo)
+{
+	struct crypto_cipher_ctx *sw = NULL;
+	struct dispatch_cipher *d = NULL;
+	size_t threshold = 0;
+
+	threshold = get_threshold(cipher_thresholds,
+				  ARRAY_SIZE(cipher_thresholds), algo);
+	if (!threshold)
+		return TEE_SUCCESS;
+
+	/* Without the software implementation, the driver does it all */
+	if (crypto_sw_cipher_alloc_ctx(&sw, algo))
+		return TEE_SUCCESS;
+
+	d = calloc(1, sizeof(*d));
+	if (!d) {
+		sw->ops->free_ctx(sw);
+		return TEE_SUCCESS;
+	}
+
+	d->cipher_ctx.ops = &dispatch_cipher_ops;
+	d->hw = *ctx;
+	d->sw = sw;
+	d->threshold = threshold;
+	*ctx = &d->cipher_ctx;
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Returns the time in counter ticks taken by a hash of @len bytes of @buf
+ * with @ctx
+ *
+ * @ctx  Hash context
+ * @buf  Data to hash
+ * @len  Length of @buf
+ */
+static uint64_t time_hash(struct crypto_hash_ctx *ctx, uint8_t *buf,
+			  size_t len)
+{
+	uint8_t digest[TEE_MAX_HASH_SIZE] = { };
+	uint64_t t = read_cntpct();
+
+	if (ctx->ops->init(ctx) || ctx->ops->update(ctx, buf, len) ||
+	    ctx->ops->final(ctx, digest, sizeof(digest)))
+		return UINT64_MAX;
+
+	return read_cntpct() - t;
+}
+
+/*
+ * Returns the time in counter ticks taken by a cipher operation of @len
+ * bytes of @buf with @ctx
+ *
+ * @ctx  Cipher context
+ * @buf  Data to encrypt in place
+ * @len  Length of @buf
+ */
+static uint64_t time_cipher(struct crypto_cipher_ctx *ctx, uint8_t *buf,
+			    size_t len)
+{
+	static const uint8_t key[TEE_AES_BLOCK_SIZE];
+	static const uint8_t iv[TEE_AES_BLOCK_SIZE];
+	uint64_t t = read_cntpct();
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = ctx->ops->init(ctx, TEE_MODE_ENCRYPT, key, sizeof(key), NULL, 0,
+			     iv, sizeof(iv));
+	if (!res)
+		res = ctx->ops->update(ctx, true, buf, len, buf);
+	ctx->ops->final(ctx);
+	if (res)
+		return UINT64_MAX;
+
+	return read_cntpct() - t;
+}
+
+/*
+ * Returns the smallest size for which the driver is faster than the
+ * software, CALIB_MAX_SIZE if it's never the case
+ *
+ * @hw_hash    Driver hash context or NULL
+ * @sw_hash    Software hash context or NULL
+ * @hw_cipher  Driver cipher context or NULL
+ * @sw_cipher  Software cipher context or NULL
+ * @buf        Buffer of CALIB_MAX_SIZE bytes
+ */
+static size_t calibrate(struct crypto_hash_ctx *hw_hash,
+			struct crypto_hash_ctx *sw_hash,
+			struct crypto_cipher_ctx *hw_cipher,
+			struct crypto_cipher_ctx *sw_cipher, uint8_t *buf)
+{
+	uint64_t hw_total = 0;
+	uint64_t sw_total = 0;
+	uint64_t hw_time = 0;
+	uint64_t sw_time = 0;
+	size_t len = 0;
+	size_t n = 0;
+
+	for (len = CALIB_MIN_SIZE; len < CALIB_MAX_SIZE; len *= 2) {
+		hw_total = 0;
+		sw_total = 0;
+		/* The first iteration warms up the caches and is ignored */
+		for (n = 0; n <= CALIB_NUM_ITER; n++) {
+			if (hw_hash) {
+				hw_time = time_hash(hw_hash, buf, len);
+				sw_time = time_hash(sw_hash, buf, len);
+			} else {
+				hw_time = time_cipher(hw_cipher, buf, len);
+				sw_time = time_cipher(sw_cipher, buf, len);
+			}
+			if (hw_time == UINT64_MAX || sw_time == UINT64_MAX)
+				return 0;
+			if (n) {
+				hw_total += hw_time;
+				sw_total += sw_time;
+			}
+		}
+		if (hw_total < sw_total)
+			break;
+	}
+
+	return len;
+}
+
+static void calibrate_hash(struct dispatch_threshold *t, uint8_t *buf)
+{
+	struct crypto_hash_ctx *hw = NULL;
+	struct crypto_hash_ctx *sw = NULL;
+	size_t size = 0;
+
+	if (!drvcrypt_hash_alloc_ctx(&hw, t->algo) &&
+	    !crypto_sw_hash_alloc_ctx(&sw, t->algo))
+		size = calibrate(hw, sw, NULL, NULL, buf);
+
+	if (hw)
+		hw->ops->free_ctx(hw);
+	if (sw)
+		sw->ops->free_ctx(sw);
+
+	__atomic_store_n(&t->size, size, __ATOMIC_RELAXED);
+}
+
+static void calibrate_cipher(struct dispatch_threshold *t, uint8_t *buf)
+{
+	struct crypto_cipher_ctx *hw = NULL;
+	struct crypto_cipher_ctx *sw = NULL;
+	size_t size = 0;
+
+	if (!drvcrypt_cipher_alloc_ctx(&hw, t->algo) &&
+	    !crypto_sw_cipher_alloc_ctx(&sw, t->algo))
+		size = calibrate(NULL, NULL, hw, sw, buf);
+
+	if (hw)
+		hw->ops->free_ctx(hw);
+	if (sw)
+		sw->ops->free_ctx(sw);
+
+	__atomic_store_n(&t->size, size, __ATOMIC_RELAXED);
+}
+
+static TEE_Result dispatch_init(void)
+{
+	static const size_t hash_cfg = CFG_CRYPTO_DRV_HASH_SW_THRESHOLD;
+	static const size_t cipher_cfg = CFG_CRYPTO_DRV_CIPHER_SW_THRESHOLD;
+	uint8_t *buf = NULL;
+	size_t n = 0;
+
+	if (!hash_cfg || !cipher_cfg) {
+		buf = calloc(1, CALIB_MAX_SIZE);
+		if (!buf)
+			return TEE_ERROR_OUT_OF_MEMORY;
+	}
+
+	for (n = 0; n < ARRAY_SIZE(hash_thresholds); n++) {
+		if (hash_cfg)
+			__atomic_store_n(&hash_thresholds[n].size, hash_cfg,
+					 __ATOMIC_RELAXED);
+		else
+			calibrate_hash(hash_thresholds + n, buf);
+		DMSG("%#"PRIx32": software below %zu bytes",
+		     hash_thresholds[n].algo, hash_thresholds[n].size);
+	}
+
+	for (n = 0; n < ARRAY_SIZE(cipher_thresholds); n++) {
+		if (cipher_cfg)
+			__atomic_store_n(&cipher_thresholds[n].size,
+					 cipher_cfg, __ATOMIC_RELAXED);
+		else
+			calibrate_cipher(cipher_thresholds + n, buf);
+		DMSG("%#"PRIx32": software below %zu bytes",
+		     cipher_thresholds[n].algo, cipher_thresholds[n].size);
+	}
+
+	free(buf);
+
+	return TEE_SUCCESS;
+}
+driver_init_deferred(dispatch_init);
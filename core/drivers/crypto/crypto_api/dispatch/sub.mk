@@ -0,0 +1 @@
+srcs-y += dispatch.c
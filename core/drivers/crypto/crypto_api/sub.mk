@@ -7,3 +7,4 @@ subdirs-$(CFG_CRYPTO_DRV_CIPHER)  += cipher
 subdirs-$(CFG_CRYPTO_DRV_ACIPHER) += acipher
 subdirs-$(CFG_CRYPTO_DRV_ACIPHER) += oid
 subdirs-$(CFG_CRYPTO_DRV_MAC)     += mac
+subdirs-$(CFG_CRYPTO_DRV_SW_DISPATCH) += dispatch
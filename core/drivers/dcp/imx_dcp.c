@@ -948,8 +948,8 @@ static TEE_Result dcp_pbase(paddr_t *base)
 	}
 
 	for (i = 0; i < ARRAY_SIZE(dt_ctrl_match_table); i++) {
-		node = fdt_node_offset_by_compatible(fdt, 0,
-						     dt_ctrl_match_table[i]);
+		node = dt_node_offset_by_compatible(fdt, 0,
+						    dt_ctrl_match_table[i]);
 		if (node >= 0)
 			break;
 	}
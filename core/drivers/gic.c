@@ -64,6 +64,8 @@
 #define GIC_MAX_INTS		1020
 
 #define GICC_IAR_IT_ID_MASK	0x3ff
+/* Interrupt IDs from this one and above are special, 1023 is spurious */
+#define GICC_IAR_SPECIAL_ID	1020
 #define GICC_IAR_CPU_ID_MASK	0x7
 #define GICC_IAR_CPU_ID_SHIFT	10
 
@@ -236,21 +238,18 @@ static void gic_it_set_cpu_mask(struct gic_data *gd, size_t it,
 {
 	size_t idx __maybe_unused = it / NUM_INTS_PER_REG;
 	uint32_t mask __maybe_unused = 1 << (it % NUM_INTS_PER_REG);
-	uint32_t target, target_shift;
-	vaddr_t itargetsr = gd->gicd_base +
-			    GICD_ITARGETSR(it / NUM_TARGETS_PER_REG);
 
 	/* Assigned to group0 */
 	assert(!(io_read32(gd->gicd_base + GICD_IGROUPR(idx)) & mask));
 
-	/* Route it to selected CPUs */
-	target = io_read32(itargetsr);
-	target_shift = (it % NUM_TARGETS_PER_REG) * ITARGETSR_FIELD_BITS;
-	target &= ~(ITARGETSR_FIELD_MASK << target_shift);
-	target |= cpu_mask << target_shift;
-	DMSG("cpu_mask: writing 0x%x to 0x%" PRIxVA, target, itargetsr);
-	io_write32(itargetsr, target);
-	DMSG("cpu_mask: 0x%x", io_read32(itargetsr));
+	/*
+	 * Route it to selected CPUs, GICD_ITARGETSR is byte accessible so
+	 * there's no need to read-modify-write the register shared with
+	 * three other interrupts.
+	 */
+	DMSG("cpu_mask: writing 0x%x to 0x%" PRIxVA,
+	     cpu_mask, gd->gicd_base + GICD_ITARGETSR(0) + it);
+	io_write8(gd->gicd_base + GICD_ITARGETSR(0) + it, cpu_mask);
 }
 
 static void gic_it_set_prio(struct gic_data *gd, size_t it, uint8_t prio)
@@ -396,15 +395,24 @@ void gic_it_handle(struct gic_data *gd)
 	uint32_t iar;
 	uint32_t id;
 
-	iar = gic_read_iar(gd);
-	id = iar & GICC_IAR_IT_ID_MASK;
-
-	if (id < gd->max_it)
-		itr_handle(id);
-	else
-		DMSG("ignoring interrupt %" PRIu32, id);
-
-	gic_write_eoir(gd, iar);
+	/*
+	 * Acknowledge interrupts until none is pending, saving an
+	 * exception entry and return for each interrupt which became
+	 * pending while the previous one was handled.
+	 */
+	while (true) {
+		iar = gic_read_iar(gd);
+		id = iar & GICC_IAR_IT_ID_MASK;
+		if (id >= GICC_IAR_SPECIAL_ID)
+			break;
+
+		if (id < gd->max_it)
+			itr_handle(id);
+		else
+			DMSG("ignoring interrupt %" PRIu32, id);
+
+		gic_write_eoir(gd, iar);
+	}
 }
 
 static void gic_op_add(struct itr_chip *chip, size_t it,
@@ -108,11 +108,11 @@ static TEE_Result imx_wdog_base(vaddr_t *wdog_vbase)
 		return TEE_ERROR_NOT_SUPPORTED;
 
 	for (i = 0; i < ARRAY_SIZE(dt_match_table); i++) {
-		off = fdt_node_offset_by_compatible(fdt, 0, dt_match_table[i]);
+		off = dt_node_offset_by_compatible(fdt, 0, dt_match_table[i]);
 
 		for (; off != -FDT_ERR_NOTFOUND;
-		     off = fdt_node_offset_by_compatible(fdt, off,
-							 dt_match_table[i])) {
+		     off = dt_node_offset_by_compatible(fdt, off,
+							dt_match_table[i])) {
 			if (_fdt_get_status(fdt, off) != DT_STATUS_DISABLED)
 				break;
 		}
@@ -4,14 +4,18 @@
  *
  */
 
+#include <arm.h>
 #include <assert.h>
 #include <drivers/pl022_spi.h>
 #include <initcall.h>
 #include <io.h>
 #include <keep.h>
 #include <kernel/panic.h>
+#include <kernel/spinlock.h>
 #include <kernel/tee_time.h>
+#include <malloc.h>
 #include <platform_config.h>
+#include <string.h>
 #include <trace.h>
 #include <util.h>
 
@@ -135,6 +139,195 @@
 #define SSP_SCR_MAX		255
 #define SSP_SCR_MIN		0
 #define SSP_DATASIZE_MAX	16
+#define SSP_FIFO_DEPTH		8
+
+/*
+ * Moves data between the FIFOs and the transfer buffers. No more packets
+ * than the receive FIFO can hold are in flight so that it can't overrun.
+ * Returns true once all packets are received.
+ */
+static bool pl022_xfer_fifos(struct pl022_data *pd)
+{
+	struct pl022_xfer *x = &pd->xfer;
+	uint16_t rdat = 0;
+
+	while (x->rx_pos < x->num_pkts &&
+	       (io_read8(pd->base + SSPSR) & SSPSR_RNE)) {
+		if (x->pkt_size == 1)
+			rdat = io_read8(pd->base + SSPDR);
+		else
+			rdat = io_read16(pd->base + SSPDR);
+		if (x->rdat && x->pkt_size == 1)
+			((uint8_t *)x->rdat)[x->rx_pos] = rdat;
+		else if (x->rdat)
+			((uint16_t *)x->rdat)[x->rx_pos] = rdat;
+		x->rx_pos++;
+	}
+
+	while (x->tx_pos < x->num_pkts &&
+	       x->tx_pos - x->rx_pos < SSP_FIFO_DEPTH &&
+	       (io_read8(pd->base + SSPSR) & SSPSR_TNF)) {
+		if (x->pkt_size == 1)
+			io_write8(pd->base + SSPDR,
+				  ((const uint8_t *)x->wdat)[x->tx_pos]);
+		else
+			io_write16(pd->base + SSPDR,
+				   ((const uint16_t *)x->wdat)[x->tx_pos]);
+		x->tx_pos++;
+	}
+
+	return x->rx_pos == x->num_pkts;
+}
+
+static enum itr_return pl022_itr_cb(struct itr_handler *h)
+{
+	struct pl022_data *pd = h->data;
+	struct pl022_xfer *x = &pd->xfer;
+	enum spi_result res = SPI_OK;
+	spi_done_cb done = NULL;
+	void *done_data = NULL;
+	uint8_t mis = 0;
+
+	cpu_spin_lock(&pd->lock);
+
+	mis = io_read8(pd->base + SSPMIS);
+	io_write8(pd->base + SSPICR, SSPICR_RORIC | SSPICR_RTIC);
+
+	if (!x->busy) {
+		io_mask8(pd->base + SSPIMSC, 0, MASK_4);
+		goto out;
+	}
+
+	if (mis & SSPMIS_RORMIS) {
+		EMSG("Receive FIFO overrun");
+		res = SPI_ERR_PKTCNT;
+	} else if (!pl022_xfer_fifos(pd)) {
+		/*
+		 * The transmit interrupt is only needed while packets can
+		 * be sent, else the receive interrupts resume the transfer.
+		 */
+		if (x->tx_pos < x->num_pkts &&
+		    x->tx_pos - x->rx_pos < SSP_FIFO_DEPTH)
+			io_mask8(pd->base + SSPIMSC, SSPIMSC_TXIM,
+				 SSPIMSC_TXIM);
+		else
+			io_mask8(pd->base + SSPIMSC, 0, SSPIMSC_TXIM);
+		goto out;
+	}
+
+	io_mask8(pd->base + SSPIMSC, 0, MASK_4);
+	x->busy = false;
+	done = x->done;
+	done_data = x->done_data;
+out:
+	cpu_spin_unlock(&pd->lock);
+
+	if (done)
+		done(&pd->chip, res, done_data);
+
+	return ITRR_HANDLED;
+}
+
+static enum spi_result pl022_txrx_async(struct pl022_data *pd,
+					const void *wdat, void *rdat,
+					size_t num_pkts, size_t pkt_size,
+					spi_done_cb done, void *data)
+{
+	struct pl022_xfer *x = &pd->xfer;
+	uint32_t exceptions = 0;
+
+	if (!pd->itr || !wdat || !done)
+		return SPI_ERR_CFG;
+
+	if (pd->data_size_bits != pkt_size * 8) {
+		EMSG("data_size_bits should be %zu, not %u", pkt_size * 8,
+		     pd->data_size_bits);
+		return SPI_ERR_CFG;
+	}
+
+	exceptions = cpu_spin_lock_xsave(&pd->lock);
+
+	if (x->busy) {
+		cpu_spin_unlock_xrestore(&pd->lock, exceptions);
+		return SPI_ERR_BUSY;
+	}
+
+	x->wdat = wdat;
+	x->rdat = rdat;
+	x->num_pkts = num_pkts;
+	x->pkt_size = pkt_size;
+	x->tx_pos = 0;
+	x->rx_pos = 0;
+	x->done = done;
+	x->done_data = data;
+	x->busy = true;
+
+	/* The transmit interrupt is raised as long as the FIFO isn't full */
+	io_mask8(pd->base + SSPIMSC, SSPIMSC_TXIM | SSPIMSC_RXIM |
+		 SSPIMSC_RTIM | SSPIMSC_RORIM, MASK_4);
+
+	cpu_spin_unlock_xrestore(&pd->lock, exceptions);
+
+	return SPI_OK;
+}
+
+static enum spi_result pl022_txrx8_async(struct spi_chip *chip,
+					 uint8_t *wdat, uint8_t *rdat,
+					 size_t num_pkts, spi_done_cb done,
+					 void *data)
+{
+	struct pl022_data *pd = container_of(chip, struct pl022_data, chip);
+
+	return pl022_txrx_async(pd, wdat, rdat, num_pkts, sizeof(*wdat), done,
+				data);
+}
+
+static enum spi_result pl022_txrx16_async(struct spi_chip *chip,
+					  uint16_t *wdat, uint16_t *rdat,
+					  size_t num_pkts, spi_done_cb done,
+					  void *data)
+{
+	struct pl022_data *pd = container_of(chip, struct pl022_data, chip);
+
+	return pl022_txrx_async(pd, wdat, rdat, num_pkts, sizeof(*wdat), done,
+				data);
+}
+
+struct pl022_wait {
+	enum spi_result res;
+	bool done;
+};
+
+static void pl022_wait_done(struct spi_chip *chip __unused,
+			    enum spi_result res, void *data)
+{
+	struct pl022_wait *w = data;
+
+	w->res = res;
+	__atomic_store_n(&w->done, true, __ATOMIC_RELEASE);
+	dsb();
+	sev();
+}
+
+/* Synchronous transfer done from the interrupt handler */
+static enum spi_result pl022_txrx_wait(struct pl022_data *pd,
+				       const void *wdat, void *rdat,
+				       size_t num_pkts, size_t pkt_size)
+{
+	struct pl022_wait w = { };
+	enum spi_result res = SPI_OK;
+
+	res = pl022_txrx_async(pd, wdat, rdat, num_pkts, pkt_size,
+			       pl022_wait_done, &w);
+	if (res)
+		return res;
+
+	/* WFE returns on the SEV from the completion */
+	while (!__atomic_load_n(&w.done, __ATOMIC_ACQUIRE))
+		wfe();
+
+	return w.res;
+}
 
 static enum spi_result pl022_txrx8(struct spi_chip *chip, uint8_t *wdat,
 	uint8_t *rdat, size_t num_pkts)
@@ -150,6 +343,10 @@ static enum spi_result pl022_txrx8(struct spi_chip *chip, uint8_t *wdat,
 		return SPI_ERR_CFG;
 	}
 
+	if (pd->itr && wdat)
+		return pl022_txrx_wait(pd, wdat, rdat, num_pkts,
+				       sizeof(*wdat));
+
 	if (wdat)
 		while (i < num_pkts) {
 			if (io_read8(pd->base + SSPSR) & SSPSR_TNF) {
@@ -195,6 +392,10 @@ static enum spi_result pl022_txrx16(struct spi_chip *chip, uint16_t *wdat,
 		return SPI_ERR_CFG;
 	}
 
+	if (pd->itr && wdat)
+		return pl022_txrx_wait(pd, wdat, rdat, num_pkts,
+				       sizeof(*wdat));
+
 	if (wdat)
 		while (i < num_pkts) {
 			if (io_read8(pd->base + SSPSR) & SSPSR_TNF) {
@@ -498,6 +699,8 @@ static const struct spi_ops pl022_ops = {
 	.txrx8 = pl022_txrx8,
 	.txrx16 = pl022_txrx16,
 	.end = pl022_end,
+	.txrx8_async = pl022_txrx8_async,
+	.txrx16_async = pl022_txrx16_async,
 };
 KEEP_PAGER(pl022_ops);
 
@@ -505,4 +708,30 @@ void pl022_init(struct pl022_data *pd)
 {
 	assert(pd);
 	pd->chip.ops = &pl022_ops;
+	pd->itr = NULL;
+	pd->lock = SPINLOCK_UNLOCK;
+	memset(&pd->xfer, 0, sizeof(pd->xfer));
+}
+
+TEE_Result pl022_register_itr(struct pl022_data *pd, size_t itr_num,
+			      uint32_t itr_flags)
+{
+	struct itr_handler *itr = NULL;
+
+	assert(pd && !pd->itr);
+
+	itr = calloc(1, sizeof(*itr));
+	if (!itr)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	itr->it = itr_num;
+	itr->flags = itr_flags;
+	itr->handler = pl022_itr_cb;
+	itr->data = pd;
+	pd->itr = itr;
+
+	itr_add(itr);
+	itr_enable(itr->it);
+
+	return TEE_SUCCESS;
 }
@@ -215,7 +215,7 @@ static int get_pinctrl_from_fdt(void *fdt, int node,
 	if (!cuint)
 		return -FDT_ERR_NOTFOUND;
 
-	pinctrl_node = fdt_parent_offset(fdt, fdt_parent_offset(fdt, node));
+	pinctrl_node = dt_parent_offset(fdt, dt_parent_offset(fdt, node));
 	if (pinctrl_node < 0)
 		return -FDT_ERR_NOTFOUND;
 
@@ -320,7 +320,7 @@ int stm32_pinctrl_fdt_get_pinctrl(void *fdt, int device_node,
 		int node = 0;
 		int subnode = 0;
 
-		node = fdt_node_offset_by_phandle(fdt, fdt32_to_cpu(*cuint));
+		node = dt_node_offset_by_phandle(fdt, fdt32_to_cpu(*cuint));
 		if (node < 0)
 			return -FDT_ERR_NOTFOUND;
 
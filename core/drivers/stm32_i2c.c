@@ -15,6 +15,7 @@
 #include <kernel/delay.h>
 #include <kernel/dt.h>
 #include <kernel/generic_boot.h>
+#include <kernel/interrupt.h>
 #include <kernel/panic.h>
 #include <libfdt.h>
 #include <stdbool.h>
@@ -57,6 +58,9 @@
 #define I2C_CR1_SMBDEN			BIT(21)
 #define I2C_CR1_ALERTEN			BIT(22)
 #define I2C_CR1_PECEN			BIT(23)
+#define I2C_CR1_EVENT_IE		(I2C_CR1_TXIE | I2C_CR1_RXIE | \
+					 I2C_CR1_NACKIE | I2C_CR1_STOPIE | \
+					 I2C_CR1_TCIE | I2C_CR1_ERRIE)
 
 /* Bit definition for I2C_CR2 register */
 #define I2C_CR2_SADD			GENMASK_32(9, 0)
@@ -801,6 +805,82 @@ static void i2c_flush_txdr(struct i2c_handle_s *hi2c)
 		io_setbits32(base + I2C_ISR, I2C_ISR_TXE);
 }
 
+static enum itr_return stm32_i2c_itr_cb(struct itr_handler *h)
+{
+	struct i2c_handle_s *hi2c = h->data;
+
+	/* Events are handled by the waiting thread, only wake it up */
+	io_clrbits32(get_base(hi2c) + I2C_CR1, I2C_CR1_EVENT_IE);
+	dsb();
+	sev();
+
+	return ITRR_HANDLED;
+}
+
+int stm32_i2c_register_itr(struct i2c_handle_s *hi2c, size_t itr_num,
+			   uint32_t itr_flags)
+{
+	struct itr_handler *itr = NULL;
+
+	assert(!hi2c->itr);
+
+	itr = calloc(1, sizeof(*itr));
+	if (!itr)
+		return -1;
+
+	itr->it = itr_num;
+	itr->flags = itr_flags;
+	itr->handler = stm32_i2c_itr_cb;
+	itr->data = hi2c;
+	hi2c->itr = itr;
+
+	itr_add(itr);
+	itr_enable(itr->it);
+
+	return 0;
+}
+
+/* Interrupt enable bits in I2C_CR1 of the events in I2C_ISR @isr_mask */
+static uint32_t isr_to_cr1_ie(uint32_t isr_mask)
+{
+	uint32_t ie = 0;
+
+	if (isr_mask & I2C_ISR_TXIS)
+		ie |= I2C_CR1_TXIE;
+	if (isr_mask & I2C_ISR_RXNE)
+		ie |= I2C_CR1_RXIE;
+	if (isr_mask & (I2C_ISR_TC | I2C_ISR_TCR))
+		ie |= I2C_CR1_TCIE;
+	if (isr_mask & I2C_ISR_STOPF)
+		ie |= I2C_CR1_STOPIE;
+	if (isr_mask & I2C_ISR_NACKF)
+		ie |= I2C_CR1_NACKIE;
+
+	return ie;
+}
+
+/*
+ * Sleep until one of the events in I2C_ISR @isr_mask or an error occurs.
+ * Returns directly if the interrupt isn't used or if there's no interrupt
+ * for these events, the caller then keeps polling.
+ *
+ * If the event occurred since the caller checked for it, the interrupt is
+ * raised as soon as it's enabled and its SEV makes WFE return directly.
+ * The caller's timeout is only checked when WFE returns, bus errors raise
+ * the interrupt too.
+ */
+static void i2c_wait_itr(struct i2c_handle_s *hi2c, uint32_t isr_mask)
+{
+	uint32_t ie = isr_to_cr1_ie(isr_mask);
+
+	if (!hi2c->itr || !ie)
+		return;
+
+	io_setbits32(get_base(hi2c) + I2C_CR1,
+		     ie | I2C_CR1_NACKIE | I2C_CR1_ERRIE);
+	wfe();
+}
+
 /*
  * Wait for a single target I2C_ISR bit to reach an awaited value (0 or 1)
  *
@@ -818,9 +898,12 @@ static int wait_isr_event(struct i2c_handle_s *hi2c, uint32_t bit_mask,
 	assert(IS_POWER_OF_TWO(bit_mask) && !(awaited_value & ~1U));
 
 	/* May timeout while TEE thread is suspended */
-	while (!timeout_elapsed(timeout_ref))
+	while (!timeout_elapsed(timeout_ref)) {
 		if (!!(io_read32(isr) & bit_mask) == awaited_value)
 			break;
+		if (awaited_value)
+			i2c_wait_itr(hi2c, bit_mask);
+	}
 
 	if (!!(io_read32(isr) & bit_mask) == awaited_value)
 		return 0;
@@ -842,9 +925,11 @@ static int i2c_ack_failed(struct i2c_handle_s *hi2c, uint64_t timeout_ref)
 	 * AutoEnd should be initiate after AF.
 	 * Timeout may elpased while TEE thread is suspended.
 	 */
-	while (!timeout_elapsed(timeout_ref))
+	while (!timeout_elapsed(timeout_ref)) {
 		if (io_read32(base + I2C_ISR) & I2C_ISR_STOPF)
 			break;
+		i2c_wait_itr(hi2c, I2C_ISR_STOPF);
+	}
 
 	if ((io_read32(base + I2C_ISR) & I2C_ISR_STOPF) == 0) {
 		notif_i2c_timeout(hi2c);
@@ -873,6 +958,7 @@ static int i2c_wait_txis(struct i2c_handle_s *hi2c, uint64_t timeout_ref)
 			break;
 		if (i2c_ack_failed(hi2c, timeout_ref))
 			return -1;
+		i2c_wait_itr(hi2c, I2C_ISR_TXIS);
 	}
 
 	if (io_read32(get_base(hi2c) + I2C_ISR) & I2C_ISR_TXIS)
@@ -894,6 +980,8 @@ static int i2c_wait_stop(struct i2c_handle_s *hi2c, uint64_t timeout_ref)
 
 		if (i2c_ack_failed(hi2c, timeout_ref))
 			return -1;
+
+		i2c_wait_itr(hi2c, I2C_ISR_STOPF);
 	}
 
 	if (io_read32(get_base(hi2c) + I2C_ISR) & I2C_ISR_STOPF)
@@ -1407,9 +1495,11 @@ bool stm32_i2c_is_device_ready(struct i2c_handle_s *hi2c, uint32_t dev_addr,
 		 * Wait until STOPF flag is set or a NACK flag is set.
 		 */
 		timeout_ref = timeout_init_us(timeout_ms * 1000);
-		while (!timeout_elapsed(timeout_ref))
+		while (!timeout_elapsed(timeout_ref)) {
 			if (io_read32(isr) & (I2C_ISR_STOPF | I2C_ISR_NACKF))
 				break;
+			i2c_wait_itr(hi2c, I2C_ISR_STOPF | I2C_ISR_NACKF);
+		}
 
 		if ((io_read32(isr) & (I2C_ISR_STOPF | I2C_ISR_NACKF)) == 0) {
 			notif_i2c_timeout(hi2c);
@@ -11,6 +11,7 @@
 #include <kernel/generic_boot.h>
 #include <kernel/panic.h>
 #include <mm/core_memprot.h>
+#include <rng_support.h>
 #include <stdbool.h>
 #include <stm32_util.h>
 #include <string.h>
@@ -76,13 +77,32 @@ static void conceal_seed_error(vaddr_t rng_base)
 }
 
 #define RNG_FIFO_BYTE_DEPTH		16u
+/* Maximum number of bytes read with exceptions masked */
+#define RNG_BURST_BYTE_MAX		(4 * RNG_FIFO_BYTE_DEPTH)
+
+static bool wait_data_ready(vaddr_t rng_base)
+{
+	uint64_t timeout_ref = timeout_init_us(RNG_TIMEOUT_US);
+
+	/* Wait RNG has produced well seeded random samples */
+	while (!timeout_elapsed(timeout_ref)) {
+		conceal_seed_error(rng_base);
+
+		if (io_read32(rng_base + RNG_SR) & RNG_SR_DRDY)
+			return true;
+	}
+
+	return io_read32(rng_base + RNG_SR) & RNG_SR_DRDY;
+}
 
 TEE_Result stm32_rng_read_raw(vaddr_t rng_base, uint8_t *out, size_t *size)
 {
 	bool enabled = false;
 	TEE_Result rc = TEE_ERROR_SECURITY;
 	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
-	uint64_t timeout_ref = timeout_init_us(RNG_TIMEOUT_US);
+	size_t req_size = MIN(RNG_BURST_BYTE_MAX, *size);
+	size_t len = req_size;
+	uint8_t *buf = out;
 
 	if (!(io_read32(rng_base + RNG_CR) & RNG_CR_RNGEN)) {
 		/* Enable RNG if not, clock error is disabled */
@@ -90,30 +110,25 @@ TEE_Result stm32_rng_read_raw(vaddr_t rng_base, uint8_t *out, size_t *size)
 		enabled = true;
 	}
 
-	/* Wait RNG has produced well seeded random samples */
-	while (!timeout_elapsed(timeout_ref)) {
-		conceal_seed_error(rng_base);
-
-		if (io_read32(rng_base + RNG_SR) & RNG_SR_DRDY)
-			break;
-	}
-
-	if (io_read32(rng_base + RNG_SR) & RNG_SR_DRDY) {
-		uint8_t *buf = out;
-		size_t req_size = MIN(RNG_FIFO_BYTE_DEPTH, *size);
-		size_t len = req_size;
+	/* Read the FIFO each time it's refilled, up to a few times */
+	while (len && wait_data_ready(rng_base)) {
+		size_t fifo_len = MIN(len, RNG_FIFO_BYTE_DEPTH);
 
 		/* RNG is ready: read up to 4 32bit words */
-		while (len) {
+		while (fifo_len) {
 			uint32_t data32 = io_read32(rng_base + RNG_DR);
-			size_t sz = MIN(len, sizeof(uint32_t));
+			size_t sz = MIN(fifo_len, sizeof(uint32_t));
 
 			memcpy(buf, &data32, sz);
 			buf += sz;
+			fifo_len -= sz;
 			len -= sz;
 		}
+	}
+
+	if (len != req_size) {
 		rc = TEE_SUCCESS;
-		*size = req_size;
+		*size = req_size - len;
 	}
 
 	if (enabled)
@@ -187,6 +202,11 @@ bail:
 	return rc;
 }
 
+TEE_Result hw_get_random_bytes(void *buf, size_t len)
+{
+	return stm32_rng_read(buf, len);
+}
+
 #ifdef CFG_EMBED_DTB
 static TEE_Result stm32_rng_init(void)
 {
@@ -202,7 +222,7 @@ static TEE_Result stm32_rng_init(void)
 		panic();
 
 	while (true) {
-		node = fdt_node_offset_by_compatible(fdt, node, DT_RNG_COMPAT);
+		node = dt_node_offset_by_compatible(fdt, node, DT_RNG_COMPAT);
 		if (node < 0)
 			break;
 
@@ -49,6 +49,31 @@ TEE_Result crypto_cipher_update(void *ctx, uint32_t algo,
 				TEE_OperationMode mode, bool last_block,
 				const uint8_t *data, size_t len, uint8_t *dst);
 void crypto_cipher_final(void *ctx, uint32_t algo);
+
+/*
+ * Restarts @ctx with a new @iv and the key(s) of the last successful
+ * crypto_cipher_init(), also after crypto_cipher_final(). Saves the key
+ * expansion done by crypto_cipher_init(). Returns TEE_ERROR_NOT_SUPPORTED
+ * if the implementation can't, crypto_cipher_init() must then be used.
+ */
+TEE_Result crypto_cipher_reinit(void *ctx, uint32_t algo,
+				TEE_OperationMode mode, const uint8_t *iv,
+				size_t iv_len);
+
+/* Maximum number of contexts passed to crypto_cipher_update_multi() */
+#define CRYPTO_CIPHER_UPDATE_MULTI_MAX	4
+
+/*
+ * Updates @num contexts of the same algorithm and mode, each with
+ * @len bytes from data[n] to dst[n]. The contexts must be distinct and
+ * none of the updates can be the last one. Implementations may process
+ * the streams interleaved, which is faster than one at a time when the
+ * mode is serial like CBC encryption.
+ */
+TEE_Result crypto_cipher_update_multi(void *ctx[], uint32_t algo,
+				      TEE_OperationMode mode, size_t num,
+				      const uint8_t *data[], size_t len,
+				      uint8_t *dst[]);
 TEE_Result crypto_cipher_get_block_size(uint32_t algo, size_t *size);
 void crypto_cipher_free_ctx(void *ctx, uint32_t algo);
 void crypto_cipher_copy_state(void *dst_ctx, void *src_ctx, uint32_t algo);
@@ -61,6 +86,12 @@ TEE_Result crypto_mac_update(void *ctx, uint32_t algo, const uint8_t *data,
 			     size_t len);
 TEE_Result crypto_mac_final(void *ctx, uint32_t algo, uint8_t *digest,
 			    size_t digest_len);
+/*
+ * Restarts @ctx with the key of the last successful crypto_mac_init(),
+ * also after crypto_mac_final(). Returns TEE_ERROR_NOT_SUPPORTED if the
+ * implementation can't, crypto_mac_init() must then be used.
+ */
+TEE_Result crypto_mac_reinit(void *ctx, uint32_t algo);
 void crypto_mac_free_ctx(void *ctx, uint32_t algo);
 void crypto_mac_copy_state(void *dst_ctx, void *src_ctx, uint32_t algo);
 
@@ -71,6 +102,17 @@ TEE_Result crypto_authenc_init(void *ctx, uint32_t algo, TEE_OperationMode mode,
 			       const uint8_t *nonce, size_t nonce_len,
 			       size_t tag_len, size_t aad_len,
 			       size_t payload_len);
+/*
+ * Restarts @ctx with a new @nonce and the key of the last successful
+ * crypto_authenc_init(), also after crypto_authenc_final(). Returns
+ * TEE_ERROR_NOT_SUPPORTED if the implementation can't,
+ * crypto_authenc_init() must then be used.
+ */
+TEE_Result crypto_authenc_reinit(void *ctx, uint32_t algo,
+				 TEE_OperationMode mode,
+				 const uint8_t *nonce, size_t nonce_len,
+				 size_t tag_len, size_t aad_len,
+				 size_t payload_len);
 TEE_Result crypto_authenc_update_aad(void *ctx, uint32_t algo,
 				     TEE_OperationMode mode,
 				     const uint8_t *data, size_t len);
@@ -123,6 +165,14 @@ struct rsa_keypair {
 	struct bignum *qp;	/* 1/q mod p */
 	struct bignum *dp;	/* d mod (p-1) */
 	struct bignum *dq;	/* d mod (q-1) */
+
+	/*
+	 * Values derived from the key by the crypto library on first use
+	 * to speed up later private key operations, NULL until then. Must
+	 * be released with crypto_acipher_clear_rsa_keypair_cache() when
+	 * the key changes or is freed.
+	 */
+	void *cache;
 };
 
 struct rsa_public_key {
@@ -172,6 +222,24 @@ struct ecc_keypair {
 	uint32_t curve;	        /* Curve type */
 };
 
+/* Size in bytes of the X25519 and Ed25519 keys and public values */
+#define CURVE25519_KEY_SIZE	32
+
+/* X25519 and Ed25519 keys are byte strings as in RFC 7748 and RFC 8032 */
+struct x25519_keypair {
+	uint8_t priv[CURVE25519_KEY_SIZE];	/* Private scalar */
+	uint8_t pub[CURVE25519_KEY_SIZE];	/* Public u-coordinate */
+};
+
+struct ed25519_keypair {
+	uint8_t priv[CURVE25519_KEY_SIZE];	/* Private seed */
+	uint8_t pub[CURVE25519_KEY_SIZE];	/* Public key */
+};
+
+struct ed25519_public_key {
+	uint8_t pub[CURVE25519_KEY_SIZE];	/* Public key */
+};
+
 /*
  * Key allocation functions
  * Allocate the bignum's inside a key structure.
@@ -182,6 +250,7 @@ TEE_Result crypto_acipher_alloc_rsa_keypair(struct rsa_keypair *s,
 TEE_Result crypto_acipher_alloc_rsa_public_key(struct rsa_public_key *s,
 				   size_t key_size_bits);
 void crypto_acipher_free_rsa_public_key(struct rsa_public_key *s);
+void crypto_acipher_clear_rsa_keypair_cache(struct rsa_keypair *s);
 TEE_Result crypto_acipher_alloc_dsa_keypair(struct dsa_keypair *s,
 				size_t key_size_bits);
 TEE_Result crypto_acipher_alloc_dsa_public_key(struct dsa_public_key *s,
@@ -202,6 +271,8 @@ TEE_Result crypto_acipher_gen_dsa_key(struct dsa_keypair *key, size_t key_size);
 TEE_Result crypto_acipher_gen_dh_key(struct dh_keypair *key, struct bignum *q,
 				     size_t xbits);
 TEE_Result crypto_acipher_gen_ecc_key(struct ecc_keypair *key);
+TEE_Result crypto_acipher_gen_x25519_key(struct x25519_keypair *key);
+TEE_Result crypto_acipher_gen_ed25519_key(struct ed25519_keypair *key);
 
 TEE_Result crypto_acipher_dh_shared_secret(struct dh_keypair *private_key,
 					   struct bignum *public_key,
@@ -248,6 +319,17 @@ TEE_Result crypto_acipher_ecc_shared_secret(struct ecc_keypair *private_key,
 					    struct ecc_public_key *public_key,
 					    void *secret,
 					    unsigned long *secret_len);
+/* @public_key and @secret are CURVE25519_KEY_SIZE bytes */
+TEE_Result
+crypto_acipher_x25519_shared_secret(struct x25519_keypair *private_key,
+				    const uint8_t *public_key,
+				    uint8_t *secret);
+TEE_Result crypto_acipher_ed25519_sign(struct ed25519_keypair *key,
+				       const uint8_t *msg, size_t msg_len,
+				       uint8_t *sig, size_t *sig_len);
+TEE_Result crypto_acipher_ed25519_verify(struct ed25519_public_key *key,
+					 const uint8_t *msg, size_t msg_len,
+					 const uint8_t *sig, size_t sig_len);
 
 /*
  * Verifies a SHA-256 hash, doesn't require crypto_init() to be called in
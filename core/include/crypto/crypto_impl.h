@@ -86,6 +86,8 @@ struct crypto_mac_ops {
 	void (*free_ctx)(struct crypto_mac_ctx *ctx);
 	void (*copy_state)(struct crypto_mac_ctx *dst_ctx,
 			   struct crypto_mac_ctx *src_ctx);
+	/* Optional, see crypto_mac_reinit() */
+	TEE_Result (*reinit)(struct crypto_mac_ctx *ctx);
 };
 
 #if defined(CFG_CRYPTO_HMAC)
@@ -147,6 +149,14 @@ struct crypto_cipher_ops {
 	void (*free_ctx)(struct crypto_cipher_ctx *ctx);
 	void (*copy_state)(struct crypto_cipher_ctx *dst_ctx,
 			   struct crypto_cipher_ctx *src_ctx);
+	/* Optional, see crypto_cipher_update_multi() */
+	TEE_Result (*update_multi)(struct crypto_cipher_ctx *ctx[],
+				   size_t num, const uint8_t *data[],
+				   size_t len, uint8_t *dst[]);
+	/* Optional, see crypto_cipher_reinit() */
+	TEE_Result (*reinit)(struct crypto_cipher_ctx *ctx,
+			     TEE_OperationMode mode, const uint8_t *iv,
+			     size_t iv_len);
 };
 
 #if defined(CFG_CRYPTO_AES) && defined(CFG_CRYPTO_ECB)
@@ -228,10 +238,17 @@ struct crypto_authenc_ops {
 	void (*free_ctx)(struct crypto_authenc_ctx *ctx);
 	void (*copy_state)(struct crypto_authenc_ctx *dst_ctx,
 			   struct crypto_authenc_ctx *src_ctx);
+	/* Optional, see crypto_authenc_reinit() */
+	TEE_Result (*reinit)(struct crypto_authenc_ctx *ctx,
+			     TEE_OperationMode mode,
+			     const uint8_t *nonce, size_t nonce_len,
+			     size_t tag_len, size_t aad_len,
+			     size_t payload_len);
 };
 
 TEE_Result crypto_aes_ccm_alloc_ctx(struct crypto_authenc_ctx **ctx);
 TEE_Result crypto_aes_gcm_alloc_ctx(struct crypto_authenc_ctx **ctx);
+TEE_Result crypto_chacha20_poly1305_alloc_ctx(struct crypto_authenc_ctx **ctx);
 
 #ifdef CFG_CRYPTO_DRV_HASH
 TEE_Result drvcrypt_hash_alloc_ctx(struct crypto_hash_ctx **ctx, uint32_t algo);
@@ -266,4 +283,36 @@ drvcrypt_mac_alloc_ctx(struct crypto_mac_ctx **ctx __unused,
 }
 #endif /* CFG_CRYPTO_DRV_MAC */
 
+/* Software implementation of @algo, whether a crypto driver supports it */
+TEE_Result crypto_sw_hash_alloc_ctx(struct crypto_hash_ctx **ctx,
+				    uint32_t algo);
+TEE_Result crypto_sw_cipher_alloc_ctx(struct crypto_cipher_ctx **ctx,
+				      uint32_t algo);
+
+#ifdef CFG_CRYPTO_DRV_SW_DISPATCH
+/*
+ * Wrap the driver context *@ctx of @algo so that operations smaller than
+ * the size threshold of @algo are done by the software implementation.
+ * *@ctx is left unchanged if there's no threshold for @algo.
+ */
+TEE_Result drvcrypt_hash_dispatch_ctx(struct crypto_hash_ctx **ctx,
+				      uint32_t algo);
+TEE_Result drvcrypt_cipher_dispatch_ctx(struct crypto_cipher_ctx **ctx,
+					uint32_t algo);
+#else
+static inline TEE_Result
+drvcrypt_hash_dispatch_ctx(struct crypto_hash_ctx **ctx __unused,
+			   uint32_t algo __unused)
+{
+	return TEE_SUCCESS;
+}
+
+static inline TEE_Result
+drvcrypt_cipher_dispatch_ctx(struct crypto_cipher_ctx **ctx __unused,
+			     uint32_t algo __unused)
+{
+	return TEE_SUCCESS;
+}
+#endif /* CFG_CRYPTO_DRV_SW_DISPATCH */
+
 #endif /*__CRYPTO_CRYPTO_IMPL_H*/
@@ -24,6 +24,10 @@ struct internal_aes_gcm_state {
 	uint64_t HH[16];
 #else
 	uint8_t hash_subkey[TEE_AES_BLOCK_SIZE];
+#ifdef CFG_CRYPTO_WITH_CE
+	/* H^2, H^3 and H^4 following H, see internal_aes_gcm_set_key() */
+	uint8_t hash_subkey_pow[3][TEE_AES_BLOCK_SIZE];
+#endif
 #endif
 	uint8_t hash_state[TEE_AES_BLOCK_SIZE];
 
@@ -77,6 +81,34 @@ TEE_Result
 internal_aes_gcm_expand_enc_key(const void *key, size_t key_len,
 				struct internal_aes_gcm_key *enc_key);
 
+/*
+ * An expanded key together with the hash subkey derived from it, for
+ * many one-shot operations with the same key. Each operation then starts
+ * from a copy of @state instead of deriving the hash subkey again.
+ */
+struct internal_aes_gcm_prepared_key {
+	struct internal_aes_gcm_key key;
+	struct internal_aes_gcm_state state;
+};
+
+TEE_Result
+internal_aes_gcm_prepare_key(const void *key, size_t key_len,
+			     struct internal_aes_gcm_prepared_key *pk);
+
+TEE_Result
+internal_aes_gcm_enc_prepared(const struct internal_aes_gcm_prepared_key *pk,
+			      const void *nonce, size_t nonce_len,
+			      const void *aad, size_t aad_len,
+			      const void *src, size_t len, void *dst,
+			      void *tag, size_t *tag_len);
+
+TEE_Result
+internal_aes_gcm_dec_prepared(const struct internal_aes_gcm_prepared_key *pk,
+			      const void *nonce, size_t nonce_len,
+			      const void *aad, size_t aad_len,
+			      const void *src, size_t len, void *dst,
+			      const void *tag, size_t tag_len);
+
 /*
  * Internal weak functions that can be overridden with hardware specific
  * implementations.
@@ -8,7 +8,9 @@
 #define __PL022_SPI_H__
 
 #include <gpio.h>
+#include <kernel/interrupt.h>
 #include <spi.h>
+#include <tee_api_types.h>
 
 #define PL022_REG_SIZE	0x1000
 
@@ -28,6 +30,19 @@ union pl022_cs_data {
 	void				(*cs_cb)(enum gpio_level value);
 };
 
+/* Transfer in progress when the interrupt is used */
+struct pl022_xfer {
+	const void		*wdat;
+	void			*rdat;
+	size_t			num_pkts;
+	size_t			pkt_size;
+	size_t			tx_pos;
+	size_t			rx_pos;
+	spi_done_cb		done;
+	void			*done_data;
+	bool			busy;
+};
+
 struct pl022_data {
 	union pl022_cs_data	cs_data;
 	struct spi_chip		chip;
@@ -38,9 +53,26 @@ struct pl022_data {
 	unsigned int		speed_hz;
 	unsigned int		data_size_bits;
 	bool			loopback;
+	struct itr_handler	*itr;
+	unsigned int		lock;
+	struct pl022_xfer	xfer;
 };
 
 void pl022_init(struct pl022_data *pd);
 
+/*
+ * Optionally use the interrupt of the controller: transfers are then done
+ * from the interrupt handler, the asynchronous operations are available
+ * and the synchronous ones wait for completion in WFE instead of polling.
+ * To be called after pl022_init().
+ *
+ * @pd: pl022 platform data
+ * @itr_num: pl022 interrupt id
+ * @itr_flags: interrupt attributes
+ * Return a TEE_Result compliant status
+ */
+TEE_Result pl022_register_itr(struct pl022_data *pd, size_t itr_num,
+			      uint32_t itr_flags);
+
 #endif	/* __PL022_SPI_H__ */
 
@@ -113,6 +113,7 @@ struct i2c_cfg {
  * @sec_cfg: I2C regsiters configuration storage
  * @pinctrl: PINCTRLs configuration for the I2C PINs
  * @pinctrl_count: Number of PINCTRLs elements
+ * @itr: Interrupt waking up the waits for bus events, NULL if polling
  */
 struct i2c_handle_s {
 	struct io_pa_va base;
@@ -123,6 +124,7 @@ struct i2c_handle_s {
 	struct i2c_cfg sec_cfg;
 	struct stm32_pinctrl *pinctrl;
 	size_t pinctrl_count;
+	struct itr_handler *itr;
 };
 
 /* STM32 specific defines */
@@ -158,6 +160,18 @@ int stm32_i2c_get_setup_from_fdt(void *fdt, int node,
 int stm32_i2c_init(struct i2c_handle_s *hi2c,
 		   struct stm32_i2c_init_s *init_data);
 
+/*
+ * Use the I2C event interrupt: instead of polling the status register, the
+ * waits for bus events sleep in WFE until the interrupt is raised.
+ *
+ * @hi2c: Reference to I2C bus handle structure
+ * @itr_num: I2C event interrupt ID
+ * @itr_flags: Interrupt attributes
+ * Return 0 on success else a negative value
+ */
+int stm32_i2c_register_itr(struct i2c_handle_s *hi2c, size_t itr_num,
+			   uint32_t itr_flags);
+
 /*
  * Send a memory write request in the I2C bus
  *
@@ -23,5 +23,26 @@ typedef TEE_Result (*initcall_t)(void);
 #define driver_init(fn)		__define_initcall(3, fn)
 #define driver_init_late(fn)	__define_initcall(4, fn)
 
+/*
+ * Driver initialization which isn't needed to boot normal world. These
+ * initcalls are run in thread context once boot is completed, by
+ * deferred work. Code depending on such a driver calls
+ * initcall_run_deferred() first.
+ */
+#define driver_init_deferred(fn) \
+	SCATTERED_ARRAY_DEFINE_PG_ITEM(deferred_initcall, initcall_t) = (fn)
+
+#define deferred_initcall_begin \
+	SCATTERED_ARRAY_BEGIN(deferred_initcall, initcall_t)
+#define deferred_initcall_end \
+	SCATTERED_ARRAY_END(deferred_initcall, initcall_t)
+
+/*
+ * Runs the deferred initcalls unless they have already been run, waits
+ * if they're being run by another thread. Must be called in thread
+ * context. Called from a deferred initcall it returns directly, the
+ * initcalls run in the order they are linked.
+ */
+void initcall_run_deferred(void);
 
 #endif
@@ -127,6 +127,18 @@ int dt_disable_status(void *fdt, int node);
  */
 int dt_enable_secure_status(void *fdt, int node);
 
+/*
+ * Lookups of nodes through an index of @fdt built on first use, with the
+ * same semantics as fdt_node_offset_by_compatible(),
+ * fdt_node_offset_by_phandle() and fdt_parent_offset() respectively.
+ * They don't rescan the tree as long as its structure block isn't
+ * resized.
+ */
+int dt_node_offset_by_compatible(const void *fdt, int startoffset,
+				 const char *compatible);
+int dt_node_offset_by_phandle(const void *fdt, uint32_t phandle);
+int dt_parent_offset(const void *fdt, int offs);
+
 /*
  * FDT manipulation functions, not provided by <libfdt.h>
  */
@@ -186,6 +198,25 @@ static inline int dt_map_dev(const void *fdt __unused, int offs __unused,
 	return -1;
 }
 
+static inline int dt_node_offset_by_compatible(const void *fdt __unused,
+					       int startoffset __unused,
+					       const char *compatible __unused)
+{
+	return -1;
+}
+
+static inline int dt_node_offset_by_phandle(const void *fdt __unused,
+					    uint32_t phandle __unused)
+{
+	return -1;
+}
+
+static inline int dt_parent_offset(const void *fdt __unused,
+				   int offs __unused)
+{
+	return -1;
+}
+
 static inline paddr_t _fdt_reg_base_address(const void *fdt __unused,
 					    int offs __unused)
 {
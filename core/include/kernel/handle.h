@@ -5,14 +5,32 @@
 #ifndef KERNEL_HANDLE_H
 #define KERNEL_HANDLE_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+/*
+ * A handle is the index of a slot in the low HANDLE_IDX_BITS and the
+ * generation of the slot in the bits above. The generation is bumped each
+ * time the slot is freed so a stale handle doesn't match a pointer
+ * registered later in the same slot. Free slots are linked in a list so
+ * handles are allocated and freed in constant time.
+ */
+#define HANDLE_IDX_BITS		20
+#define HANDLE_GEN_BITS		11
+
+struct handle_db_slot {
+	void *ptr;
+	uint32_t gen;
+	uint32_t next_free;	/* index + 1 of next free slot, 0 if last */
+};
+
 struct handle_db {
-	void **ptrs;
+	struct handle_db_slot *slots;
 	size_t max_ptrs;
+	size_t free_head;	/* index + 1 of first free slot, 0 if none */
 };
 
-#define HANDLE_DB_INITIALIZER { NULL, 0 }
+#define HANDLE_DB_INITIALIZER { NULL, 0, 0 }
 
 /*
  * Frees all internal data structures of the database, but does not free
@@ -33,7 +51,8 @@ int handle_get(struct handle_db *db, void *ptr);
 
 /*
  * Deallocates a handle. Returns the assiciated pointer of the handle
- * the the handle was valid or NULL if it's invalid.
+ * the the handle was valid or NULL if it's invalid. A handle is invalid
+ * once it has been deallocated, even if its slot has been reused.
  */
 void *handle_put(struct handle_db *db, int handle);
 
@@ -45,6 +45,8 @@ enum huk_subkey_usage {
  *
  * Returns a subkey derived from the hardware unique key. Given the same
  * input the same subkey is returned each time.
+ * With CFG_CORE_HUK_SUBKEY_CACHE=y subkeys already derived are served
+ * from a cache.
  *
  * Return TEE_SUCCES on success or an error code on failure.
  */
@@ -5,6 +5,8 @@
 #ifndef __KERNEL_INTERRUPT_H
 #define __KERNEL_INTERRUPT_H
 
+#include <compiler.h>
+#include <stdbool.h>
 #include <types_ext.h>
 #include <sys/queue.h>
 
@@ -36,6 +38,25 @@ struct itr_handler {
 	enum itr_return (*handler)(struct itr_handler *h);
 	void *data;
 	SLIST_ENTRY(itr_handler) link;
+#ifdef CFG_ITR_STATS
+	uint64_t count;
+	uint64_t ticks;
+	uint64_t max_ticks;
+#endif
+};
+
+/*
+ * struct itr_stats - Statistics of an interrupt handler
+ * @it:		Interrupt number
+ * @count:	Number of times the handler was called
+ * @time_ns:	Total time spent in the handler
+ * @max_ns:	Longest time spent in the handler
+ */
+struct itr_stats {
+	uint64_t it;
+	uint64_t count;
+	uint64_t time_ns;
+	uint64_t max_ns;
 };
 
 void itr_init(struct itr_chip *data);
@@ -64,4 +85,24 @@ void itr_set_affinity(size_t it, uint8_t cpu_mask);
  */
 void itr_core_handler(void);
 
+#ifdef CFG_ITR_STATS
+/*
+ * itr_get_stats() - Get the statistics of all interrupt handlers
+ * @stats:	Output array
+ * @count:	[in] Number of entries in @stats, [out] number of handlers
+ * @reset:	If true, the statistics are cleared after being copied
+ *
+ * Returns false if @stats is too small, @count is then updated with the
+ * required number of entries.
+ */
+bool itr_get_stats(struct itr_stats *stats, size_t *count, bool reset);
+#else
+static inline bool itr_get_stats(struct itr_stats *stats __unused,
+				 size_t *count, bool reset __unused)
+{
+	*count = 0;
+	return true;
+}
+#endif
+
 #endif /*__KERNEL_INTERRUPT_H*/
@@ -28,15 +28,19 @@ struct lockdep_edge {
 
 STAILQ_HEAD(lockdep_edge_head, lockdep_edge);
 
+TAILQ_HEAD(lockdep_node_head, lockdep_node);
+
 struct lockdep_node {
 	uintptr_t lock_id; /* For instance, address of actual lock object */
 	struct lockdep_edge_head edges;
 	TAILQ_ENTRY(lockdep_node) link;
+	/* Lookup of the node by @graph and @lock_id */
+	struct lockdep_node_head *graph;
+	LIST_ENTRY(lockdep_node) hash_link;
+	unsigned int visit_gen; /* Last search reaching the node */
 	uint8_t flags; /* Used temporarily when walking the graph */
 };
 
-TAILQ_HEAD(lockdep_node_head, lockdep_node);
-
 /* Per-thread queue of currently owned locks (point to nodes in the graph) */
 
 struct lockdep_lock {
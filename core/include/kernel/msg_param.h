@@ -44,18 +44,21 @@
  * @size - optee_msg_param.u.tmem.size value
  * @shm_ref - optee_msg_param.u.tmem.shm_ref value
  * @map_buffer - true if buffer needs to be mapped into OP-TEE address space
+ * @cattr - cache attributes normal world maps the buffer with,
+ *	    TEE_MATTR_CACHE_*, only TEE_MATTR_CACHE_CACHED with @map_buffer
  *
  * return:
  *	mobj or NULL on error
  */
 #ifdef CFG_CORE_DYN_SHM
 struct mobj *msg_param_mobj_from_noncontig(paddr_t buf_ptr, size_t size,
-					   uint64_t shm_ref, bool map_buffer);
+					   uint64_t shm_ref, bool map_buffer,
+					   uint32_t cattr);
 #else
 static inline struct mobj *
 msg_param_mobj_from_noncontig(paddr_t buf_ptr __unused, size_t size __unused,
 			      uint64_t shm_ref __unused,
-			      bool map_buffer __unused)
+			      bool map_buffer __unused, uint32_t cattr __unused)
 {
 	return NULL;
 }
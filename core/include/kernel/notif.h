@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __KERNEL_NOTIF_H
+#define __KERNEL_NOTIF_H
+
+#include <compiler.h>
+#include <types_ext.h>
+
+/*
+ * Asynchronous notifications from secure world to normal world
+ *
+ * A notification value is made pending with notif_send_async() which
+ * also raises the notification interrupt CFG_CORE_ASYNC_NOTIF_GIC_INTID.
+ * The interrupt handler in normal world retrieves the pending values one
+ * at a time with the fast call OPTEE_SMC_GET_ASYNC_NOTIF_VALUE.
+ *
+ * Value 0 is reserved, value NOTIF_VALUE_DO_WORK asks normal world to
+ * lend a thread with OPTEE_MSG_CMD_DO_WORK, values NOTIF_VALUE_DO_WORK + 1
+ * to NOTIF_ASYNC_VALUE_MAX can be used.
+ *
+ * If normal world has set OPTEE_SMC_NSEC_CAP_WQ_ASYNC_NOTIF, value
+ * NOTIF_VALUE_WQ_BASE + n wakes the thread sleeping in a wait queue with
+ * the key NOTIF_VALUE_WQ_BASE + n, in place of an
+ * OPTEE_RPC_WAIT_QUEUE_WAKEUP request.
+ */
+#define NOTIF_VALUE_DO_WORK		1
+#define NOTIF_ASYNC_VALUE_MAX		63
+#define NOTIF_VALUE_WQ_BASE		(NOTIF_ASYNC_VALUE_MAX + 1)
+#define NOTIF_VALUE_MAX			(NOTIF_VALUE_WQ_BASE + \
+					 CFG_NUM_THREADS - 1)
+
+#ifdef CFG_CORE_ASYNC_NOTIF
+/* Makes @value pending and raises the notification interrupt */
+void notif_send_async(uint32_t value);
+
+/*
+ * Makes the @count values in @values pending and raises the notification
+ * interrupt once for all of them
+ */
+void notif_send_async_multi(const uint32_t *values, size_t count);
+
+/*
+ * Retrieves and clears one pending value. Returns false if no value was
+ * pending, else true with *@value set and *@more_pending true if further
+ * values are pending.
+ */
+bool notif_get_value(uint32_t *value, bool *more_pending);
+
+/* Sets whether wait queues are woken up with notifications */
+void notif_set_wq_wakeup(bool enable);
+
+/* Returns true if wait queues are woken up with notifications */
+bool notif_wq_wakeup_enabled(void);
+#else
+static inline void notif_send_async(uint32_t value __unused)
+{
+}
+
+static inline void notif_send_async_multi(const uint32_t *values __unused,
+					  size_t count __unused)
+{
+}
+
+static inline bool notif_get_value(uint32_t *value __unused,
+				   bool *more_pending __unused)
+{
+	return false;
+}
+
+static inline void notif_set_wq_wakeup(bool enable __unused)
+{
+}
+
+static inline bool notif_wq_wakeup_enabled(void)
+{
+	return false;
+}
+#endif
+
+#endif /*__KERNEL_NOTIF_H*/
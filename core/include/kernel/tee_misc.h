@@ -24,7 +24,8 @@ uint32_t tee_b2hs(uint8_t *b, uint8_t *hs, uint32_t blen, uint32_t hslen);
  * hex string to binary buffer
  * Returns the number of data bytes written to the bin buffer
  */
-uint32_t tee_hs2b(uint8_t *hs, uint8_t *b, uint32_t hslen, uint32_t blen);
+uint32_t tee_hs2b(const uint8_t *hs, uint8_t *b, uint32_t hslen,
+		  uint32_t blen);
 
 /*
  * Is buffer 'b' inside/outside/overlapping area 'a'?
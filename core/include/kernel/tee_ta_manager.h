@@ -13,6 +13,8 @@
 #include <utee_types.h>
 #include <kernel/tee_common.h>
 #include <kernel/mutex.h>
+#include <kernel/pmu.h>
+#include <kernel/tee_time.h>
 #include <tee_api_types.h>
 #include <user_ta_header.h>
 
@@ -23,6 +25,7 @@
 
 TAILQ_HEAD(tee_ta_session_head, tee_ta_session);
 TAILQ_HEAD(tee_ta_ctx_head, tee_ta_ctx);
+TAILQ_HEAD(tee_ta_busy_head, tee_ta_busy_waiter);
 
 struct mobj;
 
@@ -35,6 +38,7 @@ struct param_mem {
 	struct mobj *mobj;
 	size_t size;
 	size_t offs;
+	bool read_only;	/* Mapped read-only in a user TA */
 };
 
 struct tee_ta_param {
@@ -43,6 +47,7 @@ struct tee_ta_param {
 		struct param_val val;
 		struct param_mem mem;
 	} u[TEE_NUM_PARAMS];
+	uint8_t prio;	/* Priority class when waiting for a busy TA */
 };
 
 struct tee_ta_ctx;
@@ -81,17 +86,24 @@ struct tee_ta_ctx {
 	const struct tee_ta_ops *ops;
 	uint32_t flags;		/* TA_FLAGS from TA header */
 	TAILQ_ENTRY(tee_ta_ctx) link;
+	LIST_ENTRY(tee_ta_ctx) link_hash; /* Link in the UUID index */
 	uint32_t panicked;	/* True if TA has panicked, written from asm */
 	uint32_t panic_code;	/* Code supplied for panic */
 	uint32_t ref_count;	/* Reference counter for multi session TA */
 	bool busy;		/* Context is busy and cannot be entered */
 	bool initializing;	/* Context is initializing */
-	struct condvar busy_cv;	/* CV used when context is busy */
+	struct mutex busy_mutex; /* Protects busy and initializing */
+	struct condvar busy_cv;	/* CV used when context is initializing */
+	/* Threads waiting for the context, granted in order */
+	struct tee_ta_busy_head busy_waiters;
+	struct tee_time_ta_offs time_offs; /* Cached persistent time offset */
 };
 
 struct tee_ta_session {
 	TAILQ_ENTRY(tee_ta_session) link;
 	TAILQ_ENTRY(tee_ta_session) link_tsd;
+	LIST_ENTRY(tee_ta_session) link_hash; /* Link in the session index */
+	struct tee_ta_session_head *open_sessions; /* List holding session */
 	uint32_t id;		/* Session handle (0 is invalid) */
 	struct tee_ta_ctx *ctx;	/* TA context */
 	TEE_Identity clnt_id;	/* Identify of client */
@@ -110,6 +122,15 @@ struct tee_ta_session {
 #if defined(CFG_TA_FTRACE_SUPPORT)
 	struct ftrace_buf *fbuf; /* ftrace buffer */
 #endif
+#if defined(CFG_THREAD_RPC_STATS)
+	struct thread_rpc_stats *rpc_stats; /* RPC statistics */
+#endif
+#if defined(CFG_TA_PMU_STATS)
+	struct pmu_stats pmu_stats; /* PMU counts in user mode */
+#endif
+#if defined(CFG_THREAD_QUANTUM)
+	uint64_t run_ticks;	/* Time run in secure world */
+#endif
 };
 
 /* Registered contexts */
@@ -117,6 +138,9 @@ extern struct tee_ta_ctx_head tee_ctxes;
 
 extern struct mutex tee_ta_mutex;
 
+/* Registers @ctx in tee_ctxes, must be called with tee_ta_mutex held */
+void tee_ta_link_ctx(struct tee_ta_ctx *ctx);
+
 TEE_Result tee_ta_open_session(TEE_ErrorOrigin *err,
 			       struct tee_ta_session **sess,
 			       struct tee_ta_session_head *open_sessions,
@@ -163,15 +187,28 @@ struct tee_ta_session *tee_ta_get_session(uint32_t id, bool exclusive,
 
 void tee_ta_put_session(struct tee_ta_session *sess);
 
-#if defined(CFG_TA_GPROF_SUPPORT)
+#if defined(CFG_TA_GPROF_SUPPORT) || defined(CFG_TA_PMU_STATS)
 void tee_ta_update_session_utime_suspend(void);
 void tee_ta_update_session_utime_resume(void);
-void tee_ta_gprof_sample_pc(vaddr_t pc);
 #else
 static inline void tee_ta_update_session_utime_suspend(void) {}
 static inline void tee_ta_update_session_utime_resume(void) {}
+#endif
+#if defined(CFG_TA_GPROF_SUPPORT)
+void tee_ta_gprof_sample_pc(vaddr_t pc);
+#else
 static inline void tee_ta_gprof_sample_pc(vaddr_t pc __unused) {}
 #endif
+#if defined(CFG_TA_PMU_STATS)
+/*
+ * Stops the PMU counting of the current session, used when user mode is
+ * left without tee_ta_update_session_utime_suspend(), for instance due
+ * to an abort.
+ */
+void tee_ta_pmu_stop(void);
+#else
+static inline void tee_ta_pmu_stop(void) {}
+#endif
 #if defined(CFG_TA_FTRACE_SUPPORT)
 void tee_ta_ftrace_update_times_suspend(void);
 void tee_ta_ftrace_update_times_resume(void);
@@ -8,13 +8,36 @@
 
 #include "tee_api_types.h"
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #define TEE_TIME_BOOT_TICKS_HZ  10UL
 
+/*
+ * struct tee_time_ta_offs - Cached persistent time offset of a TA
+ * @offs:	Offset from system time
+ * @positive:	True if @offs is added to system time
+ * @gen:	Generation of the offsets the cache was filled from, 0 if
+ *		not filled
+ *
+ * Kept in the TA context so the offset isn't looked up by UUID each time
+ * the persistent time is read. Zero initialized.
+ */
+struct tee_time_ta_offs {
+	TEE_Time offs;
+	bool positive;
+	uint32_t gen;
+};
+
 TEE_Result tee_time_get_sys_time(TEE_Time *time);
 uint32_t tee_time_get_sys_time_protection_level(void);
-TEE_Result tee_time_get_ta_time(const TEE_UUID *uuid, TEE_Time *time);
+/* @cache is optional, it's filled or used to skip the lookup of @uuid */
+TEE_Result tee_time_get_ta_time(const TEE_UUID *uuid,
+				struct tee_time_ta_offs *cache, TEE_Time *time);
 TEE_Result tee_time_get_ree_time(TEE_Time *time);
-TEE_Result tee_time_set_ta_time(const TEE_UUID *uuid, const TEE_Time *time);
+TEE_Result tee_time_set_ta_time(const TEE_UUID *uuid,
+				struct tee_time_ta_offs *cache,
+				const TEE_Time *time);
 /* Releases CPU through OP-TEE RPC which switches to Normal World */
 void tee_time_wait(uint32_t milliseconds_delay);
 /* Busy wait */
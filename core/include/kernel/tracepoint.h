@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+#ifndef __KERNEL_TRACEPOINT_H
+#define __KERNEL_TRACEPOINT_H
+
+#include <compiler.h>
+#include <pta_trace.h>
+#include <scattered_array.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Static tracepoints logging timestamped events to per-CPU rings shared
+ * with normal world, controlled with the trace pseudo TA.
+ *
+ * Each tracepoint is described by a struct tracepoint in the
+ * "tracepoints" scattered array, its index in the array is the event ID
+ * reported in the records. Tracepoints are enabled per category, a
+ * disabled tracepoint costs a load and a test.
+ */
+
+struct tracepoint {
+	const char *name;
+	uint32_t category;
+};
+
+#ifdef CFG_CORE_TRACEPOINTS
+extern uint32_t tracepoint_categories;
+
+void tracepoint_log(const struct tracepoint *tp, uint64_t arg0,
+		    uint64_t arg1);
+
+/* Returns the size of a trace buffer with @num_recs records per CPU */
+size_t tracepoint_get_buf_size(size_t num_recs);
+
+/*
+ * tracepoint_set_buf() - Initialize and start using the trace buffer
+ * @buf:	Buffer of tracepoint_get_buf_size(@num_recs) bytes
+ * @num_recs:	Number of records per CPU, a power of two
+ *
+ * The buffer can only be set once.
+ */
+void tracepoint_set_buf(void *buf, size_t num_recs);
+
+/*
+ * TRACEPOINT() - Log an event if its category is enabled
+ * @cat:	One of PTA_TRACE_CAT_*
+ * @ev_name:	Name of the event, a string literal
+ * @arg0:	First event specific argument
+ * @arg1:	Second event specific argument
+ */
+#define TRACEPOINT(cat, ev_name, arg0, arg1) do { \
+		SCATTERED_ARRAY_DEFINE_NAMED_PG_ITEM(tracepoints, \
+						     __tracepoint, \
+						     struct tracepoint) = { \
+			.name = (ev_name), .category = (cat), \
+		}; \
+		\
+		if (tracepoint_categories & (cat)) \
+			tracepoint_log(&__tracepoint, (arg0), (arg1)); \
+	} while (0)
+#else
+#define TRACEPOINT(cat, ev_name, arg0, arg1) do { \
+		(void)(arg0); \
+		(void)(arg1); \
+	} while (0)
+#endif
+
+#endif /*__KERNEL_TRACEPOINT_H*/
@@ -7,6 +7,7 @@
 
 #include <tee_api_types.h>
 
+struct mobj;
 struct user_ta_store_handle;
 struct user_ta_store_ops {
 	/*
@@ -45,6 +46,17 @@ struct user_ta_store_ops {
 	 */
 	TEE_Result (*read)(struct user_ta_store_handle *h, void *data,
 			   size_t len);
+	/*
+	 * Optional. If the @num_bytes bytes at the page aligned offset @offs
+	 * of the TA are stored uncompressed in memory which can be mapped
+	 * read-only into the TA, return in @mobj and @mobj_offs where they
+	 * are, else TEE_ERROR_NOT_SUPPORTED. The memory up to the next page
+	 * boundary after the @num_bytes bytes must not hold anything else
+	 * than the TA. Does not change the offset of read().
+	 */
+	TEE_Result (*get_mobj)(const struct user_ta_store_handle *h,
+			       size_t offs, size_t num_bytes,
+			       struct mobj **mobj, size_t *mobj_offs);
 	/*
 	 * Close a TA handle. Do nothing if @h == NULL.
 	 */
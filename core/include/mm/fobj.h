@@ -63,7 +63,9 @@ struct fobj *fobj_locked_paged_alloc(unsigned int num_pages);
  * @num_pages:	Number of pages covered
  *
  * This object supports both load and saving of pages. Pages are zero
- * initialized the first time they are loaded.
+ * initialized the first time they are loaded. With
+ * CFG_PAGER_RWP_COMPRESS=y saved pages are kept compressed in a store
+ * shared by all such objects instead of in storage reserved here.
  *
  * Returns a valid pointer on success or NULL on failure.
  */
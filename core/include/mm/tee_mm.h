@@ -16,22 +16,38 @@
 /* Flag to indicate that pool should use nex_malloc instead of malloc */
 #define TEE_MM_POOL_NEX_MALLOC             (1u << 1)
 
+/*
+ * The entries of a pool are kept in a treap ordered in allocation order,
+ * that is by ascending offset or by descending offset with
+ * TEE_MM_POOL_HI_ALLOC. Each entry also describes its subtree with
+ * positions counted in allocation order from the start of the pool:
+ * where the first entry starts, where the last entry ends and the largest
+ * gap between two entries. This lets allocation and lookup find their
+ * entry in O(log n).
+ */
 struct _tee_mm_entry_t {
 	struct _tee_mm_pool_t *pool;
-	struct _tee_mm_entry_t *next;
+	struct _tee_mm_entry_t *left;
+	struct _tee_mm_entry_t *right;
 	uint32_t offset;	/* offset in pages/sections */
 	uint32_t size;		/* size in pages/sections */
+	uint32_t prio;		/* treap priority */
+	uint32_t first;		/* start of first entry in subtree */
+	uint32_t last;		/* end of last entry in subtree */
+	uint32_t max_gap;	/* largest gap between entries in subtree */
 };
 typedef struct _tee_mm_entry_t tee_mm_entry_t;
 
 struct _tee_mm_pool_t {
-	tee_mm_entry_t *entry;
+	tee_mm_entry_t *root;	/* treap of allocated entries */
 	paddr_t lo;		/* low boundary of the pool */
 	paddr_t hi;		/* high boundary of the pool */
 	uint32_t flags;		/* Config flags for the pool */
+	uint32_t seed;		/* priority generator, non-zero once init */
 	uint8_t shift;		/* size shift */
 	unsigned int lock;
 #ifdef CFG_WITH_STATS
+	size_t allocated;	/* in pages/sections */
 	size_t max_allocated;
 #endif
 };
@@ -27,12 +27,20 @@
 
 #define TEE_MATTR_GLOBAL		BIT(10)
 #define TEE_MATTR_SECURE		BIT(11)
+/*
+ * The entry is part of a naturally aligned group of entries mapping
+ * contiguous physical memory with identical attributes, used to set the
+ * contiguous hint with LPAE. Only set when mapping, never reported back.
+ */
+#define TEE_MATTR_CONTIG		BIT(15)
 
 #define TEE_MATTR_CACHE_MASK	0x7
 #define TEE_MATTR_CACHE_SHIFT	12
 /* These are shifted TEE_MATTR_CACHE_SHIFT */
 #define TEE_MATTR_CACHE_NONCACHE 0
 #define TEE_MATTR_CACHE_CACHED	1
+/* Normal memory, not cacheable but writes may be buffered and combined */
+#define TEE_MATTR_CACHE_WC	2
 
 /*
  * Tags TA mappings which are only used during a single call (open session
@@ -89,8 +97,22 @@ struct vm_region {
 
 TAILQ_HEAD(vm_region_head, vm_region);
 
+/*
+ * @param_cache holds the regions of the parameters of the last invoke
+ * after they've been unmapped. The regions are reused, with the same
+ * virtual address if it's still free, if the next invoke passes the same
+ * buffers.
+ *
+ * @regions_by_va holds the @num_regions regions of @regions in the same
+ * order, sorted by virtual address, to look up the region of an address
+ * with a binary search. @max_regions is the number of allocated entries.
+ */
 struct vm_info {
 	struct vm_region_head regions;
+	struct vm_region_head param_cache;
+	struct vm_region **regions_by_va;
+	size_t num_regions;
+	size_t max_regions;
 	unsigned int asid;
 };
 
@@ -78,6 +78,16 @@
 #define OPTEE_MSG_ATTR_CACHE_MASK		GENMASK_32(2, 0)
 #define OPTEE_MSG_ATTR_CACHE_PREDEFINED		0
 
+/*
+ * Priority class of an open session or invoke command request, used when
+ * the request has to wait for a busy TA. Requests of a higher class are
+ * granted the TA before those of a lower class, requests of the same
+ * class in arrival order. The highest class found in the parameters of a
+ * request applies, 0 is the default.
+ */
+#define OPTEE_MSG_ATTR_PRIO_SHIFT		19
+#define OPTEE_MSG_ATTR_PRIO_MASK		GENMASK_32(1, 0)
+
 /*
  * Same values as TEE_LOGIN_* from TEE Internal API
  */
@@ -292,6 +302,10 @@ struct optee_msg_arg {
  * [in] param[0].u.tmem.buf_ptr		physical address (of first fragment)
  * [in] param[0].u.tmem.size		size (of first fragment)
  * [in] param[0].u.tmem.shm_ref		holds shared memory reference
+ * The cache attributes normal world maps the memory with may be passed in
+ * the OPTEE_MSG_ATTR_CACHE_* bits of param[0].attr, the memory is then
+ * mapped the same way in secure world. OPTEE_MSG_ATTR_CACHE_PREDEFINED
+ * means cached.
  *
  * OPTEE_MSG_CMD_UNREGISTER_SHM unregisteres a previously registered shared
  * memory reference. The information is passed as:
@@ -299,6 +313,105 @@ struct optee_msg_arg {
  * [in] param[0].u.rmem.shm_ref		holds shared memory reference
  * [in] param[0].u.rmem.offs		0
  * [in] param[0].u.rmem.size		0
+ *
+ * OPTEE_MSG_CMD_REGISTER_SHM_BATCH registers struct optee_msg_arg::num_params
+ * shared memory references in one call. Each parameter describes one
+ * buffer as param[0] of OPTEE_MSG_CMD_REGISTER_SHM, the buffer is named
+ * by its u.tmem.shm_ref. If one buffer can't be registered none of them
+ * are.
+ *
+ * OPTEE_MSG_CMD_UNREGISTER_SHM_BATCH unregisters
+ * struct optee_msg_arg::num_params previously registered shared memory
+ * references in one call. Each parameter names one buffer as param[0] of
+ * OPTEE_MSG_CMD_UNREGISTER_SHM. All buffers that can be unregistered are,
+ * ret is the error of the first one that can't.
+ *
+ * Support for the batched commands is reported with
+ * OPTEE_SMC_SEC_CAP_BATCH_SHM.
+ *
+ * OPTEE_MSG_CMD_INVOKE_BATCH invokes a number of commands on previously
+ * opened sessions, possibly to different Trusted Applications, in one
+ * call. The commands are executed in order on the same thread and their
+ * results are returned once all of them have completed.
+ * struct optee_msg_arg::func holds the number of sub commands, the sub
+ * commands are stored back to back in the memory normally holding the
+ * parameters of the batch command, struct optee_msg_arg::num_params
+ * giving the size of that memory in units of struct optee_msg_param.
+ * Each sub command is a struct optee_msg_arg with cmd set to
+ * OPTEE_MSG_CMD_INVOKE_COMMAND followed by its own parameters, that is
+ * it occupies OPTEE_MSG_GET_ARG_SIZE(num_params) bytes. Each sub command
+ * has its own ret and ret_origin updated as if it had been invoked
+ * separately. If a malformed sub command is found the ret of the batch
+ * command is set to TEE_ERROR_BAD_PARAMETERS and the sub commands from
+ * there on are left unmodified.
+ * Support for this command is reported with
+ * OPTEE_SMC_SEC_CAP_BATCH_INVOKE.
+ *
+ * OPTEE_MSG_CMD_INVOKE_ASYNC queues an invoke of a command on a
+ * previously opened session and returns immediately. The arguments are
+ * the same as for OPTEE_MSG_CMD_INVOKE_COMMAND, on success
+ * struct optee_msg_arg::cancel_id is updated with a ticket identifying
+ * the queued command. Memory referenced by the parameters must stay
+ * valid until the result has been retrieved.
+ *
+ * OPTEE_MSG_CMD_DO_ASYNC executes one queued asynchronous command on the
+ * calling thread. struct optee_msg_arg::cancel_id is updated with the
+ * ticket of the executed command, ret is TEE_ERROR_ITEM_NOT_FOUND if no
+ * command was queued. When the command has completed its ticket is
+ * posted as an asynchronous notification value, see
+ * OPTEE_SMC_GET_ASYNC_NOTIF_VALUE.
+ *
+ * OPTEE_MSG_CMD_GET_ASYNC_RESULT retrieves the result of a completed
+ * asynchronous command and releases its ticket. The ticket is passed in
+ * struct optee_msg_arg::cancel_id and num_params must be the same as
+ * when the command was queued. On success, the result of the command is
+ * returned in ret, ret_origin and the parameters as for
+ * OPTEE_MSG_CMD_INVOKE_COMMAND. ret is TEE_ERROR_BUSY if the command
+ * hasn't completed yet. Queued commands which haven't started are dropped
+ * when their session is closed, and results not retrieved within a
+ * configured time are discarded, the ticket is then unknown.
+ *
+ * Support for the asynchronous commands is reported with
+ * OPTEE_SMC_SEC_CAP_ASYNC_NOTIF.
+ *
+ * OPTEE_MSG_CMD_DO_WORK lends the calling thread to secure world to run
+ * deferred work queued in secure world, the call returns when no more
+ * work is queued. num_params must be 0. If secure world can notify normal
+ * world asynchronously it posts the notification value 1 when work is
+ * queued once normal world has issued this command, until then the
+ * queued work is run at the end of other standard calls. Support for
+ * this command is reported with OPTEE_SMC_SEC_CAP_WORK_QUEUE.
+ *
+ * OPTEE_MSG_CMD_SDP_ALLOC allocates a physically contiguous buffer from
+ * the Secure Data Path memory, named by a cookie supplied by normal world.
+ * [in/out] param[0].attr		OPTEE_MSG_ATTR_TYPE_VALUE_INOUT
+ * [in] param[0].u.value.a		Requested size
+ * [in] param[0].u.value.b		Cookie, must not name registered
+ *					shared memory or another SDP buffer
+ * [out] param[0].u.value.a		Physical address of the buffer
+ * [out] param[0].u.value.b		Allocated size
+ * The buffer is passed to TAs as a OPTEE_MSG_ATTR_TYPE_RMEM_* parameter
+ * with u.rmem.shm_ref set to the cookie.
+ *
+ * OPTEE_MSG_CMD_SDP_FREE releases a buffer allocated with
+ * OPTEE_MSG_CMD_SDP_ALLOC, the memory is reused once no TA invocation
+ * references it any longer.
+ * [in] param[0].attr			OPTEE_MSG_ATTR_TYPE_VALUE_INPUT
+ * [in] param[0].u.value.a		Cookie
+ * Support for these commands is reported with OPTEE_SMC_SEC_CAP_SDP_POOL.
+ *
+ * OPTEE_MSG_CMD_SET_TELEMETRY sets the buffer secure world updates
+ * struct optee_msg_telemetry in, normal world can then read the
+ * statistics in it at any time without a call to secure world.
+ * [in] param[0].attr			OPTEE_MSG_ATTR_TYPE_RMEM_INOUT
+ * [in] param[0].u.rmem.shm_ref		registered shared memory reference
+ * [in] param[0].u.rmem.offs		offset, 8 bytes aligned
+ * [in/out] param[0].u.rmem.size	size of the buffer, updated with
+ *					the size needed if ret is
+ *					TEE_ERROR_SHORT_BUFFER
+ * The buffer must stay registered until the command has been issued
+ * again without parameters, which stops the updates. Support for this
+ * command is reported with OPTEE_SMC_SEC_CAP_TELEMETRY.
  */
 #define OPTEE_MSG_CMD_OPEN_SESSION	0
 #define OPTEE_MSG_CMD_INVOKE_COMMAND	1
@@ -306,6 +419,72 @@ struct optee_msg_arg {
 #define OPTEE_MSG_CMD_CANCEL		3
 #define OPTEE_MSG_CMD_REGISTER_SHM	4
 #define OPTEE_MSG_CMD_UNREGISTER_SHM	5
+#define OPTEE_MSG_CMD_INVOKE_BATCH	6
+#define OPTEE_MSG_CMD_INVOKE_ASYNC	7
+#define OPTEE_MSG_CMD_DO_ASYNC		8
+#define OPTEE_MSG_CMD_GET_ASYNC_RESULT	9
+#define OPTEE_MSG_CMD_DO_WORK		10
+#define OPTEE_MSG_CMD_SDP_ALLOC		11
+#define OPTEE_MSG_CMD_SDP_FREE		12
+#define OPTEE_MSG_CMD_REGISTER_SHM_BATCH	13
+#define OPTEE_MSG_CMD_UNREGISTER_SHM_BATCH	14
+#define OPTEE_MSG_CMD_SET_TELEMETRY	15
 #define OPTEE_MSG_FUNCID_CALL_WITH_ARG	0x0004
 
+#ifndef __ASSEMBLER__
+/*
+ * struct optee_msg_telemetry_core - Statistics of one core
+ * @busy_ticks:		Time spent running threads in secure world, in ticks
+ *			of the counter of frequency
+ *			struct optee_msg_telemetry::cntfrq
+ * @std_calls:		Number of standard calls started on the core
+ */
+struct optee_msg_telemetry_core {
+	uint64_t busy_ticks;
+	uint64_t std_calls;
+};
+
+/*
+ * struct optee_msg_telemetry - Statistics updated by secure world in the
+ * buffer set with OPTEE_MSG_CMD_SET_TELEMETRY
+ * @seq:		Odd while secure world updates the buffer, a reader
+ *			retries if it's odd or has changed after reading
+ * @num_cores:		Number of elements in @core
+ * @timestamp:		Counter value at the last update
+ * @cntfrq:		Counter frequency
+ * @num_threads:	Number of thread contexts
+ * @free_threads:	Thread contexts currently free
+ * @thread_limit_count:	Standard calls rejected with ETHREAD_LIMIT
+ * @heap_alloc_fails:	Failed heap allocations
+ * @heap_size:		Size of the heap
+ * @heap_allocated:	Bytes currently allocated from the heap
+ * @heap_max_allocated:	Highest number of bytes allocated from the heap
+ * @pager_npages:	Pages used by the pager
+ * @pager_loads:	Page faults which loaded a page
+ * @pager_hidden_hits:	Page faults on pages still in memory
+ * @rpc_count:		RPCs to normal world
+ * @storage_ops:	Secure storage operations sent to normal world
+ * @core:		Per core statistics
+ */
+struct optee_msg_telemetry {
+	uint32_t seq;
+	uint32_t num_cores;
+	uint64_t timestamp;
+	uint64_t cntfrq;
+	uint32_t num_threads;
+	uint32_t free_threads;
+	uint32_t thread_limit_count;
+	uint32_t heap_alloc_fails;
+	uint64_t heap_size;
+	uint64_t heap_allocated;
+	uint64_t heap_max_allocated;
+	uint64_t pager_npages;
+	uint64_t pager_loads;
+	uint64_t pager_hidden_hits;
+	uint64_t rpc_count;
+	uint64_t storage_ops;
+	struct optee_msg_telemetry_core core[];
+};
+#endif /*__ASSEMBLER__*/
+
 #endif /* _OPTEE_MSG_H */
@@ -252,6 +252,50 @@
  */
 #define OPTEE_RPC_FS_READDIR		10
 
+/*
+ * Read a list of extents from a file
+ *
+ * memref[1] is an array of value[0].c extents, each extent is a pair of
+ * uint64_t holding the offset into the file and the length of the extent.
+ * The data of the extents is returned back to back in memref[2] in the
+ * order of the array. The size of memref[2] is updated with the number of
+ * bytes up to the end of the data of the last extent read in full.
+ *
+ * [in]     value[0].a	    OPTEE_RPC_FS_READV
+ * [in]     value[0].b	    File descriptor of open file
+ * [in]     value[0].c	    Number of extents
+ * [in]     memref[1]	    Array of extents
+ * [out]    memref[2]	    Buffer to hold returned data
+ */
+#define OPTEE_RPC_FS_READV		11
+
+/*
+ * Write a list of extents to a file
+ *
+ * memref[1] is an array of extents as for OPTEE_RPC_FS_READV, the data of
+ * the extents is stored back to back in memref[2] in the order of the
+ * array.
+ *
+ * [in]     value[0].a	    OPTEE_RPC_FS_WRITEV
+ * [in]     value[0].b	    File descriptor of open file
+ * [in]     value[0].c	    Number of extents
+ * [in]     memref[1]	    Array of extents
+ * [in]     memref[2]	    Buffer holding data to be written
+ */
+#define OPTEE_RPC_FS_WRITEV		12
+
+/*
+ * Get the optional features of the file system implemented by normal
+ * world. Normal world not knowing this request fails it, which means
+ * that none of the features are supported.
+ *
+ * [in]     value[0].a	    OPTEE_RPC_FS_GET_CAPS
+ * [out]    value[1].a	    Bitfield of OPTEE_RPC_FS_CAP_*
+ */
+#define OPTEE_RPC_FS_GET_CAPS		13
+/* OPTEE_RPC_FS_READV and OPTEE_RPC_FS_WRITEV are supported */
+#define OPTEE_RPC_FS_CAP_VEC_OPS	(1 << 0)
+
 /* End of definition of protocol for command OPTEE_RPC_CMD_FS */
 
 /*
@@ -5,8 +5,20 @@
 #ifndef __RNG_SUPPORT_H__
 #define __RNG_SUPPORT_H__
 
+#include <stddef.h>
 #include <stdint.h>
+#include <tee_api_types.h>
 
 uint8_t hw_get_random_byte(void);
 
+/*
+ * hw_get_random_bytes() - Fill a buffer from the hardware RNG
+ * @buf:	Output buffer
+ * @len:	Number of bytes to generate
+ *
+ * The default implementation calls hw_get_random_byte() for each byte,
+ * drivers able to produce larger blocks at once override it.
+ */
+TEE_Result hw_get_random_bytes(void *buf, size_t len);
+
 #endif /* __RNG_SUPPORT_H__ */
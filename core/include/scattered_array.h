@@ -77,6 +77,18 @@
 #define SCATTERED_ARRAY_DEFINE_PG_ITEM(array_name, element_type) \
 	__SCT_ARRAY_DEF_PG_ITEM1(array_name, 0, __COUNTER__, element_type)
 
+/*
+ * Same as SCATTERED_ARRAY_DEFINE_PG_ITEM except that the item is named
+ * @element_name, it can then be defined in a function and be referenced.
+ * @array_name:   Name of the scattered array
+ * @element_name: Name of the item
+ * @element_type: The type of the elemenet
+ */
+#define SCATTERED_ARRAY_DEFINE_NAMED_PG_ITEM(array_name, element_name, \
+					     element_type) \
+	__SCT_ARRAY_DEF_PG_ITEM3(element_type, element_name, \
+				 ".scattered_array_" #array_name "_1_0")
+
 /*
  * Returns the first element in a scattered array
  * @array_name:   Name of the scattered array
@@ -19,13 +19,18 @@ enum spi_result {
 	SPI_OK,
 	SPI_ERR_CFG,
 	SPI_ERR_PKTCNT,
-	SPI_ERR_GENERIC
+	SPI_ERR_GENERIC,
+	SPI_ERR_BUSY
 };
 
 struct spi_chip {
 	const struct spi_ops *ops;
 };
 
+/* Completion of an asynchronous transfer, called in interrupt context */
+typedef void (*spi_done_cb)(struct spi_chip *chip, enum spi_result res,
+			    void *data);
+
 struct spi_ops {
 	void (*configure)(struct spi_chip *chip);
 	void (*start)(struct spi_chip *chip);
@@ -34,6 +39,16 @@ struct spi_ops {
 	enum spi_result (*txrx16)(struct spi_chip *chip, uint16_t *wdat,
 		uint16_t *rdat, size_t num_pkts);
 	void (*end)(struct spi_chip *chip);
+	/*
+	 * Optional, start a transfer and return without waiting for it,
+	 * @done is called once the transfer is completed. @wdat and @rdat
+	 * must remain valid until then. Returns SPI_ERR_BUSY if a transfer
+	 * is already in progress.
+	 */
+	enum spi_result (*txrx8_async)(struct spi_chip *chip, uint8_t *wdat,
+		uint8_t *rdat, size_t num_pkts, spi_done_cb done, void *data);
+	enum spi_result (*txrx16_async)(struct spi_chip *chip, uint16_t *wdat,
+		uint16_t *rdat, size_t num_pkts, spi_done_cb done, void *data);
 };
 
 #endif	/* __SPI_H__ */
@@ -16,11 +16,14 @@ struct tee_fs_dirfile_dirh;
  * @file_number:	sequence number of a file
  * @hash:		hash of file, to be supplied to tee_fs_htree_open()
  * @idx:		index of the file handle in the dirfile
+ * @is_inline:		the content is stored in the dirfile entry, there's
+ *			no file and @file_number and @hash are unused
  */
 struct tee_fs_dirfile_fileh {
 	uint32_t file_number;
 	uint8_t hash[TEE_FS_HTREE_HASH_SIZE];
 	int idx;
+	bool is_inline;
 };
 
 /**
@@ -83,6 +86,25 @@ TEE_Result tee_fs_dirfile_commit_writes(struct tee_fs_dirfile_dirh *dirh,
 TEE_Result tee_fs_dirfile_get_tmp(struct tee_fs_dirfile_dirh *dirh,
 				  struct tee_fs_dirfile_fileh *dfh);
 
+/**
+ * tee_fs_dirfile_hold_file() - keep a file number from being reused
+ * @dirh:	dirfile handle
+ * @file_number: file number
+ *
+ * Used for the file of a removed or replaced file handle as long as the
+ * committed dirfile may still refer to it.
+ */
+TEE_Result tee_fs_dirfile_hold_file(struct tee_fs_dirfile_dirh *dirh,
+				    uint32_t file_number);
+
+/**
+ * tee_fs_dirfile_release_file() - release a file number
+ * @dirh:	dirfile handle
+ * @file_number: file number held with tee_fs_dirfile_hold_file()
+ */
+void tee_fs_dirfile_release_file(struct tee_fs_dirfile_dirh *dirh,
+				 uint32_t file_number);
+
 /**
  * tee_fs_dirfile_find() - find a file handle
  * @dirh:	dirfile handle
@@ -132,10 +154,82 @@ TEE_Result tee_fs_dirfile_remove(struct tee_fs_dirfile_dirh *dirh,
  * tee_fs_dirfile_update_hash() - update hash of file handle
  * @dirh:	filefile handle
  * @dfh:	file handle
+ *
+ * The file number is updated too, an entry with inline content is turned
+ * into an entry referring to the file in @dfh.
  */
 TEE_Result tee_fs_dirfile_update_hash(struct tee_fs_dirfile_dirh *dirh,
 				      const struct tee_fs_dirfile_fileh *dfh);
 
+#if CFG_REE_FS_INLINE_SIZE
+/**
+ * tee_fs_dirfile_set_inline() - supplies object id and inline content
+ * @dirh:	dirfile handle
+ * @uuid:	uuid of requesting TA
+ * @dfh:	file handle, as for tee_fs_dirfile_rename()
+ * @oid:	object id
+ * @oidlen:	length of object id
+ * @data:	content of the object
+ * @len:	length of @data, at most CFG_REE_FS_INLINE_SIZE
+ *
+ * The content is stored in the dirfile entry instead of in a file of its
+ * own, @dfh->is_inline is set.
+ */
+TEE_Result tee_fs_dirfile_set_inline(struct tee_fs_dirfile_dirh *dirh,
+				     const TEE_UUID *uuid,
+				     struct tee_fs_dirfile_fileh *dfh,
+				     const void *oid, size_t oidlen,
+				     const void *data, size_t len);
+
+/**
+ * tee_fs_dirfile_update_inline() - update inline content of file handle
+ * @dirh:	dirfile handle
+ * @dfh:	file handle with @dfh->is_inline set
+ * @data:	content of the object
+ * @len:	length of @data, at most CFG_REE_FS_INLINE_SIZE
+ */
+TEE_Result tee_fs_dirfile_update_inline(struct tee_fs_dirfile_dirh *dirh,
+					const struct tee_fs_dirfile_fileh *dfh,
+					const void *data, size_t len);
+
+/**
+ * tee_fs_dirfile_read_inline() - read inline content of file handle
+ * @dirh:	dirfile handle
+ * @dfh:	file handle with @dfh->is_inline set
+ * @data:	buffer of CFG_REE_FS_INLINE_SIZE bytes
+ * @len:	returned length of the content
+ */
+TEE_Result tee_fs_dirfile_read_inline(struct tee_fs_dirfile_dirh *dirh,
+				      const struct tee_fs_dirfile_fileh *dfh,
+				      void *data, size_t *len);
+#else
+static inline TEE_Result
+tee_fs_dirfile_set_inline(struct tee_fs_dirfile_dirh *dirh __unused,
+			  const TEE_UUID *uuid __unused,
+			  struct tee_fs_dirfile_fileh *dfh __unused,
+			  const void *oid __unused, size_t oidlen __unused,
+			  const void *data __unused, size_t len __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline TEE_Result
+tee_fs_dirfile_update_inline(struct tee_fs_dirfile_dirh *dirh __unused,
+			     const struct tee_fs_dirfile_fileh *dfh __unused,
+			     const void *data __unused, size_t len __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline TEE_Result
+tee_fs_dirfile_read_inline(struct tee_fs_dirfile_dirh *dirh __unused,
+			   const struct tee_fs_dirfile_fileh *dfh __unused,
+			   void *data __unused, size_t *len __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
 /**
  * tee_fs_dirfile_get_next() - get object id of next file
  * @dirh:	dirfile handle
@@ -70,6 +70,20 @@ enum tee_fs_htree_type {
 
 struct tee_fs_rpc_operation;
 
+/**
+ * struct tee_fs_htree_elem - element of a vectored RPC operation
+ * @type:	type of the element
+ * @idx:	index of the element
+ * @vers:	version of the element
+ * @data:	returned pointer to the element in non-secure shared memory
+ */
+struct tee_fs_htree_elem {
+	enum tee_fs_htree_type type;
+	size_t idx;
+	uint8_t vers;
+	void *data;
+};
+
 /**
  * struct tee_fs_htree_storage - storage description supplied by user of
  * this interface
@@ -78,6 +92,21 @@ struct tee_fs_rpc_operation;
  *			operation
  * @rpc_write_init:	initialize a struct tee_fs_rpc_operation for an RPC
  *			write operation
+ * @rpc_read_blocks_init: optional, initialize a struct tee_fs_rpc_operation
+ *			for a single RPC read of @num consecutive data blocks
+ *			starting at @idx, with versions supplied in @vers.
+ *			Returns a pointer to each block in @data and the
+ *			number of bytes the operation is expected to read
+ *			in @size.
+ * @rpc_readv_init:	optional, initialize a struct tee_fs_rpc_operation
+ *			to read all the @num elements in @elem with a single
+ *			RPC
+ * @rpc_writev_init:	optional, initialize a struct tee_fs_rpc_operation
+ *			to write all the @num elements in @elem with a single
+ *			RPC
+ *
+ * If a vectored final function returns TEE_ERROR_NOT_SUPPORTED the
+ * elements are transferred one by one instead.
  *
  * The @idx arguments starts counting from 0. The @vers arguments are either
  * 0 or 1. The @data arguments is a pointer to a buffer in non-secure shared
@@ -94,6 +123,22 @@ struct tee_fs_htree_storage {
 				     enum tee_fs_htree_type type, size_t idx,
 				     uint8_t vers, void **data);
 	TEE_Result (*rpc_write_final)(struct tee_fs_rpc_operation *op);
+	TEE_Result (*rpc_read_blocks_init)(void *aux,
+					   struct tee_fs_rpc_operation *op,
+					   size_t idx, size_t num,
+					   const uint8_t *vers, void **data,
+					   size_t *size);
+	TEE_Result (*rpc_readv_init)(void *aux,
+				     struct tee_fs_rpc_operation *op,
+				     struct tee_fs_htree_elem *elem,
+				     size_t num);
+	TEE_Result (*rpc_readv_final)(struct tee_fs_rpc_operation *op,
+				      size_t *bytes);
+	TEE_Result (*rpc_writev_init)(void *aux,
+				      struct tee_fs_rpc_operation *op,
+				      struct tee_fs_htree_elem *elem,
+				      size_t num);
+	TEE_Result (*rpc_writev_final)(struct tee_fs_rpc_operation *op);
 };
 
 struct tee_fs_htree;
@@ -130,6 +175,12 @@ struct tee_fs_htree_meta *tee_fs_htree_get_meta(struct tee_fs_htree *ht);
  */
 void tee_fs_htree_meta_set_dirty(struct tee_fs_htree *ht);
 
+/**
+ * tee_fs_htree_is_dirty() - check for changes not yet synced to storage
+ * @ht:		hash tree
+ */
+bool tee_fs_htree_is_dirty(struct tee_fs_htree *ht);
+
 /**
  * tee_fs_htree_sync_to_storage() - synchronize hash tree to storage
  * @ht:		hash tree
@@ -170,4 +221,19 @@ TEE_Result tee_fs_htree_write_block(struct tee_fs_htree **ht, size_t block_num,
 TEE_Result tee_fs_htree_read_block(struct tee_fs_htree **ht, size_t block_num,
 				   void *block);
 
+/**
+ * tee_fs_htree_read_blocks() - read and decrypt consecutive data blocks
+ * @ht:		hash tree
+ * @block_num:	number of the first block
+ * @num:	number of blocks to read
+ * @blocks:	array of @num pointers to blocks of stor->block_size size
+ *
+ * The blocks are fetched with a single RPC if stor->rpc_read_blocks_init
+ * is supplied, else one block at a time.
+ *
+ * Frees the hash tree and sets *ht to NULL on failure and returns an error code
+ */
+TEE_Result tee_fs_htree_read_blocks(struct tee_fs_htree **ht, size_t block_num,
+				    size_t num, void **blocks);
+
 #endif /*__TEE_FS_HTREE_H*/
@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef TEE_CRYP_KEYPOOL_H
+#define TEE_CRYP_KEYPOOL_H
+
+#include <compiler.h>
+#include <crypto/crypto.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Pools of ECC and DH key pairs generated ahead of use
+ *
+ * A pool is created for each ECC curve and each DH group a key pair is
+ * asked for, the first request is a miss. Pools are filled with
+ * CFG_CORE_KEYGEN_POOL_DEPTH key pairs by deferred work, see
+ * <kernel/work_queue.h>, and refilled each time a key pair is taken.
+ * A key pair is handed out only once.
+ */
+#ifdef CFG_CORE_KEYGEN_POOL
+/*
+ * Fills in @key->d, @key->x and @key->y with a key pair for the curve
+ * @key->curve of @key_size bits. Returns false if the pool is empty.
+ */
+bool tee_cryp_keypool_get_ecc(struct ecc_keypair *key, size_t key_size);
+
+/*
+ * Fills in @key->x and @key->y with a key pair for the group @key->g,
+ * @key->p, @q and @xbits, with the meaning of crypto_acipher_gen_dh_key().
+ * Returns false if the pool is empty.
+ */
+bool tee_cryp_keypool_get_dh(struct dh_keypair *key, struct bignum *q,
+			     size_t xbits, size_t key_size);
+#else
+static inline bool tee_cryp_keypool_get_ecc(struct ecc_keypair *key __unused,
+					    size_t key_size __unused)
+{
+	return false;
+}
+
+static inline bool tee_cryp_keypool_get_dh(struct dh_keypair *key __unused,
+					   struct bignum *q __unused,
+					   size_t xbits __unused,
+					   size_t key_size __unused)
+{
+	return false;
+}
+#endif
+
+#endif /*TEE_CRYP_KEYPOOL_H*/
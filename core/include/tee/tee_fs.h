@@ -48,6 +48,14 @@ struct tee_file_operations {
 	TEE_Result (*opendir)(const TEE_UUID *uuid, struct tee_fs_dir **d);
 	TEE_Result (*readdir)(struct tee_fs_dir *d, struct tee_fs_dirent **ent);
 	void (*closedir)(struct tee_fs_dir *d);
+
+	/*
+	 * Optional, changes by create(), rename() and remove() until
+	 * end_transaction() are committed together. Changes made with
+	 * write() and truncate() commit the pending changes too.
+	 */
+	TEE_Result (*begin_transaction)(void);
+	TEE_Result (*end_transaction)(void);
 };
 
 #ifdef CFG_REE_FS
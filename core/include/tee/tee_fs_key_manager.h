@@ -18,10 +18,33 @@
 
 TEE_Result tee_fs_generate_fek(const TEE_UUID *uuid, void *encrypted_fek,
 			       size_t fek_size);
-TEE_Result tee_fs_crypt_block(const TEE_UUID *uuid, uint8_t *out,
+/*
+ * The decrypted FEK of a file with an AES-ECB context keyed for ESSIV and
+ * an AES-CBC context, kept by an open file so that the blocks of the file
+ * following each other don't have to decrypt the FEK and hash it again.
+ * Zero initialized, the users of the file handle serialize the accesses.
+ */
+struct tee_fs_fek_cache {
+	bool valid;
+	bool has_uuid;
+	TEE_UUID uuid;
+	uint8_t encrypted_fek[TEE_FS_KM_FEK_SIZE];
+	uint8_t fek[TEE_FS_KM_FEK_SIZE];
+	void *essiv_ctx;
+	void *cbc_ctx;
+};
+
+/*
+ * Encrypts or decrypts a block of file data, @cache is NULL or the cache
+ * of the file using @encrypted_fek.
+ */
+TEE_Result tee_fs_crypt_block(struct tee_fs_fek_cache *cache,
+			      const TEE_UUID *uuid, uint8_t *out,
 			      const uint8_t *in, size_t size,
 			      uint16_t blk_idx, const uint8_t *encrypted_fek,
 			      TEE_OperationMode mode);
+/* Wipes the key material in @cache, to be called when the file is closed */
+void tee_fs_fek_cache_wipe(struct tee_fs_fek_cache *cache);
 
 TEE_Result tee_fs_fek_crypt(const TEE_UUID *uuid, TEE_OperationMode mode,
 			    const uint8_t *in_key, size_t size,
@@ -44,6 +44,38 @@ TEE_Result tee_fs_rpc_write_init(struct tee_fs_rpc_operation *op,
 				 size_t data_len, void **data);
 TEE_Result tee_fs_rpc_write_final(struct tee_fs_rpc_operation *op);
 
+/*
+ * struct tee_fs_rpc_iov - one extent of a vectored read or write
+ * @offset:	offset into the file
+ * @len:	length of the extent
+ * @data:	returned pointer to the data of the extent in non-secure
+ *		shared memory
+ */
+struct tee_fs_rpc_iov {
+	tee_fs_off_t offset;
+	size_t len;
+	void *data;
+};
+
+/*
+ * Vectored versions of the read and write operations above, all the
+ * extents in @iov are transferred with a single RPC. The init functions
+ * return TEE_ERROR_NOT_SUPPORTED if normal world doesn't report
+ * OPTEE_RPC_FS_CAP_VEC_OPS with OPTEE_RPC_FS_GET_CAPS, queried by the
+ * first call. The caller is expected to fall back to one operation per
+ * extent.
+ */
+TEE_Result tee_fs_rpc_readv_init(struct tee_fs_rpc_operation *op,
+				 uint32_t id, int fd,
+				 struct tee_fs_rpc_iov *iov, size_t num);
+TEE_Result tee_fs_rpc_readv_final(struct tee_fs_rpc_operation *op,
+				  size_t *data_len);
+
+TEE_Result tee_fs_rpc_writev_init(struct tee_fs_rpc_operation *op,
+				  uint32_t id, int fd,
+				  struct tee_fs_rpc_iov *iov, size_t num);
+TEE_Result tee_fs_rpc_writev_final(struct tee_fs_rpc_operation *op);
+
 
 TEE_Result tee_fs_rpc_truncate(uint32_t id, int fd, size_t len);
 TEE_Result tee_fs_rpc_remove(uint32_t id, struct tee_pobj *po);
@@ -58,21 +90,36 @@ TEE_Result tee_fs_rpc_closedir(uint32_t id, struct tee_fs_dir *d);
 TEE_Result tee_fs_rpc_readdir(uint32_t id, struct tee_fs_dir *d,
 			      struct tee_fs_dirent **ent);
 
+struct tee_fs_rpc_cache_stats {
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t evictions;
+};
+
 struct thread_specific_data;
 #if defined(CFG_WITH_USER_TA) && (defined(CFG_REE_FS) || defined(CFG_RPMB_FS))
 /* Frees the cache of allocated FS RPC memory */
 void tee_fs_rpc_cache_clear(struct thread_specific_data *tsd);
+void tee_fs_rpc_cache_get_stats(struct tee_fs_rpc_cache_stats *stats);
 #else
 static inline void tee_fs_rpc_cache_clear(
 			struct thread_specific_data *tsd __unused)
 {
 }
+
+static inline void tee_fs_rpc_cache_get_stats(
+			struct tee_fs_rpc_cache_stats *stats)
+{
+	*stats = (struct tee_fs_rpc_cache_stats){ };
+}
 #endif
 
 /*
  * Returns a pointer to the cached FS RPC memory. Each thread has a unique
- * cache. The pointer is guaranteed to point to a large enough area or to
- * be NULL.
+ * cache of CFG_TEE_FS_RPC_CACHE_ENTRIES buffers of different sizes, the
+ * least recently used one is replaced when a larger buffer is needed. The
+ * pointer is guaranteed to point to a large enough area or to be NULL.
+ * The buffer stays valid at least until the next call of this function.
  */
 void *tee_fs_rpc_cache_alloc(size_t size, struct mobj **mobj);
 
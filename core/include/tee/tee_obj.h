@@ -12,20 +12,30 @@
 
 #define TEE_USAGE_DEFAULT   0xffffffff
 
+struct storage_async;
+
 struct tee_obj {
 	TAILQ_ENTRY(tee_obj) link;
+	uint32_t id;		/* handle of the object in the TA */
 	TEE_ObjectInfo info;
 	bool busy;		/* true if used by an operation */
 	uint32_t have_attrs;	/* bitfield identifying set properties */
+	uint32_t generation;	/* changed when the key may have changed */
 	void *attr;
 	size_t ds_pos;
 	struct tee_pobj *pobj;	/* ptr to persistant object */
 	struct tee_file_handle *fh;
 	uint32_t flags;		/* permission flags for persistent objects */
+	struct storage_async *async; /* pending asynchronous read or write */
 };
 
-void tee_obj_add(struct user_ta_ctx *utc, struct tee_obj *o);
+/*
+ * Registers @o in the context and assigns it a non-zero o->id, the handle
+ * the TA uses for the object.
+ */
+TEE_Result tee_obj_add(struct user_ta_ctx *utc, struct tee_obj *o);
 
+/* Looks up an object from its handle in constant time */
 TEE_Result tee_obj_get(struct user_ta_ctx *utc, uint32_t obj_id,
 		       struct tee_obj **obj);
 
@@ -43,6 +43,8 @@ TEE_Result syscall_hash_update(unsigned long state, const void *chunk,
 			size_t chunk_size);
 TEE_Result syscall_hash_final(unsigned long state, const void *chunk,
 			size_t chunk_size, void *hash, uint64_t *hash_len);
+TEE_Result syscall_hash_init_final(unsigned long state, const void *chunk,
+			size_t chunk_size, void *hash, uint64_t *hash_len);
 
 TEE_Result syscall_cipher_init(unsigned long state, const void *iv,
 			size_t iv_len);
@@ -51,6 +53,9 @@ TEE_Result syscall_cipher_update(unsigned long state, const void *src,
 TEE_Result syscall_cipher_final(unsigned long state, const void *src,
 			size_t src_len, void *dest, uint64_t *dest_len);
 
+TEE_Result syscall_cryp_update_vec(struct utee_cryp_update *updates,
+			size_t num_updates);
+
 TEE_Result syscall_cryp_derive_key(unsigned long state,
 			const struct utee_attribute *params,
 			unsigned long param_count, unsigned long derived_key);
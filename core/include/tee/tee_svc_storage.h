@@ -9,6 +9,7 @@
 #include <tee_api_types.h>
 #include <kernel/tee_ta_manager.h>
 #include <tee/tee_fs.h>
+#include <utee_types.h>
 
 /*
  * Returns the appropriate tee_file_operations for the specified storage ID.
@@ -49,6 +50,15 @@ TEE_Result syscall_storage_start_enum(unsigned long obj_enum,
 TEE_Result syscall_storage_next_enum(unsigned long obj_enum,
 			TEE_ObjectInfo *info, void *obj_id, uint64_t *len);
 
+/*
+ * Returns up to @num_entries objects of the enumeration in @entries, each
+ * with its own result. Stops at the end of the enumeration, which is
+ * reported with TEE_ERROR_ITEM_NOT_FOUND only if no object is returned.
+ */
+TEE_Result syscall_storage_next_enum_batch(unsigned long obj_enum,
+			struct utee_object_enum_entry *entries,
+			size_t num_entries, uint64_t *count);
+
 /*
  * Data Stream Access Functions
  */
@@ -63,8 +73,29 @@ TEE_Result syscall_storage_obj_trunc(unsigned long obj, size_t len);
 TEE_Result syscall_storage_obj_seek(unsigned long obj, int32_t offset,
 				    unsigned long whence);
 
+TEE_Result syscall_storage_obj_submit(unsigned long obj, unsigned long write,
+				      void *data, size_t len);
+
+TEE_Result syscall_storage_obj_wait(unsigned long obj, unsigned long wait,
+				    uint64_t *count);
+
+/*
+ * Waits for the asynchronous read or write of @o, if any, to complete and
+ * discards its result. Called before @o is closed.
+ */
+void tee_svc_storage_async_release(struct tee_obj *o);
+
+TEE_Result syscall_storage_txn(unsigned long storage_id,
+			       unsigned long begin);
+
 void tee_svc_storage_close_all_enum(struct user_ta_ctx *utc);
 
+/*
+ * Ends the storage transaction of @utc if there's one, the changes made
+ * so far are committed. Called when the TA context is destroyed.
+ */
+void tee_svc_storage_end_txn(struct user_ta_ctx *utc);
+
 void tee_svc_storage_init(void);
 
 struct tee_pobj;
@@ -6,9 +6,11 @@
 #include <assert.h>
 #include <kernel/dt.h>
 #include <kernel/linker.h>
+#include <kernel/spinlock.h>
 #include <libfdt.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
+#include <stdlib.h>
 #include <string.h>
 #include <trace.h>
 
@@ -32,6 +34,268 @@ const struct dt_driver *dt_find_compatible_driver(const void *fdt, int offs)
 	return NULL;
 }
 
+/*
+ * Index of the nodes of a device tree by offset, compatible string and
+ * phandle, built with a single walk of the tree on the first lookup.
+ * libfdt scans the tree from the start for each lookup of a node by
+ * compatible string or phandle and for each lookup of a parent, which
+ * makes probing all the devices of a tree quadratic in its size.
+ *
+ * Node offsets only change when the structure block is resized, the
+ * index is rebuilt when its size differs from the indexed one. Nodes
+ * found by compatible string are checked against the tree, but a
+ * compatible string or a phandle changed in place isn't expected.
+ */
+#define DT_INDEX_MAX_DEPTH	32
+
+struct dt_index_node {
+	int offs;
+	int parent;
+};
+
+struct dt_index_key {
+	uint32_t key;	/* Hash of a compatible string or phandle */
+	int offs;
+};
+
+struct dt_index {
+	const void *fdt;
+	uint32_t size_dt_struct;
+	struct dt_index_node *nodes;
+	size_t num_nodes;
+	struct dt_index_key *compat;
+	size_t num_compat;
+	struct dt_index_key *phandle;
+	size_t num_phandle;
+};
+
+static struct dt_index dt_index __nex_bss;
+static unsigned int dt_index_lock __nex_bss;
+
+static uint32_t compat_hash(const char *s, size_t len)
+{
+	uint32_t h = 2166136261U;
+	size_t n = 0;
+
+	for (n = 0; n < len && s[n]; n++)
+		h = (h ^ (uint8_t)s[n]) * 16777619U;
+
+	return h;
+}
+
+static int cmp_key(const void *a, const void *b)
+{
+	const struct dt_index_key *ka = a;
+	const struct dt_index_key *kb = b;
+
+	if (ka->key != kb->key)
+		return CMP_TRILEAN(ka->key, kb->key);
+	return CMP_TRILEAN(ka->offs, kb->offs);
+}
+
+/*
+ * Walks the tree, counting only if the arrays of @idx aren't allocated.
+ * Returns false if the tree is malformed or too deep.
+ */
+static bool index_walk(const void *fdt, struct dt_index *idx)
+{
+	int parents[DT_INDEX_MAX_DEPTH] = { };
+	const char *compat = NULL;
+	uint32_t phandle = 0;
+	int depth = -1;
+	int offs = 0;
+	int len = 0;
+	int n = 0;
+
+	idx->num_nodes = 0;
+	idx->num_compat = 0;
+	idx->num_phandle = 0;
+
+	for (offs = fdt_next_node(fdt, -1, &depth); offs >= 0 && depth >= 0;
+	     offs = fdt_next_node(fdt, offs, &depth)) {
+		if (depth >= DT_INDEX_MAX_DEPTH)
+			return false;
+		parents[depth] = offs;
+
+		if (idx->nodes) {
+			idx->nodes[idx->num_nodes].offs = offs;
+			if (depth)
+				idx->nodes[idx->num_nodes].parent =
+					parents[depth - 1];
+			else
+				idx->nodes[idx->num_nodes].parent =
+					-FDT_ERR_NOTFOUND;
+		}
+		idx->num_nodes++;
+
+		compat = fdt_getprop(fdt, offs, "compatible", &len);
+		for (n = 0; compat && n < len; n += strnlen(compat + n,
+							    len - n) + 1) {
+			if (idx->compat) {
+				idx->compat[idx->num_compat].key =
+					compat_hash(compat + n, len - n);
+				idx->compat[idx->num_compat].offs = offs;
+			}
+			idx->num_compat++;
+		}
+
+		phandle = fdt_get_phandle(fdt, offs);
+		if (phandle && phandle != (uint32_t)-1) {
+			if (idx->phandle) {
+				idx->phandle[idx->num_phandle].key = phandle;
+				idx->phandle[idx->num_phandle].offs = offs;
+			}
+			idx->num_phandle++;
+		}
+	}
+
+	return offs >= 0 || offs == -FDT_ERR_NOTFOUND;
+}
+
+static void index_free(struct dt_index *idx)
+{
+	free(idx->nodes);
+	free(idx->compat);
+	free(idx->phandle);
+	memset(idx, 0, sizeof(*idx));
+}
+
+/* Returns true if the index covers @fdt, dt_index_lock must be held */
+static bool index_fdt(const void *fdt)
+{
+	struct dt_index *idx = &dt_index;
+
+	if (idx->fdt == fdt && idx->size_dt_struct == fdt_size_dt_struct(fdt))
+		return true;
+
+	index_free(idx);
+	if (!index_walk(fdt, idx))
+		return false;
+
+	idx->nodes = calloc(idx->num_nodes, sizeof(*idx->nodes));
+	idx->compat = calloc(idx->num_compat + 1, sizeof(*idx->compat));
+	idx->phandle = calloc(idx->num_phandle + 1, sizeof(*idx->phandle));
+	if (!idx->nodes || !idx->compat || !idx->phandle ||
+	    !index_walk(fdt, idx)) {
+		index_free(idx);
+		return false;
+	}
+
+	qsort(idx->compat, idx->num_compat, sizeof(*idx->compat), cmp_key);
+	qsort(idx->phandle, idx->num_phandle, sizeof(*idx->phandle), cmp_key);
+	idx->fdt = fdt;
+	idx->size_dt_struct = fdt_size_dt_struct(fdt);
+
+	return true;
+}
+
+/* Returns the position of the first key not less than @key and @offs */
+static size_t find_key(const struct dt_index_key *keys, size_t num_keys,
+		       uint32_t key, int offs)
+{
+	const struct dt_index_key k = { .key = key, .offs = offs };
+	size_t lo = 0;
+	size_t hi = num_keys;
+	size_t mid = 0;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (cmp_key(keys + mid, &k) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+int dt_node_offset_by_compatible(const void *fdt, int startoffset,
+				 const char *compatible)
+{
+	uint32_t key = compat_hash(compatible, strlen(compatible));
+	uint32_t exceptions = cpu_spin_lock_xsave(&dt_index_lock);
+	int ret = -FDT_ERR_NOTFOUND;
+	size_t n = 0;
+
+	if (!index_fdt(fdt)) {
+		cpu_spin_unlock_xrestore(&dt_index_lock, exceptions);
+		return fdt_node_offset_by_compatible(fdt, startoffset,
+						     compatible);
+	}
+
+	n = find_key(dt_index.compat, dt_index.num_compat, key,
+		     startoffset + 1);
+	for (; n < dt_index.num_compat && dt_index.compat[n].key == key; n++) {
+		if (!fdt_node_check_compatible(fdt, dt_index.compat[n].offs,
+					       compatible)) {
+			ret = dt_index.compat[n].offs;
+			break;
+		}
+	}
+
+	cpu_spin_unlock_xrestore(&dt_index_lock, exceptions);
+
+	return ret;
+}
+
+int dt_node_offset_by_phandle(const void *fdt, uint32_t phandle)
+{
+	uint32_t exceptions = 0;
+	int ret = -FDT_ERR_NOTFOUND;
+	size_t n = 0;
+
+	if (!phandle || phandle == (uint32_t)-1)
+		return -FDT_ERR_BADPHANDLE;
+
+	exceptions = cpu_spin_lock_xsave(&dt_index_lock);
+
+	if (!index_fdt(fdt)) {
+		cpu_spin_unlock_xrestore(&dt_index_lock, exceptions);
+		return fdt_node_offset_by_phandle(fdt, phandle);
+	}
+
+	n = find_key(dt_index.phandle, dt_index.num_phandle, phandle, 0);
+	if (n < dt_index.num_phandle && dt_index.phandle[n].key == phandle)
+		ret = dt_index.phandle[n].offs;
+
+	cpu_spin_unlock_xrestore(&dt_index_lock, exceptions);
+
+	return ret;
+}
+
+int dt_parent_offset(const void *fdt, int offs)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&dt_index_lock);
+	int ret = -FDT_ERR_BADOFFSET;
+	bool found = false;
+	size_t lo = 0;
+	size_t hi = 0;
+	size_t mid = 0;
+
+	if (index_fdt(fdt)) {
+		hi = dt_index.num_nodes;
+		while (lo < hi) {
+			mid = lo + (hi - lo) / 2;
+			if (dt_index.nodes[mid].offs < offs)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if (lo < dt_index.num_nodes && dt_index.nodes[lo].offs == offs) {
+			ret = dt_index.nodes[lo].parent;
+			found = true;
+		}
+	}
+
+	cpu_spin_unlock_xrestore(&dt_index_lock, exceptions);
+
+	/* Not a node in the index, let libfdt report the error */
+	if (!found)
+		return fdt_parent_offset(fdt, offs);
+
+	return ret;
+}
+
 const struct dt_driver *__dt_driver_start(void)
 {
 	return &__rodata_dtdrv_start;
@@ -197,7 +461,7 @@ paddr_t _fdt_reg_base_address(const void *fdt, int offs)
 	int len;
 	int parent;
 
-	parent = fdt_parent_offset(fdt, offs);
+	parent = dt_parent_offset(fdt, offs);
 	if (parent < 0)
 		return DT_INFO_INVALID_REG;
 
@@ -220,7 +484,7 @@ ssize_t _fdt_reg_size(const void *fdt, int offs)
 	int len;
 	int parent;
 
-	parent = fdt_parent_offset(fdt, offs);
+	parent = dt_parent_offset(fdt, offs);
 	if (parent < 0)
 		return DT_INFO_INVALID_REG;
 
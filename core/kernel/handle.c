@@ -2,6 +2,7 @@
 /*
  * Copyright (c) 2014, Linaro Limited
  */
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <kernel/handle.h>
@@ -14,6 +15,57 @@
  */
 #define HANDLE_DB_INITIAL_MAX_PTRS	4
 
+#define HANDLE_IDX_MASK		((1U << HANDLE_IDX_BITS) - 1)
+#define HANDLE_GEN_MASK		((1U << HANDLE_GEN_BITS) - 1)
+
+static struct handle_db_slot *get_slot(struct handle_db *db, int handle)
+{
+	struct handle_db_slot *slot = NULL;
+	size_t idx = 0;
+
+	if (!db || handle < 0)
+		return NULL;
+
+	idx = handle & HANDLE_IDX_MASK;
+	if (idx >= db->max_ptrs)
+		return NULL;
+
+	slot = db->slots + idx;
+	if (!slot->ptr || slot->gen != (uint32_t)handle >> HANDLE_IDX_BITS)
+		return NULL;
+
+	return slot;
+}
+
+static bool grow_db(struct handle_db *db)
+{
+	size_t new_max_ptrs = 0;
+	size_t n = 0;
+	void *p = NULL;
+
+	if (db->max_ptrs)
+		new_max_ptrs = db->max_ptrs * 2;
+	else
+		new_max_ptrs = HANDLE_DB_INITIAL_MAX_PTRS;
+	if (new_max_ptrs > HANDLE_IDX_MASK + 1)
+		return false;
+
+	p = realloc(db->slots, new_max_ptrs * sizeof(*db->slots));
+	if (!p)
+		return false;
+	db->slots = p;
+	memset(db->slots + db->max_ptrs, 0,
+	       (new_max_ptrs - db->max_ptrs) * sizeof(*db->slots));
+
+	/* Only called with an empty free list, lowest index first */
+	for (n = db->max_ptrs; n < new_max_ptrs - 1; n++)
+		db->slots[n].next_free = n + 2;
+	db->free_head = db->max_ptrs + 1;
+	db->max_ptrs = new_max_ptrs;
+
+	return true;
+}
+
 void handle_db_destroy(struct handle_db *db, void (*ptr_destructor)(void *ptr))
 {
 	if (db) {
@@ -21,66 +73,59 @@ void handle_db_destroy(struct handle_db *db, void (*ptr_destructor)(void *ptr))
 			size_t n = 0;
 
 			for (n = 0; n < db->max_ptrs; n++)
-				if (db->ptrs[n])
-					ptr_destructor(db->ptrs[n]);
+				if (db->slots[n].ptr)
+					ptr_destructor(db->slots[n].ptr);
 		}
-		free(db->ptrs);
-		db->ptrs = NULL;
+		free(db->slots);
+		db->slots = NULL;
 		db->max_ptrs = 0;
+		db->free_head = 0;
 	}
 }
 
 int handle_get(struct handle_db *db, void *ptr)
 {
-	size_t n;
-	void *p;
-	size_t new_max_ptrs;
+	struct handle_db_slot *slot = NULL;
+	size_t idx = 0;
 
 	if (!db || !ptr)
 		return -1;
 
-	/* Try to find an empty location */
-	for (n = 0; n < db->max_ptrs; n++) {
-		if (!db->ptrs[n]) {
-			db->ptrs[n] = ptr;
-			return n;
-		}
-	}
-
-	/* No location available, grow the ptrs array */
-	if (db->max_ptrs)
-		new_max_ptrs = db->max_ptrs * 2;
-	else
-		new_max_ptrs = HANDLE_DB_INITIAL_MAX_PTRS;
-	p = realloc(db->ptrs, new_max_ptrs * sizeof(void *));
-	if (!p)
+	if (!db->free_head && !grow_db(db))
 		return -1;
-	db->ptrs = p;
-	memset(db->ptrs + db->max_ptrs, 0,
-	       (new_max_ptrs - db->max_ptrs) * sizeof(void *));
-	db->max_ptrs = new_max_ptrs;
 
-	/* Since n stopped at db->max_ptrs there is an empty location there */
-	db->ptrs[n] = ptr;
-	return n;
+	idx = db->free_head - 1;
+	slot = db->slots + idx;
+	db->free_head = slot->next_free;
+	slot->next_free = 0;
+	slot->ptr = ptr;
+
+	return (slot->gen << HANDLE_IDX_BITS) | idx;
 }
 
 void *handle_put(struct handle_db *db, int handle)
 {
-	void *p;
+	struct handle_db_slot *slot = get_slot(db, handle);
+	void *p = NULL;
 
-	if (!db || handle < 0 || (size_t)handle >= db->max_ptrs)
+	if (!slot)
 		return NULL;
 
-	p = db->ptrs[handle];
-	db->ptrs[handle] = NULL;
+	p = slot->ptr;
+	slot->ptr = NULL;
+	slot->gen = (slot->gen + 1) & HANDLE_GEN_MASK;
+	slot->next_free = db->free_head;
+	db->free_head = (slot - db->slots) + 1;
+
 	return p;
 }
 
 void *handle_lookup(struct handle_db *db, int handle)
 {
-	if (!db || handle < 0 || (size_t)handle >= db->max_ptrs)
+	struct handle_db_slot *slot = get_slot(db, handle);
+
+	if (!slot)
 		return NULL;
 
-	return db->ptrs[handle];
+	return slot->ptr;
 }
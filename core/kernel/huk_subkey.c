@@ -4,8 +4,13 @@
  */
 
 #include <crypto/crypto.h>
+#include <initcall.h>
+#include <keep.h>
 #include <kernel/huk_subkey.h>
+#include <kernel/pm.h>
+#include <kernel/spinlock.h>
 #include <kernel/tee_common_otp.h>
+#include <string.h>
 #include <string_ext.h>
 #include <tee/tee_fs_key_manager.h>
 
@@ -57,12 +62,135 @@ static TEE_Result huk_compat(void *ctx, enum huk_subkey_usage usage)
 }
 #endif /*CFG_CORE_HUK_SUBKEY_COMPAT*/
 
+#ifdef CFG_CORE_HUK_SUBKEY_CACHE
+/*
+ * Subkeys are cached with their full HMAC-SHA256 length, a shorter
+ * subkey is a truncation of the same MAC. Subkeys derived with more than
+ * HUK_CACHE_CONST_MAX_LEN bytes of constant data aren't cached.
+ */
+#define HUK_CACHE_CONST_MAX_LEN	32
+
+struct huk_cache_entry {
+	bool valid;
+	enum huk_subkey_usage usage;
+	size_t const_data_len;
+	uint8_t const_data[HUK_CACHE_CONST_MAX_LEN];
+	uint8_t subkey[HUK_SUBKEY_MAX_LEN];
+};
+
+static struct huk_cache_entry huk_cache[CFG_CORE_HUK_SUBKEY_CACHE_ENTRIES];
+static size_t huk_cache_next;
+static unsigned int huk_cache_lock = SPINLOCK_UNLOCK;
+
+static struct huk_cache_entry *cache_find(enum huk_subkey_usage usage,
+					  const void *const_data,
+					  size_t const_data_len)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(huk_cache); n++) {
+		if (huk_cache[n].valid && huk_cache[n].usage == usage &&
+		    huk_cache[n].const_data_len == const_data_len &&
+		    (!const_data_len ||
+		     !memcmp(huk_cache[n].const_data, const_data,
+			     const_data_len)))
+			return huk_cache + n;
+	}
+
+	return NULL;
+}
+
+static bool cache_get(enum huk_subkey_usage usage, const void *const_data,
+		      size_t const_data_len, uint8_t *subkey,
+		      size_t subkey_len)
+{
+	struct huk_cache_entry *e = NULL;
+	uint32_t exceptions = 0;
+
+	if (const_data_len > HUK_CACHE_CONST_MAX_LEN)
+		return false;
+
+	exceptions = cpu_spin_lock_xsave(&huk_cache_lock);
+	e = cache_find(usage, const_data, const_data_len);
+	if (e)
+		memcpy(subkey, e->subkey, subkey_len);
+	cpu_spin_unlock_xrestore(&huk_cache_lock, exceptions);
+
+	return e;
+}
+
+static void cache_put(enum huk_subkey_usage usage, const void *const_data,
+		      size_t const_data_len, const uint8_t *subkey)
+{
+	struct huk_cache_entry *e = NULL;
+	uint32_t exceptions = 0;
+
+	if (const_data_len > HUK_CACHE_CONST_MAX_LEN)
+		return;
+
+	exceptions = cpu_spin_lock_xsave(&huk_cache_lock);
+	/* Another thread may have derived the same subkey meanwhile */
+	if (!cache_find(usage, const_data, const_data_len)) {
+		e = huk_cache + huk_cache_next;
+		huk_cache_next = (huk_cache_next + 1) % ARRAY_SIZE(huk_cache);
+
+		e->valid = true;
+		e->usage = usage;
+		e->const_data_len = const_data_len;
+		if (const_data_len)
+			memcpy(e->const_data, const_data, const_data_len);
+		memcpy(e->subkey, subkey, sizeof(e->subkey));
+	}
+	cpu_spin_unlock_xrestore(&huk_cache_lock, exceptions);
+}
+
+static TEE_Result huk_cache_pm(enum pm_op op, uint32_t pm_hint __unused,
+			       const struct pm_callback_handle *hdl __unused)
+{
+	uint32_t exceptions = 0;
+
+	if (op == PM_OP_SUSPEND) {
+		exceptions = cpu_spin_lock_xsave(&huk_cache_lock);
+		memzero_explicit(huk_cache, sizeof(huk_cache));
+		huk_cache_next = 0;
+		cpu_spin_unlock_xrestore(&huk_cache_lock, exceptions);
+	}
+
+	return TEE_SUCCESS;
+}
+KEEP_PAGER(huk_cache_pm);
+
+static TEE_Result huk_cache_init(void)
+{
+	register_pm_core_service_cb(huk_cache_pm, NULL);
+
+	return TEE_SUCCESS;
+}
+service_init(huk_cache_init);
+#else
+static bool cache_get(enum huk_subkey_usage usage __unused,
+		      const void *const_data __unused,
+		      size_t const_data_len __unused,
+		      uint8_t *subkey __unused, size_t subkey_len __unused)
+{
+	return false;
+}
+
+static void cache_put(enum huk_subkey_usage usage __unused,
+		      const void *const_data __unused,
+		      size_t const_data_len __unused,
+		      const uint8_t *subkey __unused)
+{
+}
+#endif /*CFG_CORE_HUK_SUBKEY_CACHE*/
+
 TEE_Result huk_subkey_derive(enum huk_subkey_usage usage,
 			     const void *const_data, size_t const_data_len,
 			     uint8_t *subkey, size_t subkey_len)
 {
 	void *ctx = NULL;
 	struct tee_hw_unique_key huk = { };
+	uint8_t full_subkey[HUK_SUBKEY_MAX_LEN] = { };
 	TEE_Result res = TEE_SUCCESS;
 
 	if (subkey_len > HUK_SUBKEY_MAX_LEN)
@@ -70,6 +198,9 @@ TEE_Result huk_subkey_derive(enum huk_subkey_usage usage,
 	if (!const_data && const_data_len)
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	if (cache_get(usage, const_data, const_data_len, subkey, subkey_len))
+		return TEE_SUCCESS;
+
 	res = crypto_mac_alloc_ctx(&ctx, TEE_ALG_HMAC_SHA256);
 	if (res)
 		return res;
@@ -98,10 +229,17 @@ TEE_Result huk_subkey_derive(enum huk_subkey_usage usage,
 			goto out;
 	}
 
-	res = crypto_mac_final(ctx, TEE_ALG_HMAC_SHA256, subkey, subkey_len);
+	res = crypto_mac_final(ctx, TEE_ALG_HMAC_SHA256, full_subkey,
+			       sizeof(full_subkey));
+	if (res)
+		goto out;
+
+	memcpy(subkey, full_subkey, subkey_len);
+	cache_put(usage, const_data, const_data_len, full_subkey);
 out:
 	if (res)
 		memzero_explicit(subkey, subkey_len);
+	memzero_explicit(full_subkey, sizeof(full_subkey));
 	memzero_explicit(&huk, sizeof(huk));
 	crypto_mac_free_ctx(ctx, TEE_ALG_HMAC_SHA256);
 	return res;
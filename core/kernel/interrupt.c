@@ -3,9 +3,15 @@
  * Copyright (c) 2016-2019, Linaro Limited
  */
 
+#include <arm.h>
+#include <compiler.h>
 #include <kernel/interrupt.h>
 #include <kernel/panic.h>
+#include <kernel/spinlock.h>
+#include <stdlib.h>
+#include <string.h>
 #include <trace.h>
+#include <util.h>
 
 /*
  * NOTE!
@@ -15,8 +21,21 @@
  * we begin to modify settings after boot initialization.
  */
 
+/*
+ * Handlers of interrupts below ITR_TABLE_SIZE, which covers all the
+ * interrupts of a GIC but LPIs, are looked up in a two-level table.
+ * The chunks of the table are allocated when a handler in their range is
+ * added. All handlers are also in @handlers, which is scanned for larger
+ * interrupt numbers or if a chunk couldn't be allocated.
+ */
+#define ITR_CHUNK_SHIFT		5
+#define ITR_CHUNK_SIZE		BIT(ITR_CHUNK_SHIFT)
+#define ITR_NUM_CHUNKS		32
+#define ITR_TABLE_SIZE		(ITR_NUM_CHUNKS * ITR_CHUNK_SIZE)
+
 static struct itr_chip *itr_chip;
 static SLIST_HEAD(, itr_handler) handlers = SLIST_HEAD_INITIALIZER(handlers);
+static struct itr_handler **itr_table[ITR_NUM_CHUNKS];
 
 void itr_init(struct itr_chip *chip)
 {
@@ -27,12 +46,86 @@ static struct itr_handler *find_handler(size_t it)
 {
 	struct itr_handler *h;
 
+	if (it < ITR_TABLE_SIZE && itr_table[it >> ITR_CHUNK_SHIFT])
+		return itr_table[it >> ITR_CHUNK_SHIFT][it % ITR_CHUNK_SIZE];
+
 	SLIST_FOREACH(h, &handlers, link)
 		if (h->it == it)
 			return h;
 	return NULL;
 }
 
+#ifdef CFG_ITR_STATS
+/* Only taken to read the statistics, handlers update them lockless */
+static unsigned int itr_stats_lock = SPINLOCK_UNLOCK;
+
+/*
+ * An interrupt isn't delivered again until its handler has returned so
+ * the statistics of a handler are only updated by one CPU at a time.
+ */
+static enum itr_return call_handler(struct itr_handler *h)
+{
+	uint64_t begin = read_cntpct();
+	enum itr_return ret = h->handler(h);
+	uint64_t ticks = read_cntpct() - begin;
+
+	h->count++;
+	h->ticks += ticks;
+	h->max_ticks = MAX(h->max_ticks, ticks);
+
+	return ret;
+}
+
+static uint64_t ticks_to_ns(uint64_t ticks, uint64_t freq)
+{
+	return (ticks / freq) * 1000000000 +
+	       ((ticks % freq) * 1000000000) / freq;
+}
+
+bool itr_get_stats(struct itr_stats *stats, size_t *count, bool reset)
+{
+	uint64_t freq = read_cntfrq();
+	struct itr_handler *h = NULL;
+	uint32_t exceptions = 0;
+	size_t num = 0;
+
+	exceptions = cpu_spin_lock_xsave(&itr_stats_lock);
+
+	SLIST_FOREACH(h, &handlers, link)
+		num++;
+	if (*count < num) {
+		*count = num;
+		cpu_spin_unlock_xrestore(&itr_stats_lock, exceptions);
+		return false;
+	}
+
+	num = 0;
+	SLIST_FOREACH(h, &handlers, link) {
+		memset(stats + num, 0, sizeof(*stats));
+		stats[num].it = h->it;
+		stats[num].count = h->count;
+		stats[num].time_ns = ticks_to_ns(h->ticks, freq);
+		stats[num].max_ns = ticks_to_ns(h->max_ticks, freq);
+		if (reset) {
+			h->count = 0;
+			h->ticks = 0;
+			h->max_ticks = 0;
+		}
+		num++;
+	}
+	*count = num;
+
+	cpu_spin_unlock_xrestore(&itr_stats_lock, exceptions);
+
+	return true;
+}
+#else
+static enum itr_return call_handler(struct itr_handler *h)
+{
+	return h->handler(h);
+}
+#endif /*CFG_ITR_STATS*/
+
 void itr_handle(size_t it)
 {
 	struct itr_handler *h = find_handler(it);
@@ -43,7 +136,7 @@ void itr_handle(size_t it)
 		return;
 	}
 
-	if (h->handler(h) != ITRR_HANDLED) {
+	if (call_handler(h) != ITRR_HANDLED) {
 		EMSG("Disabling interrupt %zu not handled by handler", it);
 		itr_chip->ops->disable(itr_chip, it);
 	}
@@ -51,8 +144,32 @@ void itr_handle(size_t it)
 
 void itr_add(struct itr_handler *h)
 {
+	size_t idx = h->it >> ITR_CHUNK_SHIFT;
+	struct itr_handler *hh = NULL;
+
 	itr_chip->ops->add(itr_chip, h->it, h->flags);
 	SLIST_INSERT_HEAD(&handlers, h, link);
+
+	if (h->it >= ITR_TABLE_SIZE)
+		return;
+
+	if (itr_table[idx]) {
+		itr_table[idx][h->it % ITR_CHUNK_SIZE] = h;
+		return;
+	}
+
+	itr_table[idx] = calloc(ITR_CHUNK_SIZE, sizeof(*itr_table[idx]));
+	if (!itr_table[idx])
+		return;
+
+	/*
+	 * An earlier allocation of the chunk may have failed. The latest
+	 * handler added for an interrupt comes first in the list, as before.
+	 */
+	SLIST_FOREACH(hh, &handlers, link)
+		if (hh->it >> ITR_CHUNK_SHIFT == idx &&
+		    !itr_table[idx][hh->it % ITR_CHUNK_SIZE])
+			itr_table[idx][hh->it % ITR_CHUNK_SIZE] = hh;
 }
 
 void itr_enable(size_t it)
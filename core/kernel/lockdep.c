@@ -5,6 +5,7 @@
 
 #include <assert.h>
 #include <kernel/lockdep.h>
+#include <kernel/spinlock.h>
 #include <kernel/unwind.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,32 +13,79 @@
 #include <util.h>
 
 /* lockdep_node::flags values */
-/* Flags used for depth-first topological sorting */
-#define LOCKDEP_NODE_TEMP_MARK		BIT(0)
-#define LOCKDEP_NODE_PERM_MARK		BIT(1)
 /* Flag used during breadth-first search (print shortest cycle) */
 #define LOCKDEP_NODE_BFS_VISITED	BIT(2)
 
+/*
+ * The nodes of all graphs are indexed by graph and lock ID, the graphs
+ * are protected by their users but may be used concurrently.
+ */
+#define LOCKDEP_HASH_SIZE		256
+
+static LIST_HEAD(lockdep_hash_head, lockdep_node)
+	lockdep_hash[LOCKDEP_HASH_SIZE];
+static unsigned int lockdep_hash_lock = SPINLOCK_UNLOCK;
+/* Identifies the nodes reached by the current search */
+static unsigned int lockdep_visit_gen;
+
+static struct lockdep_hash_head *
+lockdep_hash_bucket(struct lockdep_node_head *graph, uintptr_t lock_id)
+{
+	uintptr_t h = ((uintptr_t)graph >> 4) ^ (lock_id >> 3) ^ (lock_id >> 11);
+
+	return lockdep_hash + h % LOCKDEP_HASH_SIZE;
+}
+
+static struct lockdep_node *lockdep_find_node(struct lockdep_node_head *graph,
+					      uintptr_t lock_id)
+{
+	struct lockdep_hash_head *bucket = lockdep_hash_bucket(graph, lock_id);
+	struct lockdep_node *node = NULL;
+	uint32_t exceptions = 0;
+
+	exceptions = cpu_spin_lock_xsave(&lockdep_hash_lock);
+	LIST_FOREACH(node, bucket, hash_link)
+		if (node->graph == graph && node->lock_id == lock_id)
+			break;
+	cpu_spin_unlock_xrestore(&lockdep_hash_lock, exceptions);
+
+	return node;
+}
+
+static void lockdep_hash_remove(struct lockdep_node *node)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&lockdep_hash_lock);
+
+	LIST_REMOVE(node, hash_link);
+	cpu_spin_unlock_xrestore(&lockdep_hash_lock, exceptions);
+}
+
 /* Find node in graph or add it */
 static struct lockdep_node *lockdep_add_to_graph(
 				struct lockdep_node_head *graph,
 				uintptr_t lock_id)
 {
 	struct lockdep_node *node = NULL;
+	uint32_t exceptions = 0;
 
 	assert(graph);
-	TAILQ_FOREACH(node, graph, link)
-		if (node->lock_id == lock_id)
-			return node;
+	node = lockdep_find_node(graph, lock_id);
+	if (node)
+		return node;
 
 	node = calloc(1, sizeof(*node));
 	if (!node)
 		return NULL;
 
 	node->lock_id = lock_id;
+	node->graph = graph;
 	STAILQ_INIT(&node->edges);
 	TAILQ_INSERT_TAIL(graph, node, link);
 
+	exceptions = cpu_spin_lock_xsave(&lockdep_hash_lock);
+	LIST_INSERT_HEAD(lockdep_hash_bucket(graph, lock_id), node, hash_link);
+	cpu_spin_unlock_xrestore(&lockdep_hash_lock, exceptions);
+
 	return node;
 }
 
@@ -70,11 +118,12 @@ static void lockdep_print_call_stack(vaddr_t *stack)
 		EMSG_RAW(" %#" PRIxPTR, *p);
 }
 
+/* Sets *@added to true if the edge didn't exist already */
 static TEE_Result lockdep_add_edge(struct lockdep_node *from,
 				   struct lockdep_node *to,
 				   vaddr_t *call_stack_from,
 				   vaddr_t *call_stack_to,
-				   uintptr_t thread_id)
+				   uintptr_t thread_id, bool *added)
 {
 	struct lockdep_edge *edge = NULL;
 
@@ -90,6 +139,7 @@ static TEE_Result lockdep_add_edge(struct lockdep_node *from,
 	edge->call_stack_to = dup_call_stack(call_stack_to);
 	edge->thread_id = thread_id;
 	STAILQ_INSERT_TAIL(&from->edges, edge, link);
+	*added = true;
 
 	return TEE_SUCCESS;
 }
@@ -204,60 +254,49 @@ out:
 	return ret;
 }
 
-static TEE_Result lockdep_visit(struct lockdep_node *node)
+/* Marks all nodes reachable from @node with @gen */
+static void lockdep_visit(struct lockdep_node *node, unsigned int gen)
 {
-	if (node->flags & LOCKDEP_NODE_PERM_MARK)
-		return TEE_SUCCESS;
-
-	if (node->flags & LOCKDEP_NODE_TEMP_MARK)
-		return TEE_ERROR_BAD_STATE;	/* Not a DAG! */
-
-	node->flags |= LOCKDEP_NODE_TEMP_MARK;
-
-	struct lockdep_edge *e;
+	struct lockdep_edge *e = NULL;
 
 	STAILQ_FOREACH(e, &node->edges, link) {
-		TEE_Result res = lockdep_visit(e->to);
-
-		if (res)
-			return res;
+		if (e->to->visit_gen != gen) {
+			e->to->visit_gen = gen;
+			lockdep_visit(e->to, gen);
+		}
 	}
-
-	node->flags |= LOCKDEP_NODE_PERM_MARK;
-	return TEE_SUCCESS;
 }
 
-static TEE_Result lockdep_graph_sort(struct lockdep_node_head *graph)
+/*
+ * The graph was acyclic before the edges from the locks in @owned to
+ * @node were added, so a cycle can only go through @node and one of
+ * these locks.
+ */
+static bool lockdep_has_cycle(struct lockdep_node *node,
+			      struct lockdep_lock_head *owned)
 {
-	struct lockdep_node *node = NULL;
-
-	TAILQ_FOREACH(node, graph, link) {
-		if (!node->flags) {
-			/* Unmarked node */
-			TEE_Result res = lockdep_visit(node);
-
-			if (res)
-				return res;
-		}
-	}
+	unsigned int gen = __atomic_add_fetch(&lockdep_visit_gen, 1,
+					      __ATOMIC_RELAXED);
+	struct lockdep_lock *lock = NULL;
 
-	TAILQ_FOREACH(node, graph, link)
-		node->flags = 0;
+	lockdep_visit(node, gen);
+	TAILQ_FOREACH(lock, owned, link)
+		if (lock->node->visit_gen == gen)
+			return true;
 
-	return TEE_SUCCESS;
+	return false;
 }
 
 static struct lockdep_edge *lockdep_find_edge(struct lockdep_node_head *graph,
 					      uintptr_t from, uintptr_t to)
 {
-	struct lockdep_node *node = NULL;
+	struct lockdep_node *node = lockdep_find_node(graph, from);
 	struct lockdep_edge *edge = NULL;
 
-	TAILQ_FOREACH(node, graph, link)
-		if (node->lock_id == from)
-			STAILQ_FOREACH(edge, &node->edges, link)
-				if (edge->to->lock_id == to)
-					return edge;
+	if (node)
+		STAILQ_FOREACH(edge, &node->edges, link)
+			if (edge->to->lock_id == to)
+				return edge;
 	return NULL;
 }
 
@@ -323,24 +362,24 @@ TEE_Result __lockdep_lock_acquire(struct lockdep_node_head *graph,
 
 	struct lockdep_lock *lock = NULL;
 	vaddr_t *acq_stack = unw_get_kernel_stack();
+	bool added = false;
 
 	TAILQ_FOREACH(lock, owned, link) {
 		TEE_Result res = lockdep_add_edge(lock->node, node,
 						  lock->call_stack,
 						  acq_stack,
-						  (uintptr_t)owned);
+						  (uintptr_t)owned, &added);
 
 		if (res)
 			return res;
 	}
 
-	TEE_Result res = lockdep_graph_sort(graph);
-
-	if (res) {
+	/* Existing edges were validated when they were added */
+	if (added && lockdep_has_cycle(node, owned)) {
 		EMSG_RAW("Potential deadlock detected!");
 		EMSG_RAW("When trying to acquire lock %#" PRIxPTR, id);
 		lockdep_print_cycle_info(graph, node);
-		return res;
+		return TEE_ERROR_BAD_STATE;
 	}
 
 	lock = calloc(1, sizeof(*lock));
@@ -424,6 +463,7 @@ void lockdep_graph_delete(struct lockdep_node_head *graph)
 
 	TAILQ_FOREACH_SAFE(node, graph, link, next) {
 		TAILQ_REMOVE(graph, node, link);
+		lockdep_hash_remove(node);
 		lockdep_node_delete(node);
 	}
 }
@@ -447,6 +487,7 @@ static void lockdep_node_destroy(struct lockdep_node_head *graph,
 	struct lockdep_node *from = NULL;
 
 	TAILQ_REMOVE(graph, node, link);
+	lockdep_hash_remove(node);
 
 	/*
 	 * Loop over all nodes in the graph to remove all edges with the
@@ -486,10 +527,7 @@ void lockdep_lock_destroy(struct lockdep_node_head *graph, uintptr_t lock_id)
 	struct lockdep_node *node = NULL;
 
 	assert(graph);
-	TAILQ_FOREACH(node, graph, link) {
-		if (node->lock_id == lock_id) {
-			lockdep_node_destroy(graph, node);
-			break;
-		}
-	}
+	node = lockdep_find_node(graph, lock_id);
+	if (node)
+		lockdep_node_destroy(graph, node);
 }
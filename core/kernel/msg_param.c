@@ -26,7 +26,10 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <io.h>
 #include <kernel/msg_param.h>
+#include <mm/core_memprot.h>
+#include <mm/core_mmu.h>
 #include <mm/mobj.h>
 #include <optee_msg.h>
 #include <stdio.h>
@@ -62,58 +65,63 @@
 static bool msg_param_extract_pages(paddr_t buffer, paddr_t *pages,
 				       size_t num_pages)
 {
-	size_t cnt;
-	struct mobj *mobj;
-	paddr_t page;
-	uint64_t *va;
+	const size_t entries = OPTEE_MSG_NONCONTIG_PAGE_SIZE /
+			       sizeof(uint64_t) - 1;
+	size_t num_lists = (num_pages + entries - 1) / entries;
+	tee_mm_entry_t *mm = NULL;
+	size_t num_mapped = 0;
+	uint64_t *va = NULL;
+	vaddr_t base = 0;
+	size_t cnt = 0;
+	size_t n = 0;
+	size_t m = 0;
 	bool ret = false;
 
-	if (buffer & SMALL_PAGE_MASK)
-		return false;
+	COMPILE_TIME_ASSERT(OPTEE_MSG_NONCONTIG_PAGE_SIZE == SMALL_PAGE_SIZE);
 
 	/*
-	 * There we map first page of array.
-	 * mobj_mapped_shm_alloc() will check if page resides in nonsec ddr
+	 * The pages of the list are mapped one after the other in a range
+	 * reserved for all of them, removing the mappings once at the end
+	 * saves a TLB invalidation per page of the list.
 	 */
-	mobj = mobj_mapped_shm_alloc(&buffer, 1, 0, 0);
-	if (!mobj)
+	mm = mobj_mapped_shm_alloc_va(num_lists);
+	if (!mm)
 		return false;
+	base = tee_mm_get_smem(mm);
 
-	va = mobj_get_va(mobj, 0);
-	assert(va);
+	for (n = 0; n < num_lists; n++) {
+		/* Only non-secure memory can be mapped there */
+		if ((buffer & SMALL_PAGE_MASK) ||
+		    !core_pbuf_is(CORE_MEM_NON_SEC, buffer, SMALL_PAGE_SIZE))
+			goto out;
 
-	for (cnt = 0; cnt < num_pages; cnt++, va++) {
-		/*
-		 * If we about to roll over page boundary, then last entry holds
-		 * address of next page of array. Unmap current page and map
-		 * next one
-		 */
-		if (!((vaddr_t)(va + 1) & SMALL_PAGE_MASK)) {
-			page = *va;
-			if (page & SMALL_PAGE_MASK)
-				goto out;
+		va = (uint64_t *)(base + n * SMALL_PAGE_SIZE);
+		if (core_mmu_map_pages((vaddr_t)va, &buffer, 1,
+				       MEM_AREA_NSEC_SHM))
+			goto out;
+		num_mapped++;
 
-			mobj_free(mobj);
-			mobj = mobj_mapped_shm_alloc(&page, 1, 0, 0);
-			if (!mobj)
+		for (m = 0; m < entries && cnt < num_pages; m++, cnt++) {
+			pages[cnt] = READ_ONCE(va[m]);
+			if (pages[cnt] & SMALL_PAGE_MASK)
 				goto out;
-
-			va = mobj_get_va(mobj, 0);
-			assert(va);
 		}
-		pages[cnt] = *va;
-		if (pages[cnt] & SMALL_PAGE_MASK)
-			goto out;
+
+		/* The last entry holds the address of the next page */
+		buffer = READ_ONCE(va[entries]);
 	}
 
 	ret = true;
 out:
-	mobj_free(mobj);
+	if (num_mapped)
+		core_mmu_unmap_pages(base, num_mapped);
+	tee_mm_free(mm);
 	return ret;
 }
 
 struct mobj *msg_param_mobj_from_noncontig(paddr_t buf_ptr, size_t size,
-					   uint64_t shm_ref, bool map_buffer)
+					   uint64_t shm_ref, bool map_buffer,
+					   uint32_t cattr)
 {
 	struct mobj *mobj = NULL;
 	paddr_t *pages = NULL;
@@ -137,12 +145,14 @@ struct mobj *msg_param_mobj_from_noncontig(paddr_t buf_ptr, size_t size,
 				     pages, num_pages))
 		goto out;
 
-	if (map_buffer)
-		mobj = mobj_mapped_shm_alloc(pages, num_pages, page_offset,
-					     shm_ref);
-	else
+	if (map_buffer) {
+		if (cattr == TEE_MATTR_CACHE_CACHED)
+			mobj = mobj_mapped_shm_alloc(pages, num_pages,
+						     page_offset, shm_ref);
+	} else {
 		mobj = mobj_reg_shm_alloc(pages, num_pages, page_offset,
-					  shm_ref);
+					  shm_ref, cattr);
+	}
 out:
 	free(pages);
 	return mobj;
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <assert.h>
+#include <bitstring.h>
+#include <kernel/interrupt.h>
+#include <kernel/notif.h>
+#include <kernel/spinlock.h>
+#include <util.h>
+
+#define NUM_WQ_VALUES	(NOTIF_VALUE_MAX - NOTIF_VALUE_WQ_BASE + 1)
+
+static uint64_t notif_pending_values;
+static bitstr_t bit_decl(notif_pending_wq_values, NUM_WQ_VALUES);
+static unsigned int notif_lock = SPINLOCK_UNLOCK;
+static bool notif_wq_wakeup;
+
+void notif_send_async(uint32_t value)
+{
+	notif_send_async_multi(&value, 1);
+}
+
+void notif_send_async_multi(const uint32_t *values, size_t count)
+{
+	uint32_t old_itr_status = 0;
+	uint32_t value = 0;
+	size_t n = 0;
+
+	old_itr_status = cpu_spin_lock_xsave(&notif_lock);
+	for (n = 0; n < count; n++) {
+		value = values[n];
+		assert(value && value <= NOTIF_VALUE_MAX);
+		if (value >= NOTIF_VALUE_WQ_BASE)
+			bit_set(notif_pending_wq_values,
+				value - NOTIF_VALUE_WQ_BASE);
+		else
+			notif_pending_values |= BIT64(value);
+	}
+	cpu_spin_unlock_xrestore(&notif_lock, old_itr_status);
+
+	itr_raise_pi(CFG_CORE_ASYNC_NOTIF_GIC_INTID);
+}
+
+bool notif_get_value(uint32_t *value, bool *more_pending)
+{
+	uint32_t old_itr_status = 0;
+	bool res = false;
+	int wq_bit = -1;
+
+	old_itr_status = cpu_spin_lock_xsave(&notif_lock);
+
+	/* Wait queue wakeups first, a thread is blocked on each of them */
+	bit_ffs(notif_pending_wq_values, NUM_WQ_VALUES, &wq_bit);
+	if (wq_bit >= 0) {
+		*value = NOTIF_VALUE_WQ_BASE + wq_bit;
+		bit_clear(notif_pending_wq_values, wq_bit);
+		res = true;
+	} else if (notif_pending_values) {
+		*value = __builtin_ctzll(notif_pending_values);
+		notif_pending_values &= ~BIT64(*value);
+		res = true;
+	}
+	if (res) {
+		bit_ffs(notif_pending_wq_values, NUM_WQ_VALUES, &wq_bit);
+		*more_pending = notif_pending_values || wq_bit >= 0;
+	}
+
+	cpu_spin_unlock_xrestore(&notif_lock, old_itr_status);
+
+	return res;
+}
+
+void notif_set_wq_wakeup(bool enable)
+{
+	notif_wq_wakeup = enable;
+}
+
+bool notif_wq_wakeup_enabled(void)
+{
+	return notif_wq_wakeup;
+}
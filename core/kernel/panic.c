@@ -4,6 +4,7 @@
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
 
+#include <kernel/async_log.h>
 #include <kernel/panic.h>
 #include <kernel/thread.h>
 #include <trace.h>
@@ -18,6 +19,9 @@ void __do_panic(const char *file __maybe_unused,
 
 	/* TODO: notify other cores */
 
+	/* Queued messages first, the panic message is written right away */
+	async_log_sync();
+
 	/* trace: Panic ['panic-string-message' ]at FILE:LINE [<FUNCTION>]" */
 	if (!file && !func && !msg)
 		EMSG_RAW("Panic");
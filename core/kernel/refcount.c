@@ -6,6 +6,7 @@
 #include <assert.h>
 #include <atomic.h>
 #include <kernel/refcount.h>
+#include <limits.h>
 
 bool refcount_inc(struct refcount *r)
 {
@@ -30,23 +31,12 @@ bool refcount_inc(struct refcount *r)
 
 bool refcount_dec(struct refcount *r)
 {
-	unsigned int nval;
-	unsigned int oval = atomic_load_uint(&r->val);
+	/* A single atomic add with LSE, no retry under contention */
+	unsigned int nval = atomic_dec32(&r->val);
 
-	while (true) {
-		assert(oval);
-		nval = oval - 1;
-
-		if (atomic_cas_uint(&r->val, &oval, nval)) {
-			/*
-			 * Value has been updated, if value was set to 0
-			 * return true to indicate that.
-			 */
-			return !nval;
-		}
-		/*
-		 * At this point atomic_cas_uint() has updated oval to the
-		 * current r->val.
-		 */
-	}
+	/* r->val was 0 */
+	assert(nval != UINT_MAX);
+
+	/* Return true to indicate that the value was set to 0 */
+	return !nval;
 }
@@ -47,7 +47,8 @@ uint32_t tee_b2hs(uint8_t *b, uint8_t *hs, uint32_t blen, uint32_t hslen)
 	return blen * 2;
 }
 
-uint32_t tee_hs2b(uint8_t *hs, uint8_t *b, uint32_t hslen, uint32_t blen)
+uint32_t tee_hs2b(const uint8_t *hs, uint8_t *b, uint32_t hslen,
+		  uint32_t blen)
 {
 	uint32_t i = 0;
 	uint32_t len = TEE_HS2B_BBUF_SIZE(hslen);
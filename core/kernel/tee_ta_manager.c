@@ -9,9 +9,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <arm.h>
+#include <config.h>
 #include <assert.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
+#include <kernel/pmu.h>
 #include <kernel/pseudo_ta.h>
 #include <kernel/tee_common.h>
 #include <kernel/tee_misc.h>
@@ -33,37 +35,114 @@
 #include <utee_types.h>
 #include <util.h>
 
-/* This mutex protects the critical section in tee_ta_init_session */
+/*
+ * This mutex protects the registry of sessions and contexts: the lists,
+ * their indices and the reference counters. It's only held for lookups
+ * and updates, the busy state of a context is protected by the mutex of
+ * the context and the single-instance lock by its own mutex.
+ */
 struct mutex tee_ta_mutex = MUTEX_INITIALIZER;
 struct tee_ta_ctx_head tee_ctxes = TAILQ_HEAD_INITIALIZER(tee_ctxes);
 
+/*
+ * Indices of the open sessions by list and session ID and of the
+ * registered contexts by UUID, protected by tee_ta_mutex. They keep the
+ * lookups done on each invoke independent of the number of sessions.
+ */
+#define SESS_HASH_SIZE	128
+#define CTX_HASH_SIZE	32
+
+LIST_HEAD(sess_hash_head, tee_ta_session);
+LIST_HEAD(ctx_hash_head, tee_ta_ctx);
+
+static struct sess_hash_head sess_hash[SESS_HASH_SIZE];
+static struct ctx_hash_head ctx_hash[CTX_HASH_SIZE];
+
+/*
+ * A thread waiting for a busy context or for the single-instance lock
+ * queues one of these on its stack. The releasing thread hands over to
+ * the first waiter directly, the resource is never seen free in between
+ * so a newcomer can't take it ahead of the queue, and only the thread
+ * granted is woken.
+ */
+struct tee_ta_busy_waiter {
+	struct condvar cv;
+	uint8_t prio;
+	bool granted;
+	TAILQ_ENTRY(tee_ta_busy_waiter) link;
+};
+
+/*
+ * Waits in @head until granted by grant_next_waiter(), @m must be held.
+ * Waiters are ordered by decreasing priority class and by arrival within
+ * a class.
+ */
+static void wait_granted(struct tee_ta_busy_head *head, struct mutex *m,
+			 uint8_t prio)
+{
+	struct tee_ta_busy_waiter w = {
+		.cv = CONDVAR_INITIALIZER,
+		.prio = prio,
+	};
+	struct tee_ta_busy_waiter *p = NULL;
+
+	TAILQ_FOREACH(p, head, link)
+		if (p->prio < prio)
+			break;
+	if (p)
+		TAILQ_INSERT_BEFORE(p, &w, link);
+	else
+		TAILQ_INSERT_TAIL(head, &w, link);
+
+	while (!w.granted)
+		condvar_wait(&w.cv, m);
+}
+
+/*
+ * Hands over to the first waiter in @head if any, the mutex passed to
+ * wait_granted() must be held. Returns false if there was no waiter.
+ */
+static bool grant_next_waiter(struct tee_ta_busy_head *head)
+{
+	struct tee_ta_busy_waiter *w = TAILQ_FIRST(head);
+
+	if (!w)
+		return false;
+
+	TAILQ_REMOVE(head, w, link);
+	w->granted = true;
+	condvar_signal(&w->cv);
+
+	return true;
+}
+
 #ifndef CFG_CONCURRENT_SINGLE_INSTANCE_TA
-static struct condvar tee_ta_cv = CONDVAR_INITIALIZER;
+static struct mutex tee_ta_single_instance_mutex = MUTEX_INITIALIZER;
+static struct tee_ta_busy_head tee_ta_single_instance_waiters =
+	TAILQ_HEAD_INITIALIZER(tee_ta_single_instance_waiters);
 static int tee_ta_single_instance_thread = THREAD_ID_INVALID;
 static size_t tee_ta_single_instance_count;
 #endif
 
 #ifdef CFG_CONCURRENT_SINGLE_INSTANCE_TA
-static void lock_single_instance(void)
-{
-}
-
 static void unlock_single_instance(void)
 {
 }
 
-static bool has_single_instance_lock(void)
+static bool try_lock_single_instance(bool lock __unused,
+				     uint8_t prio __unused)
 {
 	return false;
 }
 #else
-static void lock_single_instance(void)
+static void lock_single_instance(uint8_t prio)
 {
-	/* Requires tee_ta_mutex to be held */
+	/* Requires tee_ta_single_instance_mutex to be held */
 	if (tee_ta_single_instance_thread != thread_get_id()) {
-		/* Wait until the single-instance lock is available. */
-		while (tee_ta_single_instance_thread != THREAD_ID_INVALID)
-			condvar_wait(&tee_ta_cv, &tee_ta_mutex);
+		/* Wait until the single-instance lock is handed over */
+		if (tee_ta_single_instance_thread != THREAD_ID_INVALID)
+			wait_granted(&tee_ta_single_instance_waiters,
+				     &tee_ta_single_instance_mutex, prio);
 
 		tee_ta_single_instance_thread = thread_get_id();
 		assert(tee_ta_single_instance_count == 0);
@@ -74,46 +153,71 @@ static void lock_single_instance(void)
 
 static void unlock_single_instance(void)
 {
-	/* Requires tee_ta_mutex to be held */
+	mutex_lock(&tee_ta_single_instance_mutex);
+
 	assert(tee_ta_single_instance_thread == thread_get_id());
 	assert(tee_ta_single_instance_count > 0);
 
 	tee_ta_single_instance_count--;
 	if (tee_ta_single_instance_count == 0) {
-		tee_ta_single_instance_thread = THREAD_ID_INVALID;
-		condvar_signal(&tee_ta_cv);
+		/* The granted thread takes the lock as its own */
+		if (!grant_next_waiter(&tee_ta_single_instance_waiters))
+			tee_ta_single_instance_thread = THREAD_ID_INVALID;
 	}
+
+	mutex_unlock(&tee_ta_single_instance_mutex);
 }
 
-static bool has_single_instance_lock(void)
+/*
+ * Takes the single-instance lock if @lock is true, returns whether the
+ * current thread is holding it.
+ */
+static bool try_lock_single_instance(bool lock, uint8_t prio)
 {
-	/* Requires tee_ta_mutex to be held */
-	return tee_ta_single_instance_thread == thread_get_id();
+	bool rc = false;
+
+	mutex_lock(&tee_ta_single_instance_mutex);
+
+	if (lock)
+		lock_single_instance(prio);
+	rc = tee_ta_single_instance_thread == thread_get_id();
+
+	mutex_unlock(&tee_ta_single_instance_mutex);
+
+	return rc;
 }
 #endif
 
-static bool tee_ta_try_set_busy(struct tee_ta_ctx *ctx)
+static bool tee_ta_try_set_busy(struct tee_ta_ctx *ctx, uint8_t prio)
 {
 	bool rc = true;
+	bool single_instance_locked = false;
 
 	if (ctx->flags & TA_FLAG_CONCURRENT)
 		return true;
 
-	mutex_lock(&tee_ta_mutex);
-
+	mutex_lock(&ctx->busy_mutex);
 	if (ctx->initializing) {
 		/*
 		 * Context is still initializing and flags cannot be relied
 		 * on for user TAs. Wait here until it's initialized.
 		 */
 		while (ctx->busy)
-			condvar_wait(&ctx->busy_cv, &tee_ta_mutex);
+			condvar_wait(&ctx->busy_cv, &ctx->busy_mutex);
 	}
+	mutex_unlock(&ctx->busy_mutex);
+
+	/*
+	 * The single-instance lock may be waited for, so it's not taken
+	 * with the mutex of the context held.
+	 */
+	single_instance_locked =
+		try_lock_single_instance(ctx->flags & TA_FLAG_SINGLE_INSTANCE,
+					 prio);
 
-	if (ctx->flags & TA_FLAG_SINGLE_INSTANCE)
-		lock_single_instance();
+	mutex_lock(&ctx->busy_mutex);
 
-	if (has_single_instance_lock()) {
+	if (single_instance_locked) {
 		if (ctx->busy) {
 			/*
 			 * We're holding the single-instance lock and the
@@ -121,48 +225,54 @@ static bool tee_ta_try_set_busy(struct tee_ta_ctx *ctx)
 			 * dead-lock, we release the lock and return false.
 			 */
 			rc = false;
-			if (ctx->flags & TA_FLAG_SINGLE_INSTANCE)
-				unlock_single_instance();
 		}
-	} else {
+	} else if (ctx->busy) {
 		/*
 		 * We're not holding the single-instance lock, we're free to
-		 * wait for the TA to become available.
+		 * wait for the TA to be handed over, busy is left set.
 		 */
-		while (ctx->busy)
-			condvar_wait(&ctx->busy_cv, &tee_ta_mutex);
+		wait_granted(&ctx->busy_waiters, &ctx->busy_mutex, prio);
 	}
 
 	/* Either it's already true or we should set it to true */
 	ctx->busy = true;
 
-	mutex_unlock(&tee_ta_mutex);
+	mutex_unlock(&ctx->busy_mutex);
+
+	if (!rc && (ctx->flags & TA_FLAG_SINGLE_INSTANCE))
+		unlock_single_instance();
+
 	return rc;
 }
 
-static void tee_ta_set_busy(struct tee_ta_ctx *ctx)
+static void tee_ta_set_busy(struct tee_ta_ctx *ctx, uint8_t prio)
 {
-	if (!tee_ta_try_set_busy(ctx))
+	if (!tee_ta_try_set_busy(ctx, prio))
 		panic();
 }
 
 static void tee_ta_clear_busy(struct tee_ta_ctx *ctx)
 {
+	bool was_initializing = false;
+
 	if (ctx->flags & TA_FLAG_CONCURRENT)
 		return;
 
-	mutex_lock(&tee_ta_mutex);
+	mutex_lock(&ctx->busy_mutex);
 
 	assert(ctx->busy);
-	ctx->busy = false;
-	condvar_signal(&ctx->busy_cv);
-
-	if (!ctx->initializing && (ctx->flags & TA_FLAG_SINGLE_INSTANCE))
-		unlock_single_instance();
+	if (!grant_next_waiter(&ctx->busy_waiters))
+		ctx->busy = false;
 
+	was_initializing = ctx->initializing;
 	ctx->initializing = false;
+	if (was_initializing)
+		condvar_broadcast(&ctx->busy_cv);
 
-	mutex_unlock(&tee_ta_mutex);
+	mutex_unlock(&ctx->busy_mutex);
+
+	if (!was_initializing && (ctx->flags & TA_FLAG_SINGLE_INSTANCE))
+		unlock_single_instance();
 }
 
 static void dec_session_ref_count(struct tee_ta_session *s)
@@ -186,14 +296,54 @@ void tee_ta_put_session(struct tee_ta_session *s)
 	mutex_unlock(&tee_ta_mutex);
 }
 
+static struct sess_hash_head *sess_bucket(uint32_t id,
+			struct tee_ta_session_head *open_sessions)
+{
+	vaddr_t key = (vaddr_t)open_sessions / sizeof(*open_sessions);
+
+	return sess_hash + (id ^ key) % SESS_HASH_SIZE;
+}
+
+static struct ctx_hash_head *ctx_bucket(const TEE_UUID *uuid)
+{
+	return ctx_hash + (uuid->timeLow ^ uuid->timeMid) % CTX_HASH_SIZE;
+}
+
+static void link_session(struct tee_ta_session *s,
+			 struct tee_ta_session_head *open_sessions)
+{
+	s->open_sessions = open_sessions;
+	TAILQ_INSERT_TAIL(open_sessions, s, link);
+	LIST_INSERT_HEAD(sess_bucket(s->id, open_sessions), s, link_hash);
+}
+
+static void unlink_session(struct tee_ta_session *s,
+			   struct tee_ta_session_head *open_sessions)
+{
+	TAILQ_REMOVE(open_sessions, s, link);
+	LIST_REMOVE(s, link_hash);
+}
+
+void tee_ta_link_ctx(struct tee_ta_ctx *ctx)
+{
+	TAILQ_INSERT_TAIL(&tee_ctxes, ctx, link);
+	LIST_INSERT_HEAD(ctx_bucket(&ctx->uuid), ctx, link_hash);
+}
+
+static void unlink_ctx(struct tee_ta_ctx *ctx)
+{
+	TAILQ_REMOVE(&tee_ctxes, ctx, link);
+	LIST_REMOVE(ctx, link_hash);
+}
+
 static struct tee_ta_session *tee_ta_find_session_nolock(uint32_t id,
 			struct tee_ta_session_head *open_sessions)
 {
 	struct tee_ta_session *s = NULL;
 	struct tee_ta_session *found = NULL;
 
-	TAILQ_FOREACH(s, open_sessions, link) {
-		if (s->id == id) {
+	LIST_FOREACH(s, sess_bucket(id, open_sessions), link_hash) {
+		if (s->id == id && s->open_sessions == open_sessions) {
 			found = s;
 			break;
 		}
@@ -269,7 +419,7 @@ static void tee_ta_unlink_session(struct tee_ta_session *s,
 	while (s->ref_count != 1)
 		condvar_wait(&s->refc_cv, &tee_ta_mutex);
 
-	TAILQ_REMOVE(open_sessions, s, link);
+	unlink_session(s, open_sessions);
 
 	mutex_unlock(&tee_ta_mutex);
 }
@@ -288,6 +438,9 @@ static void destroy_session(struct tee_ta_session *s,
 	tee_ta_unlink_session(s, open_sessions);
 #if defined(CFG_TA_GPROF_SUPPORT)
 	free(s->sbuf);
+#endif
+#if defined(CFG_THREAD_RPC_STATS)
+	free(s->rpc_stats);
 #endif
 	free(s);
 }
@@ -297,6 +450,7 @@ static void destroy_context(struct tee_ta_ctx *ctx)
 	DMSG("Destroy TA ctx (0x%" PRIxVA ")",  (vaddr_t)ctx);
 
 	condvar_destroy(&ctx->busy_cv);
+	mutex_destroy(&ctx->busy_mutex);
 	pgt_flush_ctx(ctx);
 	ctx->ops->destroy(ctx);
 }
@@ -352,7 +506,7 @@ static void destroy_ta_ctx_from_session(struct tee_ta_session *s)
 
 	assert(count == s->ctx->ref_count);
 
-	TAILQ_REMOVE(&tee_ctxes, s->ctx, link);
+	unlink_ctx(s->ctx);
 	mutex_unlock(&tee_ta_mutex);
 
 	destroy_context(s->ctx);
@@ -368,7 +522,7 @@ static struct tee_ta_ctx *tee_ta_context_find(const TEE_UUID *uuid)
 {
 	struct tee_ta_ctx *ctx;
 
-	TAILQ_FOREACH(ctx, &tee_ctxes, link) {
+	LIST_FOREACH(ctx, ctx_bucket(uuid), link_hash) {
 		if (memcmp(&ctx->uuid, uuid, sizeof(TEE_UUID)) == 0)
 			return ctx;
 	}
@@ -524,7 +678,7 @@ TEE_Result tee_ta_close_session(struct tee_ta_session *csess,
 	if (ctx->panicked) {
 		destroy_session(sess, open_sessions);
 	} else {
-		tee_ta_set_busy(ctx);
+		tee_ta_set_busy(ctx, 0);
 		set_invoke_timeout(sess, TEE_TIMEOUT_INFINITE);
 		ctx->ops->enter_close_session(sess);
 		destroy_session(sess, open_sessions);
@@ -540,7 +694,7 @@ TEE_Result tee_ta_close_session(struct tee_ta_session *csess,
 	keep_alive = (ctx->flags & TA_FLAG_INSTANCE_KEEP_ALIVE) &&
 			(ctx->flags & TA_FLAG_SINGLE_INSTANCE);
 	if (!ctx->ref_count && !keep_alive) {
-		TAILQ_REMOVE(&tee_ctxes, ctx, link);
+		unlink_ctx(ctx);
 		mutex_unlock(&tee_ta_mutex);
 
 		destroy_context(ctx);
@@ -635,7 +789,7 @@ static TEE_Result tee_ta_init_session(TEE_ErrorOrigin *err,
 		res = TEE_ERROR_OVERFLOW;
 		goto out;
 	}
-	TAILQ_INSERT_TAIL(open_sessions, s, link);
+	link_session(s, open_sessions);
 
 	/* Look for already loaded TA */
 	ctx = tee_ta_context_find(uuid);
@@ -657,7 +811,10 @@ out:
 	if (res == TEE_SUCCESS) {
 		*sess = s;
 	} else {
-		TAILQ_REMOVE(open_sessions, s, link);
+		unlink_session(s, open_sessions);
+#if defined(CFG_THREAD_RPC_STATS)
+		free(s->rpc_stats);
+#endif
 		free(s);
 	}
 	mutex_unlock(&tee_ta_mutex);
@@ -700,7 +857,7 @@ TEE_Result tee_ta_open_session(TEE_ErrorOrigin *err,
 	/* Save identity of the owner of the session */
 	s->clnt_id = *clnt_id;
 
-	if (tee_ta_try_set_busy(ctx)) {
+	if (tee_ta_try_set_busy(ctx, param->prio)) {
 		set_invoke_timeout(s, cancel_req_to);
 		res = ctx->ops->enter_open_session(s, param, err);
 		tee_ta_clear_busy(ctx);
@@ -754,7 +911,7 @@ TEE_Result tee_ta_invoke_command(TEE_ErrorOrigin *err,
 		return TEE_ERROR_TARGET_DEAD;
 	}
 
-	tee_ta_set_busy(sess->ctx);
+	tee_ta_set_busy(sess->ctx, param->prio);
 
 	set_invoke_timeout(sess, cancel_req_to);
 	res = sess->ctx->ops->enter_invoke_cmd(sess, cmd, param, err);
@@ -843,6 +1000,7 @@ void tee_ta_push_current_session(struct tee_ta_session *sess)
 {
 	struct thread_specific_data *tsd = thread_get_tsd();
 
+	thread_account_run_time();
 	TAILQ_INSERT_HEAD(&tsd->sess_stack, sess, link_tsd);
 	update_current_ctx(tsd);
 }
@@ -853,6 +1011,7 @@ struct tee_ta_session *tee_ta_pop_current_session(void)
 	struct tee_ta_session *s = TAILQ_FIRST(&tsd->sess_stack);
 
 	if (s) {
+		thread_account_run_time();
 		TAILQ_REMOVE(&tsd->sess_stack, s, link_tsd);
 		update_current_ctx(tsd);
 	}
@@ -917,9 +1076,42 @@ static void gprof_update_session_utime(bool suspend, struct tee_ta_session *s,
 		sbuf->usr_entered = now;
 	}
 }
+#elif defined(CFG_TA_PMU_STATS)
+static void gprof_update_session_utime(bool suspend __unused,
+				       struct tee_ta_session *s __unused,
+				       uint64_t now __unused)
+{
+}
+#endif /*CFG_TA_GPROF_SUPPORT*/
+
+#if defined(CFG_TA_PMU_STATS)
+static void pmu_update_session(bool suspend, struct tee_ta_session *s)
+{
+	if (suspend)
+		pmu_stop(&s->pmu_stats);
+	else
+		pmu_start();
+}
+
+void tee_ta_pmu_stop(void)
+{
+	struct tee_ta_session *s = NULL;
+
+	if (tee_ta_get_current_session(&s) == TEE_SUCCESS)
+		pmu_stop(&s->pmu_stats);
+	else
+		pmu_stop(NULL);
+}
+#elif defined(CFG_TA_GPROF_SUPPORT)
+static void pmu_update_session(bool suspend __unused,
+			       struct tee_ta_session *s __unused)
+{
+}
+#endif /*CFG_TA_PMU_STATS*/
 
+#if defined(CFG_TA_GPROF_SUPPORT) || defined(CFG_TA_PMU_STATS)
 /*
- * Update user-mode CPU time for the current session
+ * Update user-mode CPU time and PMU counters for the current session
  * @suspend: true if session is being suspended (leaving user mode), false if
  * it is resumed (entering user mode)
  */
@@ -934,6 +1126,7 @@ static void tee_ta_update_session_utime(bool suspend)
 	now = read_cntpct();
 
 	gprof_update_session_utime(suspend, s, now);
+	pmu_update_session(suspend, s);
 }
 
 void tee_ta_update_session_utime_suspend(void)
@@ -966,6 +1159,9 @@ static void ftrace_update_times(bool suspend)
 
 	if (suspend) {
 		fbuf->suspend_time = now;
+	} else if (IS_ENABLED(CFG_TA_FTRACE_STREAM)) {
+		/* The TA subtracts the offset from the timestamps it records */
+		fbuf->ts_offset += now - fbuf->suspend_time;
 	} else {
 		for (i = 0; i <= fbuf->ret_idx; i++)
 			fbuf->begin_time[i] += now - fbuf->suspend_time;
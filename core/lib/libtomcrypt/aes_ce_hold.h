@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+/*
+ * Modes processing one AES block at a time would otherwise enable and
+ * disable VFP for each block, holding it across an update turns the per
+ * block calls into nested ones which only count.
+ */
+#if defined(_CFG_CORE_LTC_AES_ARM64_CE) || defined(_CFG_CORE_LTC_AES_ARM32_CE)
+#include <tomcrypt_arm_neon.h>
+
+struct aes_ce_hold {
+	struct tomcrypt_arm_neon_state state;
+};
+
+static inline void aes_ce_hold(struct aes_ce_hold *h)
+{
+	tomcrypt_arm_neon_enable(&h->state);
+}
+
+static inline void aes_ce_release(struct aes_ce_hold *h)
+{
+	tomcrypt_arm_neon_disable(&h->state);
+}
+#else
+struct aes_ce_hold {
+};
+
+static inline void aes_ce_hold(struct aes_ce_hold *h __unused)
+{
+}
+
+static inline void aes_ce_release(struct aes_ce_hold *h __unused)
+{
+}
+#endif
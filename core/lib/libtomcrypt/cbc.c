@@ -9,9 +9,15 @@
 #include <stdlib.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
+#include <utee_defines.h>
 #include <util.h>
 
+#ifdef _CFG_CORE_LTC_AES_ARM64_CE
+#include <tomcrypt_arm_neon.h>
+#endif
+
 #include "des2_key.h"
+#include "ltc_index.h"
 
 struct ltc_cbc_ctx {
 	struct crypto_cipher_ctx ctx;
@@ -76,6 +82,29 @@ static void ltc_cbc_final(struct crypto_cipher_ctx *ctx)
 	cbc_done(&to_cbc_ctx(ctx)->state);
 }
 
+/* cbc_done() leaves the key schedule in place, only the IV is replaced */
+static TEE_Result ltc_cbc_reinit(struct crypto_cipher_ctx *ctx,
+				 TEE_OperationMode mode, const uint8_t *iv,
+				 size_t iv_len)
+{
+	struct ltc_cbc_ctx *c = to_cbc_ctx(ctx);
+
+	if (!c->update)
+		return TEE_ERROR_BAD_STATE;
+	if ((int)iv_len != cipher_descriptor[c->cipher_idx]->block_length)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (mode == TEE_MODE_ENCRYPT)
+		c->update = cbc_encrypt;
+	else
+		c->update = cbc_decrypt;
+
+	if (cbc_setiv(iv, iv_len, &c->state) == CRYPT_OK)
+		return TEE_SUCCESS;
+	else
+		return TEE_ERROR_BAD_STATE;
+}
+
 static void ltc_cbc_free_ctx(struct crypto_cipher_ctx *ctx)
 {
 	free(to_cbc_ctx(ctx));
@@ -92,12 +121,66 @@ static void ltc_cbc_copy_state(struct crypto_cipher_ctx *dst_ctx,
 	dst->state = src->state;
 }
 
+#ifdef _CFG_CORE_LTC_AES_ARM64_CE
+/*
+ * Encrypts several AES-CBC streams interleaved, with fewer than four
+ * streams the first one is repeated in the unused lanes.
+ */
+static TEE_Result ltc_cbc_update_multi(struct crypto_cipher_ctx *ctx[],
+				       size_t num, const uint8_t *data[],
+				       size_t len, uint8_t *dst[])
+{
+	symmetric_key *skey[4] = { };
+	unsigned char *iv[4] = { };
+	const unsigned char *pt[4] = { };
+	unsigned char *ct[4] = { };
+	struct ltc_cbc_ctx *c = NULL;
+	size_t n = 0;
+
+	if (num > 4 || len % TEE_AES_BLOCK_SIZE)
+		goto fallback;
+	for (n = 0; n < num; n++) {
+		c = to_cbc_ctx(ctx[n]);
+		if (c->update != cbc_encrypt ||
+		    cipher_descriptor[c->cipher_idx] != &aes_desc)
+			goto fallback;
+	}
+
+	for (n = 0; n < 4; n++) {
+		c = to_cbc_ctx(ctx[n < num ? n : 0]);
+		skey[n] = &c->state.key;
+		iv[n] = c->state.IV;
+		pt[n] = data[n < num ? n : 0];
+		ct[n] = dst[n < num ? n : 0];
+	}
+
+	if (rijndael_cbc_encrypt_4way(pt, ct, len / TEE_AES_BLOCK_SIZE, iv,
+				      skey) == CRYPT_OK)
+		return TEE_SUCCESS;
+
+fallback:
+	for (n = 0; n < num; n++) {
+		TEE_Result res = ltc_cbc_update(ctx[n], false, data[n], len,
+						dst[n]);
+
+		if (res)
+			return res;
+	}
+
+	return TEE_SUCCESS;
+}
+#endif
+
 static const struct crypto_cipher_ops ltc_cbc_ops = {
 	.init = ltc_cbc_init,
 	.update = ltc_cbc_update,
 	.final = ltc_cbc_final,
 	.free_ctx = ltc_cbc_free_ctx,
 	.copy_state = ltc_cbc_copy_state,
+#ifdef _CFG_CORE_LTC_AES_ARM64_CE
+	.update_multi = ltc_cbc_update_multi,
+#endif
+	.reinit = ltc_cbc_reinit,
 };
 
 static TEE_Result ltc_cbc_alloc_ctx(struct crypto_cipher_ctx **ctx_ret,
@@ -123,18 +206,18 @@ static TEE_Result ltc_cbc_alloc_ctx(struct crypto_cipher_ctx **ctx_ret,
 #if defined(_CFG_CORE_LTC_AES)
 TEE_Result crypto_aes_cbc_alloc_ctx(struct crypto_cipher_ctx **ctx)
 {
-	return ltc_cbc_alloc_ctx(ctx, find_cipher("aes"), false);
+	return ltc_cbc_alloc_ctx(ctx, LTC_CIPHER_AES, false);
 }
 #endif
 
 #if defined(_CFG_CORE_LTC_DES)
 TEE_Result crypto_des_cbc_alloc_ctx(struct crypto_cipher_ctx **ctx)
 {
-	return ltc_cbc_alloc_ctx(ctx, find_cipher("des"), false);
+	return ltc_cbc_alloc_ctx(ctx, LTC_CIPHER_DES, false);
 }
 
 TEE_Result crypto_des3_cbc_alloc_ctx(struct crypto_cipher_ctx **ctx)
 {
-	return ltc_cbc_alloc_ctx(ctx, find_cipher("3des"), true);
+	return ltc_cbc_alloc_ctx(ctx, LTC_CIPHER_3DES, true);
 }
 #endif
@@ -12,6 +12,9 @@
 #include <tomcrypt_private.h>
 #include <util.h>
 
+#include "aes_ce_hold.h"
+#include "ltc_index.h"
+
 #define TEE_CCM_KEY_MAX_LENGTH		32
 #define TEE_CCM_NONCE_MAX_LENGTH	13
 #define TEE_CCM_TAG_MAX_LENGTH		16
@@ -66,7 +69,7 @@ static TEE_Result crypto_aes_ccm_init(struct crypto_authenc_ctx *aectx,
 				      size_t payload_len)
 {
 	int ltc_res = 0;
-	int ltc_cipherindex = find_cipher("aes");
+	int ltc_cipherindex = LTC_CIPHER_AES;
 	struct tee_ccm_state *ccm = to_tee_ccm_state(aectx);
 
 	if (ltc_cipherindex < 0)
@@ -106,10 +109,13 @@ static TEE_Result crypto_aes_ccm_update_aad(struct crypto_authenc_ctx *aectx,
 					    const uint8_t *data, size_t len)
 {
 	struct tee_ccm_state *ccm = to_tee_ccm_state(aectx);
+	struct aes_ce_hold hold = { };
 	int ltc_res = 0;
 
 	/* Add the AAD (note: aad can be NULL if aadlen == 0) */
+	aes_ce_hold(&hold);
 	ltc_res = ccm_add_aad(&ccm->ctx, data, len);
+	aes_ce_release(&hold);
 	if (ltc_res != CRYPT_OK)
 		return TEE_ERROR_BAD_STATE;
 
@@ -124,6 +130,7 @@ crypto_aes_ccm_update_payload(struct crypto_authenc_ctx *aectx,
 	int ltc_res = 0;
 	int dir = 0;
 	struct tee_ccm_state *ccm = to_tee_ccm_state(aectx);
+	struct aes_ce_hold hold = { };
 	unsigned char *pt = NULL;
 	unsigned char *ct = NULL;
 
@@ -136,7 +143,9 @@ crypto_aes_ccm_update_payload(struct crypto_authenc_ctx *aectx,
 		ct = (unsigned char *)src_data;
 		dir = CCM_DECRYPT;
 	}
+	aes_ce_hold(&hold);
 	ltc_res = ccm_process(&ccm->ctx, pt, len, ct, dir);
+	aes_ce_release(&hold);
 	if (ltc_res != CRYPT_OK)
 		return TEE_ERROR_BAD_STATE;
 
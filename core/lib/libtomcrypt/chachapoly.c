@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <assert.h>
+#include <crypto/crypto.h>
+#include <crypto/crypto_impl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee_api_types.h>
+#include <tomcrypt_private.h>
+#include <util.h>
+
+/* RFC 8439 section 2.8 only defines these sizes */
+#define TEE_CHACHAPOLY_KEY_LENGTH	32
+#define TEE_CHACHAPOLY_NONCE_LENGTH	12
+#define TEE_CHACHAPOLY_TAG_LENGTH	16
+
+struct tee_chachapoly_state {
+	struct crypto_authenc_ctx aectx;
+	chacha20poly1305_state ctx;	/* the state as defined by LTC */
+};
+
+static const struct crypto_authenc_ops chacha20_poly1305_ops;
+
+static struct tee_chachapoly_state *
+to_tee_chachapoly_state(struct crypto_authenc_ctx *aectx)
+{
+	assert(aectx && aectx->ops == &chacha20_poly1305_ops);
+
+	return container_of(aectx, struct tee_chachapoly_state, aectx);
+}
+
+TEE_Result
+crypto_chacha20_poly1305_alloc_ctx(struct crypto_authenc_ctx **ctx_ret)
+{
+	struct tee_chachapoly_state *ctx = calloc(1, sizeof(*ctx));
+
+	if (!ctx)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	ctx->aectx.ops = &chacha20_poly1305_ops;
+
+	*ctx_ret = &ctx->aectx;
+
+	return TEE_SUCCESS;
+}
+
+static void crypto_chacha20_poly1305_free_ctx(struct crypto_authenc_ctx *aectx)
+{
+	struct tee_chachapoly_state *cp = to_tee_chachapoly_state(aectx);
+
+	zeromem(&cp->ctx, sizeof(cp->ctx));
+	free(cp);
+}
+
+static void
+crypto_chacha20_poly1305_copy_state(struct crypto_authenc_ctx *dst_aectx,
+				    struct crypto_authenc_ctx *src_aectx)
+{
+	struct tee_chachapoly_state *dst_ctx =
+		to_tee_chachapoly_state(dst_aectx);
+	struct tee_chachapoly_state *src_ctx =
+		to_tee_chachapoly_state(src_aectx);
+
+	dst_ctx->ctx = src_ctx->ctx;
+}
+
+static TEE_Result
+crypto_chacha20_poly1305_init(struct crypto_authenc_ctx *aectx,
+			      TEE_OperationMode mode __unused,
+			      const uint8_t *key, size_t key_len,
+			      const uint8_t *nonce, size_t nonce_len,
+			      size_t tag_len, size_t aad_len __unused,
+			      size_t payload_len __unused)
+{
+	struct tee_chachapoly_state *cp = to_tee_chachapoly_state(aectx);
+	int ltc_res = 0;
+
+	if (!key || key_len != TEE_CHACHAPOLY_KEY_LENGTH)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (!nonce || nonce_len != TEE_CHACHAPOLY_NONCE_LENGTH)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (tag_len != TEE_CHACHAPOLY_TAG_LENGTH)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	/* reset the state */
+	memset(&cp->ctx, 0, sizeof(cp->ctx));
+
+	ltc_res = chacha20poly1305_init(&cp->ctx, key, key_len);
+	if (ltc_res != CRYPT_OK)
+		return TEE_ERROR_BAD_STATE;
+
+	/* Derives the Poly1305 key from the first keystream block */
+	ltc_res = chacha20poly1305_setiv(&cp->ctx, nonce, nonce_len);
+	if (ltc_res != CRYPT_OK)
+		return TEE_ERROR_BAD_STATE;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result
+crypto_chacha20_poly1305_update_aad(struct crypto_authenc_ctx *aectx,
+				    const uint8_t *data, size_t len)
+{
+	struct tee_chachapoly_state *cp = to_tee_chachapoly_state(aectx);
+	int ltc_res = 0;
+
+	/* Fails if payload has already been processed */
+	ltc_res = chacha20poly1305_add_aad(&cp->ctx, data, len);
+	if (ltc_res != CRYPT_OK)
+		return TEE_ERROR_BAD_STATE;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result
+crypto_chacha20_poly1305_update_payload(struct crypto_authenc_ctx *aectx,
+					TEE_OperationMode mode,
+					const uint8_t *src_data, size_t len,
+					uint8_t *dst_data)
+{
+	struct tee_chachapoly_state *cp = to_tee_chachapoly_state(aectx);
+	int ltc_res = 0;
+
+	/*
+	 * Called with len == 0 too so that the AAD padding is added to the
+	 * MAC even if there's no payload at all.
+	 */
+	if (mode == TEE_MODE_ENCRYPT)
+		ltc_res = chacha20poly1305_encrypt(&cp->ctx, src_data, len,
+						   dst_data);
+	else
+		ltc_res = chacha20poly1305_decrypt(&cp->ctx, src_data, len,
+						   dst_data);
+	if (ltc_res != CRYPT_OK)
+		return TEE_ERROR_BAD_STATE;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result
+crypto_chacha20_poly1305_enc_final(struct crypto_authenc_ctx *aectx,
+				   const uint8_t *src_data, size_t len,
+				   uint8_t *dst_data, uint8_t *dst_tag,
+				   size_t *dst_tag_len)
+{
+	struct tee_chachapoly_state *cp = to_tee_chachapoly_state(aectx);
+	TEE_Result res = TEE_SUCCESS;
+	unsigned long ltc_tag_len = TEE_CHACHAPOLY_TAG_LENGTH;
+	int ltc_res = 0;
+
+	/* Check the tag length */
+	if (*dst_tag_len < TEE_CHACHAPOLY_TAG_LENGTH) {
+		*dst_tag_len = TEE_CHACHAPOLY_TAG_LENGTH;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	*dst_tag_len = TEE_CHACHAPOLY_TAG_LENGTH;
+
+	/* Finalize the remaining buffer */
+	res = crypto_chacha20_poly1305_update_payload(aectx, TEE_MODE_ENCRYPT,
+						      src_data, len, dst_data);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	/* Compute the tag */
+	ltc_res = chacha20poly1305_done(&cp->ctx, dst_tag, &ltc_tag_len);
+	if (ltc_res != CRYPT_OK)
+		return TEE_ERROR_BAD_STATE;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result
+crypto_chacha20_poly1305_dec_final(struct crypto_authenc_ctx *aectx,
+				   const uint8_t *src_data, size_t len,
+				   uint8_t *dst_data, const uint8_t *tag,
+				   size_t tag_len)
+{
+	struct tee_chachapoly_state *cp = to_tee_chachapoly_state(aectx);
+	TEE_Result res = TEE_ERROR_BAD_STATE;
+	uint8_t dst_tag[TEE_CHACHAPOLY_TAG_LENGTH] = { 0 };
+	unsigned long ltc_tag_len = sizeof(dst_tag);
+	int ltc_res = 0;
+
+	if (tag_len == 0)
+		return TEE_ERROR_SHORT_BUFFER;
+	if (tag_len != TEE_CHACHAPOLY_TAG_LENGTH)
+		return TEE_ERROR_MAC_INVALID;
+
+	/* Process the last buffer, if any */
+	res = crypto_chacha20_poly1305_update_payload(aectx, TEE_MODE_DECRYPT,
+						      src_data, len, dst_data);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	/* Finalize the authentication */
+	ltc_res = chacha20poly1305_done(&cp->ctx, dst_tag, &ltc_tag_len);
+	if (ltc_res != CRYPT_OK)
+		return TEE_ERROR_BAD_STATE;
+
+	if (consttime_memcmp(dst_tag, tag, tag_len) != 0)
+		res = TEE_ERROR_MAC_INVALID;
+	else
+		res = TEE_SUCCESS;
+	return res;
+}
+
+static void crypto_chacha20_poly1305_final(struct crypto_authenc_ctx *aectx)
+{
+	struct tee_chachapoly_state *cp = to_tee_chachapoly_state(aectx);
+
+	zeromem(&cp->ctx, sizeof(cp->ctx));
+}
+
+static const struct crypto_authenc_ops chacha20_poly1305_ops = {
+	.init = crypto_chacha20_poly1305_init,
+	.update_aad = crypto_chacha20_poly1305_update_aad,
+	.update_payload = crypto_chacha20_poly1305_update_payload,
+	.enc_final = crypto_chacha20_poly1305_enc_final,
+	.dec_final = crypto_chacha20_poly1305_dec_final,
+	.final = crypto_chacha20_poly1305_final,
+	.free_ctx = crypto_chacha20_poly1305_free_ctx,
+	.copy_state = crypto_chacha20_poly1305_copy_state,
+};
@@ -13,6 +13,9 @@
 #include <utee_defines.h>
 #include <util.h>
 
+#include "aes_ce_hold.h"
+#include "ltc_index.h"
+
 struct ltc_omac_ctx {
 	struct crypto_mac_ctx ctx;
 	int cipher_idx;
@@ -42,7 +45,14 @@ static TEE_Result ltc_omac_init(struct crypto_mac_ctx *ctx, const uint8_t *key,
 static TEE_Result ltc_omac_update(struct crypto_mac_ctx *ctx,
 				  const uint8_t *data, size_t len)
 {
-	if (omac_process(&to_omac_ctx(ctx)->state, data, len) == CRYPT_OK)
+	struct aes_ce_hold hold = { };
+	int ltc_res = 0;
+
+	aes_ce_hold(&hold);
+	ltc_res = omac_process(&to_omac_ctx(ctx)->state, data, len);
+	aes_ce_release(&hold);
+
+	if (ltc_res == CRYPT_OK)
 		return TEE_SUCCESS;
 	else
 		return TEE_ERROR_BAD_STATE;
@@ -85,7 +95,7 @@ static const struct crypto_mac_ops ltc_omac_ops = {
 TEE_Result crypto_aes_cmac_alloc_ctx(struct crypto_mac_ctx **ctx_ret)
 {
 	struct ltc_omac_ctx *ctx = NULL;
-	int cipher_idx = find_cipher("aes");
+	int cipher_idx = LTC_CIPHER_AES;
 
 	if (cipher_idx < 0)
 		return TEE_ERROR_NOT_SUPPORTED;
@@ -11,6 +11,8 @@
 #include <tomcrypt_private.h>
 #include <util.h>
 
+#include "ltc_index.h"
+
 struct ltc_ctr_ctx {
 	struct crypto_cipher_ctx ctx;
 	int cipher_idx;
@@ -69,6 +71,29 @@ static void ltc_ctr_final(struct crypto_cipher_ctx *ctx)
 	ctr_done(&to_ctr_ctx(ctx)->state);
 }
 
+/* ctr_done() leaves the key schedule in place, only the IV is replaced */
+static TEE_Result ltc_ctr_reinit(struct crypto_cipher_ctx *ctx,
+				 TEE_OperationMode mode, const uint8_t *iv,
+				 size_t iv_len)
+{
+	struct ltc_ctr_ctx *c = to_ctr_ctx(ctx);
+
+	if (!c->update)
+		return TEE_ERROR_BAD_STATE;
+	if ((int)iv_len != cipher_descriptor[c->cipher_idx]->block_length)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (mode == TEE_MODE_ENCRYPT)
+		c->update = ctr_encrypt;
+	else
+		c->update = ctr_decrypt;
+
+	if (ctr_setiv(iv, iv_len, &c->state) == CRYPT_OK)
+		return TEE_SUCCESS;
+	else
+		return TEE_ERROR_BAD_STATE;
+}
+
 static void ltc_ctr_free_ctx(struct crypto_cipher_ctx *ctx)
 {
 	free(to_ctr_ctx(ctx));
@@ -91,12 +116,13 @@ static const struct crypto_cipher_ops ltc_ctr_ops = {
 	.final = ltc_ctr_final,
 	.free_ctx = ltc_ctr_free_ctx,
 	.copy_state = ltc_ctr_copy_state,
+	.reinit = ltc_ctr_reinit,
 };
 
 TEE_Result crypto_aes_ctr_alloc_ctx(struct crypto_cipher_ctx **ctx_ret)
 {
 	struct ltc_ctr_ctx *c = NULL;
-	int cipher_idx = find_cipher("aes");
+	int cipher_idx = LTC_CIPHER_AES;
 
 	if (cipher_idx < 0)
 		return TEE_ERROR_NOT_SUPPORTED;
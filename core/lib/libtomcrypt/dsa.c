@@ -13,6 +13,7 @@
 #include <utee_defines.h>
 
 #include "acipher_helpers.h"
+#include "ltc_index.h"
 
 TEE_Result crypto_acipher_alloc_dsa_keypair(struct dsa_keypair *s,
 					    size_t key_size_bits __unused)
@@ -76,7 +77,7 @@ TEE_Result crypto_acipher_gen_dsa_key(struct dsa_keypair *key, size_t key_size)
 		group_size = 40;
 
 	/* Generate the DSA key */
-	ltc_res = dsa_make_key(NULL, find_prng("prng_crypto"), group_size,
+	ltc_res = dsa_make_key(NULL, LTC_PRNG_CRYPTO, group_size,
 			       modulus_size, &ltc_tmp_key);
 	if (ltc_res != CRYPT_OK) {
 		res = TEE_ERROR_BAD_PARAMETERS;
@@ -147,7 +148,7 @@ TEE_Result crypto_acipher_dsa_sign(uint32_t algo, struct dsa_keypair *key,
 	}
 
 	ltc_res = dsa_sign_hash_raw(msg, msg_len, r, s, NULL,
-				    find_prng("prng_crypto"), &ltc_key);
+				    LTC_PRNG_CRYPTO, &ltc_key);
 
 	if (ltc_res == CRYPT_OK) {
 		*sig_len = 2 * mp_unsigned_bin_size(ltc_key.q);
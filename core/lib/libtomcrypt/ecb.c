@@ -12,6 +12,7 @@
 #include <util.h>
 
 #include "des2_key.h"
+#include "ltc_index.h"
 
 struct ltc_ecb_ctx {
 	struct crypto_cipher_ctx ctx;
@@ -74,6 +75,25 @@ static void ltc_ecb_final(struct crypto_cipher_ctx *ctx)
 	ecb_done(&to_ecb_ctx(ctx)->state);
 }
 
+/* ecb_done() leaves the key schedule in place, there's nothing to reset */
+static TEE_Result ltc_ecb_reinit(struct crypto_cipher_ctx *ctx,
+				 TEE_OperationMode mode,
+				 const uint8_t *iv __unused,
+				 size_t iv_len __unused)
+{
+	struct ltc_ecb_ctx *c = to_ecb_ctx(ctx);
+
+	if (!c->update)
+		return TEE_ERROR_BAD_STATE;
+
+	if (mode == TEE_MODE_ENCRYPT)
+		c->update = ecb_encrypt;
+	else
+		c->update = ecb_decrypt;
+
+	return TEE_SUCCESS;
+}
+
 static void ltc_ecb_free_ctx(struct crypto_cipher_ctx *ctx)
 {
 	free(to_ecb_ctx(ctx));
@@ -96,6 +116,7 @@ static const struct crypto_cipher_ops ltc_ecb_ops = {
 	.final = ltc_ecb_final,
 	.free_ctx = ltc_ecb_free_ctx,
 	.copy_state = ltc_ecb_copy_state,
+	.reinit = ltc_ecb_reinit,
 };
 
 static TEE_Result ltc_ecb_alloc_ctx(struct crypto_cipher_ctx **ctx_ret,
@@ -121,18 +142,18 @@ static TEE_Result ltc_ecb_alloc_ctx(struct crypto_cipher_ctx **ctx_ret,
 #if defined(_CFG_CORE_LTC_AES)
 TEE_Result crypto_aes_ecb_alloc_ctx(struct crypto_cipher_ctx **ctx)
 {
-	return ltc_ecb_alloc_ctx(ctx, find_cipher("aes"), false);
+	return ltc_ecb_alloc_ctx(ctx, LTC_CIPHER_AES, false);
 }
 #endif
 
 #if defined(_CFG_CORE_LTC_DES)
 TEE_Result crypto_des_ecb_alloc_ctx(struct crypto_cipher_ctx **ctx)
 {
-	return ltc_ecb_alloc_ctx(ctx, find_cipher("des"), false);
+	return ltc_ecb_alloc_ctx(ctx, LTC_CIPHER_DES, false);
 }
 
 TEE_Result crypto_des3_ecb_alloc_ctx(struct crypto_cipher_ctx **ctx)
 {
-	return ltc_ecb_alloc_ctx(ctx, find_cipher("3des"), true);
+	return ltc_ecb_alloc_ctx(ctx, LTC_CIPHER_3DES, true);
 }
 #endif
@@ -12,6 +12,7 @@
 #include <utee_defines.h>
 
 #include "acipher_helpers.h"
+#include "ltc_index.h"
 
 TEE_Result crypto_acipher_alloc_ecc_keypair(struct ecc_keypair *s,
 					    size_t key_size_bits __unused)
@@ -152,7 +153,7 @@ TEE_Result crypto_acipher_gen_ecc_key(struct ecc_keypair *key)
 		return res;
 
 	/* Generate the ECC key */
-	ltc_res = ecc_make_key(NULL, find_prng("prng_crypto"),
+	ltc_res = ecc_make_key(NULL, LTC_PRNG_CRYPTO,
 			       key_size_bytes, &ltc_tmp_key);
 	if (ltc_res != CRYPT_OK)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -287,7 +288,7 @@ TEE_Result crypto_acipher_ecc_sign(uint32_t algo, struct ecc_keypair *key,
 
 	ltc_sig_len = *sig_len;
 	ltc_res = ecc_sign_hash_rfc7518(msg, msg_len, sig, &ltc_sig_len,
-				    NULL, find_prng("prng_crypto"), &ltc_key);
+				    NULL, LTC_PRNG_CRYPTO, &ltc_key);
 	if (ltc_res == CRYPT_OK) {
 		res = TEE_SUCCESS;
 	} else {
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <crypto/crypto.h>
+#include <string.h>
+#include <string_ext.h>
+#include <tee_api_types.h>
+#include <tomcrypt_private.h>
+
+#include "acipher_helpers.h"
+
+TEE_Result crypto_acipher_gen_ed25519_key(struct ed25519_keypair *key)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	curve25519_key ltc_key = { };
+
+	/* The private key is a random seed, RFC 8032 section 5.1.5 */
+	res = crypto_rng_read(key->priv, sizeof(key->priv));
+	if (res)
+		return res;
+
+	if (ed25519_set_key(key->priv, sizeof(key->priv), NULL, 0,
+			    &ltc_key) != CRYPT_OK)
+		res = TEE_ERROR_BAD_PARAMETERS;
+	else
+		memcpy(key->pub, ltc_key.pub, sizeof(key->pub));
+
+	memzero_explicit(&ltc_key, sizeof(ltc_key));
+	return res;
+}
+
+TEE_Result crypto_acipher_ed25519_sign(struct ed25519_keypair *key,
+				       const uint8_t *msg, size_t msg_len,
+				       uint8_t *sig, size_t *sig_len)
+{
+	TEE_Result res = TEE_SUCCESS;
+	curve25519_key ltc_key = { };
+	unsigned long ltc_sig_len = 0;
+	int ltc_res = 0;
+
+	if (*sig_len < 2 * CURVE25519_KEY_SIZE) {
+		*sig_len = 2 * CURVE25519_KEY_SIZE;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	/* Checks that the public key matches the private key */
+	if (ed25519_set_key(key->priv, sizeof(key->priv), key->pub,
+			    sizeof(key->pub), &ltc_key) != CRYPT_OK)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	ltc_sig_len = *sig_len;
+	ltc_res = ed25519_sign(msg, msg_len, sig, &ltc_sig_len, &ltc_key);
+	if (ltc_res == CRYPT_OK)
+		*sig_len = ltc_sig_len;
+	else if (ltc_res == CRYPT_MEM)
+		res = TEE_ERROR_OUT_OF_MEMORY;
+	else
+		res = TEE_ERROR_BAD_PARAMETERS;
+
+	memzero_explicit(&ltc_key, sizeof(ltc_key));
+	return res;
+}
+
+TEE_Result crypto_acipher_ed25519_verify(struct ed25519_public_key *key,
+					 const uint8_t *msg, size_t msg_len,
+					 const uint8_t *sig, size_t sig_len)
+{
+	curve25519_key ltc_key = { };
+	int ltc_stat = 0;
+	int ltc_res = 0;
+
+	if (sig_len != 2 * CURVE25519_KEY_SIZE)
+		return TEE_ERROR_SIGNATURE_INVALID;
+
+	if (ed25519_set_key(NULL, 0, key->pub, sizeof(key->pub),
+			    &ltc_key) != CRYPT_OK)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	ltc_res = ed25519_verify(msg, msg_len, sig, sig_len, &ltc_stat,
+				 &ltc_key);
+	if (ltc_res == CRYPT_MEM)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	/* A public key that isn't a curve point can't verify anything */
+	if (ltc_res == CRYPT_ERROR)
+		return TEE_ERROR_SIGNATURE_INVALID;
+	return convert_ltc_verify_status(ltc_res, ltc_stat);
+}
@@ -12,6 +12,8 @@
 #include <tomcrypt_private.h>
 #include <util.h>
 
+#include "ltc_index.h"
+
 #define TEE_GCM_TAG_MAX_LENGTH		16
 
 struct tee_gcm_state {
@@ -65,7 +67,7 @@ static TEE_Result crypto_aes_gcm_init(struct crypto_authenc_ctx *aectx,
 				      size_t payload_len __unused)
 {
 	int ltc_res = 0;
-	int ltc_cipherindex = find_cipher("aes");
+	int ltc_cipherindex = LTC_CIPHER_AES;
 	struct tee_gcm_state *gcm = to_tee_gcm_state(aectx);
 
 	if (ltc_cipherindex < 0)
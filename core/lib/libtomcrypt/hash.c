@@ -13,6 +13,8 @@
 #include <utee_defines.h>
 #include <util.h>
 
+#include "ltc_index.h"
+
 /******************************************************************************
  * Message digest functions
  ******************************************************************************/
@@ -128,42 +130,42 @@ static TEE_Result ltc_hash_alloc_ctx(struct crypto_hash_ctx **ctx_ret,
 #if defined(_CFG_CORE_LTC_MD5)
 TEE_Result crypto_md5_alloc_ctx(struct crypto_hash_ctx **ctx)
 {
-	return ltc_hash_alloc_ctx(ctx, find_hash("md5"));
+	return ltc_hash_alloc_ctx(ctx, LTC_HASH_MD5);
 }
 #endif
 
 #if defined(_CFG_CORE_LTC_SHA1)
 TEE_Result crypto_sha1_alloc_ctx(struct crypto_hash_ctx **ctx)
 {
-	return ltc_hash_alloc_ctx(ctx, find_hash("sha1"));
+	return ltc_hash_alloc_ctx(ctx, LTC_HASH_SHA1);
 }
 #endif
 
 #if defined(_CFG_CORE_LTC_SHA224)
 TEE_Result crypto_sha224_alloc_ctx(struct crypto_hash_ctx **ctx)
 {
-	return ltc_hash_alloc_ctx(ctx, find_hash("sha224"));
+	return ltc_hash_alloc_ctx(ctx, LTC_HASH_SHA224);
 }
 #endif
 
 #if defined(_CFG_CORE_LTC_SHA256)
 TEE_Result crypto_sha256_alloc_ctx(struct crypto_hash_ctx **ctx)
 {
-	return ltc_hash_alloc_ctx(ctx, find_hash("sha256"));
+	return ltc_hash_alloc_ctx(ctx, LTC_HASH_SHA256);
 }
 #endif
 
 #if defined(_CFG_CORE_LTC_SHA384)
 TEE_Result crypto_sha384_alloc_ctx(struct crypto_hash_ctx **ctx)
 {
-	return ltc_hash_alloc_ctx(ctx, find_hash("sha384"));
+	return ltc_hash_alloc_ctx(ctx, LTC_HASH_SHA384);
 }
 #endif
 
 #if defined(_CFG_CORE_LTC_SHA512)
 TEE_Result crypto_sha512_alloc_ctx(struct crypto_hash_ctx **ctx)
 {
-	return ltc_hash_alloc_ctx(ctx, find_hash("sha512"));
+	return ltc_hash_alloc_ctx(ctx, LTC_HASH_SHA512);
 }
 #endif
 
@@ -8,15 +8,21 @@
 #include <crypto/crypto_impl.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string_ext.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
 #include <utee_defines.h>
 #include <util.h>
 
+#include "ltc_index.h"
+
 struct ltc_hmac_ctx {
 	struct crypto_mac_ctx ctx;
 	int hash_idx;
 	hmac_state state;
+	/* The state right after hmac_init(), see ltc_hmac_reinit() */
+	hmac_state init_state;
+	bool keyed;
 };
 
 static const struct crypto_mac_ops ltc_hmac_ops;
@@ -33,10 +39,30 @@ static TEE_Result ltc_hmac_init(struct crypto_mac_ctx *ctx, const uint8_t *key,
 {
 	struct ltc_hmac_ctx *hc = to_hmac_ctx(ctx);
 
-	if (hmac_init(&hc->state, hc->hash_idx, key, len) == CRYPT_OK)
-		return TEE_SUCCESS;
-	else
+	hc->keyed = false;
+	if (hmac_init(&hc->state, hc->hash_idx, key, len) != CRYPT_OK)
 		return TEE_ERROR_BAD_STATE;
+
+	hc->init_state = hc->state;
+	hc->keyed = true;
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * hmac_done() wipes the state, so restarting takes a copy of the state
+ * saved by ltc_hmac_init() where the inner padded key is already hashed.
+ */
+static TEE_Result ltc_hmac_reinit(struct crypto_mac_ctx *ctx)
+{
+	struct ltc_hmac_ctx *hc = to_hmac_ctx(ctx);
+
+	if (!hc->keyed)
+		return TEE_ERROR_BAD_STATE;
+
+	hc->state = hc->init_state;
+
+	return TEE_SUCCESS;
 }
 
 static TEE_Result ltc_hmac_update(struct crypto_mac_ctx *ctx,
@@ -61,7 +87,10 @@ static TEE_Result ltc_hmac_final(struct crypto_mac_ctx *ctx, uint8_t *digest,
 
 static void ltc_hmac_free_ctx(struct crypto_mac_ctx *ctx)
 {
-	free(to_hmac_ctx(ctx));
+	struct ltc_hmac_ctx *hc = to_hmac_ctx(ctx);
+
+	memzero_explicit(&hc->init_state, sizeof(hc->init_state));
+	free(hc);
 }
 
 static void ltc_hmac_copy_state(struct crypto_mac_ctx *dst_ctx,
@@ -72,6 +101,8 @@ static void ltc_hmac_copy_state(struct crypto_mac_ctx *dst_ctx,
 
 	assert(src->hash_idx == dst->hash_idx);
 	dst->state = src->state;
+	dst->init_state = src->init_state;
+	dst->keyed = src->keyed;
 }
 
 static const struct crypto_mac_ops ltc_hmac_ops = {
@@ -80,6 +111,7 @@ static const struct crypto_mac_ops ltc_hmac_ops = {
 	.final = ltc_hmac_final,
 	.free_ctx = ltc_hmac_free_ctx,
 	.copy_state = ltc_hmac_copy_state,
+	.reinit = ltc_hmac_reinit,
 };
 
 static TEE_Result ltc_hmac_alloc_ctx(struct crypto_mac_ctx **ctx_ret,
@@ -103,30 +135,30 @@ static TEE_Result ltc_hmac_alloc_ctx(struct crypto_mac_ctx **ctx_ret,
 
 TEE_Result crypto_hmac_md5_alloc_ctx(struct crypto_mac_ctx **ctx)
 {
-	return ltc_hmac_alloc_ctx(ctx, find_hash("md5"));
+	return ltc_hmac_alloc_ctx(ctx, LTC_HASH_MD5);
 }
 
 TEE_Result crypto_hmac_sha1_alloc_ctx(struct crypto_mac_ctx **ctx)
 {
-	return ltc_hmac_alloc_ctx(ctx, find_hash("sha1"));
+	return ltc_hmac_alloc_ctx(ctx, LTC_HASH_SHA1);
 }
 
 TEE_Result crypto_hmac_sha224_alloc_ctx(struct crypto_mac_ctx **ctx)
 {
-	return ltc_hmac_alloc_ctx(ctx, find_hash("sha224"));
+	return ltc_hmac_alloc_ctx(ctx, LTC_HASH_SHA224);
 }
 
 TEE_Result crypto_hmac_sha256_alloc_ctx(struct crypto_mac_ctx **ctx)
 {
-	return ltc_hmac_alloc_ctx(ctx, find_hash("sha256"));
+	return ltc_hmac_alloc_ctx(ctx, LTC_HASH_SHA256);
 }
 
 TEE_Result crypto_hmac_sha384_alloc_ctx(struct crypto_mac_ctx **ctx)
 {
-	return ltc_hmac_alloc_ctx(ctx, find_hash("sha384"));
+	return ltc_hmac_alloc_ctx(ctx, LTC_HASH_SHA384);
 }
 
 TEE_Result crypto_hmac_sha512_alloc_ctx(struct crypto_mac_ctx **ctx)
 {
-	return ltc_hmac_alloc_ctx(ctx, find_hash("sha512"));
+	return ltc_hmac_alloc_ctx(ctx, LTC_HASH_SHA512);
 }
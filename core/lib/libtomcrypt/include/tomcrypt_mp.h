@@ -12,4 +12,10 @@ void init_mp_tomcrypt(void);
 static inline void init_mp_tomcrypt(void) { }
 #endif
 
+#if defined(_CFG_CORE_LTC_ECC_FIXED_BASE) && defined(_CFG_CORE_LTC_MPI)
+/* ltc_mp.ecc_ptmul() using precomputed tables for the NIST generators */
+int mpi_ecc_fixed_base_mulmod(void *k, const ecc_point *G, ecc_point *R,
+			      void *a, void *modulus, int map);
+#endif
+
 #endif /* TOMCRYPT_MP_H_ */
@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __LTC_INDEX_H
+#define __LTC_INDEX_H
+
+/*
+ * Indices of the LibTomCrypt descriptors registered by tee_ltc_reg_algs()
+ * in registration order. The set of registered descriptors is fixed by
+ * the configuration, so the indices replace the lookups by name with
+ * find_cipher(), find_hash() and find_prng().
+ */
+
+enum ltc_cipher_index {
+#if defined(_CFG_CORE_LTC_AES) || defined(_CFG_CORE_LTC_AES_DESC)
+	LTC_CIPHER_AES,
+#endif
+#if defined(_CFG_CORE_LTC_DES)
+	LTC_CIPHER_DES,
+	LTC_CIPHER_3DES,
+#endif
+	LTC_CIPHER_COUNT
+};
+
+enum ltc_hash_index {
+#if defined(_CFG_CORE_LTC_MD5)
+	LTC_HASH_MD5,
+#endif
+#if defined(_CFG_CORE_LTC_SHA1)
+	LTC_HASH_SHA1,
+#endif
+#if defined(_CFG_CORE_LTC_SHA224)
+	LTC_HASH_SHA224,
+#endif
+#if defined(_CFG_CORE_LTC_SHA256) || defined(_CFG_CORE_LTC_SHA256_DESC)
+	LTC_HASH_SHA256,
+#endif
+#if defined(_CFG_CORE_LTC_SHA384) || defined(_CFG_CORE_LTC_SHA384_DESC)
+	LTC_HASH_SHA384,
+#endif
+#if defined(_CFG_CORE_LTC_SHA512) || defined(_CFG_CORE_LTC_SHA512_DESC)
+	LTC_HASH_SHA512,
+#endif
+	LTC_HASH_COUNT
+};
+
+enum ltc_prng_index {
+#if defined(_CFG_CORE_LTC_ACIPHER)
+	LTC_PRNG_CRYPTO,
+#endif
+	LTC_PRNG_COUNT
+};
+
+#endif /*__LTC_INDEX_H*/
@@ -554,7 +554,7 @@ static void montgomery_deinit(void *a)
  * @c: modulus
  * @d: destination
  */
-static int exptmod(void *a, void *b, void *c, void *d)
+static int exptmod_rr(void *a, void *b, void *c, mbedtls_mpi *rr, void *d)
 {
 	int res;
 
@@ -562,12 +562,12 @@ static int exptmod(void *a, void *b, void *c, void *d)
 		mbedtls_mpi dest;
 
 		mbedtls_mpi_init_mempool(&dest);
-		res = mbedtls_mpi_exp_mod(&dest, a, b, c, NULL);
+		res = mbedtls_mpi_exp_mod(&dest, a, b, c, rr);
 		if (!res)
 			res = mbedtls_mpi_copy(d, &dest);
 		mbedtls_mpi_free(&dest);
 	} else {
-		res = mbedtls_mpi_exp_mod(d, a, b, c, NULL);
+		res = mbedtls_mpi_exp_mod(d, a, b, c, rr);
 	}
 
 	if (res)
@@ -576,6 +576,51 @@ static int exptmod(void *a, void *b, void *c, void *d)
 		return CRYPT_OK;
 }
 
+static int exptmod(void *a, void *b, void *c, void *d)
+{
+	return exptmod_rr(a, b, c, NULL, d);
+}
+
+/*
+ * Like exptmod() but with R^2 mod c kept in @cache between calls.
+ *
+ * mbedtls_mpi_exp_mod() can compute and return R^2 mod c itself, but
+ * it's then allocated from the mempool which only is meant for temporary
+ * variables. So it's computed here on the heap instead, with R depending
+ * on the number of limbs in c exactly as in mbedtls_mpi_exp_mod().
+ */
+static int exptmod_cached(void *a, void *b, void *c, void **cache, void *d)
+{
+	const mbedtls_mpi *n = c;
+	mbedtls_mpi *rr = *cache;
+
+	if (!rr) {
+		rr = malloc(sizeof(*rr));
+		if (!rr)
+			return CRYPT_MEM;
+		mbedtls_mpi_init(rr);
+		if (mbedtls_mpi_lset(rr, 1) ||
+		    mbedtls_mpi_shift_l(rr, n->n * 2 * sizeof(*n->p) * 8) ||
+		    mbedtls_mpi_mod_mpi(rr, rr, n)) {
+			mbedtls_mpi_free(rr);
+			free(rr);
+			return CRYPT_MEM;
+		}
+		*cache = rr;
+	}
+
+	return exptmod_rr(a, b, c, rr, d);
+}
+
+static void exptmod_cache_free(void *cache)
+{
+	if (cache) {
+		/* mbedtls_mpi_free() also wipes the value */
+		mbedtls_mpi_free(cache);
+		free(cache);
+	}
+}
+
 static int rng_read(void *ignored __unused, unsigned char *buf, size_t blen)
 {
 	if (crypto_rng_read(buf, blen))
@@ -583,9 +628,10 @@ static int rng_read(void *ignored __unused, unsigned char *buf, size_t blen)
 	return 0;
 }
 
-static int isprime(void *a, int b __unused, int *c)
+/* @b is the number of Miller-Rabin rounds, <= 0 selects the default */
+static int isprime(void *a, int b, int *c)
 {
-	int res = mbedtls_mpi_is_prime(a, rng_read, NULL);
+	int res = mbedtls_mpi_is_prime_ext(a, b > 0 ? b : 40, rng_read, NULL);
 
 	if (res == MBEDTLS_ERR_MPI_ALLOC_FAILED)
 		return CRYPT_MEM;
@@ -662,6 +708,8 @@ ltc_math_descriptor ltc_mp = {
 #ifdef LTC_MECC
 #ifdef LTC_MECC_FP
 	.ecc_ptmul = &ltc_ecc_fp_mulmod,
+#elif defined(_CFG_CORE_LTC_ECC_FIXED_BASE)
+	.ecc_ptmul = &mpi_ecc_fixed_base_mulmod,
 #else
 	.ecc_ptmul = &ltc_ecc_mulmod,
 #endif /* LTC_MECC_FP */
@@ -682,6 +730,8 @@ ltc_math_descriptor ltc_mp = {
 	.rsa_me = &rsa_exptmod,
 #endif
 	.rand = &mpa_rand,
+	.exptmod_cached = &exptmod_cached,
+	.exptmod_cache_free = &exptmod_cache_free,
 
 };
 
@@ -0,0 +1,428 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/mutex.h>
+#include <mbedtls/bignum.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tomcrypt_private.h>
+#include <tomcrypt_mp.h>
+#include <util.h>
+
+/*
+ * Scalar multiplication of the NIST P-256 and P-384 generators with a
+ * fixed-base comb, as used by ECC key generation and ECDSA signing.
+ *
+ * The comb needs 2^(w-1) precomputed points T[i] = G + sum_j b_j 2^(jd) G
+ * where b_j is bit j - 1 of i for j = 1 .. w - 1 and d = ceil(bits / w).
+ * The scalar is recoded as in mbedtls ecp_comb_recode_core() so that each
+ * of the d + 1 comb digits selects a signed, non-zero entry. The result is
+ * then obtained with d doublings and d additions, compared to one doubling
+ * and one addition per bit in the timing resistant ltc_ecc_mulmod().
+ *
+ * Every entry of the table is read regardless of the digit, so the memory
+ * access pattern doesn't depend on the scalar. The tables are computed on
+ * first use of each curve and kept until reboot.
+ */
+
+#define ciL		(sizeof(mbedtls_mpi_uint))
+#define biL		(ciL << 3)
+
+#define COMB_MAX_D	64
+#define COMB_MAX_LIMBS	(384 / biL)
+
+struct comb_curve {
+	const char *oid;
+	unsigned int w;
+
+	bool loaded;		/* Parameters below read from the curve */
+	size_t limbs;
+	size_t d;
+	mbedtls_mpi prime;
+	mbedtls_mpi order;
+	mbedtls_mpi gx;
+	mbedtls_mpi gy;
+
+	/* x and y of each entry in Montgomery form, z is one */
+	mbedtls_mpi_uint *table;
+	mbedtls_mpi one;	/* R mod prime */
+};
+
+static struct comb_curve comb_curves[] = {
+	{ .oid = "1.2.840.10045.3.1.7", .w = 5 },	/* P-256 */
+	{ .oid = "1.3.132.0.34", .w = 6 },		/* P-384 */
+};
+
+static struct mutex comb_mutex = MUTEX_INITIALIZER;
+
+static size_t comb_entries(const struct comb_curve *cc)
+{
+	return BIT(cc->w - 1);
+}
+
+static void get_limbs(mbedtls_mpi_uint *dst, size_t limbs,
+		      const mbedtls_mpi *src)
+{
+	size_t n = MIN(limbs, src->n);
+
+	memcpy(dst, src->p, n * ciL);
+	memset(dst + n, 0, (limbs - n) * ciL);
+}
+
+static int set_limbs(mbedtls_mpi *dst, const mbedtls_mpi_uint *src,
+		     size_t limbs)
+{
+	if (mbedtls_mpi_grow(dst, limbs))
+		return CRYPT_MEM;
+
+	memcpy(dst->p, src, limbs * ciL);
+	memset(dst->p + limbs, 0, (dst->n - limbs) * ciL);
+	dst->s = 1;
+
+	return CRYPT_OK;
+}
+
+/* Parameters are kept on the heap, the mempool is for temporaries only */
+static int load_curve(struct comb_curve *cc)
+{
+	const ltc_ecc_curve *cu = NULL;
+
+	if (ecc_find_curve(cc->oid, &cu) != CRYPT_OK)
+		return CRYPT_ERROR;
+
+	mbedtls_mpi_init(&cc->prime);
+	mbedtls_mpi_init(&cc->order);
+	mbedtls_mpi_init(&cc->gx);
+	mbedtls_mpi_init(&cc->gy);
+	mbedtls_mpi_init(&cc->one);
+
+	if (mbedtls_mpi_read_string(&cc->prime, 16, cu->prime) ||
+	    mbedtls_mpi_read_string(&cc->order, 16, cu->order) ||
+	    mbedtls_mpi_read_string(&cc->gx, 16, cu->Gx) ||
+	    mbedtls_mpi_read_string(&cc->gy, 16, cu->Gy))
+		goto err;
+
+	cc->limbs = (mbedtls_mpi_bitlen(&cc->prime) + biL - 1) / biL;
+	cc->d = (mbedtls_mpi_bitlen(&cc->order) + cc->w - 1) / cc->w;
+	if (cc->limbs > COMB_MAX_LIMBS || cc->d > COMB_MAX_D)
+		goto err;
+
+	cc->loaded = true;
+	return CRYPT_OK;
+err:
+	mbedtls_mpi_free(&cc->prime);
+	mbedtls_mpi_free(&cc->order);
+	mbedtls_mpi_free(&cc->gx);
+	mbedtls_mpi_free(&cc->gy);
+	return CRYPT_ERROR;
+}
+
+static bool is_generator(const struct comb_curve *cc, void *modulus,
+			 const ecc_point *G)
+{
+	return !mbedtls_mpi_cmp_mpi(modulus, &cc->prime) &&
+	       !mbedtls_mpi_cmp_mpi(G->x, &cc->gx) &&
+	       !mbedtls_mpi_cmp_mpi(G->y, &cc->gy) &&
+	       !mbedtls_mpi_cmp_int(G->z, 1);
+}
+
+static mbedtls_mpi_uint *entry_x(const struct comb_curve *cc, size_t idx)
+{
+	return cc->table + idx * 2 * cc->limbs;
+}
+
+static mbedtls_mpi_uint *entry_y(const struct comb_curve *cc, size_t idx)
+{
+	return entry_x(cc, idx) + cc->limbs;
+}
+
+static int set_one(const struct comb_curve *cc, void *z)
+{
+	if (mbedtls_mpi_copy(z, &cc->one))
+		return CRYPT_MEM;
+	return CRYPT_OK;
+}
+
+static int load_entry(const struct comb_curve *cc, size_t idx, ecc_point *P)
+{
+	int err = set_limbs(P->x, entry_x(cc, idx), cc->limbs);
+
+	if (err)
+		return err;
+	err = set_limbs(P->y, entry_y(cc, idx), cc->limbs);
+	if (err)
+		return err;
+	return set_one(cc, P->z);
+}
+
+/* Stores P, in Montgomery projective form, as affine entry @idx */
+static int store_entry(struct comb_curve *cc, size_t idx, ecc_point *P,
+		       void *modulus, void *mp)
+{
+	int err = ltc_ecc_map(P, modulus, mp);
+
+	if (err)
+		return err;
+	err = mp_mulmod(P->x, &cc->one, modulus, P->x);
+	if (err)
+		return err;
+	err = mp_mulmod(P->y, &cc->one, modulus, P->y);
+	if (err)
+		return err;
+
+	get_limbs(entry_x(cc, idx), cc->limbs, P->x);
+	get_limbs(entry_y(cc, idx), cc->limbs, P->y);
+	return CRYPT_OK;
+}
+
+static int build_table(struct comb_curve *cc, void *modulus,
+		       const ecc_point *G)
+{
+	size_t table_size = comb_entries(cc) * 2 * cc->limbs * ciL;
+	ecc_point *P = NULL;
+	ecc_point *Q = NULL;
+	void *mp = NULL;
+	size_t i = 0;
+	size_t j = 0;
+	int err = CRYPT_MEM;
+
+	cc->table = calloc(1, table_size);
+	if (!cc->table)
+		return CRYPT_MEM;
+
+	P = ltc_ecc_new_point();
+	Q = ltc_ecc_new_point();
+	if (!P || !Q)
+		goto out;
+
+	err = mp_montgomery_setup(modulus, &mp);
+	if (err)
+		goto out;
+	err = mp_montgomery_normalization(&cc->one, modulus);
+	if (err)
+		goto out;
+
+	/* P = G in Montgomery form, T[0] = G */
+	err = mp_mulmod(G->x, &cc->one, modulus, P->x);
+	if (!err)
+		err = mp_mulmod(G->y, &cc->one, modulus, P->y);
+	if (!err)
+		err = set_one(cc, P->z);
+	if (!err)
+		err = ltc_ecc_copy_point(P, Q);
+	if (!err)
+		err = store_entry(cc, 0, Q, modulus, mp);
+	if (err)
+		goto out;
+
+	for (j = 1; j < cc->w; j++) {
+		/* P = 2^(jd) G */
+		for (i = 0; i < cc->d; i++) {
+			err = ltc_mp.ecc_ptdbl(P, P, NULL, modulus, mp);
+			if (err)
+				goto out;
+		}
+
+		/* T[2^(j-1) + i] = T[i] + 2^(jd) G */
+		for (i = 0; i < BIT(j - 1); i++) {
+			err = load_entry(cc, i, Q);
+			if (!err)
+				err = ltc_mp.ecc_ptadd(Q, P, Q, NULL, modulus,
+						       mp);
+			if (!err)
+				err = store_entry(cc, BIT(j - 1) + i, Q,
+						  modulus, mp);
+			if (err)
+				goto out;
+		}
+	}
+
+	err = CRYPT_OK;
+out:
+	if (mp)
+		mp_montgomery_free(mp);
+	ltc_ecc_del_point(Q);
+	ltc_ecc_del_point(P);
+	if (err) {
+		mbedtls_mpi_free(&cc->one);
+		free(cc->table);
+		cc->table = NULL;
+	}
+	return err;
+}
+
+/* Returns the comb for G if it's the generator of a supported curve */
+static const struct comb_curve *get_comb(void *modulus, const ecc_point *G)
+{
+	struct comb_curve *cc = NULL;
+	size_t n = 0;
+
+	mutex_lock(&comb_mutex);
+	for (n = 0; n < ARRAY_SIZE(comb_curves); n++) {
+		if (!comb_curves[n].loaded && load_curve(comb_curves + n))
+			continue;
+		if (is_generator(comb_curves + n, modulus, G)) {
+			if (comb_curves[n].table ||
+			    !build_table(comb_curves + n, modulus, G))
+				cc = comb_curves + n;
+			break;
+		}
+	}
+	mutex_unlock(&comb_mutex);
+
+	return cc;
+}
+
+/*
+ * Splits odd m into the d + 1 comb digits, bit 7 of a digit is set if
+ * the entry is to be subtracted instead of added
+ */
+static void recode_scalar(const struct comb_curve *cc, const mbedtls_mpi *m,
+			  uint8_t *x)
+{
+	size_t i = 0;
+	size_t j = 0;
+	uint8_t adjust = 0;
+	uint8_t carry = 0;
+	uint8_t next = 0;
+
+	memset(x, 0, cc->d + 1);
+	for (i = 0; i < cc->d; i++)
+		for (j = 0; j < cc->w; j++)
+			x[i] |= mbedtls_mpi_get_bit(m, i + cc->d * j) << j;
+
+	/* Make x[1] .. x[d] odd without branches */
+	for (i = 1; i <= cc->d; i++) {
+		next = x[i] & carry;
+		x[i] ^= carry;
+		carry = next;
+
+		adjust = 1 - (x[i] & 1);
+		carry |= x[i] & (x[i - 1] * adjust);
+		x[i] ^= x[i - 1] * adjust;
+		x[i - 1] |= adjust << 7;
+	}
+}
+
+/* P = +/- T[(digit & 0x7f) >> 1], reading every entry of the table */
+static int select_entry(const struct comb_curve *cc, uint8_t digit,
+			ecc_point *P, mbedtls_mpi *tmp)
+{
+	mbedtls_mpi_uint x[COMB_MAX_LIMBS] = { 0 };
+	mbedtls_mpi_uint y[COMB_MAX_LIMBS] = { 0 };
+	mbedtls_mpi_uint idx = (digit & 0x7f) >> 1;
+	mbedtls_mpi_uint mask = 0;
+	size_t i = 0;
+	size_t l = 0;
+	int err = CRYPT_OK;
+
+	for (i = 0; i < comb_entries(cc); i++) {
+		/* All ones if i == idx, else zero */
+		mask = 0 - (((mbedtls_mpi_uint)(i ^ idx) - 1) >> (biL - 1));
+		for (l = 0; l < cc->limbs; l++) {
+			x[l] |= entry_x(cc, i)[l] & mask;
+			y[l] |= entry_y(cc, i)[l] & mask;
+		}
+	}
+
+	err = set_limbs(P->x, x, cc->limbs);
+	if (!err)
+		err = set_limbs(P->y, y, cc->limbs);
+	if (!err && mbedtls_mpi_sub_mpi(tmp, &cc->prime, P->y))
+		err = CRYPT_MEM;
+	if (!err && mbedtls_mpi_safe_cond_assign(P->y, tmp, digit >> 7))
+		err = CRYPT_MEM;
+
+	zeromem(x, sizeof(x));
+	zeromem(y, sizeof(y));
+	return err;
+}
+
+static int comb_mulmod(const struct comb_curve *cc, void *k, ecc_point *R,
+		       void *modulus, int map)
+{
+	uint8_t x[COMB_MAX_D + 1] = { 0 };
+	ecc_point *acc = NULL;
+	ecc_point *T = NULL;
+	mbedtls_mpi m;
+	mbedtls_mpi tmp;
+	void *mp = NULL;
+	uint8_t odd = 0;
+	size_t i = 0;
+	int err = CRYPT_MEM;
+
+	mbedtls_mpi_init_mempool(&m);
+	mbedtls_mpi_init_mempool(&tmp);
+
+	acc = ltc_ecc_new_point();
+	T = ltc_ecc_new_point();
+	if (!acc || !T)
+		goto out;
+
+	err = mp_montgomery_setup(modulus, &mp);
+	if (err)
+		goto out;
+
+	/* The comb needs an odd scalar, use order - k for even k */
+	odd = mbedtls_mpi_get_bit(k, 0);
+	if (mbedtls_mpi_copy(&m, k) ||
+	    mbedtls_mpi_sub_mpi(&tmp, &cc->order, k) ||
+	    mbedtls_mpi_safe_cond_assign(&m, &tmp, !odd)) {
+		err = CRYPT_MEM;
+		goto out;
+	}
+	recode_scalar(cc, &m, x);
+
+	err = select_entry(cc, x[cc->d], acc, &tmp);
+	if (!err)
+		err = set_one(cc, acc->z);
+	if (!err)
+		err = set_one(cc, T->z);
+	if (err)
+		goto out;
+
+	for (i = cc->d; i > 0; i--) {
+		err = ltc_mp.ecc_ptdbl(acc, acc, NULL, modulus, mp);
+		if (!err)
+			err = select_entry(cc, x[i - 1], T, &tmp);
+		if (!err)
+			err = ltc_mp.ecc_ptadd(acc, T, acc, NULL, modulus, mp);
+		if (err)
+			goto out;
+	}
+
+	/* Negate the result back for even k */
+	if (mbedtls_mpi_sub_mpi(&tmp, &cc->prime, acc->y) ||
+	    mbedtls_mpi_safe_cond_assign(acc->y, &tmp, !odd)) {
+		err = CRYPT_MEM;
+		goto out;
+	}
+
+	err = ltc_ecc_copy_point(acc, R);
+	if (!err && map)
+		err = ltc_ecc_map(R, modulus, mp);
+out:
+	zeromem(x, sizeof(x));
+	if (mp)
+		mp_montgomery_free(mp);
+	ltc_ecc_del_point(T);
+	ltc_ecc_del_point(acc);
+	mbedtls_mpi_free(&tmp);
+	mbedtls_mpi_free(&m);
+	return err;
+}
+
+int mpi_ecc_fixed_base_mulmod(void *k, const ecc_point *G, ecc_point *R,
+			      void *a, void *modulus, int map)
+{
+	const struct comb_curve *cc = get_comb(modulus, G);
+
+	/* The comb only covers 0 < k < order, leave the rest to LTC */
+	if (!cc || mbedtls_mpi_cmp_int(k, 0) <= 0 ||
+	    mbedtls_mpi_cmp_mpi(k, &cc->order) >= 0)
+		return ltc_ecc_mulmod(k, G, R, a, modulus, map);
+
+	return comb_mulmod(cc, k, R, modulus, map);
+}
@@ -14,6 +14,7 @@
 #include <utee_defines.h>
 
 #include "acipher_helpers.h"
+#include "ltc_index.h"
 
 
 /*
@@ -31,40 +32,40 @@ static TEE_Result tee_algo_to_ltc_hashindex(uint32_t algo, int *ltc_hashindex)
 	case TEE_ALG_RSASSA_PKCS1_V1_5_SHA1:
 	case TEE_ALG_RSASSA_PKCS1_PSS_MGF1_SHA1:
 	case TEE_ALG_RSAES_PKCS1_OAEP_MGF1_SHA1:
-		*ltc_hashindex = find_hash("sha1");
+		*ltc_hashindex = LTC_HASH_SHA1;
 		break;
 #endif
 #if defined(_CFG_CORE_LTC_MD5)
 	case TEE_ALG_RSASSA_PKCS1_V1_5_MD5:
-		*ltc_hashindex = find_hash("md5");
+		*ltc_hashindex = LTC_HASH_MD5;
 		break;
 #endif
 #if defined(_CFG_CORE_LTC_SHA224)
 	case TEE_ALG_RSASSA_PKCS1_V1_5_SHA224:
 	case TEE_ALG_RSASSA_PKCS1_PSS_MGF1_SHA224:
 	case TEE_ALG_RSAES_PKCS1_OAEP_MGF1_SHA224:
-		*ltc_hashindex = find_hash("sha224");
+		*ltc_hashindex = LTC_HASH_SHA224;
 		break;
 #endif
 #if defined(_CFG_CORE_LTC_SHA256)
 	case TEE_ALG_RSASSA_PKCS1_V1_5_SHA256:
 	case TEE_ALG_RSASSA_PKCS1_PSS_MGF1_SHA256:
 	case TEE_ALG_RSAES_PKCS1_OAEP_MGF1_SHA256:
-		*ltc_hashindex = find_hash("sha256");
+		*ltc_hashindex = LTC_HASH_SHA256;
 		break;
 #endif
 #if defined(_CFG_CORE_LTC_SHA384)
 	case TEE_ALG_RSASSA_PKCS1_V1_5_SHA384:
 	case TEE_ALG_RSASSA_PKCS1_PSS_MGF1_SHA384:
 	case TEE_ALG_RSAES_PKCS1_OAEP_MGF1_SHA384:
-		*ltc_hashindex = find_hash("sha384");
+		*ltc_hashindex = LTC_HASH_SHA384;
 		break;
 #endif
 #if defined(_CFG_CORE_LTC_SHA512)
 	case TEE_ALG_RSASSA_PKCS1_V1_5_SHA512:
 	case TEE_ALG_RSASSA_PKCS1_PSS_MGF1_SHA512:
 	case TEE_ALG_RSAES_PKCS1_OAEP_MGF1_SHA512:
-		*ltc_hashindex = find_hash("sha512");
+		*ltc_hashindex = LTC_HASH_SHA512;
 		break;
 #endif
 	case TEE_ALG_RSASSA_PKCS1_V1_5:
@@ -139,6 +140,34 @@ void crypto_acipher_free_rsa_public_key(struct rsa_public_key *s)
 	crypto_bignum_free(s->e);
 }
 
+/*
+ * Returns the values kept in @key between private key operations,
+ * allocated on first use. The operations work without them too so NULL
+ * is also returned if the allocation fails.
+ */
+static rsa_exptmod_cache *get_exptmod_cache(struct rsa_keypair *key)
+{
+	if (!key->cache && ltc_mp.exptmod_cached)
+		key->cache = calloc(1, sizeof(rsa_exptmod_cache));
+
+	return key->cache;
+}
+
+void crypto_acipher_clear_rsa_keypair_cache(struct rsa_keypair *s)
+{
+	rsa_exptmod_cache *cache = NULL;
+
+	if (!s || !s->cache)
+		return;
+
+	cache = s->cache;
+	ltc_mp.exptmod_cache_free(cache->p);
+	ltc_mp.exptmod_cache_free(cache->q);
+	ltc_mp.exptmod_cache_free(cache->N);
+	free(cache);
+	s->cache = NULL;
+}
+
 TEE_Result crypto_acipher_gen_rsa_key(struct rsa_keypair *key, size_t key_size)
 {
 	TEE_Result res;
@@ -146,11 +175,13 @@ TEE_Result crypto_acipher_gen_rsa_key(struct rsa_keypair *key, size_t key_size)
 	int ltc_res;
 	long e;
 
+	crypto_acipher_clear_rsa_keypair_cache(key);
+
 	/* get the public exponent */
 	e = mp_get_int(key->e);
 
 	/* Generate a temporary RSA key */
-	ltc_res = rsa_make_key(NULL, find_prng("prng_crypto"), key_size / 8, e,
+	ltc_res = rsa_make_key(NULL, LTC_PRNG_CRYPTO, key_size / 8, e,
 			       &ltc_tmp_key);
 	if (ltc_res != CRYPT_OK) {
 		res = TEE_ERROR_BAD_PARAMETERS;
@@ -270,6 +301,7 @@ TEE_Result crypto_acipher_rsanopad_decrypt(struct rsa_keypair *key,
 		ltc_key.dP = key->dp;
 		ltc_key.dQ = key->dq;
 	}
+	ltc_key.cache = get_exptmod_cache(key);
 
 	res = rsadorep(&ltc_key, src, src_len, dst, dst_len);
 	return res;
@@ -298,6 +330,7 @@ TEE_Result crypto_acipher_rsaes_decrypt(uint32_t algo, struct rsa_keypair *key,
 		ltc_key.dP = key->dp;
 		ltc_key.dQ = key->dq;
 	}
+	ltc_key.cache = get_exptmod_cache(key);
 
 	/* Get the algorithm */
 	res = tee_algo_to_ltc_hashindex(algo, &ltc_hashindex);
@@ -406,7 +439,7 @@ TEE_Result crypto_acipher_rsaes_encrypt(uint32_t algo,
 
 	ltc_res = rsa_encrypt_key_ex(src, src_len, dst,
 				     (unsigned long *)(dst_len), label,
-				     label_len, NULL, find_prng("prng_crypto"),
+				     label_len, NULL, LTC_PRNG_CRYPTO,
 				     ltc_hashindex, ltc_rsa_algo, &ltc_key);
 	switch (ltc_res) {
 	case CRYPT_PK_INVALID_PADDING:
@@ -450,6 +483,7 @@ TEE_Result crypto_acipher_rsassa_sign(uint32_t algo, struct rsa_keypair *key,
 		ltc_key.dP = key->dp;
 		ltc_key.dQ = key->dq;
 	}
+	ltc_key.cache = get_exptmod_cache(key);
 
 	switch (algo) {
 	case TEE_ALG_RSASSA_PKCS1_V1_5:
@@ -504,7 +538,7 @@ TEE_Result crypto_acipher_rsassa_sign(uint32_t algo, struct rsa_keypair *key,
 	ltc_sig_len = mod_size;
 
 	ltc_res = rsa_sign_hash_ex(msg, msg_len, sig, &ltc_sig_len,
-				   ltc_rsa_algo, NULL, find_prng("prng_crypto"),
+				   ltc_rsa_algo, NULL, LTC_PRNG_CRYPTO,
 				   ltc_hashindex, salt_len, &ltc_key);
 
 	*sig_len = ltc_sig_len;
@@ -64,6 +64,17 @@ void ce_aes_cbc_decrypt(u8 out[], u8 const in[], u8 const rk[], int rounds,
 			int blocks, u8 iv[]);
 void ce_aes_ctr_encrypt(u8 out[], u8 const in[], u8 const rk[], int rounds,
 			int blocks, u8 ctr[], int first);
+#ifdef _CFG_CORE_LTC_AES_ARM64_CE
+struct ce_aes_cbc_stream {
+	u8 *out;
+	u8 const *in;
+	u8 const *rk;
+	u8 *iv;
+};
+
+void ce_aes_cbc_encrypt_4way(struct ce_aes_cbc_stream s[4], int rounds,
+			     int blocks);
+#endif
 void ce_aes_xts_encrypt(u8 out[], u8 const in[], u8 const rk1[], int rounds,
 			int blocks, u8 const rk2[], u8 iv[]);
 void ce_aes_xts_decrypt(u8 out[], u8 const in[], u8 const rk1[], int rounds,
@@ -258,6 +269,44 @@ static int aes_cbc_encrypt_nblocks(const unsigned char *pt, unsigned char *ct,
 	return CRYPT_OK;
 }
 
+#ifdef _CFG_CORE_LTC_AES_ARM64_CE
+int rijndael_cbc_encrypt_4way(const unsigned char *pt[4], unsigned char *ct[4],
+			      unsigned long blocks, unsigned char *IV[4],
+			      symmetric_key *skey[4])
+{
+	struct tomcrypt_arm_neon_state state;
+	struct ce_aes_cbc_stream s[4];
+	int Nr;
+	int n;
+
+	LTC_ARGCHK(pt);
+	LTC_ARGCHK(ct);
+	LTC_ARGCHK(IV);
+	LTC_ARGCHK(skey);
+
+	Nr = skey[0]->rijndael.Nr;
+	for (n = 0; n < 4; n++) {
+		LTC_ARGCHK(pt[n]);
+		LTC_ARGCHK(ct[n]);
+		LTC_ARGCHK(IV[n]);
+		LTC_ARGCHK(skey[n]);
+		if (skey[n]->rijndael.Nr != Nr)
+			return CRYPT_INVALID_ARG;
+
+		s[n].out = ct[n];
+		s[n].in = pt[n];
+		s[n].rk = (u8 *)skey[n]->rijndael.eK;
+		s[n].iv = IV[n];
+	}
+
+	tomcrypt_arm_neon_enable(&state);
+	ce_aes_cbc_encrypt_4way(s, Nr, blocks);
+	tomcrypt_arm_neon_disable(&state);
+
+	return CRYPT_OK;
+}
+#endif
+
 static int aes_cbc_decrypt_nblocks(const unsigned char *ct, unsigned char *pt,
 				   unsigned long blocks, unsigned char *IV,
 				   symmetric_key *skey)
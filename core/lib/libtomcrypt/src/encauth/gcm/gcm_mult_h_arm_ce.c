@@ -18,7 +18,8 @@ void gcm_mult_h(gcm_state *gcm, unsigned char *I)
 {
 	struct tomcrypt_arm_neon_state state;
 	const uint8_t zeroes[TEE_AES_BLOCK_SIZE] = { 0 };
-	uint64_t k[2];
+	/* Room for H^2, H^3 and H^4 loaded, but unused, by the arm64 p64 code */
+	uint64_t k[8] = { 0 };
 	uint64_t a;
 	uint64_t b;
 	uint64_t dg[2];
@@ -7,9 +7,8 @@ ifeq ($(SHA256),y)
 SHA256_CE := $(call cfg-one-enabled, _CFG_CORE_LTC_SHA256_ARM32_CE \
 				     _CFG_CORE_LTC_SHA256_ARM64_CE)
 ifeq ($(SHA256_CE),y)
+# The assembly is in core/arch/arm/crypto
 srcs-y += sha256_armv8a_ce.c
-srcs-$(_CFG_CORE_LTC_SHA256_ARM32_CE) += sha256_armv8a_ce_a32.S
-srcs-$(_CFG_CORE_LTC_SHA256_ARM64_CE) += sha256_armv8a_ce_a64.S
 else
 srcs-y += sha256.c
 endif
@@ -17,6 +16,13 @@ endif
 
 srcs-$(call cfg-one-enabled, _CFG_CORE_LTC_SHA384 \
 			     _CFG_CORE_LTC_SHA384_DESC) += sha384.c
-srcs-$(call cfg-one-enabled, _CFG_CORE_LTC_SHA512 \
-			     _CFG_CORE_LTC_SHA512_DESC) += sha512.c
+SHA512 := $(call cfg-one-enabled, _CFG_CORE_LTC_SHA512 _CFG_CORE_LTC_SHA512_DESC)
+ifeq ($(SHA512),y)
+ifeq ($(_CFG_CORE_LTC_SHA512_ARM64_CE),y)
+srcs-y += sha512_armv8a_ce.c
+srcs-y += sha512_armv8a_ce_a64.S
+else
+srcs-y += sha512.c
+endif
+endif
 srcs-$(_CFG_CORE_LTC_SHA512_256) += sha512_256.c
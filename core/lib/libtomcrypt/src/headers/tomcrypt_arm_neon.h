@@ -16,4 +16,21 @@ void tomcrypt_arm_neon_enable(struct tomcrypt_arm_neon_state *state);
 /* Disables neon instructions after a call to tomcrypt_arm_neon_enable() */
 void tomcrypt_arm_neon_disable(struct tomcrypt_arm_neon_state *state);
 
+/*
+ * Encrypts blocks of four independent AES-CBC streams at once, all keys
+ * must have the same size. Streams may be repeated, the same result is
+ * then written twice.
+ */
+union Symmetric_key;
+int rijndael_cbc_encrypt_4way(const unsigned char *pt[4], unsigned char *ct[4],
+			      unsigned long blocks, unsigned char *IV[4],
+			      union Symmetric_key *skey[4]);
+
+/*
+ * XORs four blocks (256 bytes) of ChaCha keystream into @in, starting at
+ * the block counter in state[12]. state[12] isn't updated.
+ */
+void chacha_4block_xor_neon(const ulong32 *state, unsigned char *out,
+			    const unsigned char *in, int rounds);
+
 #endif /*TOMCRYPT_ARM_NEON_H*/
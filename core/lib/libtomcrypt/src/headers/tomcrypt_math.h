@@ -512,6 +512,24 @@ typedef struct {
       @return CRYPT_OK on success
    */
    int (*rand)(void *a, int size);
+
+/* ---- (optional) cached exponentiation ---- */
+
+   /** Modular exponentiation reusing values derived from the modulus
+      @param a      The base integer
+      @param b      The power integer
+      @param c      The modulus integer
+      @param cache  [in/out] The values derived from c, computed and
+                    stored here on first use if NULL
+      @param d      The destination
+      @return CRYPT_OK on success
+   */
+   int (*exptmod_cached)(void *a, void *b, void *c, void **cache, void *d);
+
+   /** Free and wipe the values stored by exptmod_cached
+      @param cache  The values to free, may be NULL
+   */
+   void (*exptmod_cache_free)(void *cache);
 } ltc_math_descriptor;
 
 extern ltc_math_descriptor ltc_mp;
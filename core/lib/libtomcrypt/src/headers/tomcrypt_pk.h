@@ -29,6 +29,13 @@ int rand_prime(void *N, long len, prng_state *prng, int wprng);
 /* ---- RSA ---- */
 #ifdef LTC_MRSA
 
+/** Values cached by ltc_mp.exptmod_cached for the RSA private key moduli */
+typedef struct {
+    void *p;
+    void *q;
+    void *N;
+} rsa_exptmod_cache;
+
 /** RSA PKCS style key */
 typedef struct Rsa_key {
     /** Type of key, PK_PRIVATE or PK_PUBLIC */
@@ -49,6 +56,8 @@ typedef struct Rsa_key {
     void *dP;
     /** The d mod (q - 1) CRT param */
     void *dQ;
+    /** (optional) Values kept between private key operations, NULL if unused */
+    rsa_exptmod_cache *cache;
 } rsa_key;
 
 int rsa_make_key(prng_state *prng, int wprng, int size, long e, rsa_key *key);
@@ -1,2 +1,3 @@
 subdirs-$(_CFG_CORE_LTC_HMAC) += hmac
 subdirs-$(_CFG_CORE_LTC_CMAC) += omac
+subdirs-$(_CFG_CORE_LTC_CHACHA20_POLY1305) += poly1305
@@ -18,19 +18,41 @@ typedef unsigned char u8;
 typedef ulong32 u32;
 typedef ulong64 u64;
 typedef long64 i64;
-typedef i64 gf[16];
 
-static const u8
-  _9[32] = {9};
+#ifdef __SIZEOF_INT128__
+/*
+ * Radix 2^51: five unsigned 64-bit limbs, 128-bit products. Elements are
+ * kept unreduced, limbs are below 2^52 after M() and S() and must be below
+ * 2^54 when passed to them.
+ */
+typedef unsigned __int128 u128;
+typedef u64 limb;
+#define NLIMBS 5
+#define MASK51 (((u64)1 << 51) - 1)
+#else
+/*
+ * Radix 2^25.5: ten signed limbs of alternately 26 and 25 bits with 64-bit
+ * products, as in the ref10 implementation. Limbs may exceed their width
+ * by a few bits and go negative between multiplications.
+ */
+typedef int limb;
+#define NLIMBS 10
+#endif
+typedef limb gf[NLIMBS];
+
 static const gf
   gf0,
   gf1 = {1},
-  _121665 = {0xDB41,1},
-  D = {0x78a3, 0x1359, 0x4dca, 0x75eb, 0xd8ab, 0x4141, 0x0a4d, 0x0070, 0xe898, 0x7779, 0x4079, 0x8cc7, 0xfe73, 0x2b6f, 0x6cee, 0x5203},
-  D2 = {0xf159, 0x26b2, 0x9b94, 0xebd6, 0xb156, 0x8283, 0x149a, 0x00e0, 0xd130, 0xeef3, 0x80f2, 0x198e, 0xfce7, 0x56df, 0xd9dc, 0x2406},
-  X = {0xd51a, 0x8f25, 0x2d60, 0xc956, 0xa7b2, 0x9525, 0xc760, 0x692c, 0xdc5c, 0xfdd6, 0xe231, 0xc0a4, 0x53fe, 0xcd6e, 0x36d3, 0x2169},
-  Y = {0x6658, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666},
-  I = {0xa0b0, 0x4a0e, 0x1b27, 0xc4ee, 0xe478, 0xad2f, 0x1806, 0x2f43, 0xd7a7, 0x3dfb, 0x0099, 0x2b4d, 0xdf0b, 0x4fc1, 0x2480, 0x2b83};
+  _121665 = {0x1DB41},
+#ifdef __SIZEOF_INT128__
+  D = {0x34dca135978a3, 0x1a8283b156ebd, 0x5e7a26001c029, 0x739c663a03cbb, 0x52036cee2b6ff},
+  D2 = {0x69b9426b2f159, 0x35050762add7a, 0x3cf44c0038052, 0x6738cc7407977, 0x2406d9dc56dff},
+  I = {0x61b274a0ea0b0, 0xd5a5fc8f189d, 0x7ef5e9cbd0c60, 0x78595a6804c9e, 0x2b8324804fc1d};
+#else
+  D = {0x35978a3, 0xd37284, 0x3156ebd, 0x6a0a0e, 0x1c029, 0x179e898, 0x3a03cbb, 0x1ce7198, 0x2e2b6ff, 0x1480db3},
+  D2 = {0x2b2f159, 0x1a6e509, 0x22add7a, 0xd4141d, 0x38052, 0xf3d130, 0x3407977, 0x19ce331, 0x1c56dff, 0x901b67},
+  I = {0x20ea0b0, 0x186c9d2, 0x8f189d, 0x35697f, 0xbd0c60, 0x1fbd7a7, 0x2804c9e, 0x1e16569, 0x4fc1d, 0xae0c92};
+#endif
 
 static int vn(const u8 *x,const u8 *y,int n)
 {
@@ -48,144 +70,388 @@ static int tweetnacl_crypto_verify_32(const u8 *x,const u8 *y)
 sv set25519(gf r, const gf a)
 {
   int i;
-  FOR(i,16) r[i]=a[i];
-}
-
-sv car25519(gf o)
-{
-  int i;
-  i64 c;
-  FOR(i,16) {
-    o[i]+=(1LL<<16);
-    c=o[i]>>16;
-    o[(i+1)*(i<15)]+=c-1+37*(c-1)*(i==15);
-    o[i]-=c<<16;
-  }
+  FOR(i,NLIMBS) r[i]=a[i];
 }
 
+/* Constant time swap of p and q if b is 1 */
 sv sel25519(gf p,gf q,int b)
 {
-  i64 t,i,c=~(b-1);
-  FOR(i,16) {
+  limb t,c=-(limb)b;
+  int i;
+  FOR(i,NLIMBS) {
     t= c&(p[i]^q[i]);
     p[i]^=t;
     q[i]^=t;
   }
 }
 
-sv pack25519(u8 *o,const gf n)
+/* Constant time p = q if b is 1 */
+sv cmov25519(gf p,const gf q,int b)
 {
-  int i,j,b;
-  gf m,t;
-  FOR(i,16) t[i]=n[i];
-  car25519(t);
-  car25519(t);
-  car25519(t);
-  FOR(j,2) {
-    m[0]=t[0]-0xffed;
-    for(i=1;i<15;i++) {
-      m[i]=t[i]-0xffff-((m[i-1]>>16)&1);
-      m[i-1]&=0xffff;
-    }
-    m[15]=t[15]-0x7fff-((m[14]>>16)&1);
-    b=(m[15]>>16)&1;
-    m[14]&=0xffff;
-    sel25519(t,m,1-b);
+  limb c=-(limb)b;
+  int i;
+  FOR(i,NLIMBS) p[i]^=c&(p[i]^q[i]);
+}
+
+sv A(gf o,const gf a,const gf b)
+{
+  int i;
+  FOR(i,NLIMBS) o[i]=a[i]+b[i];
+}
+
+#ifdef __SIZEOF_INT128__
+static const gf _4p = {0x1fffffffffffb4, 0x1ffffffffffffc, 0x1ffffffffffffc,
+                       0x1ffffffffffffc, 0x1ffffffffffffc};
+
+/* Limbs of b must not exceed those of 4p, outputs of M() and S() never do */
+sv Z(gf o,const gf a,const gf b)
+{
+  int i;
+  FOR(i,5) o[i]=a[i]+_4p[i]-b[i];
+}
+
+sv car25519(gf o)
+{
+  int i;
+  u64 c;
+  FOR(i,4) {
+    c=o[i]>>51;
+    o[i]&=MASK51;
+    o[i+1]+=c;
   }
-  FOR(i,16) {
-    o[2*i]=t[i]&0xff;
-    o[2*i+1]=t[i]>>8;
+  c=o[4]>>51;
+  o[4]&=MASK51;
+  o[0]+=19*c;
+}
+
+/* Folds the five 128-bit column sums of a product into o */
+sv carry_wide(gf o,u128 t[5])
+{
+  u64 c;
+  int i;
+  FOR(i,4) {
+    t[i+1]+=(u64)(t[i]>>51);
+    o[i]=(u64)t[i]&MASK51;
   }
+  c=(u64)(t[4]>>51);
+  o[4]=(u64)t[4]&MASK51;
+  o[0]+=19*c;
+  o[1]+=o[0]>>51;
+  o[0]&=MASK51;
 }
 
-static int neq25519(const gf a, const gf b)
+sv M(gf o,const gf a,const gf b)
 {
-  u8 c[32],d[32];
-  pack25519(c,a);
-  pack25519(d,b);
-  return tweetnacl_crypto_verify_32(c,d);
+  u64 b19[5];
+  u128 t[5];
+  int i;
+  FOR(i,5) b19[i]=19*b[i];
+  t[0]=(u128)a[0]*b[0]+(u128)a[1]*b19[4]+(u128)a[2]*b19[3]+(u128)a[3]*b19[2]+(u128)a[4]*b19[1];
+  t[1]=(u128)a[0]*b[1]+(u128)a[1]*b[0]+(u128)a[2]*b19[4]+(u128)a[3]*b19[3]+(u128)a[4]*b19[2];
+  t[2]=(u128)a[0]*b[2]+(u128)a[1]*b[1]+(u128)a[2]*b[0]+(u128)a[3]*b19[4]+(u128)a[4]*b19[3];
+  t[3]=(u128)a[0]*b[3]+(u128)a[1]*b[2]+(u128)a[2]*b[1]+(u128)a[3]*b[0]+(u128)a[4]*b19[4];
+  t[4]=(u128)a[0]*b[4]+(u128)a[1]*b[3]+(u128)a[2]*b[2]+(u128)a[3]*b[1]+(u128)a[4]*b[0];
+  carry_wide(o,t);
 }
 
-static u8 par25519(const gf a)
+sv S(gf o,const gf a)
 {
-  u8 d[32];
-  pack25519(d,a);
-  return d[0]&1;
+  u64 d0=2*a[0],d1=2*a[1],d2=2*a[2];
+  u64 a3_19=19*a[3],a4_19=19*a[4];
+  u128 t[5];
+  t[0]=(u128)a[0]*a[0]+(u128)d1*a4_19+(u128)d2*a3_19;
+  t[1]=(u128)d0*a[1]+(u128)d2*a4_19+(u128)a[3]*a3_19;
+  t[2]=(u128)d0*a[2]+(u128)a[1]*a[1]+(u128)(2*a[3])*a4_19;
+  t[3]=(u128)d0*a[3]+(u128)d1*a[2]+(u128)a[4]*a4_19;
+  t[4]=(u128)d0*a[4]+(u128)d1*a[3]+(u128)a[2]*a[2];
+  carry_wide(o,t);
 }
 
-sv unpack25519(gf o, const u8 *n)
+sv pack25519(u8 *o,const gf n)
 {
   int i;
-  FOR(i,16) o[i]=n[2*i]+((i64)n[2*i+1]<<8);
-  o[15]&=0x7fff;
+  u64 t[5],q,w;
+  FOR(i,5) t[i]=n[i];
+  car25519(t);
+  car25519(t);
+  /* q is 1 if t >= 2^255 - 19 */
+  q=(t[0]+19)>>51;
+  for(i=1;i<5;i++) q=(t[i]+q)>>51;
+  t[0]+=19*q;
+  FOR(i,4) {
+    t[i+1]+=t[i]>>51;
+    t[i]&=MASK51;
+  }
+  t[4]&=MASK51;
+  FOR(i,4) {
+    w=(t[i]>>(13*i))|(t[i+1]<<(51-13*i));
+    STORE64L(w,o+8*i);
+  }
 }
 
-sv A(gf o,const gf a,const gf b)
+sv unpack25519(gf o, const u8 *n)
 {
+  u64 w[4];
   int i;
-  FOR(i,16) o[i]=a[i]+b[i];
+  FOR(i,4) LOAD64L(w[i],n+8*i);
+  o[0]=w[0]&MASK51;
+  o[1]=((w[0]>>51)|(w[1]<<13))&MASK51;
+  o[2]=((w[1]>>38)|(w[2]<<26))&MASK51;
+  o[3]=((w[2]>>25)|(w[3]<<39))&MASK51;
+  o[4]=(w[3]>>12)&MASK51;
 }
+#else
+/* Bit offset and width of each limb */
+static const u8 fe_off[10] = {0, 26, 51, 77, 102, 128, 153, 179, 204, 230};
+#define FE_BITS(i) (26-((i)&1))
 
 sv Z(gf o,const gf a,const gf b)
 {
   int i;
-  FOR(i,16) o[i]=a[i]-b[i];
+  FOR(i,10) o[i]=a[i]-b[i];
+}
+
+/* Centered carry of the column sums of a product, leaves |o[i]| < 2^25 + 2^13 */
+sv carry_wide(gf o,i64 t[10])
+{
+  i64 c;
+  int i;
+  FOR(i,10) {
+    c=(t[i]+((i64)1<<(FE_BITS(i)-1)))>>FE_BITS(i);
+    t[i]-=c*((i64)1<<FE_BITS(i));
+    if (i==9) t[0]+=19*c;
+    else t[i+1]+=c;
+  }
+  c=(t[0]+((i64)1<<25))>>26;
+  t[0]-=c*((i64)1<<26);
+  t[1]+=c;
+  FOR(i,10) o[i]=(limb)t[i];
 }
 
 sv M(gf o,const gf a,const gf b)
 {
-  i64 i,j,t[31];
-  FOR(i,31) t[i]=0;
-  FOR(i,16) FOR(j,16) t[i+j]+=a[i]*b[j];
-  FOR(i,15) t[i]+=38*t[i+16];
-  FOR(i,16) o[i]=t[i];
-  car25519(o);
-  car25519(o);
+  i64 t[19];
+  int i,j;
+  FOR(i,19) t[i]=0;
+  /* Two odd offsets add up to one bit more than the sum of their limbs */
+  FOR(i,10) FOR(j,10) t[i+j]+=(i64)a[i]*(b[j]*(1+(i&j&1)));
+  FOR(i,9) t[i]+=19*t[i+10];
+  carry_wide(o,t);
 }
 
 sv S(gf o,const gf a)
 {
-  M(o,a,a);
+  i64 t[19];
+  int i,j;
+  FOR(i,19) t[i]=0;
+  FOR(i,10) {
+    t[2*i]+=(i64)a[i]*(a[i]*(1+(i&1)));
+    for(j=i+1;j<10;j++) t[i+j]+=(i64)a[i]*(a[j]*2*(1+(i&j&1)));
+  }
+  FOR(i,9) t[i]+=19*t[i+10];
+  carry_wide(o,t);
+}
+
+sv pack25519(u8 *o,const gf n)
+{
+  i64 t[10],q,acc;
+  int i,k,bits;
+  gf c;
+  FOR(i,10) t[i]=n[i];
+  carry_wide(c,t);
+  FOR(i,10) t[i]=c[i];
+  /* q is -1, 0 or 1 such that t - q * (2^255 - 19) is in [0, 2^255 - 19) */
+  q=(19*t[9]+((i64)1<<24))>>25;
+  FOR(i,10) q=(t[i]+q)>>FE_BITS(i);
+  t[0]+=19*q;
+  FOR(i,9) {
+    t[i+1]+=t[i]>>FE_BITS(i);
+    t[i]&=((i64)1<<FE_BITS(i))-1;
+  }
+  t[9]&=((i64)1<<25)-1;
+  acc=0;
+  bits=0;
+  k=0;
+  FOR(i,10) {
+    acc|=t[i]<<bits;
+    bits+=FE_BITS(i);
+    while(bits>=8) {
+      o[k++]=acc&255;
+      acc>>=8;
+      bits-=8;
+    }
+  }
+  o[31]=acc;
+}
+
+sv unpack25519(gf o, const u8 *n)
+{
+  u32 w;
+  int i,k,b;
+  FOR(i,10) {
+    b=fe_off[i]>>3;
+    w=0;
+    for(k=0;k<4&&b+k<32;k++) w|=(u32)n[b+k]<<(8*k);
+    o[i]=(w>>(fe_off[i]&7))&((1u<<FE_BITS(i))-1);
+  }
+}
+#endif
+
+static int neq25519(const gf a, const gf b)
+{
+  u8 c[32],d[32];
+  pack25519(c,a);
+  pack25519(d,b);
+  return tweetnacl_crypto_verify_32(c,d);
+}
+
+static u8 par25519(const gf a)
+{
+  u8 d[32];
+  pack25519(d,a);
+  return d[0]&1;
 }
 
 sv inv25519(gf o,const gf i)
 {
   gf c;
   int a;
-  FOR(a,16) c[a]=i[a];
+  set25519(c,i);
   for(a=253;a>=0;a--) {
     S(c,c);
     if(a!=2&&a!=4) M(c,c,i);
   }
-  FOR(a,16) o[a]=c[a];
+  set25519(o,c);
 }
 
 sv pow2523(gf o,const gf i)
 {
   gf c;
   int a;
-  FOR(a,16) c[a]=i[a];
+  set25519(c,i);
   for(a=250;a>=0;a--) {
     S(c,c);
     if(a!=1) M(c,c,i);
   }
-  FOR(a,16) o[a]=c[a];
+  set25519(o,c);
 }
 
+/* P, 2P, ... 8P for the base point P, affine with T = XY */
+static const gf base_tbl[8][4] = {
+#ifdef __SIZEOF_INT128__
+  {
+    {0x62d608f25d51a, 0x412a4b4f6592a, 0x75b7171a4b31d, 0x1ff60527118fe, 0x216936d3cd6e5},
+    {0x6666666666658, 0x4cccccccccccc, 0x1999999999999, 0x3333333333333, 0x6666666666666},
+    {0x1, 0x0, 0x0, 0x0, 0x0},
+    {0x68ab3a5b7dda3, 0xeea2a5eadbb, 0x2af8df483c27e, 0x332b375274732, 0x67875f0fd78b7}
+  },
+  {
+    {0x5a14e2843ce0e, 0xa2baf48bf078, 0xcf9eb0203639, 0x2361e821dbe8c, 0x36ab384c9f5a0},
+    {0x746ae6af8a3c9, 0x22c870a2ac1cb, 0x6887d5a5ce43d, 0x4e10ed12f7464, 0x2260cdf309232},
+    {0x1, 0x0, 0x0, 0x0, 0x0},
+    {0x23f556d69b401, 0x1383ee48056e3, 0x40ed04d75e6b3, 0x46e0ef2af8439, 0x2498a7850b2f6}
+  },
+  {
+    {0x2485fd3f8e25c, 0x3302c4910d58c, 0x36b20e98d0e60, 0x7a48ffa573a1f, 0x67ae9c4a22928},
+    {0x3684878f5b4d4, 0x2ece480608058, 0x9a7bde7c5bb0, 0x4d5d09350c730, 0x1267b1d177ee6},
+    {0x1, 0x0, 0x0, 0x0, 0x0},
+    {0x108fa78b3a41a, 0x17f62df8959bf, 0x6e4549d709cd6, 0x28875f79bc1d6, 0x2a4d025cb1dd9}
+  },
+  {
+    {0x2a657c4c9f870, 0x3279c2a8e927, 0xd483e469ce7b, 0xa34192ea5c3d, 0x203da8db56cff},
+    {0xab61ca32112f, 0x65d45e1fe1be7, 0x355c5b133c8a0, 0x2f0a3875c42c0, 0x47d0e827cb159},
+    {0x1, 0x0, 0x0, 0x0, 0x0},
+    {0x722f6728a1358, 0x3d6dba0f94bf1, 0x1f0a581c6578c, 0x306390a5d3563, 0x22783cd8d8732}
+  },
+  {
+    {0x9cc0322ef233, 0x727c37c34b228, 0x4b6977970a067, 0x43dfe77be7be8, 0x49fda73eade35},
+    {0x21f83d676c8ed, 0x15128616ba21a, 0x6491998c4a0bb, 0x737f016370a44, 0x5f4825b298fea},
+    {0x1, 0x0, 0x0, 0x0, 0x0},
+    {0x150bcf3e801d0, 0xa00124d7ec83, 0x4db1fe6bee53a, 0x6a618b0752843, 0x745c562c9c593}
+  },
+  {
+    {0x2741a7dcbf23d, 0x4d8f6884ef07, 0x428a6fa879666, 0xe315756606e, 0x4c9797ba7a456},
+    {0x27ad0f9497ef4, 0xd289ad6c183a, 0x53df5dfe505f0, 0x4508edb84d3fe, 0x54de3fc2886d},
+    {0x1, 0x0, 0x0, 0x0, 0x0},
+    {0x6d6c8b44ef1d2, 0x28f8fb91378f9, 0x79f73102ebe48, 0x27c142ad4ca7, 0x3c32efd109aa6}
+  },
+  {
+    {0x5981af50e4107, 0x6777e39d2ab0a, 0x476041e0fa027, 0x6a774f1f70ca5, 0x14568685fcf4b},
+    {0x4c4b59f4062b8, 0xdef57e47a258, 0x4dab507c220ad, 0x297c3e732346e, 0x31c563e32b47d},
+    {0x1, 0x0, 0x0, 0x0, 0x0},
+    {0x545565587ed1b, 0x543d3549c8217, 0x756ead14a518c, 0x70dcdf416e2c4, 0x119e77b11d165}
+  },
+  {
+    {0x7fdbc08a584c8, 0x7700d31732770, 0x13b3e4faceb19, 0xdb214316ae7c, 0x6742e15f97d77},
+    {0x75ba9fc37b9b4, 0x78c43dc9263c5, 0x22bce3e05e0f3, 0x1bcb756b784b3, 0x21d30600c9e57},
+    {0x1, 0x0, 0x0, 0x0, 0x0},
+    {0x6f41ad41a51bf, 0x5a689857eadf7, 0x2cf664d17c339, 0x5708b04614d9c, 0x2c4f59ecedf7e}
+  }
+#else
+  {
+    {0x325d51a, 0x18b5823, 0xf6592a, 0x104a92d, 0x1a4b31d, 0x1d6dc5c, 0x27118fe, 0x7fd814, 0x13cd6e5, 0x85a4db},
+    {0x2666658, 0x1999999, 0xcccccc, 0x1333333, 0x1999999, 0x666666, 0x3333333, 0xcccccc, 0x2666666, 0x1999999},
+    {0x1, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0},
+    {0x1b7dda3, 0x1a2ace9, 0x25eadbb, 0x3ba8a, 0x83c27e, 0xabe37d, 0x1274732, 0xccacdd, 0xfd78b7, 0x19e1d7c}
+  },
+  {
+    {0x43ce0e, 0x168538a, 0x8bf078, 0x28aebd, 0x203639, 0x33e7ac, 0x21dbe8c, 0x8d87a0, 0xc9f5a0, 0xdaace1},
+    {0x2f8a3c9, 0x1d1ab9a, 0x22ac1cb, 0x8b21c2, 0x25ce43d, 0x1a21f56, 0x12f7464, 0x13843b4, 0x3309232, 0x898337},
+    {0x1, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0},
+    {0x169b401, 0x8fd55b, 0x8056e3, 0x4e0fb9, 0x175e6b3, 0x103b413, 0x2af8439, 0x11b83bc, 0x50b2f6, 0x92629e}
+  },
+  {
+    {0x3f8e25c, 0x9217f4, 0x110d58c, 0xcc0b12, 0x18d0e60, 0xdac83a, 0x2573a1f, 0x1e923fe, 0xa22928, 0x19eba71},
+    {0xf5b4d4, 0xda121e, 0x608058, 0xbb3920, 0x27c5bb0, 0x269ef7, 0x350c730, 0x1357424, 0x1177ee6, 0x499ec7},
+    {0x1, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0},
+    {0xb3a41a, 0x423e9e, 0x38959bf, 0x5fd8b7, 0x1709cd6, 0x1b91527, 0x39bc1d6, 0xa21d7d, 0x1cb1dd9, 0xa93409}
+  },
+  {
+    {0xc9f870, 0xa995f1, 0x2a8e927, 0xc9e70, 0x69ce7b, 0x3520f9, 0x2ea5c3d, 0x28d064, 0x1b56cff, 0x80f6a3},
+    {0x232112f, 0x2ad872, 0x1fe1be7, 0x1975178, 0x133c8a0, 0xd5716c, 0x35c42c0, 0xbc28e1, 0x27cb159, 0x11f43a0},
+    {0x1, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0},
+    {0x28a1358, 0x1c8bd9c, 0xf94bf1, 0xf5b6e8, 0x1c6578c, 0x7c2960, 0x25d3563, 0xc18e42, 0x18d8732, 0x89e0f3}
+  },
+  {
+    {0x22ef233, 0x27300c, 0x34b228, 0x1c9f0df, 0x170a067, 0x12da5de, 0x3be7be8, 0x10f7f9d, 0x3eade35, 0x127f69c},
+    {0x276c8ed, 0x87e0f5, 0x16ba21a, 0x544a18, 0xc4a0bb, 0x1924666, 0x2370a44, 0x1cdfc05, 0x3298fea, 0x17d2096},
+    {0x1, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0},
+    {0x3e801d0, 0x542f3c, 0xd7ec83, 0x280049, 0x2bee53a, 0x136c7f9, 0x752843, 0x1a9862c, 0x2c9c593, 0x1d17158}
+  },
+  {
+    {0x1cbf23d, 0x9d069f, 0x84ef07, 0x1363da, 0x2879666, 0x10a29be, 0x356606e, 0x38c55, 0x3a7a456, 0x1325e5e},
+    {0x1497ef4, 0x9eb43e, 0x16c183a, 0x34a26b, 0x3e505f0, 0x14f7d77, 0x384d3fe, 0x11423b6, 0x3c2886d, 0x15378f},
+    {0x1, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0},
+    {0x4ef1d2, 0x1b5b22d, 0x11378f9, 0xa3e3ee, 0x2ebe48, 0x1e7dcc4, 0x2ad4ca7, 0x9f050, 0x1109aa6, 0xf0cbbf}
+  },
+  {
+    {0x10e4107, 0x16606bd, 0x1d2ab0a, 0x19ddf8e, 0x20fa027, 0x11d8107, 0x1f70ca5, 0x1a9dd3c, 0x5fcf4b, 0x515a1a},
+    {0x34062b8, 0x1312d67, 0x247a258, 0x37bd5f, 0x3c220ad, 0x136ad41, 0x332346e, 0xa5f0f9, 0x232b47d, 0xc7158f},
+    {0x1, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0},
+    {0x187ed1b, 0x1515595, 0x9c8217, 0x150f4d5, 0x14a518c, 0x1d5bab4, 0x16e2c4, 0x1c3737d, 0x311d165, 0x4679de}
+  },
+  {
+    {0xa584c8, 0x1ff6f02, 0x1732770, 0x1dc034c, 0x3aceb19, 0x4ecf93, 0x316ae7c, 0x36c850, 0x1f97d77, 0x19d0b85},
+    {0x37b9b4, 0x1d6ea7f, 0x9263c5, 0x1e310f7, 0x205e0f3, 0x8af38f, 0x2b784b3, 0x6f2dd5, 0xc9e57, 0x874c18},
+    {0x1, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0},
+    {0x1a51bf, 0x1bd06b5, 0x17eadf7, 0x169a261, 0x117c339, 0xb3d993, 0x614d9c, 0x15c22c1, 0x2cedf7e, 0xb13d67}
+  }
+#endif
+};
+
 int tweetnacl_crypto_scalarmult(u8 *q,const u8 *n,const u8 *p)
 {
   u8 z[32];
-  i64 x[80],r,i;
-  gf a,b,c,d,e,f;
+  i64 r,i;
+  gf x,a,b,c,d,e,f;
   FOR(i,31) z[i]=n[i];
   z[31]=(n[31]&127)|64;
   z[0]&=248;
   unpack25519(x,p);
-  FOR(i,16) {
-    b[i]=x[i];
-    d[i]=a[i]=c[i]=0;
-  }
-  a[0]=d[0]=1;
+  set25519(b,x);
+  set25519(a,gf1);
+  set25519(c,gf0);
+  set25519(d,gf1);
   for(i=254;i>=0;--i) {
     r=(z[i>>3]>>(i&7))&1;
     sel25519(a,b,r);
@@ -211,23 +477,12 @@ int tweetnacl_crypto_scalarmult(u8 *q,const u8 *n,const u8 *p)
     sel25519(a,b,r);
     sel25519(c,d,r);
   }
-  FOR(i,16) {
-    x[i+16]=a[i];
-    x[i+32]=c[i];
-    x[i+48]=b[i];
-    x[i+64]=d[i];
-  }
-  inv25519(x+32,x+32);
-  M(x+16,x+16,x+32);
-  pack25519(q,x+16);
+  inv25519(c,c);
+  M(a,a,c);
+  pack25519(q,a);
   return 0;
 }
 
-int tweetnacl_crypto_scalarmult_base(u8 *q,const u8 *n)
-{
-  return tweetnacl_crypto_scalarmult(q,n,_9);
-}
-
 static int tweetnacl_crypto_hash(u8 *out,const u8 *m,u64 n)
 {
   unsigned long len;
@@ -267,11 +522,27 @@ sv add(gf p[4],gf q[4])
   M(p[3], e, h);
 }
 
-sv cswap(gf p[4],gf q[4],u8 b)
+/* Doubling in extended coordinates, "dbl-2008-hwcd" with a = -1 */
+sv dbl(gf p[4])
 {
-  int i;
-  FOR(i,4)
-    sel25519(p[i],q[i],b);
+  gf a,b,c,e,f,g,h;
+
+  S(a, p[0]);
+  S(b, p[1]);
+  S(c, p[2]);
+  A(c, c, c);
+  A(h, a, b);
+  A(e, p[0], p[1]);
+  S(e, e);
+  Z(e, e, h);
+  Z(g, b, a);
+  A(f, c, a);
+  Z(f, f, b);
+
+  M(p[0], e, f);
+  M(p[1], g, h);
+  M(p[2], f, g);
+  M(p[3], e, h);
 }
 
 sv pack(u8 *r,gf p[4])
@@ -284,30 +555,103 @@ sv pack(u8 *r,gf p[4])
   r[31] ^= par25519(tx) << 7;
 }
 
-sv scalarmult(gf p[4],gf q[4],const u8 *s)
+/* Constant time t = e * P where tbl holds P, 2P, ... 8P and -8 <= e <= 8 */
+sv select(gf t[4],const gf tbl[8][4],signed char e)
 {
+  u32 neg = (u32)(u8)e >> 7;
+  u32 a = (u32)(e - (signed char)(2 * (-(int)neg & e)));
+  gf n;
   int i;
+
+  set25519(t[0],gf0);
+  set25519(t[1],gf1);
+  set25519(t[2],gf1);
+  set25519(t[3],gf0);
+  FOR(i,8) {
+    u32 eq = ((a ^ (u32)(i + 1)) - 1) >> 31;
+    cmov25519(t[0],tbl[i][0],eq);
+    cmov25519(t[1],tbl[i][1],eq);
+    cmov25519(t[2],tbl[i][2],eq);
+    cmov25519(t[3],tbl[i][3],eq);
+  }
+  Z(n,gf0,t[0]);
+  cmov25519(t[0],n,neg);
+  Z(n,gf0,t[3]);
+  cmov25519(t[3],n,neg);
+}
+
+/*
+ * Constant time p = s * P with a fixed window of signed 4-bit digits, tbl
+ * holds P, 2P, ... 8P. s must be below 2^255.
+ */
+sv scalarmult_tbl(gf p[4],const gf tbl[8][4],const u8 *s)
+{
+  signed char e[64];
+  gf t[4];
+  int i,carry;
+
+  FOR(i,32) {
+    e[2*i] = s[i] & 15;
+    e[2*i+1] = s[i] >> 4;
+  }
+  carry = 0;
+  FOR(i,63) {
+    e[i] += carry;
+    carry = (e[i] + 8) >> 4;
+    e[i] -= carry * 16;
+  }
+  e[63] += carry;
+
   set25519(p[0],gf0);
   set25519(p[1],gf1);
   set25519(p[2],gf1);
   set25519(p[3],gf0);
-  for (i = 255;i >= 0;--i) {
-    u8 b = (s[i/8]>>(i&7))&1;
-    cswap(p,q,b);
-    add(q,p);
-    add(p,p);
-    cswap(p,q,b);
+  for (i = 63;i >= 0;--i) {
+    dbl(p);
+    dbl(p);
+    dbl(p);
+    dbl(p);
+    select(t,tbl,e[i]);
+    add(p,t);
   }
 }
 
+sv scalarmult(gf p[4],gf q[4],const u8 *s)
+{
+  gf tbl[8][4];
+  int i,j;
+
+  FOR(j,4) set25519(tbl[0][j],q[j]);
+  for (i = 1;i < 8;++i) {
+    FOR(j,4) set25519(tbl[i][j],tbl[i-1][j]);
+    add(tbl[i],q);
+  }
+  scalarmult_tbl(p,(const gf (*)[4])tbl,s);
+}
+
 sv scalarbase(gf p[4],const u8 *s)
 {
-  gf q[4];
-  set25519(q[0],X);
-  set25519(q[1],Y);
-  set25519(q[2],gf1);
-  M(q[3],X,Y);
-  scalarmult(p,q,s);
+  scalarmult_tbl(p,base_tbl,s);
+}
+
+int tweetnacl_crypto_scalarmult_base(u8 *q,const u8 *n)
+{
+  u8 z[32];
+  gf p[4],a,b;
+  int i;
+
+  FOR(i,31) z[i]=n[i];
+  z[31]=(n[31]&127)|64;
+  z[0]&=248;
+
+  /* u = (1 + y) / (1 - y) on the birationally equivalent Edwards curve */
+  scalarbase(p,z);
+  A(a,p[2],p[1]);
+  Z(b,p[2],p[1]);
+  inv25519(b,b);
+  M(a,a,b);
+  pack25519(q,a);
+  return 0;
 }
 
 int tweetnacl_crypto_sk_to_pk(u8 *pk, const u8 *sk)
@@ -349,6 +693,17 @@ int tweetnacl_crypto_sign_keypair(prng_state *prng, int wprng, u8 *pk, u8 *sk)
 
 static const u64 L[32] = {0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x10};
 
+/* s must be below L, see RFC 8032 section 5.1.7 */
+static int sc_is_canonical(const u8 *s)
+{
+  int i;
+  for (i = 31;i >= 0;--i) {
+    if (s[i] < L[i]) return 1;
+    if (s[i] > L[i]) return 0;
+  }
+  return 0;
+}
+
 sv modL(u8 *r,i64 x[64])
 {
   i64 carry,i,j;
@@ -461,6 +816,7 @@ int tweetnacl_crypto_sign_open(int *stat, u8 *m,u64 *mlen,const u8 *sm,u64 smlen
   if (*mlen < smlen) return CRYPT_BUFFER_OVERFLOW;
   *mlen = -1;
   if (smlen < 64) return CRYPT_INVALID_ARG;
+  if (!sc_is_canonical(sm + 32)) return CRYPT_OK;
 
   if (unpackneg(q,pk)) return CRYPT_ERROR;
 
@@ -17,6 +17,14 @@
 
 #ifdef LTC_MRSA
 
+static int _rsa_mp_exptmod(void *a, void *b, void *c, void **cache, void *d)
+{
+   if (cache != NULL && ltc_mp.exptmod_cached != NULL) {
+      return ltc_mp.exptmod_cached(a, b, c, cache, d);
+   }
+   return mp_exptmod(a, b, c, d);
+}
+
 /**
    Compute an RSA modular exponentiation
    @param in         The input data to send into RSA
@@ -37,6 +45,7 @@ int rsa_exptmod(const unsigned char *in,   unsigned long inlen,
    #endif
    unsigned long x;
    int           err, has_crt_parameters;
+   void        **cache_p = NULL, **cache_q = NULL, **cache_N = NULL;
 
    LTC_ARGCHK(in     != NULL);
    LTC_ARGCHK(out    != NULL);
@@ -53,6 +62,12 @@ int rsa_exptmod(const unsigned char *in,   unsigned long inlen,
       return CRYPT_PK_INVALID_TYPE;
    }
 
+   if (key->cache != NULL) {
+      cache_p = &key->cache->p;
+      cache_q = &key->cache->q;
+      cache_N = &key->cache->N;
+   }
+
    /* init and copy into tmp */
    if ((err = mp_init_multi(&tmp, &tmpa, &tmpb,
 #ifdef LTC_RSA_BLINDING
@@ -86,7 +101,7 @@ int rsa_exptmod(const unsigned char *in,   unsigned long inlen,
       }
 
       /* rnd = rnd^e */
-      err = mp_exptmod( rnd, key->e, key->N, rnd);
+      err = _rsa_mp_exptmod(rnd, key->e, key->N, cache_N, rnd);
       if (err != CRYPT_OK) {
              goto error;
       }
@@ -109,13 +124,13 @@ int rsa_exptmod(const unsigned char *in,   unsigned long inlen,
           * In case CRT optimization parameters are not provided,
           * the private key is directly used to exptmod it
           */
-         if ((err = mp_exptmod(tmp, key->d, key->N, tmp)) != CRYPT_OK)                              { goto error; }
+         if ((err = _rsa_mp_exptmod(tmp, key->d, key->N, cache_N, tmp)) != CRYPT_OK)                              { goto error; }
       } else {
          /* tmpa = tmp^dP mod p */
-         if ((err = mp_exptmod(tmp, key->dP, key->p, tmpa)) != CRYPT_OK)                            { goto error; }
+         if ((err = _rsa_mp_exptmod(tmp, key->dP, key->p, cache_p, tmpa)) != CRYPT_OK)                            { goto error; }
 
          /* tmpb = tmp^dQ mod q */
-         if ((err = mp_exptmod(tmp, key->dQ, key->q, tmpb)) != CRYPT_OK)                            { goto error; }
+         if ((err = _rsa_mp_exptmod(tmp, key->dQ, key->q, cache_q, tmpb)) != CRYPT_OK)                            { goto error; }
 
          /* tmp = (tmpa - tmpb) * qInv (mod p) */
          if ((err = mp_sub(tmpa, tmpb, tmp)) != CRYPT_OK)                                           { goto error; }
@@ -136,14 +151,14 @@ int rsa_exptmod(const unsigned char *in,   unsigned long inlen,
 
       #ifdef LTC_RSA_CRT_HARDENING
       if (has_crt_parameters) {
-         if ((err = mp_exptmod(tmp, key->e, key->N, tmpa)) != CRYPT_OK)                              { goto error; }
+         if ((err = _rsa_mp_exptmod(tmp, key->e, key->N, cache_N, tmpa)) != CRYPT_OK)                              { goto error; }
          if ((err = mp_read_unsigned_bin(tmpb, (unsigned char *)in, (int)inlen)) != CRYPT_OK)        { goto error; }
          if (mp_cmp(tmpa, tmpb) != LTC_MP_EQ)                                     { err = CRYPT_ERROR; goto error; }
       }
       #endif
    } else {
       /* exptmod it */
-      if ((err = mp_exptmod(tmp, key->e, key->N, tmp)) != CRYPT_OK)                                { goto error; }
+      if ((err = _rsa_mp_exptmod(tmp, key->e, key->N, cache_N, tmp)) != CRYPT_OK)                                { goto error; }
    }
 
    /* read it back */
@@ -39,6 +39,7 @@ int rsa_import(const unsigned char *in, unsigned long inlen, rsa_key *key)
                             &key->dP, &key->qP, &key->p, &key->q, NULL)) != CRYPT_OK) {
       return err;
    }
+   key->cache = NULL;
 
    /* see if the OpenSSL DER format RSA public key will work */
    tmpbuf_len = inlen;
@@ -5,3 +5,6 @@ subdirs-$(_CFG_CORE_LTC_RSA) += pkcs1
 subdirs-$(_CFG_CORE_LTC_RSA) += rsa
 subdirs-$(_CFG_CORE_LTC_DH) += dh
 subdirs-$(_CFG_CORE_LTC_ECC) += ecc
+subdirs-$(_CFG_CORE_LTC_EC25519) += ec25519
+subdirs-$(_CFG_CORE_LTC_X25519) += x25519
+subdirs-$(_CFG_CORE_LTC_ED25519) += ed25519
@@ -17,6 +17,31 @@
 
 #ifdef LTC_CHACHA
 
+#if defined(LTC_CHACHA_ARM32_NEON) || defined(LTC_CHACHA_ARM64_NEON)
+#include "tomcrypt_arm_neon.h"
+
+/* Processes as many 256 byte chunks as possible, returns the bytes done */
+static unsigned long _chacha_crypt_neon(chacha_state *st, const unsigned char *in,
+                                        unsigned long inlen, unsigned char *out)
+{
+   struct tomcrypt_arm_neon_state state;
+   unsigned long n = 0;
+
+   /* The 32bit counter must not wrap inside a chunk */
+   if (inlen < 256 || st->input[12] > 0xfffffffbUL) return 0;
+
+   tomcrypt_arm_neon_enable(&state);
+   while (inlen - n >= 256 && st->input[12] <= 0xfffffffbUL) {
+      chacha_4block_xor_neon(st->input, out + n, in + n, st->rounds);
+      st->input[12] += 4;
+      n += 256;
+   }
+   tomcrypt_arm_neon_disable(&state);
+
+   return n;
+}
+#endif
+
 #define QUARTERROUND(a,b,c,d) \
   x[a] += x[b]; x[d] = ROL(x[d] ^ x[a], 16); \
   x[c] += x[d]; x[b] = ROL(x[b] ^ x[c], 12); \
@@ -72,6 +97,13 @@ int chacha_crypt(chacha_state *st, const unsigned char *in, unsigned long inlen,
       out += j;
       in  += j;
    }
+#if defined(LTC_CHACHA_ARM32_NEON) || defined(LTC_CHACHA_ARM64_NEON)
+   j = _chacha_crypt_neon(st, in, inlen, out);
+   inlen -= j;
+   if (inlen == 0) return CRYPT_OK;
+   out += j;
+   in  += j;
+#endif
    for (;;) {
      _chacha_block(buf, st->input, st->rounds);
      if (st->ivlen == 8) {
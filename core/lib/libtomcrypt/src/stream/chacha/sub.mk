@@ -0,0 +1,8 @@
+srcs-y += chacha_crypt.c
+srcs-y += chacha_done.c
+srcs-y += chacha_ivctr32.c
+srcs-y += chacha_ivctr64.c
+srcs-y += chacha_keystream.c
+srcs-y += chacha_setup.c
+srcs-$(_CFG_CORE_LTC_CHACHA20_ARM32_NEON) += chacha_neon_a32.S
+srcs-$(_CFG_CORE_LTC_CHACHA20_ARM64_NEON) += chacha_neon_a64.S
@@ -0,0 +1 @@
+subdirs-$(_CFG_CORE_LTC_CHACHA20_POLY1305) += chacha
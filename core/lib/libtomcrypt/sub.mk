@@ -62,6 +62,9 @@ endif
 ifneq (,$(filter y,$(_CFG_CORE_LTC_SHA512) $(_CFG_CORE_LTC_SHA512_DESC)))
 	cppflags-lib-y += -DLTC_SHA512
 endif
+ifeq ($(_CFG_CORE_LTC_SHA512_ARM64_CE),y)
+	cppflags-lib-y += -DLTC_SHA512_ARM64_CE
+endif
 ifeq ($(_CFG_CORE_LTC_SHA512_256),y)
 	cppflags-lib-y += -DLTC_SHA512_256
 endif
@@ -80,6 +83,16 @@ endif
 ifeq ($(_CFG_CORE_LTC_GCM),y)
 	cppflags-lib-y += -DLTC_GCM_MODE
 endif
+ifeq ($(_CFG_CORE_LTC_CHACHA20_POLY1305),y)
+	cppflags-lib-y += -DLTC_CHACHA -DLTC_POLY1305
+	cppflags-lib-y += -DLTC_CHACHA20POLY1305_MODE
+endif
+ifeq ($(_CFG_CORE_LTC_CHACHA20_ARM32_NEON),y)
+	cppflags-lib-y += -DLTC_CHACHA_ARM32_NEON
+endif
+ifeq ($(_CFG_CORE_LTC_CHACHA20_ARM64_NEON),y)
+	cppflags-lib-y += -DLTC_CHACHA_ARM64_NEON
+endif
 
 cppflags-lib-y += -DLTC_NO_PK
 
@@ -107,6 +120,9 @@ ifeq ($(_CFG_CORE_LTC_ECC),y)
    # ECC 521 bits is the max supported key size
    cppflags-lib-y += -DLTC_MAX_ECC=521
 endif
+ifeq ($(_CFG_CORE_LTC_EC25519),y)
+   cppflags-lib-y += -DLTC_CURVE25519
+endif
 
 cppflags-lib-y += -DLTC_NO_PKCS
 
@@ -129,15 +145,19 @@ srcs-$(_CFG_CORE_LTC_CTR) += ctr.c
 srcs-$(_CFG_CORE_LTC_XTS) += xts.c
 srcs-$(_CFG_CORE_LTC_CCM) += ccm.c
 srcs-$(_CFG_CORE_LTC_GCM) += gcm.c
+srcs-$(_CFG_CORE_LTC_CHACHA20_POLY1305) += chachapoly.c
 srcs-$(_CFG_CORE_LTC_DSA) += dsa.c
 srcs-$(_CFG_CORE_LTC_ECC) += ecc.c
 srcs-$(_CFG_CORE_LTC_RSA) += rsa.c
 srcs-$(_CFG_CORE_LTC_DH) += dh.c
+srcs-$(_CFG_CORE_LTC_X25519) += x25519.c
+srcs-$(_CFG_CORE_LTC_ED25519) += ed25519.c
 srcs-$(_CFG_CORE_LTC_AES) += aes.c
 
 ifeq ($(_CFG_CORE_LTC_ACIPHER),y)
 ifeq ($(_CFG_CORE_LTC_MPI),y)
 srcs-y += mpi_desc.c
+srcs-$(_CFG_CORE_LTC_ECC_FIXED_BASE) += mpi_ecc_fixed_base.c
 else
 srcs-y += mpa_desc.c
 # Get mpa.h which normally is an internal .h file
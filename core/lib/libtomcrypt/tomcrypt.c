@@ -4,6 +4,7 @@
  */
 
 #include <crypto/crypto.h>
+#include <kernel/panic.h>
 #include <tee_api_types.h>
 #include <tee_api_defines.h>
 #include <tomcrypt_private.h>
@@ -11,6 +12,8 @@
 #include "tomcrypt_mp.h"
 #include <trace.h>
 
+#include "ltc_index.h"
+
 #if defined(_CFG_CORE_LTC_VFP)
 #include <tomcrypt_arm_neon.h>
 #include <kernel/thread.h>
@@ -88,37 +91,55 @@ static const struct ltc_prng_descriptor prng_crypto_desc = {
  *	- algorithms
  *	- hash
  *	- prng (pseudo random generator)
+ *
+ * The descriptors must end up at the indices in ltc_index.h which are
+ * used instead of looking them up by name.
  */
 
+static void __maybe_unused reg_cipher(const struct ltc_cipher_descriptor *desc,
+				      int idx)
+{
+	if (register_cipher(desc) != idx)
+		panic();
+}
+
+static void __maybe_unused reg_hash(const struct ltc_hash_descriptor *desc,
+				    int idx)
+{
+	if (register_hash(desc) != idx)
+		panic();
+}
+
 static void tee_ltc_reg_algs(void)
 {
 #if defined(_CFG_CORE_LTC_AES) || defined(_CFG_CORE_LTC_AES_DESC)
-	register_cipher(&aes_desc);
+	reg_cipher(&aes_desc, LTC_CIPHER_AES);
 #endif
 #if defined(_CFG_CORE_LTC_DES)
-	register_cipher(&des_desc);
-	register_cipher(&des3_desc);
+	reg_cipher(&des_desc, LTC_CIPHER_DES);
+	reg_cipher(&des3_desc, LTC_CIPHER_3DES);
 #endif
 #if defined(_CFG_CORE_LTC_MD5)
-	register_hash(&md5_desc);
+	reg_hash(&md5_desc, LTC_HASH_MD5);
 #endif
 #if defined(_CFG_CORE_LTC_SHA1)
-	register_hash(&sha1_desc);
+	reg_hash(&sha1_desc, LTC_HASH_SHA1);
 #endif
 #if defined(_CFG_CORE_LTC_SHA224)
-	register_hash(&sha224_desc);
+	reg_hash(&sha224_desc, LTC_HASH_SHA224);
 #endif
 #if defined(_CFG_CORE_LTC_SHA256) || defined(_CFG_CORE_LTC_SHA256_DESC)
-	register_hash(&sha256_desc);
+	reg_hash(&sha256_desc, LTC_HASH_SHA256);
 #endif
 #if defined(_CFG_CORE_LTC_SHA384) || defined(_CFG_CORE_LTC_SHA384_DESC)
-	register_hash(&sha384_desc);
+	reg_hash(&sha384_desc, LTC_HASH_SHA384);
 #endif
 #if defined(_CFG_CORE_LTC_SHA512) || defined(_CFG_CORE_LTC_SHA512_DESC)
-	register_hash(&sha512_desc);
+	reg_hash(&sha512_desc, LTC_HASH_SHA512);
 #endif
 #if defined(_CFG_CORE_LTC_ACIPHER)
-	register_prng(&prng_crypto_desc);
+	if (register_prng(&prng_crypto_desc) != LTC_PRNG_CRYPTO)
+		panic();
 #endif
 }
 
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <crypto/crypto.h>
+#include <string.h>
+#include <string_ext.h>
+#include <tee_api_types.h>
+#include <tomcrypt_private.h>
+
+TEE_Result crypto_acipher_gen_x25519_key(struct x25519_keypair *key)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	curve25519_key ltc_key = { };
+
+	/* Any 32 bytes are a valid private key, RFC 7748 section 5 */
+	res = crypto_rng_read(key->priv, sizeof(key->priv));
+	if (res)
+		return res;
+
+	if (x25519_set_key(key->priv, sizeof(key->priv), NULL, 0,
+			   &ltc_key) != CRYPT_OK)
+		res = TEE_ERROR_BAD_PARAMETERS;
+	else
+		memcpy(key->pub, ltc_key.pub, sizeof(key->pub));
+
+	memzero_explicit(&ltc_key, sizeof(ltc_key));
+	return res;
+}
+
+TEE_Result
+crypto_acipher_x25519_shared_secret(struct x25519_keypair *private_key,
+				    const uint8_t *public_key,
+				    uint8_t *secret)
+{
+	TEE_Result res = TEE_SUCCESS;
+	curve25519_key ltc_private_key = { };
+	curve25519_key ltc_public_key = { };
+	unsigned long secret_len = CURVE25519_KEY_SIZE;
+	uint8_t acc = 0;
+	size_t n = 0;
+
+	if (x25519_set_key(private_key->priv, sizeof(private_key->priv),
+			   NULL, 0, &ltc_private_key) != CRYPT_OK ||
+	    x25519_set_key(NULL, 0, public_key, CURVE25519_KEY_SIZE,
+			   &ltc_public_key) != CRYPT_OK ||
+	    x25519_shared_secret(&ltc_private_key, &ltc_public_key, secret,
+				 &secret_len) != CRYPT_OK) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	/*
+	 * A public value of small order gives an all-zero secret which
+	 * must be rejected, RFC 7748 section 6.1
+	 */
+	for (n = 0; n < CURVE25519_KEY_SIZE; n++)
+		acc |= secret[n];
+	if (!acc)
+		res = TEE_ERROR_BAD_PARAMETERS;
+out:
+	memzero_explicit(&ltc_private_key, sizeof(ltc_private_key));
+	return res;
+}
@@ -13,6 +13,8 @@
 #include <utee_defines.h>
 #include <util.h>
 
+#include "ltc_index.h"
+
 struct ltc_xts_ctx {
 	struct crypto_cipher_ctx ctx;
 	int cipher_idx;
@@ -113,7 +115,7 @@ static const struct crypto_cipher_ops ltc_xts_ops = {
 TEE_Result crypto_aes_xts_alloc_ctx(struct crypto_cipher_ctx **ctx_ret)
 {
 	struct ltc_xts_ctx *c = NULL;
-	int cipher_idx = find_cipher("aes");
+	int cipher_idx = LTC_CIPHER_AES;
 
 	if (cipher_idx < 0)
 		return TEE_ERROR_NOT_SUPPORTED;
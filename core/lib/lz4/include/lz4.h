@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+#ifndef __LZ4_H
+#define __LZ4_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Minimal LZ4 block format compressor and decompressor, no frame format.
+ * Intended for small buffers like single pages.
+ */
+
+/* Number of entries in the work area passed to lz4_compress() */
+#define LZ4_HASH_BITS		10
+#define LZ4_HASH_ENTRIES	(1 << LZ4_HASH_BITS)
+
+/* Largest input supported by lz4_compress() */
+#define LZ4_MAX_INPUT_SIZE	UINT16_MAX
+
+/*
+ * lz4_compress() - Compress a buffer
+ * @src:	Data to compress
+ * @src_len:	Length of @src, at most LZ4_MAX_INPUT_SIZE
+ * @dst:	Output buffer
+ * @dst_size:	Size of @dst
+ * @work:	Work area of LZ4_HASH_ENTRIES entries
+ *
+ * Returns the length of the compressed data or 0 if it doesn't fit in
+ * @dst_size bytes.
+ */
+size_t lz4_compress(const void *src, size_t src_len, void *dst,
+		    size_t dst_size, uint16_t *work);
+
+/*
+ * lz4_decompress() - Decompress a buffer
+ * @src:	Compressed data
+ * @src_len:	Length of @src
+ * @dst:	Output buffer
+ * @dst_size:	Size of @dst
+ * @dst_len:	Returns the length of the decompressed data
+ *
+ * Returns 0 on success or -1 if @src is malformed or doesn't fit in
+ * @dst_size bytes.
+ */
+int lz4_decompress(const void *src, size_t src_len, void *dst,
+		   size_t dst_size, size_t *dst_len);
+
+#endif /*__LZ4_H*/
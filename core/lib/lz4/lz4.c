@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <lz4.h>
+#include <string.h>
+
+/*
+ * A compressed block is a sequence of sequences, each consisting of:
+ * - a token, high nibble the number of literals, low nibble the match
+ *   length minus LZ4_MIN_MATCH, 15 means that more length bytes follow
+ * - additional literal length bytes, 255 means that another one follows
+ * - the literals
+ * - a 16-bit little endian match offset
+ * - additional match length bytes, coded as for the literal length
+ * The last sequence ends after the literals.
+ */
+#define LZ4_MIN_MATCH		4
+/* The last match must start at least this many bytes before the end */
+#define LZ4_MFLIMIT		12
+/* The last bytes are always literals */
+#define LZ4_LAST_LITERALS	5
+#define LZ4_MAX_OFFSET		UINT16_MAX
+#define LZ4_RUN_MASK		15
+
+static uint32_t read32(const uint8_t *p)
+{
+	uint32_t v = 0;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static uint32_t hash32(uint32_t v)
+{
+	return (v * 2654435761U) >> (32 - LZ4_HASH_BITS);
+}
+
+/* Number of bytes needed to code @len with a nibble and length bytes */
+static size_t len_size(size_t len)
+{
+	if (len < LZ4_RUN_MASK)
+		return 0;
+	return (len - LZ4_RUN_MASK) / 255 + 1;
+}
+
+static uint8_t *put_len(uint8_t *op, size_t len)
+{
+	for (len -= LZ4_RUN_MASK; len >= 255; len -= 255)
+		*op++ = 255;
+	*op++ = len;
+
+	return op;
+}
+
+static uint8_t token_nibble(size_t len)
+{
+	if (len < LZ4_RUN_MASK)
+		return len;
+	return LZ4_RUN_MASK;
+}
+
+size_t lz4_compress(const void *src, size_t src_len, void *dst,
+		    size_t dst_size, uint16_t *work)
+{
+	const uint8_t *in = src;
+	const uint8_t *end = in + src_len;
+	const uint8_t *ip = in;
+	const uint8_t *anchor = in;
+	uint8_t *out = dst;
+	uint8_t *op = out;
+	size_t lit = 0;
+
+	if (src_len > LZ4_MAX_INPUT_SIZE)
+		return 0;
+
+	memset(work, 0, LZ4_HASH_ENTRIES * sizeof(*work));
+
+	if (src_len > LZ4_MFLIMIT) {
+		const uint8_t *mflimit = end - LZ4_MFLIMIT;
+		const uint8_t *mlimit = end - LZ4_LAST_LITERALS;
+
+		for (ip++; ip < mflimit;) {
+			uint32_t h = hash32(read32(ip));
+			const uint8_t *ref = in + work[h];
+			const uint8_t *mp = NULL;
+			size_t ml = 0;
+
+			work[h] = ip - in;
+			if (ref >= ip || read32(ref) != read32(ip)) {
+				ip++;
+				continue;
+			}
+
+			mp = ip + LZ4_MIN_MATCH;
+			while (mp < mlimit && *mp == ref[mp - ip])
+				mp++;
+
+			lit = ip - anchor;
+			ml = mp - ip - LZ4_MIN_MATCH;
+			if ((size_t)(out + dst_size - op) <
+			    1 + len_size(lit) + lit + 2 + len_size(ml))
+				return 0;
+
+			*op++ = token_nibble(lit) << 4 | token_nibble(ml);
+			if (lit >= LZ4_RUN_MASK)
+				op = put_len(op, lit);
+			memcpy(op, anchor, lit);
+			op += lit;
+			*op++ = ip - ref;
+			*op++ = (ip - ref) >> 8;
+			if (ml >= LZ4_RUN_MASK)
+				op = put_len(op, ml);
+
+			ip = mp;
+			anchor = ip;
+		}
+	}
+
+	lit = end - anchor;
+	if ((size_t)(out + dst_size - op) < 1 + len_size(lit) + lit)
+		return 0;
+	*op++ = token_nibble(lit) << 4;
+	if (lit >= LZ4_RUN_MASK)
+		op = put_len(op, lit);
+	memcpy(op, anchor, lit);
+	op += lit;
+
+	return op - out;
+}
+
+static int get_len(const uint8_t **ip, const uint8_t *iend, size_t *len)
+{
+	uint8_t b = 0;
+
+	if (*len != LZ4_RUN_MASK)
+		return 0;
+
+	do {
+		if (*ip >= iend)
+			return -1;
+		b = *(*ip)++;
+		*len += b;
+	} while (b == 255);
+
+	return 0;
+}
+
+int lz4_decompress(const void *src, size_t src_len, void *dst,
+		   size_t dst_size, size_t *dst_len)
+{
+	const uint8_t *ip = src;
+	const uint8_t *iend = ip + src_len;
+	uint8_t *out = dst;
+	uint8_t *op = out;
+	uint8_t *oend = out + dst_size;
+
+	while (ip < iend) {
+		uint8_t token = *ip++;
+		size_t lit = token >> 4;
+		size_t ml = token & LZ4_RUN_MASK;
+		size_t offs = 0;
+
+		if (get_len(&ip, iend, &lit) ||
+		    lit > (size_t)(iend - ip) || lit > (size_t)(oend - op))
+			return -1;
+		memcpy(op, ip, lit);
+		op += lit;
+		ip += lit;
+
+		if (ip == iend)
+			break;
+
+		if (iend - ip < 2)
+			return -1;
+		offs = ip[0] | ip[1] << 8;
+		ip += 2;
+		if (!offs || offs > (size_t)(op - out))
+			return -1;
+
+		if (get_len(&ip, iend, &ml))
+			return -1;
+		ml += LZ4_MIN_MATCH;
+		if (ml > (size_t)(oend - op))
+			return -1;
+
+		if (offs >= ml) {
+			memcpy(op, op - offs, ml);
+			op += ml;
+			continue;
+		}
+
+		/* Byte by byte since the match overlaps the output */
+		while (ml--) {
+			*op = *(op - offs);
+			op++;
+		}
+	}
+
+	*dst_len = op - out;
+	return 0;
+}
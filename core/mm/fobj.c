@@ -3,9 +3,14 @@
  * Copyright (c) 2019, Linaro Limited
  */
 
+#include <bitstring.h>
 #include <crypto/crypto.h>
 #include <crypto/internal_aes-gcm.h>
+#include <initcall.h>
+#include <kernel/misc.h>
 #include <kernel/panic.h>
+#include <kernel/spinlock.h>
+#include <limits.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
 #include <mm/fobj.h>
@@ -16,6 +21,10 @@
 #include <types_ext.h>
 #include <util.h>
 
+#ifdef CFG_PAGER_RWP_COMPRESS
+#include <lz4.h>
+#endif
+
 #ifdef CFG_WITH_PAGER
 
 #define RWP_AE_KEY_BITS		256
@@ -29,6 +38,15 @@ struct rwp_aes_gcm_iv {
 struct rwp_state {
 	uint64_t iv;
 	uint8_t tag[RWP_AES_GCM_TAG_LEN];
+#ifdef CFG_PAGER_RWP_COMPRESS
+	/*
+	 * First granule and length of the slot in the compressed store,
+	 * len is 0 for a zero page and SMALL_PAGE_SIZE if the page is
+	 * stored uncompressed.
+	 */
+	uint32_t slot;
+	uint16_t len;
+#endif
 };
 
 struct fobj_rwp {
@@ -39,7 +57,7 @@ struct fobj_rwp {
 
 static struct fobj_ops ops_rw_paged;
 
-static struct internal_aes_gcm_key rwp_ae_key;
+static struct internal_aes_gcm_prepared_key rwp_ae_key;
 
 void fobj_generate_authenc_key(void)
 {
@@ -47,10 +65,107 @@ void fobj_generate_authenc_key(void)
 
 	if (crypto_rng_read(key, sizeof(key)) != TEE_SUCCESS)
 		panic("failed to generate random");
-	if (internal_aes_gcm_expand_enc_key(key, sizeof(key), &rwp_ae_key))
+	if (internal_aes_gcm_prepare_key(key, sizeof(key), &rwp_ae_key))
 		panic("failed to expand key");
 }
 
+#ifdef CFG_PAGER_RWP_COMPRESS
+/*
+ * Compressed store shared by all r/w paged fobjs, used instead of a full
+ * page of TA RAM for each page. A saved page occupies a slot of
+ * contiguous granules holding the encrypted LZ4 compressed page, or the
+ * encrypted page as is if compression doesn't save at least one granule.
+ *
+ * The granule map is protected by rwpc_lock since slots are freed
+ * from thread context. rwpc_buf and rwpc_work are only used while saving
+ * or loading a page, which is serialized by the pager.
+ */
+#define RWPC_GRANULE_SIZE	64
+#define RWPC_NUM_GRANULES	(CFG_PAGER_RWP_COMPRESS_POOL_SIZE / \
+				 RWPC_GRANULE_SIZE)
+
+static uint8_t *rwpc_pool;
+static bitstr_t *rwpc_map;
+static unsigned int rwpc_lock = SPINLOCK_UNLOCK;
+static uint8_t rwpc_buf[SMALL_PAGE_SIZE];
+static uint16_t rwpc_work[LZ4_HASH_ENTRIES];
+
+static TEE_Result rwpc_init(void)
+{
+	tee_mm_entry_t *mm = NULL;
+
+	COMPILE_TIME_ASSERT(RWPC_NUM_GRANULES > 0 &&
+			    RWPC_NUM_GRANULES <= INT_MAX);
+
+	mm = tee_mm_alloc(&tee_mm_sec_ddr,
+			  RWPC_NUM_GRANULES * RWPC_GRANULE_SIZE);
+	if (!mm)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	rwpc_map = bit_alloc(RWPC_NUM_GRANULES);
+	if (!rwpc_map) {
+		tee_mm_free(mm);
+		return TEE_ERROR_OUT_OF_MEMORY;
+	}
+
+	rwpc_pool = phys_to_virt(tee_mm_get_smem(mm), MEM_AREA_TA_RAM);
+	assert(rwpc_pool);
+
+	return TEE_SUCCESS;
+}
+service_init(rwpc_init);
+
+static size_t rwpc_num_granules(size_t len)
+{
+	return ROUNDUP(len, RWPC_GRANULE_SIZE) / RWPC_GRANULE_SIZE;
+}
+
+/* First fit search for @count free contiguous granules */
+static bool rwpc_alloc_slot(size_t count, uint32_t *slot)
+{
+	size_t start = 0;
+	size_t run = 0;
+	size_t n = 0;
+
+	for (n = 0; n < RWPC_NUM_GRANULES; n++) {
+		if (bit_test(rwpc_map, n)) {
+			run = 0;
+			continue;
+		}
+		if (!run)
+			start = n;
+		run++;
+		if (run == count) {
+			bit_nset(rwpc_map, start, start + count - 1);
+			*slot = start;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void rwpc_free_slot(struct rwp_state *state)
+{
+	if (state->len)
+		bit_nclear(rwpc_map, state->slot,
+			   state->slot + rwpc_num_granules(state->len) - 1);
+	state->len = 0;
+}
+
+static bool page_is_zero(const void *va)
+{
+	const unsigned long *p = va;
+	size_t n = 0;
+
+	for (n = 0; n < SMALL_PAGE_SIZE / sizeof(*p); n++)
+		if (p[n])
+			return false;
+
+	return true;
+}
+#endif /*CFG_PAGER_RWP_COMPRESS*/
+
 static void fobj_init(struct fobj *fobj, const struct fobj_ops *ops,
 		      unsigned int num_pages)
 {
@@ -71,7 +186,7 @@ struct fobj *fobj_rw_paged_alloc(unsigned int num_pages)
 {
 	tee_mm_entry_t *mm = NULL;
 	struct fobj_rwp *rwp = NULL;
-	size_t size = 0;
+	size_t size __maybe_unused = 0;
 
 	assert(num_pages);
 
@@ -83,6 +198,10 @@ struct fobj *fobj_rw_paged_alloc(unsigned int num_pages)
 	if (!rwp->state)
 		goto err;
 
+#ifdef CFG_PAGER_RWP_COMPRESS
+	if (!rwpc_pool)
+		goto err;
+#else
 	if (MUL_OVERFLOW(num_pages, SMALL_PAGE_SIZE, &size))
 		goto err;
 	mm = tee_mm_alloc(&tee_mm_sec_ddr, size);
@@ -92,6 +211,7 @@ struct fobj *fobj_rw_paged_alloc(unsigned int num_pages)
 	assert(rwp->store); /* to assist debugging if it would ever happen */
 	if (!rwp->store)
 		goto err;
+#endif
 
 	fobj_init(&rwp->fobj, &ops_rw_paged, num_pages);
 
@@ -115,9 +235,20 @@ static struct fobj_rwp *to_rwp(struct fobj *fobj)
 static void rwp_free(struct fobj *fobj)
 {
 	struct fobj_rwp *rwp = to_rwp(fobj);
+#ifdef CFG_PAGER_RWP_COMPRESS
+	uint32_t exceptions = 0;
+	unsigned int n = 0;
+#endif
 
 	fobj_uninit(fobj);
+#ifdef CFG_PAGER_RWP_COMPRESS
+	exceptions = cpu_spin_lock_xsave(&rwpc_lock);
+	for (n = 0; n < fobj->num_pages; n++)
+		rwpc_free_slot(rwp->state + n);
+	cpu_spin_unlock_xrestore(&rwpc_lock, exceptions);
+#else
 	tee_mm_free(tee_mm_find(&tee_mm_sec_ddr, virt_to_phys(rwp->store)));
+#endif
 	free(rwp->state);
 	free(rwp);
 }
@@ -127,10 +258,16 @@ static TEE_Result rwp_load_page(struct fobj *fobj, unsigned int page_idx,
 {
 	struct fobj_rwp *rwp = to_rwp(fobj);
 	struct rwp_state *state = rwp->state + page_idx;
-	uint8_t *src = rwp->store + page_idx * SMALL_PAGE_SIZE;
 	struct rwp_aes_gcm_iv iv = {
 		.iv = { (vaddr_t)state, state->iv >> 32, state->iv }
 	};
+#ifdef CFG_PAGER_RWP_COMPRESS
+	uint8_t *src = NULL;
+	size_t len = 0;
+	TEE_Result res = TEE_ERROR_GENERIC;
+#else
+	uint8_t *src = rwp->store + page_idx * SMALL_PAGE_SIZE;
+#endif
 
 	assert(refcount_val(&fobj->refc));
 	assert(page_idx < fobj->num_pages);
@@ -140,13 +277,40 @@ static TEE_Result rwp_load_page(struct fobj *fobj, unsigned int page_idx,
 		 * iv still zero which means that this is previously unused
 		 * page.
 		 */
-		memset(va, 0, SMALL_PAGE_SIZE);
+		zero_pages(va, SMALL_PAGE_SIZE);
 		return TEE_SUCCESS;
 	}
 
-	return internal_aes_gcm_dec(&rwp_ae_key, &iv, sizeof(iv),
-				    NULL, 0, src, SMALL_PAGE_SIZE, va,
-				    state->tag, sizeof(state->tag));
+#ifdef CFG_PAGER_RWP_COMPRESS
+	if (!state->len) {
+		/* Zero page, only the flag was saved */
+		zero_pages(va, SMALL_PAGE_SIZE);
+		return TEE_SUCCESS;
+	}
+
+	src = rwpc_pool + state->slot * RWPC_GRANULE_SIZE;
+	if (state->len == SMALL_PAGE_SIZE)
+		return internal_aes_gcm_dec_prepared(&rwp_ae_key, &iv,
+						     sizeof(iv), NULL, 0, src,
+						     SMALL_PAGE_SIZE, va,
+						     state->tag,
+						     sizeof(state->tag));
+
+	res = internal_aes_gcm_dec_prepared(&rwp_ae_key, &iv, sizeof(iv),
+					    NULL, 0, src, state->len, rwpc_buf,
+					    state->tag, sizeof(state->tag));
+	if (res)
+		return res;
+	if (lz4_decompress(rwpc_buf, state->len, va, SMALL_PAGE_SIZE, &len) ||
+	    len != SMALL_PAGE_SIZE)
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	return TEE_SUCCESS;
+#else
+	return internal_aes_gcm_dec_prepared(&rwp_ae_key, &iv, sizeof(iv),
+					     NULL, 0, src, SMALL_PAGE_SIZE, va,
+					     state->tag, sizeof(state->tag));
+#endif
 }
 KEEP_PAGER(rwp_load_page);
 
@@ -156,7 +320,16 @@ static TEE_Result rwp_save_page(struct fobj *fobj, unsigned int page_idx,
 	struct fobj_rwp *rwp = to_rwp(fobj);
 	struct rwp_state *state = rwp->state + page_idx;
 	size_t tag_len = sizeof(state->tag);
+#ifdef CFG_PAGER_RWP_COMPRESS
+	const void *src = rwpc_buf;
+	uint32_t exceptions = 0;
+	size_t len = 0;
+	uint8_t *dst = NULL;
+#else
+	const void *src = va;
+	size_t len = SMALL_PAGE_SIZE;
 	uint8_t *dst = rwp->store + page_idx * SMALL_PAGE_SIZE;
+#endif
 	struct rwp_aes_gcm_iv iv;
 
 	memset(&iv, 0, sizeof(iv));
@@ -171,6 +344,35 @@ static TEE_Result rwp_save_page(struct fobj *fobj, unsigned int page_idx,
 	}
 
 	assert(page_idx < fobj->num_pages);
+
+#ifdef CFG_PAGER_RWP_COMPRESS
+	if (page_is_zero(va)) {
+		exceptions = cpu_spin_lock_xsave(&rwpc_lock);
+		rwpc_free_slot(state);
+		cpu_spin_unlock_xrestore(&rwpc_lock, exceptions);
+		return TEE_SUCCESS;
+	}
+
+	len = lz4_compress(va, SMALL_PAGE_SIZE, rwpc_buf,
+			   SMALL_PAGE_SIZE - RWPC_GRANULE_SIZE, rwpc_work);
+	if (!len) {
+		src = va;
+		len = SMALL_PAGE_SIZE;
+	}
+
+	exceptions = cpu_spin_lock_xsave(&rwpc_lock);
+	if (rwpc_num_granules(len) != rwpc_num_granules(state->len)) {
+		rwpc_free_slot(state);
+		if (!rwpc_alloc_slot(rwpc_num_granules(len), &state->slot)) {
+			cpu_spin_unlock_xrestore(&rwpc_lock, exceptions);
+			return TEE_ERROR_OUT_OF_MEMORY;
+		}
+	}
+	state->len = len;
+	cpu_spin_unlock_xrestore(&rwpc_lock, exceptions);
+	dst = rwpc_pool + state->slot * RWPC_GRANULE_SIZE;
+#endif
+
 	assert(state->iv + 1 > state->iv);
 
 	state->iv++;
@@ -185,9 +387,9 @@ static TEE_Result rwp_save_page(struct fobj *fobj, unsigned int page_idx,
 	iv.iv[1] = state->iv >> 32;
 	iv.iv[2] = state->iv;
 
-	return internal_aes_gcm_enc(&rwp_ae_key, &iv, sizeof(iv),
-				    NULL, 0, va, SMALL_PAGE_SIZE, dst,
-				    state->tag, &tag_len);
+	return internal_aes_gcm_enc_prepared(&rwp_ae_key, &iv, sizeof(iv),
+					     NULL, 0, src, len, dst,
+					     state->tag, &tag_len);
 }
 KEEP_PAGER(rwp_save_page);
 
@@ -301,7 +503,7 @@ static TEE_Result lop_load_page(struct fobj *fobj __maybe_unused,
 	assert(refcount_val(&fobj->refc));
 	assert(page_idx < fobj->num_pages);
 
-	memset(va, 0, SMALL_PAGE_SIZE);
+	zero_pages(va, SMALL_PAGE_SIZE);
 
 	return TEE_SUCCESS;
 }
@@ -351,7 +553,7 @@ struct fobj *fobj_sec_mem_alloc(unsigned int num_pages)
 	if (!va)
 		goto err;
 
-	memset(va, 0, size);
+	zero_pages(va, size);
 	f->fobj.ops = &ops_sec_mem;
 	f->fobj.num_pages = num_pages;
 	refcount_set(&f->fobj.refc, 1);
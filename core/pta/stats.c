@@ -2,15 +2,28 @@
 /*
  * Copyright (c) 2015, Linaro Limited
  */
+#include <arm.h>
 #include <compiler.h>
+#include <config.h>
 #include <stdio.h>
 #include <trace.h>
+#include <kernel/boot_profile.h>
+#include <kernel/interrupt.h>
+#include <kernel/lock_stats.h>
+#include <kernel/profiler.h>
+#include <kernel/pmu.h>
 #include <kernel/pseudo_ta.h>
+#include <kernel/thread.h>
+#include <mm/pgt_cache.h>
 #include <mm/tee_pager.h>
 #include <mm/tee_mm.h>
 #include <string.h>
 #include <string_ext.h>
 #include <malloc.h>
+#include <tee/arch_svc.h>
+#include <tee/entry_std.h>
+#include <tee/tee_fs_rpc.h>
+#include <util.h>
 
 #define TA_NAME		"stats.ta"
 
@@ -21,6 +34,21 @@
 #define STATS_CMD_PAGER_STATS		0
 #define STATS_CMD_ALLOC_STATS		1
 #define STATS_CMD_MEMLEAK_STATS		2
+#define STATS_CMD_THREAD_STATS		3
+#define STATS_CMD_RPC_CACHE_STATS	4
+#define STATS_CMD_FS_RPC_CACHE_STATS	5
+#define STATS_CMD_PGT_CACHE_STATS	6
+#define STATS_CMD_PAGER_PROFILE		7
+#define STATS_CMD_MALLOC_CACHE_STATS	8
+#define STATS_CMD_MALLOC_PROFILE	9
+#define STATS_CMD_SYSCALL_STATS		10
+#define STATS_CMD_RPC_STATS		11
+#define STATS_CMD_CORE_PROFILE		12
+#define STATS_CMD_PMU_STATS		13
+#define STATS_CMD_LOCK_STATS		14
+#define STATS_CMD_BOOT_PROFILE		15
+#define STATS_CMD_RUN_TIME		16
+#define STATS_CMD_ITR_STATS		17
 
 #define STATS_NB_POOLS			4
 
@@ -104,12 +132,18 @@ static TEE_Result get_alloc_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 static TEE_Result get_pager_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 {
 	struct tee_pager_stats stats;
+	bool with_fault_around = false;
 
-	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
-			    TEE_PARAM_TYPE_VALUE_OUTPUT,
-			    TEE_PARAM_TYPE_VALUE_OUTPUT,
-			    TEE_PARAM_TYPE_NONE) != type) {
-		EMSG("expect 3 output values as argument");
+	if (type == TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+				    TEE_PARAM_TYPE_VALUE_OUTPUT,
+				    TEE_PARAM_TYPE_VALUE_OUTPUT,
+				    TEE_PARAM_TYPE_VALUE_OUTPUT)) {
+		with_fault_around = true;
+	} else if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+				   TEE_PARAM_TYPE_VALUE_OUTPUT,
+				   TEE_PARAM_TYPE_VALUE_OUTPUT,
+				   TEE_PARAM_TYPE_NONE) != type) {
+		EMSG("expect 3 or 4 output values as argument");
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
 
@@ -120,6 +154,10 @@ static TEE_Result get_pager_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 	p[1].value.b = stats.rw_hits;
 	p[2].value.a = stats.hidden_hits;
 	p[2].value.b = stats.zi_released;
+	if (with_fault_around) {
+		p[3].value.a = stats.fault_around_loads;
+		p[3].value.b = stats.fault_around_hits;
+	}
 
 	return TEE_SUCCESS;
 }
@@ -137,6 +175,435 @@ static TEE_Result get_memleak_stats(uint32_t type,
 	return TEE_SUCCESS;
 }
 
+static TEE_Result get_thread_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct thread_alloc_stats stats = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	thread_get_alloc_stats(&stats);
+	p[0].value.a = stats.num_threads;
+	p[0].value.b = stats.free_threads;
+	p[1].value.a = stats.limit_count;
+	p[1].value.b = stats.heap_stacks;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_rpc_cache_stats(uint32_t type,
+				      TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct thread_rpc_cache_stats stats = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	thread_get_rpc_cache_stats(&stats);
+	p[0].value.a = stats.arg_allocs;
+	p[0].value.b = 0;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_fs_rpc_cache_stats(uint32_t type,
+					 TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct tee_fs_rpc_cache_stats stats = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	tee_fs_rpc_cache_get_stats(&stats);
+	p[0].value.a = stats.hits;
+	p[0].value.b = stats.misses;
+	p[1].value.a = stats.evictions;
+	p[1].value.b = 0;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_pgt_cache_stats(uint32_t type,
+				      TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct pgt_cache_stats stats = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	pgt_get_stats(&stats);
+	p[0].value.a = stats.hits;
+	p[0].value.b = stats.misses;
+	p[1].value.a = stats.evictions;
+	p[1].value.b = stats.cached;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_malloc_cache_stats(uint32_t type,
+					 TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct malloc_cache_stats stats = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	malloc_get_cache_stats(&stats);
+	p[0].value.a = stats.hits;
+	p[0].value.b = stats.misses;
+	p[1].value.a = stats.cached_frees;
+	p[1].value.b = stats.cached;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_pager_profile(uint32_t type,
+				    TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct tee_pager_page_profile *prof = NULL;
+	size_t count = 0;
+	TEE_Result res = TEE_SUCCESS;
+
+	/*
+	 * p[0].value.a = 0 if no reset of the profile
+	 * p[1].memref.buffer = output buffer to array of
+	 *			struct tee_pager_page_profile
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	prof = p[1].memref.buffer;
+	count = p[1].memref.size / sizeof(*prof);
+	if (count && !ALIGNMENT_IS_OK(prof, struct tee_pager_page_profile))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = tee_pager_get_profile(prof, &count, p[0].value.a);
+	if (res == TEE_SUCCESS || res == TEE_ERROR_SHORT_BUFFER)
+		p[1].memref.size = count * sizeof(*prof);
+
+	return res;
+}
+
+static TEE_Result get_malloc_profile(uint32_t type,
+				     TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct malloc_site_profile *prof = NULL;
+	size_t count = 0;
+
+	/*
+	 * p[0].value.a = 0 if no reset of the profile
+	 * p[1].memref.buffer = output buffer to array of
+	 *			struct malloc_site_profile
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	prof = p[1].memref.buffer;
+	count = p[1].memref.size / sizeof(*prof);
+	if (count && !ALIGNMENT_IS_OK(prof, struct malloc_site_profile))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!malloc_get_profile(prof, &count, p[0].value.a)) {
+		p[1].memref.size = count * sizeof(*prof);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	p[1].memref.size = count * sizeof(*prof);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_syscall_stats(uint32_t type,
+				    TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct syscall_stats *stats = NULL;
+
+	/*
+	 * p[0].value.a = index of the TA
+	 * p[0].value.b = 0 if no reset of the statistics
+	 * p[1].memref.buffer = output buffer to struct syscall_stats
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (p[1].memref.size < sizeof(*stats)) {
+		p[1].memref.size = sizeof(*stats);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	stats = p[1].memref.buffer;
+	if (!stats || !ALIGNMENT_IS_OK(stats, struct syscall_stats))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	p[1].memref.size = sizeof(*stats);
+
+	return syscall_stats_get(p[0].value.a, stats, p[0].value.b);
+}
+
+static TEE_Result get_rpc_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct thread_rpc_stats *stats = NULL;
+
+	/*
+	 * p[0].value.a = session ID, 0 for all sessions
+	 * p[0].value.b = 0 if no reset of the statistics
+	 * p[1].memref.buffer = output buffer to struct thread_rpc_stats
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (p[1].memref.size < sizeof(*stats)) {
+		p[1].memref.size = sizeof(*stats);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	stats = p[1].memref.buffer;
+	if (!stats || !ALIGNMENT_IS_OK(stats, struct thread_rpc_stats))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	p[1].memref.size = sizeof(*stats);
+
+	return thread_get_rpc_stats(p[0].value.a, stats, p[0].value.b);
+}
+
+static TEE_Result get_core_profile(uint32_t type,
+				   TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct core_profile_stack *stacks = NULL;
+	size_t count = 0;
+
+	/*
+	 * p[0].value.a = 0 if no reset of the profile
+	 * p[1].memref.buffer = output buffer to array of
+	 *			struct core_profile_stack
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	stacks = p[1].memref.buffer;
+	count = p[1].memref.size / sizeof(*stacks);
+	if (count && !ALIGNMENT_IS_OK(stacks, struct core_profile_stack))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!core_profiler_get(stacks, &count, p[0].value.a)) {
+		p[1].memref.size = count * sizeof(*stacks);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	p[1].memref.size = count * sizeof(*stacks);
+
+	return TEE_SUCCESS;
+}
+
+#ifdef CFG_TA_PMU_STATS
+static TEE_Result get_pmu_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct tee_ta_session_head *open_sessions = NULL;
+	struct pmu_stats *stats = NULL;
+	struct tee_ta_session *s = NULL;
+
+	/*
+	 * p[0].value.a = session ID
+	 * p[0].value.b = 0 if no reset of the counters
+	 * p[1].memref.buffer = output buffer to struct pmu_stats
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (p[1].memref.size < sizeof(*stats)) {
+		p[1].memref.size = sizeof(*stats);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	stats = p[1].memref.buffer;
+	if (!stats || !ALIGNMENT_IS_OK(stats, struct pmu_stats))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	nsec_sessions_list_head(&open_sessions);
+	s = tee_ta_get_session(p[0].value.a, false, open_sessions);
+	if (!s)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+
+	*stats = s->pmu_stats;
+	if (p[0].value.b)
+		memset(&s->pmu_stats, 0, sizeof(s->pmu_stats));
+	tee_ta_put_session(s);
+
+	p[1].memref.size = sizeof(*stats);
+
+	return TEE_SUCCESS;
+}
+#else
+static TEE_Result get_pmu_stats(uint32_t type __unused,
+				TEE_Param p[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+static TEE_Result get_lock_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct lock_stats *stats = NULL;
+	size_t count = 0;
+
+	/*
+	 * p[0].value.a = 0 if no reset of the statistics
+	 * p[1].memref.buffer = output buffer to array of struct lock_stats
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	stats = p[1].memref.buffer;
+	count = p[1].memref.size / sizeof(*stats);
+	if (count && !ALIGNMENT_IS_OK(stats, struct lock_stats))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!lock_stats_get(stats, &count, p[0].value.a)) {
+		p[1].memref.size = count * sizeof(*stats);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	p[1].memref.size = count * sizeof(*stats);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_boot_profile(uint32_t type,
+				   TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct boot_profile_entry *entries = NULL;
+	size_t count = 0;
+
+	/*
+	 * p[0].memref.buffer = output buffer to array of
+	 *			struct boot_profile_entry
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!IS_ENABLED(CFG_BOOT_PROFILE))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	entries = p[0].memref.buffer;
+	count = p[0].memref.size / sizeof(*entries);
+	if (count && !ALIGNMENT_IS_OK(entries, struct boot_profile_entry))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!boot_profile_get(entries, &count)) {
+		p[0].memref.size = count * sizeof(*entries);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	p[0].memref.size = count * sizeof(*entries);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_itr_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct itr_stats *stats = NULL;
+	size_t count = 0;
+
+	/*
+	 * p[0].value.a = 0 if no reset of the statistics
+	 * p[1].memref.buffer = output buffer to array of struct itr_stats
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	stats = p[1].memref.buffer;
+	count = p[1].memref.size / sizeof(*stats);
+	if (count && !ALIGNMENT_IS_OK(stats, struct itr_stats))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!itr_get_stats(stats, &count, p[0].value.a)) {
+		p[1].memref.size = count * sizeof(*stats);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	p[1].memref.size = count * sizeof(*stats);
+
+	return TEE_SUCCESS;
+}
+
+#ifdef CFG_THREAD_QUANTUM
+static TEE_Result get_run_time(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct tee_ta_session_head *open_sessions = NULL;
+	struct tee_ta_session *s = NULL;
+	uint64_t freq = read_cntfrq();
+	uint64_t ticks = 0;
+	uint64_t us = 0;
+
+	/*
+	 * p[0].value.a = session ID
+	 * p[0].value.b = 0 if no reset of the run time
+	 * p[1].value.a = run time in secure world in us, lower 32 bits
+	 * p[1].value.b = run time in secure world in us, upper 32 bits
+	 */
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	nsec_sessions_list_head(&open_sessions);
+	s = tee_ta_get_session(p[0].value.a, false, open_sessions);
+	if (!s)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+
+	ticks = s->run_ticks;
+	if (p[0].value.b)
+		s->run_ticks = 0;
+	tee_ta_put_session(s);
+
+	us = (ticks / freq) * 1000000 + ((ticks % freq) * 1000000) / freq;
+	reg_pair_from_64(us, &p[1].value.b, &p[1].value.a);
+
+	return TEE_SUCCESS;
+}
+#else
+static TEE_Result get_run_time(uint32_t type __unused,
+			       TEE_Param p[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
 /*
  * Trusted Application Entry Points
  */
@@ -152,6 +619,36 @@ static TEE_Result invoke_command(void *psess __unused,
 		return get_alloc_stats(ptypes, params);
 	case STATS_CMD_MEMLEAK_STATS:
 		return get_memleak_stats(ptypes, params);
+	case STATS_CMD_THREAD_STATS:
+		return get_thread_stats(ptypes, params);
+	case STATS_CMD_RPC_CACHE_STATS:
+		return get_rpc_cache_stats(ptypes, params);
+	case STATS_CMD_FS_RPC_CACHE_STATS:
+		return get_fs_rpc_cache_stats(ptypes, params);
+	case STATS_CMD_PGT_CACHE_STATS:
+		return get_pgt_cache_stats(ptypes, params);
+	case STATS_CMD_PAGER_PROFILE:
+		return get_pager_profile(ptypes, params);
+	case STATS_CMD_MALLOC_CACHE_STATS:
+		return get_malloc_cache_stats(ptypes, params);
+	case STATS_CMD_MALLOC_PROFILE:
+		return get_malloc_profile(ptypes, params);
+	case STATS_CMD_SYSCALL_STATS:
+		return get_syscall_stats(ptypes, params);
+	case STATS_CMD_RPC_STATS:
+		return get_rpc_stats(ptypes, params);
+	case STATS_CMD_CORE_PROFILE:
+		return get_core_profile(ptypes, params);
+	case STATS_CMD_PMU_STATS:
+		return get_pmu_stats(ptypes, params);
+	case STATS_CMD_LOCK_STATS:
+		return get_lock_stats(ptypes, params);
+	case STATS_CMD_BOOT_PROFILE:
+		return get_boot_profile(ptypes, params);
+	case STATS_CMD_RUN_TIME:
+		return get_run_time(ptypes, params);
+	case STATS_CMD_ITR_STATS:
+		return get_itr_stats(ptypes, params);
 	default:
 		break;
 	}
@@ -16,6 +16,7 @@
 #include <mm/file.h>
 #include <mm/fobj.h>
 #include <mm/tee_mmu.h>
+#include <mm/tee_pager.h>
 #include <pta_system.h>
 #include <string.h>
 #include <tee_api_defines_extensions.h>
@@ -208,27 +209,14 @@ static void ta_bin_close(void *ptr)
 	free(binh);
 }
 
-static TEE_Result system_open_ta_binary(struct system_ctx *ctx,
-					uint32_t param_types,
-					TEE_Param params[TEE_NUM_PARAMS])
+static TEE_Result open_ta_binary(struct system_ctx *ctx, const TEE_UUID *uuid,
+				 uint32_t *handle)
 {
 	TEE_Result res = TEE_SUCCESS;
 	struct bin_handle *binh = NULL;
 	int h = 0;
-	TEE_UUID *uuid = NULL;
 	uint8_t tag[FILE_TAG_SIZE] = { 0 };
 	unsigned int tag_len = sizeof(tag);
-	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
-					  TEE_PARAM_TYPE_VALUE_OUTPUT,
-					  TEE_PARAM_TYPE_NONE,
-					  TEE_PARAM_TYPE_NONE);
-
-	if (exp_pt != param_types)
-		return TEE_ERROR_BAD_PARAMETERS;
-	if (params[0].memref.size != sizeof(*uuid))
-		return TEE_ERROR_BAD_PARAMETERS;
-
-	uuid = params[0].memref.buffer;
 
 	binh = calloc(1, sizeof(*binh));
 	if (!binh)
@@ -260,6 +248,7 @@ static TEE_Result system_open_ta_binary(struct system_ctx *ctx,
 	h = handle_get(&ctx->db, binh);
 	if (h < 0)
 		goto err_oom;
+	*handle = h;
 
 	return TEE_SUCCESS;
 err_oom:
@@ -269,6 +258,75 @@ err:
 	return res;
 }
 
+static TEE_Result system_open_ta_binary(struct system_ctx *ctx,
+					uint32_t param_types,
+					TEE_Param params[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t handle = 0;
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+
+	if (exp_pt != param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (params[0].memref.size != sizeof(TEE_UUID))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = open_ta_binary(ctx, params[0].memref.buffer, &handle);
+	if (res)
+		return res;
+
+	params[1].value.a = handle;
+	params[1].value.b = 0;
+	return TEE_SUCCESS;
+}
+
+static TEE_Result system_open_ta_binaries(struct system_ctx *ctx,
+					  uint32_t param_types,
+					  TEE_Param params[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t handle = 0;
+	TEE_UUID uuid = { };
+	size_t num_bins = 0;
+	size_t n = 0;
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+
+	if (exp_pt != param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (params[0].memref.size % sizeof(TEE_UUID))
+		return TEE_ERROR_BAD_PARAMETERS;
+	num_bins = params[0].memref.size / sizeof(TEE_UUID);
+	if (!num_bins || num_bins > PTA_SYSTEM_OPEN_TA_BINARIES_MAX ||
+	    params[1].memref.size != num_bins * sizeof(uint32_t))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	for (n = 0; n < num_bins; n++) {
+		memcpy(&uuid, (TEE_UUID *)params[0].memref.buffer + n,
+		       sizeof(uuid));
+		res = open_ta_binary(ctx, &uuid, &handle);
+		if (res)
+			goto err;
+		memcpy((uint32_t *)params[1].memref.buffer + n, &handle,
+		       sizeof(handle));
+	}
+
+	return TEE_SUCCESS;
+err:
+	while (n) {
+		n--;
+		memcpy(&handle, (uint32_t *)params[1].memref.buffer + n,
+		       sizeof(handle));
+		ta_bin_close(handle_put(&ctx->db, handle));
+	}
+	return res;
+}
+
 static TEE_Result system_close_ta_binary(struct system_ctx *ctx,
 					 uint32_t param_types,
 					 TEE_Param params[TEE_NUM_PARAMS])
@@ -352,6 +410,7 @@ static TEE_Result system_map_ta_binary(struct system_ctx *ctx,
 	struct mobj *mobj = NULL;
 	uint32_t offs_bytes = 0;
 	uint32_t offs_pages = 0;
+	size_t mobj_offs = 0;
 	uint32_t num_bytes = 0;
 	uint32_t pad_begin = 0;
 	uint32_t pad_end = 0;
@@ -433,6 +492,18 @@ static TEE_Result system_map_ta_binary(struct system_ctx *ctx,
 				 mobj, 0, pad_begin, pad_end);
 		if (res)
 			goto err;
+	} else if (!(flags & PTA_SYSTEM_MAP_FLAG_WRITEABLE) &&
+		   binh->op->get_mobj &&
+		   !binh->op->get_mobj(binh->h, offs_bytes, num_bytes, &mobj,
+				       &mobj_offs)) {
+		/* Mapped in place, the TA binary isn't read or copied */
+		res = vm_map_pad(utc, &va, num_pages * SMALL_PAGE_SIZE, prot,
+				 VM_FLAG_READONLY, mobj, mobj_offs,
+				 pad_begin, pad_end);
+		/* @mobj isn't owned by the mapping */
+		mobj = NULL;
+		if (res)
+			goto err;
 	} else {
 		struct fobj *f = fobj_ta_mem_alloc(num_pages);
 		struct file *file = NULL;
@@ -571,6 +642,63 @@ static TEE_Result system_set_prot(struct tee_ta_session *s,
 	return vm_set_prot(utc, va, sz, prot);
 }
 
+static TEE_Result get_pin_range(uint32_t param_types,
+				TEE_Param params[TEE_NUM_PARAMS],
+				vaddr_t *va, size_t *sz)
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	vaddr_t begin = 0;
+	vaddr_t end = 0;
+
+	if (exp_pt != param_types || params[0].value.b)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	begin = reg_pair_to_64(params[1].value.a, params[1].value.b);
+	if (ADD_OVERFLOW(begin, params[0].value.a, &end) ||
+	    ROUNDUP_OVERFLOW(end, SMALL_PAGE_SIZE, &end))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	*va = ROUNDDOWN(begin, SMALL_PAGE_SIZE);
+	*sz = end - *va;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result system_pin_range(struct tee_ta_session *s,
+				   uint32_t param_types,
+				   TEE_Param params[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_SUCCESS;
+	vaddr_t va = 0;
+	size_t sz = 0;
+
+	res = get_pin_range(param_types, params, &va, &sz);
+	if (res)
+		return res;
+
+	return tee_pager_pin_uta_range(to_user_ta_ctx(s->ctx), va, sz);
+}
+
+static TEE_Result system_unpin_range(struct tee_ta_session *s,
+				     uint32_t param_types,
+				     TEE_Param params[TEE_NUM_PARAMS])
+{
+	TEE_Result res = TEE_SUCCESS;
+	vaddr_t va = 0;
+	size_t sz = 0;
+
+	res = get_pin_range(param_types, params, &va, &sz);
+	if (res)
+		return res;
+
+	tee_pager_unpin_uta_range(to_user_ta_ctx(s->ctx), va, sz);
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result system_remap(struct tee_ta_session *s, uint32_t param_types,
 			       TEE_Param params[TEE_NUM_PARAMS])
 {
@@ -819,6 +947,8 @@ static TEE_Result invoke_command(void *sess_ctx, uint32_t cmd_id,
 		return system_unmap(s, param_types, params);
 	case PTA_SYSTEM_OPEN_TA_BINARY:
 		return system_open_ta_binary(sess_ctx, param_types, params);
+	case PTA_SYSTEM_OPEN_TA_BINARIES:
+		return system_open_ta_binaries(sess_ctx, param_types, params);
 	case PTA_SYSTEM_CLOSE_TA_BINARY:
 		return system_close_ta_binary(sess_ctx, param_types, params);
 	case PTA_SYSTEM_MAP_TA_BINARY:
@@ -828,6 +958,10 @@ static TEE_Result invoke_command(void *sess_ctx, uint32_t cmd_id,
 						  params);
 	case PTA_SYSTEM_SET_PROT:
 		return system_set_prot(s, param_types, params);
+	case PTA_SYSTEM_PIN_RANGE:
+		return system_pin_range(s, param_types, params);
+	case PTA_SYSTEM_UNPIN_RANGE:
+		return system_unpin_range(s, param_types, params);
 	case PTA_SYSTEM_REMAP:
 		return system_remap(s, param_types, params);
 	case PTA_SYSTEM_DLOPEN:
@@ -0,0 +1,320 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+/*
+ * Known answer and throughput tests of the core authenticated encryption
+ * implementations
+ */
+
+#include <assert.h>
+#include <crypto/crypto.h>
+#include <inttypes.h>
+#include <kernel/tee_time.h>
+#include <pta_invoke_tests.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee_api_defines_extensions.h>
+#include <trace.h>
+#include <utee_defines.h>
+
+#include "misc.h"
+
+#define AE_PERF_MAX_SIZE	(64 * 1024)
+#define AE_TAG_LEN		16
+
+#if defined(CFG_CRYPTO_CHACHA20_POLY1305)
+/* RFC 8439 section 2.8.2 */
+static const uint8_t chachapoly_key[] = {
+	0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+	0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+	0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
+	0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f,
+};
+
+static const uint8_t chachapoly_nonce[] = {
+	0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43,
+	0x44, 0x45, 0x46, 0x47,
+};
+
+static const uint8_t chachapoly_aad[] = {
+	0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3,
+	0xc4, 0xc5, 0xc6, 0xc7,
+};
+
+static const char chachapoly_pt[] =
+	"Ladies and Gentlemen of the class of '99: If I could offer you "
+	"only one tip for the future, sunscreen would be it.";
+
+static const uint8_t chachapoly_ct[] = {
+	0xd3, 0x1a, 0x8d, 0x34, 0x64, 0x8e, 0x60, 0xdb,
+	0x7b, 0x86, 0xaf, 0xbc, 0x53, 0xef, 0x7e, 0xc2,
+	0xa4, 0xad, 0xed, 0x51, 0x29, 0x6e, 0x08, 0xfe,
+	0xa9, 0xe2, 0xb5, 0xa7, 0x36, 0xee, 0x62, 0xd6,
+	0x3d, 0xbe, 0xa4, 0x5e, 0x8c, 0xa9, 0x67, 0x12,
+	0x82, 0xfa, 0xfb, 0x69, 0xda, 0x92, 0x72, 0x8b,
+	0x1a, 0x71, 0xde, 0x0a, 0x9e, 0x06, 0x0b, 0x29,
+	0x05, 0xd6, 0xa5, 0xb6, 0x7e, 0xcd, 0x3b, 0x36,
+	0x92, 0xdd, 0xbd, 0x7f, 0x2d, 0x77, 0x8b, 0x8c,
+	0x98, 0x03, 0xae, 0xe3, 0x28, 0x09, 0x1b, 0x58,
+	0xfa, 0xb3, 0x24, 0xe4, 0xfa, 0xd6, 0x75, 0x94,
+	0x55, 0x85, 0x80, 0x8b, 0x48, 0x31, 0xd7, 0xbc,
+	0x3f, 0xf4, 0xde, 0xf0, 0x8e, 0x4b, 0x7a, 0x9d,
+	0xe5, 0x76, 0xd2, 0x65, 0x86, 0xce, 0xc6, 0x4b,
+	0x61, 0x16,
+};
+
+static const uint8_t chachapoly_tag[] = {
+	0x1a, 0xe1, 0x0b, 0x59, 0x4f, 0x09, 0xe2, 0x6a,
+	0x7e, 0x90, 0x2e, 0xcb, 0xd0, 0x60, 0x06, 0x91,
+};
+#endif
+
+/*
+ * Encrypts or decrypts @len bytes of @src into @dst, feeding the payload
+ * in chunks of @chunk bytes and passing the remainder to the final
+ * function.
+ */
+static TEE_Result ae_run(uint32_t algo, TEE_OperationMode mode,
+			 const uint8_t *key, size_t key_len,
+			 const uint8_t *nonce, size_t nonce_len,
+			 const uint8_t *aad, size_t aad_len,
+			 const uint8_t *src, size_t len, size_t chunk,
+			 uint8_t *dst, uint8_t *tag)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	size_t tag_len = AE_TAG_LEN;
+	size_t dlen = 0;
+	size_t n = 0;
+	void *ctx = NULL;
+
+	res = crypto_authenc_alloc_ctx(&ctx, algo);
+	if (res)
+		return res;
+
+	res = crypto_authenc_init(ctx, algo, mode, key, key_len, nonce,
+				  nonce_len, AE_TAG_LEN, aad_len, len);
+	if (res)
+		goto out;
+
+	if (aad_len) {
+		res = crypto_authenc_update_aad(ctx, algo, mode, aad, aad_len);
+		if (res)
+			goto out;
+	}
+
+	while (len - n > chunk) {
+		dlen = chunk;
+		res = crypto_authenc_update_payload(ctx, algo, mode, src + n,
+						    chunk, dst + n, &dlen);
+		if (res)
+			goto out;
+		n += chunk;
+	}
+
+	dlen = len - n;
+	if (mode == TEE_MODE_ENCRYPT)
+		res = crypto_authenc_enc_final(ctx, algo, src + n, len - n,
+					       dst + n, &dlen, tag, &tag_len);
+	else
+		res = crypto_authenc_dec_final(ctx, algo, src + n, len - n,
+					       dst + n, &dlen, tag, tag_len);
+	crypto_authenc_final(ctx, algo);
+out:
+	crypto_authenc_free_ctx(ctx, algo);
+	return res;
+}
+
+#if defined(CFG_CRYPTO_CHACHA20_POLY1305)
+static TEE_Result chachapoly_kat(void)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	const size_t len = sizeof(chachapoly_pt) - 1;
+	uint8_t buf[sizeof(chachapoly_ct)] = { 0 };
+	uint8_t tag[AE_TAG_LEN] = { 0 };
+	size_t chunk = 0;
+
+	COMPILE_TIME_ASSERT(sizeof(chachapoly_pt) - 1 ==
+			    sizeof(chachapoly_ct));
+
+	/* Odd chunk sizes exercise the buffering in all layers */
+	for (chunk = 1; chunk <= len; chunk += 13) {
+		res = ae_run(TEE_ALG_CHACHA20_POLY1305, TEE_MODE_ENCRYPT,
+			     chachapoly_key, sizeof(chachapoly_key),
+			     chachapoly_nonce, sizeof(chachapoly_nonce),
+			     chachapoly_aad, sizeof(chachapoly_aad),
+			     (const uint8_t *)chachapoly_pt, len, chunk,
+			     buf, tag);
+		if (res)
+			return res;
+		if (memcmp(buf, chachapoly_ct, len) ||
+		    memcmp(tag, chachapoly_tag, sizeof(tag))) {
+			EMSG("Encryption mismatch, chunk %zu", chunk);
+			return TEE_ERROR_GENERIC;
+		}
+
+		res = ae_run(TEE_ALG_CHACHA20_POLY1305, TEE_MODE_DECRYPT,
+			     chachapoly_key, sizeof(chachapoly_key),
+			     chachapoly_nonce, sizeof(chachapoly_nonce),
+			     chachapoly_aad, sizeof(chachapoly_aad),
+			     chachapoly_ct, len, chunk, buf, tag);
+		if (res)
+			return res;
+		if (memcmp(buf, chachapoly_pt, len)) {
+			EMSG("Decryption mismatch, chunk %zu", chunk);
+			return TEE_ERROR_GENERIC;
+		}
+	}
+
+	/* A modified tag must be rejected */
+	tag[0] ^= 1;
+	res = ae_run(TEE_ALG_CHACHA20_POLY1305, TEE_MODE_DECRYPT,
+		     chachapoly_key, sizeof(chachapoly_key),
+		     chachapoly_nonce, sizeof(chachapoly_nonce),
+		     chachapoly_aad, sizeof(chachapoly_aad),
+		     chachapoly_ct, len, len, buf, tag);
+	if (res != TEE_ERROR_MAC_INVALID) {
+		EMSG("Modified tag not detected: %#"PRIx32, res);
+		return TEE_ERROR_GENERIC;
+	}
+
+	return TEE_SUCCESS;
+}
+#else
+static TEE_Result chachapoly_kat(void)
+{
+	return TEE_SUCCESS;
+}
+#endif
+
+/*
+ * Large buffers go through the multi-block code paths, check that they
+ * produce the same result as short updates which don't.
+ */
+static TEE_Result ae_consistency(uint32_t algo, const uint8_t *key,
+				 size_t key_len, uint8_t *src, size_t len)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	static const uint8_t nonce[12] = { 0 };
+	uint8_t tag1[AE_TAG_LEN] = { 0 };
+	uint8_t tag2[AE_TAG_LEN] = { 0 };
+	uint8_t *dst1 = NULL;
+	uint8_t *dst2 = NULL;
+
+	dst1 = malloc(len);
+	dst2 = malloc(len);
+	if (!dst1 || !dst2) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+
+	res = ae_run(algo, TEE_MODE_ENCRYPT, key, key_len, nonce,
+		     sizeof(nonce), src, 7, src, len, len, dst1, tag1);
+	if (res)
+		goto out;
+	res = ae_run(algo, TEE_MODE_ENCRYPT, key, key_len, nonce,
+		     sizeof(nonce), src, 7, src, len, 63, dst2, tag2);
+	if (res)
+		goto out;
+
+	if (memcmp(dst1, dst2, len) || memcmp(tag1, tag2, sizeof(tag1))) {
+		EMSG("Algo %#"PRIx32": one-shot and chunked results differ",
+		     algo);
+		res = TEE_ERROR_GENERIC;
+	}
+out:
+	free(dst1);
+	free(dst2);
+	return res;
+}
+
+static uint32_t elapsed_ms(const TEE_Time *t0, const TEE_Time *t1)
+{
+	return (t1->seconds - t0->seconds) * 1000 + t1->millis - t0->millis;
+}
+
+TEE_Result core_authenc_perf_tests(uint32_t param_types,
+				   TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_NONE);
+	TEE_Result res = TEE_ERROR_GENERIC;
+	static const uint8_t nonce[12] = { 0 };
+	uint8_t key[32] = { 0 };
+	uint8_t tag[AE_TAG_LEN] = { 0 };
+	size_t key_len = 0;
+	uint32_t algo = 0;
+	size_t size = 0;
+	uint32_t iter = 0;
+	uint32_t ms = 0;
+	uint32_t n = 0;
+	TEE_Time t0 = { };
+	TEE_Time t1 = { };
+	uint8_t *buf = NULL;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	algo = params[0].value.a;
+	size = params[0].value.b;
+	iter = params[1].value.a;
+	if (!size || size > AE_PERF_MAX_SIZE || !iter)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	switch (algo) {
+	case TEE_ALG_AES_GCM:
+		key_len = 16;
+		break;
+	case TEE_ALG_CHACHA20_POLY1305:
+		key_len = 32;
+		res = chachapoly_kat();
+		if (res)
+			return res;
+		break;
+	default:
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+
+	buf = malloc(size);
+	if (!buf)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	for (n = 0; n < size; n++)
+		buf[n] = n;
+	for (n = 0; n < key_len; n++)
+		key[n] = n;
+
+	res = ae_consistency(algo, key, key_len, buf, size);
+	if (res)
+		goto out;
+
+	res = tee_time_get_sys_time(&t0);
+	if (res)
+		goto out;
+	for (n = 0; n < iter; n++) {
+		/* In place */
+		res = ae_run(algo, TEE_MODE_ENCRYPT, key, key_len, nonce,
+			     sizeof(nonce), NULL, 0, buf, size, size, buf,
+			     tag);
+		if (res)
+			goto out;
+	}
+	res = tee_time_get_sys_time(&t1);
+	if (res)
+		goto out;
+
+	ms = elapsed_ms(&t0, &t1);
+	params[2].value.a = ms;
+	/* kB/s, 0 if too fast to be measured */
+	if (ms)
+		params[2].value.b = ((uint64_t)size * iter) / ms;
+	else
+		params[2].value.b = 0;
+	IMSG("Algo %#"PRIx32": %"PRIu32" x %zu bytes in %"PRIu32" ms",
+	     algo, iter, size, ms);
+out:
+	free(buf);
+	return res;
+}
@@ -0,0 +1,716 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+/*
+ * Microbenchmarks of core primitives. Each operation is timed with the
+ * system counter, the results are meant to be compared between builds on
+ * the same platform.
+ */
+
+#include <arm.h>
+#include <crypto/crypto.h>
+#include <kernel/mutex.h>
+#include <kernel/tee_ta_manager.h>
+#include <kernel/tee_time.h>
+#include <kernel/thread.h>
+#include <mempool.h>
+#include <mm/tee_mm.h>
+#include <mm/tee_pager.h>
+#include <pta_invoke_tests.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee_api_defines_extensions.h>
+#include <tee/tee_pobj.h>
+#include <tee/tee_svc_storage.h>
+#include <trace.h>
+#include <utee_defines.h>
+#include <util.h>
+
+#include "misc.h"
+
+#define BENCH_MAX_SIZE		(64 * 1024)
+#define BENCH_MAX_PAGES		16
+#define BENCH_STORAGE_MAX_SIZE	(BENCH_MAX_SIZE * PTA_BENCH_STORAGE_CHUNKS)
+
+struct bench;
+
+/*
+ * struct bench_case - A benchmark case
+ * @init:	Allocates the resources of the case, optional
+ * @prepare:	Called before each operation without being timed, optional
+ * @op:		Operation @n
+ * @final:	Releases the resources of the case, optional
+ */
+struct bench_case {
+	TEE_Result (*init)(struct bench *b);
+	void (*prepare)(struct bench *b, size_t n);
+	TEE_Result (*op)(struct bench *b, size_t n);
+	void (*final)(struct bench *b);
+};
+
+struct bench {
+	size_t size;
+	uint32_t storage_id;
+	uint8_t *buf;
+	void *ctx;
+	struct fs_htree_bench *fhb;
+	struct tee_pobj *po;
+	struct tee_file_handle *fh;
+};
+
+static struct mutex bench_mutex = MUTEX_INITIALIZER;
+
+static TEE_Result init_size(struct bench *b)
+{
+	if (!b->size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result init_buf(struct bench *b)
+{
+	if (!b->size || b->size > BENCH_MAX_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	b->buf = calloc(1, b->size);
+	if (!b->buf)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	return TEE_SUCCESS;
+}
+
+static void final_buf(struct bench *b)
+{
+	free(b->buf);
+}
+
+static TEE_Result op_nop(struct bench *b __unused, size_t n __unused)
+{
+	return TEE_SUCCESS;
+}
+
+static TEE_Result op_malloc(struct bench *b, size_t n __unused)
+{
+	void *p = malloc(b->size);
+
+	if (!p)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	free(p);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result init_mempool(struct bench *b)
+{
+	if (!mempool_default)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	return init_size(b);
+}
+
+static TEE_Result op_mempool(struct bench *b, size_t n __unused)
+{
+	void *p = mempool_alloc(mempool_default, b->size);
+
+	if (!p)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	mempool_free(mempool_default, p);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result op_tee_mm(struct bench *b, size_t n __unused)
+{
+	tee_mm_entry_t *mm = tee_mm_alloc(&tee_mm_sec_ddr, b->size);
+
+	if (!mm)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	tee_mm_free(mm);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result op_mutex(struct bench *b __unused, size_t n __unused)
+{
+	struct mutex m = MUTEX_INITIALIZER;
+
+	mutex_lock(&m);
+	mutex_unlock(&m);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result op_mutex_contended(struct bench *b __unused,
+				     size_t n __unused)
+{
+	mutex_lock(&bench_mutex);
+	mutex_unlock(&bench_mutex);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result op_rpc(struct bench *b __unused, size_t n __unused)
+{
+	TEE_Time t = { };
+
+	/* Served by the normal world kernel driver */
+	return tee_time_get_ree_time(&t);
+}
+
+static TEE_Result init_sha256(struct bench *b)
+{
+	TEE_Result res = init_buf(b);
+
+	if (res)
+		return res;
+
+	res = crypto_hash_alloc_ctx(&b->ctx, TEE_ALG_SHA256);
+	if (res)
+		final_buf(b);
+
+	return res;
+}
+
+static TEE_Result op_sha256(struct bench *b, size_t n __unused)
+{
+	uint8_t digest[TEE_SHA256_HASH_SIZE] = { };
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = crypto_hash_init(b->ctx, TEE_ALG_SHA256);
+	if (res)
+		return res;
+	res = crypto_hash_update(b->ctx, TEE_ALG_SHA256, b->buf, b->size);
+	if (res)
+		return res;
+
+	return crypto_hash_final(b->ctx, TEE_ALG_SHA256, digest,
+				 sizeof(digest));
+}
+
+static void final_sha256(struct bench *b)
+{
+	crypto_hash_free_ctx(b->ctx, TEE_ALG_SHA256);
+	final_buf(b);
+}
+
+static TEE_Result init_aes_cbc(struct bench *b)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (b->size % TEE_AES_BLOCK_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = init_buf(b);
+	if (res)
+		return res;
+
+	res = crypto_cipher_alloc_ctx(&b->ctx, TEE_ALG_AES_CBC_NOPAD);
+	if (res)
+		final_buf(b);
+
+	return res;
+}
+
+static TEE_Result op_aes_cbc(struct bench *b, size_t n __unused)
+{
+	static const uint8_t key[16] = { };
+	static const uint8_t iv[TEE_AES_BLOCK_SIZE] = { };
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = crypto_cipher_init(b->ctx, TEE_ALG_AES_CBC_NOPAD,
+				 TEE_MODE_ENCRYPT, key, sizeof(key), NULL, 0,
+				 iv, sizeof(iv));
+	if (res)
+		return res;
+
+	/* In place */
+	res = crypto_cipher_update(b->ctx, TEE_ALG_AES_CBC_NOPAD,
+				   TEE_MODE_ENCRYPT, true, b->buf, b->size,
+				   b->buf);
+	crypto_cipher_final(b->ctx, TEE_ALG_AES_CBC_NOPAD);
+
+	return res;
+}
+
+static void final_aes_cbc(struct bench *b)
+{
+	crypto_cipher_free_ctx(b->ctx, TEE_ALG_AES_CBC_NOPAD);
+	final_buf(b);
+}
+
+#ifdef CFG_WITH_PAGER
+/* Pager memory can't be freed, the same pages are used by all invocations */
+static uint8_t *bench_pages;
+static struct mutex bench_pages_mutex = MUTEX_INITIALIZER;
+
+static TEE_Result init_page_fault(struct bench *b)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!b->size || b->size > BENCH_MAX_PAGES)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mutex_lock(&bench_pages_mutex);
+	if (!bench_pages) {
+		bench_pages = tee_pager_alloc(BENCH_MAX_PAGES *
+					      SMALL_PAGE_SIZE);
+		if (!bench_pages)
+			res = TEE_ERROR_OUT_OF_MEMORY;
+	}
+	mutex_unlock(&bench_pages_mutex);
+
+	return res;
+}
+
+static void prepare_page_fault(struct bench *b, size_t n)
+{
+	uint8_t *page = bench_pages + (n % b->size) * SMALL_PAGE_SIZE;
+
+	/* Next access to the page faults */
+	tee_pager_release_phys(page, SMALL_PAGE_SIZE);
+}
+
+static TEE_Result op_page_fault(struct bench *b, size_t n)
+{
+	volatile uint8_t *page = NULL;
+
+	page = bench_pages + (n % b->size) * SMALL_PAGE_SIZE;
+	*page = n;
+
+	return TEE_SUCCESS;
+}
+#endif /*CFG_WITH_PAGER*/
+
+#ifdef CFG_WITH_USER_TA
+static TEE_Result init_fs_htree(struct bench *b)
+{
+	return core_fs_htree_bench_open(b->size, &b->fhb);
+}
+
+static TEE_Result op_fs_htree_read(struct bench *b, size_t n)
+{
+	return core_fs_htree_bench_op(b->fhb, n, false);
+}
+
+static TEE_Result op_fs_htree_write(struct bench *b, size_t n)
+{
+	return core_fs_htree_bench_op(b->fhb, n, true);
+}
+
+static void final_fs_htree(struct bench *b)
+{
+	core_fs_htree_bench_close(b->fhb);
+}
+
+/* Objects of the storage cases are stored on behalf of this PTA */
+static const TEE_UUID bench_uuid = PTA_INVOKE_TESTS_UUID;
+static const char bench_obj_id[] = "bench";
+
+static TEE_Result storage_create(struct bench *b, size_t size)
+{
+	const struct tee_file_operations *fops = b->po->fops;
+	TEE_Result res = TEE_SUCCESS;
+	size_t chunk = MIN(size, (size_t)BENCH_MAX_SIZE);
+	size_t pos = chunk;
+
+	res = fops->create(b->po, false, NULL, 0, NULL, 0, b->buf, chunk,
+			   &b->fh);
+	if (res)
+		return res;
+
+	while (pos < size) {
+		chunk = MIN(size - pos, (size_t)BENCH_MAX_SIZE);
+		res = fops->write(b->fh, pos, b->buf, chunk);
+		if (res)
+			break;
+		pos += chunk;
+	}
+	fops->close(&b->fh);
+	if (res)
+		fops->remove(b->po);
+
+	return res;
+}
+
+static TEE_Result init_storage(struct bench *b, size_t size,
+			       size_t buf_size)
+{
+	uint32_t flags = TEE_DATA_FLAG_ACCESS_READ |
+			 TEE_DATA_FLAG_ACCESS_WRITE |
+			 TEE_DATA_FLAG_ACCESS_WRITE_META;
+	const struct tee_file_operations *fops = NULL;
+	TEE_UUID uuid = bench_uuid;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (b->storage_id != TEE_STORAGE_PRIVATE_REE &&
+	    b->storage_id != TEE_STORAGE_PRIVATE_RPMB)
+		return TEE_ERROR_BAD_PARAMETERS;
+	fops = tee_svc_storage_file_ops(b->storage_id);
+	if (!fops)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+	if (size > BENCH_STORAGE_MAX_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	b->buf = calloc(1, MAX(buf_size, (size_t)1));
+	if (!b->buf)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	memset(b->buf, 0xa5, buf_size);
+
+	res = tee_pobj_get(&uuid, (void *)bench_obj_id, sizeof(bench_obj_id),
+			   flags, false, fops, &b->po);
+	if (res) {
+		free(b->buf);
+		return res;
+	}
+
+	/* Left behind by an interrupted run */
+	fops->remove(b->po);
+
+	return TEE_SUCCESS;
+}
+
+static void final_storage(struct bench *b)
+{
+	if (b->fh)
+		b->po->fops->close(&b->fh);
+	b->po->fops->remove(b->po);
+	tee_pobj_release(b->po);
+	free(b->buf);
+}
+
+static TEE_Result init_storage_open(struct bench *b)
+{
+	TEE_Result res = init_storage(b, b->size,
+				      MIN(b->size, (size_t)BENCH_MAX_SIZE));
+
+	if (res)
+		return res;
+
+	res = storage_create(b, b->size);
+	if (res)
+		final_storage(b);
+
+	return res;
+}
+
+static TEE_Result op_storage_open(struct bench *b, size_t n __unused)
+{
+	TEE_Result res = b->po->fops->open(b->po, NULL, &b->fh);
+
+	if (!res)
+		b->po->fops->close(&b->fh);
+
+	return res;
+}
+
+static TEE_Result init_storage_rw(struct bench *b)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!b->size || b->size > BENCH_MAX_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = init_storage(b, b->size * PTA_BENCH_STORAGE_CHUNKS, b->size);
+	if (res)
+		return res;
+
+	res = storage_create(b, b->size * PTA_BENCH_STORAGE_CHUNKS);
+	if (!res)
+		res = b->po->fops->open(b->po, NULL, &b->fh);
+	if (res)
+		final_storage(b);
+
+	return res;
+}
+
+static size_t storage_pos(struct bench *b, size_t n, bool rand)
+{
+	size_t chunk = n % PTA_BENCH_STORAGE_CHUNKS;
+
+	/* Multiplicative hashing, the same sequence in each run */
+	if (rand)
+		chunk = ((uint32_t)n * 2654435761U) %
+			PTA_BENCH_STORAGE_CHUNKS;
+
+	return chunk * b->size;
+}
+
+static TEE_Result storage_read(struct bench *b, size_t n, bool rand)
+{
+	size_t len = b->size;
+	TEE_Result res = TEE_SUCCESS;
+
+	res = b->po->fops->read(b->fh, storage_pos(b, n, rand), b->buf, &len);
+	if (!res && len != b->size)
+		res = TEE_ERROR_CORRUPT_OBJECT;
+
+	return res;
+}
+
+static TEE_Result op_storage_read_seq(struct bench *b, size_t n)
+{
+	return storage_read(b, n, false);
+}
+
+static TEE_Result op_storage_read_rand(struct bench *b, size_t n)
+{
+	return storage_read(b, n, true);
+}
+
+static TEE_Result op_storage_write_seq(struct bench *b, size_t n)
+{
+	return b->po->fops->write(b->fh, storage_pos(b, n, false), b->buf,
+				  b->size);
+}
+
+static TEE_Result op_storage_write_rand(struct bench *b, size_t n)
+{
+	return b->po->fops->write(b->fh, storage_pos(b, n, true), b->buf,
+				  b->size);
+}
+
+static TEE_Result init_storage_size(struct bench *b)
+{
+	return init_storage(b, b->size, MIN(b->size, (size_t)BENCH_MAX_SIZE));
+}
+
+static void prepare_storage_create(struct bench *b, size_t n)
+{
+	if (n)
+		b->po->fops->remove(b->po);
+}
+
+static TEE_Result op_storage_create(struct bench *b, size_t n __unused)
+{
+	return storage_create(b, b->size);
+}
+
+static void prepare_storage_remove(struct bench *b, size_t n __unused)
+{
+	/* A failure shows as a failure to remove the object */
+	storage_create(b, b->size);
+}
+
+static TEE_Result op_storage_remove(struct bench *b, size_t n __unused)
+{
+	return b->po->fops->remove(b->po);
+}
+#endif /*CFG_WITH_USER_TA*/
+
+static const struct bench_case bench_cases[] = {
+	[PTA_BENCH_NOP] = { .op = op_nop },
+	[PTA_BENCH_MALLOC] = { .init = init_size, .op = op_malloc },
+	[PTA_BENCH_MEMPOOL] = { .init = init_mempool, .op = op_mempool },
+	[PTA_BENCH_TEE_MM] = { .init = init_size, .op = op_tee_mm },
+	[PTA_BENCH_MUTEX] = { .op = op_mutex },
+	[PTA_BENCH_MUTEX_CONTENDED] = { .op = op_mutex_contended },
+	[PTA_BENCH_RPC] = { .op = op_rpc },
+	[PTA_BENCH_SHA256] = {
+		.init = init_sha256,
+		.op = op_sha256,
+		.final = final_sha256,
+	},
+	[PTA_BENCH_AES_CBC] = {
+		.init = init_aes_cbc,
+		.op = op_aes_cbc,
+		.final = final_aes_cbc,
+	},
+#ifdef CFG_WITH_PAGER
+	[PTA_BENCH_PAGE_FAULT] = {
+		.init = init_page_fault,
+		.prepare = prepare_page_fault,
+		.op = op_page_fault,
+	},
+#endif
+#ifdef CFG_WITH_USER_TA
+	[PTA_BENCH_FS_HTREE_READ] = {
+		.init = init_fs_htree,
+		.op = op_fs_htree_read,
+		.final = final_fs_htree,
+	},
+	[PTA_BENCH_FS_HTREE_WRITE] = {
+		.init = init_fs_htree,
+		.op = op_fs_htree_write,
+		.final = final_fs_htree,
+	},
+	[PTA_BENCH_STORAGE_OPEN] = {
+		.init = init_storage_open,
+		.op = op_storage_open,
+		.final = final_storage,
+	},
+	[PTA_BENCH_STORAGE_READ_SEQ] = {
+		.init = init_storage_rw,
+		.op = op_storage_read_seq,
+		.final = final_storage,
+	},
+	[PTA_BENCH_STORAGE_READ_RAND] = {
+		.init = init_storage_rw,
+		.op = op_storage_read_rand,
+		.final = final_storage,
+	},
+	[PTA_BENCH_STORAGE_WRITE_SEQ] = {
+		.init = init_storage_rw,
+		.op = op_storage_write_seq,
+		.final = final_storage,
+	},
+	[PTA_BENCH_STORAGE_WRITE_RAND] = {
+		.init = init_storage_rw,
+		.op = op_storage_write_rand,
+		.final = final_storage,
+	},
+	[PTA_BENCH_STORAGE_CREATE] = {
+		.init = init_storage_size,
+		.prepare = prepare_storage_create,
+		.op = op_storage_create,
+		.final = final_storage,
+	},
+	[PTA_BENCH_STORAGE_REMOVE] = {
+		.init = init_storage_size,
+		.prepare = prepare_storage_remove,
+		.op = op_storage_remove,
+		.final = final_storage,
+	},
+#endif
+};
+
+static uint64_t read_counter(void)
+{
+	isb();
+	return read_cntpct();
+}
+
+/* Number of RPCs issued so far by the current session */
+static uint64_t session_rpc_count(void)
+{
+	struct thread_rpc_stats stats = { };
+	struct tee_ta_session *s = NULL;
+	uint64_t count = 0;
+	size_t n = 0;
+
+	if (tee_ta_get_current_session(&s) ||
+	    thread_get_rpc_stats(s->id, &stats, false))
+		return 0;
+
+	for (n = 0; n < ARRAY_SIZE(stats.cmd); n++)
+		count += stats.cmd[n].count;
+
+	return count;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	const uint64_t *ua = a;
+	const uint64_t *ub = b;
+
+	return CMP_TRILEAN(*ua, *ub);
+}
+
+static uint64_t percentile(const uint64_t *samples, size_t num,
+			   unsigned int pct)
+{
+	return samples[(num - 1) * pct / 100];
+}
+
+static TEE_Result run_bench(const struct bench_case *bc, struct bench *b,
+			    size_t ops, struct pta_bench_result *r)
+{
+	size_t num_samples = MIN(ops, (size_t)PTA_BENCH_MAX_SAMPLES);
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t *samples = NULL;
+	uint64_t rpcs = 0;
+	uint64_t t0 = 0;
+	uint64_t t = 0;
+	size_t n = 0;
+
+	samples = calloc(num_samples, sizeof(*samples));
+	if (!samples)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	for (n = 0; n < ops; n++) {
+		if (bc->prepare)
+			bc->prepare(b, n);
+		rpcs = session_rpc_count();
+		t0 = read_counter();
+		res = bc->op(b, n);
+		t = read_counter() - t0;
+		r->rpcs += session_rpc_count() - rpcs;
+		if (res)
+			goto out;
+		if (n < num_samples)
+			samples[n] = t;
+		r->ticks += t;
+	}
+
+	qsort(samples, num_samples, sizeof(*samples), cmp_u64);
+
+	r->ops = ops;
+	r->freq = read_cntfrq();
+	r->ticks_per_op = r->ticks / ops;
+	if (r->ticks)
+		r->ops_per_sec = (ops * r->freq) / r->ticks;
+	r->min = samples[0];
+	r->p50 = percentile(samples, num_samples, 50);
+	r->p90 = percentile(samples, num_samples, 90);
+	r->p99 = percentile(samples, num_samples, 99);
+	r->max = samples[num_samples - 1];
+out:
+	free(samples);
+	return res;
+}
+
+TEE_Result core_bench_tests(uint32_t param_types,
+			    TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					  TEE_PARAM_TYPE_NONE);
+	const size_t min_size = offsetof(struct pta_bench_result, rpcs);
+	struct pta_bench_result r = { };
+	size_t size = 0;
+	const struct bench_case *bc = NULL;
+	TEE_Result res = TEE_ERROR_GENERIC;
+	struct bench b = { };
+	uint32_t ops = 0;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (params[0].value.a >= ARRAY_SIZE(bench_cases) ||
+	    !bench_cases[params[0].value.a].op)
+		return TEE_ERROR_NOT_SUPPORTED;
+	bc = bench_cases + params[0].value.a;
+
+	ops = params[0].value.b;
+	if (!ops)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (params[2].memref.size < min_size) {
+		params[2].memref.size = sizeof(r);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	size = MIN(params[2].memref.size, sizeof(r));
+
+	b.size = params[1].value.a;
+	b.storage_id = params[1].value.b;
+	if (bc->init) {
+		res = bc->init(&b);
+		if (res)
+			return res;
+	}
+
+	res = run_bench(bc, &b, ops, &r);
+
+	if (bc->final)
+		bc->final(&b);
+	if (res)
+		return res;
+
+	memcpy(params[2].memref.buffer, &r, size);
+	params[2].memref.size = size;
+
+	return TEE_SUCCESS;
+}
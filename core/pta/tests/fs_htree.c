@@ -500,7 +500,9 @@ static TEE_Result test_corrupt_type(const TEE_UUID *uuid, uint8_t *hash,
 		/*
 		 * Errors in head or node is detected by
 		 * tee_fs_htree_open() errors in block is detected when
-		 * actually read by do_range(read_block)
+		 * actually read by do_range(read_block). With
+		 * CFG_FS_HTREE_LAZY_VERIFY=y errors in most nodes are
+		 * also detected by do_range(read_block).
 		 */
 		res = tee_fs_htree_open(false, hash, uuid, &test_htree_ops,
 					&aux2, &ht);
@@ -616,6 +618,125 @@ out:
 	return res;
 }
 
+static TEE_Result test_truncate(size_t num_blocks, size_t keep_blocks)
+{
+	TEE_Result res;
+	struct tee_fs_htree *ht = NULL;
+	struct tee_ta_session *sess;
+	uint8_t hash[TEE_FS_HTREE_HASH_SIZE];
+	const TEE_UUID *uuid;
+	struct test_aux *aux;
+
+	assert(keep_blocks && keep_blocks <= num_blocks);
+
+	res = tee_ta_get_current_session(&sess);
+	if (res)
+		return res;
+	uuid = &sess->ctx->uuid;
+
+	aux = aux_alloc(num_blocks);
+	if (!aux)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	aux->data_len = 0;
+	memset(aux->data, 0xce, aux->data_alloced);
+
+	res = tee_fs_htree_open(true, hash, uuid, &test_htree_ops, aux, &ht);
+	CHECK_RES(res, goto out);
+	res = do_range(write_block, &ht, 0, num_blocks, 1);
+	CHECK_RES(res, goto out);
+	res = tee_fs_htree_sync_to_storage(&ht, hash);
+	CHECK_RES(res, goto out);
+	tee_fs_htree_close(&ht);
+
+	/*
+	 * Truncate an object which has just been opened and verify that
+	 * the remaining blocks can be read after it's reopened.
+	 */
+	res = tee_fs_htree_open(false, hash, uuid, &test_htree_ops, aux, &ht);
+	CHECK_RES(res, goto out);
+	res = tee_fs_htree_truncate(&ht, keep_blocks - 1);
+	CHECK_RES(res, goto out);
+	res = tee_fs_htree_sync_to_storage(&ht, hash);
+	CHECK_RES(res, goto out);
+	tee_fs_htree_close(&ht);
+
+	res = tee_fs_htree_open(false, hash, uuid, &test_htree_ops, aux, &ht);
+	CHECK_RES(res, goto out);
+	res = do_range(read_block, &ht, 0, keep_blocks, 1);
+	CHECK_RES(res, goto out);
+
+out:
+	tee_fs_htree_close(&ht);
+	aux_free(aux);
+	if (res == TEE_ERROR_TIME_NOT_SET)
+		res = TEE_ERROR_SECURITY;
+	return res;
+}
+
+struct fs_htree_bench {
+	struct test_aux *aux;
+	struct tee_fs_htree *ht;
+	size_t num_blocks;
+};
+
+TEE_Result core_fs_htree_bench_open(size_t num_blocks,
+				    struct fs_htree_bench **fhb_ret)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	uint8_t hash[TEE_FS_HTREE_HASH_SIZE] = { };
+	struct tee_ta_session *sess = NULL;
+	struct fs_htree_bench *fhb = NULL;
+
+	if (!num_blocks || num_blocks >= UINT16_MAX)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = tee_ta_get_current_session(&sess);
+	if (res)
+		return res;
+
+	fhb = calloc(1, sizeof(*fhb));
+	if (!fhb)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	fhb->num_blocks = num_blocks;
+	fhb->aux = aux_alloc(num_blocks);
+	if (!fhb->aux) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto err;
+	}
+
+	res = tee_fs_htree_open(true, hash, &sess->ctx->uuid, &test_htree_ops,
+				fhb->aux, &fhb->ht);
+	if (res)
+		goto err;
+	res = do_range(write_block, &fhb->ht, 0, num_blocks, 0);
+	if (res)
+		goto err;
+
+	*fhb_ret = fhb;
+	return TEE_SUCCESS;
+err:
+	core_fs_htree_bench_close(fhb);
+	return res;
+}
+
+TEE_Result core_fs_htree_bench_op(struct fs_htree_bench *fhb, size_t n,
+				  bool write)
+{
+	if (write)
+		return write_block(&fhb->ht, n % fhb->num_blocks, 0);
+	return read_block(&fhb->ht, n % fhb->num_blocks, 0);
+}
+
+void core_fs_htree_bench_close(struct fs_htree_bench *fhb)
+{
+	if (fhb) {
+		tee_fs_htree_close(&fhb->ht);
+		aux_free(fhb->aux);
+		free(fhb);
+	}
+}
+
 TEE_Result core_fs_htree_tests(uint32_t nParamTypes,
 			       TEE_Param pParams[TEE_NUM_PARAMS] __unused)
 {
@@ -628,5 +749,9 @@ TEE_Result core_fs_htree_tests(uint32_t nParamTypes,
 	if (res)
 		return res;
 
+	res = test_truncate(10, 3);
+	if (res)
+		return res;
+
 	return test_corrupt(5);
 }
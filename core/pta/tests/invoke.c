@@ -410,6 +410,10 @@ static TEE_Result invoke_command(void *pSessionContext __unused,
 		return core_mutex_tests(nParamTypes, pParams);
 	case PTA_INVOKE_TESTS_CMD_LOCKDEP:
 		return core_lockdep_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_AE_PERF:
+		return core_authenc_perf_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_BENCH:
+		return core_bench_tests(nParamTypes, pParams);
 	default:
 		break;
 	}
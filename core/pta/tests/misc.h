@@ -6,6 +6,8 @@
 #define CORE_PTA_TESTS_MISC_H
 
 #include <compiler.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <tee_api_types.h>
 #include <tee_api_defines.h>
 
@@ -16,9 +18,28 @@ TEE_Result core_self_tests(uint32_t nParamTypes,
 TEE_Result core_fs_htree_tests(uint32_t nParamTypes,
 			       TEE_Param pParams[TEE_NUM_PARAMS]);
 
+/*
+ * Hash tree of blocks stored in memory for core_bench_tests(), all blocks
+ * are written once it's opened. Operation @n reads or writes block @n
+ * modulo the number of blocks.
+ */
+struct fs_htree_bench;
+
+TEE_Result core_fs_htree_bench_open(size_t num_blocks,
+				    struct fs_htree_bench **fhb);
+TEE_Result core_fs_htree_bench_op(struct fs_htree_bench *fhb, size_t n,
+				  bool write);
+void core_fs_htree_bench_close(struct fs_htree_bench *fhb);
+
 TEE_Result core_mutex_tests(uint32_t nParamTypes,
 			    TEE_Param pParams[TEE_NUM_PARAMS]);
 
+TEE_Result core_authenc_perf_tests(uint32_t nParamTypes,
+				   TEE_Param pParams[TEE_NUM_PARAMS]);
+
+TEE_Result core_bench_tests(uint32_t nParamTypes,
+			    TEE_Param pParams[TEE_NUM_PARAMS]);
+
 #ifdef CFG_LOCKDEP
 TEE_Result core_lockdep_tests(uint32_t nParamTypes,
 			      TEE_Param pParams[TEE_NUM_PARAMS]);
@@ -1,3 +1,5 @@
+srcs-y += authenc_perf.c
+srcs-y += bench.c
 srcs-$(CFG_WITH_USER_TA) += fs_htree.c
 srcs-y += interrupt.c
 srcs-y += invoke.c
@@ -0,0 +1,204 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/mutex.h>
+#include <kernel/pseudo_ta.h>
+#include <kernel/thread.h>
+#include <kernel/trace_bin.h>
+#include <kernel/tracepoint.h>
+#include <mm/core_memprot.h>
+#include <mm/mobj.h>
+#include <pta_trace.h>
+#include <string.h>
+#include <string_ext.h>
+#include <trace.h>
+#include <util.h>
+
+#define TA_NAME		"trace.ta"
+
+/* Upper limit of records per CPU, 2 MiB per CPU */
+#define MAX_NUM_RECS	65536
+
+static struct mutex trace_mu = MUTEX_INITIALIZER;
+static struct mobj *trace_mobj;
+static size_t trace_buf_size;
+
+static TEE_Result get_events(uint32_t ptypes, TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	struct pta_trace_event_desc *desc = params[0].memref.buffer;
+	const struct tracepoint *first = NULL;
+	const struct tracepoint *tp = NULL;
+	size_t count = 0;
+	size_t n = 0;
+
+	if (ptypes != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	first = SCATTERED_ARRAY_BEGIN(tracepoints, struct tracepoint);
+	count = SCATTERED_ARRAY_END(tracepoints, struct tracepoint) - first;
+	if (params[0].memref.size < count * sizeof(*desc)) {
+		params[0].memref.size = count * sizeof(*desc);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	if (count && !ALIGNMENT_IS_OK(desc, struct pta_trace_event_desc))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	SCATTERED_ARRAY_FOREACH(tp, tracepoints, struct tracepoint) {
+		desc[n] = (struct pta_trace_event_desc){
+			.id = n,
+			.category = tp->category,
+		};
+		strlcpy(desc[n].name, tp->name, sizeof(desc[n].name));
+		n++;
+	}
+	params[0].memref.size = count * sizeof(*desc);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result start(uint32_t ptypes, TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_NONE);
+	size_t num_recs = params[0].value.b;
+	TEE_Result res = TEE_SUCCESS;
+	paddr_t pa = 0;
+	void *va = NULL;
+
+	if (ptypes != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mutex_lock(&trace_mu);
+
+	if (!trace_mobj) {
+		if (!IS_POWER_OF_TWO(num_recs) || num_recs > MAX_NUM_RECS) {
+			res = TEE_ERROR_BAD_PARAMETERS;
+			goto out;
+		}
+
+		trace_buf_size = tracepoint_get_buf_size(num_recs);
+		trace_mobj = thread_rpc_alloc_global_payload(trace_buf_size);
+		if (!trace_mobj) {
+			res = TEE_ERROR_OUT_OF_MEMORY;
+			goto out;
+		}
+		va = mobj_get_va(trace_mobj, 0);
+		if (!va) {
+			thread_rpc_free_global_payload(trace_mobj);
+			trace_mobj = NULL;
+			res = TEE_ERROR_BAD_STATE;
+			goto out;
+		}
+		tracepoint_set_buf(va, num_recs);
+	}
+
+	res = mobj_get_pa(trace_mobj, 0, 0, &pa);
+	if (res)
+		goto out;
+
+	reg_pair_from_64(pa, &params[1].value.a, &params[1].value.b);
+	params[2].value.a = trace_buf_size;
+	params[2].value.b = 0;
+	tracepoint_categories = params[0].value.a;
+	DMSG("Trace buffer at %#"PRIxPA", categories %#"PRIx32,
+	     pa, tracepoint_categories);
+out:
+	mutex_unlock(&trace_mu);
+
+	return res;
+}
+
+static TEE_Result stop(uint32_t ptypes,
+		       TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	if (ptypes != TEE_PARAM_TYPES(TEE_PARAM_TYPE_NONE,
+				      TEE_PARAM_TYPE_NONE,
+				      TEE_PARAM_TYPE_NONE,
+				      TEE_PARAM_TYPE_NONE))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	tracepoint_categories = 0;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result log_level(uint32_t ptypes, TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	uint32_t level = params[0].value.a;
+
+	if (ptypes != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (level != PTA_TRACE_LOG_LEVEL_KEEP && level > TRACE_MAX)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	params[1].value.a = trace_get_level();
+	params[1].value.b = 0;
+	if (level != PTA_TRACE_LOG_LEVEL_KEEP) {
+		trace_set_level(level);
+		DMSG("Log level %"PRIu32, level);
+	}
+
+	return TEE_SUCCESS;
+}
+
+#ifdef CFG_CORE_BINARY_TRACE
+static TEE_Result get_log(uint32_t ptypes, TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	size_t len = params[0].memref.size;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (ptypes != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mutex_lock(&trace_mu);
+	res = trace_bin_read(params[0].memref.buffer, &len);
+	mutex_unlock(&trace_mu);
+	params[0].memref.size = len;
+
+	return res;
+}
+#endif
+
+static TEE_Result invoke_command(void *psess __unused,
+				 uint32_t cmd, uint32_t ptypes,
+				 TEE_Param params[TEE_NUM_PARAMS])
+{
+	switch (cmd) {
+	case PTA_TRACE_GET_EVENTS:
+		return get_events(ptypes, params);
+	case PTA_TRACE_START:
+		return start(ptypes, params);
+	case PTA_TRACE_STOP:
+		return stop(ptypes, params);
+	case PTA_TRACE_LOG_LEVEL:
+		return log_level(ptypes, params);
+#ifdef CFG_CORE_BINARY_TRACE
+	case PTA_TRACE_GET_LOG:
+		return get_log(ptypes, params);
+#endif
+	default:
+		break;
+	}
+
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+
+pseudo_ta_register(.uuid = PTA_TRACE_UUID, .name = TA_NAME,
+		   .flags = PTA_DEFAULT_FLAGS,
+		   .invoke_command_entry_point = invoke_command);
@@ -8,15 +8,42 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string_ext.h>
 #include <tee/fs_dirfile.h>
 #include <types_ext.h>
+#include <util.h>
 
+#define DIRFILE_INDEX_MIN_BUCKETS	16
+#define DIRFILE_INDEX_END		-1
+
+/*
+ * struct dirfile_index - in memory index of a dirfile entry
+ * @key:	hash of the UUID and object ID of the entry
+ * @next:	next entry in the same bucket or DIRFILE_INDEX_END
+ * @used:	true if the entry holds an object
+ */
+struct dirfile_index {
+	uint32_t key;
+	int next;
+	bool used;
+};
+
+/*
+ * @index:	one struct dirfile_index per entry in the dirfile, only
+ *		used entries are linked into @buckets
+ * @index_size:	number of elements in @index
+ * @buckets:	heads of the hash chains, @nbuckets is a power of 2
+ */
 struct tee_fs_dirfile_dirh {
 	const struct tee_fs_dirfile_operations *fops;
 	struct tee_file_handle *fh;
 	int nbits;
 	bitstr_t *files;
 	size_t ndents;
+	struct dirfile_index *index;
+	size_t index_size;
+	int *buckets;
+	size_t nbuckets;
 };
 
 struct dirfile_entry {
@@ -25,8 +52,16 @@ struct dirfile_entry {
 	uint32_t oidlen;
 	uint8_t hash[TEE_FS_HTREE_HASH_SIZE];
 	uint32_t file_number;
+#if CFG_REE_FS_INLINE_SIZE
+	uint32_t flags;
+	uint32_t data_len;
+	uint8_t data[CFG_REE_FS_INLINE_SIZE];
+#endif
 };
 
+/* The content is in @data, @hash and @file_number are unused */
+#define DIRFILE_FLAG_INLINE	BIT32(0)
+
 /*
  * File layout
  *
@@ -35,8 +70,20 @@ struct dirfile_entry {
  * dirfile_entry.n
  *
  * where n the index is disconnected from file_number in struct dirfile_entry
+ *
+ * With CFG_REE_FS_INLINE_SIZE > 0 an entry may hold the content of a
+ * small object itself, no file number is used by such an entry.
  */
 
+static bool dent_is_inline(const struct dirfile_entry *dent __maybe_unused)
+{
+#if CFG_REE_FS_INLINE_SIZE
+	return dent->flags & DIRFILE_FLAG_INLINE;
+#else
+	return false;
+#endif
+}
+
 static TEE_Result maybe_grow_files(struct tee_fs_dirfile_dirh *dirh, int idx)
 {
 	void *p;
@@ -79,6 +126,120 @@ static bool test_file(struct tee_fs_dirfile_dirh *dirh, int idx)
 	return false;
 }
 
+static uint32_t index_key(const TEE_UUID *uuid, const void *oid,
+			  size_t oidlen)
+{
+	const uint8_t *p = (const uint8_t *)uuid;
+	uint32_t h = 2166136261U ^ oidlen;
+	size_t n = 0;
+
+	/* FNV-1a over the UUID followed by the object ID */
+	for (n = 0; n < sizeof(*uuid); n++)
+		h = (h ^ p[n]) * 16777619U;
+	p = oid;
+	for (n = 0; n < oidlen; n++)
+		h = (h ^ p[n]) * 16777619U;
+
+	return h;
+}
+
+static int *index_bucket(struct tee_fs_dirfile_dirh *dirh, uint32_t key)
+{
+	return dirh->buckets + (key & (dirh->nbuckets - 1));
+}
+
+static void index_rehash(struct tee_fs_dirfile_dirh *dirh)
+{
+	size_t n = 0;
+
+	for (n = 0; n < dirh->nbuckets; n++)
+		dirh->buckets[n] = DIRFILE_INDEX_END;
+
+	for (n = 0; n < dirh->index_size; n++) {
+		struct dirfile_index *e = dirh->index + n;
+		int *b = NULL;
+
+		if (!e->used)
+			continue;
+		b = index_bucket(dirh, e->key);
+		e->next = *b;
+		*b = n;
+	}
+}
+
+/*
+ * Makes room for entry @idx in the index, done before the entry is
+ * written so that updating the index afterwards can't fail.
+ */
+static TEE_Result index_reserve(struct tee_fs_dirfile_dirh *dirh, size_t idx)
+{
+	size_t nbuckets = dirh->nbuckets;
+	size_t size = dirh->index_size;
+	void *p = NULL;
+	size_t n = 0;
+
+	if (idx < size)
+		return TEE_SUCCESS;
+
+	if (!size)
+		size = DIRFILE_INDEX_MIN_BUCKETS;
+	while (size <= idx)
+		size *= 2;
+
+	p = realloc(dirh->index, size * sizeof(*dirh->index));
+	if (!p)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	dirh->index = p;
+	for (n = dirh->index_size; n < size; n++)
+		dirh->index[n] = (struct dirfile_index){
+			.next = DIRFILE_INDEX_END,
+		};
+	dirh->index_size = size;
+
+	/* Keep on average at most one entry per bucket */
+	if (!nbuckets)
+		nbuckets = DIRFILE_INDEX_MIN_BUCKETS;
+	while (nbuckets < size)
+		nbuckets *= 2;
+	if (nbuckets != dirh->nbuckets) {
+		p = realloc(dirh->buckets, nbuckets * sizeof(*dirh->buckets));
+		if (!p)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		dirh->buckets = p;
+		dirh->nbuckets = nbuckets;
+		index_rehash(dirh);
+	}
+
+	return TEE_SUCCESS;
+}
+
+/* Updates the index with the new content of entry @idx */
+static void index_update(struct tee_fs_dirfile_dirh *dirh, size_t idx,
+			 const struct dirfile_entry *dent)
+{
+	struct dirfile_index *e = dirh->index + idx;
+	int *b = NULL;
+
+	assert(idx < dirh->index_size);
+
+	if (e->used) {
+		for (b = index_bucket(dirh, e->key); *b != (int)idx;
+		     b = &dirh->index[*b].next)
+			assert(*b != DIRFILE_INDEX_END);
+		*b = e->next;
+		e->next = DIRFILE_INDEX_END;
+		e->used = false;
+	}
+
+	if (dent->oidlen) {
+		e->key = index_key(&dent->uuid, dent->oid, dent->oidlen);
+		e->used = true;
+		b = index_bucket(dirh, e->key);
+		e->next = *b;
+		*b = idx;
+	}
+}
+
 static TEE_Result read_dent(struct tee_fs_dirfile_dirh *dirh, int idx,
 			    struct dirfile_entry *dent)
 {
@@ -99,12 +260,20 @@ static TEE_Result write_dent(struct tee_fs_dirfile_dirh *dirh, size_t n,
 {
 	TEE_Result res;
 
+	res = index_reserve(dirh, n);
+	if (res)
+		return res;
+
 	res = dirh->fops->write(dirh->fh, sizeof(*dent) * n,
 				dent, sizeof(*dent));
-	if (!res && n >= dirh->ndents)
+	if (res)
+		return res;
+
+	index_update(dirh, n, dent);
+	if (n >= dirh->ndents)
 		dirh->ndents = n + 1;
 
-	return res;
+	return TEE_SUCCESS;
 }
 
 TEE_Result tee_fs_dirfile_open(bool create, uint8_t *hash,
@@ -136,6 +305,9 @@ TEE_Result tee_fs_dirfile_open(bool create, uint8_t *hash,
 		if (!dent.oidlen)
 			continue;
 
+		if (dent_is_inline(&dent))
+			goto update_index;
+
 		if (test_file(dirh, dent.file_number)) {
 			DMSG("clearing duplicate file number %" PRIu32,
 			     dent.file_number);
@@ -149,6 +321,11 @@ TEE_Result tee_fs_dirfile_open(bool create, uint8_t *hash,
 		res = set_file(dirh, dent.file_number);
 		if (res != TEE_SUCCESS)
 			goto out;
+update_index:
+		res = index_reserve(dirh, n);
+		if (res != TEE_SUCCESS)
+			goto out;
+		index_update(dirh, n, &dent);
 	}
 out:
 	if (!res) {
@@ -165,6 +342,8 @@ void tee_fs_dirfile_close(struct tee_fs_dirfile_dirh *dirh)
 	if (dirh) {
 		dirh->fops->close(dirh->fh);
 		free(dirh->files);
+		free(dirh->index);
+		free(dirh->buckets);
 		free(dirh);
 	}
 }
@@ -194,45 +373,67 @@ TEE_Result tee_fs_dirfile_get_tmp(struct tee_fs_dirfile_dirh *dirh,
 	return res;
 }
 
+TEE_Result tee_fs_dirfile_hold_file(struct tee_fs_dirfile_dirh *dirh,
+				    uint32_t file_number)
+{
+	return set_file(dirh, file_number);
+}
+
+void tee_fs_dirfile_release_file(struct tee_fs_dirfile_dirh *dirh,
+				 uint32_t file_number)
+{
+	clear_file(dirh, file_number);
+}
+
 TEE_Result tee_fs_dirfile_find(struct tee_fs_dirfile_dirh *dirh,
 			       const TEE_UUID *uuid, const void *oid,
 			       size_t oidlen, struct tee_fs_dirfile_fileh *dfh)
 {
 	TEE_Result res;
-	struct dirfile_entry dent;
-	int n;
-	int first_free = -1;
+	struct dirfile_entry dent = { };
+	uint32_t key = 0;
+	int n = 0;
+
+	if (!oidlen) {
+		/* Find a free entry, or the one following the last */
+		while ((size_t)n < dirh->ndents &&
+		       (size_t)n < dirh->index_size && dirh->index[n].used)
+			n++;
+		goto out;
+	}
+
+	/*
+	 * Only entries with a matching key are read, normally just the
+	 * one searched for.
+	 */
+	if (!dirh->nbuckets)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+	key = index_key(uuid, oid, oidlen);
+	for (n = *index_bucket(dirh, key); n != DIRFILE_INDEX_END;
+	     n = dirh->index[n].next) {
+		if (dirh->index[n].key != key)
+			continue;
 
-	for (n = 0;; n++) {
 		res = read_dent(dirh, n, &dent);
-		if (res == TEE_ERROR_ITEM_NOT_FOUND && !oidlen) {
-			memset(&dent, 0, sizeof(dent));
-			if (first_free != -1)
-				n = first_free;
-			break;
-		}
 		if (res)
 			return res;
 
-		/* TODO check this loop when oidlen == 0 */
-
-		if (!dent.oidlen && first_free == -1)
-			first_free = n;
-		if (dent.oidlen != oidlen)
-			continue;
-
-		assert(!oidlen || !dent.oidlen ||
+		assert(dent_is_inline(&dent) ||
 		       test_file(dirh, dent.file_number));
 
-		if (!memcmp(&dent.uuid, uuid, sizeof(dent.uuid)) &&
+		if (dent.oidlen == oidlen &&
+		    !memcmp(&dent.uuid, uuid, sizeof(dent.uuid)) &&
 		    !memcmp(&dent.oid, oid, oidlen))
-			break;
+			goto out;
 	}
 
+	return TEE_ERROR_ITEM_NOT_FOUND;
+out:
 	if (dfh) {
 		dfh->idx = n;
 		dfh->file_number = dent.file_number;
 		memcpy(dfh->hash, dent.hash, sizeof(dent.hash));
+		dfh->is_inline = dent_is_inline(&dent);
 	}
 
 	return TEE_SUCCESS;
@@ -269,12 +470,20 @@ TEE_Result tee_fs_dirfile_rename(struct tee_fs_dirfile_dirh *dirh,
 
 	if (!oidlen || oidlen > sizeof(dent.oid))
 		return TEE_ERROR_BAD_PARAMETERS;
-	memset(&dent, 0, sizeof(dent));
+	if (dfh->is_inline) {
+		/* The content moves along with the entry */
+		res = read_dent(dirh, dfh->idx, &dent);
+		if (res)
+			return res;
+		memset(dent.oid, 0, sizeof(dent.oid));
+	} else {
+		memset(&dent, 0, sizeof(dent));
+		memcpy(dent.hash, dfh->hash, sizeof(dent.hash));
+		dent.file_number = dfh->file_number;
+	}
 	dent.uuid = *uuid;
 	memcpy(dent.oid, oid, oidlen);
 	dent.oidlen = oidlen;
-	memcpy(dent.hash, dfh->hash, sizeof(dent.hash));
-	dent.file_number = dfh->file_number;
 
 	if (dfh->idx < 0) {
 		struct tee_fs_dirfile_fileh dfh2;
@@ -307,6 +516,11 @@ TEE_Result tee_fs_dirfile_remove(struct tee_fs_dirfile_dirh *dirh,
 	if (!dent.oidlen)
 		return TEE_SUCCESS;
 
+	if (dent_is_inline(&dent)) {
+		memset(&dent, 0, sizeof(dent));
+		return write_dent(dirh, dfh->idx, &dent);
+	}
+
 	file_number = dent.file_number;
 	assert(dfh->file_number == file_number);
 	assert(test_file(dirh, file_number));
@@ -328,6 +542,15 @@ TEE_Result tee_fs_dirfile_update_hash(struct tee_fs_dirfile_dirh *dirh,
 	res = read_dent(dirh, dfh->idx, &dent);
 	if (res)
 		return res;
+#if CFG_REE_FS_INLINE_SIZE
+	if (dent_is_inline(&dent)) {
+		/* The content has been moved to the file in @dfh */
+		dent.flags &= ~DIRFILE_FLAG_INLINE;
+		dent.data_len = 0;
+		memzero_explicit(dent.data, sizeof(dent.data));
+		dent.file_number = dfh->file_number;
+	}
+#endif
 	assert(dent.file_number == dfh->file_number);
 	assert(test_file(dirh, dent.file_number));
 
@@ -336,6 +559,94 @@ TEE_Result tee_fs_dirfile_update_hash(struct tee_fs_dirfile_dirh *dirh,
 	return write_dent(dirh, dfh->idx, &dent);
 }
 
+#if CFG_REE_FS_INLINE_SIZE
+TEE_Result tee_fs_dirfile_set_inline(struct tee_fs_dirfile_dirh *dirh,
+				     const TEE_UUID *uuid,
+				     struct tee_fs_dirfile_fileh *dfh,
+				     const void *oid, size_t oidlen,
+				     const void *data, size_t len)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct dirfile_entry dent = { };
+
+	if (!oidlen || oidlen > sizeof(dent.oid) || len > sizeof(dent.data))
+		return TEE_ERROR_BAD_PARAMETERS;
+	dent.uuid = *uuid;
+	memcpy(dent.oid, oid, oidlen);
+	dent.oidlen = oidlen;
+	dent.flags = DIRFILE_FLAG_INLINE;
+	dent.data_len = len;
+	memcpy(dent.data, data, len);
+
+	if (dfh->idx < 0) {
+		struct tee_fs_dirfile_fileh dfh2;
+
+		res = tee_fs_dirfile_find(dirh, uuid, oid, oidlen, &dfh2);
+		if (res) {
+			if (res == TEE_ERROR_ITEM_NOT_FOUND)
+				res = tee_fs_dirfile_find(dirh, uuid, NULL, 0,
+							  &dfh2);
+			if (res)
+				goto out;
+		}
+		dfh->idx = dfh2.idx;
+	}
+
+	res = write_dent(dirh, dfh->idx, &dent);
+	if (!res)
+		dfh->is_inline = true;
+out:
+	memzero_explicit(&dent, sizeof(dent));
+	return res;
+}
+
+TEE_Result tee_fs_dirfile_update_inline(struct tee_fs_dirfile_dirh *dirh,
+					const struct tee_fs_dirfile_fileh *dfh,
+					const void *data, size_t len)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct dirfile_entry dent = { };
+
+	if (len > sizeof(dent.data))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = read_dent(dirh, dfh->idx, &dent);
+	if (res)
+		goto out;
+	assert(dent_is_inline(&dent));
+
+	memzero_explicit(dent.data, sizeof(dent.data));
+	memcpy(dent.data, data, len);
+	dent.data_len = len;
+	res = write_dent(dirh, dfh->idx, &dent);
+out:
+	memzero_explicit(&dent, sizeof(dent));
+	return res;
+}
+
+TEE_Result tee_fs_dirfile_read_inline(struct tee_fs_dirfile_dirh *dirh,
+				      const struct tee_fs_dirfile_fileh *dfh,
+				      void *data, size_t *len)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct dirfile_entry dent = { };
+
+	res = read_dent(dirh, dfh->idx, &dent);
+	if (res)
+		goto out;
+	if (!dent_is_inline(&dent) || dent.data_len > sizeof(dent.data)) {
+		res = TEE_ERROR_CORRUPT_OBJECT;
+		goto out;
+	}
+
+	memcpy(data, dent.data, dent.data_len);
+	*len = dent.data_len;
+out:
+	memzero_explicit(&dent, sizeof(dent));
+	return res;
+}
+#endif /*CFG_REE_FS_INLINE_SIZE*/
+
 TEE_Result tee_fs_dirfile_get_next(struct tee_fs_dirfile_dirh *dirh,
 				   const TEE_UUID *uuid, int *idx, void *oid,
 				   size_t *oidlen)
@@ -347,7 +658,12 @@ TEE_Result tee_fs_dirfile_get_next(struct tee_fs_dirfile_dirh *dirh,
 	if (i < 0)
 		i = 0;
 
+	/* Free entries aren't read, every used entry is in the index */
 	for (;; i++) {
+		if ((size_t)i >= dirh->ndents)
+			return TEE_ERROR_ITEM_NOT_FOUND;
+		if ((size_t)i >= dirh->index_size || !dirh->index[i].used)
+			continue;
 		res = read_dent(dirh, i, &dent);
 		if (res)
 			return res;
@@ -4,10 +4,13 @@
  */
 
 #include <assert.h>
+#include <config.h>
 #include <crypto/crypto.h>
+#include <crypto/internal_aes-gcm.h>
 #include <initcall.h>
 #include <kernel/tee_common_otp.h>
 #include <stdlib.h>
+#include <stdlib_ext.h>
 #include <string_ext.h>
 #include <string.h>
 #include <tee/fs_htree.h>
@@ -23,7 +26,6 @@
 #define TEE_FS_HTREE_ENC_SIZE		TEE_AES_BLOCK_SIZE
 #define TEE_FS_HTREE_SSK_SIZE		TEE_FS_HTREE_HASH_SIZE
 
-#define TEE_FS_HTREE_AUTH_ENC_ALG	TEE_ALG_AES_GCM
 #define TEE_FS_HTREE_HMAC_ALG		TEE_ALG_HMAC_SHA256
 
 #define BLOCK_NUM_TO_NODE_ID(num)	((num) + 1)
@@ -76,10 +78,19 @@
 /* n is 0 or 1 */
 #define HTREE_NODE_COMMITTED_CHILD(n)	BIT32(1 + (n))
 
+/*
+ * With CFG_FS_HTREE_LAZY_VERIFY=y the node images are only read when the
+ * parent node is verified, which in turn is done the first time the node
+ * or one of its descendants is used. @loaded tells if @node holds the
+ * image from storage (or a new image) and @verified if the hash of the
+ * node has been checked. A node can't be verified before its parent.
+ */
 struct htree_node {
 	size_t id;
 	bool dirty;
 	bool block_updated;
+	bool loaded;
+	bool verified;
 	struct tee_fs_htree_node_image node;
 	struct htree_node *parent;
 	struct htree_node *child[2];
@@ -89,6 +100,7 @@ struct tee_fs_htree {
 	struct htree_node root;
 	struct tee_fs_htree_image head;
 	uint8_t fek[TEE_FS_HTREE_FEK_SIZE];
+	struct internal_aes_gcm_prepared_key ae_key;
 	struct tee_fs_htree_imeta imeta;
 	bool dirty;
 	const TEE_UUID *uuid;
@@ -251,9 +263,13 @@ static struct htree_node *find_node(struct tee_fs_htree *ht, size_t node_id)
 	return NULL;
 }
 
+static TEE_Result verify_path(struct tee_fs_htree *ht,
+			      struct htree_node *node);
+
 static TEE_Result get_node(struct tee_fs_htree *ht, bool create,
 			   size_t node_id, struct htree_node **node_ret)
 {
+	TEE_Result res;
 	struct htree_node *node;
 	struct htree_node *nc;
 	size_t n;
@@ -283,10 +299,17 @@ static TEE_Result get_node(struct tee_fs_htree *ht, bool create,
 		assert((n >> 1) == node->id);
 		assert(!node->child[n & 1]);
 
+		/* The hash of the parent is about to be updated */
+		res = verify_path(ht, node);
+		if (res != TEE_SUCCESS)
+			return res;
+
 		nc = calloc(1, sizeof(*nc));
 		if (!nc)
 			return TEE_ERROR_OUT_OF_MEMORY;
 		nc->id = n;
+		nc->loaded = true;
+		nc->verified = true;
 		nc->parent = node;
 		node->child[n & 1] = nc;
 		node = nc;
@@ -361,41 +384,161 @@ static TEE_Result init_head_from_data(struct tee_fs_htree *ht,
 	}
 
 	ht->root.id = 1;
+	ht->root.loaded = true;
 
 	return TEE_SUCCESS;
 }
 
-static TEE_Result init_tree_from_data(struct tee_fs_htree *ht)
+static TEE_Result read_node(struct tee_fs_htree *ht, size_t node_id)
 {
 	TEE_Result res;
 	struct tee_fs_htree_node_image node_image;
 	struct htree_node *node;
 	struct htree_node *nc;
 	size_t committed_version;
-	size_t node_id = 2;
 
-	while (node_id <= ht->imeta.max_node_id) {
+	node = find_node(ht, node_id >> 1);
+	if (!node)
+		return TEE_ERROR_GENERIC;
+	committed_version = !!(node->node.flags &
+			    HTREE_NODE_COMMITTED_CHILD(node_id & 1));
+
+	res = rpc_read_node(ht, node_id, committed_version, &node_image);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	nc = find_node(ht, node_id);
+	if (!nc)
+		return TEE_ERROR_GENERIC;
+	nc->node = node_image;
+	nc->loaded = true;
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Reads nodes @first to @last, the parents of the nodes must already be
+ * loaded. The nodes are read with a single RPC if supported by the
+ * storage.
+ */
+static TEE_Result read_nodes(struct tee_fs_htree *ht, size_t first,
+			     size_t last)
+{
+	const size_t node_size = sizeof(struct tee_fs_htree_node_image);
+	TEE_Result res = TEE_ERROR_NOT_SUPPORTED;
+	struct tee_fs_rpc_operation op = { };
+	struct tee_fs_htree_elem *elem = NULL;
+	size_t num = last - first + 1;
+	struct htree_node *node = NULL;
+	size_t len = 0;
+	size_t n = 0;
+
+	if (ht->stor->rpc_readv_init && num > 1)
+		elem = calloc(num, sizeof(*elem));
+	if (!elem)
+		goto fallback;
+
+	for (n = 0; n < num; n++) {
+		size_t node_id = first + n;
+
+		node = find_node(ht, node_id >> 1);
+		if (!node) {
+			res = TEE_ERROR_GENERIC;
+			goto out;
+		}
+		elem[n].type = TEE_FS_HTREE_TYPE_NODE;
+		elem[n].idx = node_id - 1;
+		elem[n].vers = !!(node->node.flags &
+				  HTREE_NODE_COMMITTED_CHILD(node_id & 1));
+	}
+
+	res = ht->stor->rpc_readv_init(ht->stor_aux, &op, elem, num);
+	if (res == TEE_SUCCESS)
+		res = ht->stor->rpc_readv_final(&op, &len);
+	if (res == TEE_ERROR_NOT_SUPPORTED)
+		goto fallback;
+	if (res != TEE_SUCCESS)
+		goto out;
+	if (len != num * node_size) {
+		res = TEE_ERROR_CORRUPT_OBJECT;
+		goto out;
+	}
+
+	for (n = 0; n < num; n++) {
+		node = find_node(ht, first + n);
+		if (!node) {
+			res = TEE_ERROR_GENERIC;
+			goto out;
+		}
+		memcpy(&node->node, elem[n].data, node_size);
+		node->loaded = true;
+	}
+	goto out;
+
+fallback:
+	for (n = first; n <= last; n++) {
+		res = read_node(ht, n);
+		if (res != TEE_SUCCESS)
+			break;
+	}
+out:
+	free(elem);
+	return res;
+}
+
+/* Adds all the nodes to the tree, without reading their images */
+static TEE_Result init_tree_nodes(struct tee_fs_htree *ht)
+{
+	struct htree_node *node = NULL;
+	struct htree_node *nc = NULL;
+	size_t node_id = 0;
+
+	for (node_id = 2; node_id <= ht->imeta.max_node_id; node_id++) {
 		node = find_node(ht, node_id >> 1);
 		if (!node)
 			return TEE_ERROR_GENERIC;
-		committed_version = !!(node->node.flags &
-				    HTREE_NODE_COMMITTED_CHILD(node_id & 1));
 
-		res = rpc_read_node(ht, node_id, committed_version,
-				    &node_image);
-		if (res != TEE_SUCCESS)
-			return res;
+		nc = calloc(1, sizeof(*nc));
+		if (!nc)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		nc->id = node_id;
+		nc->parent = node;
+		node->child[node_id & 1] = nc;
+	}
+
+	return TEE_SUCCESS;
+}
 
-		res = get_node(ht, true, node_id, &nc);
+static TEE_Result init_tree_from_data(struct tee_fs_htree *ht)
+{
+	TEE_Result res;
+	size_t node_id = 2;
+
+	/*
+	 * The version of a node is recorded in its parent so the tree is
+	 * read one level at a time.
+	 */
+	while (node_id <= ht->imeta.max_node_id) {
+		res = read_nodes(ht, node_id,
+				 MIN(node_id * 2 - 1,
+				     (size_t)ht->imeta.max_node_id));
 		if (res != TEE_SUCCESS)
 			return res;
-		nc->node = node_image;
-		node_id++;
+		node_id *= 2;
 	}
 
 	return TEE_SUCCESS;
 }
 
+/*
+ * The hashed data of a node is at most the node image without the hash,
+ * the meta data (root node only) and the hashes of the two children.
+ */
+#define NODE_HASH_DATA_MAX_SIZE	(sizeof(struct tee_fs_htree_node_image) - \
+				 TEE_FS_HTREE_HASH_SIZE + \
+				 sizeof(struct tee_fs_htree_meta) + \
+				 2 * TEE_FS_HTREE_HASH_SIZE)
+
 static TEE_Result calc_node_hash(struct htree_node *node,
 				 struct tee_fs_htree_meta *meta, void *ctx,
 				 uint8_t *digest)
@@ -404,55 +547,74 @@ static TEE_Result calc_node_hash(struct htree_node *node,
 	uint32_t alg = TEE_FS_HTREE_HASH_ALG;
 	uint8_t *ndata = (uint8_t *)&node->node + sizeof(node->node.hash);
 	size_t nsize = sizeof(node->node) - sizeof(node->node.hash);
+	uint8_t buf[NODE_HASH_DATA_MAX_SIZE];
+	size_t len = 0;
+	size_t n = 0;
+
+	/*
+	 * Gather everything in one buffer to hash it with a single update,
+	 * this is called for each dirty node when syncing and for each
+	 * node when verifying so the per call overhead adds up.
+	 */
+	memcpy(buf, ndata, nsize);
+	len = nsize;
+
+	if (meta) {
+		memcpy(buf + len, meta, sizeof(*meta));
+		len += sizeof(*meta);
+	}
+
+	for (n = 0; n < ARRAY_SIZE(node->child); n++) {
+		if (node->child[n]) {
+			memcpy(buf + len, node->child[n]->node.hash,
+			       sizeof(node->child[n]->node.hash));
+			len += sizeof(node->child[n]->node.hash);
+		}
+	}
 
 	res = crypto_hash_init(ctx, alg);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = crypto_hash_update(ctx, alg, ndata, nsize);
+	res = crypto_hash_update(ctx, alg, buf, len);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	if (meta) {
-		res = crypto_hash_update(ctx, alg, (void *)meta, sizeof(*meta));
-		if (res != TEE_SUCCESS)
-			return res;
-	}
-
-	if (node->child[0]) {
-		res = crypto_hash_update(ctx, alg, node->child[0]->node.hash,
-					 sizeof(node->child[0]->node.hash));
-		if (res != TEE_SUCCESS)
-			return res;
-	}
+	return crypto_hash_final(ctx, alg, digest, TEE_FS_HTREE_HASH_SIZE);
+}
 
-	if (node->child[1]) {
-		res = crypto_hash_update(ctx, alg, node->child[1]->node.hash,
-					 sizeof(node->child[1]->node.hash));
-		if (res != TEE_SUCCESS)
-			return res;
-	}
+/*
+ * The additional authenticated data of a node or of the root, collected
+ * by authenc_init() for authenc_decrypt_final() or authenc_encrypt_final()
+ */
+struct authenc_aad {
+	uint8_t buf[TEE_FS_HTREE_FEK_SIZE + sizeof(uint32_t) +
+		    TEE_FS_HTREE_FEK_SIZE + TEE_FS_HTREE_IV_SIZE];
+	size_t len;
+	const uint8_t *iv;
+};
 
-	return crypto_hash_final(ctx, alg, digest, TEE_FS_HTREE_HASH_SIZE);
+static void aad_add(struct authenc_aad *aad, const void *data, size_t len)
+{
+	assert(aad->len + len <= sizeof(aad->buf));
+	memcpy(aad->buf + aad->len, data, len);
+	aad->len += len;
 }
 
-static TEE_Result authenc_init(void **ctx_ret, TEE_OperationMode mode,
+static TEE_Result authenc_init(struct authenc_aad *aad,
+			       TEE_OperationMode mode,
 			       struct tee_fs_htree *ht,
-			       struct tee_fs_htree_node_image *ni,
-			       size_t payload_len)
+			       struct tee_fs_htree_node_image *ni)
 {
 	TEE_Result res = TEE_SUCCESS;
-	const uint32_t alg = TEE_FS_HTREE_AUTH_ENC_ALG;
-	void *ctx;
-	size_t aad_len = TEE_FS_HTREE_FEK_SIZE + TEE_FS_HTREE_IV_SIZE;
 	uint8_t *iv;
 
-	if (ni) {
+	COMPILE_TIME_ASSERT(sizeof(ht->head.counter) == sizeof(uint32_t));
+
+	if (ni)
 		iv = ni->iv;
-	} else {
+	else
 		iv = ht->head.iv;
-		aad_len += TEE_FS_HTREE_HASH_SIZE + sizeof(ht->head.counter);
-	}
 
 	if (mode == TEE_MODE_ENCRYPT) {
 		res = crypto_rng_read(iv, TEE_FS_HTREE_IV_SIZE);
@@ -460,108 +622,83 @@ static TEE_Result authenc_init(void **ctx_ret, TEE_OperationMode mode,
 			return res;
 	}
 
-	res = crypto_authenc_alloc_ctx(&ctx, alg);
-	if (res != TEE_SUCCESS)
-		return res;
-
-	res = crypto_authenc_init(ctx, alg, mode, ht->fek,
-				  TEE_FS_HTREE_FEK_SIZE, iv,
-				  TEE_FS_HTREE_IV_SIZE, TEE_FS_HTREE_TAG_SIZE,
-				  aad_len, payload_len);
-	if (res != TEE_SUCCESS)
-		goto err_free;
-
+	aad->len = 0;
+	aad->iv = iv;
 	if (!ni) {
-		res = crypto_authenc_update_aad(ctx, alg, mode,
-						ht->root.node.hash,
-						TEE_FS_HTREE_FEK_SIZE);
-		if (res != TEE_SUCCESS)
-			goto err;
-
-		res = crypto_authenc_update_aad(ctx, alg, mode,
-						(void *)&ht->head.counter,
-						sizeof(ht->head.counter));
-		if (res != TEE_SUCCESS)
-			goto err;
+		aad_add(aad, ht->root.node.hash, TEE_FS_HTREE_FEK_SIZE);
+		aad_add(aad, &ht->head.counter, sizeof(ht->head.counter));
 	}
-
-	res = crypto_authenc_update_aad(ctx, alg, mode, ht->head.enc_fek,
-					TEE_FS_HTREE_FEK_SIZE);
-	if (res != TEE_SUCCESS)
-		goto err;
-
-	res = crypto_authenc_update_aad(ctx, alg, mode, iv,
-					TEE_FS_HTREE_IV_SIZE);
-	if (res != TEE_SUCCESS)
-		goto err;
-
-	*ctx_ret = ctx;
+	aad_add(aad, ht->head.enc_fek, TEE_FS_HTREE_FEK_SIZE);
+	aad_add(aad, iv, TEE_FS_HTREE_IV_SIZE);
 
 	return TEE_SUCCESS;
-err:
-	crypto_authenc_final(ctx, alg);
-err_free:
-	crypto_authenc_free_ctx(ctx, alg);
-	return res;
 }
 
-static TEE_Result authenc_decrypt_final(void *ctx, const uint8_t *tag,
+static TEE_Result authenc_decrypt_final(struct tee_fs_htree *ht,
+					const struct authenc_aad *aad,
+					const uint8_t *tag,
 					const void *crypt, size_t len,
 					void *plain)
 {
 	TEE_Result res;
-	size_t out_size = len;
-
-	res = crypto_authenc_dec_final(ctx, TEE_FS_HTREE_AUTH_ENC_ALG, crypt,
-				       len, plain, &out_size, tag,
-				       TEE_FS_HTREE_TAG_SIZE);
-	crypto_authenc_final(ctx, TEE_FS_HTREE_AUTH_ENC_ALG);
-	crypto_authenc_free_ctx(ctx, TEE_FS_HTREE_AUTH_ENC_ALG);
 
-	if (res == TEE_SUCCESS && out_size != len)
-		return TEE_ERROR_GENERIC;
+	res = internal_aes_gcm_dec_prepared(&ht->ae_key, aad->iv,
+					    TEE_FS_HTREE_IV_SIZE, aad->buf,
+					    aad->len, crypt, len, plain, tag,
+					    TEE_FS_HTREE_TAG_SIZE);
 	if (res == TEE_ERROR_MAC_INVALID)
 		return TEE_ERROR_CORRUPT_OBJECT;
 
 	return res;
 }
 
-static TEE_Result authenc_encrypt_final(void *ctx, uint8_t *tag,
-					const void *plain, size_t len,
-					void *crypt)
+static TEE_Result authenc_encrypt_final(struct tee_fs_htree *ht,
+					const struct authenc_aad *aad,
+					uint8_t *tag, const void *plain,
+					size_t len, void *crypt)
 {
 	TEE_Result res;
-	size_t out_size = len;
 	size_t out_tag_size = TEE_FS_HTREE_TAG_SIZE;
 
-	res = crypto_authenc_enc_final(ctx, TEE_FS_HTREE_AUTH_ENC_ALG, plain,
-				       len, crypt, &out_size, tag,
-				       &out_tag_size);
-	crypto_authenc_final(ctx, TEE_FS_HTREE_AUTH_ENC_ALG);
-	crypto_authenc_free_ctx(ctx, TEE_FS_HTREE_AUTH_ENC_ALG);
-
-	if (res == TEE_SUCCESS &&
-	    (out_size != len || out_tag_size != TEE_FS_HTREE_TAG_SIZE))
+	res = internal_aes_gcm_enc_prepared(&ht->ae_key, aad->iv,
+					    TEE_FS_HTREE_IV_SIZE, aad->buf,
+					    aad->len, plain, len, crypt, tag,
+					    &out_tag_size);
+	if (res == TEE_SUCCESS && out_tag_size != TEE_FS_HTREE_TAG_SIZE)
 		return TEE_ERROR_GENERIC;
 
 	return res;
 }
 
+/*
+ * Expands the FEK and derives the GHASH key once, each block is then only
+ * encrypted or decrypted with a new IV.
+ */
+static TEE_Result init_ae_key(struct tee_fs_htree *ht)
+{
+	return internal_aes_gcm_prepare_key(ht->fek, sizeof(ht->fek),
+					    &ht->ae_key);
+}
+
 static TEE_Result verify_root(struct tee_fs_htree *ht)
 {
 	TEE_Result res;
-	void *ctx;
+	struct authenc_aad aad;
 
 	res = tee_fs_fek_crypt(ht->uuid, TEE_MODE_DECRYPT, ht->head.enc_fek,
 			       sizeof(ht->fek), ht->fek);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = authenc_init(&ctx, TEE_MODE_DECRYPT, ht, NULL, sizeof(ht->imeta));
+	res = init_ae_key(ht);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = authenc_init(&aad, TEE_MODE_DECRYPT, ht, NULL);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	return authenc_decrypt_final(ctx, ht->head.tag, ht->head.imeta,
+	return authenc_decrypt_final(ht, &aad, ht->head.tag, ht->head.imeta,
 				     sizeof(ht->imeta), &ht->imeta);
 }
 
@@ -576,11 +713,13 @@ static TEE_Result verify_node(struct traverse_arg *targ,
 		res = calc_node_hash(node, NULL, ctx, digest);
 	else
 		res = calc_node_hash(node, &targ->ht->imeta.meta, ctx, digest);
-	if (res == TEE_SUCCESS &&
-	    consttime_memcmp(digest, node->node.hash, sizeof(digest)))
+	if (res != TEE_SUCCESS)
+		return res;
+	if (consttime_memcmp(digest, node->node.hash, sizeof(digest)))
 		return TEE_ERROR_CORRUPT_OBJECT;
 
-	return res;
+	node->verified = true;
+	return TEE_SUCCESS;
 }
 
 static TEE_Result verify_tree(struct tee_fs_htree *ht)
@@ -598,6 +737,66 @@ static TEE_Result verify_tree(struct tee_fs_htree *ht)
 	return res;
 }
 
+static TEE_Result load_children(struct tee_fs_htree *ht,
+				struct htree_node *node)
+{
+	struct htree_node *c0 = node->child[0];
+	struct htree_node *c1 = node->child[1];
+	TEE_Result res = TEE_SUCCESS;
+
+	if (c0 && !c0->loaded && c1 && !c1->loaded)
+		return read_nodes(ht, c0->id, c1->id);
+
+	if (c0 && !c0->loaded) {
+		res = read_node(ht, c0->id);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
+	if (c1 && !c1->loaded)
+		res = read_node(ht, c1->id);
+
+	return res;
+}
+
+/*
+ * Verifies @node and all its ancestors not verified yet. The image of the
+ * node is authenticated by the hash of the parent, which covers the hashes
+ * of the children, so the images of the children are read here.
+ */
+static TEE_Result verify_path(struct tee_fs_htree *ht,
+			      struct htree_node *node)
+{
+	struct traverse_arg targ = { .ht = ht };
+	TEE_Result res = TEE_SUCCESS;
+
+	if (node->verified)
+		return TEE_SUCCESS;
+
+	/*
+	 * This function is recursing but not very deep, only with Log(N)
+	 * maximum depth.
+	 */
+	if (node->parent) {
+		res = verify_path(ht, node->parent);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
+	assert(node->loaded);
+
+	res = load_children(ht, node);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = crypto_hash_alloc_ctx(&targ.arg, TEE_FS_HTREE_HASH_ALG);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = verify_node(&targ, node);
+	crypto_hash_free_ctx(targ.arg, TEE_FS_HTREE_HASH_ALG);
+
+	return res;
+}
+
 static TEE_Result init_root_node(struct tee_fs_htree *ht)
 {
 	TEE_Result res;
@@ -609,6 +808,8 @@ static TEE_Result init_root_node(struct tee_fs_htree *ht)
 
 	ht->root.id = 1;
 	ht->root.dirty = true;
+	ht->root.loaded = true;
+	ht->root.verified = true;
 
 	res = calc_node_hash(&ht->root, &ht->imeta.meta, ctx,
 			     ht->root.node.hash);
@@ -643,6 +844,10 @@ TEE_Result tee_fs_htree_open(bool create, uint8_t *hash, const TEE_UUID *uuid,
 		if (res != TEE_SUCCESS)
 			goto out;
 
+		res = init_ae_key(ht);
+		if (res != TEE_SUCCESS)
+			goto out;
+
 		res = init_root_node(ht);
 		if (res != TEE_SUCCESS)
 			goto out;
@@ -661,6 +866,19 @@ TEE_Result tee_fs_htree_open(bool create, uint8_t *hash, const TEE_UUID *uuid,
 		if (res != TEE_SUCCESS)
 			goto out;
 
+		res = init_tree_nodes(ht);
+		if (res != TEE_SUCCESS)
+			goto out;
+
+		/*
+		 * The root node is always verified since the meta data it
+		 * covers may be updated by the user at any time.
+		 */
+		if (IS_ENABLED(CFG_FS_HTREE_LAZY_VERIFY)) {
+			res = verify_path(ht, &ht->root);
+			goto out;
+		}
+
 		res = init_tree_from_data(ht);
 		if (res != TEE_SUCCESS)
 			goto out;
@@ -686,6 +904,11 @@ void tee_fs_htree_meta_set_dirty(struct tee_fs_htree *ht)
 	ht->root.dirty = true;
 }
 
+bool tee_fs_htree_is_dirty(struct tee_fs_htree *ht)
+{
+	return ht->dirty;
+}
+
 static TEE_Result free_node(struct traverse_arg *targ __unused,
 			    struct htree_node *node)
 {
@@ -699,13 +922,32 @@ void tee_fs_htree_close(struct tee_fs_htree **ht)
 	if (!*ht)
 		return;
 	htree_traverse_post_order(*ht, free_node, NULL);
-	free(*ht);
+	/* Wipes the FEK and the expanded key */
+	free_wipe(*ht);
 	*ht = NULL;
 }
 
+/*
+ * struct htree_sync_arg - state of tee_fs_htree_sync_to_storage()
+ * @ctx:	hash context
+ * @elem:	node writes recorded to be done with a single RPC, NULL if
+ *		each node is written directly
+ * @nodes:	the nodes corresponding to the entries in @elem
+ * @num:	number of recorded writes
+ * @max:	capacity of @elem and @nodes
+ */
+struct htree_sync_arg {
+	void *ctx;
+	struct tee_fs_htree_elem *elem;
+	struct htree_node **nodes;
+	size_t num;
+	size_t max;
+};
+
 static TEE_Result htree_sync_node_to_storage(struct traverse_arg *targ,
 					     struct htree_node *node)
 {
+	struct htree_sync_arg *sarg = targ->arg;
 	TEE_Result res;
 	uint8_t vers;
 	struct tee_fs_htree_meta *meta = NULL;
@@ -719,6 +961,7 @@ static TEE_Result htree_sync_node_to_storage(struct traverse_arg *targ,
 
 	if (!node->dirty)
 		return TEE_SUCCESS;
+	assert(node->verified);
 
 	if (node->parent) {
 		uint32_t f = HTREE_NODE_COMMITTED_CHILD(node->id & 1);
@@ -735,28 +978,75 @@ static TEE_Result htree_sync_node_to_storage(struct traverse_arg *targ,
 		meta = &targ->ht->imeta.meta;
 	}
 
-	res = calc_node_hash(node, meta, targ->arg, node->node.hash);
+	res = calc_node_hash(node, meta, sarg->ctx, node->node.hash);
 	if (res != TEE_SUCCESS)
 		return res;
 
 	node->dirty = false;
 	node->block_updated = false;
 
+	/*
+	 * The node image doesn't change after this point since the
+	 * children are visited before their parent.
+	 */
+	if (sarg->elem && sarg->num < sarg->max) {
+		sarg->elem[sarg->num] = (struct tee_fs_htree_elem){
+			.type = TEE_FS_HTREE_TYPE_NODE,
+			.idx = node->id - 1,
+			.vers = vers,
+		};
+		sarg->nodes[sarg->num] = node;
+		sarg->num++;
+		return TEE_SUCCESS;
+	}
+
 	return rpc_write_node(targ->ht, node->id, vers, &node->node);
 }
 
+static TEE_Result write_recorded_nodes(struct tee_fs_htree *ht,
+				       struct htree_sync_arg *sarg)
+{
+	const size_t node_size = sizeof(struct tee_fs_htree_node_image);
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_fs_rpc_operation op = { };
+	size_t n = 0;
+
+	if (!sarg->num)
+		return TEE_SUCCESS;
+
+	res = ht->stor->rpc_writev_init(ht->stor_aux, &op, sarg->elem,
+					sarg->num);
+	if (res == TEE_SUCCESS) {
+		for (n = 0; n < sarg->num; n++)
+			memcpy(sarg->elem[n].data, &sarg->nodes[n]->node,
+			       node_size);
+		res = ht->stor->rpc_writev_final(&op);
+	}
+	if (res != TEE_ERROR_NOT_SUPPORTED)
+		return res;
+
+	for (n = 0; n < sarg->num; n++) {
+		res = rpc_write_node(ht, sarg->nodes[n]->id, sarg->elem[n].vers,
+				     &sarg->nodes[n]->node);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result update_root(struct tee_fs_htree *ht)
 {
 	TEE_Result res;
-	void *ctx;
+	struct authenc_aad aad;
 
 	ht->head.counter++;
 
-	res = authenc_init(&ctx, TEE_MODE_ENCRYPT, ht, NULL, sizeof(ht->imeta));
+	res = authenc_init(&aad, TEE_MODE_ENCRYPT, ht, NULL);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	return authenc_encrypt_final(ctx, ht->head.tag, &ht->imeta,
+	return authenc_encrypt_final(ht, &aad, ht->head.tag, &ht->imeta,
 				     sizeof(ht->imeta), &ht->head.imeta);
 }
 
@@ -765,7 +1055,7 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 {
 	TEE_Result res;
 	struct tee_fs_htree *ht = *ht_arg;
-	void *ctx;
+	struct htree_sync_arg sarg = { };
 
 	if (!ht)
 		return TEE_ERROR_CORRUPT_OBJECT;
@@ -773,11 +1063,33 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 	if (!ht->dirty)
 		return TEE_SUCCESS;
 
-	res = crypto_hash_alloc_ctx(&ctx, TEE_FS_HTREE_HASH_ALG);
+	res = crypto_hash_alloc_ctx(&sarg.ctx, TEE_FS_HTREE_HASH_ALG);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = htree_traverse_post_order(ht, htree_sync_node_to_storage, ctx);
+	/*
+	 * Record the dirty nodes while traversing the tree and write them
+	 * all with one RPC afterwards. Without memory for that the nodes
+	 * are written one by one.
+	 */
+	if (ht->stor->rpc_writev_init) {
+		/* The root node is there even if max_node_id is 0 */
+		sarg.max = MAX(ht->imeta.max_node_id, 1U);
+		sarg.elem = calloc(sarg.max, sizeof(*sarg.elem));
+		sarg.nodes = calloc(sarg.max, sizeof(*sarg.nodes));
+		if (!sarg.elem || !sarg.nodes) {
+			free(sarg.elem);
+			free(sarg.nodes);
+			sarg.elem = NULL;
+			sarg.nodes = NULL;
+		}
+	}
+
+	res = htree_traverse_post_order(ht, htree_sync_node_to_storage, &sarg);
+	if (res != TEE_SUCCESS)
+		goto out;
+
+	res = write_recorded_nodes(ht, &sarg);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -794,7 +1106,9 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 	if (hash)
 		memcpy(hash, ht->root.node.hash, sizeof(ht->root.node.hash));
 out:
-	crypto_hash_free_ctx(ctx, TEE_FS_HTREE_HASH_ALG);
+	free(sarg.elem);
+	free(sarg.nodes);
+	crypto_hash_free_ctx(sarg.ctx, TEE_FS_HTREE_HASH_ALG);
 	if (res != TEE_SUCCESS)
 		tee_fs_htree_close(ht_arg);
 	return res;
@@ -821,13 +1135,16 @@ TEE_Result tee_fs_htree_write_block(struct tee_fs_htree **ht_arg,
 	struct tee_fs_rpc_operation op;
 	struct htree_node *node = NULL;
 	uint8_t block_vers;
-	void *ctx;
+	struct authenc_aad aad;
 	void *enc_block;
 
 	if (!ht)
 		return TEE_ERROR_CORRUPT_OBJECT;
 
 	res = get_block_node(ht, true, block_num, &node);
+	if (res != TEE_SUCCESS)
+		goto out;
+	res = verify_path(ht, node);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -841,11 +1158,10 @@ TEE_Result tee_fs_htree_write_block(struct tee_fs_htree **ht_arg,
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = authenc_init(&ctx, TEE_MODE_ENCRYPT, ht, &node->node,
-			   ht->stor->block_size);
+	res = authenc_init(&aad, TEE_MODE_ENCRYPT, ht, &node->node);
 	if (res != TEE_SUCCESS)
 		goto out;
-	res = authenc_encrypt_final(ctx, node->node.tag, block,
+	res = authenc_encrypt_final(ht, &aad, node->node.tag, block,
 				    ht->stor->block_size, enc_block);
 	if (res != TEE_SUCCESS)
 		goto out;
@@ -872,13 +1188,16 @@ TEE_Result tee_fs_htree_read_block(struct tee_fs_htree **ht_arg,
 	struct htree_node *node;
 	uint8_t block_vers;
 	size_t len;
-	void *ctx;
+	struct authenc_aad aad;
 	void *enc_block;
 
 	if (!ht)
 		return TEE_ERROR_CORRUPT_OBJECT;
 
 	res = get_block_node(ht, false, block_num, &node);
+	if (res != TEE_SUCCESS)
+		goto out;
+	res = verify_path(ht, node);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -897,12 +1216,11 @@ TEE_Result tee_fs_htree_read_block(struct tee_fs_htree **ht_arg,
 		goto out;
 	}
 
-	res = authenc_init(&ctx, TEE_MODE_DECRYPT, ht, &node->node,
-			   ht->stor->block_size);
+	res = authenc_init(&aad, TEE_MODE_DECRYPT, ht, &node->node);
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = authenc_decrypt_final(ctx, node->node.tag, enc_block,
+	res = authenc_decrypt_final(ht, &aad, node->node.tag, enc_block,
 				    ht->stor->block_size, block);
 out:
 	if (res != TEE_SUCCESS)
@@ -910,11 +1228,91 @@ out:
 	return res;
 }
 
+TEE_Result tee_fs_htree_read_blocks(struct tee_fs_htree **ht_arg,
+				    size_t block_num, size_t num, void **blocks)
+{
+	struct tee_fs_htree *ht = *ht_arg;
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_fs_rpc_operation op = { };
+	struct htree_node **nodes = NULL;
+	void **enc_blocks = NULL;
+	uint8_t *vers = NULL;
+	size_t size = 0;
+	size_t len = 0;
+	size_t n = 0;
+	struct authenc_aad aad;
+
+	if (!ht)
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	if (!ht->stor->rpc_read_blocks_init || num < 2) {
+		for (n = 0; n < num; n++) {
+			res = tee_fs_htree_read_block(ht_arg, block_num + n,
+						      blocks[n]);
+			if (res != TEE_SUCCESS)
+				return res;
+		}
+		return TEE_SUCCESS;
+	}
+
+	nodes = calloc(num, sizeof(*nodes));
+	enc_blocks = calloc(num, sizeof(*enc_blocks));
+	vers = calloc(num, sizeof(*vers));
+	if (!nodes || !enc_blocks || !vers) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+
+	for (n = 0; n < num; n++) {
+		res = get_block_node(ht, false, block_num + n, nodes + n);
+		if (res != TEE_SUCCESS)
+			goto out;
+		res = verify_path(ht, nodes[n]);
+		if (res != TEE_SUCCESS)
+			goto out;
+		vers[n] = !!(nodes[n]->node.flags & HTREE_NODE_COMMITTED_BLOCK);
+	}
+
+	res = ht->stor->rpc_read_blocks_init(ht->stor_aux, &op, block_num,
+					     num, vers, enc_blocks, &size);
+	if (res != TEE_SUCCESS)
+		goto out;
+
+	res = ht->stor->rpc_read_final(&op, &len);
+	if (res != TEE_SUCCESS)
+		goto out;
+	if (len != size) {
+		res = TEE_ERROR_CORRUPT_OBJECT;
+		goto out;
+	}
+
+	for (n = 0; n < num; n++) {
+		res = authenc_init(&aad, TEE_MODE_DECRYPT, ht,
+				   &nodes[n]->node);
+		if (res != TEE_SUCCESS)
+			goto out;
+
+		res = authenc_decrypt_final(ht, &aad, nodes[n]->node.tag,
+					    enc_blocks[n], ht->stor->block_size,
+					    blocks[n]);
+		if (res != TEE_SUCCESS)
+			goto out;
+	}
+out:
+	free(nodes);
+	free(enc_blocks);
+	free(vers);
+	if (res != TEE_SUCCESS)
+		tee_fs_htree_close(ht_arg);
+	return res;
+}
+
 TEE_Result tee_fs_htree_truncate(struct tee_fs_htree **ht_arg, size_t block_num)
 {
 	struct tee_fs_htree *ht = *ht_arg;
 	size_t node_id = BLOCK_NUM_TO_NODE_ID(block_num);
 	struct htree_node *node;
+	TEE_Result res;
 
 	if (!ht)
 		return TEE_ERROR_CORRUPT_OBJECT;
@@ -925,6 +1323,15 @@ TEE_Result tee_fs_htree_truncate(struct tee_fs_htree **ht_arg, size_t block_num)
 		assert(!node->child[0] && !node->child[1]);
 		assert(node->parent);
 		assert(node->parent->child[node->id & 1] == node);
+
+		/* The hash of the parent changes when a child is removed */
+		res = verify_path(ht, node->parent);
+		if (res != TEE_SUCCESS) {
+			tee_fs_htree_close(ht_arg);
+			return res;
+		}
+		node->parent->dirty = true;
+
 		node->parent->child[node->id & 1] = NULL;
 		free(node);
 		ht->imeta.max_node_id--;
@@ -27,6 +27,7 @@ ifeq ($(CFG_WITH_USER_TA),y)
 srcs-y += tee_svc.c
 cppflags-tee_svc.c-y += -DTEE_IMPL_VERSION=$(TEE_IMPL_VERSION)
 srcs-y += tee_svc_cryp.c
+srcs-$(CFG_CORE_KEYGEN_POOL) += tee_cryp_keypool.c
 srcs-y += tee_svc_storage.c
 srcs-$(CFG_RPMB_FS) += tee_rpmb_fs.c
 srcs-$(CFG_REE_FS) += tee_ree_fs.c
@@ -11,6 +11,7 @@
 #include <mm/mobj.h>
 #include <optee_rpc_cmd.h>
 #include <stdio.h>
+#include <stdlib_ext.h>
 #include <string.h>
 #include <tee_api_defines_extensions.h>
 #include <tee/tadb.h>
@@ -70,6 +71,19 @@ static struct tee_tadb_dir *tadb_db;
 static unsigned int tadb_db_refc;
 static struct mutex tadb_mutex = MUTEX_INITIALIZER;
 
+/*
+ * Copy of the entries in the TA database, indexed as in the database.
+ * It's populated on first use and updated each time an entry is
+ * written, so finding a TA doesn't read and decrypt the entries one by
+ * one. The database can only be modified from here so the copy is kept
+ * until a write fails and leaves the database in an unknown state.
+ * Protected by tadb_mutex.
+ */
+static struct tadb_entry *tadb_ents;
+static size_t tadb_num_ents;
+static size_t tadb_max_ents;
+static bool tadb_ents_valid;
+
 static void file_num_to_str(char *buf, size_t blen, uint32_t file_number)
 {
 	snprintf(buf, blen, "%" PRIu32 ".ta", file_number);
@@ -181,12 +195,81 @@ static TEE_Result read_ent(struct tee_tadb_dir *db, size_t idx,
 	return res;
 }
 
+static void ents_cache_drop(void)
+{
+	free_wipe(tadb_ents);
+	tadb_ents = NULL;
+	tadb_num_ents = 0;
+	tadb_max_ents = 0;
+	tadb_ents_valid = false;
+}
+
+static TEE_Result ents_cache_set(size_t idx, const struct tadb_entry *entry)
+{
+	struct tadb_entry *p = NULL;
+	size_t n = 0;
+
+	if (idx >= tadb_max_ents) {
+		n = MAX(idx + 1, tadb_max_ents * 2);
+		p = calloc(n, sizeof(*p));
+		if (!p)
+			return TEE_ERROR_OUT_OF_MEMORY;
+		if (tadb_ents)
+			memcpy(p, tadb_ents, tadb_num_ents * sizeof(*p));
+		free_wipe(tadb_ents);
+		tadb_ents = p;
+		tadb_max_ents = n;
+	}
+
+	tadb_ents[idx] = *entry;
+	tadb_num_ents = MAX(tadb_num_ents, idx + 1);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result populate_ents(struct tee_tadb_dir *db)
+{
+	struct tadb_entry entry = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t idx = 0;
+
+	if (tadb_ents_valid)
+		return TEE_SUCCESS;
+
+	for (idx = 0;; idx++) {
+		res = read_ent(db, idx, &entry);
+		if (res) {
+			if (res == TEE_ERROR_ITEM_NOT_FOUND) {
+				tadb_ents_valid = true;
+				res = TEE_SUCCESS;
+			}
+			break;
+		}
+
+		res = ents_cache_set(idx, &entry);
+		if (res)
+			break;
+	}
+
+	memzero_explicit(&entry, sizeof(entry));
+	if (res)
+		ents_cache_drop();
+
+	return res;
+}
+
 static TEE_Result write_ent(struct tee_tadb_dir *db, size_t idx,
 			    const struct tadb_entry *entry)
 {
 	const size_t l = sizeof(*entry);
+	TEE_Result res = db->ops->write(db->fh, idx * l, entry, l);
+
+	if (!res && tadb_ents_valid)
+		res = ents_cache_set(idx, entry);
+	if (res)
+		ents_cache_drop();
 
-	return db->ops->write(db->fh, idx * l, entry, l);
+	return res;
 }
 
 static TEE_Result tadb_open(struct tee_tadb_dir **db_ret)
@@ -303,6 +386,10 @@ static TEE_Result populate_files(struct tee_tadb_dir *db)
 	if (db->files)
 		return TEE_SUCCESS;
 
+	res = populate_ents(db);
+	if (res)
+		return res;
+
 	/*
 	 * Iterate over the TA database and set the bits in the bit field
 	 * for used file numbers. Note that set_file() will allocate and
@@ -314,34 +401,29 @@ static TEE_Result populate_files(struct tee_tadb_dir *db)
 	 * to clean it out here instead of letting the error spread with
 	 * unexpected side effects.
 	 */
-	for (idx = 0;; idx++) {
-		struct tadb_entry entry;
-
-		res = read_ent(db, idx, &entry);
-		if (res) {
-			if (res == TEE_ERROR_ITEM_NOT_FOUND)
-				return TEE_SUCCESS;
-			goto err;
-		}
+	for (idx = 0; idx < tadb_num_ents; idx++) {
+		const struct tadb_entry *entry = tadb_ents + idx;
+		const struct tadb_entry null_entry = { };
 
-		if (is_null_uuid(&entry.prop.uuid))
+		if (is_null_uuid(&entry->prop.uuid))
 			continue;
 
-		if (test_file(db, entry.file_number)) {
+		if (test_file(db, entry->file_number)) {
 			IMSG("Clearing duplicate file number %" PRIu32,
-			     entry.file_number);
-			memset(&entry, 0, sizeof(entry));
-			res = write_ent(db, idx, &entry);
+			     entry->file_number);
+			res = write_ent(db, idx, &null_entry);
 			if (res)
 				goto err;
 			continue;
 		}
 
-		res = set_file(db, entry.file_number);
+		res = set_file(db, entry->file_number);
 		if (res)
 			goto err;
 	}
 
+	return TEE_SUCCESS;
+
 err:
 	free(db->files);
 	db->files = NULL;
@@ -479,6 +561,10 @@ static TEE_Result find_ent(struct tee_tadb_dir *db, const TEE_UUID *uuid,
 	TEE_Result res;
 	size_t idx;
 
+	res = populate_ents(db);
+	if (res)
+		return res;
+
 	/*
 	 * Search for the provided uuid, if it's found return the index it
 	 * has together with TEE_SUCCESS.
@@ -486,25 +572,17 @@ static TEE_Result find_ent(struct tee_tadb_dir *db, const TEE_UUID *uuid,
 	 * If the uuid can't be found return the number indexes together
 	 * with TEE_ERROR_ITEM_NOT_FOUND.
 	 */
-	for (idx = 0;; idx++) {
-		struct tadb_entry entry;
-
-		res = read_ent(db, idx, &entry);
-		if (res) {
-			if (res == TEE_ERROR_ITEM_NOT_FOUND)
-				break;
-			return res;
-		}
-
-		if (!memcmp(&entry.prop.uuid, uuid, sizeof(*uuid))) {
+	for (idx = 0; idx < tadb_num_ents; idx++) {
+		if (!memcmp(&tadb_ents[idx].prop.uuid, uuid, sizeof(*uuid))) {
 			if (entry_ret)
-				*entry_ret = entry;
-			break;
+				*entry_ret = tadb_ents[idx];
+			*idx_ret = idx;
+			return TEE_SUCCESS;
 		}
 	}
 
 	*idx_ret = idx;
-	return res;
+	return TEE_ERROR_ITEM_NOT_FOUND;
 }
 
 static TEE_Result find_free_ent_idx(struct tee_tadb_dir *db, size_t *idx)
@@ -617,7 +695,6 @@ TEE_Result tee_tadb_ta_open(const TEE_UUID *uuid,
 	TEE_Result res;
 	size_t idx;
 	struct tee_tadb_ta_read *ta;
-	static struct tadb_entry last_entry;
 
 	if (is_null_uuid(uuid))
 		return TEE_ERROR_GENERIC;
@@ -626,19 +703,16 @@ TEE_Result tee_tadb_ta_open(const TEE_UUID *uuid,
 	if (!ta)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
-	if (!memcmp(uuid, &last_entry.prop.uuid, sizeof(*uuid))) {
-		ta->entry = last_entry;
-	} else {
-		res = tee_tadb_open(&ta->db);
-		if (res)
-			goto err_free; /* Mustn't all tadb_put() */
+	res = tee_tadb_open(&ta->db);
+	if (res)
+		goto err_free; /* Mustn't all tadb_put() */
 
-		mutex_read_lock(&tadb_mutex);
-		res = find_ent(ta->db, uuid, &idx, &ta->entry);
-		mutex_read_unlock(&tadb_mutex);
-		if (res)
-			goto err;
-	}
+	/* Exclusive since the first lookup populates the entry cache */
+	mutex_lock(&tadb_mutex);
+	res = find_ent(ta->db, uuid, &idx, &ta->entry);
+	mutex_unlock(&tadb_mutex);
+	if (res)
+		goto err;
 
 	res = ta_operation_open(OPTEE_RPC_FS_OPEN, ta->entry.file_number,
 				&ta->fd);
@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <crypto/crypto.h>
+#include <kernel/mutex.h>
+#include <kernel/work_queue.h>
+#include <tee/tee_cryp_keypool.h>
+#include <trace.h>
+#include <util.h>
+
+enum keypool_type {
+	KEYPOOL_UNUSED,
+	KEYPOOL_ECC,
+	KEYPOOL_DH,
+};
+
+/* DH key pairs only have x and y, the group is kept in the pool */
+union keypool_key {
+	struct ecc_keypair ecc;
+	struct dh_keypair dh;
+};
+
+struct keypool {
+	enum keypool_type type;
+	size_t key_size;
+	union {
+		uint32_t curve;
+		struct {
+			struct bignum *g;
+			struct bignum *p;
+			struct bignum *q;
+			size_t xbits;
+		} dh;
+	} group;
+	union keypool_key key[CFG_CORE_KEYGEN_POOL_DEPTH];
+	size_t num_keys;
+	unsigned int last_use;
+	/*
+	 * Set while the refill work is queued or running. The type and
+	 * group of the pool can't change then, the refill uses them
+	 * without holding keypool_mu.
+	 */
+	bool busy;
+	struct work work;
+};
+
+static struct keypool keypools[CFG_CORE_KEYGEN_POOL_GROUPS];
+static struct mutex keypool_mu = MUTEX_INITIALIZER;
+static unsigned int keypool_tick;
+
+static void free_priv(struct bignum *bn)
+{
+	if (bn)
+		crypto_bignum_clear(bn);
+	crypto_bignum_free(bn);
+}
+
+static void free_key(enum keypool_type type, union keypool_key *key)
+{
+	if (type == KEYPOOL_ECC) {
+		free_priv(key->ecc.d);
+		crypto_bignum_free(key->ecc.x);
+		crypto_bignum_free(key->ecc.y);
+	} else {
+		free_priv(key->dh.x);
+		crypto_bignum_free(key->dh.y);
+	}
+	*key = (union keypool_key){ };
+}
+
+static TEE_Result gen_ecc_key(struct keypool *kp, struct ecc_keypair *key)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	res = crypto_acipher_alloc_ecc_keypair(key, kp->key_size);
+	if (res) {
+		/* The bignums are already freed */
+		*key = (struct ecc_keypair){ };
+		return res;
+	}
+
+	key->curve = kp->group.curve;
+	return crypto_acipher_gen_ecc_key(key);
+}
+
+static TEE_Result gen_dh_key(struct keypool *kp, struct dh_keypair *key)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	*key = (struct dh_keypair){
+		.g = kp->group.dh.g,
+		.p = kp->group.dh.p,
+		.x = crypto_bignum_allocate(kp->key_size),
+		.y = crypto_bignum_allocate(kp->key_size),
+	};
+	if (!key->x || !key->y)
+		res = TEE_ERROR_OUT_OF_MEMORY;
+	else
+		res = crypto_acipher_gen_dh_key(key, kp->group.dh.q,
+						kp->group.dh.xbits);
+
+	key->g = NULL;
+	key->p = NULL;
+	return res;
+}
+
+static void keypool_refill(struct work *work)
+{
+	struct keypool *kp = container_of(work, struct keypool, work);
+	union keypool_key key = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	mutex_lock(&keypool_mu);
+	while (kp->num_keys < CFG_CORE_KEYGEN_POOL_DEPTH) {
+		mutex_unlock(&keypool_mu);
+
+		if (kp->type == KEYPOOL_ECC)
+			res = gen_ecc_key(kp, &key.ecc);
+		else
+			res = gen_dh_key(kp, &key.dh);
+
+		mutex_lock(&keypool_mu);
+		if (res) {
+			DMSG("Key generation failed: %#"PRIx32, res);
+			free_key(kp->type, &key);
+			break;
+		}
+		kp->key[kp->num_keys] = key;
+		kp->num_keys++;
+	}
+	kp->busy = false;
+	mutex_unlock(&keypool_mu);
+}
+
+static void release_pool(struct keypool *kp)
+{
+	size_t n = 0;
+
+	for (n = 0; n < kp->num_keys; n++)
+		free_key(kp->type, kp->key + n);
+
+	if (kp->type == KEYPOOL_DH) {
+		crypto_bignum_free(kp->group.dh.g);
+		crypto_bignum_free(kp->group.dh.p);
+		crypto_bignum_free(kp->group.dh.q);
+	}
+
+	*kp = (struct keypool){ };
+}
+
+/*
+ * Returns an unused pool, or else the least recently used pool which
+ * isn't being refilled, or NULL.
+ */
+static struct keypool *alloc_pool(enum keypool_type type, size_t key_size)
+{
+	struct keypool *lru = NULL;
+	struct keypool *kp = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(keypools); n++) {
+		kp = keypools + n;
+		if (kp->type == KEYPOOL_UNUSED) {
+			lru = kp;
+			break;
+		}
+		if (!kp->busy && (!lru || kp->last_use < lru->last_use))
+			lru = kp;
+	}
+	if (!lru)
+		return NULL;
+
+	release_pool(lru);
+	lru->type = type;
+	lru->key_size = key_size;
+	work_init(&lru->work, keypool_refill);
+	return lru;
+}
+
+/* Takes a key from @kp if there's one and queues a refill */
+static bool take_key(struct keypool *kp, union keypool_key *key)
+{
+	bool ret = false;
+
+	if (kp->num_keys) {
+		kp->num_keys--;
+		*key = kp->key[kp->num_keys];
+		kp->key[kp->num_keys] = (union keypool_key){ };
+		ret = true;
+	}
+
+	kp->last_use = ++keypool_tick;
+	if (!kp->busy) {
+		kp->busy = true;
+		work_queue(&kp->work);
+	}
+
+	return ret;
+}
+
+bool tee_cryp_keypool_get_ecc(struct ecc_keypair *key, size_t key_size)
+{
+	union keypool_key k = { };
+	struct keypool *kp = NULL;
+	bool ret = false;
+	size_t n = 0;
+
+	mutex_lock(&keypool_mu);
+
+	for (n = 0; n < ARRAY_SIZE(keypools); n++) {
+		if (keypools[n].type == KEYPOOL_ECC &&
+		    keypools[n].group.curve == key->curve &&
+		    keypools[n].key_size == key_size) {
+			kp = keypools + n;
+			break;
+		}
+	}
+	if (!kp) {
+		kp = alloc_pool(KEYPOOL_ECC, key_size);
+		if (kp)
+			kp->group.curve = key->curve;
+	}
+	if (kp)
+		ret = take_key(kp, &k);
+
+	mutex_unlock(&keypool_mu);
+
+	if (ret) {
+		crypto_bignum_copy(key->d, k.ecc.d);
+		crypto_bignum_copy(key->x, k.ecc.x);
+		crypto_bignum_copy(key->y, k.ecc.y);
+		free_key(KEYPOOL_ECC, &k);
+	}
+
+	return ret;
+}
+
+static bool dh_group_match(struct keypool *kp, struct dh_keypair *key,
+			   struct bignum *q, size_t xbits, size_t key_size)
+{
+	if (kp->type != KEYPOOL_DH || kp->key_size != key_size ||
+	    kp->group.dh.xbits != xbits || !q != !kp->group.dh.q)
+		return false;
+
+	return !crypto_bignum_compare(kp->group.dh.p, key->p) &&
+	       !crypto_bignum_compare(kp->group.dh.g, key->g) &&
+	       (!q || !crypto_bignum_compare(kp->group.dh.q, q));
+}
+
+static bool set_dh_group(struct keypool *kp, struct dh_keypair *key,
+			 struct bignum *q, size_t xbits)
+{
+	kp->group.dh.g = crypto_bignum_allocate(kp->key_size);
+	kp->group.dh.p = crypto_bignum_allocate(kp->key_size);
+	if (q)
+		kp->group.dh.q = crypto_bignum_allocate(kp->key_size);
+	if (!kp->group.dh.g || !kp->group.dh.p || (q && !kp->group.dh.q))
+		return false;
+
+	crypto_bignum_copy(kp->group.dh.g, key->g);
+	crypto_bignum_copy(kp->group.dh.p, key->p);
+	if (q)
+		crypto_bignum_copy(kp->group.dh.q, q);
+	kp->group.dh.xbits = xbits;
+	return true;
+}
+
+bool tee_cryp_keypool_get_dh(struct dh_keypair *key, struct bignum *q,
+			     size_t xbits, size_t key_size)
+{
+	union keypool_key k = { };
+	struct keypool *kp = NULL;
+	bool ret = false;
+	size_t n = 0;
+
+	mutex_lock(&keypool_mu);
+
+	for (n = 0; n < ARRAY_SIZE(keypools); n++) {
+		if (dh_group_match(keypools + n, key, q, xbits, key_size)) {
+			kp = keypools + n;
+			break;
+		}
+	}
+	if (!kp) {
+		kp = alloc_pool(KEYPOOL_DH, key_size);
+		if (kp && !set_dh_group(kp, key, q, xbits)) {
+			release_pool(kp);
+			kp = NULL;
+		}
+	}
+	if (kp)
+		ret = take_key(kp, &k);
+
+	mutex_unlock(&keypool_mu);
+
+	if (ret) {
+		crypto_bignum_copy(key->x, k.dh.x);
+		crypto_bignum_copy(key->y, k.dh.y);
+		free_key(KEYPOOL_DH, &k);
+	}
+
+	return ret;
+}
@@ -176,104 +176,139 @@ static TEE_Result sha256(uint8_t *out, size_t out_size, const uint8_t *in,
 				     out, out_size);
 }
 
-static TEE_Result aes_ecb(uint8_t out[TEE_AES_BLOCK_SIZE],
-			  const uint8_t in[TEE_AES_BLOCK_SIZE],
-			  const uint8_t *key, size_t key_size)
+void tee_fs_fek_cache_wipe(struct tee_fs_fek_cache *c)
+{
+	crypto_cipher_free_ctx(c->essiv_ctx, TEE_ALG_AES_ECB_NOPAD);
+	crypto_cipher_free_ctx(c->cbc_ctx, TEE_ALG_AES_CBC_NOPAD);
+	memzero_explicit(c, sizeof(*c));
+}
+
+static bool fek_cache_match(struct tee_fs_fek_cache *c,
+			    const TEE_UUID *uuid,
+			    const uint8_t *encrypted_fek)
+{
+	if (!c->valid || c->has_uuid != !!uuid)
+		return false;
+	if (uuid && memcmp(uuid, &c->uuid, sizeof(*uuid)))
+		return false;
+	return !memcmp(encrypted_fek, c->encrypted_fek, TEE_FS_KM_FEK_SIZE);
+}
+
+static TEE_Result fek_cache_fill(struct tee_fs_fek_cache *c,
+				 const TEE_UUID *uuid,
+				 const uint8_t *encrypted_fek)
 {
 	TEE_Result res;
-	void *ctx = NULL;
-	const uint32_t algo = TEE_ALG_AES_ECB_NOPAD;
+	uint8_t sha[TEE_SHA256_HASH_SIZE];
+
+	if (fek_cache_match(c, uuid, encrypted_fek))
+		return TEE_SUCCESS;
 
-	res = crypto_cipher_alloc_ctx(&ctx, algo);
+	c->valid = false;
+
+	if (!c->essiv_ctx) {
+		res = crypto_cipher_alloc_ctx(&c->essiv_ctx,
+					      TEE_ALG_AES_ECB_NOPAD);
+		if (res != TEE_SUCCESS)
+			goto err;
+	}
+	if (!c->cbc_ctx) {
+		res = crypto_cipher_alloc_ctx(&c->cbc_ctx,
+					      TEE_ALG_AES_CBC_NOPAD);
+		if (res != TEE_SUCCESS)
+			goto err;
+	}
+
+	/* Decrypt FEK */
+	res = tee_fs_fek_crypt(uuid, TEE_MODE_DECRYPT, encrypted_fek,
+			       TEE_FS_KM_FEK_SIZE, c->fek);
 	if (res != TEE_SUCCESS)
-		return res;
+		goto err;
 
-	res = crypto_cipher_init(ctx, algo, TEE_MODE_ENCRYPT, key,
-				 key_size, NULL, 0, NULL, 0);
+	/* The ESSIV key is the first half of SHA-256(FEK) */
+	res = sha256(sha, sizeof(sha), c->fek, TEE_FS_KM_FEK_SIZE);
 	if (res != TEE_SUCCESS)
-		goto out;
+		goto err;
 
-	res = crypto_cipher_update(ctx, algo, TEE_MODE_ENCRYPT, true, in,
-				   TEE_AES_BLOCK_SIZE, out);
+	res = crypto_cipher_init(c->essiv_ctx, TEE_ALG_AES_ECB_NOPAD,
+				 TEE_MODE_ENCRYPT, sha, 16, NULL, 0, NULL, 0);
+	memzero_explicit(sha, sizeof(sha));
 	if (res != TEE_SUCCESS)
-		goto out;
+		goto err;
 
-	crypto_cipher_final(ctx, algo);
-	res = TEE_SUCCESS;
+	c->has_uuid = !!uuid;
+	if (uuid)
+		c->uuid = *uuid;
+	memcpy(c->encrypted_fek, encrypted_fek, TEE_FS_KM_FEK_SIZE);
+	c->valid = true;
 
-out:
-	crypto_cipher_free_ctx(ctx, algo);
+	return TEE_SUCCESS;
+err:
+	memzero_explicit(sha, sizeof(sha));
+	tee_fs_fek_cache_wipe(c);
 	return res;
 }
 
-static TEE_Result essiv(uint8_t iv[TEE_AES_BLOCK_SIZE],
-			const uint8_t fek[TEE_FS_KM_FEK_SIZE],
-			uint16_t blk_idx)
+static TEE_Result essiv(struct tee_fs_fek_cache *c,
+			uint8_t iv[TEE_AES_BLOCK_SIZE], uint16_t blk_idx)
 {
-	TEE_Result res;
-	uint8_t sha[TEE_SHA256_HASH_SIZE];
 	uint8_t pad_blkid[TEE_AES_BLOCK_SIZE] = { 0, };
 
-	res = sha256(sha, sizeof(sha), fek, TEE_FS_KM_FEK_SIZE);
-	if (res != TEE_SUCCESS)
-		return res;
-
 	pad_blkid[0] = (blk_idx & 0xFF);
 	pad_blkid[1] = (blk_idx & 0xFF00) >> 8;
 
-	res = aes_ecb(iv, pad_blkid, sha, 16);
-
-	memzero_explicit(sha, sizeof(sha));
-	return res;
+	/* ECB has no chaining, the context is reused for each block */
+	return crypto_cipher_update(c->essiv_ctx, TEE_ALG_AES_ECB_NOPAD,
+				    TEE_MODE_ENCRYPT, false, pad_blkid,
+				    TEE_AES_BLOCK_SIZE, iv);
 }
 
 /*
  * Encryption/decryption of RPMB FS file data. This is AES CBC with ESSIV.
  */
-TEE_Result tee_fs_crypt_block(const TEE_UUID *uuid, uint8_t *out,
+TEE_Result tee_fs_crypt_block(struct tee_fs_fek_cache *cache,
+			      const TEE_UUID *uuid, uint8_t *out,
 			      const uint8_t *in, size_t size,
 			      uint16_t blk_idx, const uint8_t *encrypted_fek,
 			      TEE_OperationMode mode)
 {
 	TEE_Result res;
-	uint8_t fek[TEE_FS_KM_FEK_SIZE];
 	uint8_t iv[TEE_AES_BLOCK_SIZE];
-	void *ctx;
+	struct tee_fs_fek_cache tmp_cache = { };
+	struct tee_fs_fek_cache *c = cache;
 	const uint32_t algo = TEE_ALG_AES_CBC_NOPAD;
 
 	DMSG("%scrypt block #%u", (mode == TEE_MODE_ENCRYPT) ? "En" : "De",
 	     blk_idx);
 
-	/* Decrypt FEK */
-	res = tee_fs_fek_crypt(uuid, TEE_MODE_DECRYPT, encrypted_fek,
-			       TEE_FS_KM_FEK_SIZE, fek);
+	if (!c)
+		c = &tmp_cache;
+
+	res = fek_cache_fill(c, uuid, encrypted_fek);
 	if (res != TEE_SUCCESS)
-		goto wipe;
+		goto out;
 
 	/* Compute initialization vector for this block */
-	res = essiv(iv, fek, blk_idx);
+	res = essiv(c, iv, blk_idx);
 	if (res != TEE_SUCCESS)
-		goto wipe;
+		goto out;
 
 	/* Run AES CBC */
-	res = crypto_cipher_alloc_ctx(&ctx, algo);
+	res = crypto_cipher_init(c->cbc_ctx, algo, mode, c->fek,
+				 sizeof(c->fek), NULL, 0, iv,
+				 TEE_AES_BLOCK_SIZE);
 	if (res != TEE_SUCCESS)
-		goto wipe;
-
-	res = crypto_cipher_init(ctx, algo, mode, fek, sizeof(fek), NULL,
-				 0, iv, TEE_AES_BLOCK_SIZE);
-	if (res != TEE_SUCCESS)
-		goto exit;
-	res = crypto_cipher_update(ctx, algo, mode, true, in, size, out);
+		goto out;
+	res = crypto_cipher_update(c->cbc_ctx, algo, mode, true, in, size,
+				   out);
 	if (res != TEE_SUCCESS)
-		goto exit;
+		goto out;
 
-	crypto_cipher_final(ctx, algo);
+	crypto_cipher_final(c->cbc_ctx, algo);
 
-exit:
-	crypto_cipher_free_ctx(ctx, algo);
-wipe:
-	memzero_explicit(fek, sizeof(fek));
+out:
+	if (res != TEE_SUCCESS || !cache)
+		tee_fs_fek_cache_wipe(c);
 	memzero_explicit(iv, sizeof(iv));
 	return res;
 }
@@ -5,7 +5,9 @@
 
 #include <assert.h>
 #include <kernel/tee_misc.h>
+#include <kernel/telemetry.h>
 #include <kernel/thread.h>
+#include <kernel/tracepoint.h>
 #include <mm/core_memprot.h>
 #include <optee_rpc_cmd.h>
 #include <stdlib.h>
@@ -25,7 +27,16 @@ struct tee_fs_dir {
 
 static TEE_Result operation_commit(struct tee_fs_rpc_operation *op)
 {
-	return thread_rpc_cmd(op->id, op->num_params, op->params);
+	TEE_Result res = TEE_SUCCESS;
+
+	TRACEPOINT(PTA_TRACE_CAT_STORAGE, "fs_request",
+		   op->params[0].u.value.a, op->id);
+	telemetry_count(TELEMETRY_STORAGE);
+	res = thread_rpc_cmd(op->id, op->num_params, op->params);
+	TRACEPOINT(PTA_TRACE_CAT_STORAGE, "fs_done",
+		   op->params[0].u.value.a, res);
+
+	return res;
 }
 
 static TEE_Result operation_open(uint32_t id, unsigned int cmd,
@@ -193,6 +204,138 @@ TEE_Result tee_fs_rpc_write_final(struct tee_fs_rpc_operation *op)
 	return operation_commit(op);
 }
 
+/* Layout of an extent in the array passed in memref[1] */
+struct fs_rpc_extent {
+	uint64_t offset;
+	uint64_t length;
+};
+
+/*
+ * Tells if normal world implements OPTEE_RPC_FS_READV and
+ * OPTEE_RPC_FS_WRITEV, queried once with OPTEE_RPC_FS_GET_CAPS.
+ */
+static enum {
+	VEC_OPS_UNKNOWN,
+	VEC_OPS_SUPPORTED,
+	VEC_OPS_NOT_SUPPORTED,
+} vec_ops_support;
+
+static bool vec_ops_supported(uint32_t id)
+{
+	struct tee_fs_rpc_operation op = {
+		.id = id, .num_params = 2, .params = {
+			[0] = THREAD_PARAM_VALUE(IN, OPTEE_RPC_FS_GET_CAPS, 0,
+						 0),
+			[1] = THREAD_PARAM_VALUE(OUT, 0, 0, 0),
+	} };
+	TEE_Result res = TEE_SUCCESS;
+
+	if (vec_ops_support != VEC_OPS_UNKNOWN)
+		return vec_ops_support == VEC_OPS_SUPPORTED;
+
+	res = operation_commit(&op);
+	if (res == TEE_SUCCESS) {
+		if (op.params[1].u.value.a & OPTEE_RPC_FS_CAP_VEC_OPS)
+			vec_ops_support = VEC_OPS_SUPPORTED;
+		else
+			vec_ops_support = VEC_OPS_NOT_SUPPORTED;
+	} else if (res == TEE_ERROR_BAD_PARAMETERS ||
+		   res == TEE_ERROR_NOT_SUPPORTED ||
+		   res == TEE_ERROR_NOT_IMPLEMENTED) {
+		/* Normal world predating OPTEE_RPC_FS_GET_CAPS */
+		vec_ops_support = VEC_OPS_NOT_SUPPORTED;
+	}
+
+	/* Other errors are transient, the query is done again next time */
+	return vec_ops_support == VEC_OPS_SUPPORTED;
+}
+
+static TEE_Result operation_vec_init(struct tee_fs_rpc_operation *op,
+				     uint32_t id, unsigned int cmd, int fd,
+				     struct tee_fs_rpc_iov *iov, size_t num)
+{
+	struct fs_rpc_extent *ext = NULL;
+	struct mobj *mobj = NULL;
+	size_t ext_size = 0;
+	size_t data_size = 0;
+	size_t total = 0;
+	uint8_t *va = NULL;
+	size_t n = 0;
+
+	if (!vec_ops_supported(id))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	if (!num || MUL_OVERFLOW(num, sizeof(*ext), &ext_size))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	for (n = 0; n < num; n++) {
+		if (iov[n].offset < 0 ||
+		    ADD_OVERFLOW(data_size, iov[n].len, &data_size))
+			return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (ADD_OVERFLOW(ext_size, data_size, &total))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Extents and data share one buffer, see tee_fs_rpc_cache_alloc() */
+	va = tee_fs_rpc_cache_alloc(total, &mobj);
+	if (!va)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	ext = (struct fs_rpc_extent *)(void *)va;
+	va += ext_size;
+	for (n = 0; n < num; n++) {
+		ext[n].offset = iov[n].offset;
+		ext[n].length = iov[n].len;
+		iov[n].data = va;
+		va += iov[n].len;
+	}
+
+	*op = (struct tee_fs_rpc_operation){
+		.id = id, .num_params = 3, .params = {
+			[0] = THREAD_PARAM_VALUE(IN, cmd, fd, num),
+			[1] = THREAD_PARAM_MEMREF(IN, mobj, 0, ext_size),
+			[2] = THREAD_PARAM_MEMREF(IN, mobj, ext_size,
+						  data_size),
+		},
+	};
+
+	/* The data is returned in memref[2] when reading */
+	if (cmd == OPTEE_RPC_FS_READV)
+		op->params[2].attr = THREAD_PARAM_ATTR_MEMREF_OUT;
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result tee_fs_rpc_readv_init(struct tee_fs_rpc_operation *op,
+				 uint32_t id, int fd,
+				 struct tee_fs_rpc_iov *iov, size_t num)
+{
+	return operation_vec_init(op, id, OPTEE_RPC_FS_READV, fd, iov, num);
+}
+
+TEE_Result tee_fs_rpc_readv_final(struct tee_fs_rpc_operation *op,
+				  size_t *data_len)
+{
+	TEE_Result res = operation_commit(op);
+
+	if (res == TEE_SUCCESS)
+		*data_len = op->params[2].u.memref.size;
+	return res;
+}
+
+TEE_Result tee_fs_rpc_writev_init(struct tee_fs_rpc_operation *op,
+				  uint32_t id, int fd,
+				  struct tee_fs_rpc_iov *iov, size_t num)
+{
+	return operation_vec_init(op, id, OPTEE_RPC_FS_WRITEV, fd, iov, num);
+}
+
+TEE_Result tee_fs_rpc_writev_final(struct tee_fs_rpc_operation *op)
+{
+	return operation_commit(op);
+}
+
 TEE_Result tee_fs_rpc_truncate(uint32_t id, int fd, size_t len)
 {
 	struct tee_fs_rpc_operation op = {
@@ -3,62 +3,131 @@
  * Copyright (c) 2016, Linaro Limited
  */
 
+#include <assert.h>
+#include <atomic.h>
 #include <kernel/thread.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
 #include <mm/mobj.h>
 #include <tee/tee_fs_rpc.h>
+#include <util.h>
+
+static struct tee_fs_rpc_cache_stats cache_stats;
+
+static void free_payload(struct thread_rpc_fs_payload *pl)
+{
+	if (pl->va) {
+		thread_rpc_free_payload(pl->mobj);
+		*pl = (struct thread_rpc_fs_payload){ };
+	}
+}
 
 void tee_fs_rpc_cache_clear(struct thread_specific_data *tsd)
 {
-	if (tsd->rpc_fs_payload) {
-		thread_rpc_free_payload(tsd->rpc_fs_payload_mobj);
-		tsd->rpc_fs_payload = NULL;
-		tsd->rpc_fs_payload_size = 0;
-		tsd->rpc_fs_payload_mobj = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(tsd->rpc_fs_payload); n++)
+		free_payload(tsd->rpc_fs_payload + n);
+	tsd->rpc_fs_payload_tick = 0;
+}
+
+void tee_fs_rpc_cache_get_stats(struct tee_fs_rpc_cache_stats *stats)
+{
+	stats->hits = atomic_load_u32(&cache_stats.hits);
+	stats->misses = atomic_load_u32(&cache_stats.misses);
+	stats->evictions = atomic_load_u32(&cache_stats.evictions);
+}
+
+/*
+ * Returns the smallest cached buffer of at least @sz bytes, or if there's
+ * none an unused entry, or the least recently used entry.
+ */
+static struct thread_rpc_fs_payload *find_payload(
+					struct thread_specific_data *tsd,
+					size_t sz, bool *hit)
+{
+	struct thread_rpc_fs_payload *best = NULL;
+	struct thread_rpc_fs_payload *lru = NULL;
+	struct thread_rpc_fs_payload *pl = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(tsd->rpc_fs_payload); n++) {
+		pl = tsd->rpc_fs_payload + n;
+		if (!pl->va) {
+			if (!lru || lru->va)
+				lru = pl;
+			continue;
+		}
+		if (pl->size >= sz && (!best || pl->size < best->size))
+			best = pl;
+		if (!lru || (lru->va && pl->last_use < lru->last_use))
+			lru = pl;
 	}
+
+	*hit = best;
+	if (best)
+		return best;
+	return lru;
 }
 
 void *tee_fs_rpc_cache_alloc(size_t size, struct mobj **mobj)
 {
 	struct thread_specific_data *tsd = thread_get_tsd();
+	struct thread_rpc_fs_payload *pl = NULL;
+	bool hit = false;
 	size_t sz = size;
 	paddr_t p;
 	void *va;
 
+	COMPILE_TIME_ASSERT(CFG_TEE_FS_RPC_CACHE_ENTRIES >= 2);
+
 	if (!size)
 		return NULL;
 
 	/*
 	 * Always allocate in page chunks as normal world allocates payload
-	 * memory as complete pages.
+	 * memory as complete pages. Sizes are also rounded up to a power
+	 * of two number of pages to have a few size classes only.
 	 */
 	sz = ROUNDUP(size, SMALL_PAGE_SIZE);
+	while (!IS_POWER_OF_TWO(sz))
+		sz += sz & (~sz + 1);
 
-	if (sz > tsd->rpc_fs_payload_size) {
-		tee_fs_rpc_cache_clear(tsd);
+	pl = find_payload(tsd, sz, &hit);
+	tsd->rpc_fs_payload_tick++;
+	if (hit) {
+		atomic_inc32(&cache_stats.hits);
+		pl->last_use = tsd->rpc_fs_payload_tick;
+		*mobj = pl->mobj;
+		return pl->va;
+	}
 
-		*mobj = thread_rpc_alloc_payload(sz);
-		if (!*mobj)
-			return NULL;
+	atomic_inc32(&cache_stats.misses);
+	if (pl->va) {
+		atomic_inc32(&cache_stats.evictions);
+		free_payload(pl);
+	}
+
+	*mobj = thread_rpc_alloc_payload(sz);
+	if (!*mobj)
+		return NULL;
 
-		if (mobj_get_pa(*mobj, 0, 0, &p))
-			goto err;
+	if (mobj_get_pa(*mobj, 0, 0, &p))
+		goto err;
 
-		if (!ALIGNMENT_IS_OK(p, uint64_t))
-			goto err;
+	if (!ALIGNMENT_IS_OK(p, uint64_t))
+		goto err;
 
-		va = mobj_get_va(*mobj, 0);
-		if (!va)
-			goto err;
+	va = mobj_get_va(*mobj, 0);
+	if (!va)
+		goto err;
 
-		tsd->rpc_fs_payload = va;
-		tsd->rpc_fs_payload_mobj = *mobj;
-		tsd->rpc_fs_payload_size = sz;
-	} else
-		*mobj = tsd->rpc_fs_payload_mobj;
+	pl->va = va;
+	pl->mobj = *mobj;
+	pl->size = sz;
+	pl->last_use = tsd->rpc_fs_payload_tick;
 
-	return tsd->rpc_fs_payload;
+	return va;
 err:
 	thread_rpc_free_payload(*mobj);
 	return NULL;
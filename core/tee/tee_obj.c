@@ -5,6 +5,8 @@
 
 #include <tee/tee_obj.h>
 
+#include <kernel/handle.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <tee_api_defines.h>
 #include <mm/tee_mmu.h>
@@ -14,30 +16,41 @@
 #include <tee/tee_svc_storage.h>
 #include <tee/tee_svc_cryp.h>
 
-void tee_obj_add(struct user_ta_ctx *utc, struct tee_obj *o)
+TEE_Result tee_obj_add(struct user_ta_ctx *utc, struct tee_obj *o)
 {
+	int handle = handle_get(&utc->object_db, o);
+
+	if (handle < 0)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	o->id = handle + 1;
 	TAILQ_INSERT_TAIL(&utc->objects, o, link);
+	return TEE_SUCCESS;
 }
 
 TEE_Result tee_obj_get(struct user_ta_ctx *utc, uint32_t obj_id,
 		       struct tee_obj **obj)
 {
-	struct tee_obj *o;
+	struct tee_obj *o = NULL;
 
-	TAILQ_FOREACH(o, &utc->objects, link) {
-		if (obj_id == (vaddr_t)o) {
-			*obj = o;
-			return TEE_SUCCESS;
-		}
-	}
-	return TEE_ERROR_BAD_PARAMETERS;
+	if (!obj_id || obj_id > INT_MAX)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	o = handle_lookup(&utc->object_db, obj_id - 1);
+	if (!o)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	*obj = o;
+	return TEE_SUCCESS;
 }
 
 void tee_obj_close(struct user_ta_ctx *utc, struct tee_obj *o)
 {
 	TAILQ_REMOVE(&utc->objects, o, link);
+	handle_put(&utc->object_db, o->id - 1);
 
 	if ((o->info.handleFlags & TEE_HANDLE_FLAG_PERSISTENT)) {
+		tee_svc_storage_async_release(o);
 		o->pobj->fops->close(&o->fh);
 		tee_pobj_release(o->pobj);
 	}
@@ -51,6 +64,7 @@ void tee_obj_close_all(struct user_ta_ctx *utc)
 
 	while (!TAILQ_EMPTY(objects))
 		tee_obj_close(utc, TAILQ_FIRST(objects));
+	handle_db_destroy(&utc->object_db, NULL);
 }
 
 TEE_Result tee_obj_verify(struct tee_ta_session *sess, struct tee_obj *o)
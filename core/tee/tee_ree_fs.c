@@ -4,6 +4,7 @@
  */
 
 #include <assert.h>
+#include <config.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/thread.h>
@@ -13,6 +14,7 @@
 #include <optee_rpc_cmd.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdlib_ext.h>
 #include <string_ext.h>
 #include <string.h>
 #include <sys/queue.h>
@@ -25,15 +27,63 @@
 #include <utee_defines.h>
 #include <util.h>
 
-#define BLOCK_SHIFT	12
+#define BLOCK_SHIFT	CFG_REE_FS_BLOCK_SHIFT
 
 #define BLOCK_SIZE	(1 << BLOCK_SHIFT)
 
+#if BLOCK_SHIFT < 12 || BLOCK_SHIFT > 16
+#error CFG_REE_FS_BLOCK_SHIFT must be in the range 12 to 16
+#endif
+
+/*
+ * struct block_cache_entry - a decrypted and authenticated data block
+ * @block_num:	number of the block in the file
+ * @last_use:	value of block_cache::tick at last access, used for LRU
+ * @valid:	true if @data holds the content of @block_num
+ * @dirty:	true if @data is modified but not yet written to the hash tree
+ * @data:	BLOCK_SIZE bytes of data
+ */
+struct block_cache_entry {
+	size_t block_num;
+	unsigned int last_use;
+	bool valid;
+	bool dirty;
+	uint8_t *data;
+};
+
+/*
+ * struct block_cache - per file cache of CFG_REE_FS_BLOCK_CACHE_BLOCKS blocks
+ * @tick:	incremented on each access
+ * @num_entries: number of entries in @entries and @ra_blocks
+ * @next_block:	block following the last one read, to detect sequential
+ *		reads
+ * @entries:	the cached blocks
+ * @ra_blocks:	scratch array of block pointers used when reading ahead
+ */
+struct block_cache {
+	unsigned int tick;
+	size_t num_entries;
+	size_t next_block;
+	struct block_cache_entry *entries;
+	void **ra_blocks;
+};
+
+/*
+ * @inline_data:	content of an object stored in its dirfile entry, a
+ *			buffer of CFG_REE_FS_INLINE_SIZE bytes, NULL if the
+ *			object has a file of its own in @ht and @fd
+ * @inline_len:		length of the content in @inline_data
+ */
 struct tee_fs_fd {
 	struct tee_fs_htree *ht;
 	int fd;
 	struct tee_fs_dirfile_fileh dfh;
-	const TEE_UUID *uuid;
+	TEE_UUID uuid;
+	struct block_cache *bcache;
+	uint8_t *inline_data;
+	size_t inline_len;
+	struct mutex mu;
+	TAILQ_ENTRY(tee_fs_fd) link;
 };
 
 struct tee_fs_dir {
@@ -48,16 +98,290 @@ static int pos_to_block_num(int position)
 	return position >> BLOCK_SHIFT;
 }
 
+/*
+ * ree_fs_mutex protects the dirfile and the state shared by all files,
+ * struct tee_fs_fd::mu protects the hash tree and the block cache of a
+ * file. Data is read, encrypted and decrypted with only the lock of the
+ * file held so operations on different files run concurrently. When both
+ * are needed the lock of the file is taken first.
+ */
 static struct mutex ree_fs_mutex = MUTEX_INITIALIZER;
 
+/*
+ * Temporary blocks are taken from a pool of their own instead of
+ * mempool_default which is shared with the bignum code, an REE FS
+ * operation doesn't have to wait for a big number computation in another
+ * thread to release mempool_default. A thread owning the pool never waits
+ * for ree_fs_mutex.
+ */
+static uint8_t tmp_block_data[ROUNDUP(sizeof(struct mempool_item) +
+				      BLOCK_SIZE, MEMPOOL_ALIGN)]
+	__aligned(MEMPOOL_ALIGN);
+static struct mempool *tmp_block_pool;
+static struct mutex tmp_block_pool_mu = MUTEX_INITIALIZER;
+
 static void *get_tmp_block(void)
 {
-	return mempool_alloc(mempool_default, BLOCK_SIZE);
+	struct mempool *pool = NULL;
+
+	mutex_lock(&tmp_block_pool_mu);
+	if (!tmp_block_pool)
+		tmp_block_pool = mempool_alloc_pool(tmp_block_data,
+						    sizeof(tmp_block_data),
+						    NULL);
+	pool = tmp_block_pool;
+	mutex_unlock(&tmp_block_pool_mu);
+
+	if (!pool)
+		return NULL;
+
+	return mempool_alloc(pool, BLOCK_SIZE);
 }
 
 static void put_tmp_block(void *tmp_block)
 {
-	mempool_free(mempool_default, tmp_block);
+	mempool_free(tmp_block_pool, tmp_block);
+}
+
+/*
+ * Returns the block cache of the file, allocated on first use. NULL is
+ * returned if the cache is disabled or cannot be allocated, in which case
+ * the blocks are accessed directly in the hash tree.
+ */
+static struct block_cache *bcache_get(struct tee_fs_fd *fdp)
+{
+	const size_t num = CFG_REE_FS_BLOCK_CACHE_BLOCKS;
+	struct block_cache *bc = NULL;
+	uint8_t *data = NULL;
+	size_t n = 0;
+
+	if (fdp->bcache || !num)
+		return fdp->bcache;
+
+	bc = calloc(1, sizeof(*bc));
+	if (!bc)
+		return NULL;
+	bc->entries = calloc(num, sizeof(*bc->entries));
+	bc->ra_blocks = calloc(num, sizeof(*bc->ra_blocks));
+	data = malloc(num * BLOCK_SIZE);
+	if (!bc->entries || !bc->ra_blocks || !data) {
+		free(bc->entries);
+		free(bc->ra_blocks);
+		free(data);
+		free(bc);
+		return NULL;
+	}
+
+	for (n = 0; n < num; n++)
+		bc->entries[n].data = data + n * BLOCK_SIZE;
+	bc->num_entries = num;
+
+	fdp->bcache = bc;
+	return bc;
+}
+
+static void bcache_free(struct tee_fs_fd *fdp)
+{
+	struct block_cache *bc = fdp->bcache;
+
+	if (bc) {
+		free(bc->entries[0].data);
+		free(bc->entries);
+		free(bc->ra_blocks);
+		free(bc);
+		fdp->bcache = NULL;
+	}
+}
+
+static bool bcache_is_dirty(struct tee_fs_fd *fdp)
+{
+	struct block_cache *bc = fdp->bcache;
+	size_t n = 0;
+
+	if (!bc)
+		return false;
+
+	for (n = 0; n < bc->num_entries; n++)
+		if (bc->entries[n].dirty)
+			return true;
+
+	return false;
+}
+
+static void bcache_invalidate(struct block_cache *bc)
+{
+	size_t n = 0;
+
+	if (!bc)
+		return;
+
+	for (n = 0; n < bc->num_entries; n++) {
+		bc->entries[n].valid = false;
+		bc->entries[n].dirty = false;
+	}
+}
+
+static struct block_cache_entry *bcache_find(struct block_cache *bc,
+					     size_t block_num)
+{
+	size_t n = 0;
+
+	for (n = 0; n < bc->num_entries; n++) {
+		struct block_cache_entry *e = bc->entries + n;
+
+		if (e->valid && e->block_num == block_num) {
+			e->last_use = ++bc->tick;
+			return e;
+		}
+	}
+
+	return NULL;
+}
+
+static TEE_Result bcache_write_back(struct tee_fs_fd *fdp,
+				    struct block_cache_entry *e)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!e->dirty)
+		return TEE_SUCCESS;
+
+	res = tee_fs_htree_write_block(&fdp->ht, e->block_num, e->data);
+	if (res) {
+		/* The hash tree is closed, the cache is meaningless now */
+		bcache_invalidate(fdp->bcache);
+		return res;
+	}
+	e->dirty = false;
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Writes all dirty blocks to the hash tree, needs to be done before the
+ * hash tree is synchronized to storage.
+ */
+static TEE_Result bcache_flush(struct tee_fs_fd *fdp)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	if (!fdp->bcache)
+		return TEE_SUCCESS;
+
+	for (n = 0; n < fdp->bcache->num_entries; n++) {
+		res = bcache_write_back(fdp, fdp->bcache->entries + n);
+		if (res)
+			return res;
+	}
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Assigns the least recently used entry to @block_num, writing back its
+ * previous content if dirty. The returned entry isn't valid yet.
+ */
+static TEE_Result bcache_evict(struct tee_fs_fd *fdp, size_t block_num,
+			       struct block_cache_entry **entry)
+{
+	struct block_cache *bc = fdp->bcache;
+	struct block_cache_entry *e = bc->entries;
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	/*
+	 * Invalid entries are picked like the others, so entries just
+	 * assigned to blocks being read ahead aren't reused.
+	 */
+	for (n = 1; n < bc->num_entries; n++)
+		if (bc->entries[n].last_use < e->last_use)
+			e = bc->entries + n;
+
+	res = bcache_write_back(fdp, e);
+	if (res)
+		return res;
+
+	e->valid = false;
+	e->block_num = block_num;
+	e->last_use = ++bc->tick;
+	*entry = e;
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Returns the cached entry of @block_num. On a miss the block is read from
+ * the hash tree if @fill is true, together with up to @ra_num - 1
+ * following blocks that aren't cached already. The blocks are fetched with
+ * a single RPC. If @fill is false the caller is about to overwrite the
+ * whole block and it's only zeroed.
+ */
+static TEE_Result bcache_get_block(struct tee_fs_fd *fdp, size_t block_num,
+				   size_t ra_num, bool fill,
+				   struct block_cache_entry **entry)
+{
+	struct block_cache *bc = fdp->bcache;
+	struct block_cache_entry *e = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t num = 0;
+	size_t n = 0;
+
+	e = bcache_find(bc, block_num);
+	if (e)
+		goto out;
+
+	if (!fill) {
+		res = bcache_evict(fdp, block_num, &e);
+		if (res)
+			return res;
+		memset(e->data, 0, BLOCK_SIZE);
+		e->valid = true;
+		goto out;
+	}
+
+	ra_num = MIN(ra_num, bc->num_entries);
+	for (num = 1; num < ra_num; num++)
+		if (bcache_find(bc, block_num + num))
+			break;
+
+	for (n = 0; n < num; n++) {
+		struct block_cache_entry *ra_e = NULL;
+
+		res = bcache_evict(fdp, block_num + n, &ra_e);
+		if (res)
+			return res;
+		bc->ra_blocks[n] = ra_e->data;
+		if (!n)
+			e = ra_e;
+	}
+
+	res = tee_fs_htree_read_blocks(&fdp->ht, block_num, num,
+				       bc->ra_blocks);
+	if (res) {
+		bcache_invalidate(bc);
+		return res;
+	}
+
+	for (n = 0; n < num; n++) {
+		size_t idx = ((uint8_t *)bc->ra_blocks[n] -
+			      bc->entries[0].data) / BLOCK_SIZE;
+
+		bc->entries[idx].valid = true;
+	}
+out:
+	*entry = e;
+	return TEE_SUCCESS;
+}
+
+static TEE_Result ree_fs_sync_to_storage(struct tee_fs_fd *fdp)
+{
+	TEE_Result res = bcache_flush(fdp);
+
+	if (res)
+		return res;
+
+	return tee_fs_htree_sync_to_storage(&fdp->ht, fdp->dfh.hash);
 }
 
 static TEE_Result out_of_place_write(struct tee_fs_fd *fdp, size_t pos,
@@ -68,8 +392,9 @@ static TEE_Result out_of_place_write(struct tee_fs_fd *fdp, size_t pos,
 	size_t end_block_num = pos_to_block_num(pos + len - 1);
 	size_t remain_bytes = len;
 	uint8_t *data_ptr = (uint8_t *)buf;
-	uint8_t *block;
+	uint8_t *block = NULL;
 	struct tee_fs_htree_meta *meta = tee_fs_htree_get_meta(fdp->ht);
+	struct block_cache *bc = bcache_get(fdp);
 
 	/*
 	 * It doesn't make sense to call this function if nothing is to be
@@ -79,36 +404,70 @@ static TEE_Result out_of_place_write(struct tee_fs_fd *fdp, size_t pos,
 	if (!len)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	block = get_tmp_block();
-	if (!block)
-		return TEE_ERROR_OUT_OF_MEMORY;
-
 	while (start_block_num <= end_block_num) {
 		size_t offset = pos % BLOCK_SIZE;
 		size_t size_to_write = MIN(remain_bytes, (size_t)BLOCK_SIZE);
+		bool in_file = start_block_num * BLOCK_SIZE <
+			       ROUNDUP(meta->length, BLOCK_SIZE);
+		const uint8_t *src = NULL;
+		uint8_t *dst = NULL;
 
 		if (size_to_write + offset > BLOCK_SIZE)
 			size_to_write = BLOCK_SIZE - offset;
 
-		if (start_block_num * BLOCK_SIZE <
-		    ROUNDUP(meta->length, BLOCK_SIZE)) {
-			res = tee_fs_htree_read_block(&fdp->ht,
-						      start_block_num, block);
+		if (bc) {
+			struct block_cache_entry *e = NULL;
+
+			/*
+			 * The block is only written to the hash tree when
+			 * evicted from the cache or before the hash tree is
+			 * synchronized to storage.
+			 */
+			res = bcache_get_block(fdp, start_block_num, 1,
+					       in_file &&
+					       size_to_write != BLOCK_SIZE, &e);
 			if (res != TEE_SUCCESS)
 				goto exit;
+			e->dirty = true;
+			dst = e->data;
+		} else if (data_ptr && size_to_write == BLOCK_SIZE) {
+			/*
+			 * A full block is encrypted straight from the
+			 * caller's buffer.
+			 */
+			src = data_ptr;
 		} else {
-			memset(block, 0, BLOCK_SIZE);
+			if (!block) {
+				block = get_tmp_block();
+				if (!block) {
+					res = TEE_ERROR_OUT_OF_MEMORY;
+					goto exit;
+				}
+			}
+			if (in_file && size_to_write != BLOCK_SIZE) {
+				res = tee_fs_htree_read_block(&fdp->ht,
+							      start_block_num,
+							      block);
+				if (res != TEE_SUCCESS)
+					goto exit;
+			} else {
+				memset(block, 0, BLOCK_SIZE);
+			}
+			dst = block;
+			src = block;
 		}
 
-		if (data_ptr)
-			memcpy(block + offset, data_ptr, size_to_write);
-		else
-			memset(block + offset, 0, size_to_write);
+		if (dst && data_ptr)
+			memcpy(dst + offset, data_ptr, size_to_write);
+		else if (dst)
+			memset(dst + offset, 0, size_to_write);
 
-		res = tee_fs_htree_write_block(&fdp->ht, start_block_num,
-					       block);
-		if (res != TEE_SUCCESS)
-			goto exit;
+		if (src) {
+			res = tee_fs_htree_write_block(&fdp->ht,
+						       start_block_num, src);
+			if (res != TEE_SUCCESS)
+				goto exit;
+		}
 
 		if (data_ptr)
 			data_ptr += size_to_write;
@@ -247,12 +606,118 @@ static TEE_Result ree_fs_rpc_write_init(void *aux,
 				     offs, size, data);
 }
 
+/*
+ * Reads the range of the file from the first to the last of the requested
+ * block versions in one RPC. This also transfers the other versions of the
+ * blocks and the node blocks in between, but saves one round trip to
+ * normal world per block.
+ */
+static TEE_Result ree_fs_rpc_read_blocks_init(void *aux,
+					      struct tee_fs_rpc_operation *op,
+					      size_t idx, size_t num,
+					      const uint8_t *vers, void **data,
+					      size_t *size)
+{
+	struct tee_fs_fd *fdp = aux;
+	TEE_Result res = TEE_SUCCESS;
+	size_t start = 0;
+	size_t offs = 0;
+	size_t sz = 0;
+	void *p = NULL;
+	size_t n = 0;
+
+	res = get_offs_size(TEE_FS_HTREE_TYPE_BLOCK, idx, vers[0], &start,
+			    &sz);
+	if (res != TEE_SUCCESS)
+		return res;
+	res = get_offs_size(TEE_FS_HTREE_TYPE_BLOCK, idx + num - 1,
+			    vers[num - 1], &offs, &sz);
+	if (res != TEE_SUCCESS)
+		return res;
+	*size = offs + sz - start;
+
+	res = tee_fs_rpc_read_init(op, OPTEE_RPC_CMD_FS, fdp->fd, start,
+				   *size, &p);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	for (n = 0; n < num; n++) {
+		res = get_offs_size(TEE_FS_HTREE_TYPE_BLOCK, idx + n, vers[n],
+				    &offs, &sz);
+		if (res != TEE_SUCCESS)
+			return res;
+		data[n] = (uint8_t *)p + offs - start;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result ree_fs_rpc_vec_init(void *aux,
+				      struct tee_fs_rpc_operation *op,
+				      struct tee_fs_htree_elem *elem,
+				      size_t num, bool write)
+{
+	struct tee_fs_fd *fdp = aux;
+	struct tee_fs_rpc_iov *iov = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t offs = 0;
+	size_t n = 0;
+
+	iov = calloc(num, sizeof(*iov));
+	if (!iov)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	for (n = 0; n < num; n++) {
+		res = get_offs_size(elem[n].type, elem[n].idx, elem[n].vers,
+				    &offs, &iov[n].len);
+		if (res != TEE_SUCCESS)
+			goto out;
+		iov[n].offset = offs;
+	}
+
+	if (write)
+		res = tee_fs_rpc_writev_init(op, OPTEE_RPC_CMD_FS, fdp->fd,
+					     iov, num);
+	else
+		res = tee_fs_rpc_readv_init(op, OPTEE_RPC_CMD_FS, fdp->fd,
+					    iov, num);
+	if (res != TEE_SUCCESS)
+		goto out;
+
+	for (n = 0; n < num; n++)
+		elem[n].data = iov[n].data;
+out:
+	free(iov);
+	return res;
+}
+
+static TEE_Result ree_fs_rpc_readv_init(void *aux,
+					struct tee_fs_rpc_operation *op,
+					struct tee_fs_htree_elem *elem,
+					size_t num)
+{
+	return ree_fs_rpc_vec_init(aux, op, elem, num, false);
+}
+
+static TEE_Result ree_fs_rpc_writev_init(void *aux,
+					 struct tee_fs_rpc_operation *op,
+					 struct tee_fs_htree_elem *elem,
+					 size_t num)
+{
+	return ree_fs_rpc_vec_init(aux, op, elem, num, true);
+}
+
 static const struct tee_fs_htree_storage ree_fs_storage_ops = {
 	.block_size = BLOCK_SIZE,
 	.rpc_read_init = ree_fs_rpc_read_init,
 	.rpc_read_final = tee_fs_rpc_read_final,
 	.rpc_write_init = ree_fs_rpc_write_init,
 	.rpc_write_final = tee_fs_rpc_write_final,
+	.rpc_read_blocks_init = ree_fs_rpc_read_blocks_init,
+	.rpc_readv_init = ree_fs_rpc_readv_init,
+	.rpc_readv_final = tee_fs_rpc_readv_final,
+	.rpc_writev_init = ree_fs_rpc_writev_init,
+	.rpc_writev_final = tee_fs_rpc_writev_final,
 };
 
 static TEE_Result ree_fs_ftruncate_internal(struct tee_fs_fd *fdp,
@@ -277,6 +742,12 @@ static TEE_Result ree_fs_ftruncate_internal(struct tee_fs_fd *fdp,
 		if (res != TEE_SUCCESS)
 			return res;
 
+		/* Don't let blocks beyond the new end be written back */
+		res = bcache_flush(fdp);
+		if (res != TEE_SUCCESS)
+			return res;
+		bcache_invalidate(fdp->bcache);
+
 		res = tee_fs_htree_truncate(&fdp->ht,
 					    new_file_len / BLOCK_SIZE);
 		if (res != TEE_SUCCESS)
@@ -300,10 +771,12 @@ static TEE_Result ree_fs_read_primitive(struct tee_file_handle *fh, size_t pos,
 	TEE_Result res;
 	int start_block_num;
 	int end_block_num;
+	int last_block_num = 0;
 	size_t remain_bytes;
 	uint8_t *data_ptr = buf;
 	uint8_t *block = NULL;
 	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
+	struct block_cache *bc = NULL;
 	struct tee_fs_htree_meta *meta = tee_fs_htree_get_meta(fdp->ht);
 
 	remain_bytes = *len;
@@ -322,24 +795,63 @@ static TEE_Result ree_fs_read_primitive(struct tee_file_handle *fh, size_t pos,
 	start_block_num = pos_to_block_num(pos);
 	end_block_num = pos_to_block_num(pos + remain_bytes - 1);
 
-	block = get_tmp_block();
-	if (!block) {
-		res = TEE_ERROR_OUT_OF_MEMORY;
-		goto exit;
+	bc = bcache_get(fdp);
+	if (bc) {
+		/*
+		 * Read ahead to the end of the file when reading
+		 * sequentially, else only what's requested.
+		 */
+		if ((size_t)start_block_num == bc->next_block)
+			last_block_num = pos_to_block_num(meta->length - 1);
+		else
+			last_block_num = end_block_num;
+		bc->next_block = end_block_num + 1;
 	}
 
 	while (start_block_num <= end_block_num) {
 		size_t offset = pos % BLOCK_SIZE;
 		size_t size_to_read = MIN(remain_bytes, (size_t)BLOCK_SIZE);
+		uint8_t *src = NULL;
 
 		if (size_to_read + offset > BLOCK_SIZE)
 			size_to_read = BLOCK_SIZE - offset;
 
-		res = tee_fs_htree_read_block(&fdp->ht, start_block_num, block);
-		if (res != TEE_SUCCESS)
-			goto exit;
+		if (bc) {
+			struct block_cache_entry *e = NULL;
 
-		memcpy(data_ptr, block + offset, size_to_read);
+			res = bcache_get_block(fdp, start_block_num,
+					       last_block_num -
+					       start_block_num + 1, true, &e);
+			if (res != TEE_SUCCESS)
+				goto exit;
+			src = e->data;
+		} else if (size_to_read == BLOCK_SIZE) {
+			/* A full block is decrypted straight into @buf */
+			res = tee_fs_htree_read_block(&fdp->ht, start_block_num,
+						      data_ptr);
+			if (res != TEE_SUCCESS) {
+				/* Don't leave unauthenticated data behind */
+				memset(data_ptr, 0, BLOCK_SIZE);
+				goto exit;
+			}
+			src = NULL;
+		} else {
+			if (!block) {
+				block = get_tmp_block();
+				if (!block) {
+					res = TEE_ERROR_OUT_OF_MEMORY;
+					goto exit;
+				}
+			}
+			res = tee_fs_htree_read_block(&fdp->ht, start_block_num,
+						      block);
+			if (res != TEE_SUCCESS)
+				goto exit;
+			src = block;
+		}
+
+		if (src)
+			memcpy(data_ptr, src + offset, size_to_read);
 
 		data_ptr += size_to_read;
 		remain_bytes -= size_to_read;
@@ -354,14 +866,30 @@ exit:
 	return res;
 }
 
+static void inline_read(struct tee_fs_fd *fdp, size_t pos, void *buf,
+			size_t *len)
+{
+	if (pos >= fdp->inline_len) {
+		*len = 0;
+		return;
+	}
+
+	*len = MIN(*len, fdp->inline_len - pos);
+	memcpy(buf, fdp->inline_data + pos, *len);
+}
+
 static TEE_Result ree_fs_read(struct tee_file_handle *fh, size_t pos,
 			      void *buf, size_t *len)
 {
-	TEE_Result res;
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
 
-	mutex_lock(&ree_fs_mutex);
-	res = ree_fs_read_primitive(fh, pos, buf, len);
-	mutex_unlock(&ree_fs_mutex);
+	mutex_lock(&fdp->mu);
+	if (fdp->inline_data)
+		inline_read(fdp, pos, buf, len);
+	else
+		res = ree_fs_read_primitive(fh, pos, buf, len);
+	mutex_unlock(&fdp->mu);
 
 	return res;
 }
@@ -390,6 +918,35 @@ static TEE_Result ree_fs_write_primitive(struct tee_file_handle *fh, size_t pos,
 	return out_of_place_write(fdp, pos, buf, len);
 }
 
+/*
+ * Opens the file in @dfh and its hash tree, @uuid is NULL or points to
+ * @fdp->uuid. The file is closed again on failure.
+ */
+static TEE_Result fd_open_htree(struct tee_fs_fd *fdp, bool create,
+				uint8_t *hash, const TEE_UUID *uuid,
+				struct tee_fs_dirfile_fileh *dfh)
+{
+	TEE_Result res;
+
+	if (create)
+		res = tee_fs_rpc_create_dfh(OPTEE_RPC_CMD_FS,
+					    dfh, &fdp->fd);
+	else
+		res = tee_fs_rpc_open_dfh(OPTEE_RPC_CMD_FS, dfh, &fdp->fd);
+
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = tee_fs_htree_open(create, hash, uuid, &ree_fs_storage_ops, fdp,
+				&fdp->ht);
+	if (res != TEE_SUCCESS) {
+		tee_fs_rpc_close(OPTEE_RPC_CMD_FS, fdp->fd);
+		fdp->fd = -1;
+	}
+
+	return res;
+}
+
 static TEE_Result ree_fs_open_primitive(bool create, uint8_t *hash,
 					const TEE_UUID *uuid,
 					struct tee_fs_dirfile_fileh *dfh,
@@ -402,20 +959,11 @@ static TEE_Result ree_fs_open_primitive(bool create, uint8_t *hash,
 	if (!fdp)
 		return TEE_ERROR_OUT_OF_MEMORY;
 	fdp->fd = -1;
-	fdp->uuid = uuid;
+	mutex_init(&fdp->mu);
+	if (uuid)
+		fdp->uuid = *uuid;
 
-	if (create)
-		res = tee_fs_rpc_create_dfh(OPTEE_RPC_CMD_FS,
-					    dfh, &fdp->fd);
-	else
-		res = tee_fs_rpc_open_dfh(OPTEE_RPC_CMD_FS, dfh, &fdp->fd);
-
-	if (res != TEE_SUCCESS)
-		goto out;
-
-	res = tee_fs_htree_open(create, hash, uuid, &ree_fs_storage_ops,
-				fdp, &fdp->ht);
-out:
+	res = fd_open_htree(fdp, create, hash, uuid ? &fdp->uuid : NULL, dfh);
 	if (res == TEE_SUCCESS) {
 		if (dfh)
 			fdp->dfh = *dfh;
@@ -423,10 +971,9 @@ out:
 			fdp->dfh.idx = -1;
 		*fh = (struct tee_file_handle *)fdp;
 	} else {
-		if (fdp->fd != -1)
-			tee_fs_rpc_close(OPTEE_RPC_CMD_FS, fdp->fd);
 		if (create)
 			tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, dfh);
+		mutex_destroy(&fdp->mu);
 		free(fdp);
 	}
 
@@ -438,8 +985,14 @@ static void ree_fs_close_primitive(struct tee_file_handle *fh)
 	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
 
 	if (fdp) {
-		tee_fs_htree_close(&fdp->ht);
-		tee_fs_rpc_close(OPTEE_RPC_CMD_FS, fdp->fd);
+		bcache_free(fdp);
+		if (fdp->inline_data) {
+			free_wipe(fdp->inline_data);
+		} else {
+			tee_fs_htree_close(&fdp->ht);
+			tee_fs_rpc_close(OPTEE_RPC_CMD_FS, fdp->fd);
+		}
+		mutex_destroy(&fdp->mu);
 		free(fdp);
 	}
 }
@@ -450,7 +1003,7 @@ static TEE_Result ree_dirf_commit_writes(struct tee_file_handle *fh,
 	TEE_Result res;
 	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
 
-	res = tee_fs_htree_sync_to_storage(&fdp->ht, fdp->dfh.hash);
+	res = ree_fs_sync_to_storage(fdp);
 
 	if (!res && hash)
 		memcpy(hash, fdp->dfh.hash, sizeof(fdp->dfh.hash));
@@ -546,6 +1099,125 @@ static void close_dirh(struct tee_fs_dirfile_dirh **dirh)
 }
 #endif /*!CFG_RPMB_FS*/
 
+/*
+ * With CFG_REE_FS_DIRFILE_BATCH the commit of dirfile changes made by
+ * creating, removing or renaming objects is deferred until that many
+ * such changes are pending or until any other change is committed.
+ * While a transaction is active they're deferred until it ends instead.
+ * Files of removed objects are kept in normal world, and their file
+ * numbers aren't reused, until the dirfile no longer referring to them
+ * is committed. Files of created objects are tracked until the dirfile
+ * referring to them is committed, so they can be removed if the deferred
+ * changes are lost.
+ */
+struct dirh_pending_file {
+	struct tee_fs_dirfile_fileh dfh;
+	SLIST_ENTRY(dirh_pending_file) link;
+};
+
+SLIST_HEAD(dirh_pending_file_head, dirh_pending_file);
+
+static struct dirh_pending_file_head dirh_pending_removes =
+	SLIST_HEAD_INITIALIZER(dirh_pending_removes);
+static struct dirh_pending_file_head dirh_pending_creates =
+	SLIST_HEAD_INITIALIZER(dirh_pending_creates);
+static size_t dirh_pending_ops;
+static size_t dirh_txn_count;
+
+static bool dirh_resident(void)
+{
+	return IS_ENABLED(CFG_REE_FS_DIRFILE_RESIDENT) ||
+	       CFG_REE_FS_DIRFILE_BATCH;
+}
+
+/* Removes the files if @dirh isn't NULL, else just forgets them */
+static void free_pending_files(struct dirh_pending_file_head *head,
+			       struct tee_fs_dirfile_dirh *dirh)
+{
+	struct dirh_pending_file *pf = NULL;
+
+	while (!SLIST_EMPTY(head)) {
+		pf = SLIST_FIRST(head);
+		SLIST_REMOVE_HEAD(head, link);
+		if (dirh) {
+			tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, &pf->dfh);
+			tee_fs_dirfile_release_file(dirh, pf->dfh.file_number);
+		}
+		free(pf);
+	}
+}
+
+/*
+ * Called when the deferred changes are committed or lost, removes the
+ * files the committed dirfile doesn't refer to.
+ */
+static void dirh_drop_pending(struct tee_fs_dirfile_dirh *dirh,
+			      bool committed)
+{
+	free_pending_files(&dirh_pending_removes, committed ? dirh : NULL);
+	free_pending_files(&dirh_pending_creates, committed ? NULL : dirh);
+	dirh_pending_ops = 0;
+}
+
+/* Commits all dirfile changes, including deferred ones */
+static TEE_Result flush_dirh_writes(struct tee_fs_dirfile_dirh *dirh)
+{
+	TEE_Result res = commit_dirh_writes(dirh);
+
+	if (!res)
+		dirh_drop_pending(dirh, true);
+
+	return res;
+}
+
+/*
+ * Commits, or defers the commit of, a change of the dirfile which
+ * refers to the new file in @create_dfh and replaces or removes the file
+ * in @remove_dfh, each if not NULL.
+ */
+static TEE_Result batch_dirh_writes(struct tee_fs_dirfile_dirh *dirh,
+				    struct tee_fs_dirfile_fileh *create_dfh,
+				    struct tee_fs_dirfile_fileh *remove_dfh)
+{
+	const size_t max_ops = CFG_REE_FS_DIRFILE_BATCH;
+	uint32_t remove_fnum = remove_dfh ? remove_dfh->file_number : 0;
+	struct dirh_pending_file *cf = NULL;
+	struct dirh_pending_file *rf = NULL;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (dirh_txn_count || dirh_pending_ops + 1 < max_ops) {
+		if (create_dfh) {
+			cf = malloc(sizeof(*cf));
+			if (!cf)
+				goto flush;
+			cf->dfh = *create_dfh;
+		}
+		if (remove_dfh) {
+			rf = malloc(sizeof(*rf));
+			if (!rf || tee_fs_dirfile_hold_file(dirh, remove_fnum))
+				goto flush;
+			rf->dfh = *remove_dfh;
+			SLIST_INSERT_HEAD(&dirh_pending_removes, rf, link);
+		}
+		if (cf)
+			SLIST_INSERT_HEAD(&dirh_pending_creates, cf, link);
+		dirh_pending_ops++;
+		return TEE_SUCCESS;
+	}
+
+flush:
+	free(cf);
+	free(rf);
+
+	res = flush_dirh_writes(dirh);
+	if (!res && remove_dfh) {
+		tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, remove_dfh);
+		tee_fs_dirfile_release_file(dirh, remove_fnum);
+	}
+
+	return res;
+}
+
 static TEE_Result get_dirh(struct tee_fs_dirfile_dirh **dirh)
 {
 	if (!ree_fs_dirh) {
@@ -580,8 +1252,16 @@ static void put_dirh_primitive(bool close)
 	 * ree_fs_dirh may actually be NULL.
 	 */
 	ree_fs_dirh_refcount--;
-	if (ree_fs_dirh && (!ree_fs_dirh_refcount || close))
+	if (ree_fs_dirh &&
+	    (close || (!ree_fs_dirh_refcount && !dirh_resident()))) {
+		/*
+		 * Deferred changes are lost with the dirfile. The files
+		 * they would have removed are still referred to by the
+		 * committed dirfile, the files they created aren't.
+		 */
+		dirh_drop_pending(ree_fs_dirh, false);
 		close_dirh(&ree_fs_dirh);
+	}
 }
 
 static void put_dirh(struct tee_fs_dirfile_dirh *dirh, bool close)
@@ -592,12 +1272,115 @@ static void put_dirh(struct tee_fs_dirfile_dirh *dirh, bool close)
 	}
 }
 
+/*
+ * Handles of closed files kept for CFG_REE_FS_HANDLE_CACHE, most recently
+ * closed first. Each of them holds a reference on ree_fs_dirh.
+ */
+static TAILQ_HEAD(closed_fd_head, tee_fs_fd) closed_fds =
+	TAILQ_HEAD_INITIALIZER(closed_fds);
+static size_t closed_fd_count;
+
+static void closed_fd_drop(struct tee_fs_fd *fdp)
+{
+	TAILQ_REMOVE(&closed_fds, fdp, link);
+	closed_fd_count--;
+	ree_fs_close_primitive((struct tee_file_handle *)fdp);
+	put_dirh_primitive(false);
+}
+
+/*
+ * Keeps the handle of a file being closed, together with its reference
+ * on ree_fs_dirh. Returns false if the handle has to be closed instead
+ * because the cache is disabled or the hash tree holds changes which
+ * aren't committed.
+ */
+static bool closed_fd_put(struct tee_fs_fd *fdp)
+{
+	if (!CFG_REE_FS_HANDLE_CACHE || !fdp->ht ||
+	    tee_fs_htree_is_dirty(fdp->ht) || bcache_is_dirty(fdp))
+		return false;
+
+	bcache_free(fdp);
+	TAILQ_INSERT_HEAD(&closed_fds, fdp, link);
+	closed_fd_count++;
+	if (closed_fd_count > CFG_REE_FS_HANDLE_CACHE)
+		closed_fd_drop(TAILQ_LAST(&closed_fds, closed_fd_head));
+
+	return true;
+}
+
+/*
+ * Returns a kept handle of the file in @dfh if its hash tree still matches
+ * the hash recorded in the dirfile. The caller's reference on ree_fs_dirh
+ * replaces the one held by the kept handle.
+ */
+static struct tee_fs_fd *closed_fd_get(const TEE_UUID *uuid,
+				       struct tee_fs_dirfile_fileh *dfh)
+{
+	struct tee_fs_fd *fdp = NULL;
+	struct tee_fs_fd *next = NULL;
+
+	TAILQ_FOREACH_SAFE(fdp, &closed_fds, link, next) {
+		if (fdp->dfh.file_number != dfh->file_number)
+			continue;
+
+		if (memcmp(fdp->dfh.hash, dfh->hash, sizeof(dfh->hash)) ||
+		    memcmp(&fdp->uuid, uuid, sizeof(*uuid))) {
+			/* The file has been replaced since */
+			closed_fd_drop(fdp);
+			continue;
+		}
+
+		TAILQ_REMOVE(&closed_fds, fdp, link);
+		closed_fd_count--;
+		fdp->dfh = *dfh;
+		put_dirh_primitive(false);
+		return fdp;
+	}
+
+	return NULL;
+}
+
+/* Closes all kept handles of a file which is about to be removed */
+static void closed_fd_forget(struct tee_fs_dirfile_fileh *dfh)
+{
+	struct tee_fs_fd *fdp = NULL;
+	struct tee_fs_fd *next = NULL;
+
+	TAILQ_FOREACH_SAFE(fdp, &closed_fds, link, next)
+		if (fdp->dfh.file_number == dfh->file_number)
+			closed_fd_drop(fdp);
+}
+
+/* Allocates the handle of an object stored in its dirfile entry */
+static TEE_Result inline_fd_alloc(const TEE_UUID *uuid,
+				  struct tee_fs_fd **fdp_ret)
+{
+	struct tee_fs_fd *fdp = calloc(1, sizeof(*fdp));
+
+	if (!fdp)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	fdp->inline_data = calloc(1, CFG_REE_FS_INLINE_SIZE);
+	if (!fdp->inline_data) {
+		free(fdp);
+		return TEE_ERROR_OUT_OF_MEMORY;
+	}
+	fdp->fd = -1;
+	fdp->dfh.idx = -1;
+	fdp->uuid = *uuid;
+	mutex_init(&fdp->mu);
+	*fdp_ret = fdp;
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result ree_fs_open(struct tee_pobj *po, size_t *size,
 			      struct tee_file_handle **fh)
 {
 	TEE_Result res;
 	struct tee_fs_dirfile_dirh *dirh = NULL;
 	struct tee_fs_dirfile_fileh dfh;
+	struct tee_fs_fd *fdp = NULL;
 
 	mutex_lock(&ree_fs_mutex);
 
@@ -610,7 +1393,32 @@ static TEE_Result ree_fs_open(struct tee_pobj *po, size_t *size,
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = ree_fs_open_primitive(false, dfh.hash, &po->uuid, &dfh, fh);
+	if (dfh.is_inline) {
+		res = inline_fd_alloc(&po->uuid, &fdp);
+		if (res)
+			goto out;
+		fdp->dfh = dfh;
+		res = tee_fs_dirfile_read_inline(dirh, &dfh, fdp->inline_data,
+						 &fdp->inline_len);
+		if (res) {
+			ree_fs_close_primitive((struct tee_file_handle *)fdp);
+			goto out;
+		}
+		*fh = (struct tee_file_handle *)fdp;
+		if (size)
+			*size = fdp->inline_len;
+		goto out;
+	}
+
+	fdp = closed_fd_get(&po->uuid, &dfh);
+	if (fdp) {
+		*fh = (struct tee_file_handle *)fdp;
+		res = TEE_SUCCESS;
+	} else {
+		res = ree_fs_open_primitive(false, dfh.hash, &po->uuid, &dfh,
+					    fh);
+		fdp = (struct tee_fs_fd *)*fh;
+	}
 	if (res == TEE_ERROR_ITEM_NOT_FOUND) {
 		/*
 		 * If the object isn't found someone has tampered with it,
@@ -618,8 +1426,6 @@ static TEE_Result ree_fs_open(struct tee_pobj *po, size_t *size,
 		 */
 		res = TEE_ERROR_CORRUPT_OBJECT;
 	} else if (!res && size) {
-		struct tee_fs_fd *fdp = (struct tee_fs_fd *)*fh;
-
 		*size = tee_fs_htree_get_meta(fdp->ht)->length;
 	}
 
@@ -638,6 +1444,7 @@ static TEE_Result set_name(struct tee_fs_dirfile_dirh *dirh,
 	TEE_Result res;
 	bool have_old_dfh = false;
 	struct tee_fs_dirfile_fileh old_dfh = { .idx = -1 };
+	struct tee_fs_dirfile_fileh *create_dfh = NULL;
 
 	res = tee_fs_dirfile_find(dirh, &po->uuid, po->obj_id, po->obj_id_len,
 				  &old_dfh);
@@ -653,27 +1460,36 @@ static TEE_Result set_name(struct tee_fs_dirfile_dirh *dirh,
 	 */
 	fdp->dfh.idx = old_dfh.idx;
 	old_dfh.idx = -1;
-	res = tee_fs_dirfile_rename(dirh, &po->uuid, &fdp->dfh,
-				    po->obj_id, po->obj_id_len);
+	if (fdp->inline_data)
+		res = tee_fs_dirfile_set_inline(dirh, &po->uuid, &fdp->dfh,
+						po->obj_id, po->obj_id_len,
+						fdp->inline_data,
+						fdp->inline_len);
+	else
+		res = tee_fs_dirfile_rename(dirh, &po->uuid, &fdp->dfh,
+					    po->obj_id, po->obj_id_len);
 	if (res)
 		return res;
 
-	res = commit_dirh_writes(dirh);
-	if (res)
-		return res;
+	if (!fdp->inline_data)
+		create_dfh = &fdp->dfh;
 
-	if (have_old_dfh)
-		tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, &old_dfh);
+	/* An inline object leaves no file behind */
+	if (!have_old_dfh || old_dfh.is_inline)
+		return batch_dirh_writes(dirh, create_dfh, NULL);
 
-	return TEE_SUCCESS;
+	closed_fd_forget(&old_dfh);
+	return batch_dirh_writes(dirh, create_dfh, &old_dfh);
 }
 
 static void ree_fs_close(struct tee_file_handle **fh)
 {
 	if (*fh) {
 		mutex_lock(&ree_fs_mutex);
-		put_dirh_primitive(false);
-		ree_fs_close_primitive(*fh);
+		if (!closed_fd_put((struct tee_fs_fd *)*fh)) {
+			put_dirh_primitive(false);
+			ree_fs_close_primitive(*fh);
+		}
 		*fh = NULL;
 		mutex_unlock(&ree_fs_mutex);
 
@@ -688,9 +1504,11 @@ static TEE_Result ree_fs_create(struct tee_pobj *po, bool overwrite,
 {
 	struct tee_fs_fd *fdp;
 	struct tee_fs_dirfile_dirh *dirh = NULL;
-	struct tee_fs_dirfile_fileh dfh;
+	struct tee_fs_dirfile_fileh dfh = { };
 	TEE_Result res;
 	size_t pos = 0;
+	size_t size = 0;
+	bool is_inline = false;
 
 	*fh = NULL;
 	mutex_lock(&ree_fs_mutex);
@@ -699,6 +1517,34 @@ static TEE_Result ree_fs_create(struct tee_pobj *po, bool overwrite,
 	if (res)
 		goto out;
 
+	if (CFG_REE_FS_INLINE_SIZE &&
+	    !ADD_OVERFLOW(head_size, attr_size, &size) &&
+	    !ADD_OVERFLOW(size, data_size, &size) &&
+	    size <= CFG_REE_FS_INLINE_SIZE) {
+		is_inline = true;
+		res = inline_fd_alloc(&po->uuid, &fdp);
+		if (res)
+			goto out;
+		*fh = (struct tee_file_handle *)fdp;
+
+		if (head && head_size) {
+			memcpy(fdp->inline_data + pos, head, head_size);
+			pos += head_size;
+		}
+		if (attr && attr_size) {
+			memcpy(fdp->inline_data + pos, attr, attr_size);
+			pos += attr_size;
+		}
+		if (data && data_size) {
+			memcpy(fdp->inline_data + pos, data, data_size);
+			pos += data_size;
+		}
+		fdp->inline_len = pos;
+
+		res = set_name(dirh, fdp, po, overwrite);
+		goto out;
+	}
+
 	res = tee_fs_dirfile_get_tmp(dirh, &dfh);
 	if (res)
 		goto out;
@@ -728,31 +1574,31 @@ static TEE_Result ree_fs_create(struct tee_pobj *po, bool overwrite,
 	}
 
 	fdp = (struct tee_fs_fd *)*fh;
-	res = tee_fs_htree_sync_to_storage(&fdp->ht, fdp->dfh.hash);
+	res = ree_fs_sync_to_storage(fdp);
 	if (res)
 		goto out;
 
 	res = set_name(dirh, fdp, po, overwrite);
 out:
 	if (res) {
-		put_dirh(dirh, true);
 		if (*fh) {
 			ree_fs_close_primitive(*fh);
 			*fh = NULL;
-			tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, &dfh);
+			if (!is_inline)
+				tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, &dfh);
 		}
+		put_dirh(dirh, true);
 	}
 	mutex_unlock(&ree_fs_mutex);
 
 	return res;
 }
 
-static TEE_Result ree_fs_write(struct tee_file_handle *fh, size_t pos,
-			       const void *buf, size_t len)
+/* Records the new hash of a file in the dirfile, called with fdp->mu held */
+static TEE_Result update_dirh_hash(struct tee_fs_fd *fdp)
 {
 	TEE_Result res;
 	struct tee_fs_dirfile_dirh *dirh = NULL;
-	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
 
 	mutex_lock(&ree_fs_mutex);
 
@@ -760,22 +1606,162 @@ static TEE_Result ree_fs_write(struct tee_file_handle *fh, size_t pos,
 	if (res)
 		goto out;
 
-	res = ree_fs_write_primitive(fh, pos, buf, len);
+	res = tee_fs_dirfile_update_hash(dirh, &fdp->dfh);
 	if (res)
 		goto out;
+	res = flush_dirh_writes(dirh);
+out:
+	put_dirh(dirh, res);
+	mutex_unlock(&ree_fs_mutex);
+
+	return res;
+}
 
-	res = tee_fs_htree_sync_to_storage(&fdp->ht, fdp->dfh.hash);
+static bool inline_fits(size_t pos, size_t len)
+{
+	size_t end = 0;
+
+	return !ADD_OVERFLOW(pos, len, &end) && end <= CFG_REE_FS_INLINE_SIZE;
+}
+
+/*
+ * Replaces the content of an inline object with the first @new_len bytes
+ * of the current content, zero extended, overwritten with @buf at @pos if
+ * @buf isn't NULL. Called with fdp->mu held.
+ */
+static TEE_Result inline_update(struct tee_fs_fd *fdp, size_t pos,
+				const void *buf, size_t len, size_t new_len)
+{
+	TEE_Result res;
+	struct tee_fs_dirfile_dirh *dirh = NULL;
+	uint8_t *data = calloc(1, CFG_REE_FS_INLINE_SIZE);
+
+	if (!data)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	memcpy(data, fdp->inline_data, MIN(fdp->inline_len, new_len));
+	if (buf)
+		memcpy(data + pos, buf, len);
+
+	mutex_lock(&ree_fs_mutex);
+
+	res = get_dirh(&dirh);
 	if (res)
 		goto out;
 
-	res = tee_fs_dirfile_update_hash(dirh, &fdp->dfh);
+	res = tee_fs_dirfile_update_inline(dirh, &fdp->dfh, data, new_len);
 	if (res)
 		goto out;
-	res = commit_dirh_writes(dirh);
+	res = flush_dirh_writes(dirh);
 out:
 	put_dirh(dirh, res);
 	mutex_unlock(&ree_fs_mutex);
 
+	if (!res) {
+		free_wipe(fdp->inline_data);
+		fdp->inline_data = data;
+		fdp->inline_len = new_len;
+	} else {
+		free_wipe(data);
+	}
+
+	return res;
+}
+
+/*
+ * Moves the content of an inline object which has outgrown its dirfile
+ * entry to a file of its own. Called with fdp->mu held.
+ */
+static TEE_Result inline_to_file(struct tee_fs_fd *fdp)
+{
+	TEE_Result res;
+	struct tee_fs_dirfile_dirh *dirh = NULL;
+	struct tee_fs_dirfile_fileh old_dfh = fdp->dfh;
+
+	mutex_lock(&ree_fs_mutex);
+
+	res = get_dirh(&dirh);
+	if (res)
+		goto out;
+
+	res = tee_fs_dirfile_get_tmp(dirh, &fdp->dfh);
+	if (res)
+		goto out;
+
+	res = fd_open_htree(fdp, true, fdp->dfh.hash, &fdp->uuid, &fdp->dfh);
+	if (res)
+		goto err_remove;
+
+	res = ree_fs_write_primitive((struct tee_file_handle *)fdp, 0,
+				     fdp->inline_data, fdp->inline_len);
+	if (res)
+		goto err_close;
+	res = ree_fs_sync_to_storage(fdp);
+	if (res)
+		goto err_close;
+
+	res = tee_fs_dirfile_update_hash(dirh, &fdp->dfh);
+	if (res)
+		goto err_close;
+	res = flush_dirh_writes(dirh);
+	if (res)
+		goto err_close;
+
+	fdp->dfh.is_inline = false;
+	free_wipe(fdp->inline_data);
+	fdp->inline_data = NULL;
+	fdp->inline_len = 0;
+	goto out;
+
+err_close:
+	bcache_free(fdp);
+	tee_fs_htree_close(&fdp->ht);
+	tee_fs_rpc_close(OPTEE_RPC_CMD_FS, fdp->fd);
+	fdp->fd = -1;
+err_remove:
+	tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, &fdp->dfh);
+	tee_fs_dirfile_release_file(dirh, fdp->dfh.file_number);
+	fdp->dfh = old_dfh;
+out:
+	put_dirh(dirh, res);
+	mutex_unlock(&ree_fs_mutex);
+
+	return res;
+}
+
+static TEE_Result ree_fs_write(struct tee_file_handle *fh, size_t pos,
+			       const void *buf, size_t len)
+{
+	TEE_Result res;
+	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
+
+	mutex_lock(&fdp->mu);
+
+	if (fdp->inline_data) {
+		if (inline_fits(pos, len)) {
+			size_t new_len = fdp->inline_len;
+
+			if (len)
+				new_len = MAX(new_len, pos + len);
+			res = inline_update(fdp, pos, buf, len, new_len);
+			goto out;
+		}
+		res = inline_to_file(fdp);
+		if (res)
+			goto out;
+	}
+
+	res = ree_fs_write_primitive(fh, pos, buf, len);
+	if (res)
+		goto out;
+
+	res = ree_fs_sync_to_storage(fdp);
+	if (res)
+		goto out;
+
+	res = update_dirh_hash(fdp);
+out:
+	mutex_unlock(&fdp->mu);
+
 	return res;
 }
 
@@ -816,14 +1802,16 @@ static TEE_Result ree_fs_rename(struct tee_pobj *old, struct tee_pobj *new,
 		res = tee_fs_dirfile_remove(dirh, &remove_dfh);
 		if (res)
 			goto out;
-	}
 
-	res = commit_dirh_writes(dirh);
-	if (res)
-		goto out;
-
-	if (remove_dfh.idx != -1)
-		tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, &remove_dfh);
+		if (remove_dfh.is_inline) {
+			res = batch_dirh_writes(dirh, NULL, NULL);
+		} else {
+			closed_fd_forget(&remove_dfh);
+			res = batch_dirh_writes(dirh, NULL, &remove_dfh);
+		}
+	} else {
+		res = batch_dirh_writes(dirh, NULL, NULL);
+	}
 
 out:
 	put_dirh(dirh, res);
@@ -853,12 +1841,15 @@ static TEE_Result ree_fs_remove(struct tee_pobj *po)
 	if (res)
 		goto out;
 
-	res = commit_dirh_writes(dirh);
+	if (dfh.is_inline) {
+		res = batch_dirh_writes(dirh, NULL, NULL);
+	} else {
+		closed_fd_forget(&dfh);
+		res = batch_dirh_writes(dirh, NULL, &dfh);
+	}
 	if (res)
 		goto out;
 
-	tee_fs_rpc_remove_dfh(OPTEE_RPC_CMD_FS, &dfh);
-
 	assert(tee_fs_dirfile_find(dirh, &po->uuid, po->obj_id, po->obj_id_len,
 				   &dfh));
 out:
@@ -871,30 +1862,31 @@ out:
 static TEE_Result ree_fs_truncate(struct tee_file_handle *fh, size_t len)
 {
 	TEE_Result res;
-	struct tee_fs_dirfile_dirh *dirh = NULL;
 	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
 
-	mutex_lock(&ree_fs_mutex);
+	mutex_lock(&fdp->mu);
 
-	res = get_dirh(&dirh);
-	if (res)
-		goto out;
+	if (fdp->inline_data) {
+		if (len <= CFG_REE_FS_INLINE_SIZE) {
+			res = inline_update(fdp, 0, NULL, 0, len);
+			goto out;
+		}
+		res = inline_to_file(fdp);
+		if (res)
+			goto out;
+	}
 
 	res = ree_fs_ftruncate_internal(fdp, len);
 	if (res)
 		goto out;
 
-	res = tee_fs_htree_sync_to_storage(&fdp->ht, fdp->dfh.hash);
+	res = ree_fs_sync_to_storage(fdp);
 	if (res)
 		goto out;
 
-	res = tee_fs_dirfile_update_hash(dirh, &fdp->dfh);
-	if (res)
-		goto out;
-	res = commit_dirh_writes(dirh);
+	res = update_dirh_hash(fdp);
 out:
-	put_dirh(dirh, res);
-	mutex_unlock(&ree_fs_mutex);
+	mutex_unlock(&fdp->mu);
 
 	return res;
 }
@@ -967,6 +1959,41 @@ static TEE_Result ree_fs_readdir_rpc(struct tee_fs_dir *d,
 	return res;
 }
 
+/*
+ * A transaction holds a reference to the dirfile so deferred changes
+ * aren't dropped with it. Transactions aren't tracked separately, the
+ * changes of all of them are committed when the last one ends.
+ */
+static TEE_Result ree_fs_begin_transaction(void)
+{
+	TEE_Result res;
+	struct tee_fs_dirfile_dirh *dirh = NULL;
+
+	mutex_lock(&ree_fs_mutex);
+	res = get_dirh(&dirh);
+	if (!res)
+		dirh_txn_count++;
+	mutex_unlock(&ree_fs_mutex);
+
+	return res;
+}
+
+static TEE_Result ree_fs_end_transaction(void)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	mutex_lock(&ree_fs_mutex);
+	assert(dirh_txn_count);
+	dirh_txn_count--;
+	/* ree_fs_dirh is NULL if an error dropped it during the transaction */
+	if (!dirh_txn_count && ree_fs_dirh && dirh_pending_ops)
+		res = flush_dirh_writes(ree_fs_dirh);
+	put_dirh_primitive(res);
+	mutex_unlock(&ree_fs_mutex);
+
+	return res;
+}
+
 const struct tee_file_operations ree_fs_ops = {
 	.open = ree_fs_open,
 	.create = ree_fs_create,
@@ -979,4 +2006,6 @@ const struct tee_file_operations ree_fs_ops = {
 	.opendir = ree_fs_opendir_rpc,
 	.closedir = ree_fs_closedir_rpc,
 	.readdir = ree_fs_readdir_rpc,
+	.begin_transaction = ree_fs_begin_transaction,
+	.end_transaction = ree_fs_end_transaction,
 };
@@ -4,6 +4,7 @@
  */
 
 #include <assert.h>
+#include <config.h>
 #include <crypto/crypto.h>
 #include <kernel/huk_subkey.h>
 #include <kernel/misc.h>
@@ -76,6 +77,10 @@ struct rpmb_file_handle {
 	char filename[TEE_RPMB_FS_FILENAME_LENGTH];
 	/* Address for current entry in RPMB */
 	uint32_t rpmb_fat_address;
+	/* Key material of the file data, kept while the file is open */
+	struct tee_fs_fek_cache fek_cache;
+	/* Writes may be buffered, see CFG_RPMB_FS_WRITE_BACK_SIZE */
+	bool write_back;
 };
 
 /**
@@ -192,6 +197,8 @@ struct rpmb_raw_data {
 	uint32_t len;
 	/* Byte address offset in the first block involved */
 	uint8_t byte_offset;
+	/* HMAC context to verify the response with, rpmb_mac_ctx if NULL */
+	void *mac_ctx;
 };
 
 #define RPMB_EMMC_CID_SIZE 16
@@ -327,43 +334,96 @@ static void get_op_result_bits(uint8_t *bytes, uint8_t *res)
 	*res = *(bytes + 1) & RPMB_RESULT_MASK;
 }
 
-static TEE_Result tee_rpmb_mac_calc(uint8_t *mac, uint32_t macsize,
-				    uint8_t *key, uint32_t keysize,
-				    struct rpmb_data_frame *datafrms,
+/*
+ * HMAC-SHA256 keyed with the RPMB key. rpmb_mac_key_ctx holds the state
+ * right after the key has been set up and is copied into rpmb_mac_ctx
+ * when a MAC is started, so neither a context allocation nor the key
+ * processing is repeated for each RPMB operation. Both are protected by
+ * rpmb_mutex.
+ *
+ * Data read responses are verified once rpmb_mutex is released, each
+ * thread uses its own context from rpmb_read_mac_ctx for that. The key
+ * is only set once so rpmb_mac_key_ctx doesn't change while it's copied
+ * without the mutex held.
+ */
+static void *rpmb_mac_key_ctx;
+static void *rpmb_mac_ctx;
+static void *rpmb_read_mac_ctx[CFG_NUM_THREADS];
+
+static TEE_Result tee_rpmb_mac_set_key(const uint8_t *key, size_t keysize)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (!rpmb_mac_key_ctx) {
+		res = crypto_mac_alloc_ctx(&rpmb_mac_key_ctx,
+					   TEE_ALG_HMAC_SHA256);
+		if (res)
+			return res;
+	}
+
+	if (!rpmb_mac_ctx) {
+		res = crypto_mac_alloc_ctx(&rpmb_mac_ctx, TEE_ALG_HMAC_SHA256);
+		if (res)
+			return res;
+	}
+
+	return crypto_mac_init(rpmb_mac_key_ctx, TEE_ALG_HMAC_SHA256, key,
+			       keysize);
+}
+
+/* Called with rpmb_mutex held, once the key is set */
+static TEE_Result tee_rpmb_get_read_mac_ctx(void **ctx)
+{
+	void **c = rpmb_read_mac_ctx + thread_get_id();
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!*c) {
+		res = crypto_mac_alloc_ctx(c, TEE_ALG_HMAC_SHA256);
+		if (res)
+			return res;
+	}
+
+	*ctx = *c;
+	return TEE_SUCCESS;
+}
+
+static void tee_rpmb_mac_begin(void *ctx)
+{
+	crypto_mac_copy_state(ctx, rpmb_mac_key_ctx, TEE_ALG_HMAC_SHA256);
+}
+
+static TEE_Result tee_rpmb_mac_update(void *ctx,
+				      const struct rpmb_data_frame *frm)
+{
+	return crypto_mac_update(ctx, TEE_ALG_HMAC_SHA256, frm->data,
+				 RPMB_MAC_PROTECT_DATA_SIZE);
+}
+
+static TEE_Result tee_rpmb_mac_final(void *ctx, uint8_t *mac)
+{
+	return crypto_mac_final(ctx, TEE_ALG_HMAC_SHA256, mac,
+				RPMB_KEY_MAC_SIZE);
+}
+
+static TEE_Result tee_rpmb_mac_calc(void *ctx, uint8_t *mac,
+				    const struct rpmb_data_frame *datafrms,
 				    uint16_t blkcnt)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
 	int i;
-	void *ctx = NULL;
 
-	if (!mac || !key || !datafrms)
+	if (!mac || !datafrms)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	res = crypto_mac_alloc_ctx(&ctx, TEE_ALG_HMAC_SHA256);
-	if (res)
-		return res;
-
-	res = crypto_mac_init(ctx, TEE_ALG_HMAC_SHA256, key, keysize);
-	if (res != TEE_SUCCESS)
-		goto func_exit;
+	tee_rpmb_mac_begin(ctx);
 
 	for (i = 0; i < blkcnt; i++) {
-		res = crypto_mac_update(ctx, TEE_ALG_HMAC_SHA256,
-					datafrms[i].data,
-					RPMB_MAC_PROTECT_DATA_SIZE);
+		res = tee_rpmb_mac_update(ctx, datafrms + i);
 		if (res != TEE_SUCCESS)
-			goto func_exit;
+			return res;
 	}
 
-	res = crypto_mac_final(ctx, TEE_ALG_HMAC_SHA256, mac, macsize);
-	if (res != TEE_SUCCESS)
-		goto func_exit;
-
-	res = TEE_SUCCESS;
-
-func_exit:
-	crypto_mac_free_ctx(ctx, TEE_ALG_HMAC_SHA256);
-	return res;
+	return tee_rpmb_mac_final(ctx, mac);
 }
 
 struct tee_rpmb_mem {
@@ -449,17 +509,19 @@ static bool is_zero(const uint8_t *buf, size_t size)
 
 static TEE_Result encrypt_block(uint8_t *out, const uint8_t *in,
 				uint16_t blk_idx, const uint8_t *fek,
-				const TEE_UUID *uuid)
+				const TEE_UUID *uuid,
+				struct tee_fs_fek_cache *fc)
 {
-	return tee_fs_crypt_block(uuid, out, in, RPMB_DATA_SIZE,
+	return tee_fs_crypt_block(fc, uuid, out, in, RPMB_DATA_SIZE,
 				  blk_idx, fek, TEE_MODE_ENCRYPT);
 }
 
 static TEE_Result decrypt_block(uint8_t *out, const uint8_t *in,
 				uint16_t blk_idx, const uint8_t *fek,
-				const TEE_UUID *uuid)
+				const TEE_UUID *uuid,
+				struct tee_fs_fek_cache *fc)
 {
-	return tee_fs_crypt_block(uuid, out, in, RPMB_DATA_SIZE,
+	return tee_fs_crypt_block(fc, uuid, out, in, RPMB_DATA_SIZE,
 				  blk_idx, fek, TEE_MODE_DECRYPT);
 }
 
@@ -467,7 +529,8 @@ static TEE_Result decrypt_block(uint8_t *out, const uint8_t *in,
 static TEE_Result decrypt(uint8_t *out, const struct rpmb_data_frame *frm,
 			  size_t size, size_t offset,
 			  uint16_t blk_idx __maybe_unused, const uint8_t *fek,
-			  const TEE_UUID *uuid)
+			  const TEE_UUID *uuid,
+			  struct tee_fs_fek_cache *fc)
 {
 	uint8_t *tmp __maybe_unused;
 
@@ -491,11 +554,11 @@ static TEE_Result decrypt(uint8_t *out, const struct rpmb_data_frame *frm,
 			tmp = malloc(RPMB_DATA_SIZE);
 			if (!tmp)
 				return TEE_ERROR_OUT_OF_MEMORY;
-			decrypt_block(tmp, frm->data, blk_idx, fek, uuid);
+			decrypt_block(tmp, frm->data, blk_idx, fek, uuid, fc);
 			memcpy(out, tmp + offset, size);
 			free(tmp);
 		} else {
-			decrypt_block(out, frm->data, blk_idx, fek, uuid);
+			decrypt_block(out, frm->data, blk_idx, fek, uuid, fc);
 		}
 	}
 
@@ -505,11 +568,14 @@ static TEE_Result decrypt(uint8_t *out, const struct rpmb_data_frame *frm,
 static TEE_Result tee_rpmb_req_pack(struct rpmb_req *req,
 				    struct rpmb_raw_data *rawdata,
 				    uint16_t nbr_frms, uint16_t dev_id,
-				    const uint8_t *fek, const TEE_UUID *uuid)
+				    const uint8_t *fek, const TEE_UUID *uuid,
+				    struct tee_fs_fek_cache *fc)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
+	struct rpmb_data_frame *reqfrm = NULL;
+	struct rpmb_data_frame localfrm;
+	bool write_mac = false;
 	int i;
-	struct rpmb_data_frame *datafrm;
 
 	if (!req || !rawdata || !nbr_frms)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -525,85 +591,96 @@ static TEE_Result tee_rpmb_req_pack(struct rpmb_req *req,
 		return TEE_ERROR_GENERIC;
 	}
 
+	/* Check the block index is within range. */
+	if (rawdata->blk_idx &&
+	    (*rawdata->blk_idx + nbr_frms) > rpmb_ctx->max_blk_idx)
+		return TEE_ERROR_GENERIC;
+
 	req->cmd = RPMB_CMD_DATA_REQ;
 	req->dev_id = dev_id;
+	reqfrm = TEE_RPMB_REQ_DATA(req);
 
-	/* Allocate memory for construct all data packets and calculate MAC. */
-	datafrm = calloc(nbr_frms, RPMB_DATA_FRAME_SIZE);
-	if (!datafrm)
-		return TEE_ERROR_OUT_OF_MEMORY;
+	write_mac = rawdata->key_mac &&
+		    rawdata->msg_type == RPMB_MSG_TYPE_REQ_AUTH_DATA_WRITE;
+	if (write_mac)
+		tee_rpmb_mac_begin(rpmb_mac_ctx);
 
+	/*
+	 * Each frame is built and MACed in secure memory before it's
+	 * copied to the request, while the data is still in the cache.
+	 * The request itself lives in non-secure memory and can be
+	 * modified before it reaches the device, but that would only
+	 * make the MAC check of the device fail.
+	 */
 	for (i = 0; i < nbr_frms; i++) {
-		u16_to_bytes(rawdata->msg_type, datafrm[i].msg_type);
+		memset(&localfrm, 0, sizeof(localfrm));
+		u16_to_bytes(rawdata->msg_type, localfrm.msg_type);
 
 		if (rawdata->block_count)
 			u16_to_bytes(*rawdata->block_count,
-				     datafrm[i].block_count);
-
-		if (rawdata->blk_idx) {
-			/* Check the block index is within range. */
-			if ((*rawdata->blk_idx + nbr_frms) >
-			    rpmb_ctx->max_blk_idx) {
-				res = TEE_ERROR_GENERIC;
-				goto func_exit;
-			}
-			u16_to_bytes(*rawdata->blk_idx, datafrm[i].address);
-		}
+				     localfrm.block_count);
+
+		if (rawdata->blk_idx)
+			u16_to_bytes(*rawdata->blk_idx, localfrm.address);
 
 		if (rawdata->write_counter)
 			u32_to_bytes(*rawdata->write_counter,
-				     datafrm[i].write_counter);
+				     localfrm.write_counter);
 
 		if (rawdata->nonce)
-			memcpy(datafrm[i].nonce, rawdata->nonce,
+			memcpy(localfrm.nonce, rawdata->nonce,
 			       RPMB_NONCE_SIZE);
 
 		if (rawdata->data) {
-			if (fek)
-				encrypt_block(datafrm[i].data,
+			if (fek) {
+				res = encrypt_block(localfrm.data,
 					rawdata->data + (i * RPMB_DATA_SIZE),
-					*rawdata->blk_idx + i, fek, uuid);
-			else
-				memcpy(datafrm[i].data,
+					*rawdata->blk_idx + i, fek, uuid, fc);
+				if (res)
+					return res;
+			} else {
+				memcpy(localfrm.data,
 				       rawdata->data + (i * RPMB_DATA_SIZE),
 				       RPMB_DATA_SIZE);
+			}
 		}
-	}
 
-	if (rawdata->key_mac) {
-		if (rawdata->msg_type == RPMB_MSG_TYPE_REQ_AUTH_DATA_WRITE) {
-			res =
-			    tee_rpmb_mac_calc(rawdata->key_mac,
-					      RPMB_KEY_MAC_SIZE, rpmb_ctx->key,
-					      RPMB_KEY_MAC_SIZE, datafrm,
-					      nbr_frms);
-			if (res != TEE_SUCCESS)
-				goto func_exit;
+		if (write_mac) {
+			res = tee_rpmb_mac_update(rpmb_mac_ctx, &localfrm);
+			if (res)
+				return res;
+		}
+
+		if (i == nbr_frms - 1 && rawdata->key_mac) {
+			if (write_mac) {
+				res = tee_rpmb_mac_final(rpmb_mac_ctx,
+							 rawdata->key_mac);
+				if (res)
+					return res;
+			}
+			memcpy(localfrm.key_mac, rawdata->key_mac,
+			       RPMB_KEY_MAC_SIZE);
 		}
-		memcpy(datafrm[nbr_frms - 1].key_mac,
-		       rawdata->key_mac, RPMB_KEY_MAC_SIZE);
-	}
 
-	memcpy(TEE_RPMB_REQ_DATA(req), datafrm,
-	       nbr_frms * RPMB_DATA_FRAME_SIZE);
+		memcpy(reqfrm + i, &localfrm, RPMB_DATA_FRAME_SIZE);
+	}
 
 #ifdef CFG_RPMB_FS_DEBUG_DATA
 	for (i = 0; i < nbr_frms; i++) {
 		DMSG("Dumping data frame %d:", i);
-		DHEXDUMP((uint8_t *)&datafrm[i] + RPMB_STUFF_DATA_SIZE,
+		DHEXDUMP((uint8_t *)&reqfrm[i] + RPMB_STUFF_DATA_SIZE,
 			 512 - RPMB_STUFF_DATA_SIZE);
 	}
 #endif
 
-	res = TEE_SUCCESS;
-func_exit:
-	free(datafrm);
-	return res;
+	return TEE_SUCCESS;
 }
 
-static TEE_Result data_cpy_mac_calc_1b(struct rpmb_raw_data *rawdata,
+static TEE_Result data_cpy_mac_calc_1b(void *mac_ctx,
+				       struct rpmb_raw_data *rawdata,
 				       struct rpmb_data_frame *frm,
-				       const uint8_t *fek, const TEE_UUID *uuid)
+				       const uint8_t *fek, const TEE_UUID *uuid,
+				       struct tee_fs_fek_cache *fc)
 {
 	TEE_Result res;
 	uint8_t *data;
@@ -612,8 +689,7 @@ static TEE_Result data_cpy_mac_calc_1b(struct rpmb_raw_data *rawdata,
 	if (rawdata->len + rawdata->byte_offset > RPMB_DATA_SIZE)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	res = tee_rpmb_mac_calc(rawdata->key_mac, RPMB_KEY_MAC_SIZE,
-				rpmb_ctx->key, RPMB_KEY_MAC_SIZE, frm, 1);
+	res = tee_rpmb_mac_calc(mac_ctx, rawdata->key_mac, frm, 1);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -621,20 +697,21 @@ static TEE_Result data_cpy_mac_calc_1b(struct rpmb_raw_data *rawdata,
 	bytes_to_u16(frm->address, &idx);
 
 	res = decrypt(data, frm, rawdata->len, rawdata->byte_offset, idx, fek,
-		      uuid);
+		      uuid, fc);
 	return res;
 }
 
-static TEE_Result tee_rpmb_data_cpy_mac_calc(struct rpmb_data_frame *datafrm,
+static TEE_Result tee_rpmb_data_cpy_mac_calc(void *mac_ctx,
+					     struct rpmb_data_frame *datafrm,
 					     struct rpmb_raw_data *rawdata,
 					     uint16_t nbr_frms,
 					     struct rpmb_data_frame *lastfrm,
 					     const uint8_t *fek,
-					     const TEE_UUID *uuid)
+					     const TEE_UUID *uuid,
+					     struct tee_fs_fek_cache *fc)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
 	int i;
-	void *ctx = NULL;
 	uint16_t offset;
 	uint32_t size;
 	uint8_t *data;
@@ -645,20 +722,14 @@ static TEE_Result tee_rpmb_data_cpy_mac_calc(struct rpmb_data_frame *datafrm,
 		return TEE_ERROR_BAD_PARAMETERS;
 
 	if (nbr_frms == 1)
-		return data_cpy_mac_calc_1b(rawdata, lastfrm, fek, uuid);
+		return data_cpy_mac_calc_1b(mac_ctx, rawdata, lastfrm, fek,
+					    uuid, fc);
 
 	/* nbr_frms > 1 */
 
 	data = rawdata->data;
 
-	res = crypto_mac_alloc_ctx(&ctx, TEE_ALG_HMAC_SHA256);
-	if (res)
-		goto func_exit;
-
-	res = crypto_mac_init(ctx, TEE_ALG_HMAC_SHA256, rpmb_ctx->key,
-			      RPMB_KEY_MAC_SIZE);
-	if (res != TEE_SUCCESS)
-		goto func_exit;
+	tee_rpmb_mac_begin(mac_ctx);
 
 	/*
 	 * Note: JEDEC JESD84-B51: "In every packet the address is the start
@@ -676,10 +747,9 @@ static TEE_Result tee_rpmb_data_cpy_mac_calc(struct rpmb_data_frame *datafrm,
 		 */
 		memcpy(&localfrm, &datafrm[i], RPMB_DATA_FRAME_SIZE);
 
-		res = crypto_mac_update(ctx, TEE_ALG_HMAC_SHA256, localfrm.data,
-					RPMB_MAC_PROTECT_DATA_SIZE);
+		res = tee_rpmb_mac_update(mac_ctx, &localfrm);
 		if (res != TEE_SUCCESS)
-			goto func_exit;
+			return res;
 
 		if (i == 0) {
 			/* First block */
@@ -692,9 +762,9 @@ static TEE_Result tee_rpmb_data_cpy_mac_calc(struct rpmb_data_frame *datafrm,
 		}
 
 		res = decrypt(data, &localfrm, size, offset, start_idx + i,
-			      fek, uuid);
+			      fek, uuid, fc);
 		if (res != TEE_SUCCESS)
-			goto func_exit;
+			return res;
 
 		data += size;
 	}
@@ -704,33 +774,24 @@ static TEE_Result tee_rpmb_data_cpy_mac_calc(struct rpmb_data_frame *datafrm,
 	if (size == 0)
 		size = RPMB_DATA_SIZE;
 	res = decrypt(data, lastfrm, size, 0, start_idx + nbr_frms - 1, fek,
-		      uuid);
+		      uuid, fc);
 	if (res != TEE_SUCCESS)
-		goto func_exit;
+		return res;
 
 	/* Update MAC against the last block */
-	res = crypto_mac_update(ctx, TEE_ALG_HMAC_SHA256, lastfrm->data,
-				RPMB_MAC_PROTECT_DATA_SIZE);
+	res = tee_rpmb_mac_update(mac_ctx, lastfrm);
 	if (res != TEE_SUCCESS)
-		goto func_exit;
-
-	res = crypto_mac_final(ctx, TEE_ALG_HMAC_SHA256, rawdata->key_mac,
-			       RPMB_KEY_MAC_SIZE);
-	if (res != TEE_SUCCESS)
-		goto func_exit;
-
-	res = TEE_SUCCESS;
+		return res;
 
-func_exit:
-	crypto_mac_free_ctx(ctx, TEE_ALG_HMAC_SHA256);
-	return res;
+	return tee_rpmb_mac_final(mac_ctx, rawdata->key_mac);
 }
 
 static TEE_Result tee_rpmb_resp_unpack_verify(struct rpmb_data_frame *datafrm,
 					      struct rpmb_raw_data *rawdata,
 					      uint16_t nbr_frms,
 					      const uint8_t *fek,
-					      const TEE_UUID *uuid)
+					      const TEE_UUID *uuid,
+					      struct tee_fs_fek_cache *fc)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
 	uint16_t msg_type;
@@ -738,10 +799,15 @@ static TEE_Result tee_rpmb_resp_unpack_verify(struct rpmb_data_frame *datafrm,
 	uint16_t blk_idx;
 	uint8_t op_result;
 	struct rpmb_data_frame lastfrm;
+	void *mac_ctx = NULL;
 
 	if (!datafrm || !rawdata || !nbr_frms)
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	mac_ctx = rawdata->mac_ctx;
+	if (!mac_ctx)
+		mac_ctx = rpmb_mac_ctx;
+
 #ifdef CFG_RPMB_FS_DEBUG_DATA
 	for (uint32_t i = 0; i < nbr_frms; i++) {
 		DMSG("Dumping data frame %d:", i);
@@ -803,9 +869,10 @@ static TEE_Result tee_rpmb_resp_unpack_verify(struct rpmb_data_frame *datafrm,
 			if (!rawdata->data)
 				return TEE_ERROR_GENERIC;
 
-			res = tee_rpmb_data_cpy_mac_calc(datafrm, rawdata,
-							 nbr_frms, &lastfrm,
-							 fek, uuid);
+			res = tee_rpmb_data_cpy_mac_calc(mac_ctx, datafrm,
+							 rawdata, nbr_frms,
+							 &lastfrm, fek, uuid,
+							 fc);
 
 			if (res != TEE_SUCCESS)
 				return res;
@@ -817,10 +884,7 @@ static TEE_Result tee_rpmb_resp_unpack_verify(struct rpmb_data_frame *datafrm,
 			if (nbr_frms != 1)
 				return TEE_ERROR_GENERIC;
 
-			res = tee_rpmb_mac_calc(rawdata->key_mac,
-						RPMB_KEY_MAC_SIZE,
-						rpmb_ctx->key,
-						RPMB_KEY_MAC_SIZE,
+			res = tee_rpmb_mac_calc(mac_ctx, rawdata->key_mac,
 						&lastfrm, 1);
 
 			if (res != TEE_SUCCESS)
@@ -928,7 +992,7 @@ static TEE_Result tee_rpmb_init_read_wr_cnt(uint16_t dev_id,
 	rawdata.msg_type = msg_type;
 	rawdata.nonce = nonce;
 
-	res = tee_rpmb_req_pack(req, &rawdata, 1, dev_id, NULL, NULL);
+	res = tee_rpmb_req_pack(req, &rawdata, 1, dev_id, NULL, NULL, NULL);
 	if (res != TEE_SUCCESS)
 		goto func_exit;
 
@@ -945,7 +1009,7 @@ static TEE_Result tee_rpmb_init_read_wr_cnt(uint16_t dev_id,
 	rawdata.nonce = nonce;
 	rawdata.key_mac = hmac;
 
-	res = tee_rpmb_resp_unpack_verify(resp, &rawdata, 1, NULL, NULL);
+	res = tee_rpmb_resp_unpack_verify(resp, &rawdata, 1, NULL, NULL, NULL);
 	if (res != TEE_SUCCESS)
 		goto func_exit;
 
@@ -997,7 +1061,7 @@ static TEE_Result tee_rpmb_write_key(uint16_t dev_id)
 	rawdata.msg_type = msg_type;
 	rawdata.key_mac = rpmb_ctx->key;
 
-	res = tee_rpmb_req_pack(req, &rawdata, 1, dev_id, NULL, NULL);
+	res = tee_rpmb_req_pack(req, &rawdata, 1, dev_id, NULL, NULL, NULL);
 	if (res != TEE_SUCCESS)
 		goto func_exit;
 
@@ -1010,7 +1074,7 @@ static TEE_Result tee_rpmb_write_key(uint16_t dev_id)
 	memset(&rawdata, 0x00, sizeof(struct rpmb_raw_data));
 	rawdata.msg_type = msg_type;
 
-	res = tee_rpmb_resp_unpack_verify(resp, &rawdata, 1, NULL, NULL);
+	res = tee_rpmb_resp_unpack_verify(resp, &rawdata, 1, NULL, NULL, NULL);
 	if (res != TEE_SUCCESS)
 		goto func_exit;
 
@@ -1087,11 +1151,15 @@ static TEE_Result tee_rpmb_init(uint16_t dev_id)
 
 		memcpy(rpmb_ctx->cid, dev_info.cid, RPMB_EMMC_CID_SIZE);
 
-#ifdef RPMB_DRIVER_MULTIPLE_WRITE_FIXED
-		rpmb_ctx->rel_wr_blkcnt = dev_info.rel_wr_sec_c * 2;
-#else
-		rpmb_ctx->rel_wr_blkcnt = 1;
-#endif
+		/*
+		 * The reliable write sector count is in units of 512 byte
+		 * sectors, each carrying two RPMB data frames.
+		 */
+		if (IS_ENABLED(CFG_RPMB_DRIVER_MULTIPLE_WRITE_FIXED) &&
+		    dev_info.rel_wr_sec_c)
+			rpmb_ctx->rel_wr_blkcnt = dev_info.rel_wr_sec_c * 2;
+		else
+			rpmb_ctx->rel_wr_blkcnt = 1;
 
 		rpmb_ctx->dev_info_synced = true;
 	}
@@ -1107,6 +1175,10 @@ static TEE_Result tee_rpmb_init(uint16_t dev_id)
 			goto func_exit;
 		}
 
+		res = tee_rpmb_mac_set_key(rpmb_ctx->key, RPMB_KEY_MAC_SIZE);
+		if (res != TEE_SUCCESS)
+			goto func_exit;
+
 		rpmb_ctx->key_derived = true;
 	}
 
@@ -1133,104 +1205,161 @@ func_exit:
 }
 
 /*
- * Read RPMB data in bytes.
+ * State of a data read between the request to the device, done with
+ * rpmb_mutex held, and the verification of the response which doesn't
+ * need it.
+ */
+struct rpmb_read_req {
+	struct tee_rpmb_mem mem;
+	struct rpmb_data_frame *resp;
+	void *mac_ctx;
+	uint8_t nonce[RPMB_NONCE_SIZE];
+	uint16_t blk_idx;
+	uint16_t blkcnt;
+	uint8_t byte_offset;
+};
+
+/*
+ * Request RPMB data, must be called with rpmb_mutex held. On success
+ * tee_rpmb_read_finish() must be called.
  *
  * @dev_id     Device ID of the eMMC device.
  * @addr       Byte address of data.
- * @data       Pointer to the data.
  * @len        Size of data in bytes.
- * @fek        Encrypted File Encryption Key or NULL.
+ * @rr         Read request state.
  */
-static TEE_Result tee_rpmb_read(uint16_t dev_id, uint32_t addr, uint8_t *data,
-				uint32_t len, const uint8_t *fek,
-				const TEE_UUID *uuid)
+static TEE_Result tee_rpmb_read_start(uint16_t dev_id, uint32_t addr,
+				      uint32_t len, struct rpmb_read_req *rr)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
-	struct tee_rpmb_mem mem = { 0 };
-	uint16_t msg_type;
-	uint8_t nonce[RPMB_NONCE_SIZE];
-	uint8_t hmac[RPMB_KEY_MAC_SIZE];
 	struct rpmb_req *req = NULL;
-	struct rpmb_data_frame *resp = NULL;
 	struct rpmb_raw_data rawdata;
 	uint32_t req_size;
 	uint32_t resp_size;
-	uint16_t blk_idx;
-	uint16_t blkcnt;
-	uint8_t byte_offset;
 
-	if (!data || !len)
+	memset(rr, 0, sizeof(*rr));
+
+	if (!len)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	blk_idx = addr / RPMB_DATA_SIZE;
-	byte_offset = addr % RPMB_DATA_SIZE;
+	rr->blk_idx = addr / RPMB_DATA_SIZE;
+	rr->byte_offset = addr % RPMB_DATA_SIZE;
 
-	if (len + byte_offset + RPMB_DATA_SIZE < RPMB_DATA_SIZE) {
+	if (len + rr->byte_offset + RPMB_DATA_SIZE < RPMB_DATA_SIZE) {
 		/* Overflow */
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
-	blkcnt =
-	    ROUNDUP(len + byte_offset, RPMB_DATA_SIZE) / RPMB_DATA_SIZE;
+	rr->blkcnt =
+	    ROUNDUP(len + rr->byte_offset, RPMB_DATA_SIZE) / RPMB_DATA_SIZE;
 	res = tee_rpmb_init(dev_id);
 	if (res != TEE_SUCCESS)
 		goto func_exit;
 
+	res = tee_rpmb_get_read_mac_ctx(&rr->mac_ctx);
+	if (res != TEE_SUCCESS)
+		goto func_exit;
+
 	req_size = sizeof(struct rpmb_req) + RPMB_DATA_FRAME_SIZE;
-	resp_size = RPMB_DATA_FRAME_SIZE * blkcnt;
-	res = tee_rpmb_alloc(req_size, resp_size, &mem,
-			     (void *)&req, (void *)&resp);
+	resp_size = RPMB_DATA_FRAME_SIZE * rr->blkcnt;
+	res = tee_rpmb_alloc(req_size, resp_size, &rr->mem,
+			     (void *)&req, (void *)&rr->resp);
 	if (res != TEE_SUCCESS)
 		goto func_exit;
 
-	msg_type = RPMB_MSG_TYPE_REQ_AUTH_DATA_READ;
-	res = crypto_rng_read(nonce, RPMB_NONCE_SIZE);
+	res = crypto_rng_read(rr->nonce, RPMB_NONCE_SIZE);
 	if (res != TEE_SUCCESS)
 		goto func_exit;
 
 	memset(&rawdata, 0x00, sizeof(struct rpmb_raw_data));
-	rawdata.msg_type = msg_type;
-	rawdata.nonce = nonce;
-	rawdata.blk_idx = &blk_idx;
-	res = tee_rpmb_req_pack(req, &rawdata, 1, dev_id, NULL, NULL);
+	rawdata.msg_type = RPMB_MSG_TYPE_REQ_AUTH_DATA_READ;
+	rawdata.nonce = rr->nonce;
+	rawdata.blk_idx = &rr->blk_idx;
+	res = tee_rpmb_req_pack(req, &rawdata, 1, dev_id, NULL, NULL, NULL);
 	if (res != TEE_SUCCESS)
 		goto func_exit;
 
-	req->block_count = blkcnt;
+	req->block_count = rr->blkcnt;
 
-	DMSG("Read %u block%s at index %u", blkcnt, ((blkcnt > 1) ? "s" : ""),
-	     blk_idx);
+	DMSG("Read %u block%s at index %u", rr->blkcnt,
+	     ((rr->blkcnt > 1) ? "s" : ""), rr->blk_idx);
 
-	res = tee_rpmb_invoke(&mem);
+	res = tee_rpmb_invoke(&rr->mem);
+
+func_exit:
 	if (res != TEE_SUCCESS)
-		goto func_exit;
+		tee_rpmb_free(&rr->mem);
+	return res;
+}
 
-	msg_type = RPMB_MSG_TYPE_RESP_AUTH_DATA_READ;
+/*
+ * Verify the response to a request from tee_rpmb_read_start() and copy
+ * the data, rpmb_mutex doesn't need to be held.
+ *
+ * @rr         Read request state.
+ * @data       Pointer to the data.
+ * @len        Size of data in bytes, as passed to tee_rpmb_read_start().
+ * @fek        Encrypted File Encryption Key or NULL.
+ */
+static TEE_Result tee_rpmb_read_finish(struct rpmb_read_req *rr,
+				       uint8_t *data, uint32_t len,
+				       const uint8_t *fek,
+				       const TEE_UUID *uuid,
+				       struct tee_fs_fek_cache *fc)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	uint8_t hmac[RPMB_KEY_MAC_SIZE];
+	struct rpmb_raw_data rawdata;
 
 	memset(&rawdata, 0x00, sizeof(struct rpmb_raw_data));
-	rawdata.msg_type = msg_type;
-	rawdata.block_count = &blkcnt;
-	rawdata.blk_idx = &blk_idx;
-	rawdata.nonce = nonce;
+	rawdata.msg_type = RPMB_MSG_TYPE_RESP_AUTH_DATA_READ;
+	rawdata.block_count = &rr->blkcnt;
+	rawdata.blk_idx = &rr->blk_idx;
+	rawdata.nonce = rr->nonce;
 	rawdata.key_mac = hmac;
 	rawdata.data = data;
+	rawdata.mac_ctx = rr->mac_ctx;
 
 	rawdata.len = len;
-	rawdata.byte_offset = byte_offset;
+	rawdata.byte_offset = rr->byte_offset;
 
-	res = tee_rpmb_resp_unpack_verify(resp, &rawdata, blkcnt, fek, uuid);
-	if (res != TEE_SUCCESS)
-		goto func_exit;
-
-	res = TEE_SUCCESS;
+	res = tee_rpmb_resp_unpack_verify(rr->resp, &rawdata, rr->blkcnt, fek,
+					  uuid, fc);
 
-func_exit:
-	tee_rpmb_free(&mem);
+	tee_rpmb_free(&rr->mem);
 	return res;
 }
 
+/*
+ * Read RPMB data in bytes.
+ *
+ * @dev_id     Device ID of the eMMC device.
+ * @addr       Byte address of data.
+ * @data       Pointer to the data.
+ * @len        Size of data in bytes.
+ * @fek        Encrypted File Encryption Key or NULL.
+ */
+static TEE_Result tee_rpmb_read(uint16_t dev_id, uint32_t addr, uint8_t *data,
+				uint32_t len, const uint8_t *fek,
+				const TEE_UUID *uuid,
+				struct tee_fs_fek_cache *fc)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	struct rpmb_read_req rr;
+
+	if (!data || !len)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = tee_rpmb_read_start(dev_id, addr, len, &rr);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	return tee_rpmb_read_finish(&rr, data, len, fek, uuid, fc);
+}
+
 static TEE_Result tee_rpmb_write_blk(uint16_t dev_id, uint16_t blk_idx,
 				     const uint8_t *data_blks, uint16_t blkcnt,
-				     const uint8_t *fek, const TEE_UUID *uuid)
+				     const uint8_t *fek, const TEE_UUID *uuid,
+				     struct tee_fs_fek_cache *fc)
 {
 	TEE_Result res;
 	struct tee_rpmb_mem mem;
@@ -1305,7 +1434,7 @@ static TEE_Result tee_rpmb_write_blk(uint16_t dev_id, uint16_t blk_idx,
 				i * rpmb_ctx->rel_wr_blkcnt * RPMB_DATA_SIZE;
 
 		res = tee_rpmb_req_pack(req, &rawdata, tmp_blkcnt, dev_id,
-					fek, uuid);
+					fek, uuid, fc);
 		if (res != TEE_SUCCESS)
 			goto out;
 
@@ -1329,7 +1458,7 @@ static TEE_Result tee_rpmb_write_blk(uint16_t dev_id, uint16_t blk_idx,
 		rawdata.key_mac = hmac;
 
 		res = tee_rpmb_resp_unpack_verify(resp, &rawdata, 1, NULL,
-						  NULL);
+						  NULL, NULL);
 		if (res != TEE_SUCCESS) {
 			/*
 			 * To force wr_cnt sync next time, as it might get
@@ -1368,7 +1497,8 @@ static bool tee_rpmb_write_is_atomic(uint16_t dev_id __unused, uint32_t addr,
  */
 static TEE_Result tee_rpmb_write(uint16_t dev_id, uint32_t addr,
 				 const uint8_t *data, uint32_t len,
-				 const uint8_t *fek, const TEE_UUID *uuid)
+				 const uint8_t *fek, const TEE_UUID *uuid,
+				 struct tee_fs_fek_cache *fc)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
 	uint8_t *data_tmp = NULL;
@@ -1384,7 +1514,7 @@ static TEE_Result tee_rpmb_write(uint16_t dev_id, uint32_t addr,
 
 	if (byte_offset == 0 && (len % RPMB_DATA_SIZE) == 0) {
 		res = tee_rpmb_write_blk(dev_id, blk_idx, data, blkcnt, fek,
-					 uuid);
+					 uuid, fc);
 		if (res != TEE_SUCCESS)
 			goto func_exit;
 	} else {
@@ -1396,7 +1526,7 @@ static TEE_Result tee_rpmb_write(uint16_t dev_id, uint32_t addr,
 
 		/* Read the complete blocks */
 		res = tee_rpmb_read(dev_id, blk_idx * RPMB_DATA_SIZE, data_tmp,
-				    blkcnt * RPMB_DATA_SIZE, fek, uuid);
+				    blkcnt * RPMB_DATA_SIZE, fek, uuid, fc);
 		if (res != TEE_SUCCESS)
 			goto func_exit;
 
@@ -1404,7 +1534,7 @@ static TEE_Result tee_rpmb_write(uint16_t dev_id, uint32_t addr,
 		memcpy(data_tmp + byte_offset, data, len);
 
 		res = tee_rpmb_write_blk(dev_id, blk_idx, data_tmp, blkcnt,
-					 fek, uuid);
+					 fek, uuid, fc);
 		if (res != TEE_SUCCESS)
 			goto func_exit;
 	}
@@ -1473,53 +1603,485 @@ func_exit:
 
 static TEE_Result get_fat_start_address(uint32_t *addr);
 
-static void dump_fat(void)
+/**
+ * FAT iterator: Returns the FAT entries in order, from the FAT cache
+ * if enabled and else read N_ENTRIES at a time from RPMB. The caller
+ * stops on the entry with FILE_IS_LAST_ENTRY set.
+ */
+struct fat_iter {
+	struct rpmb_fat_entry *buf;
+	const struct rpmb_fat_entry *entries;
+	size_t num_entries;
+	size_t pos;
+	uint32_t address;
+	bool by_dir;
+};
+
+#ifdef CFG_RPMB_FS_FAT_CACHE
+/*
+ * RAM copy of the FAT, from the first entry up to and including the
+ * first one with FILE_IS_LAST_ENTRY set. Only this driver writes the
+ * RPMB partition, so write_fat_entry() keeps the copy coherent and a
+ * failed write drops it since the content of the FAT is unknown then.
+ *
+ * @space represents the RPMB space in use, the FAT itself in @fat_mm and
+ * the data of each active file, the same way read_fat() builds a pool
+ * from the FAT. It's kept up to date with the entries so allocating
+ * space for a file doesn't rebuild a pool from the whole FAT.
+ *
+ * Active entries are also linked by directory, that is the part of the
+ * filename up to the last '/', in @dir_head and @dir_next so that
+ * listing the objects of a TA only visits entries of its directory or
+ * of a directory hashing to the same bucket.
+ */
+#define FAT_CACHE_DIR_BUCKETS	16
+#define FAT_CACHE_NO_IDX	UINT32_MAX
+
+static struct {
+	struct rpmb_fat_entry *entries;
+	size_t num_entries;
+	tee_mm_pool_t space;
+	tee_mm_entry_t *fat_mm;
+	uint32_t *dir_next;
+	uint32_t dir_head[FAT_CACHE_DIR_BUCKETS];
+	bool valid;
+} fat_cache;
+
+static void fat_cache_invalidate(void)
+{
+	tee_mm_final(&fat_cache.space);
+	free(fat_cache.entries);
+	fat_cache.entries = NULL;
+	fat_cache.num_entries = 0;
+	fat_cache.fat_mm = NULL;
+	free(fat_cache.dir_next);
+	fat_cache.dir_next = NULL;
+	fat_cache.valid = false;
+}
+
+/* FNV-1a of the directory part of @name */
+static size_t fat_cache_dir_bucket(const char *name, size_t len)
+{
+	uint32_t h = 2166136261;
+	size_t dirlen = 0;
+	size_t n = 0;
+
+	for (n = 0; n < len && name[n]; n++)
+		if (name[n] == '/')
+			dirlen = n;
+
+	for (n = 0; n < dirlen; n++)
+		h = (h ^ (uint8_t)name[n]) * 16777619;
+
+	return h % FAT_CACHE_DIR_BUCKETS;
+}
+
+static void fat_cache_dir_link(uint32_t idx)
+{
+	const struct rpmb_fat_entry *fe = fat_cache.entries + idx;
+	size_t b = fat_cache_dir_bucket(fe->filename, sizeof(fe->filename));
+
+	fat_cache.dir_next[idx] = fat_cache.dir_head[b];
+	fat_cache.dir_head[b] = idx;
+}
+
+static void fat_cache_dir_unlink(uint32_t idx)
+{
+	const struct rpmb_fat_entry *fe = fat_cache.entries + idx;
+	size_t b = fat_cache_dir_bucket(fe->filename, sizeof(fe->filename));
+	uint32_t *p = fat_cache.dir_head + b;
+
+	while (*p != idx) {
+		assert(*p != FAT_CACHE_NO_IDX);
+		p = fat_cache.dir_next + *p;
+	}
+	*p = fat_cache.dir_next[idx];
+}
+
+static void fat_cache_init_dirs(void)
+{
+	size_t n = 0;
+
+	for (n = 0; n < FAT_CACHE_DIR_BUCKETS; n++)
+		fat_cache.dir_head[n] = FAT_CACHE_NO_IDX;
+
+	for (n = fat_cache.num_entries; n > 0; n--) {
+		fat_cache.dir_next[n - 1] = FAT_CACHE_NO_IDX;
+		if (fat_cache.entries[n - 1].flags & FILE_IS_ACTIVE)
+			fat_cache_dir_link(n - 1);
+	}
+}
+
+static TEE_Result fat_cache_init_space(void)
+{
+	const struct rpmb_fat_entry *fe = NULL;
+	uint32_t fat_start = 0;
+	size_t n = 0;
+
+	if (get_fat_start_address(&fat_start))
+		return TEE_ERROR_NO_DATA;
+
+	if (!tee_mm_init(&fat_cache.space, RPMB_STORAGE_START_ADDRESS,
+			 fs_par->max_rpmb_address, RPMB_BLOCK_SIZE_SHIFT,
+			 TEE_MM_POOL_HI_ALLOC))
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	for (n = 0; n < fat_cache.num_entries; n++) {
+		fe = fat_cache.entries + n;
+		if ((fe->flags & FILE_IS_ACTIVE) && fe->data_size &&
+		    !tee_mm_alloc2(&fat_cache.space, fe->start_address,
+				   fe->data_size))
+			return TEE_ERROR_OUT_OF_MEMORY;
+	}
+
+	fat_cache.fat_mm = tee_mm_alloc2(&fat_cache.space,
+					 RPMB_STORAGE_START_ADDRESS,
+					 fat_start + fat_cache.num_entries *
+						     sizeof(*fe));
+	if (!fat_cache.fat_mm)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result fat_cache_fill(void)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
-	struct rpmb_fat_entry *fat_entries = NULL;
-	uint32_t fat_address;
-	size_t size;
-	int i;
-	bool last_entry_found = false;
+	struct rpmb_fat_entry *fe = NULL;
+	uint32_t fat_address = 0;
+	size_t num = 0;
+	size_t n = 0;
+	void *p = NULL;
 
 	res = get_fat_start_address(&fat_address);
 	if (res != TEE_SUCCESS)
-		goto out;
+		return res;
 
-	size = N_ENTRIES * sizeof(struct rpmb_fat_entry);
-	fat_entries = malloc(size);
-	if (!fat_entries) {
-		res = TEE_ERROR_OUT_OF_MEMORY;
-		goto out;
-	}
+	while (true) {
+		p = realloc(fe, (num + N_ENTRIES) * sizeof(*fe));
+		if (!p) {
+			res = TEE_ERROR_OUT_OF_MEMORY;
+			goto err;
+		}
+		fe = p;
 
-	while (!last_entry_found) {
 		res = tee_rpmb_read(CFG_RPMB_FS_DEV_ID, fat_address,
-				    (uint8_t *)fat_entries, size, NULL, NULL);
+				    (uint8_t *)(fe + num),
+				    N_ENTRIES * sizeof(*fe), NULL, NULL, NULL);
 		if (res != TEE_SUCCESS)
-			goto out;
+			goto err;
+
+		for (n = 0; n < N_ENTRIES; n++) {
+			if (fe[num + n].flags & FILE_IS_LAST_ENTRY) {
+				fat_cache.entries = fe;
+				fat_cache.num_entries = num + n + 1;
+				fat_cache.dir_next =
+					calloc(fat_cache.num_entries,
+					       sizeof(*fat_cache.dir_next));
+				if (!fat_cache.dir_next)
+					res = TEE_ERROR_OUT_OF_MEMORY;
+				else
+					res = fat_cache_init_space();
+				if (res) {
+					fat_cache_invalidate();
+					return res;
+				}
+				fat_cache_init_dirs();
+				fat_cache.valid = true;
+				return TEE_SUCCESS;
+			}
+		}
 
-		for (i = 0; i < N_ENTRIES; i++) {
+		num += N_ENTRIES;
+		fat_address += N_ENTRIES * sizeof(*fe);
+	}
 
-			FMSG("flags 0x%x, size %d, address 0x%x, filename '%s'",
-				fat_entries[i].flags,
-				fat_entries[i].data_size,
-				fat_entries[i].start_address,
-				fat_entries[i].filename);
+err:
+	free(fe);
+	return res;
+}
 
-			if ((fat_entries[i].flags & FILE_IS_LAST_ENTRY) != 0) {
-				last_entry_found = true;
-				break;
-			}
+static void fat_cache_update(uint32_t fat_address,
+			     const struct rpmb_fat_entry *fe)
+{
+	struct rpmb_fat_entry *old = NULL;
+	tee_mm_entry_t *mm = NULL;
+	uint32_t fat_start = 0;
+	size_t idx = 0;
+	void *p = NULL;
 
-			/* Move to next fat_entry. */
-			fat_address += sizeof(struct rpmb_fat_entry);
+	if (!fat_cache.valid)
+		return;
+
+	if (get_fat_start_address(&fat_start) || fat_address < fat_start)
+		goto err;
+
+	idx = (fat_address - fat_start) / sizeof(*fe);
+	if (idx == fat_cache.num_entries) {
+		/*
+		 * Only the new last entry when the FAT is expanded is
+		 * appended, the FAT then covers one more entry.
+		 */
+		if (!(fe->flags & FILE_IS_LAST_ENTRY))
+			goto err;
+
+		p = realloc(fat_cache.entries, (idx + 1) * sizeof(*fe));
+		if (!p)
+			goto err;
+		fat_cache.entries = p;
+		p = realloc(fat_cache.dir_next,
+			    (idx + 1) * sizeof(*fat_cache.dir_next));
+		if (!p)
+			goto err;
+		fat_cache.dir_next = p;
+		fat_cache.dir_next[idx] = FAT_CACHE_NO_IDX;
+		fat_cache.num_entries++;
+
+		tee_mm_free(fat_cache.fat_mm);
+		fat_cache.fat_mm = tee_mm_alloc2(&fat_cache.space,
+						 RPMB_STORAGE_START_ADDRESS,
+						 fat_address + sizeof(*fe));
+		if (!fat_cache.fat_mm)
+			goto err;
+	} else if (idx < fat_cache.num_entries) {
+		old = fat_cache.entries + idx;
+		if (old->flags & FILE_IS_ACTIVE)
+			fat_cache_dir_unlink(idx);
+		if ((old->flags & FILE_IS_ACTIVE) && old->data_size) {
+			mm = tee_mm_find(&fat_cache.space, old->start_address);
+			if (!mm)
+				goto err;
+			tee_mm_free(mm);
 		}
+	} else {
+		goto err;
+	}
+
+	fat_cache.entries[idx] = *fe;
+	if (fe->flags & FILE_IS_ACTIVE)
+		fat_cache_dir_link(idx);
+
+	if ((fe->flags & FILE_IS_ACTIVE) && fe->data_size) {
+		/*
+		 * The space is normally already allocated with
+		 * fat_space_get() by the writer of the entry.
+		 */
+		mm = tee_mm_find(&fat_cache.space, fe->start_address);
+		if (mm) {
+			if (tee_mm_get_smem(mm) != fe->start_address)
+				goto err;
+		} else if (!tee_mm_alloc2(&fat_cache.space, fe->start_address,
+					  fe->data_size)) {
+			goto err;
+		}
+	}
+	return;
+
+err:
+	fat_cache_invalidate();
+}
+
+static bool fat_space_is_cached(tee_mm_pool_t *pool)
+{
+	return pool == &fat_cache.space;
+}
+#else
+static void fat_cache_invalidate(void)
+{
+}
+
+static void fat_cache_update(uint32_t fat_address __unused,
+			     const struct rpmb_fat_entry *fe __unused)
+{
+}
+
+static bool fat_space_is_cached(tee_mm_pool_t *pool __unused)
+{
+	return false;
+}
+#endif /*CFG_RPMB_FS_FAT_CACHE*/
+
+/*
+ * fat_space_get: Returns in @pool the pool to allocate RPMB space for a
+ * file from. That's the space of the FAT cache if available, else
+ * @tmp_pool is initialized and read_fat() has to be called with it to
+ * fill in the space in use. The pool is released with fat_space_put()
+ * which also frees @mm unless it has been recorded with
+ * write_fat_entry().
+ */
+static TEE_Result fat_space_get(tee_mm_pool_t *tmp_pool, tee_mm_pool_t **pool)
+{
+#ifdef CFG_RPMB_FS_FAT_CACHE
+	/* A failure to fill the cache is handled with a temporary pool */
+	if (!fat_cache.valid)
+		fat_cache_fill();
+	if (fat_cache.valid) {
+		*pool = &fat_cache.space;
+		return TEE_SUCCESS;
+	}
+#endif
+
+	/* Upper memory allocation must be used for RPMB_FS. */
+	if (!tee_mm_init(tmp_pool, RPMB_STORAGE_START_ADDRESS,
+			 fs_par->max_rpmb_address, RPMB_BLOCK_SIZE_SHIFT,
+			 TEE_MM_POOL_HI_ALLOC))
+		return TEE_ERROR_OUT_OF_MEMORY;
+	*pool = tmp_pool;
+
+	return TEE_SUCCESS;
+}
+
+static void fat_space_put(tee_mm_pool_t *tmp_pool, tee_mm_pool_t *pool,
+			  tee_mm_entry_t *mm)
+{
+	if (pool == tmp_pool)
+		tee_mm_final(tmp_pool);
+	else if (mm)
+		tee_mm_free(mm);
+}
+
+static TEE_Result fat_iter_init(struct fat_iter *it)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	*it = (struct fat_iter){ };
+
+	res = get_fat_start_address(&it->address);
+	if (res != TEE_SUCCESS)
+		return res;
+
+#ifdef CFG_RPMB_FS_FAT_CACHE
+	if (!fat_cache.valid) {
+		res = fat_cache_fill();
+		if (res == TEE_ERROR_OUT_OF_MEMORY)
+			DMSG("FAT cache disabled, out of memory");
+		else if (res != TEE_SUCCESS)
+			return res;
+	}
+	if (fat_cache.valid) {
+		it->entries = fat_cache.entries;
+		it->num_entries = fat_cache.num_entries;
+		return TEE_SUCCESS;
+	}
+#endif
+
+	it->buf = malloc(N_ENTRIES * sizeof(struct rpmb_fat_entry));
+	if (!it->buf)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	it->entries = it->buf;
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Returns the next FAT entry in @fe and its RPMB address in @fat_address.
+ * @fe is only valid until the next call or until the FAT is written.
+ */
+static TEE_Result fat_iter_next(struct fat_iter *it,
+				const struct rpmb_fat_entry **fe,
+				uint32_t *fat_address)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+#ifdef CFG_RPMB_FS_FAT_CACHE
+	if (it->by_dir) {
+		static const struct rpmb_fat_entry last_fe = {
+			.flags = FILE_IS_LAST_ENTRY,
+		};
+		uint32_t fat_start = 0;
+
+		if (it->pos == FAT_CACHE_NO_IDX) {
+			*fe = &last_fe;
+			*fat_address = 0;
+			return TEE_SUCCESS;
+		}
+
+		res = get_fat_start_address(&fat_start);
+		if (res)
+			return res;
+		*fe = fat_cache.entries + it->pos;
+		*fat_address = fat_start + it->pos * sizeof(**fe);
+		it->pos = fat_cache.dir_next[it->pos];
+		return TEE_SUCCESS;
+	}
+#endif
+
+	if (it->pos == it->num_entries) {
+		/* A cached FAT always ends with the last entry */
+		if (!it->buf)
+			return TEE_ERROR_CORRUPT_OBJECT;
+
+		res = tee_rpmb_read(CFG_RPMB_FS_DEV_ID, it->address,
+				    (uint8_t *)it->buf,
+				    N_ENTRIES * sizeof(struct rpmb_fat_entry),
+				    NULL, NULL, NULL);
+		if (res != TEE_SUCCESS)
+			return res;
+		it->num_entries = N_ENTRIES;
+		it->pos = 0;
+	}
+
+	*fe = it->entries + it->pos;
+	*fat_address = it->address;
+	it->pos++;
+	it->address += sizeof(struct rpmb_fat_entry);
+
+	return TEE_SUCCESS;
+}
+
+static void fat_iter_final(struct fat_iter *it)
+{
+	free(it->buf);
+}
+
+/*
+ * Like fat_iter_init() but the iterator may only return the active
+ * entries with filenames in directory @path, ending with an inactive
+ * last entry. Other entries then have to be skipped by the caller.
+ */
+static TEE_Result fat_iter_init_dir(struct fat_iter *it,
+				    const char *path __maybe_unused)
+{
+	TEE_Result res = fat_iter_init(it);
+
+#ifdef CFG_RPMB_FS_FAT_CACHE
+	if (res == TEE_SUCCESS && !it->buf) {
+		it->by_dir = true;
+		it->pos = fat_cache.dir_head[fat_cache_dir_bucket(path,
+								 SIZE_MAX)];
+	}
+#endif
+
+	return res;
+}
+
+#if (TRACE_LEVEL >= TRACE_FLOW)
+static void dump_fat(void)
+{
+	const struct rpmb_fat_entry *fe = NULL;
+	uint32_t fat_address = 0;
+	struct fat_iter it = { };
+
+	if (fat_iter_init(&it))
+		goto out;
+
+	while (!fat_iter_next(&it, &fe, &fat_address)) {
+		FMSG("flags 0x%x, size %d, address 0x%x, filename '%s'",
+		     fe->flags, fe->data_size, fe->start_address,
+		     fe->filename);
+
+		if ((fe->flags & FILE_IS_LAST_ENTRY) != 0)
+			break;
 	}
 
 out:
-	free(fat_entries);
+	fat_iter_final(&it);
+}
+#else
+static void dump_fat(void)
+{
 }
+#endif
 
 #if (TRACE_LEVEL >= TRACE_DEBUG)
 static void dump_fh(struct rpmb_file_handle *fh)
@@ -1580,7 +2142,11 @@ static TEE_Result write_fat_entry(struct rpmb_file_handle *fh,
 
 	res = tee_rpmb_write(CFG_RPMB_FS_DEV_ID, fh->rpmb_fat_address,
 			     (uint8_t *)&fh->fat_entry,
-			     sizeof(struct rpmb_fat_entry), NULL, NULL);
+			     sizeof(struct rpmb_fat_entry), NULL, NULL, NULL);
+	if (res == TEE_SUCCESS)
+		fat_cache_update(fh->rpmb_fat_address, &fh->fat_entry);
+	else
+		fat_cache_invalidate();
 
 	dump_fat();
 
@@ -1617,7 +2183,7 @@ static TEE_Result rpmb_fs_setup(void)
 
 	res = tee_rpmb_read(CFG_RPMB_FS_DEV_ID, RPMB_STORAGE_START_ADDRESS,
 			    (uint8_t *)partition_data,
-			    sizeof(struct rpmb_fs_partition), NULL, NULL);
+			    sizeof(struct rpmb_fs_partition), NULL, NULL, NULL);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -1662,7 +2228,8 @@ static TEE_Result rpmb_fs_setup(void)
 		goto out;
 	res = tee_rpmb_write(CFG_RPMB_FS_DEV_ID, RPMB_STORAGE_START_ADDRESS,
 			     (uint8_t *)partition_data,
-			     sizeof(struct rpmb_fs_partition), NULL, NULL);
+			     sizeof(struct rpmb_fs_partition), NULL, NULL,
+			     NULL);
 
 #ifndef CFG_RPMB_RESET_FAT
 store_fs_par:
@@ -1705,18 +2272,20 @@ static TEE_Result get_fat_start_address(uint32_t *addr)
  * Return matching FAT entry for read, rm rename and stat.
  * Build up memory pool and return matching entry for write operation.
  * "Last FAT entry" can be returned during write.
+ * The space of the FAT cache from fat_space_get() already represents
+ * the RPMB layout and is only used to expand the FAT.
  */
 static TEE_Result read_fat(struct rpmb_file_handle *fh, tee_mm_pool_t *p)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
 	tee_mm_entry_t *mm = NULL;
-	struct rpmb_fat_entry *fat_entries = NULL;
-	uint32_t fat_address;
-	size_t size;
-	int i;
+	const struct rpmb_fat_entry *fe = NULL;
+	struct fat_iter it = { };
+	uint32_t fat_address = 0;
 	bool entry_found = false;
 	bool last_entry_found = false;
 	bool expand_fat = false;
+	bool fill_pool = p && !fat_space_is_cached(p);
 	struct rpmb_file_handle last_fh;
 
 	DMSG("fat_address %d", fh->rpmb_fat_address);
@@ -1725,90 +2294,70 @@ static TEE_Result read_fat(struct rpmb_file_handle *fh, tee_mm_pool_t *p)
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = get_fat_start_address(&fat_address);
+	res = fat_iter_init(&it);
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	size = N_ENTRIES * sizeof(struct rpmb_fat_entry);
-	fat_entries = malloc(size);
-	if (!fat_entries) {
-		res = TEE_ERROR_OUT_OF_MEMORY;
-		goto out;
-	}
-
 	/*
 	 * The pool is used to represent the current RPMB layout. To find
 	 * a slot for the file tee_mm_alloc is called on the pool. Thus
 	 * if it is not NULL the entire FAT must be traversed to fill in
 	 * the pool.
 	 */
-	while (!last_entry_found && (!entry_found || p)) {
-		res = tee_rpmb_read(CFG_RPMB_FS_DEV_ID, fat_address,
-				    (uint8_t *)fat_entries, size, NULL, NULL);
+	while (!last_entry_found && (!entry_found || fill_pool)) {
+		res = fat_iter_next(&it, &fe, &fat_address);
 		if (res != TEE_SUCCESS)
 			goto out;
 
-		for (i = 0; i < N_ENTRIES; i++) {
-			/*
-			 * Look for an entry, matching filenames. (read, rm,
-			 * rename and stat.). Only store first filename match.
-			 */
-			if (fh->filename &&
-			    (strcmp(fh->filename,
-				    fat_entries[i].filename) == 0) &&
-			    (fat_entries[i].flags & FILE_IS_ACTIVE) &&
-			    (!entry_found)) {
-				entry_found = true;
-				fh->rpmb_fat_address = fat_address;
-				memcpy(&fh->fat_entry, &fat_entries[i],
-				       sizeof(struct rpmb_fat_entry));
-				if (!p)
-					break;
-			}
-
-			/* Add existing files to memory pool. (write) */
-			if (p) {
-				if ((fat_entries[i].flags & FILE_IS_ACTIVE) &&
-				    (fat_entries[i].data_size > 0)) {
-
-					mm = tee_mm_alloc2
-						(p,
-						 fat_entries[i].start_address,
-						 fat_entries[i].data_size);
-					if (!mm) {
-						res = TEE_ERROR_OUT_OF_MEMORY;
-						goto out;
-					}
-				}
+		/*
+		 * Look for an entry, matching filenames. (read, rm,
+		 * rename and stat.). Only store first filename match.
+		 */
+		if ((strcmp(fh->filename, fe->filename) == 0) &&
+		    (fe->flags & FILE_IS_ACTIVE) && (!entry_found)) {
+			entry_found = true;
+			fh->rpmb_fat_address = fat_address;
+			memcpy(&fh->fat_entry, fe,
+			       sizeof(struct rpmb_fat_entry));
+			if (!fill_pool)
+				break;
+		}
 
-				/* Unused FAT entries can be reused (write) */
-				if (((fat_entries[i].flags & FILE_IS_ACTIVE) ==
-				     0) && (fh->rpmb_fat_address == 0)) {
-					fh->rpmb_fat_address = fat_address;
-					memcpy(&fh->fat_entry, &fat_entries[i],
-					       sizeof(struct rpmb_fat_entry));
+		/* Add existing files to memory pool. (write) */
+		if (p) {
+			if (fill_pool && (fe->flags & FILE_IS_ACTIVE) &&
+			    (fe->data_size > 0)) {
+				mm = tee_mm_alloc2(p, fe->start_address,
+						   fe->data_size);
+				if (!mm) {
+					res = TEE_ERROR_OUT_OF_MEMORY;
+					goto out;
 				}
 			}
 
-			if ((fat_entries[i].flags & FILE_IS_LAST_ENTRY) != 0) {
-				last_entry_found = true;
-
-				/*
-				 * If the last entry was reached and was chosen
-				 * by the previous check, then the FAT needs to
-				 * be expanded.
-				 * fh->rpmb_fat_address is the address chosen
-				 * to store the files FAT entry and fat_address
-				 * is the current FAT entry address being
-				 * compared.
-				 */
-				if (p && fh->rpmb_fat_address == fat_address)
-					expand_fat = true;
-				break;
+			/* Unused FAT entries can be reused (write) */
+			if (((fe->flags & FILE_IS_ACTIVE) == 0) &&
+			    (fh->rpmb_fat_address == 0)) {
+				fh->rpmb_fat_address = fat_address;
+				memcpy(&fh->fat_entry, fe,
+				       sizeof(struct rpmb_fat_entry));
 			}
+		}
 
-			/* Move to next fat_entry. */
-			fat_address += sizeof(struct rpmb_fat_entry);
+		if ((fe->flags & FILE_IS_LAST_ENTRY) != 0) {
+			last_entry_found = true;
+
+			/*
+			 * If the last entry was reached and was chosen
+			 * by the previous check, then the FAT needs to
+			 * be expanded.
+			 * fh->rpmb_fat_address is the address chosen
+			 * to store the files FAT entry and fat_address
+			 * is the current FAT entry address being
+			 * compared.
+			 */
+			if (p && fh->rpmb_fat_address == fat_address)
+				expand_fat = true;
 		}
 	}
 
@@ -1826,8 +2375,17 @@ static TEE_Result read_fat(struct rpmb_file_handle *fh, tee_mm_pool_t *p)
 		if (expand_fat)
 			fat_address += sizeof(struct rpmb_fat_entry);
 
-		mm = tee_mm_alloc2(p, RPMB_STORAGE_START_ADDRESS, fat_address);
-		if (!mm) {
+		if (fill_pool) {
+			mm = tee_mm_alloc2(p, RPMB_STORAGE_START_ADDRESS,
+					   fat_address);
+			if (!mm) {
+				res = TEE_ERROR_OUT_OF_MEMORY;
+				goto out;
+			}
+		} else if (expand_fat &&
+			   tee_mm_find(p, fat_address -
+					  sizeof(struct rpmb_fat_entry))) {
+			/* The new entry would overwrite data of a file */
 			res = TEE_ERROR_OUT_OF_MEMORY;
 			goto out;
 		}
@@ -1847,11 +2405,11 @@ static TEE_Result read_fat(struct rpmb_file_handle *fh, tee_mm_pool_t *p)
 		}
 	}
 
-	if (fh->filename && !fh->rpmb_fat_address)
+	if (!fh->rpmb_fat_address)
 		res = TEE_ERROR_ITEM_NOT_FOUND;
 
 out:
-	free(fat_entries);
+	fat_iter_final(&it);
 	return res;
 }
 
@@ -1873,8 +2431,8 @@ again:
 static TEE_Result rpmb_fs_open_internal(struct rpmb_file_handle *fh,
 					const TEE_UUID *uuid, bool create)
 {
-	tee_mm_pool_t p;
-	bool pool_result;
+	tee_mm_pool_t tmp_pool;
+	tee_mm_pool_t *pool = NULL;
 	TEE_Result res = TEE_ERROR_GENERIC;
 
 	/* We need to do setup in order to make sure fs_par is filled in */
@@ -1884,20 +2442,12 @@ static TEE_Result rpmb_fs_open_internal(struct rpmb_file_handle *fh,
 
 	fh->uuid = uuid;
 	if (create) {
-		/* Upper memory allocation must be used for RPMB_FS. */
-		pool_result = tee_mm_init(&p,
-					  RPMB_STORAGE_START_ADDRESS,
-					  fs_par->max_rpmb_address,
-					  RPMB_BLOCK_SIZE_SHIFT,
-					  TEE_MM_POOL_HI_ALLOC);
-
-		if (!pool_result) {
-			res = TEE_ERROR_OUT_OF_MEMORY;
+		res = fat_space_get(&tmp_pool, &pool);
+		if (res != TEE_SUCCESS)
 			goto out;
-		}
 
-		res = read_fat(fh, &p);
-		tee_mm_final(&p);
+		res = read_fat(fh, pool);
+		fat_space_put(&tmp_pool, pool, NULL);
 		if (res != TEE_SUCCESS)
 			goto out;
 	} else {
@@ -1938,10 +2488,105 @@ out:
 	return res;
 }
 
+static TEE_Result rpmb_fs_write_primitive(struct rpmb_file_handle *fh,
+					  size_t pos, const void *buf,
+					  size_t size);
+
+/*
+ * Write-back of file data, enabled with CFG_RPMB_FS_WRITE_BACK_SIZE > 0.
+ * This is a non-durable mode: a write is acknowledged before its data is
+ * stored, which GP requires of TEE_WriteObjectData(), and data is lost on
+ * power failure until it's flushed.
+ *
+ * Only handles of TA objects opened with rpmb_fs_open() or
+ * rpmb_fs_create() use it. Files opened with tee_rpmb_fs_raw_open(), like
+ * the REE FS dirfile hash, are always written right away. Consecutive
+ * contiguous writes through the same file handle are collected in wb_data
+ * and stored with a single rpmb_fs_write_primitive() once they don't fit
+ * any longer, or before any other RPMB FS operation, including closing
+ * the handle. So there's at most one file handle with pending data,
+ * protected by rpmb_mutex.
+ */
+static struct rpmb_file_handle *wb_fh;
+static uint8_t *wb_data;
+static size_t wb_pos;
+static size_t wb_len;
+
+/*
+ * Stores pending data. A failure is only returned if @fh is the handle
+ * the data was written through, for other callers it's just logged since
+ * the data is lost either way.
+ */
+static TEE_Result wb_flush(struct rpmb_file_handle *fh)
+{
+	struct rpmb_file_handle *wfh = wb_fh;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!wfh)
+		return TEE_SUCCESS;
+
+	wb_fh = NULL;
+	res = rpmb_fs_write_primitive(wfh, wb_pos, wb_data, wb_len);
+	if (res) {
+		EMSG("Lost %zu bytes written at %zu to %s: %#"PRIx32,
+		     wb_len, wb_pos, wfh->filename, res);
+		if (wfh != fh)
+			res = TEE_SUCCESS;
+	}
+	wb_len = 0;
+
+	return res;
+}
+
+static TEE_Result wb_write(struct rpmb_file_handle *fh, size_t pos,
+			   const void *buf, size_t size)
+{
+	const size_t wb_size = CFG_RPMB_FS_WRITE_BACK_SIZE;
+	TEE_Result res = TEE_ERROR_GENERIC;
+	size_t end = 0;
+
+	if (ADD_OVERFLOW(pos, size, &end) || end > INT32_MAX)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (wb_fh == fh && pos == wb_pos + wb_len &&
+	    size <= wb_size - wb_len) {
+		memcpy(wb_data + wb_len, buf, size);
+		wb_len += size;
+		return TEE_SUCCESS;
+	}
+
+	res = wb_flush(fh);
+	if (res)
+		return res;
+
+	if (!wb_data) {
+		wb_data = malloc(wb_size);
+		if (wb_data)
+			IMSG("Non-durable RPMB FS write-back enabled");
+	}
+	if (!wb_data || size > wb_size)
+		return rpmb_fs_write_primitive(fh, pos, buf, size);
+
+	memcpy(wb_data, buf, size);
+	wb_fh = fh;
+	wb_pos = pos;
+	wb_len = size;
+
+	return TEE_SUCCESS;
+}
+
 static void rpmb_fs_close(struct tee_file_handle **tfh)
 {
 	struct rpmb_file_handle *fh = (struct rpmb_file_handle *)*tfh;
 
+	if (CFG_RPMB_FS_WRITE_BACK_SIZE) {
+		mutex_lock(&rpmb_mutex);
+		if (wb_fh == fh)
+			wb_flush(fh);
+		mutex_unlock(&rpmb_mutex);
+	}
+
+	tee_fs_fek_cache_wipe(&fh->fek_cache);
 	free(fh);
 	*tfh = NULL;
 }
@@ -1951,6 +2596,8 @@ static TEE_Result rpmb_fs_read(struct tee_file_handle *tfh, size_t pos,
 {
 	TEE_Result res;
 	struct rpmb_file_handle *fh = (struct rpmb_file_handle *)tfh;
+	uint8_t fek[TEE_FS_KM_FEK_SIZE] = { };
+	struct rpmb_read_req rr;
 	size_t size = *len;
 
 	if (!size)
@@ -1958,6 +2605,10 @@ static TEE_Result rpmb_fs_read(struct tee_file_handle *tfh, size_t pos,
 
 	mutex_lock(&rpmb_mutex);
 
+	res = wb_flush(fh);
+	if (res != TEE_SUCCESS)
+		goto out;
+
 	dump_fh(fh);
 
 	res = read_fat(fh, NULL);
@@ -1970,14 +2621,24 @@ static TEE_Result rpmb_fs_read(struct tee_file_handle *tfh, size_t pos,
 	}
 
 	size = MIN(size, fh->fat_entry.data_size - pos);
-	if (size) {
-		res = tee_rpmb_read(CFG_RPMB_FS_DEV_ID,
-				    fh->fat_entry.start_address + pos, buf,
-				    size, fh->fat_entry.fek, fh->uuid);
-		if (res != TEE_SUCCESS)
-			goto out;
-	}
-	*len = size;
+	res = tee_rpmb_read_start(CFG_RPMB_FS_DEV_ID,
+				  fh->fat_entry.start_address + pos, size, &rr);
+	if (res != TEE_SUCCESS)
+		goto out;
+	memcpy(fek, fh->fat_entry.fek, sizeof(fek));
+
+	/*
+	 * The response is in memory private to this request, the MAC
+	 * check and the decryption of the data don't need to hold back
+	 * RPMB accesses from other threads.
+	 */
+	mutex_unlock(&rpmb_mutex);
+
+	res = tee_rpmb_read_finish(&rr, buf, size, fek, fh->uuid,
+				   &fh->fek_cache);
+	if (res == TEE_SUCCESS)
+		*len = size;
+	return res;
 
 out:
 	mutex_unlock(&rpmb_mutex);
@@ -1989,9 +2650,9 @@ static TEE_Result rpmb_fs_write_primitive(struct rpmb_file_handle *fh,
 					  size_t size)
 {
 	TEE_Result res;
-	tee_mm_pool_t p;
-	bool pool_result = false;
-	tee_mm_entry_t *mm;
+	tee_mm_pool_t tmp_pool;
+	tee_mm_pool_t *pool = NULL;
+	tee_mm_entry_t *mm = NULL;
 	size_t end;
 	size_t newsize;
 	uint8_t *newbuf = NULL;
@@ -2008,18 +2669,11 @@ static TEE_Result rpmb_fs_write_primitive(struct rpmb_file_handle *fh,
 
 	dump_fh(fh);
 
-	/* Upper memory allocation must be used for RPMB_FS. */
-	pool_result = tee_mm_init(&p,
-				  RPMB_STORAGE_START_ADDRESS,
-				  fs_par->max_rpmb_address,
-				  RPMB_BLOCK_SIZE_SHIFT,
-				  TEE_MM_POOL_HI_ALLOC);
-	if (!pool_result) {
-		res = TEE_ERROR_OUT_OF_MEMORY;
+	res = fat_space_get(&tmp_pool, &pool);
+	if (res != TEE_SUCCESS)
 		goto out;
-	}
 
-	res = read_fat(fh, &p);
+	res = read_fat(fh, pool);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -2040,7 +2694,8 @@ static TEE_Result rpmb_fs_write_primitive(struct rpmb_file_handle *fh,
 
 		DMSG("Updating data in-place");
 		res = tee_rpmb_write(CFG_RPMB_FS_DEV_ID, start_addr, buf,
-				     size, fh->fat_entry.fek, fh->uuid);
+				     size, fh->fat_entry.fek, fh->uuid,
+				     &fh->fek_cache);
 		if (res != TEE_SUCCESS)
 			goto out;
 	} else {
@@ -2051,7 +2706,7 @@ static TEE_Result rpmb_fs_write_primitive(struct rpmb_file_handle *fh,
 
 		DMSG("Need to re-allocate");
 		newsize = MAX(end, fh->fat_entry.data_size);
-		mm = tee_mm_alloc(&p, newsize);
+		mm = tee_mm_alloc(pool, newsize);
 		newbuf = calloc(1, newsize);
 		if (!mm || !newbuf) {
 			res = TEE_ERROR_OUT_OF_MEMORY;
@@ -2062,7 +2717,8 @@ static TEE_Result rpmb_fs_write_primitive(struct rpmb_file_handle *fh,
 			res = tee_rpmb_read(CFG_RPMB_FS_DEV_ID,
 					    fh->fat_entry.start_address,
 					    newbuf, fh->fat_entry.data_size,
-					    fh->fat_entry.fek, fh->uuid);
+					    fh->fat_entry.fek, fh->uuid,
+					    &fh->fek_cache);
 			if (res != TEE_SUCCESS)
 				goto out;
 		}
@@ -2071,20 +2727,23 @@ static TEE_Result rpmb_fs_write_primitive(struct rpmb_file_handle *fh,
 
 		newaddr = tee_mm_get_smem(mm);
 		res = tee_rpmb_write(CFG_RPMB_FS_DEV_ID, newaddr, newbuf,
-				     newsize, fh->fat_entry.fek, fh->uuid);
+				     newsize, fh->fat_entry.fek, fh->uuid,
+				     &fh->fek_cache);
 		if (res != TEE_SUCCESS)
 			goto out;
 
 		fh->fat_entry.data_size = newsize;
 		fh->fat_entry.start_address = newaddr;
 		res = write_fat_entry(fh, true);
+		/* The FAT cache has taken over or dropped the space */
+		mm = NULL;
 		if (res != TEE_SUCCESS)
 			goto out;
 	}
 
 out:
-	if (pool_result)
-		tee_mm_final(&p);
+	if (pool)
+		fat_space_put(&tmp_pool, pool, mm);
 	if (newbuf)
 		free(newbuf);
 
@@ -2094,11 +2753,14 @@ out:
 static TEE_Result rpmb_fs_write(struct tee_file_handle *tfh, size_t pos,
 				const void *buf, size_t size)
 {
+	struct rpmb_file_handle *fh = (struct rpmb_file_handle *)tfh;
 	TEE_Result res;
 
 	mutex_lock(&rpmb_mutex);
-	res = rpmb_fs_write_primitive((struct rpmb_file_handle *)tfh, pos,
-				      buf, size);
+	if (CFG_RPMB_FS_WRITE_BACK_SIZE && fh->write_back && size)
+		res = wb_write(fh, pos, buf, size);
+	else
+		res = rpmb_fs_write_primitive(fh, pos, buf, size);
 	mutex_unlock(&rpmb_mutex);
 
 	return res;
@@ -2127,6 +2789,7 @@ static TEE_Result rpmb_fs_remove(struct tee_pobj *po)
 
 	mutex_lock(&rpmb_mutex);
 
+	wb_flush(NULL);
 	res = rpmb_fs_remove_internal(fh);
 
 	mutex_unlock(&rpmb_mutex);
@@ -2203,6 +2866,7 @@ static  TEE_Result rpmb_fs_rename(struct tee_pobj *old, struct tee_pobj *new,
 	TEE_Result res;
 
 	mutex_lock(&rpmb_mutex);
+	wb_flush(NULL);
 	res = rpmb_fs_rename_internal(old, new, overwrite);
 	mutex_unlock(&rpmb_mutex);
 
@@ -2212,9 +2876,9 @@ static  TEE_Result rpmb_fs_rename(struct tee_pobj *old, struct tee_pobj *new,
 static TEE_Result rpmb_fs_truncate(struct tee_file_handle *tfh, size_t length)
 {
 	struct rpmb_file_handle *fh = (struct rpmb_file_handle *)tfh;
-	tee_mm_pool_t p;
-	bool pool_result = false;
-	tee_mm_entry_t *mm;
+	tee_mm_pool_t tmp_pool;
+	tee_mm_pool_t *pool = NULL;
+	tee_mm_entry_t *mm = NULL;
 	uint32_t newsize;
 	uint8_t *newbuf = NULL;
 	uintptr_t newaddr;
@@ -2222,6 +2886,10 @@ static TEE_Result rpmb_fs_truncate(struct tee_file_handle *tfh, size_t length)
 
 	mutex_lock(&rpmb_mutex);
 
+	res = wb_flush(fh);
+	if (res != TEE_SUCCESS)
+		goto out;
+
 	if (length > INT32_MAX) {
 		res = TEE_ERROR_BAD_PARAMETERS;
 		goto out;
@@ -2235,20 +2903,14 @@ static TEE_Result rpmb_fs_truncate(struct tee_file_handle *tfh, size_t length)
 	if (newsize > fh->fat_entry.data_size) {
 		/* Extend file */
 
-		pool_result = tee_mm_init(&p,
-					  RPMB_STORAGE_START_ADDRESS,
-					  fs_par->max_rpmb_address,
-					  RPMB_BLOCK_SIZE_SHIFT,
-					  TEE_MM_POOL_HI_ALLOC);
-		if (!pool_result) {
-			res = TEE_ERROR_OUT_OF_MEMORY;
+		res = fat_space_get(&tmp_pool, &pool);
+		if (res != TEE_SUCCESS)
 			goto out;
-		}
-		res = read_fat(fh, &p);
+		res = read_fat(fh, pool);
 		if (res != TEE_SUCCESS)
 			goto out;
 
-		mm = tee_mm_alloc(&p, newsize);
+		mm = tee_mm_alloc(pool, newsize);
 		newbuf = calloc(1, newsize);
 		if (!mm || !newbuf) {
 			res = TEE_ERROR_OUT_OF_MEMORY;
@@ -2259,14 +2921,16 @@ static TEE_Result rpmb_fs_truncate(struct tee_file_handle *tfh, size_t length)
 			res = tee_rpmb_read(CFG_RPMB_FS_DEV_ID,
 					    fh->fat_entry.start_address,
 					    newbuf, fh->fat_entry.data_size,
-					    fh->fat_entry.fek, fh->uuid);
+					    fh->fat_entry.fek, fh->uuid,
+					    &fh->fek_cache);
 			if (res != TEE_SUCCESS)
 				goto out;
 		}
 
 		newaddr = tee_mm_get_smem(mm);
 		res = tee_rpmb_write(CFG_RPMB_FS_DEV_ID, newaddr, newbuf,
-				     newsize, fh->fat_entry.fek, fh->uuid);
+				     newsize, fh->fat_entry.fek, fh->uuid,
+				     &fh->fek_cache);
 		if (res != TEE_SUCCESS)
 			goto out;
 
@@ -2279,11 +2943,13 @@ static TEE_Result rpmb_fs_truncate(struct tee_file_handle *tfh, size_t length)
 	fh->fat_entry.data_size = newsize;
 	fh->fat_entry.start_address = newaddr;
 	res = write_fat_entry(fh, true);
+	/* The FAT cache has taken over or dropped the space */
+	mm = NULL;
 
 out:
+	if (pool)
+		fat_space_put(&tmp_pool, pool, mm);
 	mutex_unlock(&rpmb_mutex);
-	if (pool_result)
-		tee_mm_final(&p);
 	if (newbuf)
 		free(newbuf);
 
@@ -2309,89 +2975,62 @@ static TEE_Result rpmb_fs_dir_populate(const char *path,
 				       struct tee_fs_dir *dir)
 {
 	struct tee_rpmb_fs_dirent *current = NULL;
-	struct rpmb_fat_entry *fat_entries = NULL;
-	uint32_t fat_address;
+	const struct rpmb_fat_entry *fe = NULL;
+	struct fat_iter it = { };
+	uint32_t fat_address = 0;
 	uint32_t filelen;
-	char *filename;
-	int i;
+	const char *filename;
 	bool last_entry_found = false;
-	bool matched;
 	struct tee_rpmb_fs_dirent *next = NULL;
 	uint32_t pathlen;
 	TEE_Result res = TEE_ERROR_GENERIC;
-	uint32_t size;
-	char temp;
 
 	mutex_lock(&rpmb_mutex);
 
+	wb_flush(NULL);
+
 	res = rpmb_fs_setup();
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = get_fat_start_address(&fat_address);
+	res = fat_iter_init_dir(&it, path);
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	size = N_ENTRIES * sizeof(struct rpmb_fat_entry);
-	fat_entries = malloc(size);
-	if (!fat_entries) {
-		res = TEE_ERROR_OUT_OF_MEMORY;
-		goto out;
-	}
-
 	pathlen = strlen(path);
 	while (!last_entry_found) {
-		res = tee_rpmb_read(CFG_RPMB_FS_DEV_ID, fat_address,
-				    (uint8_t *)fat_entries, size, NULL, NULL);
+		res = fat_iter_next(&it, &fe, &fat_address);
 		if (res != TEE_SUCCESS)
 			goto out;
 
-		for (i = 0; i < N_ENTRIES; i++) {
-			filename = fat_entries[i].filename;
-			if (fat_entries[i].flags & FILE_IS_ACTIVE) {
-				matched = false;
-				filelen = strlen(filename);
-				if (filelen > pathlen) {
-					temp = filename[pathlen];
-					filename[pathlen] = '\0';
-					if (strcmp(filename, path) == 0)
-						matched = true;
-
-					filename[pathlen] = temp;
+		filename = fe->filename;
+		if (fe->flags & FILE_IS_ACTIVE) {
+			filelen = strlen(filename);
+			if (filelen > pathlen &&
+			    !strncmp(filename, path, pathlen)) {
+				next = malloc(sizeof(*next));
+				if (!next) {
+					res = TEE_ERROR_OUT_OF_MEMORY;
+					goto out;
 				}
 
-				if (matched) {
-					next = malloc(sizeof(*next));
-					if (!next) {
-						res = TEE_ERROR_OUT_OF_MEMORY;
-						goto out;
-					}
-
-					next->entry.oidlen = tee_hs2b(
-						(uint8_t *)&filename[pathlen],
-						next->entry.oid,
-						filelen - pathlen,
-						sizeof(next->entry.oid));
-					if (next->entry.oidlen) {
-						SIMPLEQ_INSERT_TAIL(&dir->next,
-								    next, link);
-						current = next;
-					} else {
-						free(next);
-						next = NULL;
-					}
-
+				next->entry.oidlen = tee_hs2b(
+					(const uint8_t *)&filename[pathlen],
+					next->entry.oid, filelen - pathlen,
+					sizeof(next->entry.oid));
+				if (next->entry.oidlen) {
+					SIMPLEQ_INSERT_TAIL(&dir->next,
+							    next, link);
+					current = next;
+				} else {
+					free(next);
+					next = NULL;
 				}
 			}
-
-			if (fat_entries[i].flags & FILE_IS_LAST_ENTRY) {
-				last_entry_found = true;
-				break;
-			}
-
-			/* Move to next fat_entry. */
-			fat_address += sizeof(struct rpmb_fat_entry);
 		}
+
+		if (fe->flags & FILE_IS_LAST_ENTRY)
+			last_entry_found = true;
 	}
 
 	if (current)
@@ -2403,8 +3042,7 @@ out:
 	mutex_unlock(&rpmb_mutex);
 	if (res != TEE_SUCCESS)
 		rpmb_fs_dir_free(dir);
-	if (fat_entries)
-		free(fat_entries);
+	fat_iter_final(&it);
 
 	return res;
 }
@@ -2490,9 +3128,11 @@ static TEE_Result rpmb_fs_open(struct tee_pobj *po, size_t *size,
 
 	mutex_lock(&rpmb_mutex);
 
+	wb_flush(NULL);
 	res = rpmb_fs_open_internal(fh, &po->uuid, false);
 	if (!res && size)
 		*size = fh->fat_entry.data_size;
+	fh->write_back = true;
 
 	mutex_unlock(&rpmb_mutex);
 
@@ -2518,6 +3158,7 @@ static TEE_Result rpmb_fs_create(struct tee_pobj *po, bool overwrite,
 		return TEE_ERROR_OUT_OF_MEMORY;
 
 	mutex_lock(&rpmb_mutex);
+	wb_flush(NULL);
 	res = rpmb_fs_open_internal(fh, &po->uuid, true);
 	if (res)
 		goto out;
@@ -2563,8 +3204,10 @@ static TEE_Result rpmb_fs_create(struct tee_pobj *po, bool overwrite,
 out:
 	if (res) {
 		rpmb_fs_remove_internal(fh);
+		tee_fs_fek_cache_wipe(&fh->fek_cache);
 		free(fh);
 	} else {
+		fh->write_back = true;
 		*ret_fh = (struct tee_file_handle *)fh;
 	}
 	mutex_unlock(&rpmb_mutex);
@@ -2600,6 +3243,7 @@ TEE_Result tee_rpmb_fs_raw_open(const char *fname, bool create,
 
 	mutex_lock(&rpmb_mutex);
 
+	wb_flush(NULL);
 	res = rpmb_fs_open_internal(fh, &uuid, create);
 
 	mutex_unlock(&rpmb_mutex);
@@ -9,6 +9,7 @@
 #include <kernel/tee_ta_manager.h>
 #include <kernel/tee_time.h>
 #include <kernel/trace_ta.h>
+#include <kernel/user_access.h>
 #include <mm/core_memprot.h>
 #include <mm/mobj.h>
 #include <mm/tee_mm.h>
@@ -550,11 +551,49 @@ static TEE_Result alloc_temp_sec_mem(size_t size, struct mobj **mobj,
 	return TEE_SUCCESS;
 }
 
+#ifdef CFG_TA_PARAM_ZERO_COPY
+/*
+ * Memory references covering whole pages of the private memory of the
+ * calling TA don't expose anything else, these pages are mapped in the
+ * called TA instead of being copied. Returns TEE_ERROR_NOT_SUPPORTED if
+ * the memory reference has to be copied.
+ */
+static TEE_Result map_private_memref(struct user_ta_ctx *utc,
+				     struct tee_ta_param *param, size_t n)
+{
+	uint32_t type = TEE_PARAM_TYPE_GET(param->types, n);
+	void *va = (void *)param->u[n].mem.offs;
+	size_t s = param->u[n].mem.size;
+
+	if (((vaddr_t)va & SMALL_PAGE_MASK) || (s & SMALL_PAGE_MASK))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	if (tee_mmu_vbuf_to_mobj_offs(utc, va, s, &param->u[n].mem.mobj,
+				      &param->u[n].mem.offs))
+		return TEE_ERROR_NOT_SUPPORTED;
+	/*
+	 * Access rights of the caller were checked by utee_param_to_param(),
+	 * the called TA mustn't be able to write to input buffers.
+	 */
+	param->u[n].mem.read_only = type == TEE_PARAM_TYPE_MEMREF_INPUT;
+
+	return TEE_SUCCESS;
+}
+#else
+static TEE_Result map_private_memref(struct user_ta_ctx *utc __unused,
+				     struct tee_ta_param *param __unused,
+				     size_t n __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
 /*
  * TA invokes some TA with parameter.
  * If some parameters are memory references:
  * - either the memref is inside TA private RAM: TA is not allowed to expose
- *   its private RAM: use a temporary memory buffer and copy the data.
+ *   its private RAM: use a temporary memory buffer and copy the data,
+ *   unless whole pages can be mapped with CFG_TA_PARAM_ZERO_COPY=y.
  * - or the memref is not in the TA private RAM:
  *   - if the memref was mapped to the TA, TA is allowed to expose it.
  *   - if so, converts memref virtual address into a physical address.
@@ -615,6 +654,11 @@ static TEE_Result tee_svc_copy_param(struct tee_ta_session *sess,
 			}
 			/* uTA cannot expose its private memory */
 			if (tee_mmu_is_vbuf_inside_ta_private(utc, va, s)) {
+				res = map_private_memref(utc, param, n);
+				if (res == TEE_SUCCESS)
+					break;
+				if (res != TEE_ERROR_NOT_SUPPORTED)
+					return res;
 
 				s = ROUNDUP(s, sizeof(uint32_t));
 				if (ADD_OVERFLOW(req_mem, s, &req_mem))
@@ -832,6 +876,84 @@ TEE_Result syscall_close_ta_session(unsigned long ta_sess)
 	return tee_ta_close_session(s, &utc->open_sessions, &clnt_id);
 }
 
+/*
+ * Invokes a command of a concurrent pseudo TA with the parameters of the
+ * calling TA used in place. Such a pseudo TA borrows the mapping of the
+ * calling TA and doesn't need its context to be made busy, so the
+ * parameter translation and the busy handling of tee_ta_invoke_command()
+ * are skipped. ldelf loading a TA makes many such calls to the system
+ * pseudo TA.
+ */
+static TEE_Result invoke_concurrent_pta(struct user_ta_ctx *utc,
+					struct tee_ta_session *called_sess,
+					uint32_t cmd, struct utee_params *up,
+					uint32_t *ret_o)
+{
+	TEE_Param params[TEE_NUM_PARAMS] = { };
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t types = 0;
+	size_t n = 0;
+
+	if (up) {
+		res = tee_mmu_check_access_rights(utc,
+			TEE_MEMORY_ACCESS_READ | TEE_MEMORY_ACCESS_ANY_OWNER,
+			(uaddr_t)up, sizeof(*up));
+		if (res != TEE_SUCCESS)
+			return res;
+		types = up->types;
+	}
+
+	for (n = 0; n < TEE_NUM_PARAMS; n++) {
+		uint32_t flags = TEE_MEMORY_ACCESS_READ |
+				 TEE_MEMORY_ACCESS_ANY_OWNER;
+		uintptr_t a = 0;
+		size_t b = 0;
+
+		switch (TEE_PARAM_TYPE_GET(types, n)) {
+		case TEE_PARAM_TYPE_MEMREF_OUTPUT:
+		case TEE_PARAM_TYPE_MEMREF_INOUT:
+			flags |= TEE_MEMORY_ACCESS_WRITE;
+			/*FALLTHROUGH*/
+		case TEE_PARAM_TYPE_MEMREF_INPUT:
+			a = up->vals[n * 2];
+			b = up->vals[n * 2 + 1];
+			if (tee_mmu_check_access_rights(utc, flags, a, b))
+				return TEE_ERROR_ACCESS_DENIED;
+			params[n].memref.buffer = (void *)a;
+			params[n].memref.size = b;
+			break;
+		case TEE_PARAM_TYPE_VALUE_INPUT:
+		case TEE_PARAM_TYPE_VALUE_INOUT:
+			params[n].value.a = up->vals[n * 2];
+			params[n].value.b = up->vals[n * 2 + 1];
+			break;
+		default:
+			break;
+		}
+	}
+
+	*ret_o = TEE_ORIGIN_TRUSTED_APP;
+	res = pseudo_ta_invoke_direct(called_sess, cmd, types, params);
+
+	for (n = 0; n < TEE_NUM_PARAMS; n++) {
+		switch (TEE_PARAM_TYPE_GET(types, n)) {
+		case TEE_PARAM_TYPE_MEMREF_OUTPUT:
+		case TEE_PARAM_TYPE_MEMREF_INOUT:
+			up->vals[n * 2 + 1] = params[n].memref.size;
+			break;
+		case TEE_PARAM_TYPE_VALUE_OUTPUT:
+		case TEE_PARAM_TYPE_VALUE_INOUT:
+			up->vals[n * 2] = params[n].value.a;
+			up->vals[n * 2 + 1] = params[n].value.b;
+			break;
+		default:
+			break;
+		}
+	}
+
+	return res;
+}
+
 TEE_Result syscall_invoke_ta_command(unsigned long ta_sess,
 			unsigned long cancel_req_to, unsigned long cmd_id,
 			struct utee_params *usr_param, uint32_t *ret_orig)
@@ -858,6 +980,14 @@ TEE_Result syscall_invoke_ta_command(unsigned long ta_sess,
 	if (!called_sess)
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	/* The client is the current TA, the owner of the session list */
+	if (called_sess->ctx && is_pseudo_ta_ctx(called_sess->ctx) &&
+	    (called_sess->ctx->flags & TA_FLAG_CONCURRENT)) {
+		res = invoke_concurrent_pta(utc, called_sess, cmd_id,
+					    usr_param, &ret_o);
+		goto function_exit;
+	}
+
 	clnt_id.login = TEE_LOGIN_TRUSTED_APP;
 	memcpy(&clnt_id.uuid, &sess->ctx->uuid, sizeof(TEE_UUID));
 
@@ -911,6 +1041,45 @@ TEE_Result syscall_check_access_rights(unsigned long flags, const void *buf,
 					   (uaddr_t)buf, len);
 }
 
+#ifdef CFG_CORE_USER_ACCESS_UNPRIV
+/*
+ * The user buffer is checked by the MMU while it's copied, no need to look
+ * it up in the regions of the TA first.
+ */
+TEE_Result tee_svc_copy_from_user(void *kaddr, const void *uaddr, size_t len)
+{
+	TEE_Result res;
+	struct tee_ta_session *s;
+	uaddr_t end_addr = 0;
+
+	res = tee_ta_get_current_session(&s);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (ADD_OVERFLOW((uaddr_t)uaddr, len, &end_addr) ||
+	    __copy_from_user_unpriv(kaddr, uaddr, len))
+		return TEE_ERROR_ACCESS_DENIED;
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result tee_svc_copy_to_user(void *uaddr, const void *kaddr, size_t len)
+{
+	TEE_Result res;
+	struct tee_ta_session *s;
+	uaddr_t end_addr = 0;
+
+	res = tee_ta_get_current_session(&s);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (ADD_OVERFLOW((uaddr_t)uaddr, len, &end_addr) ||
+	    __copy_to_user_unpriv(uaddr, kaddr, len))
+		return TEE_ERROR_ACCESS_DENIED;
+
+	return TEE_SUCCESS;
+}
+#else
 TEE_Result tee_svc_copy_from_user(void *kaddr, const void *uaddr, size_t len)
 {
 	TEE_Result res;
@@ -950,6 +1119,7 @@ TEE_Result tee_svc_copy_to_user(void *uaddr, const void *kaddr, size_t len)
 	memcpy(uaddr, kaddr, len);
 	return TEE_SUCCESS;
 }
+#endif /*CFG_CORE_USER_ACCESS_UNPRIV*/
 
 TEE_Result tee_svc_copy_kaddr_to_uref(uint32_t *uref, void *kaddr)
 {
@@ -1053,7 +1223,8 @@ TEE_Result syscall_get_time(unsigned long cat, TEE_Time *mytime)
 		res = tee_time_get_sys_time(&t);
 		break;
 	case UTEE_TIME_CAT_TA_PERSISTENT:
-		res = tee_time_get_ta_time((const void *)&s->ctx->uuid, &t);
+		res = tee_time_get_ta_time((const void *)&s->ctx->uuid,
+					   &s->ctx->time_offs, &t);
 		break;
 	case UTEE_TIME_CAT_REE:
 		res = tee_time_get_ree_time(&t);
@@ -1086,5 +1257,6 @@ TEE_Result syscall_set_ta_time(const TEE_Time *mytime)
 	if (res != TEE_SUCCESS)
 		return res;
 
-	return tee_time_set_ta_time((const void *)&s->ctx->uuid, &t);
+	return tee_time_set_ta_time((const void *)&s->ctx->uuid,
+				    &s->ctx->time_offs, &t);
 }
@@ -6,13 +6,16 @@
 #include <assert.h>
 #include <compiler.h>
 #include <crypto/crypto.h>
+#include <kernel/handle.h>
 #include <kernel/tee_ta_manager.h>
+#include <limits.h>
 #include <mm/tee_mmu.h>
 #include <stdlib_ext.h>
 #include <string_ext.h>
 #include <string.h>
 #include <sys/queue.h>
 #include <tee_api_types.h>
+#include <tee/tee_cryp_keypool.h>
 #include <tee/tee_cryp_utl.h>
 #include <tee/tee_obj.h>
 #include <tee/tee_svc_cryp.h>
@@ -39,13 +42,21 @@ enum cryp_state {
 typedef void (*tee_cryp_ctx_finalize_func_t) (void *ctx, uint32_t algo);
 struct tee_cryp_state {
 	TAILQ_ENTRY(tee_cryp_state) link;
+	uint32_t id;
 	uint32_t algo;
 	uint32_t mode;
-	vaddr_t key1;
-	vaddr_t key2;
+	uint32_t key1;
+	uint32_t key2;
 	void *ctx;
 	tee_cryp_ctx_finalize_func_t ctx_finalize;
 	enum cryp_state state;
+	/*
+	 * Set when ctx holds the keys of key1 and key2 at the generations
+	 * below, a new init with the same keys can then skip the key setup.
+	 */
+	bool keyed;
+	uint32_t key1_generation;
+	uint32_t key2_generation;
 };
 
 struct tee_cryp_obj_secret {
@@ -73,6 +84,8 @@ struct tee_cryp_obj_secret {
 #define ATTR_OPS_INDEX_BIGNUM     1
     /* Convert to/from value attribute depending on direction */
 #define ATTR_OPS_INDEX_VALUE      2
+    /* Fixed size little-endian byte array of Curve25519 keys */
+#define ATTR_OPS_INDEX_25519      3
 
 struct tee_cryp_obj_type_attrs {
 	uint32_t attr_id;
@@ -375,6 +388,54 @@ static const struct tee_cryp_obj_type_attrs tee_cryp_obj_ecc_keypair_attrs[] = {
 	},
 };
 
+#if defined(CFG_CRYPTO_X25519)
+static const struct tee_cryp_obj_type_attrs
+	tee_cryp_obj_x25519_keypair_attrs[] = {
+	{
+	.attr_id = TEE_ATTR_X25519_PRIVATE_VALUE,
+	.flags = TEE_TYPE_ATTR_REQUIRED,
+	.ops_index = ATTR_OPS_INDEX_25519,
+	RAW_DATA(struct x25519_keypair, priv)
+	},
+
+	{
+	.attr_id = TEE_ATTR_X25519_PUBLIC_VALUE,
+	.flags = TEE_TYPE_ATTR_REQUIRED | TEE_TYPE_ATTR_SIZE_INDICATOR,
+	.ops_index = ATTR_OPS_INDEX_25519,
+	RAW_DATA(struct x25519_keypair, pub)
+	},
+};
+#endif
+
+#if defined(CFG_CRYPTO_ED25519)
+static const struct tee_cryp_obj_type_attrs
+	tee_cryp_obj_ed25519_pub_key_attrs[] = {
+	{
+	.attr_id = TEE_ATTR_ED25519_PUBLIC_VALUE,
+	.flags = TEE_TYPE_ATTR_REQUIRED | TEE_TYPE_ATTR_SIZE_INDICATOR,
+	.ops_index = ATTR_OPS_INDEX_25519,
+	RAW_DATA(struct ed25519_public_key, pub)
+	},
+};
+
+static const struct tee_cryp_obj_type_attrs
+	tee_cryp_obj_ed25519_keypair_attrs[] = {
+	{
+	.attr_id = TEE_ATTR_ED25519_PRIVATE_VALUE,
+	.flags = TEE_TYPE_ATTR_REQUIRED,
+	.ops_index = ATTR_OPS_INDEX_25519,
+	RAW_DATA(struct ed25519_keypair, priv)
+	},
+
+	{
+	.attr_id = TEE_ATTR_ED25519_PUBLIC_VALUE,
+	.flags = TEE_TYPE_ATTR_REQUIRED | TEE_TYPE_ATTR_SIZE_INDICATOR,
+	.ops_index = ATTR_OPS_INDEX_25519,
+	RAW_DATA(struct ed25519_keypair, pub)
+	},
+};
+#endif
+
 struct tee_cryp_obj_type_props {
 	TEE_ObjectType obj_type;
 	uint16_t min_size;	/* may not be smaller than this */
@@ -430,6 +491,11 @@ static const struct tee_cryp_obj_type_props tee_cryp_obj_props[] = {
 	PROP(TEE_TYPE_GENERIC_SECRET, 8, 0, 4096,
 		4096 / 8 + sizeof(struct tee_cryp_obj_secret),
 		tee_cryp_obj_secret_value_attrs),
+#if defined(CFG_CRYPTO_CHACHA20_POLY1305)
+	PROP(TEE_TYPE_CHACHA20, 8, 256, 256,
+		256 / 8 + sizeof(struct tee_cryp_obj_secret),
+		tee_cryp_obj_secret_value_attrs),
+#endif
 #if defined(CFG_CRYPTO_HKDF)
 	PROP(TEE_TYPE_HKDF_IKM, 8, 0, 4096,
 		4096 / 8 + sizeof(struct tee_cryp_obj_secret),
@@ -480,6 +546,20 @@ static const struct tee_cryp_obj_type_props tee_cryp_obj_props[] = {
 	PROP(TEE_TYPE_ECDH_KEYPAIR, 1, 192, 521,
 		sizeof(struct ecc_keypair),
 		tee_cryp_obj_ecc_keypair_attrs),
+#if defined(CFG_CRYPTO_X25519)
+	PROP(TEE_TYPE_X25519_KEYPAIR, 1, 256, 256,
+		sizeof(struct x25519_keypair),
+		tee_cryp_obj_x25519_keypair_attrs),
+#endif
+#if defined(CFG_CRYPTO_ED25519)
+	PROP(TEE_TYPE_ED25519_PUBLIC_KEY, 1, 256, 256,
+		sizeof(struct ed25519_public_key),
+		tee_cryp_obj_ed25519_pub_key_attrs),
+
+	PROP(TEE_TYPE_ED25519_KEYPAIR, 1, 256, 256,
+		sizeof(struct ed25519_keypair),
+		tee_cryp_obj_ed25519_keypair_attrs),
+#endif
 };
 
 struct attr_ops {
@@ -801,6 +881,86 @@ static void op_attr_value_clear(void *attr)
 	*v = 0;
 }
 
+static TEE_Result op_attr_25519_from_user(void *attr, const void *buffer,
+					  size_t size)
+{
+	if (size != CURVE25519_KEY_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	memcpy(attr, buffer, size);
+	return TEE_SUCCESS;
+}
+
+static TEE_Result op_attr_25519_to_user(void *attr,
+					struct tee_ta_session *sess __unused,
+					void *buffer, uint64_t *size)
+{
+	TEE_Result res;
+	uint64_t s;
+	uint64_t req_size = CURVE25519_KEY_SIZE;
+
+	res = tee_svc_copy_from_user(&s, size, sizeof(s));
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = tee_svc_copy_to_user(size, &req_size, sizeof(req_size));
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (s < req_size || !buffer)
+		return TEE_ERROR_SHORT_BUFFER;
+
+	return tee_svc_copy_to_user(buffer, attr, req_size);
+}
+
+static TEE_Result op_attr_25519_to_binary(void *attr, void *data,
+					  size_t data_len, size_t *offs)
+{
+	TEE_Result res;
+	size_t next_offs;
+
+	res = op_u32_to_binary_helper(CURVE25519_KEY_SIZE, data, data_len,
+				      offs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (ADD_OVERFLOW(*offs, CURVE25519_KEY_SIZE, &next_offs))
+		return TEE_ERROR_OVERFLOW;
+
+	if (data && next_offs <= data_len)
+		memcpy((uint8_t *)data + *offs, attr, CURVE25519_KEY_SIZE);
+	(*offs) = next_offs;
+
+	return TEE_SUCCESS;
+}
+
+static bool op_attr_25519_from_binary(void *attr, const void *data,
+				      size_t data_len, size_t *offs)
+{
+	uint32_t s;
+
+	if (!op_u32_from_binary_helper(&s, data, data_len, offs))
+		return false;
+
+	if (s != CURVE25519_KEY_SIZE || (*offs + s) > data_len)
+		return false;
+
+	memcpy(attr, (const uint8_t *)data + *offs, s);
+	(*offs) += s;
+	return true;
+}
+
+static TEE_Result op_attr_25519_from_obj(void *attr, void *src_attr)
+{
+	memcpy(attr, src_attr, CURVE25519_KEY_SIZE);
+	return TEE_SUCCESS;
+}
+
+static void op_attr_25519_clear(void *attr)
+{
+	memset(attr, 0, CURVE25519_KEY_SIZE);
+}
+
 static const struct attr_ops attr_ops[] = {
 	[ATTR_OPS_INDEX_SECRET] = {
 		.from_user = op_attr_secret_value_from_user,
@@ -829,6 +989,15 @@ static const struct attr_ops attr_ops[] = {
 		.free = op_attr_value_clear, /* not a typo */
 		.clear = op_attr_value_clear,
 	},
+	[ATTR_OPS_INDEX_25519] = {
+		.from_user = op_attr_25519_from_user,
+		.to_user = op_attr_25519_to_user,
+		.to_binary = op_attr_25519_to_binary,
+		.from_binary = op_attr_25519_from_binary,
+		.from_obj = op_attr_25519_from_obj,
+		.free = op_attr_25519_clear, /* not a typo */
+		.clear = op_attr_25519_clear,
+	},
 };
 
 static TEE_Result get_user_u64_as_size_t(size_t *dst, uint64_t *src)
@@ -863,8 +1032,7 @@ TEE_Result syscall_cryp_obj_get_info(unsigned long obj, TEE_ObjectInfo *info)
 	if (res != TEE_SUCCESS)
 		goto exit;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -885,8 +1053,7 @@ TEE_Result syscall_cryp_obj_restrict_usage(unsigned long obj,
 	if (res != TEE_SUCCESS)
 		goto exit;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -961,8 +1128,7 @@ TEE_Result syscall_cryp_obj_get_attr(unsigned long obj, unsigned long attr_id,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return TEE_ERROR_ITEM_NOT_FOUND;
 
@@ -990,6 +1156,13 @@ TEE_Result syscall_cryp_obj_get_attr(unsigned long obj, unsigned long attr_id,
 	return ops->to_user(attr, sess, buffer, size);
 }
 
+/* Drops what the crypto library may have derived from the key */
+static void tee_obj_attr_clear_cache(struct tee_obj *o)
+{
+	if (o->info.objectType == TEE_TYPE_RSA_KEYPAIR)
+		crypto_acipher_clear_rsa_keypair_cache(o->attr);
+}
+
 void tee_obj_attr_free(struct tee_obj *o)
 {
 	const struct tee_cryp_obj_type_props *tp;
@@ -997,6 +1170,7 @@ void tee_obj_attr_free(struct tee_obj *o)
 
 	if (!o->attr)
 		return;
+	tee_obj_attr_clear_cache(o);
 	tp = tee_svc_find_type_props(o->info.objectType);
 	if (!tp)
 		return;
@@ -1015,6 +1189,7 @@ void tee_obj_attr_clear(struct tee_obj *o)
 
 	if (!o->attr)
 		return;
+	tee_obj_attr_clear_cache(o);
 	tp = tee_svc_find_type_props(o->info.objectType);
 	if (!tp)
 		return;
@@ -1075,6 +1250,7 @@ TEE_Result tee_obj_attr_from_binary(struct tee_obj *o, const void *data,
 	tp = tee_svc_find_type_props(o->info.objectType);
 	if (!tp)
 		return TEE_ERROR_BAD_STATE;
+	tee_obj_attr_clear_cache(o);
 
 	for (n = 0; n < tp->num_type_attrs; n++) {
 		const struct tee_cryp_obj_type_attrs *ta = tp->type_attrs + n;
@@ -1104,6 +1280,7 @@ TEE_Result tee_obj_attr_copy_from(struct tee_obj *o, const struct tee_obj *src)
 	tp = tee_svc_find_type_props(o->info.objectType);
 	if (!tp)
 		return TEE_ERROR_BAD_STATE;
+	tee_obj_attr_clear_cache(o);
 
 	if (o->info.objectType == src->info.objectType) {
 		have_attrs = src->have_attrs;
@@ -1131,6 +1308,9 @@ TEE_Result tee_obj_attr_copy_from(struct tee_obj *o, const struct tee_obj *src)
 		} else if (o->info.objectType == TEE_TYPE_ECDH_PUBLIC_KEY) {
 			if (src->info.objectType != TEE_TYPE_ECDH_KEYPAIR)
 				return TEE_ERROR_BAD_PARAMETERS;
+		} else if (o->info.objectType == TEE_TYPE_ED25519_PUBLIC_KEY) {
+			if (src->info.objectType != TEE_TYPE_ED25519_KEYPAIR)
+				return TEE_ERROR_BAD_PARAMETERS;
 		} else {
 			return TEE_ERROR_BAD_PARAMETERS;
 		}
@@ -1226,6 +1406,11 @@ TEE_Result tee_obj_set_type(struct tee_obj *o, uint32_t obj_type,
 	case TEE_TYPE_ECDH_KEYPAIR:
 		res = crypto_acipher_alloc_ecc_keypair(o->attr, max_key_size);
 		break;
+	case TEE_TYPE_X25519_KEYPAIR:
+	case TEE_TYPE_ED25519_PUBLIC_KEY:
+	case TEE_TYPE_ED25519_KEYPAIR:
+		/* Fixed size keys, nothing to pre-allocate */
+		break;
 	default:
 		if (obj_type != TEE_TYPE_DATA) {
 			struct tee_cryp_obj_secret *key = o->attr;
@@ -1270,9 +1455,13 @@ TEE_Result syscall_cryp_obj_alloc(unsigned long obj_type,
 		return res;
 	}
 
-	tee_obj_add(to_user_ta_ctx(sess->ctx), o);
+	res = tee_obj_add(to_user_ta_ctx(sess->ctx), o);
+	if (res != TEE_SUCCESS) {
+		tee_obj_free(o);
+		return res;
+	}
 
-	res = tee_svc_copy_kaddr_to_uref(obj, o);
+	res = tee_svc_copy_to_user(obj, &o->id, sizeof(o->id));
 	if (res != TEE_SUCCESS)
 		tee_obj_close(to_user_ta_ctx(sess->ctx), o);
 	return res;
@@ -1288,8 +1477,7 @@ TEE_Result syscall_cryp_obj_close(unsigned long obj)
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -1314,8 +1502,7 @@ TEE_Result syscall_cryp_obj_reset(unsigned long obj)
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -1329,6 +1516,7 @@ TEE_Result syscall_cryp_obj_reset(unsigned long obj)
 
 	/* the object is no more initialized */
 	o->info.handleFlags &= ~TEE_HANDLE_FLAG_INITIALIZED;
+	o->generation++;
 
 	return TEE_SUCCESS;
 }
@@ -1372,6 +1560,46 @@ static TEE_Result copy_in_attrs(struct user_ta_ctx *utc,
 	return TEE_SUCCESS;
 }
 
+/*
+ * Most operations are passed only a few attributes, these are described
+ * in an array on the stack instead of an allocated one. The data of the
+ * attributes is in either case accessed in place in TA memory.
+ */
+#define NUM_STACK_ATTRS		4
+
+static TEE_Result get_user_attrs(struct user_ta_ctx *utc,
+				 const struct utee_attribute *usr_attrs,
+				 uint32_t attr_count,
+				 TEE_Attribute stack_attrs[NUM_STACK_ATTRS],
+				 TEE_Attribute **attrs)
+{
+	size_t alloc_size = 0;
+
+	if (attr_count <= NUM_STACK_ATTRS) {
+		*attrs = stack_attrs;
+	} else {
+		if (MUL_OVERFLOW(sizeof(TEE_Attribute), attr_count,
+				 &alloc_size))
+			return TEE_ERROR_OVERFLOW;
+
+		*attrs = malloc(alloc_size);
+		if (!*attrs)
+			return TEE_ERROR_OUT_OF_MEMORY;
+	}
+
+	return copy_in_attrs(utc, usr_attrs, attr_count, *attrs);
+}
+
+static void put_user_attrs(TEE_Attribute *attrs,
+			   TEE_Attribute stack_attrs[NUM_STACK_ATTRS])
+{
+	if (attrs == stack_attrs)
+		memzero_explicit(stack_attrs,
+				 sizeof(TEE_Attribute) * NUM_STACK_ATTRS);
+	else
+		free_wipe(attrs);
+}
+
 enum attr_usage {
 	ATTR_USAGE_POPULATE,
 	ATTR_USAGE_GENERATE_KEY
@@ -1557,40 +1785,33 @@ TEE_Result syscall_cryp_obj_populate(unsigned long obj,
 	struct tee_ta_session *sess;
 	struct tee_obj *o;
 	const struct tee_cryp_obj_type_props *type_props;
+	TEE_Attribute stack_attrs[NUM_STACK_ATTRS];
 	TEE_Attribute *attrs = NULL;
 
 	res = tee_ta_get_current_session(&sess);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	/* Must be a transient object */
+	/*
+	 * Must be a transient object which isn't initialized already.
+	 * TEE_ERROR_BAD_PARAMETERS is reserved for invalid attributes, the
+	 * caller panics on any other error.
+	 */
 	if ((o->info.handleFlags & TEE_HANDLE_FLAG_PERSISTENT) != 0)
-		return TEE_ERROR_BAD_PARAMETERS;
-
-	/* Must not be initialized already */
+		return TEE_ERROR_BAD_STATE;
 	if ((o->info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) != 0)
-		return TEE_ERROR_BAD_PARAMETERS;
+		return TEE_ERROR_BAD_STATE;
 
 	type_props = tee_svc_find_type_props(o->info.objectType);
 	if (!type_props)
 		return TEE_ERROR_NOT_IMPLEMENTED;
 
-	size_t alloc_size = 0;
-
-	if (MUL_OVERFLOW(sizeof(TEE_Attribute), attr_count, &alloc_size))
-		return TEE_ERROR_OVERFLOW;
-
-	attrs = malloc(alloc_size);
-	if (!attrs)
-		return TEE_ERROR_OUT_OF_MEMORY;
-
-	res = copy_in_attrs(to_user_ta_ctx(sess->ctx), usr_attrs, attr_count,
-			    attrs);
+	res = get_user_attrs(to_user_ta_ctx(sess->ctx), usr_attrs, attr_count,
+			     stack_attrs, &attrs);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -1604,7 +1825,7 @@ TEE_Result syscall_cryp_obj_populate(unsigned long obj,
 		o->info.handleFlags |= TEE_HANDLE_FLAG_INITIALIZED;
 
 out:
-	free_wipe(attrs);
+	put_user_attrs(attrs, stack_attrs);
 	return res;
 }
 
@@ -1619,13 +1840,11 @@ TEE_Result syscall_cryp_obj_copy(unsigned long dst, unsigned long src)
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  tee_svc_uref_to_vaddr(dst), &dst_o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), dst, &dst_o);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  tee_svc_uref_to_vaddr(src), &src_o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), src, &src_o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -1690,7 +1909,7 @@ static TEE_Result tee_svc_obj_generate_key_dsa(
 
 static TEE_Result tee_svc_obj_generate_key_dh(
 	struct tee_obj *o, const struct tee_cryp_obj_type_props *type_props,
-	uint32_t key_size __unused,
+	uint32_t key_size,
 	const TEE_Attribute *params, uint32_t param_count)
 {
 	TEE_Result res;
@@ -1710,9 +1929,11 @@ static TEE_Result tee_svc_obj_generate_key_dh(
 		dh_q = tee_dh_key->q;
 	if (get_attribute(o, type_props, TEE_ATTR_DH_X_BITS))
 		dh_xbits = tee_dh_key->xbits;
-	res = crypto_acipher_gen_dh_key(tee_dh_key, dh_q, dh_xbits);
-	if (res != TEE_SUCCESS)
-		return res;
+	if (!tee_cryp_keypool_get_dh(tee_dh_key, dh_q, dh_xbits, key_size)) {
+		res = crypto_acipher_gen_dh_key(tee_dh_key, dh_q, dh_xbits);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
 
 	/* Set bits for the generated public and private key */
 	set_attribute(o, type_props, TEE_ATTR_DH_PUBLIC_VALUE);
@@ -1728,6 +1949,7 @@ static TEE_Result tee_svc_obj_generate_key_ecc(
 {
 	TEE_Result res;
 	struct ecc_keypair *tee_ecc_key;
+	size_t curve_size = 0;
 
 	/* Copy the present attributes into the obj before starting */
 	res = tee_svc_cryp_obj_populate_type(o, type_props, params,
@@ -1737,9 +1959,12 @@ static TEE_Result tee_svc_obj_generate_key_ecc(
 
 	tee_ecc_key = (struct ecc_keypair *)o->attr;
 
-	res = crypto_acipher_gen_ecc_key(tee_ecc_key);
-	if (res != TEE_SUCCESS)
-		return res;
+	if (get_ec_key_size(tee_ecc_key->curve, &curve_size) ||
+	    !tee_cryp_keypool_get_ecc(tee_ecc_key, curve_size)) {
+		res = crypto_acipher_gen_ecc_key(tee_ecc_key);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
 
 	/* Set bits for the generated public and private key */
 	set_attribute(o, type_props, TEE_ATTR_ECC_PRIVATE_VALUE);
@@ -1749,6 +1974,40 @@ static TEE_Result tee_svc_obj_generate_key_ecc(
 	return TEE_SUCCESS;
 }
 
+#if defined(CFG_CRYPTO_X25519)
+static TEE_Result tee_svc_obj_generate_key_x25519(
+	struct tee_obj *o, const struct tee_cryp_obj_type_props *type_props)
+{
+	TEE_Result res;
+
+	res = crypto_acipher_gen_x25519_key(o->attr);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	/* Set bits for the generated public and private key */
+	set_attribute(o, type_props, TEE_ATTR_X25519_PRIVATE_VALUE);
+	set_attribute(o, type_props, TEE_ATTR_X25519_PUBLIC_VALUE);
+	return TEE_SUCCESS;
+}
+#endif
+
+#if defined(CFG_CRYPTO_ED25519)
+static TEE_Result tee_svc_obj_generate_key_ed25519(
+	struct tee_obj *o, const struct tee_cryp_obj_type_props *type_props)
+{
+	TEE_Result res;
+
+	res = crypto_acipher_gen_ed25519_key(o->attr);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	/* Set bits for the generated public and private key */
+	set_attribute(o, type_props, TEE_ATTR_ED25519_PRIVATE_VALUE);
+	set_attribute(o, type_props, TEE_ATTR_ED25519_PUBLIC_VALUE);
+	return TEE_SUCCESS;
+}
+#endif
+
 TEE_Result syscall_obj_generate_key(unsigned long obj, unsigned long key_size,
 			const struct utee_attribute *usr_params,
 			unsigned long param_count)
@@ -1759,14 +2018,14 @@ TEE_Result syscall_obj_generate_key(unsigned long obj, unsigned long key_size,
 	struct tee_obj *o;
 	struct tee_cryp_obj_secret *key;
 	size_t byte_size;
+	TEE_Attribute stack_params[NUM_STACK_ATTRS];
 	TEE_Attribute *params = NULL;
 
 	res = tee_ta_get_current_session(&sess);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -1791,16 +2050,8 @@ TEE_Result syscall_obj_generate_key(unsigned long obj, unsigned long key_size,
 	if (key_size > type_props->max_size)
 		return TEE_ERROR_NOT_SUPPORTED;
 
-	size_t alloc_size = 0;
-
-	if (MUL_OVERFLOW(sizeof(TEE_Attribute), param_count, &alloc_size))
-		return TEE_ERROR_OVERFLOW;
-
-	params = malloc(alloc_size);
-	if (!params)
-		return TEE_ERROR_OUT_OF_MEMORY;
-	res = copy_in_attrs(to_user_ta_ctx(sess->ctx), usr_params, param_count,
-			    params);
+	res = get_user_attrs(to_user_ta_ctx(sess->ctx), usr_params,
+			     param_count, stack_params, &params);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -1820,6 +2071,9 @@ TEE_Result syscall_obj_generate_key(unsigned long obj, unsigned long key_size,
 	case TEE_TYPE_HMAC_SHA384:
 	case TEE_TYPE_HMAC_SHA512:
 	case TEE_TYPE_GENERIC_SECRET:
+#if defined(CFG_CRYPTO_CHACHA20_POLY1305)
+	case TEE_TYPE_CHACHA20:
+#endif
 		byte_size = key_size / 8;
 
 		/*
@@ -1876,12 +2130,28 @@ TEE_Result syscall_obj_generate_key(unsigned long obj, unsigned long key_size,
 			goto out;
 		break;
 
+#if defined(CFG_CRYPTO_X25519)
+	case TEE_TYPE_X25519_KEYPAIR:
+		res = tee_svc_obj_generate_key_x25519(o, type_props);
+		if (res != TEE_SUCCESS)
+			goto out;
+		break;
+#endif
+
+#if defined(CFG_CRYPTO_ED25519)
+	case TEE_TYPE_ED25519_KEYPAIR:
+		res = tee_svc_obj_generate_key_ed25519(o, type_props);
+		if (res != TEE_SUCCESS)
+			goto out;
+		break;
+#endif
+
 	default:
 		res = TEE_ERROR_BAD_FORMAT;
 	}
 
 out:
-	free_wipe(params);
+	put_user_attrs(params, stack_params);
 	if (res == TEE_SUCCESS) {
 		o->info.keySize = key_size;
 		o->info.handleFlags |= TEE_HANDLE_FLAG_INITIALIZED;
@@ -1893,16 +2163,52 @@ static TEE_Result tee_svc_cryp_get_state(struct tee_ta_session *sess,
 					 uint32_t state_id,
 					 struct tee_cryp_state **state)
 {
-	struct tee_cryp_state *s;
 	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	struct tee_cryp_state *s = NULL;
 
-	TAILQ_FOREACH(s, &utc->cryp_states, link) {
-		if (state_id == (vaddr_t)s) {
-			*state = s;
-			return TEE_SUCCESS;
-		}
-	}
-	return TEE_ERROR_BAD_PARAMETERS;
+	if (!state_id || state_id > INT_MAX)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	s = handle_lookup(&utc->cryp_state_db, state_id - 1);
+	if (!s)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	*state = s;
+	return TEE_SUCCESS;
+}
+
+/*
+ * Returns true if cs->ctx was last set up with the keys currently held by
+ * the key objects of the state, so that a new init only has to restart
+ * it with crypto_*_reinit().
+ */
+static bool cryp_state_is_keyed(struct user_ta_ctx *utc,
+				struct tee_cryp_state *cs)
+{
+	struct tee_obj *o = NULL;
+
+	if (!cs->keyed)
+		return false;
+	if (tee_obj_get(utc, cs->key1, &o) ||
+	    o->generation != cs->key1_generation)
+		return false;
+	if (!tee_obj_get(utc, cs->key2, &o) &&
+	    o->generation != cs->key2_generation)
+		return false;
+
+	return true;
+}
+
+static void cryp_state_set_keyed(struct user_ta_ctx *utc,
+				 struct tee_cryp_state *cs)
+{
+	struct tee_obj *o = NULL;
+
+	if (!tee_obj_get(utc, cs->key1, &o))
+		cs->key1_generation = o->generation;
+	if (!tee_obj_get(utc, cs->key2, &o))
+		cs->key2_generation = o->generation;
+	cs->keyed = true;
 }
 
 static void cryp_state_free(struct user_ta_ctx *utc, struct tee_cryp_state *cs)
@@ -1915,6 +2221,7 @@ static void cryp_state_free(struct user_ta_ctx *utc, struct tee_cryp_state *cs)
 		tee_obj_close(utc, o);
 
 	TAILQ_REMOVE(&utc->cryp_states, cs, link);
+	handle_put(&utc->cryp_state_db, cs->id - 1);
 	if (cs->ctx_finalize != NULL)
 		cs->ctx_finalize(cs->ctx, cs->algo);
 
@@ -1994,11 +2301,28 @@ static TEE_Result tee_svc_cryp_check_key_type(const struct tee_obj *o,
 	case TEE_MAIN_ALGO_ECDH:
 		req_key_type = TEE_TYPE_ECDH_KEYPAIR;
 		break;
+#if defined(CFG_CRYPTO_X25519)
+	case TEE_MAIN_ALGO_X25519:
+		req_key_type = TEE_TYPE_X25519_KEYPAIR;
+		break;
+#endif
+#if defined(CFG_CRYPTO_ED25519)
+	case TEE_MAIN_ALGO_ED25519:
+		req_key_type = TEE_TYPE_ED25519_KEYPAIR;
+		if (mode == TEE_MODE_VERIFY)
+			req_key_type2 = TEE_TYPE_ED25519_PUBLIC_KEY;
+		break;
+#endif
 #if defined(CFG_CRYPTO_HKDF)
 	case TEE_MAIN_ALGO_HKDF:
 		req_key_type = TEE_TYPE_HKDF_IKM;
 		break;
 #endif
+#if defined(CFG_CRYPTO_CHACHA20_POLY1305)
+	case TEE_MAIN_ALGO_CHACHA20:
+		req_key_type = TEE_TYPE_CHACHA20;
+		break;
+#endif
 #if defined(CFG_CRYPTO_CONCAT_KDF)
 	case TEE_MAIN_ALGO_CONCAT_KDF:
 		req_key_type = TEE_TYPE_CONCAT_KDF_Z;
@@ -2029,6 +2353,7 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 	struct tee_obj *o1 = NULL;
 	struct tee_obj *o2 = NULL;
 	struct user_ta_ctx *utc;
+	int handle = 0;
 
 	res = tee_ta_get_current_session(&sess);
 	if (res != TEE_SUCCESS)
@@ -2036,7 +2361,7 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 	utc = to_user_ta_ctx(sess->ctx);
 
 	if (key1 != 0) {
-		res = tee_obj_get(utc, tee_svc_uref_to_vaddr(key1), &o1);
+		res = tee_obj_get(utc, key1, &o1);
 		if (res != TEE_SUCCESS)
 			return res;
 		if (o1->busy)
@@ -2046,7 +2371,7 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 			return res;
 	}
 	if (key2 != 0) {
-		res = tee_obj_get(utc, tee_svc_uref_to_vaddr(key2), &o2);
+		res = tee_obj_get(utc, key2, &o2);
 		if (res != TEE_SUCCESS)
 			return res;
 		if (o2->busy)
@@ -2059,6 +2384,12 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 	cs = calloc(1, sizeof(struct tee_cryp_state));
 	if (!cs)
 		return TEE_ERROR_OUT_OF_MEMORY;
+	handle = handle_get(&utc->cryp_state_db, cs);
+	if (handle < 0) {
+		free(cs);
+		return TEE_ERROR_OUT_OF_MEMORY;
+	}
+	cs->id = handle + 1;
 	TAILQ_INSERT_TAIL(&utc->cryp_states, cs, link);
 	cs->algo = algo;
 	cs->mode = mode;
@@ -2126,18 +2457,18 @@ rsassa_na1: __maybe_unused
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = tee_svc_copy_kaddr_to_uref(state, cs);
+	res = tee_svc_copy_to_user(state, &cs->id, sizeof(cs->id));
 	if (res != TEE_SUCCESS)
 		goto out;
 
 	/* Register keys */
 	if (o1 != NULL) {
 		o1->busy = true;
-		cs->key1 = (vaddr_t)o1;
+		cs->key1 = o1->id;
 	}
 	if (o2 != NULL) {
 		o2->busy = true;
-		cs->key2 = (vaddr_t)o2;
+		cs->key2 = o2->id;
 	}
 
 out:
@@ -2157,11 +2488,11 @@ TEE_Result syscall_cryp_state_copy(unsigned long dst, unsigned long src)
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(dst), &cs_dst);
+	res = tee_svc_cryp_get_state(sess, dst, &cs_dst);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(src), &cs_src);
+	res = tee_svc_cryp_get_state(sess, src, &cs_src);
 	if (res != TEE_SUCCESS)
 		return res;
 	if (cs_dst->algo != cs_src->algo || cs_dst->mode != cs_src->mode)
@@ -2187,6 +2518,8 @@ TEE_Result syscall_cryp_state_copy(unsigned long dst, unsigned long src)
 	}
 
 	cs_dst->state = cs_src->state;
+	/* The keys of cs_dst may differ from those now in its context */
+	cs_dst->keyed = false;
 
 	return TEE_SUCCESS;
 }
@@ -2197,6 +2530,7 @@ void tee_svc_cryp_free_states(struct user_ta_ctx *utc)
 
 	while (!TAILQ_EMPTY(states))
 		cryp_state_free(utc, TAILQ_FIRST(states));
+	handle_db_destroy(&utc->cryp_state_db, NULL);
 }
 
 TEE_Result syscall_cryp_state_free(unsigned long state)
@@ -2209,7 +2543,7 @@ TEE_Result syscall_cryp_state_free(unsigned long state)
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 	cryp_state_free(to_user_ta_ctx(sess->ctx), cs);
@@ -2228,7 +2562,7 @@ TEE_Result syscall_hash_init(unsigned long state,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2240,11 +2574,15 @@ TEE_Result syscall_hash_init(unsigned long state,
 		break;
 	case TEE_OPERATION_MAC:
 		{
+			struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
 			struct tee_obj *o;
 			struct tee_cryp_obj_secret *key;
 
-			res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-					  cs->key1, &o);
+			if (cryp_state_is_keyed(utc, cs) &&
+			    !crypto_mac_reinit(cs->ctx, cs->algo))
+				break;
+
+			res = tee_obj_get(utc, cs->key1, &o);
 			if (res != TEE_SUCCESS)
 				return res;
 			if ((o->info.handleFlags &
@@ -2252,10 +2590,12 @@ TEE_Result syscall_hash_init(unsigned long state,
 				return TEE_ERROR_BAD_PARAMETERS;
 
 			key = (struct tee_cryp_obj_secret *)o->attr;
+			cs->keyed = false;
 			res = crypto_mac_init(cs->ctx, cs->algo,
 					      (void *)(key + 1), key->key_size);
 			if (res != TEE_SUCCESS)
 				return res;
+			cryp_state_set_keyed(utc, cs);
 			break;
 		}
 	default:
@@ -2267,6 +2607,33 @@ TEE_Result syscall_hash_init(unsigned long state,
 	return TEE_SUCCESS;
 }
 
+static TEE_Result hash_update(struct tee_ta_session *sess,
+			      struct tee_cryp_state *cs, const void *chunk,
+			      size_t chunk_size)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	res = tee_mmu_check_access_rights(to_user_ta_ctx(sess->ctx),
+					  TEE_MEMORY_ACCESS_READ |
+					  TEE_MEMORY_ACCESS_ANY_OWNER,
+					  (uaddr_t)chunk, chunk_size);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (cs->state != CRYP_STATE_INITIALIZED)
+		return TEE_ERROR_BAD_STATE;
+
+	switch (TEE_ALG_GET_CLASS(cs->algo)) {
+	case TEE_OPERATION_DIGEST:
+		return crypto_hash_update(cs->ctx, cs->algo, chunk,
+					  chunk_size);
+	case TEE_OPERATION_MAC:
+		return crypto_mac_update(cs->ctx, cs->algo, chunk, chunk_size);
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+}
+
 TEE_Result syscall_hash_update(unsigned long state, const void *chunk,
 			size_t chunk_size)
 {
@@ -2286,36 +2653,11 @@ TEE_Result syscall_hash_update(unsigned long state, const void *chunk,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_mmu_check_access_rights(to_user_ta_ctx(sess->ctx),
-					  TEE_MEMORY_ACCESS_READ |
-					  TEE_MEMORY_ACCESS_ANY_OWNER,
-					  (uaddr_t)chunk, chunk_size);
-	if (res != TEE_SUCCESS)
-		return res;
-
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	if (cs->state != CRYP_STATE_INITIALIZED)
-		return TEE_ERROR_BAD_STATE;
-
-	switch (TEE_ALG_GET_CLASS(cs->algo)) {
-	case TEE_OPERATION_DIGEST:
-		res = crypto_hash_update(cs->ctx, cs->algo, chunk, chunk_size);
-		if (res != TEE_SUCCESS)
-			return res;
-		break;
-	case TEE_OPERATION_MAC:
-		res = crypto_mac_update(cs->ctx, cs->algo, chunk, chunk_size);
-		if (res != TEE_SUCCESS)
-			return res;
-		break;
-	default:
-		return TEE_ERROR_BAD_PARAMETERS;
-	}
-
-	return TEE_SUCCESS;
+	return hash_update(sess, cs, chunk, chunk_size);
 }
 
 TEE_Result syscall_hash_final(unsigned long state, const void *chunk,
@@ -2354,7 +2696,7 @@ TEE_Result syscall_hash_final(unsigned long state, const void *chunk,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2414,34 +2756,29 @@ out:
 	return res;
 }
 
-TEE_Result syscall_cipher_init(unsigned long state, const void *iv,
-			size_t iv_len)
+/*
+ * Saves a system call per message for one-shot digests and MACs, the state
+ * is initialized even if the final operation fails.
+ */
+TEE_Result syscall_hash_init_final(unsigned long state, const void *chunk,
+				   size_t chunk_size, void *hash,
+				   uint64_t *hash_len)
 {
-	TEE_Result res;
-	struct tee_cryp_state *cs;
-	struct tee_ta_session *sess;
-	struct tee_obj *o;
-	struct tee_cryp_obj_secret *key1;
-	struct user_ta_ctx *utc;
+	TEE_Result res = syscall_hash_init(state, NULL, 0);
 
-	res = tee_ta_get_current_session(&sess);
 	if (res != TEE_SUCCESS)
 		return res;
-	utc = to_user_ta_ctx(sess->ctx);
 
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(state), &cs);
-	if (res != TEE_SUCCESS)
-		return res;
-
-	if (TEE_ALG_GET_CLASS(cs->algo) != TEE_OPERATION_CIPHER)
-		return TEE_ERROR_BAD_STATE;
+	return syscall_hash_final(state, chunk, chunk_size, hash, hash_len);
+}
 
-	res = tee_mmu_check_access_rights(utc,
-					  TEE_MEMORY_ACCESS_READ |
-					  TEE_MEMORY_ACCESS_ANY_OWNER,
-					  (uaddr_t) iv, iv_len);
-	if (res != TEE_SUCCESS)
-		return res;
+static TEE_Result cipher_init_keys(struct user_ta_ctx *utc,
+				   struct tee_cryp_state *cs, const void *iv,
+				   size_t iv_len)
+{
+	TEE_Result res;
+	struct tee_obj *o;
+	struct tee_cryp_obj_secret *key1;
 
 	res = tee_obj_get(utc, cs->key1, &o);
 	if (res != TEE_SUCCESS)
@@ -2469,29 +2806,67 @@ TEE_Result syscall_cipher_init(unsigned long state, const void *iv,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	cs->ctx_finalize = crypto_cipher_final;
-	cs->state = CRYP_STATE_INITIALIZED;
+	cryp_state_set_keyed(utc, cs);
 
 	return TEE_SUCCESS;
 }
 
-static TEE_Result tee_svc_cipher_update_helper(unsigned long state,
-			bool last_block, const void *src, size_t src_len,
-			void *dst, uint64_t *dst_len)
+TEE_Result syscall_cipher_init(unsigned long state, const void *iv,
+			size_t iv_len)
 {
 	TEE_Result res;
 	struct tee_cryp_state *cs;
 	struct tee_ta_session *sess;
-	size_t dlen = 0;
+	struct user_ta_ctx *utc;
 
 	res = tee_ta_get_current_session(&sess);
 	if (res != TEE_SUCCESS)
 		return res;
+	utc = to_user_ta_ctx(sess->ctx);
+
+	res = tee_svc_cryp_get_state(sess, state, &cs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (TEE_ALG_GET_CLASS(cs->algo) != TEE_OPERATION_CIPHER)
+		return TEE_ERROR_BAD_STATE;
+
+	res = tee_mmu_check_access_rights(utc,
+					  TEE_MEMORY_ACCESS_READ |
+					  TEE_MEMORY_ACCESS_ANY_OWNER,
+					  (uaddr_t) iv, iv_len);
+	if (res != TEE_SUCCESS)
+		return res;
 
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(state), &cs);
+	/* Only the IV changes if the keys are the same as last time */
+	res = TEE_ERROR_NOT_SUPPORTED;
+	if (cryp_state_is_keyed(utc, cs))
+		res = crypto_cipher_reinit(cs->ctx, cs->algo, cs->mode, iv,
+					   iv_len);
+	if (res == TEE_ERROR_NOT_SUPPORTED) {
+		cs->keyed = false;
+		res = cipher_init_keys(utc, cs, iv, iv_len);
+	}
 	if (res != TEE_SUCCESS)
 		return res;
 
+	cs->ctx_finalize = crypto_cipher_final;
+	cs->state = CRYP_STATE_INITIALIZED;
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * *dlen is the size of @dst on entry and the length of the output on
+ * return, also with TEE_ERROR_SHORT_BUFFER.
+ */
+static TEE_Result cipher_update(struct tee_ta_session *sess,
+				struct tee_cryp_state *cs, bool last_block,
+				const void *src, size_t src_len, void *dst,
+				size_t *dlen)
+{
+	TEE_Result res = TEE_SUCCESS;
+
 	if (cs->state != CRYP_STATE_INITIALIZED)
 		return TEE_ERROR_BAD_STATE;
 
@@ -2502,23 +2877,17 @@ static TEE_Result tee_svc_cipher_update_helper(unsigned long state,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	if (!dst_len) {
-		dlen = 0;
-	} else {
-		res = get_user_u64_as_size_t(&dlen, dst_len);
-		if (res != TEE_SUCCESS)
-			return res;
-
+	if (*dlen) {
 		res = tee_mmu_check_access_rights(to_user_ta_ctx(sess->ctx),
 						  TEE_MEMORY_ACCESS_READ |
 						  TEE_MEMORY_ACCESS_WRITE |
 						  TEE_MEMORY_ACCESS_ANY_OWNER,
-						  (uaddr_t)dst, dlen);
+						  (uaddr_t)dst, *dlen);
 		if (res != TEE_SUCCESS)
 			return res;
 	}
 
-	if (dlen < src_len) {
+	if (*dlen < src_len) {
 		res = TEE_ERROR_SHORT_BUFFER;
 		goto out;
 	}
@@ -2535,11 +2904,39 @@ static TEE_Result tee_svc_cipher_update_helper(unsigned long state,
 	}
 
 out:
+	*dlen = src_len;
+	return res;
+}
+
+static TEE_Result tee_svc_cipher_update_helper(unsigned long state,
+			bool last_block, const void *src, size_t src_len,
+			void *dst, uint64_t *dst_len)
+{
+	TEE_Result res;
+	struct tee_cryp_state *cs;
+	struct tee_ta_session *sess;
+	size_t dlen = 0;
+
+	res = tee_ta_get_current_session(&sess);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = tee_svc_cryp_get_state(sess, state, &cs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (dst_len) {
+		res = get_user_u64_as_size_t(&dlen, dst_len);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
+
+	res = cipher_update(sess, cs, last_block, src, src_len, dst, &dlen);
 	if ((res == TEE_SUCCESS || res == TEE_ERROR_SHORT_BUFFER) &&
 	    dst_len != NULL) {
 		TEE_Result res2;
 
-		res2 = put_user_u64(dst_len, src_len);
+		res2 = put_user_u64(dst_len, dlen);
 		if (res2 != TEE_SUCCESS)
 			res = res2;
 	}
@@ -2561,6 +2958,160 @@ TEE_Result syscall_cipher_final(unsigned long state, const void *src,
 					    src, src_len, dst, dst_len);
 }
 
+static TEE_Result cryp_update(struct tee_ta_session *sess,
+			      struct utee_cryp_update *upd)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_cryp_state *cs = NULL;
+	size_t dlen = 0;
+
+	res = tee_svc_cryp_get_state(sess, upd->state, &cs);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (upd->src_len > SIZE_MAX || upd->dst_len > SIZE_MAX ||
+	    (!upd->src && upd->src_len))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	switch (TEE_ALG_GET_CLASS(cs->algo)) {
+	case TEE_OPERATION_CIPHER:
+		dlen = upd->dst_len;
+		res = cipher_update(sess, cs, false /* last_block */,
+				    (void *)(vaddr_t)upd->src, upd->src_len,
+				    (void *)(vaddr_t)upd->dst, &dlen);
+		upd->dst_len = dlen;
+		return res;
+	case TEE_OPERATION_DIGEST:
+	case TEE_OPERATION_MAC:
+		upd->dst_len = 0;
+		if (!upd->src_len)
+			return TEE_SUCCESS;
+		return hash_update(sess, cs, (void *)(vaddr_t)upd->src,
+				   upd->src_len);
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+}
+
+/*
+ * Applies the leading updates in @upd which are AES-CBC encryptions of the
+ * same length on different states with one call, so the streams can be
+ * processed interleaved. *@count is the number of updates done, 0 if
+ * fewer than two qualify.
+ */
+static TEE_Result cipher_update_multi(struct tee_ta_session *sess,
+				      struct utee_cryp_update *upd,
+				      size_t num, size_t *count)
+{
+	struct tee_cryp_state *cs[CRYPTO_CIPHER_UPDATE_MULTI_MAX] = { };
+	void *ctx[CRYPTO_CIPHER_UPDATE_MULTI_MAX] = { };
+	const uint8_t *src[CRYPTO_CIPHER_UPDATE_MULTI_MAX] = { };
+	uint8_t *dst[CRYPTO_CIPHER_UPDATE_MULTI_MAX] = { };
+	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	uint64_t len = upd->src_len;
+	TEE_Result res = TEE_SUCCESS;
+	size_t m = 0;
+	size_t n = 0;
+
+	*count = 0;
+	if (!len || len > SIZE_MAX || len % TEE_AES_BLOCK_SIZE)
+		return TEE_SUCCESS;
+
+	num = MIN(num, (size_t)CRYPTO_CIPHER_UPDATE_MULTI_MAX);
+	for (n = 0; n < num; n++) {
+		if (upd[n].src_len != len || upd[n].dst_len < len)
+			break;
+		if (tee_svc_cryp_get_state(sess, upd[n].state, cs + n))
+			break;
+		if (cs[n]->algo != TEE_ALG_AES_CBC_NOPAD ||
+		    cs[n]->mode != TEE_MODE_ENCRYPT ||
+		    cs[n]->state != CRYP_STATE_INITIALIZED)
+			break;
+		for (m = 0; m < n; m++)
+			if (cs[m] == cs[n])
+				break;
+		if (m < n)
+			break;
+
+		src[n] = (const uint8_t *)(vaddr_t)upd[n].src;
+		dst[n] = (uint8_t *)(vaddr_t)upd[n].dst;
+		if (tee_mmu_check_access_rights(utc,
+						TEE_MEMORY_ACCESS_READ |
+						TEE_MEMORY_ACCESS_ANY_OWNER,
+						(uaddr_t)src[n], len) ||
+		    tee_mmu_check_access_rights(utc,
+						TEE_MEMORY_ACCESS_READ |
+						TEE_MEMORY_ACCESS_WRITE |
+						TEE_MEMORY_ACCESS_ANY_OWNER,
+						(uaddr_t)dst[n], len))
+			break;
+		ctx[n] = cs[n]->ctx;
+	}
+	if (n < 2)
+		return TEE_SUCCESS;
+
+	res = crypto_cipher_update_multi(ctx, TEE_ALG_AES_CBC_NOPAD,
+					 TEE_MODE_ENCRYPT, n, src, len, dst);
+	for (m = 0; m < n; m++) {
+		upd[m].dst_len = len;
+		upd[m].res = res;
+	}
+	*count = n;
+
+	return res;
+}
+
+/* Number of updates copied in and out of user space at a time */
+#define CRYP_UPDATE_VEC_BATCH	8
+
+TEE_Result syscall_cryp_update_vec(struct utee_cryp_update *updates,
+			size_t num_updates)
+{
+	struct utee_cryp_update upd[CRYP_UPDATE_VEC_BATCH] = { };
+	struct tee_ta_session *sess = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Result res2 = TEE_SUCCESS;
+	size_t count = 0;
+	size_t num = 0;
+	size_t n = 0;
+
+	res = tee_ta_get_current_session(&sess);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	while (num_updates) {
+		num = MIN(num_updates, (size_t)CRYP_UPDATE_VEC_BATCH);
+		res = tee_svc_copy_from_user(upd, updates, num * sizeof(*upd));
+		if (res != TEE_SUCCESS)
+			return res;
+
+		for (n = 0; n < num; n += count) {
+			res = cipher_update_multi(sess, upd + n, num - n,
+						  &count);
+			if (!count) {
+				res = cryp_update(sess, upd + n);
+				upd[n].res = res;
+				count = 1;
+			}
+			if (res != TEE_SUCCESS) {
+				num = n + count;
+				break;
+			}
+		}
+
+		res2 = tee_svc_copy_to_user(updates, upd, num * sizeof(*upd));
+		if (res != TEE_SUCCESS)
+			return res;
+		if (res2 != TEE_SUCCESS)
+			return res2;
+
+		updates += num;
+		num_updates -= num;
+	}
+
+	return TEE_SUCCESS;
+}
+
 #if defined(CFG_CRYPTO_HKDF)
 static TEE_Result get_hkdf_params(const TEE_Attribute *params,
 				  uint32_t param_count,
@@ -2710,27 +3261,22 @@ TEE_Result syscall_cryp_derive_key(unsigned long state,
 	struct tee_cryp_state *cs;
 	struct tee_cryp_obj_secret *sk;
 	const struct tee_cryp_obj_type_props *type_props;
+	TEE_Attribute stack_params[NUM_STACK_ATTRS];
 	TEE_Attribute *params = NULL;
 	struct user_ta_ctx *utc;
+	size_t alloc_size = 0;
 
 	res = tee_ta_get_current_session(&sess);
 	if (res != TEE_SUCCESS)
 		return res;
 	utc = to_user_ta_ctx(sess->ctx);
 
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	size_t alloc_size = 0;
-
-	if (MUL_OVERFLOW(sizeof(TEE_Attribute), param_count, &alloc_size))
-		return TEE_ERROR_OVERFLOW;
-
-	params = malloc(alloc_size);
-	if (!params)
-		return TEE_ERROR_OUT_OF_MEMORY;
-	res = copy_in_attrs(utc, usr_params, param_count, params);
+	res = get_user_attrs(utc, usr_params, param_count, stack_params,
+			     &params);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -2739,12 +3285,13 @@ TEE_Result syscall_cryp_derive_key(unsigned long state,
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = tee_obj_get(utc, tee_svc_uref_to_vaddr(derived_key), &so);
+	res = tee_obj_get(utc, derived_key, &so);
 	if (res != TEE_SUCCESS)
 		goto out;
 
 	/* Find information needed about the object to initialize */
 	sk = so->attr;
+	so->generation++;
 
 	/* Find description of object */
 	type_props = tee_svc_find_type_props(so->info.objectType);
@@ -2851,6 +3398,30 @@ TEE_Result syscall_cryp_derive_key(unsigned long state,
 		/* free the public key */
 		crypto_acipher_free_ecc_public_key(&key_public);
 	}
+#if defined(CFG_CRYPTO_X25519)
+	else if (cs->algo == TEE_ALG_X25519) {
+		if (param_count != 1 ||
+		    params[0].attributeID != TEE_ATTR_X25519_PUBLIC_VALUE ||
+		    params[0].content.ref.length != CURVE25519_KEY_SIZE) {
+			res = TEE_ERROR_BAD_PARAMETERS;
+			goto out;
+		}
+
+		if (sk->alloc_size < CURVE25519_KEY_SIZE) {
+			res = TEE_ERROR_SHORT_BUFFER;
+			goto out;
+		}
+
+		res = crypto_acipher_x25519_shared_secret(ko->attr,
+						params[0].content.ref.buffer,
+						(uint8_t *)(sk + 1));
+		if (res == TEE_SUCCESS) {
+			sk->key_size = CURVE25519_KEY_SIZE;
+			so->info.handleFlags |= TEE_HANDLE_FLAG_INITIALIZED;
+			set_attribute(so, type_props, TEE_ATTR_SECRET_VALUE);
+		}
+	}
+#endif
 #if defined(CFG_CRYPTO_HKDF)
 	else if (TEE_ALG_GET_MAIN_ALG(cs->algo) == TEE_MAIN_ALGO_HKDF) {
 		void *salt, *info;
@@ -2942,7 +3513,7 @@ TEE_Result syscall_cryp_derive_key(unsigned long state,
 		res = TEE_ERROR_NOT_SUPPORTED;
 
 out:
-	free_wipe(params);
+	put_user_attrs(params, stack_params);
 	return res;
 }
 
@@ -2978,33 +3549,46 @@ TEE_Result syscall_authenc_init(unsigned long state, const void *nonce,
 	struct tee_ta_session *sess;
 	struct tee_obj *o;
 	struct tee_cryp_obj_secret *key;
+	struct user_ta_ctx *utc;
 
 	res = tee_ta_get_current_session(&sess);
 	if (res != TEE_SUCCESS)
 		return res;
+	utc = to_user_ta_ctx(sess->ctx);
 
-	res = tee_mmu_check_access_rights(to_user_ta_ctx(sess->ctx),
+	res = tee_mmu_check_access_rights(utc,
 					  TEE_MEMORY_ACCESS_READ |
 					  TEE_MEMORY_ACCESS_ANY_OWNER,
 					  (uaddr_t)nonce, nonce_len);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), cs->key1, &o);
-	if (res != TEE_SUCCESS)
-		return res;
-	if ((o->info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) == 0)
-		return TEE_ERROR_BAD_PARAMETERS;
+	/* Only the nonce changes if the key is the same as last time */
+	res = TEE_ERROR_NOT_SUPPORTED;
+	if (cryp_state_is_keyed(utc, cs))
+		res = crypto_authenc_reinit(cs->ctx, cs->algo, cs->mode,
+					    nonce, nonce_len, tag_len,
+					    aad_len, payload_len);
+	if (res == TEE_ERROR_NOT_SUPPORTED) {
+		res = tee_obj_get(utc, cs->key1, &o);
+		if (res != TEE_SUCCESS)
+			return res;
+		if ((o->info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) == 0)
+			return TEE_ERROR_BAD_PARAMETERS;
 
-	key = o->attr;
-	res = crypto_authenc_init(cs->ctx, cs->algo, cs->mode,
-				  (uint8_t *)(key + 1), key->key_size,
-				  nonce, nonce_len, tag_len, aad_len,
-				  payload_len);
+		key = o->attr;
+		cs->keyed = false;
+		res = crypto_authenc_init(cs->ctx, cs->algo, cs->mode,
+					  (uint8_t *)(key + 1), key->key_size,
+					  nonce, nonce_len, tag_len, aad_len,
+					  payload_len);
+		if (res == TEE_SUCCESS)
+			cryp_state_set_keyed(utc, cs);
+	}
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3033,7 +3617,7 @@ TEE_Result syscall_authenc_update_aad(unsigned long state,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3064,7 +3648,7 @@ TEE_Result syscall_authenc_update_payload(unsigned long state,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3126,7 +3710,7 @@ TEE_Result syscall_authenc_enc_final(unsigned long state,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3213,7 +3797,7 @@ TEE_Result syscall_authenc_dec_final(unsigned long state,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3311,6 +3895,7 @@ TEE_Result syscall_asymm_operate(unsigned long state,
 	size_t label_len = 0;
 	size_t n;
 	int salt_len;
+	TEE_Attribute stack_params[NUM_STACK_ATTRS];
 	TEE_Attribute *params = NULL;
 	struct user_ta_ctx *utc;
 
@@ -3319,7 +3904,7 @@ TEE_Result syscall_asymm_operate(unsigned long state,
 		return res;
 	utc = to_user_ta_ctx(sess->ctx);
 
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3342,15 +3927,8 @@ TEE_Result syscall_asymm_operate(unsigned long state,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	size_t alloc_size = 0;
-
-	if (MUL_OVERFLOW(sizeof(TEE_Attribute), num_params, &alloc_size))
-		return TEE_ERROR_OVERFLOW;
-
-	params = malloc(alloc_size);
-	if (!params)
-		return TEE_ERROR_OUT_OF_MEMORY;
-	res = copy_in_attrs(utc, usr_params, num_params, params);
+	res = get_user_attrs(utc, usr_params, num_params, stack_params,
+			     &params);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -3447,6 +4025,12 @@ TEE_Result syscall_asymm_operate(unsigned long state,
 		res = crypto_acipher_ecc_sign(cs->algo, o->attr, src_data,
 					      src_len, dst_data, &dlen);
 		break;
+#if defined(CFG_CRYPTO_ED25519)
+	case TEE_ALG_ED25519:
+		res = crypto_acipher_ed25519_sign(o->attr, src_data, src_len,
+						  dst_data, &dlen);
+		break;
+#endif
 
 	default:
 		res = TEE_ERROR_BAD_PARAMETERS;
@@ -3454,7 +4038,7 @@ TEE_Result syscall_asymm_operate(unsigned long state,
 	}
 
 out:
-	free_wipe(params);
+	put_user_attrs(params, stack_params);
 
 	if (res == TEE_SUCCESS || res == TEE_ERROR_SHORT_BUFFER) {
 		TEE_Result res2 = put_user_u64(dst_len, dlen);
@@ -3477,6 +4061,7 @@ TEE_Result syscall_asymm_verify(unsigned long state,
 	struct tee_obj *o;
 	size_t hash_size;
 	int salt_len = 0;
+	TEE_Attribute stack_params[NUM_STACK_ATTRS];
 	TEE_Attribute *params = NULL;
 	uint32_t hash_algo;
 	struct user_ta_ctx *utc;
@@ -3486,7 +4071,7 @@ TEE_Result syscall_asymm_verify(unsigned long state,
 		return res;
 	utc = to_user_ta_ctx(sess->ctx);
 
-	res = tee_svc_cryp_get_state(sess, tee_svc_uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3507,15 +4092,8 @@ TEE_Result syscall_asymm_verify(unsigned long state,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	size_t alloc_size = 0;
-
-	if (MUL_OVERFLOW(sizeof(TEE_Attribute), num_params, &alloc_size))
-		return TEE_ERROR_OVERFLOW;
-
-	params = malloc(alloc_size);
-	if (!params)
-		return TEE_ERROR_OUT_OF_MEMORY;
-	res = copy_in_attrs(utc, usr_params, num_params, params);
+	res = get_user_attrs(utc, usr_params, num_params, stack_params,
+			     &params);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -3570,11 +4148,29 @@ TEE_Result syscall_asymm_verify(unsigned long state,
 						data_len, sig, sig_len);
 		break;
 
+#if defined(CFG_CRYPTO_ED25519)
+	case TEE_MAIN_ALGO_ED25519:
+		if (o->info.objectType == TEE_TYPE_ED25519_KEYPAIR) {
+			struct ed25519_keypair *kp = o->attr;
+			struct ed25519_public_key pub = { };
+
+			memcpy(pub.pub, kp->pub, sizeof(pub.pub));
+			res = crypto_acipher_ed25519_verify(&pub, data,
+							    data_len, sig,
+							    sig_len);
+		} else {
+			res = crypto_acipher_ed25519_verify(o->attr, data,
+							    data_len, sig,
+							    sig_len);
+		}
+		break;
+#endif
+
 	default:
 		res = TEE_ERROR_NOT_SUPPORTED;
 	}
 
 out:
-	free_wipe(params);
+	put_user_attrs(params, stack_params);
 	return res;
 }
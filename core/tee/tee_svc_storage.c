@@ -6,7 +6,10 @@
 #include <kernel/mutex.h>
 #include <kernel/tee_misc.h>
 #include <kernel/tee_ta_manager.h>
+#include <kernel/work_queue.h>
 #include <mm/tee_mmu.h>
+#include <stdlib.h>
+#include <stdlib_ext.h>
 #include <string.h>
 #include <tee_api_defines_extensions.h>
 #include <tee_api_defines.h>
@@ -18,6 +21,7 @@
 #include <tee/tee_svc.h>
 #include <tee/tee_svc_storage.h>
 #include <trace.h>
+#include <util.h>
 
 const struct tee_file_operations *tee_svc_storage_file_ops(uint32_t storage_id)
 {
@@ -303,7 +307,13 @@ TEE_Result syscall_storage_obj_open(unsigned long storage_id, void *object_id,
 	    TEE_HANDLE_FLAG_PERSISTENT | TEE_HANDLE_FLAG_INITIALIZED;
 	o->flags = flags;
 	o->pobj = po;
-	tee_obj_add(utc, o);
+	res = tee_obj_add(utc, o);
+	if (res != TEE_SUCCESS) {
+		tee_obj_free(o);
+		o = NULL;
+		tee_pobj_release(po);
+		goto err;
+	}
 
 	res = tee_svc_storage_read_head(o);
 	if (res != TEE_SUCCESS) {
@@ -314,7 +324,7 @@ TEE_Result syscall_storage_obj_open(unsigned long storage_id, void *object_id,
 		goto oclose;
 	}
 
-	res = tee_svc_copy_kaddr_to_uref(obj, o);
+	res = tee_svc_copy_to_user(obj, &o->id, sizeof(o->id));
 	if (res != TEE_SUCCESS)
 		goto oclose;
 
@@ -460,8 +470,7 @@ TEE_Result syscall_storage_obj_create(unsigned long storage_id, void *object_id,
 	o->pobj = po;
 
 	if (attr != TEE_HANDLE_NULL) {
-		res = tee_obj_get(utc, tee_svc_uref_to_vaddr(attr),
-				  &attr_o);
+		res = tee_obj_get(utc, attr, &attr_o);
 		if (res != TEE_SUCCESS)
 			goto err;
 	}
@@ -470,10 +479,14 @@ TEE_Result syscall_storage_obj_create(unsigned long storage_id, void *object_id,
 	if (res != TEE_SUCCESS)
 		goto err;
 
+	res = tee_obj_add(utc, o);
+	if (res != TEE_SUCCESS) {
+		fops->remove(po);
+		goto err;
+	}
 	po = NULL; /* o owns it from now on */
-	tee_obj_add(utc, o);
 
-	res = tee_svc_copy_kaddr_to_uref(obj, o);
+	res = tee_svc_copy_to_user(obj, &o->id, sizeof(o->id));
 	if (res != TEE_SUCCESS)
 		goto oclose;
 
@@ -510,10 +523,13 @@ TEE_Result syscall_storage_obj_del(unsigned long obj)
 		return res;
 	utc = to_user_ta_ctx(sess->ctx);
 
-	res = tee_obj_get(utc, tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(utc, obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
+	if (o->async)
+		return TEE_ERROR_BUSY;
+
 	if (!(o->flags & TEE_DATA_FLAG_ACCESS_WRITE_META))
 		return TEE_ERROR_ACCESS_CONFLICT;
 
@@ -546,10 +562,13 @@ TEE_Result syscall_storage_obj_rename(unsigned long obj, void *object_id,
 		return res;
 	utc = to_user_ta_ctx(sess->ctx);
 
-	res = tee_obj_get(utc, tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(utc, obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
+	if (o->async)
+		return TEE_ERROR_BUSY;
+
 	if (!(o->info.handleFlags & TEE_HANDLE_FLAG_PERSISTENT)) {
 		res = TEE_ERROR_BAD_STATE;
 		goto exit;
@@ -719,52 +738,29 @@ TEE_Result syscall_storage_start_enum(unsigned long obj_enum,
 	return fops->opendir(&sess->ctx->uuid, &e->dir);
 }
 
-TEE_Result syscall_storage_next_enum(unsigned long obj_enum,
-			TEE_ObjectInfo *info, void *obj_id, uint64_t *len)
+/*
+ * Reads the next object of @e, @consumed is set once an entry has been
+ * taken from the directory, even if reading the object then fails.
+ */
+static TEE_Result storage_enum_next(struct tee_ta_session *sess,
+				    struct tee_storage_enum *e,
+				    TEE_ObjectInfo *info, void *obj_id,
+				    uint32_t *obj_id_len, bool *consumed)
 {
-	struct tee_storage_enum *e;
 	struct tee_fs_dirent *d;
 	TEE_Result res = TEE_SUCCESS;
-	struct tee_ta_session *sess;
 	struct tee_obj *o = NULL;
-	uint64_t l;
-	struct user_ta_ctx *utc;
-
-	res = tee_ta_get_current_session(&sess);
-	if (res != TEE_SUCCESS)
-		goto exit;
-	utc = to_user_ta_ctx(sess->ctx);
-
-	res = tee_svc_storage_get_enum(utc,
-			tee_svc_uref_to_vaddr(obj_enum), &e);
-	if (res != TEE_SUCCESS)
-		goto exit;
-
-	/* check rights of the provided buffers */
-	res = tee_mmu_check_access_rights(utc,
-					TEE_MEMORY_ACCESS_WRITE |
-					TEE_MEMORY_ACCESS_ANY_OWNER,
-					(uaddr_t) info,
-					sizeof(TEE_ObjectInfo));
-	if (res != TEE_SUCCESS)
-		goto exit;
 
-	res = tee_mmu_check_access_rights(utc,
-					TEE_MEMORY_ACCESS_WRITE |
-					TEE_MEMORY_ACCESS_ANY_OWNER,
-					(uaddr_t) obj_id,
-					TEE_OBJECT_ID_MAX_LEN);
-	if (res != TEE_SUCCESS)
-		goto exit;
+	*consumed = false;
+	*obj_id_len = 0;
 
-	if (!e->fops) {
-		res = TEE_ERROR_ITEM_NOT_FOUND;
-		goto exit;
-	}
+	if (!e->fops)
+		return TEE_ERROR_ITEM_NOT_FOUND;
 
 	res = e->fops->readdir(e->dir, &d);
 	if (res != TEE_SUCCESS)
-		goto exit;
+		return res;
+	*consumed = true;
 
 	o = tee_obj_alloc();
 	if (o == NULL) {
@@ -790,9 +786,7 @@ TEE_Result syscall_storage_next_enum(unsigned long obj_enum,
 
 	memcpy(info, &o->info, sizeof(TEE_ObjectInfo));
 	memcpy(obj_id, o->pobj->obj_id, o->pobj->obj_id_len);
-
-	l = o->pobj->obj_id_len;
-	res = tee_svc_copy_to_user(len, &l, sizeof(*len));
+	*obj_id_len = o->pobj->obj_id_len;
 
 exit:
 	if (o) {
@@ -808,6 +802,107 @@ exit:
 	return res;
 }
 
+TEE_Result syscall_storage_next_enum(unsigned long obj_enum,
+			TEE_ObjectInfo *info, void *obj_id, uint64_t *len)
+{
+	struct tee_storage_enum *e;
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_ta_session *sess;
+	bool consumed = false;
+	uint32_t obj_id_len = 0;
+	uint64_t l;
+	struct user_ta_ctx *utc;
+
+	res = tee_ta_get_current_session(&sess);
+	if (res != TEE_SUCCESS)
+		return res;
+	utc = to_user_ta_ctx(sess->ctx);
+
+	res = tee_svc_storage_get_enum(utc,
+			tee_svc_uref_to_vaddr(obj_enum), &e);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	/* check rights of the provided buffers */
+	res = tee_mmu_check_access_rights(utc,
+					TEE_MEMORY_ACCESS_WRITE |
+					TEE_MEMORY_ACCESS_ANY_OWNER,
+					(uaddr_t) info,
+					sizeof(TEE_ObjectInfo));
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = tee_mmu_check_access_rights(utc,
+					TEE_MEMORY_ACCESS_WRITE |
+					TEE_MEMORY_ACCESS_ANY_OWNER,
+					(uaddr_t) obj_id,
+					TEE_OBJECT_ID_MAX_LEN);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = storage_enum_next(sess, e, info, obj_id, &obj_id_len, &consumed);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	l = obj_id_len;
+	return tee_svc_copy_to_user(len, &l, sizeof(*len));
+}
+
+TEE_Result syscall_storage_next_enum_batch(unsigned long obj_enum,
+			struct utee_object_enum_entry *entries,
+			size_t num_entries, uint64_t *count)
+{
+	struct utee_object_enum_entry *ent = NULL;
+	struct tee_storage_enum *e = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_ta_session *sess = NULL;
+	struct user_ta_ctx *utc = NULL;
+	bool consumed = false;
+	uint64_t c = 0;
+	size_t sz = 0;
+	size_t n = 0;
+
+	res = tee_ta_get_current_session(&sess);
+	if (res != TEE_SUCCESS)
+		return res;
+	utc = to_user_ta_ctx(sess->ctx);
+
+	res = tee_svc_storage_get_enum(utc,
+			tee_svc_uref_to_vaddr(obj_enum), &e);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (!num_entries || MUL_OVERFLOW(num_entries, sizeof(*entries), &sz))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = tee_mmu_check_access_rights(utc,
+					TEE_MEMORY_ACCESS_WRITE |
+					TEE_MEMORY_ACCESS_ANY_OWNER,
+					(uaddr_t)entries, sz);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	/*
+	 * The directory is only walked once for the whole batch, an object
+	 * which can't be read is returned with its error and the
+	 * enumeration goes on as it would with one object per call.
+	 */
+	for (n = 0; n < num_entries; n++) {
+		ent = entries + n;
+		res = storage_enum_next(sess, e, &ent->info, ent->obj_id,
+					&ent->obj_id_len, &consumed);
+		if (!consumed)
+			break;
+		ent->res = res;
+	}
+
+	if (!n)
+		return res;
+
+	c = n;
+	return tee_svc_copy_to_user(count, &c, sizeof(*count));
+}
+
 TEE_Result syscall_storage_obj_read(unsigned long obj, void *data, size_t len,
 			uint64_t *count)
 {
@@ -824,7 +919,7 @@ TEE_Result syscall_storage_obj_read(unsigned long obj, void *data, size_t len,
 		goto exit;
 	utc = to_user_ta_ctx(sess->ctx);
 
-	res = tee_obj_get(utc, tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(utc, obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -833,6 +928,11 @@ TEE_Result syscall_storage_obj_read(unsigned long obj, void *data, size_t len,
 		goto exit;
 	}
 
+	if (o->async) {
+		res = TEE_ERROR_BUSY;
+		goto exit;
+	}
+
 	if (!(o->flags & TEE_DATA_FLAG_ACCESS_READ)) {
 		res = TEE_ERROR_ACCESS_CONFLICT;
 		goto exit;
@@ -887,7 +987,7 @@ TEE_Result syscall_storage_obj_write(unsigned long obj, void *data, size_t len)
 		goto exit;
 	utc = to_user_ta_ctx(sess->ctx);
 
-	res = tee_obj_get(utc, tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(utc, obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -896,6 +996,11 @@ TEE_Result syscall_storage_obj_write(unsigned long obj, void *data, size_t len)
 		goto exit;
 	}
 
+	if (o->async) {
+		res = TEE_ERROR_BUSY;
+		goto exit;
+	}
+
 	if (!(o->flags & TEE_DATA_FLAG_ACCESS_WRITE)) {
 		res = TEE_ERROR_ACCESS_CONFLICT;
 		goto exit;
@@ -943,8 +1048,7 @@ TEE_Result syscall_storage_obj_trunc(unsigned long obj, size_t len)
 	if (res != TEE_SUCCESS)
 		goto exit;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -953,6 +1057,11 @@ TEE_Result syscall_storage_obj_trunc(unsigned long obj, size_t len)
 		goto exit;
 	}
 
+	if (o->async) {
+		res = TEE_ERROR_BUSY;
+		goto exit;
+	}
+
 	if (!(o->flags & TEE_DATA_FLAG_ACCESS_WRITE)) {
 		res = TEE_ERROR_ACCESS_CONFLICT;
 		goto exit;
@@ -1001,14 +1110,16 @@ TEE_Result syscall_storage_obj_seek(unsigned long obj, int32_t offset,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  tee_svc_uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
 	if (!(o->info.handleFlags & TEE_HANDLE_FLAG_PERSISTENT))
 		return TEE_ERROR_BAD_STATE;
 
+	if (o->async)
+		return TEE_ERROR_BUSY;
+
 	switch (whence) {
 	case TEE_DATA_SEEK_SET:
 		new_pos = offset;
@@ -1038,6 +1149,261 @@ TEE_Result syscall_storage_obj_seek(unsigned long obj, int32_t offset,
 	return TEE_SUCCESS;
 }
 
+/*
+ * struct storage_async - Read or write of a persistent object run as
+ * deferred work
+ * @work:	Runs the read or write
+ * @o:		The object
+ * @write:	True for a write, false for a read
+ * @pos:	Position in the file of the object
+ * @buf:	Data to write, or data read
+ * @len:	Length of @buf
+ * @udata:	User buffer the data read is copied to on completion
+ * @bytes:	Number of bytes read
+ * @res:	Result of the read or write
+ * @done:	Set once @res and @bytes are valid
+ *
+ * The work runs in another thread than the one of the TA, which may not
+ * have the TA mapped, hence the bounce buffer @buf. The TA is blocked
+ * from using the data stream of @o until the result is collected with
+ * syscall_storage_obj_wait().
+ */
+struct storage_async {
+	struct work work;
+	struct tee_obj *o;
+	bool write;
+	size_t pos;
+	void *buf;
+	size_t len;
+	void *udata;
+	size_t bytes;
+	TEE_Result res;
+	bool done;
+};
+
+static void storage_async_func(struct work *work)
+{
+	struct storage_async *a = container_of(work, struct storage_async,
+					       work);
+	struct tee_obj *o = a->o;
+
+	a->bytes = a->len;
+	if (a->write)
+		a->res = o->pobj->fops->write(o->fh, a->pos, a->buf, a->len);
+	else
+		a->res = o->pobj->fops->read(o->fh, a->pos, a->buf, &a->bytes);
+
+	__atomic_store_n(&a->done, true, __ATOMIC_RELEASE);
+}
+
+/*
+ * If the work hasn't started it's run in the calling thread, there may
+ * be no other thread to run it until the TA returns to normal world.
+ */
+static void storage_async_complete(struct storage_async *a)
+{
+	if (work_cancel(&a->work))
+		storage_async_func(&a->work);
+	else
+		work_flush(&a->work);
+}
+
+static void storage_async_free(struct storage_async *a)
+{
+	if (a) {
+		free_wipe(a->buf);
+		free(a);
+	}
+}
+
+void tee_svc_storage_async_release(struct tee_obj *o)
+{
+	if (o->async) {
+		storage_async_complete(o->async);
+		storage_async_free(o->async);
+		o->async = NULL;
+	}
+}
+
+TEE_Result syscall_storage_obj_submit(unsigned long obj, unsigned long write,
+				      void *data, size_t len)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_ta_session *sess = NULL;
+	struct storage_async *a = NULL;
+	struct user_ta_ctx *utc = NULL;
+	struct tee_obj *o = NULL;
+	uint32_t access = TEE_MEMORY_ACCESS_ANY_OWNER;
+	size_t pos_tmp = 0;
+
+	res = tee_ta_get_current_session(&sess);
+	if (res != TEE_SUCCESS)
+		return res;
+	utc = to_user_ta_ctx(sess->ctx);
+
+	res = tee_obj_get(utc, obj, &o);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (!(o->info.handleFlags & TEE_HANDLE_FLAG_PERSISTENT))
+		return TEE_ERROR_BAD_STATE;
+
+	if (o->async)
+		return TEE_ERROR_BUSY;
+
+	if (write) {
+		if (!(o->flags & TEE_DATA_FLAG_ACCESS_WRITE))
+			return TEE_ERROR_ACCESS_CONFLICT;
+		access |= TEE_MEMORY_ACCESS_READ;
+	} else {
+		if (!(o->flags & TEE_DATA_FLAG_ACCESS_READ))
+			return TEE_ERROR_ACCESS_CONFLICT;
+		access |= TEE_MEMORY_ACCESS_WRITE;
+	}
+
+	/* Guard o->info.dataPosition += len on completion from overflowing */
+	if (ADD_OVERFLOW(o->info.dataPosition, len, &pos_tmp))
+		return TEE_ERROR_OVERFLOW;
+
+	res = tee_mmu_check_access_rights(utc, access, (uaddr_t)data, len);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	a = calloc(1, sizeof(*a));
+	if (!a)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	if (ADD_OVERFLOW(o->ds_pos, o->info.dataPosition, &a->pos)) {
+		res = TEE_ERROR_OVERFLOW;
+		goto err;
+	}
+
+	if (len) {
+		a->buf = malloc(len);
+		if (!a->buf) {
+			res = TEE_ERROR_OUT_OF_MEMORY;
+			goto err;
+		}
+	}
+	if (write) {
+		res = tee_svc_copy_from_user(a->buf, data, len);
+		if (res != TEE_SUCCESS)
+			goto err;
+	}
+
+	a->o = o;
+	a->write = write;
+	a->len = len;
+	a->udata = data;
+	work_init(&a->work, storage_async_func);
+
+	o->async = a;
+	work_queue(&a->work);
+
+	return TEE_SUCCESS;
+err:
+	storage_async_free(a);
+	return res;
+}
+
+TEE_Result syscall_storage_obj_wait(unsigned long obj, unsigned long wait,
+				    uint64_t *count)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_ta_session *sess = NULL;
+	struct storage_async *a = NULL;
+	struct tee_obj *o = NULL;
+	uint64_t u_count = 0;
+
+	res = tee_ta_get_current_session(&sess);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	a = o->async;
+	if (!a)
+		return TEE_ERROR_BAD_STATE;
+
+	if (!__atomic_load_n(&a->done, __ATOMIC_ACQUIRE)) {
+		if (!wait)
+			return TEE_ERROR_BUSY;
+		storage_async_complete(a);
+	}
+
+	o->async = NULL;
+	res = a->res;
+	if (res == TEE_ERROR_CORRUPT_OBJECT) {
+		EMSG("Object corrupt");
+		tee_svc_storage_remove_corrupt_obj(sess, o);
+		goto out;
+	}
+	if (res != TEE_SUCCESS)
+		goto out;
+
+	if (!a->write) {
+		res = tee_svc_copy_to_user(a->udata, a->buf, a->bytes);
+		if (res != TEE_SUCCESS)
+			goto out;
+	}
+
+	o->info.dataPosition += a->bytes;
+	if (o->info.dataPosition > o->info.dataSize)
+		o->info.dataSize = o->info.dataPosition;
+
+	u_count = a->bytes;
+	res = tee_svc_copy_to_user(count, &u_count, sizeof(*count));
+out:
+	storage_async_free(a);
+	return res;
+}
+
+TEE_Result syscall_storage_txn(unsigned long storage_id, unsigned long begin)
+{
+	const struct tee_file_operations *fops =
+			tee_svc_storage_file_ops(storage_id);
+	struct tee_ta_session *sess = NULL;
+	struct user_ta_ctx *utc = NULL;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!fops)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+
+	res = tee_ta_get_current_session(&sess);
+	if (res != TEE_SUCCESS)
+		return res;
+	utc = to_user_ta_ctx(sess->ctx);
+
+	if (begin) {
+		if (utc->storage_txn_fops)
+			return TEE_ERROR_BAD_STATE;
+		if (!fops->begin_transaction)
+			return TEE_ERROR_NOT_SUPPORTED;
+
+		res = fops->begin_transaction();
+		if (!res)
+			utc->storage_txn_fops = fops;
+		return res;
+	}
+
+	if (utc->storage_txn_fops != fops)
+		return TEE_ERROR_BAD_STATE;
+
+	utc->storage_txn_fops = NULL;
+	return fops->end_transaction();
+}
+
+void tee_svc_storage_end_txn(struct user_ta_ctx *utc)
+{
+	if (utc->storage_txn_fops) {
+		/* disregard return value */
+		utc->storage_txn_fops->end_transaction();
+		utc->storage_txn_fops = NULL;
+	}
+}
+
 void tee_svc_storage_close_all_enum(struct user_ta_ctx *utc)
 {
 	struct tee_storage_enum_head *eh = &utc->storage_enums;
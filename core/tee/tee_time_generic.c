@@ -4,6 +4,7 @@
  */
 
 #include <kernel/panic.h>
+#include <kernel/percpu_rwlock.h>
 #include <kernel/tee_time.h>
 #include <string.h>
 #include <stdlib.h>
@@ -16,61 +17,98 @@ struct tee_ta_time_offs {
 	bool positive;
 };
 
+/*
+ * The offsets are only looked up when a TA context doesn't have an up to
+ * date copy in its cache. @tee_time_offs_gen is increased each time an
+ * offset is changed, invalidating all the caches. The lookups are done
+ * concurrently by the contexts of all TAs, updates are rare.
+ */
+static struct percpu_rwlock tee_time_offs_lock = PERCPU_RWLOCK_INITIALIZER;
 static struct tee_ta_time_offs *tee_time_offs;
 static size_t tee_time_num_offs;
+static uint32_t tee_time_offs_gen = 1;
 
 static TEE_Result tee_time_ta_get_offs(const TEE_UUID *uuid,
-				       const TEE_Time **offs, bool *positive)
+				       struct tee_time_ta_offs *cache)
 {
+	TEE_Result res = TEE_ERROR_TIME_NOT_SET;
 	size_t n;
 
+	if (cache->gen &&
+	    cache->gen == __atomic_load_n(&tee_time_offs_gen, __ATOMIC_ACQUIRE))
+		return TEE_SUCCESS;
+
+	percpu_rwlock_read_lock(&tee_time_offs_lock);
 	for (n = 0; n < tee_time_num_offs; n++) {
 		if (memcmp(uuid, &tee_time_offs[n].uuid, sizeof(TEE_UUID))
 				== 0) {
-			*offs = &tee_time_offs[n].offs;
-			*positive = tee_time_offs[n].positive;
-			return TEE_SUCCESS;
+			cache->offs = tee_time_offs[n].offs;
+			cache->positive = tee_time_offs[n].positive;
+			cache->gen = tee_time_offs_gen;
+			res = TEE_SUCCESS;
+			break;
 		}
 	}
-	return TEE_ERROR_TIME_NOT_SET;
+	percpu_rwlock_read_unlock(&tee_time_offs_lock);
+
+	return res;
 }
 
 static TEE_Result tee_time_ta_set_offs(const TEE_UUID *uuid,
+				       struct tee_time_ta_offs *cache,
 				       const TEE_Time *offs, bool positive)
 {
+	TEE_Result res = TEE_SUCCESS;
 	size_t n;
 	struct tee_ta_time_offs *o;
 
+	percpu_rwlock_write_lock(&tee_time_offs_lock);
+
 	for (n = 0; n < tee_time_num_offs; n++) {
 		if (memcmp(uuid, &tee_time_offs[n].uuid, sizeof(TEE_UUID))
 				== 0) {
 			tee_time_offs[n].offs = *offs;
 			tee_time_offs[n].positive = positive;
-			return TEE_SUCCESS;
+			goto out;
 		}
 	}
 
 	n = tee_time_num_offs + 1;
 	o = realloc(tee_time_offs, n * sizeof(struct tee_ta_time_offs));
-	if (!o)
-		return TEE_ERROR_OUT_OF_MEMORY;
+	if (!o) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out_unlock;
+	}
 	tee_time_offs = o;
 	tee_time_offs[tee_time_num_offs].uuid = *uuid;
 	tee_time_offs[tee_time_num_offs].offs = *offs;
 	tee_time_offs[tee_time_num_offs].positive = positive;
 	tee_time_num_offs = n;
-	return TEE_SUCCESS;
+out:
+	/* Other contexts of the same TA must look the new offset up */
+	__atomic_store_n(&tee_time_offs_gen, tee_time_offs_gen + 1,
+			 __ATOMIC_RELEASE);
+	cache->offs = *offs;
+	cache->positive = positive;
+	cache->gen = tee_time_offs_gen;
+out_unlock:
+	percpu_rwlock_write_unlock(&tee_time_offs_lock);
+
+	return res;
 }
 
-TEE_Result tee_time_get_ta_time(const TEE_UUID *uuid, TEE_Time *time)
+TEE_Result tee_time_get_ta_time(const TEE_UUID *uuid,
+				struct tee_time_ta_offs *cache, TEE_Time *time)
 {
+	struct tee_time_ta_offs c = { };
 	TEE_Result res;
-	const TEE_Time *offs;
-	bool positive;
 	TEE_Time t;
 	TEE_Time t2;
 
-	res = tee_time_ta_get_offs(uuid, &offs, &positive);
+	if (!cache)
+		cache = &c;
+
+	res = tee_time_ta_get_offs(uuid, cache);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -78,14 +116,14 @@ TEE_Result tee_time_get_ta_time(const TEE_UUID *uuid, TEE_Time *time)
 	if (res != TEE_SUCCESS)
 		return res;
 
-	if (positive) {
-		TEE_TIME_ADD(t, *offs, t2);
+	if (cache->positive) {
+		TEE_TIME_ADD(t, cache->offs, t2);
 
 		/* Detect wrapping, the wrapped time should be returned. */
 		if (TEE_TIME_LT(t2, t))
 			res = TEE_ERROR_OVERFLOW;
 	} else {
-		TEE_TIME_SUB(t, *offs, t2);
+		TEE_TIME_SUB(t, cache->offs, t2);
 
 		/* Detect wrapping, the wrapped time should be returned. */
 		if (TEE_TIME_LE(t, t2))
@@ -96,12 +134,18 @@ TEE_Result tee_time_get_ta_time(const TEE_UUID *uuid, TEE_Time *time)
 	return res;
 }
 
-TEE_Result tee_time_set_ta_time(const TEE_UUID *uuid, const TEE_Time *time)
+TEE_Result tee_time_set_ta_time(const TEE_UUID *uuid,
+				struct tee_time_ta_offs *cache,
+				const TEE_Time *time)
 {
+	struct tee_time_ta_offs c = { };
 	TEE_Result res;
 	TEE_Time offs;
 	TEE_Time t;
 
+	if (!cache)
+		cache = &c;
+
 	/* Check that time is normalized. */
 	if (time->millis >= TEE_TIME_MILLIS_BASE)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -112,10 +156,10 @@ TEE_Result tee_time_set_ta_time(const TEE_UUID *uuid, const TEE_Time *time)
 
 	if (TEE_TIME_LT(t, *time)) {
 		TEE_TIME_SUB(*time, t, offs);
-		return tee_time_ta_set_offs(uuid, &offs, true);
+		return tee_time_ta_set_offs(uuid, cache, &offs, true);
 	} else {
 		TEE_TIME_SUB(t, *time, offs);
-		return tee_time_ta_set_offs(uuid, &offs, false);
+		return tee_time_ta_set_offs(uuid, cache, &offs, false);
 	}
 }
 
@@ -57,6 +57,19 @@ bool ftrace_init(struct ftrace_buf **fbuf_ptr)
 	fbuf->buf_off = fbuf->head_off + count;
 	fbuf->curr_size = 0;
 	fbuf->max_size = fbuf_size - sizeof(struct ftrace_buf) - count;
+	fbuf->filter_start = 0;
+	fbuf->filter_end = 0;
+	fbuf->ts_offset = 0;
+	fbuf->ring_head = 0;
+	fbuf->ring_tail = 0;
+	fbuf->ring_lost = 0;
+	fbuf->ring_size = 0;
+#ifdef CFG_TA_FTRACE_STREAM
+	/* Records must be aligned, the header length varies */
+	fbuf->buf_off = ROUNDUP(fbuf->buf_off, sizeof(uint64_t));
+	fbuf->max_size = fbuf_size - fbuf->buf_off;
+	fbuf->ring_size = fbuf->max_size / sizeof(struct ftrace_rec);
+#endif
 
 	*fbuf_ptr = fbuf;
 
@@ -72,6 +85,10 @@ void ftrace_copy_buf(void *pctx, void (*copy_func)(void *pctx, void *b,
 				   fbuf->curr_size;
 
 		assert(elf && elf->is_main);
+#ifdef CFG_TA_FTRACE_STREAM
+		/* The records are drained by the core as they are written */
+		dump_size = 0;
+#endif
 		copy_func(pctx, (char *)fbuf + fbuf->head_off, dump_size);
 	}
 }
@@ -287,6 +287,7 @@ typedef struct {
 #define	SHT_PREINIT_ARRAY	16	/* Pre-initialization function ptrs. */
 #define	SHT_GROUP		17	/* Section group. */
 #define	SHT_SYMTAB_SHNDX	18	/* Section indexes (see SHN_XINDEX). */
+#define	SHT_RELR		19	/* Relative relocations. */
 #define	SHT_LOOS		0x60000000	/* First of OS specific semantics */
 #define	SHT_LOSUNW		0x6ffffff4
 #define	SHT_SUNW_dof		0x6ffffff4
@@ -422,7 +423,10 @@ typedef struct {
 				   pre-initialization functions. */
 #define	DT_PREINIT_ARRAYSZ 33	/* Size in bytes of the array of
 				   pre-initialization functions. */
-#define	DT_MAXPOSTAGS	34	/* number of positive tags */
+#define	DT_RELRSZ	35	/* Size of the relative relocation table. */
+#define	DT_RELR		36	/* Address of the relative relocation table. */
+#define	DT_RELRENT	37	/* Size of a relative relocation table entry. */
+#define	DT_MAXPOSTAGS	38	/* number of positive tags */
 #define	DT_LOOS		0x6000000d	/* First OS-specific */
 #define	DT_SUNW_AUXILIARY	0x6000000d	/* symbol auxiliary name */
 #define	DT_SUNW_RTLDINF		0x6000000e	/* ld.so.1 info (private) */
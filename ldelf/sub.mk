@@ -1,6 +1,10 @@
 global-incdirs-y += include
 srcs-$(CFG_ARM32_$(sm)) += start_a32.S
 srcs-$(CFG_ARM64_$(sm)) += start_a64.S
+ifeq ($(CFG_TA_LAZY_BINDING),y)
+srcs-$(CFG_ARM32_$(sm)) += lazy_bind_a32.S
+srcs-$(CFG_ARM64_$(sm)) += lazy_bind_a64.S
+endif
 srcs-y += dl.c
 srcs-y += main.c
 srcs-y += sys.c
@@ -125,6 +125,24 @@ TEE_Result sys_open_ta_bin(const TEE_UUID *uuid, uint32_t *handle)
 	return res;
 }
 
+TEE_Result sys_open_ta_bins(const TEE_UUID *uuids, uint32_t *handles,
+			    size_t num_bins)
+{
+	struct utee_params params = {
+		.types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+					 TEE_PARAM_TYPE_MEMREF_OUTPUT,
+					 TEE_PARAM_TYPE_NONE,
+					 TEE_PARAM_TYPE_NONE),
+	};
+
+	params.vals[0] = (vaddr_t)uuids;
+	params.vals[1] = num_bins * sizeof(*uuids);
+	params.vals[2] = (vaddr_t)handles;
+	params.vals[3] = num_bins * sizeof(*handles);
+
+	return invoke_sys_ta(PTA_SYSTEM_OPEN_TA_BINARIES, &params);
+}
+
 TEE_Result sys_close_ta_bin(uint32_t handle)
 {
 	struct utee_params params = {
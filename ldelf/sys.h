@@ -37,6 +37,8 @@ TEE_Result sys_map_zi(size_t num_bytes, uint32_t flags, vaddr_t *va,
 		      size_t pad_begin, size_t pad_end);
 TEE_Result sys_unmap(vaddr_t va, size_t num_bytes);
 TEE_Result sys_open_ta_bin(const TEE_UUID *uuid, uint32_t *handle);
+TEE_Result sys_open_ta_bins(const TEE_UUID *uuids, uint32_t *handles,
+			    size_t num_bins);
 TEE_Result sys_close_ta_bin(uint32_t handle);
 TEE_Result sys_map_ta_bin(vaddr_t *va, size_t num_bytes, uint32_t flags,
 			  uint32_t handle, size_t offs, size_t pad_begin,
@@ -142,8 +142,8 @@ static void read_dyn(struct ta_elf *elf, vaddr_t addr,
 	}
 }
 
-static void save_hashtab_from_segment(struct ta_elf *elf, unsigned int type,
-				      vaddr_t addr, size_t memsz)
+static void save_dyn_info_from_segment(struct ta_elf *elf, unsigned int type,
+				       vaddr_t addr, size_t memsz)
 {
 	size_t dyn_entsize = 0;
 	size_t num_dyns = 0;
@@ -164,14 +164,36 @@ static void save_hashtab_from_segment(struct ta_elf *elf, unsigned int type,
 
 	for (n = 0; n < num_dyns; n++) {
 		read_dyn(elf, addr, n, &tag, &val);
-		if (tag == DT_HASH) {
+		switch (tag) {
+		case DT_HASH:
 			elf->hashtab = (void *)(val + elf->load_addr);
 			break;
+		case DT_GNU_HASH:
+			elf->gnu_hashtab = (void *)(val + elf->load_addr);
+			break;
+		case DT_PLTGOT:
+			elf->pltgot = val + elf->load_addr;
+			break;
+		case DT_JMPREL:
+			elf->jmprel = val + elf->load_addr;
+			break;
+		case DT_PLTRELSZ:
+			elf->jmprel_size = val;
+			break;
+		case DT_BIND_NOW:
+			elf->bind_now = true;
+			break;
+		case DT_FLAGS:
+			if (val & DF_BIND_NOW)
+				elf->bind_now = true;
+			break;
+		default:
+			break;
 		}
 	}
 }
 
-static void save_hashtab(struct ta_elf *elf)
+static void save_dyn_info(struct ta_elf *elf)
 {
 	size_t n = 0;
 
@@ -179,18 +201,18 @@ static void save_hashtab(struct ta_elf *elf)
 		Elf32_Phdr *phdr = elf->phdr;
 
 		for (n = 0; n < elf->e_phnum; n++)
-			save_hashtab_from_segment(elf, phdr[n].p_type,
-						  phdr[n].p_vaddr,
-						  phdr[n].p_memsz);
+			save_dyn_info_from_segment(elf, phdr[n].p_type,
+						   phdr[n].p_vaddr,
+						   phdr[n].p_memsz);
 	} else {
 		Elf64_Phdr *phdr = elf->phdr;
 
 		for (n = 0; n < elf->e_phnum; n++)
-			save_hashtab_from_segment(elf, phdr[n].p_type,
-						  phdr[n].p_vaddr,
-						  phdr[n].p_memsz);
+			save_dyn_info_from_segment(elf, phdr[n].p_type,
+						   phdr[n].p_vaddr,
+						   phdr[n].p_memsz);
 	}
-	assert(elf->hashtab);
+	assert(elf->hashtab || elf->gnu_hashtab);
 }
 
 static void e32_save_symtab(struct ta_elf *elf, size_t tab_idx)
@@ -245,7 +267,7 @@ static void save_symtab(struct ta_elf *elf)
 
 	}
 
-	save_hashtab(elf);
+	save_dyn_info(elf);
 }
 
 static void init_elf(struct ta_elf *elf)
@@ -254,9 +276,12 @@ static void init_elf(struct ta_elf *elf)
 	vaddr_t va = 0;
 	uint32_t flags = PTA_SYSTEM_MAP_FLAG_SHAREABLE;
 
-	res = sys_open_ta_bin(&elf->uuid, &elf->handle);
-	if (res)
-		err(res, "sys_open_ta_bin(%pUl)", (void *)&elf->uuid);
+	if (!elf->have_handle) {
+		res = sys_open_ta_bin(&elf->uuid, &elf->handle);
+		if (res)
+			err(res, "sys_open_ta_bin(%pUl)", (void *)&elf->uuid);
+		elf->have_handle = true;
+	}
 
 	/*
 	 * Map it read-only executable when we're loading a library where
@@ -618,6 +643,11 @@ static void populate_segments(struct ta_elf *elf)
 				pad_begin = 0;
 			}
 
+			/*
+			 * Read-only segments are mapped shareable, all
+			 * contexts which have the same binary (same tag)
+			 * loaded map the same physical pages.
+			 */
 			if (seg->flags & PF_W)
 				flags |= PTA_SYSTEM_MAP_FLAG_WRITEABLE;
 			else
@@ -793,6 +823,7 @@ static void close_handle(struct ta_elf *elf)
 	if (res)
 		err(res, "sys_close_ta_bin");
 	elf->handle = -1;
+	elf->have_handle = false;
 }
 
 static void clean_elf_load_main(struct ta_elf *elf)
@@ -923,11 +954,47 @@ void ta_elf_finalize_load_main(uint64_t *entry)
 }
 
 
+/*
+ * Opens @elf and the libraries queued after it in a single call to the
+ * system PTA, the binaries are then fetched back to back instead of
+ * between the loading of each library.
+ */
+static void open_queued_elfs(struct ta_elf *elf)
+{
+	TEE_UUID uuids[PTA_SYSTEM_OPEN_TA_BINARIES_MAX] = { };
+	uint32_t handles[PTA_SYSTEM_OPEN_TA_BINARIES_MAX] = { };
+	struct ta_elf *e = elf;
+	size_t num_bins = 0;
+	size_t n = 0;
+
+	for (e = elf; e && num_bins < ARRAY_SIZE(uuids);
+	     e = TAILQ_NEXT(e, link))
+		if (!e->is_main && !e->have_handle)
+			uuids[num_bins++] = e->uuid;
+
+	/*
+	 * Nothing is gained for a single binary. If the call fails each
+	 * binary is opened by init_elf() instead, which also reports which
+	 * of them is at fault.
+	 */
+	if (num_bins < 2 || sys_open_ta_bins(uuids, handles, num_bins))
+		return;
+
+	for (e = elf; e && n < num_bins; e = TAILQ_NEXT(e, link)) {
+		if (!e->is_main && !e->have_handle) {
+			e->handle = handles[n++];
+			e->have_handle = true;
+		}
+	}
+}
+
 void ta_elf_load_dependency(struct ta_elf *elf, bool is_32bit)
 {
 	if (elf->is_main)
 		return;
 
+	if (!elf->have_handle)
+		open_queued_elfs(elf);
 	init_elf(elf);
 	if (elf->is_32bit != is_32bit)
 		err(TEE_ERROR_BAD_FORMAT, "ELF %pUl is %sbit (expected %sbit)",
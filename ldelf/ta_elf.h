@@ -58,6 +58,14 @@ struct ta_elf {
 
 	/* DT_HASH hash table for faster resolution of external symbols */
 	void *hashtab;
+	/* DT_GNU_HASH hash table, used instead of @hashtab when present */
+	void *gnu_hashtab;
+
+	/* GOT and PLT relocations, used to bind PLT entries on first call */
+	vaddr_t pltgot;
+	vaddr_t jmprel;
+	size_t jmprel_size;
+	bool bind_now;
 
 	struct segment_head segs;
 
@@ -65,6 +73,7 @@ struct ta_elf {
 	size_t exidx_size;
 
 	uint32_t handle;
+	bool have_handle;
 
 	struct ta_head *head;
 
@@ -31,6 +31,17 @@ static uint32_t elf_hash(const char *name)
 	return h;
 }
 
+/* GNU hash function used by DT_GNU_HASH tables */
+static uint32_t gnu_hash(const char *name)
+{
+	const unsigned char *p = (const unsigned char *)name;
+	uint32_t h = 5381;
+
+	while (*p)
+		h = (h << 5) + h + *p++;
+	return h;
+}
+
 static bool __resolve_sym(struct ta_elf *elf, unsigned int bind,
 			  size_t st_shndx, size_t st_name, size_t st_value,
 			  const char *name, vaddr_t *val)
@@ -51,6 +62,24 @@ static bool __resolve_sym(struct ta_elf *elf, unsigned int bind,
 	return true;
 }
 
+static bool resolve_sym_idx(struct ta_elf *elf, size_t n, const char *name,
+			    vaddr_t *val)
+{
+	if (elf->is_32bit) {
+		Elf32_Sym *sym = elf->dynsymtab;
+
+		return __resolve_sym(elf, ELF32_ST_BIND(sym[n].st_info),
+				     sym[n].st_shndx, sym[n].st_name,
+				     sym[n].st_value, name, val);
+	} else {
+		Elf64_Sym *sym = elf->dynsymtab;
+
+		return __resolve_sym(elf, ELF64_ST_BIND(sym[n].st_info),
+				     sym[n].st_shndx, sym[n].st_name,
+				     sym[n].st_value, name, val);
+	}
+}
+
 static TEE_Result resolve_sym_helper(uint32_t hash, const char *name,
 				     vaddr_t *val, struct ta_elf *elf)
 {
@@ -65,58 +94,230 @@ static TEE_Result resolve_sym_helper(uint32_t hash, const char *name,
 	uint32_t *chain = &bucket[nbuckets];
 	size_t n = 0;
 
-	if (elf->is_32bit) {
-		Elf32_Sym *sym = elf->dynsymtab;
+	for (n = bucket[hash % nbuckets]; n; n = chain[n]) {
+		assert(n < nchains);
+		if (resolve_sym_idx(elf, n, name, val))
+			return TEE_SUCCESS;
+	}
 
-		for (n = bucket[hash % nbuckets]; n; n = chain[n]) {
-			assert(n < nchains);
-			if (__resolve_sym(elf,
-					  ELF32_ST_BIND(sym[n].st_info),
-					  sym[n].st_shndx,
-					  sym[n].st_name,
-					  sym[n].st_value, name, val))
-				return TEE_SUCCESS;
-		}
+	return TEE_ERROR_ITEM_NOT_FOUND;
+}
+
+/*
+ * The DT_GNU_HASH table is made of a header of four words (number of
+ * buckets, index of the first hashed symbol, number of Bloom filter words
+ * and Bloom filter shift), the Bloom filter of address sized words, the
+ * buckets and one hash value per hashed symbol. Bit 0 of a hash value
+ * marks the last symbol of a chain.
+ */
+static TEE_Result resolve_sym_gnu_helper(uint32_t hash, const char *name,
+					 vaddr_t *val, struct ta_elf *elf)
+{
+	uint32_t *hashtab = elf->gnu_hashtab;
+	uint32_t nbuckets = hashtab[0];
+	uint32_t symoffset = hashtab[1];
+	uint32_t bloom_size = hashtab[2];
+	uint32_t bloom_shift = hashtab[3];
+	uint32_t *bucket = NULL;
+	uint32_t *chain = NULL;
+	uint32_t h = 0;
+	size_t n = 0;
+
+	if (!nbuckets || !bloom_size)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+
+	/* The Bloom filter rules out most of the ELFs in a single check */
+	if (elf->is_32bit) {
+		uint32_t *bloom = &hashtab[4];
+		uint32_t word = bloom[(hash / 32) % bloom_size];
+		uint32_t mask = BIT32(hash % 32) |
+				BIT32((hash >> bloom_shift) % 32);
+
+		if ((word & mask) != mask)
+			return TEE_ERROR_ITEM_NOT_FOUND;
+		bucket = bloom + bloom_size;
 	} else {
-		Elf64_Sym *sym = elf->dynsymtab;
+		uint64_t *bloom = (uint64_t *)&hashtab[4];
+		uint64_t word = bloom[(hash / 64) % bloom_size];
+		uint64_t mask = BIT64(hash % 64) |
+				BIT64((hash >> bloom_shift) % 64);
+
+		if ((word & mask) != mask)
+			return TEE_ERROR_ITEM_NOT_FOUND;
+		bucket = (uint32_t *)(bloom + bloom_size);
+	}
+	chain = &bucket[nbuckets];
 
-		for (n = bucket[hash % nbuckets]; n; n = chain[n]) {
-			assert(n < nchains);
-			if (__resolve_sym(elf,
-					  ELF64_ST_BIND(sym[n].st_info),
-					  sym[n].st_shndx,
-					  sym[n].st_name,
-					  sym[n].st_value, name, val))
-				return TEE_SUCCESS;
-		}
+	n = bucket[hash % nbuckets];
+	if (n < symoffset)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+
+	while (true) {
+		assert(n < elf->num_dynsyms);
+		h = chain[n - symoffset];
+		if ((h | 1) == (hash | 1) && resolve_sym_idx(elf, n, name, val))
+			return TEE_SUCCESS;
+		if (h & 1)
+			break;
+		n++;
 	}
 
 	return TEE_ERROR_ITEM_NOT_FOUND;
 }
 
+static TEE_Result resolve_sym_elf(uint32_t hash, uint32_t ghash,
+				  const char *name, vaddr_t *val,
+				  struct ta_elf *elf)
+{
+	if (elf->gnu_hashtab)
+		return resolve_sym_gnu_helper(ghash, name, val, elf);
+	return resolve_sym_helper(hash, name, val, elf);
+}
+
 TEE_Result ta_elf_resolve_sym(const char *name, vaddr_t *val,
 			      struct ta_elf *elf)
 {
 	uint32_t hash = elf_hash(name);
+	uint32_t ghash = gnu_hash(name);
 
 	if (elf)
-		return resolve_sym_helper(hash, name, val, elf);
+		return resolve_sym_elf(hash, ghash, name, val, elf);
 
 	TAILQ_FOREACH(elf, &main_elf_queue, link)
-		if (!resolve_sym_helper(hash, name, val, elf))
+		if (!resolve_sym_elf(hash, ghash, name, val, elf))
 			return TEE_SUCCESS;
 
 	return TEE_ERROR_ITEM_NOT_FOUND;
 }
 
+/*
+ * Cache of the symbols resolved by relocations. ELFs are only ever added
+ * at the tail of main_elf_queue and the first match wins, so a resolved
+ * symbol keeps its value for the lifetime of ldelf.
+ */
+#define SYM_CACHE_SIZE	64
+
+struct sym_cache_entry {
+	const char *name;
+	uint32_t hash;
+	vaddr_t val;
+};
+
+static struct sym_cache_entry sym_cache[SYM_CACHE_SIZE];
+
 static void resolve_sym(const char *name, vaddr_t *val)
 {
-	TEE_Result res = ta_elf_resolve_sym(name, val, NULL);
+	uint32_t hash = gnu_hash(name);
+	struct sym_cache_entry *e = sym_cache + hash % SYM_CACHE_SIZE;
+	TEE_Result res = TEE_SUCCESS;
+
+	if (e->name && e->hash == hash && !strcmp(e->name, name)) {
+		*val = e->val;
+		return;
+	}
 
+	res = ta_elf_resolve_sym(name, val, NULL);
 	if (res)
 		err(res, "Symbol %s not found", name);
+
+	e->name = name;
+	e->hash = hash;
+	e->val = *val;
+}
+
+#ifdef CFG_TA_LAZY_BINDING
+/* Entered from PLT0, see lazy_bind_a32.S and lazy_bind_a64.S */
+void ta_elf_lazy_bind_entry(void);
+
+/*
+ * PLT entries can only be bound on first call when the resolver in ldelf
+ * runs in the same execution state as the ELF, that is a 32-bit ELF for
+ * a 32-bit ldelf and a 64-bit ELF for a 64-bit ldelf.
+ */
+static bool bind_lazily(struct ta_elf *elf)
+{
+#ifdef ARM64
+	if (elf->is_32bit)
+		return false;
+#endif
+	return elf->pltgot && elf->jmprel && !elf->bind_now;
 }
 
+/*
+ * Called by ta_elf_lazy_bind_entry() when the TA calls through the PLT
+ * entry for relocation @idx of the DT_JMPREL table of @elf for the first
+ * time. The GOT entry is updated so that later calls go straight to the
+ * symbol.
+ */
+vaddr_t ta_elf_lazy_resolve(struct ta_elf *elf, size_t idx);
+
+vaddr_t ta_elf_lazy_resolve(struct ta_elf *elf, size_t idx)
+{
+	const char *name = NULL;
+	vaddr_t *where = NULL;
+	size_t name_idx = 0;
+	size_t sym_idx = 0;
+	vaddr_t val = 0;
+
+#ifdef ARM64
+	Elf64_Rela *rel = (Elf64_Rela *)elf->jmprel;
+	Elf64_Sym *sym = elf->dynsymtab;
+
+	if (idx >= elf->jmprel_size / sizeof(*rel))
+		panic();
+	sym_idx = ELF64_R_SYM(rel[idx].r_info);
+#else
+	Elf32_Rel *rel = (Elf32_Rel *)elf->jmprel;
+	Elf32_Sym *sym = elf->dynsymtab;
+
+	if (idx >= elf->jmprel_size / sizeof(*rel))
+		panic();
+	sym_idx = ELF32_R_SYM(rel[idx].r_info);
+#endif
+	if (sym_idx >= elf->num_dynsyms)
+		panic();
+	name_idx = sym[sym_idx].st_name;
+	if (name_idx >= elf->dynstr_size)
+		panic();
+	name = elf->dynstr + name_idx;
+
+	/*
+	 * err() can't be used here since we're running on behalf of the
+	 * TA, a missing symbol panics the TA instead.
+	 */
+	if (ta_elf_resolve_sym(name, &val, NULL)) {
+		EMSG("Symbol %s not found", name);
+		panic();
+	}
+
+	where = (vaddr_t *)(elf->load_addr + rel[idx].r_offset);
+	*where = val;
+
+	return val;
+}
+
+/*
+ * GOT[1] and GOT[2] are reserved for the dynamic linker, PLT0 passes
+ * GOT[1] and jumps to GOT[2] when a PLT entry isn't bound yet.
+ */
+static void init_lazy_got(struct ta_elf *elf)
+{
+	vaddr_t *got = (vaddr_t *)elf->pltgot;
+
+	got[1] = (vaddr_t)elf;
+	got[2] = (vaddr_t)ta_elf_lazy_bind_entry;
+}
+#else
+static bool bind_lazily(struct ta_elf *elf __unused)
+{
+	return false;
+}
+
+static void init_lazy_got(struct ta_elf *elf __unused)
+{
+}
+#endif /*CFG_TA_LAZY_BINDING*/
+
 static void e32_process_dyn_rel(const Elf32_Sym *sym_tab, size_t num_syms,
 				const char *str_tab, size_t str_tab_size,
 				Elf32_Rel *rel, Elf32_Addr *where)
@@ -225,8 +426,16 @@ static void e32_relocate(struct ta_elf *elf, unsigned int rel_sidx)
 		case R_ARM_RELATIVE:
 			*where += elf->load_addr;
 			break;
-		case R_ARM_GLOB_DAT:
 		case R_ARM_JUMP_SLOT:
+			/* Points to PLT0 until bound by ta_elf_lazy_resolve() */
+			if (bind_lazily(elf)) {
+				*where += elf->load_addr;
+				break;
+			}
+			e32_process_dyn_rel(sym_tab, num_syms, str_tab,
+					    str_tab_size, rel, where);
+			break;
+		case R_ARM_GLOB_DAT:
 			e32_process_dyn_rel(sym_tab, num_syms, str_tab,
 					    str_tab_size, rel, where);
 			break;
@@ -237,6 +446,56 @@ static void e32_relocate(struct ta_elf *elf, unsigned int rel_sidx)
 	}
 }
 
+/*
+ * A SHT_RELR section holds R_*_RELATIVE relocations in compact form. An
+ * even entry is the offset of a word to relocate. An odd entry is a bitmap
+ * of which of the following 31 words, starting after the last relocated
+ * address, are to be relocated.
+ */
+static void e32_relocate_relr(struct ta_elf *elf, unsigned int rel_sidx)
+{
+	Elf32_Shdr *shdr = elf->shdr;
+	Elf32_Addr *relr = NULL;
+	Elf32_Addr *relr_end = NULL;
+	Elf32_Addr *where = NULL;
+	size_t sh_end = 0;
+	uint32_t bitmap = 0;
+	size_t n = 0;
+
+	assert(shdr[rel_sidx].sh_type == SHT_RELR);
+
+	assert(shdr[rel_sidx].sh_entsize == sizeof(Elf32_Addr));
+
+	/* Check the address is inside TA memory */
+	if (ADD_OVERFLOW(shdr[rel_sidx].sh_addr, shdr[rel_sidx].sh_size,
+			 &sh_end))
+		err(TEE_ERROR_SECURITY, "Overflow");
+	assert(sh_end < (elf->max_addr - elf->load_addr));
+	relr = (Elf32_Addr *)(elf->load_addr + shdr[rel_sidx].sh_addr);
+	relr_end = relr + shdr[rel_sidx].sh_size / sizeof(Elf32_Addr);
+
+	for (; relr < relr_end; relr++) {
+		if (!(*relr & 1)) {
+			/* Check the address is inside TA memory */
+			assert(*relr < (elf->max_addr - elf->load_addr));
+			where = (Elf32_Addr *)(elf->load_addr + *relr);
+			*where++ += elf->load_addr;
+			continue;
+		}
+
+		if (!where)
+			err(TEE_ERROR_BAD_FORMAT, "Bad RELR bitmap");
+		for (bitmap = *relr >> 1, n = 0; bitmap; bitmap >>= 1, n++) {
+			if (!(bitmap & 1))
+				continue;
+			/* Check the address is inside TA memory */
+			assert((vaddr_t)(where + n) < elf->max_addr);
+			where[n] += elf->load_addr;
+		}
+		where += 8 * sizeof(Elf32_Addr) - 1;
+	}
+}
+
 #ifdef ARM64
 static void e64_process_dyn_rela(const Elf64_Sym *sym_tab, size_t num_syms,
 				 const char *str_tab, size_t str_tab_size,
@@ -342,8 +601,16 @@ static void e64_relocate(struct ta_elf *elf, unsigned int rel_sidx)
 		case R_AARCH64_RELATIVE:
 			*where = rela->r_addend + elf->load_addr;
 			break;
-		case R_AARCH64_GLOB_DAT:
 		case R_AARCH64_JUMP_SLOT:
+			/* Points to PLT0 until bound by ta_elf_lazy_resolve() */
+			if (bind_lazily(elf)) {
+				*where += elf->load_addr;
+				break;
+			}
+			e64_process_dyn_rela(sym_tab, num_syms, str_tab,
+					     str_tab_size, rela, where);
+			break;
+		case R_AARCH64_GLOB_DAT:
 			e64_process_dyn_rela(sym_tab, num_syms, str_tab,
 					     str_tab_size, rela, where);
 			break;
@@ -353,12 +620,62 @@ static void e64_relocate(struct ta_elf *elf, unsigned int rel_sidx)
 		}
 	}
 }
+
+static void e64_relocate_relr(struct ta_elf *elf, unsigned int rel_sidx)
+{
+	Elf64_Shdr *shdr = elf->shdr;
+	Elf64_Addr *relr = NULL;
+	Elf64_Addr *relr_end = NULL;
+	Elf64_Addr *where = NULL;
+	size_t sh_end = 0;
+	uint64_t bitmap = 0;
+	size_t n = 0;
+
+	assert(shdr[rel_sidx].sh_type == SHT_RELR);
+
+	assert(shdr[rel_sidx].sh_entsize == sizeof(Elf64_Addr));
+
+	/* Check the address is inside TA memory */
+	if (ADD_OVERFLOW(shdr[rel_sidx].sh_addr, shdr[rel_sidx].sh_size,
+			 &sh_end))
+		err(TEE_ERROR_SECURITY, "Overflow");
+	assert(sh_end < (elf->max_addr - elf->load_addr));
+	relr = (Elf64_Addr *)(elf->load_addr + shdr[rel_sidx].sh_addr);
+	relr_end = relr + shdr[rel_sidx].sh_size / sizeof(Elf64_Addr);
+
+	for (; relr < relr_end; relr++) {
+		if (!(*relr & 1)) {
+			/* Check the address is inside TA memory */
+			assert(*relr < (elf->max_addr - elf->load_addr));
+			where = (Elf64_Addr *)(elf->load_addr + *relr);
+			*where++ += elf->load_addr;
+			continue;
+		}
+
+		if (!where)
+			err(TEE_ERROR_BAD_FORMAT, "Bad RELR bitmap");
+		for (bitmap = *relr >> 1, n = 0; bitmap; bitmap >>= 1, n++) {
+			if (!(bitmap & 1))
+				continue;
+			/* Check the address is inside TA memory */
+			assert((vaddr_t)(where + n) < elf->max_addr);
+			where[n] += elf->load_addr;
+		}
+		where += 8 * sizeof(Elf64_Addr) - 1;
+	}
+}
 #else /*ARM64*/
 static void __noreturn e64_relocate(struct ta_elf *elf __unused,
 				    unsigned int rel_sidx __unused)
 {
 	err(TEE_ERROR_NOT_SUPPORTED, "arm64 not supported");
 }
+
+static void __noreturn e64_relocate_relr(struct ta_elf *elf __unused,
+					 unsigned int rel_sidx __unused)
+{
+	err(TEE_ERROR_NOT_SUPPORTED, "arm64 not supported");
+}
 #endif /*ARM64*/
 
 void ta_elf_relocate(struct ta_elf *elf)
@@ -368,15 +685,24 @@ void ta_elf_relocate(struct ta_elf *elf)
 	if (elf->is_32bit) {
 		Elf32_Shdr *shdr = elf->shdr;
 
-		for (n = 0; n < elf->e_shnum; n++)
+		for (n = 0; n < elf->e_shnum; n++) {
 			if (shdr[n].sh_type == SHT_REL)
 				e32_relocate(elf, n);
+			else if (shdr[n].sh_type == SHT_RELR)
+				e32_relocate_relr(elf, n);
+		}
 	} else {
 		Elf64_Shdr *shdr = elf->shdr;
 
-		for (n = 0; n < elf->e_shnum; n++)
+		for (n = 0; n < elf->e_shnum; n++) {
 			if (shdr[n].sh_type == SHT_RELA)
 				e64_relocate(elf, n);
+			else if (shdr[n].sh_type == SHT_RELR)
+				e64_relocate_relr(elf, n);
+		}
 
 	}
+
+	if (bind_lazily(elf))
+		init_lazy_got(elf);
 }
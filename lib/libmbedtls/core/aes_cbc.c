@@ -14,6 +14,8 @@
 #include <utee_defines.h>
 #include <util.h>
 
+#include "mbed_ce.h"
+
 struct mbed_aes_cbc_ctx {
 	struct crypto_cipher_ctx ctx;
 	int mbed_mode;
@@ -69,6 +71,10 @@ static TEE_Result mbed_aes_cbc_update(struct crypto_cipher_ctx *ctx,
 {
 	struct mbed_aes_cbc_ctx *c = to_aes_cbc_ctx(ctx);
 
+	if (mbed_aes_ce_crypt_cbc(&c->aes_ctx, c->mbed_mode, len, c->iv, data,
+				  dst))
+		return TEE_SUCCESS;
+
 	if (mbedtls_aes_crypt_cbc(&c->aes_ctx, c->mbed_mode, len, c->iv,
 				  data, dst))
 		return TEE_ERROR_BAD_STATE;
@@ -14,6 +14,8 @@
 #include <utee_defines.h>
 #include <util.h>
 
+#include "mbed_ce.h"
+
 struct mbed_aes_ctr_ctx {
 	struct crypto_cipher_ctx ctx;
 	mbedtls_aes_context aes_ctx;
@@ -59,12 +61,15 @@ static TEE_Result mbed_aes_ctr_update(struct crypto_cipher_ctx *ctx,
 				      uint8_t *dst)
 {
 	struct mbed_aes_ctr_ctx *c = to_aes_ctr_ctx(ctx);
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t ce_state = mbed_aes_ce_hold();
 
 	if (mbedtls_aes_crypt_ctr(&c->aes_ctx, len, &c->nc_off, c->counter,
 				   c->block, data, dst))
-		return TEE_ERROR_BAD_STATE;
+		res = TEE_ERROR_BAD_STATE;
+	mbed_aes_ce_release(ce_state);
 
-	return TEE_SUCCESS;
+	return res;
 }
 
 static void mbed_aes_ctr_final(struct crypto_cipher_ctx *ctx)
@@ -14,6 +14,8 @@
 #include <utee_defines.h>
 #include <util.h>
 
+#include "mbed_ce.h"
+
 struct mbed_aes_ecb_ctx {
 	struct crypto_cipher_ctx ctx;
 	int mbed_mode;
@@ -70,6 +72,9 @@ static TEE_Result mbed_aes_ecb_update(struct crypto_cipher_ctx *ctx,
 	if (len % block_size)
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	if (mbed_aes_ce_crypt_ecb(&c->aes_ctx, c->mbed_mode, len, data, dst))
+		return TEE_SUCCESS;
+
 	for (offs = 0; offs < len; offs += block_size) {
 		if (mbedtls_aes_crypt_ecb(&c->aes_ctx, c->mbed_mode,
 					  data + offs, dst + offs))
@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <compiler.h>
+#include <kernel/thread.h>
+#include <limits.h>
+#include <mbedtls/aes.h>
+#include <mbedtls/sha1.h>
+#include <mbedtls/sha256.h>
+#include <utee_defines.h>
+
+#include "mbed_ce.h"
+
+/*
+ * mbedTLS primitives on top of the ARMv8 Cryptographic Extensions kernels
+ * in core/arch/arm/crypto, the ones LibTomCrypt uses too.
+ *
+ * The key schedules of mbedtls_aes_setkey_enc() and
+ * mbedtls_aes_setkey_dec() already have the layout the kernels expect,
+ * round keys as little endian words and for decryption in reverse order
+ * with InvMixColumns applied to all but the outer two. Only the block
+ * functions are replaced.
+ */
+
+/* Implemented in assembly */
+void ce_aes_ecb_encrypt(uint8_t out[], uint8_t const in[], uint8_t const rk[],
+			int rounds, int blocks, int first);
+void ce_aes_ecb_decrypt(uint8_t out[], uint8_t const in[], uint8_t const rk[],
+			int rounds, int blocks, int first);
+void ce_aes_cbc_encrypt(uint8_t out[], uint8_t const in[], uint8_t const rk[],
+			int rounds, int blocks, uint8_t iv[]);
+void ce_aes_cbc_decrypt(uint8_t out[], uint8_t const in[], uint8_t const rk[],
+			int rounds, int blocks, uint8_t iv[]);
+void sha1_ce_transform(uint32_t *state, const unsigned char *src, int blocks);
+int sha256_ce_transform(uint32_t *state, const unsigned char *src, int blocks);
+
+#if defined(MBEDTLS_AES_ENCRYPT_ALT)
+static const uint8_t *round_keys(const mbedtls_aes_context *ctx)
+{
+	return (const uint8_t *)ctx->rk;
+}
+
+int mbedtls_internal_aes_encrypt(mbedtls_aes_context *ctx,
+				 const unsigned char input[16],
+				 unsigned char output[16])
+{
+	uint32_t vfp_state = thread_kernel_enable_vfp();
+
+	ce_aes_ecb_encrypt(output, input, round_keys(ctx), ctx->nr, 1, 1);
+	thread_kernel_disable_vfp(vfp_state);
+
+	return 0;
+}
+
+int mbedtls_internal_aes_decrypt(mbedtls_aes_context *ctx,
+				 const unsigned char input[16],
+				 unsigned char output[16])
+{
+	uint32_t vfp_state = thread_kernel_enable_vfp();
+
+	ce_aes_ecb_decrypt(output, input, round_keys(ctx), ctx->nr, 1, 1);
+	thread_kernel_disable_vfp(vfp_state);
+
+	return 0;
+}
+
+bool mbed_aes_ce_crypt_ecb(mbedtls_aes_context *ctx, int mode, size_t len,
+			   const uint8_t *src, uint8_t *dst)
+{
+	size_t blocks = len / TEE_AES_BLOCK_SIZE;
+	uint32_t vfp_state = 0;
+
+	if (!blocks || blocks > INT_MAX)
+		return false;
+
+	vfp_state = thread_kernel_enable_vfp();
+	if (mode == MBEDTLS_AES_ENCRYPT)
+		ce_aes_ecb_encrypt(dst, src, round_keys(ctx), ctx->nr, blocks,
+				   1);
+	else
+		ce_aes_ecb_decrypt(dst, src, round_keys(ctx), ctx->nr, blocks,
+				   1);
+	thread_kernel_disable_vfp(vfp_state);
+
+	return true;
+}
+
+bool mbed_aes_ce_crypt_cbc(mbedtls_aes_context *ctx, int mode, size_t len,
+			   uint8_t iv[16], const uint8_t *src, uint8_t *dst)
+{
+	size_t blocks = len / TEE_AES_BLOCK_SIZE;
+	uint32_t vfp_state = 0;
+
+	if (!blocks || blocks > INT_MAX || len % TEE_AES_BLOCK_SIZE)
+		return false;
+
+	/* The kernels return the next IV in @iv */
+	vfp_state = thread_kernel_enable_vfp();
+	if (mode == MBEDTLS_AES_ENCRYPT)
+		ce_aes_cbc_encrypt(dst, src, round_keys(ctx), ctx->nr, blocks,
+				   iv);
+	else
+		ce_aes_cbc_decrypt(dst, src, round_keys(ctx), ctx->nr, blocks,
+				   iv);
+	thread_kernel_disable_vfp(vfp_state);
+
+	return true;
+}
+#endif /*MBEDTLS_AES_ENCRYPT_ALT*/
+
+#if defined(MBEDTLS_SHA1_PROCESS_ALT)
+int mbedtls_internal_sha1_process(mbedtls_sha1_context *ctx,
+				  const unsigned char data[64])
+{
+	uint32_t vfp_state = thread_kernel_enable_vfp();
+
+	sha1_ce_transform(ctx->state, data, 1);
+	thread_kernel_disable_vfp(vfp_state);
+
+	return 0;
+}
+#endif
+
+#if defined(MBEDTLS_SHA256_PROCESS_ALT)
+int mbedtls_internal_sha256_process(mbedtls_sha256_context *ctx,
+				    const unsigned char data[64])
+{
+	uint32_t vfp_state = thread_kernel_enable_vfp();
+
+	/* SHA-224 only differs in the initial state and the output size */
+	sha256_ce_transform(ctx->state, data, 1);
+	thread_kernel_disable_vfp(vfp_state);
+
+	return 0;
+}
+#endif
@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __MBED_CE_H
+#define __MBED_CE_H
+
+#include <mbedtls/aes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The mbedTLS cipher modes call the AES block functions once per block,
+ * with the Cryptographic Extensions each call enables and disables VFP.
+ * ECB and CBC are instead passed in full to the multi-block kernels and
+ * the other modes hold VFP across an update, which turns the enabling
+ * per block into nested calls which only count.
+ *
+ * mbed_aes_ce_crypt_ecb() and mbed_aes_ce_crypt_cbc() return false if
+ * the data wasn't processed and mbedTLS is to be called instead.
+ */
+#if defined(MBEDTLS_AES_ENCRYPT_ALT)
+#include <kernel/thread.h>
+
+bool mbed_aes_ce_crypt_ecb(mbedtls_aes_context *ctx, int mode, size_t len,
+			   const uint8_t *src, uint8_t *dst);
+bool mbed_aes_ce_crypt_cbc(mbedtls_aes_context *ctx, int mode, size_t len,
+			   uint8_t iv[16], const uint8_t *src, uint8_t *dst);
+
+static inline uint32_t mbed_aes_ce_hold(void)
+{
+	return thread_kernel_enable_vfp();
+}
+
+static inline void mbed_aes_ce_release(uint32_t state)
+{
+	thread_kernel_disable_vfp(state);
+}
+#else
+static inline bool mbed_aes_ce_crypt_ecb(mbedtls_aes_context *ctx __unused,
+					 int mode __unused,
+					 size_t len __unused,
+					 const uint8_t *src __unused,
+					 uint8_t *dst __unused)
+{
+	return false;
+}
+
+static inline bool mbed_aes_ce_crypt_cbc(mbedtls_aes_context *ctx __unused,
+					 int mode __unused,
+					 size_t len __unused,
+					 uint8_t iv[16] __unused,
+					 const uint8_t *src __unused,
+					 uint8_t *dst __unused)
+{
+	return false;
+}
+
+static inline uint32_t mbed_aes_ce_hold(void)
+{
+	return 0;
+}
+
+static inline void mbed_aes_ce_release(uint32_t state __unused)
+{
+}
+#endif
+
+#endif /*__MBED_CE_H*/
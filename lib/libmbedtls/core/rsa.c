@@ -190,6 +190,11 @@ void crypto_acipher_free_rsa_public_key(struct rsa_public_key *s)
 	crypto_bignum_free(s->e);
 }
 
+void crypto_acipher_clear_rsa_keypair_cache(struct rsa_keypair *s __unused)
+{
+	/* Nothing is cached, the key is loaded into a new context each time */
+}
+
 TEE_Result crypto_acipher_gen_rsa_key(struct rsa_keypair *key, size_t key_size)
 {
 	TEE_Result res = TEE_SUCCESS;
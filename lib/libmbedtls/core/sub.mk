@@ -1,4 +1,8 @@
 srcs-y += tomcrypt.c
+srcs-$(call cfg-one-enabled, CFG_CRYPTO_AES_ARM32_CE CFG_CRYPTO_AES_ARM64_CE \
+			     CFG_CRYPTO_SHA1_ARM32_CE CFG_CRYPTO_SHA1_ARM64_CE \
+			     CFG_CRYPTO_SHA256_ARM32_CE \
+			     CFG_CRYPTO_SHA256_ARM64_CE) += armv8a_ce.c
 srcs-$(call cfg-one-enabled, CFG_CRYPTO_MD5 CFG_CRYPTO_SHA1 CFG_CRYPTO_SHA224 \
 			     CFG_CRYPTO_SHA256 CFG_CRYPTO_SHA384 \
 			     CFG_CRYPTO_SHA512) += hash.c
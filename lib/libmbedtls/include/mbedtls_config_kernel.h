@@ -5,7 +5,11 @@
 
 #ifdef CFG_CORE_MBEDTLS_MPI
 #ifdef ARM32
-#define MBEDTLS_HAVE_INT32
+/*
+ * 32-bit limbs are the default on ARM32, MBEDTLS_HAVE_ASM instead of
+ * MBEDTLS_HAVE_INT32 enables the UMAAL multiply-accumulate in bn_mul.h.
+ */
+#define MBEDTLS_HAVE_ASM
 #endif
 #ifdef ARM64
 #define MBEDTLS_HAVE_INT64
@@ -25,11 +29,18 @@
 #if defined(CFG_CRYPTO_SHA1)
 #define MBEDTLS_SHA1_C
 #define MBEDTLS_MD_C
+#if defined(CFG_CRYPTO_SHA1_ARM32_CE) || defined(CFG_CRYPTO_SHA1_ARM64_CE)
+/* Implemented in lib/libmbedtls/core/armv8a_ce.c */
+#define MBEDTLS_SHA1_PROCESS_ALT
+#endif
 #endif
 
 #if defined(CFG_CRYPTO_SHA224) || defined(CFG_CRYPTO_SHA256)
 #define MBEDTLS_SHA256_C
 #define MBEDTLS_MD_C
+#if defined(CFG_CRYPTO_SHA256_ARM32_CE) || defined(CFG_CRYPTO_SHA256_ARM64_CE)
+#define MBEDTLS_SHA256_PROCESS_ALT
+#endif
 #endif
 
 #if defined(CFG_CRYPTO_SHA384) || defined(CFG_CRYPTO_SHA512)
@@ -44,6 +55,10 @@
 #if defined(CFG_CRYPTO_AES)
 #define MBEDTLS_AES_C
 #define MBEDTLS_AES_ROM_TABLES
+#if defined(CFG_CRYPTO_AES_ARM32_CE) || defined(CFG_CRYPTO_AES_ARM64_CE)
+#define MBEDTLS_AES_ENCRYPT_ALT
+#define MBEDTLS_AES_DECRYPT_ALT
+#endif
 #endif
 
 #if defined(CFG_CRYPTO_DES)
@@ -0,0 +1 @@
+srcs-$(CFG_ARM64_$(sm)) += mpa_montgomery_a64.S
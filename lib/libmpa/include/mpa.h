@@ -201,11 +201,16 @@ void __mpa_shift_words_right(mpanum op, mpa_word_t q);
 
 void __mpa_montgomery_sub_ack(mpanum dest, mpanum src);
 
-void __mpa_montgomery_mul_add(mpanum dest, mpanum src, mpa_word_t w);
-
 void __mpa_montgomery_mul(mpanum dest,
 			  mpanum op1, mpanum op2, mpanum n, mpa_word_t n_inv);
 
+#if defined(ARM64)
+/* From arch/arm/mpa_montgomery_a64.S */
+void __mpa_montgomery_mul_a64(uint64_t *t, const uint64_t *a,
+			      const uint64_t *b, const uint64_t *n,
+			      size_t limbs, uint64_t n_inv);
+#endif
+
 /*------------------------------------------------------------
  *
  *  From mpa_misc.c
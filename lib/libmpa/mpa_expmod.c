@@ -10,14 +10,124 @@
 		*b = tmp; \
 	} while (0)
 
+/* Number of exponent bits handled per multiplication */
+#define EXP_WINDOW_BITS		4
+#define EXP_TABLE_SIZE		(1 << EXP_WINDOW_BITS)
+
+/*
+ * Copies table[idx] to dest, every entry is read so the memory access
+ * pattern doesn't depend on idx. Entries are less than n, that is at
+ * most @words long.
+ */
+static void select_table_entry(mpanum dest, mpanum *table, mpa_word_t idx,
+			       mpa_usize_t words)
+{
+	mpa_word_t mask = 0;
+	mpa_usize_t size = 0;
+	mpa_word_t i = 0;
+	mpa_usize_t j = 0;
+
+	mpa_memset(dest->d, 0, (words + 1) * BYTES_PER_WORD);
+	for (i = 0; i < EXP_TABLE_SIZE; i++) {
+		/* All ones if i == idx, else zero */
+		mask = 0 - (((i ^ idx) - 1) >> (WORD_SIZE - 1));
+		for (j = 0; j < words; j++)
+			dest->d[j] |= table[i]->d[j] & mask;
+		size |= table[i]->size & mask;
+	}
+	dest->size = size;
+}
+
+/*
+ * Fixed window exponentiation, one squaring per exponent bit and one
+ * multiplication per window. The multiplication is done for all windows,
+ * zero included, and the table entry is selected in constant time so the
+ * sequence of operations only depends on the length of the exponent.
+ *
+ * Returns false if the scratch memory can't hold the table.
+ */
+static bool exp_mod_window(mpanum dest, const mpanum op1, const mpanum op2,
+			   const mpanum n, const mpanum r_modn,
+			   const mpanum r2_modn, const mpa_word_t n_inv,
+			   mpa_scratch_mem pool)
+{
+	mpanum table[EXP_TABLE_SIZE] = { NULL };
+	mpa_usize_t s = __mpanum_size(n);
+	mpanum A = NULL;
+	mpanum tmp_a = NULL;
+	mpanum sel = NULL;
+	mpanum *ptr_a = &A;
+	mpanum *ptr_tmp_a = &tmp_a;
+	mpa_word_t w = 0;
+	bool ret = false;
+	int idx = 0;
+	int i = 0;
+
+	for (i = 0; i < EXP_TABLE_SIZE; i++)
+		if (!mpa_alloc_static_temp_var_size(WORDS_TO_BITS(s + 1),
+						    table + i, pool))
+			goto out;
+	if (!mpa_alloc_static_temp_var_size(WORDS_TO_BITS(s + 1), &sel, pool) ||
+	    !mpa_alloc_static_temp_var(&A, pool) ||
+	    !mpa_alloc_static_temp_var(&tmp_a, pool))
+		goto out;
+
+	/* table[i] = op1^i in Montgomery space */
+	mpa_wipe(table[0]);
+	mpa_copy(table[0], r_modn);
+	__mpa_montgomery_mul(table[1], op1, r2_modn, n, n_inv);
+	for (i = 2; i < EXP_TABLE_SIZE; i++)
+		__mpa_montgomery_mul(table[i], table[i - 1], table[1], n,
+				     n_inv);
+
+	mpa_wipe(A);
+	mpa_copy(A, r_modn);
+
+	/* The exponent is zero extended to a whole number of windows */
+	idx = mpa_highest_bit_index(op2) + 1;
+	idx = ((idx + EXP_WINDOW_BITS - 1) / EXP_WINDOW_BITS - 1) *
+	      EXP_WINDOW_BITS;
+	for (; idx >= 0; idx -= EXP_WINDOW_BITS) {
+		for (i = 0; i < EXP_WINDOW_BITS; i++) {
+			__mpa_montgomery_mul(*ptr_tmp_a, *ptr_a, *ptr_a, n,
+					     n_inv);
+			swp(&ptr_tmp_a, &ptr_a);
+		}
+
+		w = 0;
+		for (i = 0; i < EXP_WINDOW_BITS; i++)
+			w |= mpa_get_bit(op2, idx + i) << i;
+		select_table_entry(sel, table, w, s);
+
+		__mpa_montgomery_mul(*ptr_tmp_a, *ptr_a, sel, n, n_inv);
+		swp(&ptr_tmp_a, &ptr_a);
+	}
+
+	/* Transform back from Montgomery space */
+	__mpa_montgomery_mul(*ptr_tmp_a, (const mpanum)&const_one, *ptr_a,
+			     n, n_inv);
+	mpa_copy(dest, *ptr_tmp_a);
+	ret = true;
+out:
+	mpa_free_static_temp_var(&tmp_a, pool);
+	mpa_free_static_temp_var(&A, pool);
+	mpa_free_static_temp_var(&sel, pool);
+	for (i = EXP_TABLE_SIZE - 1; i >= 0; i--)
+		mpa_free_static_temp_var(table + i, pool);
+	return ret;
+}
+
 /*------------------------------------------------------------
  *
  *  mpa_exp_mod
  *
  *  Calculates dest = op1 ^ op2 mod n
  *
- * This function uses the Montgomery ladder concept as proposed by Marc Joye and
- * Sun-Ming Yen, which makes the function more resistant to timing attacks.
+ * A fixed window exponentiation is used when the scratch memory can hold
+ * the table of powers, the Montgomery ladder otherwise. Both make the
+ * function more resistant to timing attacks.
+ *
+ * The Montgomery ladder concept was proposed by Marc Joye and Sun-Ming Yen.
  */
 void mpa_exp_mod(mpanum dest,
 		 const mpanum op1,
@@ -37,6 +147,9 @@ void mpa_exp_mod(mpanum dest,
 	mpanum *ptr_tmp_xtilde;
 	int idx;
 
+	if (exp_mod_window(dest, op1, op2, n, r_modn, r2_modn, n_inv, pool))
+		return;
+
 	mpa_alloc_static_temp_var(&A, pool);
 	mpa_alloc_static_temp_var(&tmp_a, pool);
 	mpa_alloc_static_temp_var(&xtilde, pool);
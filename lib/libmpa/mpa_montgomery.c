@@ -17,46 +17,6 @@
  */
 #if !defined(USE_ARM_ASM)
 
-/*  --------------------------------------------------------------------
- *  Function:  __mpa_montgomery_mul_add
- *  Calculates dest = dest + src*w
- *  Dest must be big enough to hold the result
- */
-void __mpa_montgomery_mul_add(mpanum dest, mpanum src, mpa_word_t w)
-{
-#if defined(MPA_SUPPORT_DWORD_T)
-	mpa_dword_t a;
-	mpa_word_t *ddig;
-	int32_t idx;
-	mpa_word_t carry;
-	mpa_word_t *dest_begin;
-
-	if (w == 0)
-		return;
-	dest_begin = dest->d;
-	ddig = dest->d;
-	carry = 0;
-	for (idx = 0; idx < src->size; idx++) {
-		a = (mpa_dword_t) *ddig +
-		    (mpa_dword_t) src->d[idx] * (mpa_dword_t) w +
-		    (mpa_dword_t) (carry);
-		*(ddig++) = (mpa_word_t) (a);
-		carry = (mpa_word_t) (a >> WORD_SIZE);
-	}
-	while (carry) {
-		a = (mpa_dword_t) (*ddig) + (mpa_dword_t) (carry);
-		*(ddig++) = (mpa_word_t) (a);
-		carry = (mpa_word_t) (a >> WORD_SIZE);
-	}
-	idx = (mpa_word_t) (ddig - dest_begin);
-	if (idx > dest->size)
-		dest->size = idx;
-
-#else
-#error write non-dword code for __mpa_montgomery_mul_add
-#endif
-}
-
 /*  --------------------------------------------------------------------
  *  Function:  __mpa_montgomery_sub_ack
  *  Calculates dest = dest - src
@@ -102,10 +62,63 @@ void __mpa_montgomery_sub_ack(mpanum dest, mpanum src)
 
 #endif /* USE_ARM_ASM */
 
+#if defined(ARM64)
+/*
+ * The AArch64 kernel works on 64-bit limbs, the operands must be 8 byte
+ * aligned and readable, with zeroes, up to the size of the modulus.
+ */
+static bool montgomery_a64_operand_ok(const mpanum op, mpa_usize_t size)
+{
+	mpa_usize_t i = 0;
+
+	if ((uintptr_t)op->d & 7 || (mpa_usize_t)__mpanum_alloced(op) < size)
+		return false;
+	for (i = __mpanum_size(op); i < size; i++)
+		if (op->d[i])
+			return false;
+	return true;
+}
+
+/* Extends n_inv = -n^-1 mod 2^32 to -n^-1 mod 2^64 with a Newton step */
+static uint64_t montgomery_a64_n_inv(const mpanum n, mpa_word_t n_inv)
+{
+	uint64_t n0 = n->d[0] | ((uint64_t)n->d[1] << 32);
+	uint64_t x = (mpa_word_t)(0 - n_inv);
+
+	x *= 2 - n0 * x;
+	return 0 - x;
+}
+
+static bool montgomery_mul_a64(mpanum dest, mpanum op1, mpanum op2,
+			       mpanum n, mpa_word_t n_inv)
+{
+	mpa_usize_t s = __mpanum_size(n);
+
+	/* The kernel handles two limbs, four words, per iteration */
+	if (!s || s % 4 || (uintptr_t)dest->d & 7 || (uintptr_t)n->d & 7 ||
+	    !montgomery_a64_operand_ok(op1, s) ||
+	    !montgomery_a64_operand_ok(op2, s))
+		return false;
+
+	__mpa_montgomery_mul_a64((void *)dest->d, (void *)op1->d,
+				 (void *)op2->d, (void *)n->d, s / 2,
+				 montgomery_a64_n_inv(n, n_inv));
+
+	dest->size = s;
+	while (dest->size > 0 && dest->d[dest->size - 1] == 0)
+		dest->size--;
+	return true;
+}
+#endif
+
 /*------------------------------------------------------------
  *
  *  __mpa_montgomery_mul
  *
+ *  Calculates dest = op1 * op2 * R^-1 mod n where R = 2^(n->size *
+ *  WORD_SIZE). The multiplication and the reduction are interleaved
+ *  word by word (CIOS) and the accumulator is shifted down on the fly.
+ *
  *  NOTE:
  *  Dest need to be able to hold one more word than the size of n
  *
@@ -113,27 +126,63 @@ void __mpa_montgomery_sub_ack(mpanum dest, mpanum src)
 void __mpa_montgomery_mul(mpanum dest, mpanum op1, mpanum op2, mpanum n,
 			  mpa_word_t n_inv)
 {
-	mpa_word_t u;
-	mpa_usize_t idx;
+	mpa_usize_t s = __mpanum_size(n);
+	mpa_usize_t s2 = __MIN(__mpanum_size(op2), s);
+	mpa_word_t *t = dest->d;
+	mpa_dword_t a = 0;
+	mpa_word_t ai = 0;
+	mpa_word_t u = 0;
+	mpa_word_t c1 = 0;
+	mpa_word_t c2 = 0;
+	mpa_word_t th = 0;	/* t[s], 0 or 1 */
+	mpa_usize_t idx = 0;
+	mpa_usize_t j = 0;
 
 	/* set dest to zero (with all unused digits to zero as well) */
 	mpa_wipe(dest);
 
-	for (idx = 0; idx < n->size; idx++) {
-		u = (dest->d[0] +
-		     __mpanum_get_word(idx, op1) *
-		     __mpanum_get_word(0, op2)) * n_inv;
+#if defined(ARM64)
+	if (montgomery_mul_a64(dest, op1, op2, n, n_inv))
+		return;
+#endif
 
-		__mpa_montgomery_mul_add(dest, op2,
-					 __mpanum_get_word(idx, op1));
-		__mpa_montgomery_mul_add(dest, n, u);
+	for (idx = 0; idx < s; idx++) {
+		ai = __mpanum_get_word(idx, op1);
 
-		/* Shift right one mpa_word */
-		dest->size--;
-		for (mpa_usize_t i = 0; i < dest->size; i++)
-			dest->d[i] = dest->d[i + 1];
-		*(dest->d + dest->size) = 0;	/* set unused digit to zero. */
+		/* The lowest word only gives u, it's zero after reduction */
+		a = (mpa_dword_t)t[0] +
+		    (mpa_dword_t)ai * __mpanum_get_word(0, op2);
+		c1 = (mpa_word_t)(a >> WORD_SIZE);
+		u = (mpa_word_t)a * n_inv;
+		a = (mpa_dword_t)(mpa_word_t)a + (mpa_dword_t)u * n->d[0];
+		c2 = (mpa_word_t)(a >> WORD_SIZE);
+
+		/* t = (t + ai * op2 + u * n) / 2^WORD_SIZE */
+		for (j = 1; j < s2; j++) {
+			a = (mpa_dword_t)t[j] + (mpa_dword_t)ai * op2->d[j] + c1;
+			c1 = (mpa_word_t)(a >> WORD_SIZE);
+			a = (mpa_dword_t)(mpa_word_t)a +
+			    (mpa_dword_t)u * n->d[j] + c2;
+			c2 = (mpa_word_t)(a >> WORD_SIZE);
+			t[j - 1] = (mpa_word_t)a;
+		}
+		for (j = __MAX(s2, 1); j < s; j++) {
+			a = (mpa_dword_t)t[j] + c1;
+			c1 = (mpa_word_t)(a >> WORD_SIZE);
+			a = (mpa_dword_t)(mpa_word_t)a +
+			    (mpa_dword_t)u * n->d[j] + c2;
+			c2 = (mpa_word_t)(a >> WORD_SIZE);
+			t[j - 1] = (mpa_word_t)a;
+		}
+		a = (mpa_dword_t)th + c1 + c2;
+		t[s - 1] = (mpa_word_t)a;
+		th = (mpa_word_t)(a >> WORD_SIZE);
 	}
+	t[s] = th;
+
+	dest->size = s + 1;
+	while (dest->size > 0 && dest->d[dest->size - 1] == 0)
+		dest->size--;
 
 	/* check if dest > n, if so set dest = dest - n */
 	if (__mpa_abs_cmp(dest, n) >= 0)
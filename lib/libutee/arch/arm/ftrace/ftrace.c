@@ -13,10 +13,86 @@
 #include <arm_user_sysreg.h>
 #include <assert.h>
 #include <setjmp.h>
+#include <tee_internal_api_extensions.h>
 #include <user_ta_header.h>
 #include <utee_syscalls.h>
 #include "ftrace.h"
 
+static bool __noprof is_filtered(struct ftrace_buf *fbuf, unsigned long pc)
+{
+	return fbuf->filter_end &&
+	       (pc < fbuf->filter_start || pc >= fbuf->filter_end);
+}
+
+#ifdef CFG_TA_FTRACE_STREAM
+/*
+ * Adds a record to the ring if there's room for it and @reserve more
+ * records. The ring has a single producer, the TA, and a single consumer,
+ * the core, so it doesn't need any lock.
+ */
+static bool __noprof ring_put(struct ftrace_buf *fbuf, unsigned long pc,
+			      uint32_t reserve)
+{
+	struct ftrace_rec *rec = (void *)((char *)fbuf + fbuf->buf_off);
+	uint32_t head = fbuf->ring_head;
+	uint32_t tail = __atomic_load_n(&fbuf->ring_tail, __ATOMIC_ACQUIRE);
+
+	if (fbuf->ring_size - (head - tail) <= reserve)
+		return false;
+
+	rec += head % fbuf->ring_size;
+	rec->ts = read_cntpct() - fbuf->ts_offset;
+	rec->pc = pc;
+	__atomic_store_n(&fbuf->ring_head, head + 1, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+void __noprof ftrace_enter(unsigned long pc, unsigned long *lr)
+{
+	struct ftrace_buf *fbuf = &__ftrace_buf_start;
+
+	if (!fbuf->ring_size || is_filtered(fbuf, pc))
+		return;
+
+	/*
+	 * This scenario isn't expected as function call depth shouldn't be
+	 * more than FTRACE_RETFUNC_DEPTH.
+	 */
+	if (fbuf->ret_idx >= FTRACE_RETFUNC_DEPTH)
+		utee_panic(0);
+
+	/*
+	 * Room is kept for the returns of the functions being traced so
+	 * only function entries are lost if the core doesn't drain the
+	 * ring in time. The return of a function which entry is lost
+	 * isn't hooked.
+	 */
+	if (!ring_put(fbuf, pc, fbuf->ret_idx + 1)) {
+		fbuf->ring_lost++;
+		return;
+	}
+
+	fbuf->ret_stack[fbuf->ret_idx] = *lr;
+	fbuf->ret_idx++;
+	*lr = (unsigned long)&__ftrace_return;
+}
+
+unsigned long __noprof ftrace_return(void)
+{
+	struct ftrace_buf *fbuf = &__ftrace_buf_start;
+
+	/* Check for valid return index */
+	if (fbuf->ret_idx && (fbuf->ret_idx <= FTRACE_RETFUNC_DEPTH))
+		fbuf->ret_idx--;
+	else
+		return 0;
+
+	ring_put(fbuf, 0, 0);
+
+	return fbuf->ret_stack[fbuf->ret_idx];
+}
+#else
 #define DURATION_MAX_LEN		16
 
 static const char hex_str[] = "0123456789abcdef";
@@ -73,7 +149,7 @@ void __noprof ftrace_enter(unsigned long pc, unsigned long *lr)
 
 	fbuf = &__ftrace_buf_start;
 
-	if (!fbuf->buf_off || !fbuf->max_size)
+	if (!fbuf->buf_off || !fbuf->max_size || is_filtered(fbuf, pc))
 		return;
 
 	dump_size = DURATION_MAX_LEN + fbuf->ret_idx +
@@ -220,6 +296,7 @@ unsigned long __noprof ftrace_return(void)
 
 	return fbuf->ret_stack[fbuf->ret_idx];
 }
+#endif /*CFG_TA_FTRACE_STREAM*/
 
 void __noprof ftrace_longjmp(unsigned int *ret_idx)
 {
@@ -231,3 +308,9 @@ void __noprof ftrace_setjmp(unsigned int *ret_idx)
 {
 	*ret_idx = __ftrace_buf_start.ret_idx;
 }
+
+void __noprof tee_ftrace_set_filter(const void *start, const void *end)
+{
+	__ftrace_buf_start.filter_start = (uintptr_t)start;
+	__ftrace_buf_start.filter_end = (uintptr_t)end;
+}
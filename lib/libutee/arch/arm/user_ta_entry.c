@@ -11,6 +11,7 @@
 #include <tee_internal_api_extensions.h>
 #include <user_ta_header.h>
 #include <utee_syscalls.h>
+#include <util.h>
 #include "utee_misc.h"
 #include <tee_arith_internal.h>
 #include <malloc.h>
@@ -35,11 +36,93 @@ extern struct ta_head ta_head;
 uint32_t ta_param_types;
 TEE_Param ta_params[TEE_NUM_PARAMS];
 
+#ifdef CFG_TA_HEAP_GROW
+/* From user_ta_header.c, built within TA */
+extern const size_t ta_heap_max_size;
+
+#define HEAP_GROW_ALIGN		4096
+/* Room for the bget headers and the pool array of malloc */
+#define HEAP_GROW_OVERHEAD	128
+#define HEAP_MAX_CHUNKS		32
+
+struct heap_chunk {
+	void *va;
+	size_t len;
+};
+
+static struct heap_chunk heap_chunks[HEAP_MAX_CHUNKS];
+static size_t heap_grown_size;
+
+/*
+ * Maps another chunk of zero initialized memory when the heap runs out,
+ * the part of TA_DATA_SIZE which didn't fit in the initial heap in bss is
+ * only committed this way.
+ */
+static bool heap_grow(size_t size)
+{
+	size_t max_len = ta_heap_max_size - ta_heap_size - heap_grown_size;
+	struct heap_chunk *chunk = NULL;
+	size_t len = 0;
+	size_t n = 0;
+
+	for (n = 0; n < HEAP_MAX_CHUNKS; n++) {
+		if (!heap_chunks[n].va) {
+			chunk = heap_chunks + n;
+			break;
+		}
+	}
+	if (!chunk)
+		return false;
+
+	if (ADD_OVERFLOW(size, HEAP_GROW_OVERHEAD, &len))
+		return false;
+	len = ROUNDUP(MAX(len, (size_t)CFG_TA_HEAP_GROW_SIZE),
+		      HEAP_GROW_ALIGN);
+	if (len > max_len) {
+		len = ROUNDDOWN(max_len, HEAP_GROW_ALIGN);
+		if (len < size + HEAP_GROW_OVERHEAD)
+			return false;
+	}
+
+	chunk->va = tee_map_zi(len, 0);
+	if (!chunk->va)
+		return false;
+	chunk->len = len;
+	heap_grown_size += len;
+	malloc_add_pool(chunk->va, len);
+
+	return true;
+}
+
+void tee_heap_trim(void)
+{
+	size_t n = 0;
+
+	for (n = 0; n < HEAP_MAX_CHUNKS; n++) {
+		struct heap_chunk *chunk = heap_chunks + n;
+
+		if (!chunk->va || !malloc_remove_pool(chunk->va))
+			continue;
+		if (tee_unmap(chunk->va, chunk->len))
+			continue;
+		heap_grown_size -= chunk->len;
+		*chunk = (struct heap_chunk){ };
+	}
+}
+#else
+void tee_heap_trim(void)
+{
+}
+#endif
+
 static TEE_Result init_instance(void)
 {
 	trace_set_level(tahead_get_trace_level());
 	__utee_gprof_init();
 	malloc_add_pool(ta_heap, ta_heap_size);
+#ifdef CFG_TA_HEAP_GROW
+	malloc_set_pool_grow(heap_grow);
+#endif
 	_TEE_MathAPI_Init();
 	return TA_CreateEntryPoint();
 }
@@ -107,6 +190,7 @@ static void ta_header_remove_session(uint32_t session_id)
 		if (itr->session_id == session_id) {
 			TAILQ_REMOVE(&ta_sessions, itr, link);
 			TEE_Free(itr);
+			__utee_prop_cache_remove_session(session_id);
 
 			keep_alive =
 				(ta_head.flags & TA_FLAG_SINGLE_INSTANCE) &&
@@ -248,6 +332,8 @@ TEE_Result __utee_entry(unsigned long func, unsigned long session_id,
 {
 	TEE_Result res;
 
+	__utee_prop_cache_set_session(session_id);
+
 	switch (func) {
 	case UTEE_ENTRY_FUNC_OPEN_SESSION:
 		res = entry_open_session(session_id, up);
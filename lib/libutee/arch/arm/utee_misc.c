@@ -6,6 +6,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include <arm_user_sysreg.h>
+#include <reciprocal_div.h>
+#include <utee_defines.h>
 #include <utee_misc.h>
 #include "utee_syscalls.h"
 
@@ -15,3 +18,31 @@ unsigned int utee_get_ta_exec_id(void)
 	/* no execution ID available */
 	return 0;
 }
+
+#ifdef CFG_TA_FAST_SYSTEM_TIME
+/*
+ * The core reads the same counter for the system time, see
+ * tee_time_arm_cntpct.c. TAs are single threaded so the reciprocal of
+ * CNTFRQ is computed on first use without locking.
+ */
+bool utee_get_fast_sys_time(TEE_Time *time)
+{
+	static struct reciprocal_div cntfrq_div;
+	uint64_t cntpct = read_cntpct();
+	uint32_t rem = 0;
+
+	if (!cntfrq_div.div)
+		reciprocal_div_init(&cntfrq_div, read_cntfrq());
+
+	time->seconds = reciprocal_divide(cntpct, &cntfrq_div, &rem);
+	time->millis = reciprocal_divide((uint64_t)rem * TEE_TIME_MILLIS_BASE,
+					 &cntfrq_div, NULL);
+
+	return true;
+}
+#else
+bool utee_get_fast_sys_time(TEE_Time *time __unused)
+{
+	return false;
+}
+#endif
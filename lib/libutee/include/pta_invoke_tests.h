@@ -6,6 +6,8 @@
 #ifndef __PTA_INVOKE_TESTS_H
 #define __PTA_INVOKE_TESTS_H
 
+#include <stdint.h>
+
 #define PTA_INVOKE_TESTS_UUID \
 		{ 0xd96a5b40, 0xc3e5, 0x21e3, \
 			{ 0x87, 0x94, 0x10, 0x02, 0xa5, 0xd5, 0xc6, 0x1b } }
@@ -73,5 +75,110 @@
  */
 #define PTA_INVOKE_TESTS_CMD_LOCKDEP		8
 
+/*
+ * Measures the throughput of an authenticated encryption algorithm in
+ * core, after checking it against known answers where available
+ *
+ * [in]  value[0].a	TEE_ALG_AES_GCM or TEE_ALG_CHACHA20_POLY1305
+ * [in]  value[0].b	buffer size in bytes, at most 64 KiB
+ * [in]  value[1].a	number of iterations
+ * [out] value[2].a	elapsed time in milliseconds
+ * [out] value[2].b	throughput in kB/s, 0 if too fast to be measured
+ */
+#define PTA_INVOKE_TESTS_CMD_AE_PERF		9
+
+/*
+ * Microbenchmark of a core primitive
+ *
+ * [in]  value[0].a	Benchmark case PTA_BENCH_*
+ * [in]  value[0].b	Number of operations, at least 1
+ * [in]  value[1].a	Size in bytes of the allocations or of the crypto
+ *			buffers, number of blocks of the hash tree, number
+ *			of pages faulted in or size of the storage objects
+ *			or accesses
+ * [in]  value[1].b	Storage ID for the PTA_BENCH_STORAGE_* cases,
+ *			TEE_STORAGE_PRIVATE_REE or TEE_STORAGE_PRIVATE_RPMB
+ * [out] memref[2]	struct pta_bench_result
+ *
+ * SMC round trips are measured by the client timing PTA_BENCH_NOP
+ * invocations with one operation.
+ *
+ * PTA_BENCH_MUTEX_CONTENDED uses a mutex shared by all invocations, it's
+ * contended when invoked concurrently from several normal world threads.
+ *
+ * The PTA_BENCH_STORAGE_* cases use the object "bench" of the storage
+ * backend, removed when done:
+ * - OPEN opens and closes an object of value[1].a bytes
+ * - READ_SEQ, READ_RAND, WRITE_SEQ and WRITE_RAND read or write
+ *   value[1].a bytes, at most 64 KiB, in an object of
+ *   PTA_BENCH_STORAGE_CHUNKS times that size, in order or at a pseudo
+ *   random offset. Writes are committed by each operation.
+ * - CREATE creates an object of value[1].a bytes, removed between the
+ *   operations
+ * - REMOVE removes an object of value[1].a bytes, created between the
+ *   operations
+ */
+#define PTA_INVOKE_TESTS_CMD_BENCH		10
+
+#define PTA_BENCH_NOP				0
+#define PTA_BENCH_MALLOC			1
+#define PTA_BENCH_MEMPOOL			2
+#define PTA_BENCH_TEE_MM			3
+#define PTA_BENCH_MUTEX				4
+#define PTA_BENCH_MUTEX_CONTENDED		5
+#define PTA_BENCH_RPC				6
+#define PTA_BENCH_SHA256			7
+#define PTA_BENCH_AES_CBC			8
+#define PTA_BENCH_PAGE_FAULT			9
+#define PTA_BENCH_FS_HTREE_READ			10
+#define PTA_BENCH_FS_HTREE_WRITE		11
+#define PTA_BENCH_STORAGE_OPEN			12
+#define PTA_BENCH_STORAGE_READ_SEQ		13
+#define PTA_BENCH_STORAGE_READ_RAND		14
+#define PTA_BENCH_STORAGE_WRITE_SEQ		15
+#define PTA_BENCH_STORAGE_WRITE_RAND		16
+#define PTA_BENCH_STORAGE_CREATE		17
+#define PTA_BENCH_STORAGE_REMOVE		18
+
+#define PTA_BENCH_STORAGE_CHUNKS		16
+
+/*
+ * struct pta_bench_result - Result of PTA_INVOKE_TESTS_CMD_BENCH
+ * @ops:		Number of operations
+ * @freq:		Frequency of the counter in Hz
+ * @ticks:		Counter ticks spent in all operations
+ * @ticks_per_op:	Average counter ticks per operation
+ * @ops_per_sec:	Operations per second
+ * @min:		Fastest operation, in counter ticks
+ * @p50:		Median operation, in counter ticks
+ * @p90:		90th percentile, in counter ticks
+ * @p99:		99th percentile, in counter ticks
+ * @max:		Slowest operation, in counter ticks
+ * @rpcs:		RPCs to normal world issued by all operations, 0
+ *			unless CFG_THREAD_RPC_STATS=y
+ *
+ * The counter is the system counter as the PMU cycle counter belongs to
+ * normal world. The percentiles are computed from the first
+ * PTA_BENCH_MAX_SAMPLES operations. @rpcs counts the RPCs of the session,
+ * other invocations running concurrently in the same session are counted
+ * too. It's left out if memref[2] is too small for it, for clients built
+ * before it was added.
+ */
+struct pta_bench_result {
+	uint64_t ops;
+	uint64_t freq;
+	uint64_t ticks;
+	uint64_t ticks_per_op;
+	uint64_t ops_per_sec;
+	uint64_t min;
+	uint64_t p50;
+	uint64_t p90;
+	uint64_t p99;
+	uint64_t max;
+	uint64_t rpcs;
+};
+
+#define PTA_BENCH_MAX_SAMPLES			4096
+
 #endif /*__PTA_INVOKE_TESTS_H*/
 
@@ -182,4 +182,43 @@
  */
 #define PTA_SYSTEM_DLSYM                11
 
+/*
+ * Open several TA binaries
+ *
+ * Same as PTA_SYSTEM_OPEN_TA_BINARY for each UUID in memref[0], but done
+ * in a single invocation. Either all binaries are opened or none.
+ *
+ * [in]	    memref[0]:	Array of UUIDs of TA binaries, at most
+ *			PTA_SYSTEM_OPEN_TA_BINARIES_MAX
+ * [out]    memref[1]:	Array of uint32_t handles to the TA binaries, one
+ *			for each UUID
+ */
+#define PTA_SYSTEM_OPEN_TA_BINARIES	12
+#define PTA_SYSTEM_OPEN_TA_BINARIES_MAX	8
+
+/*
+ * Pin pages of the TA resident
+ *
+ * The pages covering the range are loaded if needed and stay mapped until
+ * unpinned, so the TA doesn't take pager faults when accessing them. Only
+ * supported with paged TAs. The number of pages a TA can pin is limited,
+ * TEE_ERROR_OUT_OF_MEMORY is returned if the range doesn't fit.
+ *
+ * [in]	    value[0].a: Number of bytes
+ * [in]     value[0].b:	Must be 0
+ * [in]	    value[1].a: Address upper 32-bits
+ * [in]	    value[1].b: Address lower 32-bits
+ */
+#define PTA_SYSTEM_PIN_RANGE		13
+
+/*
+ * Unpin pages pinned with PTA_SYSTEM_PIN_RANGE
+ *
+ * [in]	    value[0].a: Number of bytes
+ * [in]     value[0].b:	Must be 0
+ * [in]	    value[1].a: Address upper 32-bits
+ * [in]	    value[1].b: Address lower 32-bits
+ */
+#define PTA_SYSTEM_UNPIN_RANGE		14
+
 #endif /* __PTA_SYSTEM_H */
@@ -0,0 +1,195 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+#ifndef __PTA_TRACE_H
+#define __PTA_TRACE_H
+
+#include <stdint.h>
+#include <util.h>
+
+/*
+ * Interface to the trace pseudo TA, which controls the static tracepoints
+ * compiled into the core (CFG_CORE_TRACEPOINTS=y)
+ */
+
+#define PTA_TRACE_UUID { 0xf689321b, 0x46c5, 0x441a, { \
+			 0x83, 0x7a, 0xd8, 0x6e, 0x67, 0xd4, 0x8e, 0xc2 } }
+
+/* Categories of tracepoints, enabled at runtime with PTA_TRACE_START */
+#define PTA_TRACE_CAT_SMC	BIT32(0)	/* Standard call entry/exit */
+#define PTA_TRACE_CAT_RPC	BIT32(1)	/* RPC to normal world out/in */
+#define PTA_TRACE_CAT_PAGER	BIT32(2)	/* Pager page faults */
+#define PTA_TRACE_CAT_TA	BIT32(3)	/* User TA entry/exit */
+#define PTA_TRACE_CAT_SYSCALL	BIT32(4)	/* System call entry/exit */
+#define PTA_TRACE_CAT_STORAGE	BIT32(5)	/* REE FS requests */
+
+#define PTA_TRACE_EVENT_NAME_LEN	24
+
+/*
+ * struct pta_trace_event_desc - Description of a tracepoint
+ * @id:		Value of the @id field in records of this event
+ * @category:	One of PTA_TRACE_CAT_*
+ * @name:	Null terminated name of the event
+ */
+struct pta_trace_event_desc {
+	uint32_t id;
+	uint32_t category;
+	char name[PTA_TRACE_EVENT_NAME_LEN];
+};
+
+/*
+ * struct pta_trace_rec - A logged event
+ * @stamp:	Value of the generic timer counter (CNTPCT)
+ * @id:		Tracepoint, see struct pta_trace_event_desc
+ * @thread:	Core thread ID or 0xffff if logged outside of a thread
+ * @arg0:	First event specific argument
+ * @arg1:	Second event specific argument
+ */
+struct pta_trace_rec {
+	uint64_t stamp;
+	uint32_t id;
+	uint16_t thread;
+	uint16_t reserved;
+	uint64_t arg0;
+	uint64_t arg1;
+};
+
+/*
+ * struct pta_trace_ring - Ring of records of one CPU
+ * @head:	Number of records logged so far, the record logged last is
+ *		in @recs[(@head - 1) % num_recs]
+ * @recs:	Records, num_recs is given by struct pta_trace_buf
+ *
+ * Each ring is written by its CPU only, with @head updated after the
+ * record is written. Records are overwritten when the ring wraps, a
+ * reader checks that @head hasn't advanced by more than num_recs after
+ * copying records out.
+ */
+struct pta_trace_ring {
+	uint64_t head;
+	uint64_t reserved;
+	struct pta_trace_rec recs[];
+};
+
+/*
+ * struct pta_trace_buf - Header of the shared trace buffer
+ * @num_cpus:	Number of rings following the header
+ * @num_recs:	Number of records in each ring, a power of two
+ * @cntfrq:	Frequency of the counter used for @stamp in records
+ * @reserved:	Zero
+ *
+ * The rings follow the header, each of size
+ * sizeof(struct pta_trace_ring) + num_recs * sizeof(struct pta_trace_rec).
+ */
+struct pta_trace_buf {
+	uint32_t num_cpus;
+	uint32_t num_recs;
+	uint32_t cntfrq;
+	uint32_t reserved;
+};
+
+/*
+ * Get the tracepoints compiled into the core
+ *
+ * [out]    memref[0]: Array of struct pta_trace_event_desc
+ *
+ * Returns TEE_ERROR_SHORT_BUFFER with the required size in memref[0] if
+ * the supplied buffer is too small.
+ */
+#define PTA_TRACE_GET_EVENTS		0
+
+/*
+ * Enable tracepoints
+ *
+ * [in]     value[0].a: Mask of PTA_TRACE_CAT_* to enable
+ * [in]     value[0].b: Number of records in each ring, a power of two
+ * [out]    value[1].a: Upper 32 bits of the physical address of the buffer
+ * [out]    value[1].b: Lower 32 bits of the physical address of the buffer
+ * [out]    value[2].a: Size of the buffer
+ *
+ * The shared buffer, starting with struct pta_trace_buf, is allocated
+ * from normal world shared memory the first time tracepoints are enabled
+ * and kept afterwards, value[0].b is ignored once the buffer exists.
+ */
+#define PTA_TRACE_START			1
+
+/*
+ * Disable all tracepoints, the buffer is kept and can still be read
+ */
+#define PTA_TRACE_STOP			2
+
+/*
+ * Set the log level of the core at runtime
+ *
+ * [in]     value[0].a: New level, TRACE_MIN to TRACE_MAX, or
+ *			PTA_TRACE_LOG_LEVEL_KEEP to only read the level
+ * [out]    value[1].a: Previous level
+ *
+ * Messages above the level the core is compiled with, CFG_TEE_CORE_LOG_LEVEL,
+ * can't be enabled.
+ */
+#define PTA_TRACE_LOG_LEVEL		3
+
+#define PTA_TRACE_LOG_LEVEL_KEEP	UINT32_MAX
+
+/*
+ * struct pta_trace_log_hdr - Header of the binary log records of one CPU
+ * @cpu:	CPU which logged the records
+ * @len:	Number of bytes of records following the header
+ * @dropped:	Records dropped since boot because the ring was full
+ * @cntfrq:	Frequency of the counter used for @stamp in records
+ */
+struct pta_trace_log_hdr {
+	uint32_t cpu;
+	uint32_t len;
+	uint32_t dropped;
+	uint32_t cntfrq;
+};
+
+/*
+ * struct pta_trace_log_rec - Header of a binary log record
+ * @len:	Size of the record including this header, the next record
+ *		follows directly
+ * @level:	TRACE_INFO, TRACE_DEBUG or TRACE_FLOW
+ * @thread:	Core thread ID or 0xff if logged outside of a thread
+ * @line:	Line of the call site
+ * @stamp:	Value of the generic timer counter (CNTPCT)
+ * @fmt:	Address of the format string in tee.elf
+ * @func:	Address of the name of the calling function in tee.elf
+ *
+ * The arguments follow the header in the order of the conversions of
+ * the format string, each as:
+ * - a 64-bit value, sign extended for signed conversions, for integer
+ *   conversions, %p, %c and '*' widths and precisions
+ * - 16 bytes for %pUl
+ * - a 16-bit length followed by as many bytes, not null terminated, for
+ *   %s
+ * All values are little endian. Records are only padded to keep the
+ * following record 8 bytes aligned.
+ */
+struct pta_trace_log_rec {
+	uint16_t len;
+	uint8_t level;
+	uint8_t thread;
+	uint32_t line;
+	uint64_t stamp;
+	uint64_t fmt;
+	uint64_t func;
+};
+
+/*
+ * Read the binary log records of IMSG(), DMSG() and FMSG() messages
+ * (CFG_CORE_BINARY_TRACE=y), the format strings are left to
+ * scripts/decode_trace_log.py
+ *
+ * [out]    memref[0]: For each CPU a struct pta_trace_log_hdr followed
+ *			by its records
+ *
+ * The records returned are consumed, as many complete records as fit
+ * in memref[0] are returned. Returns TEE_ERROR_SHORT_BUFFER if not even
+ * the headers fit.
+ */
+#define PTA_TRACE_GET_LOG		4
+
+#endif /* __PTA_TRACE_H */
@@ -56,6 +56,32 @@
 #define TEE_ATTR_PBKDF2_ITERATION_COUNT     0xF00003C2
 #define TEE_ATTR_PBKDF2_DKM_LENGTH          0xF00004C2
 
+/*
+ * ChaCha20-Poly1305 authenticated encryption
+ * RFC 8439 section 2.8, 256-bit key, 96-bit nonce and 128-bit tag
+ */
+
+#define TEE_ALG_CHACHA20_POLY1305           0x40000AC3
+
+#define TEE_TYPE_CHACHA20                   0xA00000C3
+
+/*
+ * X25519 key agreement and Ed25519 signatures
+ * GP TEE Internal Core API v1.3, RFC 7748 and RFC 8032
+ */
+
+#define TEE_ALG_X25519                      0x80000044
+#define TEE_ALG_ED25519                     0x70006043
+
+#define TEE_TYPE_X25519_KEYPAIR             0xA1000044
+#define TEE_TYPE_ED25519_PUBLIC_KEY         0xA0000043
+#define TEE_TYPE_ED25519_KEYPAIR            0xA1000043
+
+#define TEE_ATTR_X25519_PUBLIC_VALUE        0xD0000944
+#define TEE_ATTR_X25519_PRIVATE_VALUE       0xC0000A44
+#define TEE_ATTR_ED25519_PUBLIC_VALUE       0xD0000743
+#define TEE_ATTR_ED25519_PRIVATE_VALUE      0xC0000843
+
 /*
  * PKCS#1 v1.5 RSASSA pre-hashed sign/verify
  */
@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <tee_api_defines_extensions.h>
 #include <tee_api_types.h>
+#include <utee_types.h>
 
 void tee_user_mem_mark_heap(void);
 size_t tee_user_mem_check_heap(void);
@@ -55,6 +56,156 @@ void *tee_map_zi(size_t len, uint32_t flags);
  */
 TEE_Result tee_unmap(void *buf, size_t len);
 
+/*
+ * tee_heap_trim() - Unmap heap memory which isn't used any longer
+ *
+ * With CFG_TA_HEAP_GROW=y the heap beyond CFG_TA_HEAP_GROW_INITIAL bytes
+ * is mapped in chunks as it's needed, this function unmaps the chunks
+ * which have no allocated buffers left. Does nothing otherwise.
+ */
+void tee_heap_trim(void);
+
+/*
+ * tee_ftrace_set_filter() - Restrict function tracing to an address range
+ * @start:	Start of the range
+ * @end:	End of the range (exclusive), NULL to trace all functions
+ *
+ * With CFG_TA_FTRACE_SUPPORT=y only the functions with an entry point in
+ * [@start, @end) are traced. Does nothing otherwise.
+ */
+#ifdef CFG_TA_FTRACE_SUPPORT
+void tee_ftrace_set_filter(const void *start, const void *end);
+#else
+static inline void tee_ftrace_set_filter(const void *start __unused,
+					 const void *end __unused)
+{
+}
+#endif
+
+/*
+ * One update in TEE_CryptoUpdateVec()
+ * @operation:	Cipher, digest or MAC operation
+ * @src:	Input data
+ * @srcLen:	Length of @src
+ * @dest:	Output of a cipher update, unused for digest and MAC
+ * @destLen:	Size of @dest on entry, length of output on return
+ */
+typedef struct {
+	TEE_OperationHandle operation;
+	const void *src;
+	uint32_t srcLen;
+	void *dest;
+	uint32_t destLen;
+} TEE_CryptoUpdate;
+
+/*
+ * TEE_CryptoUpdateVec() - Apply several updates at once
+ * @updates:	Updates to apply, in order
+ * @numUpdates:	Number of elements in @updates
+ *
+ * Each element is processed as by TEE_CipherUpdate(), TEE_DigestUpdate()
+ * or TEE_MACUpdate() depending on the class of its operation. Consecutive
+ * updates which don't depend on data buffered in the TA, that is digest
+ * and MAC updates and cipher updates of complete blocks with nothing
+ * buffered, are passed to the TEE core with a single system call.
+ *
+ * Return TEE_SUCCESS on success or TEE_ERROR_SHORT_BUFFER if the @destLen
+ * of a cipher update is too small, in which case that @destLen is updated
+ * with the required size and the following updates are not processed.
+ * Panics on other errors, as the functions above.
+ */
+TEE_Result TEE_CryptoUpdateVec(TEE_CryptoUpdate *updates,
+			       uint32_t numUpdates);
+
+/*
+ * TEE_ReadObjectDataAsync() - Start reading from a persistent object
+ * @object:	Persistent object opened with TEE_DATA_FLAG_ACCESS_READ
+ * @buffer:	Receives the data read, must stay valid until completion
+ * @size:	Number of bytes to read
+ *
+ * The read proceeds in the TEE core while the TA continues, it's
+ * completed with TEE_WaitObjectData(). Until then the data stream of
+ * @object may only be accessed with TEE_WaitObjectData().
+ *
+ * Returns TEE_SUCCESS or TEE_ERROR_OUT_OF_MEMORY, panics on other errors.
+ */
+TEE_Result TEE_ReadObjectDataAsync(TEE_ObjectHandle object, void *buffer,
+				   uint32_t size);
+
+/*
+ * TEE_WriteObjectDataAsync() - Start writing to a persistent object
+ * @object:	Persistent object opened with TEE_DATA_FLAG_ACCESS_WRITE
+ * @buffer:	Data to write, copied before the function returns
+ * @size:	Number of bytes to write
+ *
+ * As TEE_ReadObjectDataAsync(), returns TEE_SUCCESS,
+ * TEE_ERROR_OUT_OF_MEMORY or TEE_ERROR_OVERFLOW.
+ */
+TEE_Result TEE_WriteObjectDataAsync(TEE_ObjectHandle object,
+				    const void *buffer, uint32_t size);
+
+/*
+ * TEE_WaitObjectData() - Complete an asynchronous read or write
+ * @object:	Object with a read or write started
+ * @wait:	If false, return TEE_ERROR_BUSY if the request is not
+ *		completed yet
+ * @count:	Number of bytes read or written, or NULL
+ *
+ * On completion the data position is advanced as with
+ * TEE_ReadObjectData() or TEE_WriteObjectData() and the result of the
+ * request is returned, with the same error codes as these functions.
+ * A request which hasn't started when waited for is run in the calling
+ * thread.
+ */
+TEE_Result TEE_WaitObjectData(TEE_ObjectHandle object, bool wait,
+			      uint32_t *count);
+
+/*
+ * TEE_BeginPersistentObjectTransaction() - Start a storage transaction
+ * @storageID:	Storage as passed to TEE_CreatePersistentObject()
+ *
+ * Objects created, renamed or deleted in @storageID until
+ * TEE_CommitPersistentObjectTransaction() are committed together, with
+ * one update of the storage directory. A write to or a truncation of an
+ * opened object commits the changes made so far. A TA has at most one
+ * transaction, it's committed if the TA exits before it ends.
+ *
+ * Returns TEE_SUCCESS, TEE_ERROR_ITEM_NOT_FOUND if @storageID doesn't
+ * exist, TEE_ERROR_NOT_SUPPORTED if @storageID doesn't support
+ * transactions or TEE_ERROR_BAD_STATE if a transaction is already started.
+ */
+TEE_Result TEE_BeginPersistentObjectTransaction(uint32_t storageID);
+
+/*
+ * TEE_CommitPersistentObjectTransaction() - End a storage transaction
+ * @storageID:	Storage passed to TEE_BeginPersistentObjectTransaction()
+ *
+ * Returns TEE_SUCCESS, TEE_ERROR_BAD_STATE if there's no transaction
+ * for @storageID or the error of the commit, the changes are lost then.
+ */
+TEE_Result TEE_CommitPersistentObjectTransaction(uint32_t storageID);
+
+typedef struct utee_object_enum_entry TEE_ObjectEnumEntry;
+
+/*
+ * TEE_GetNextPersistentObjects() - Get the next objects of an enumeration
+ * @objectEnumerator:	Enumerator started with TEE_StartPersistentObjectEnumerator()
+ * @entries:		Array receiving the objects
+ * @count:		[in] Number of elements in @entries, [out] number of
+ *			objects returned
+ *
+ * Same as calling TEE_GetNextPersistentObject() up to @count times, with
+ * one system call. The result TEE_GetNextPersistentObject() would have
+ * returned for an object is in its entry, TEE_SUCCESS,
+ * TEE_ERROR_CORRUPT_OBJECT or TEE_ERROR_STORAGE_NOT_AVAILABLE.
+ *
+ * Returns TEE_SUCCESS if at least one object is returned, else
+ * TEE_ERROR_ITEM_NOT_FOUND at the end of the enumeration.
+ */
+TEE_Result TEE_GetNextPersistentObjects(TEE_ObjectEnumHandle objectEnumerator,
+					TEE_ObjectEnumEntry *entries,
+					uint32_t *count);
+
 /*
  * Convert a UUID string @s into a TEE_UUID @uuid
  * Expected format for @s is: xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx
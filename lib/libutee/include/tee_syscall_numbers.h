@@ -79,8 +79,14 @@
 #define TEE_SCN_SE_CHANNEL_CLOSE__DEPRECATED		69
 /* End of deprecated Secure Element API syscalls */
 #define TEE_SCN_CACHE_OPERATION			70
+#define TEE_SCN_CRYP_UPDATE_VEC			71
+#define TEE_SCN_HASH_INIT_FINAL			72
+#define TEE_SCN_STORAGE_OBJ_SUBMIT		73
+#define TEE_SCN_STORAGE_OBJ_WAIT		74
+#define TEE_SCN_STORAGE_TXN			75
+#define TEE_SCN_STORAGE_ENUM_NEXT_BATCH		76
 
-#define TEE_SCN_MAX				70
+#define TEE_SCN_MAX				76
 
 /* Maximum number of allowed arguments for a syscall */
 #define TEE_SVC_MAX_ARGS			8
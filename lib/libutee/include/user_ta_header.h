@@ -61,6 +61,23 @@ struct ftrace_buf {
 	uint32_t max_size;	/* Max allowed size of ftrace buffer */
 	uint32_t head_off;	/* Ftrace buffer header offset */
 	uint32_t buf_off;	/* Ftrace buffer offset */
+	uint64_t filter_start;	/* Only functions in [filter_start, */
+	uint64_t filter_end;	/* filter_end) are traced if filter_end != 0 */
+	uint64_t ts_offset;	/* Time suspended, subtracted from records */
+	uint32_t ring_head;	/* Next record written by the TA */
+	uint32_t ring_tail;	/* Next record drained by the core */
+	uint32_t ring_size;	/* Number of records in the ring */
+	uint32_t ring_lost;	/* Function entries not recorded */
+};
+
+/*
+ * With CFG_TA_FTRACE_STREAM=y the buffer at buf_off is a ring of records
+ * written by the TA and drained by the core while the TA runs. @pc is 0
+ * for a return from the last entered function.
+ */
+struct ftrace_rec {
+	uint64_t ts;
+	uint64_t pc;
 };
 
 /* Defined by the linker script */
@@ -91,6 +91,10 @@ TEE_Result utee_hash_update(unsigned long state, const void *chunk,
 			    size_t chunk_size);
 TEE_Result utee_hash_final(unsigned long state, const void *chunk,
 			   size_t chunk_size, void *hash, uint64_t *hash_len);
+/* Same as utee_hash_init() with no IV followed by utee_hash_final() */
+TEE_Result utee_hash_init_final(unsigned long state, const void *chunk,
+				size_t chunk_size, void *hash,
+				uint64_t *hash_len);
 
 TEE_Result utee_cipher_init(unsigned long state, const void *iv, size_t iv_len);
 TEE_Result utee_cipher_update(unsigned long state, const void *src,
@@ -98,6 +102,13 @@ TEE_Result utee_cipher_update(unsigned long state, const void *src,
 TEE_Result utee_cipher_final(unsigned long state, const void *src,
 			size_t src_len, void *dest, uint64_t *dest_len);
 
+/*
+ * Applies @num_updates cipher, digest or MAC updates in order, stops at
+ * the first one that fails and returns its result.
+ */
+TEE_Result utee_cryp_update_vec(struct utee_cryp_update *updates,
+			size_t num_updates);
+
 /* Generic Object Functions */
 TEE_Result utee_cryp_obj_get_info(unsigned long obj, TEE_ObjectInfo *info);
 TEE_Result utee_cryp_obj_restrict_usage(unsigned long obj, unsigned long usage);
@@ -209,6 +220,21 @@ TEE_Result utee_storage_obj_trunc(unsigned long obj, size_t len);
 TEE_Result utee_storage_obj_seek(unsigned long obj, int32_t offset,
 				 unsigned long whence);
 
+/* obj is of type TEE_ObjectHandle */
+TEE_Result utee_storage_obj_submit(unsigned long obj, unsigned long write,
+				   const void *data, size_t len);
+
+/* obj is of type TEE_ObjectHandle */
+TEE_Result utee_storage_obj_wait(unsigned long obj, unsigned long wait,
+				 uint64_t *count);
+
+TEE_Result utee_storage_txn(unsigned long storage_id, unsigned long begin);
+
+/* obj_enum is of type TEE_ObjectEnumHandle */
+TEE_Result utee_storage_next_enum_batch(unsigned long obj_enum,
+					struct utee_object_enum_entry *entries,
+					size_t num_entries, uint64_t *count);
+
 /* seServiceHandle is of type TEE_SEServiceHandle */
 TEE_Result utee_se_service_open(uint32_t *seServiceHandle);
 
@@ -8,6 +8,7 @@
 
 #include <inttypes.h>
 #include <tee_api_defines.h>
+#include <tee_api_types.h>
 
 enum utee_time_category {
 	UTEE_TIME_CAT_SYSTEM = 0,
@@ -47,4 +48,32 @@ struct utee_attribute {
 	uint32_t attribute_id;
 };
 
+/*
+ * One update in utee_cryp_update_vec(), pointers and lengths are 64-bit
+ * to have the same layout for 32-bit and 64-bit TAs.
+ */
+struct utee_cryp_update {
+	uint64_t src;
+	uint64_t src_len;
+	uint64_t dst;		/* 0 for digest and MAC operations */
+	uint64_t dst_len;	/* in: size of dst, out: length of output */
+	uint32_t state;
+	uint32_t res;		/* out: result of the update */
+};
+
+/*
+ * One object returned by utee_storage_next_enum_batch(), the layout is
+ * the same for 32-bit and 64-bit TAs.
+ * @info:	info of the object, valid if @res is TEE_SUCCESS
+ * @res:	result of reading the object, as utee_storage_next_enum()
+ *		would have returned for it
+ * @obj_id_len:	length of @obj_id, 0 if the object ID is invalid
+ */
+struct utee_object_enum_entry {
+	TEE_ObjectInfo info;
+	uint32_t res;
+	uint32_t obj_id_len;
+	uint8_t obj_id[TEE_OBJECT_ID_MAX_LEN];
+};
+
 #endif /* UTEE_TYPES_H */
@@ -11,6 +11,7 @@
 #include <user_ta_header.h>
 #include <utee_syscalls.h>
 #include "tee_api_private.h"
+#include "utee_misc.h"
 
 static const void *tee_api_instance_data;
 
@@ -317,8 +318,12 @@ void *TEE_MemFill(void *buff, uint32_t x, uint32_t size)
 
 void TEE_GetSystemTime(TEE_Time *time)
 {
-	TEE_Result res = utee_get_time(UTEE_TIME_CAT_SYSTEM, time);
+	TEE_Result res = TEE_ERROR_GENERIC;
 
+	if (utee_get_fast_sys_time(time))
+		return;
+
+	res = utee_get_time(UTEE_TIME_CAT_SYSTEM, time);
 	if (res != TEE_SUCCESS)
 		TEE_Panic(res);
 }
@@ -460,6 +460,66 @@ void TEE_BigIntInvMod(TEE_BigInt *dest, const TEE_BigInt *op,
 	mpa_inv_mod(mpa_dest, mpa_op, mpa_n, mempool);
 }
 
+/*
+ * TEE_BigIntExpMod
+ */
+TEE_Result TEE_BigIntExpMod(TEE_BigInt *dest, const TEE_BigInt *op1,
+			    const TEE_BigInt *op2, const TEE_BigInt *n,
+			    const TEE_BigIntFMMContext *context)
+{
+	mpanum mpa_dest = (mpa_num_base *)dest;
+	mpanum mpa_op1 = (mpa_num_base *)op1;
+	mpanum mpa_op2 = (mpa_num_base *)op2;
+	mpanum mpa_n = (mpa_num_base *)n;
+	mpa_fmm_context mpa_context = (mpa_fmm_context_base *)context;
+	mpanum r_modn = NULL;
+	mpanum r2_modn = NULL;
+	mpa_word_t n_inv = 0;
+	mpanum base = NULL;
+	mpanum tmp_dest = NULL;
+
+	if (TEE_BigIntCmpS32(n, 2) < 0)
+		TEE_BigInt_Panic("Modulus is too short");
+	if (mpa_is_even(mpa_n))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	/*
+	 * The Montgomery constants are only computed when the caller
+	 * doesn't supply them with a context initialized by
+	 * TEE_BigIntInitFMMContext() for the same modulus.
+	 */
+	if (mpa_context) {
+		r_modn = mpa_context->r_ptr;
+		r2_modn = mpa_context->r2_ptr;
+		n_inv = mpa_context->n_inv;
+	} else {
+		mpa_alloc_static_temp_var(&r_modn, mempool);
+		mpa_alloc_static_temp_var(&r2_modn, mempool);
+		mpa_compute_fmm_context(mpa_n, r_modn, r2_modn, &n_inv,
+					mempool);
+	}
+
+	/* Montgomery multiplication expects the base to be reduced */
+	mpa_alloc_static_temp_var(&base, mempool);
+	mpa_alloc_static_temp_var(&tmp_dest, mempool);
+	mpa_mod(base, mpa_op1, mpa_n, mempool);
+	if (mpa_cmp_short(base, 0) < 0)
+		mpa_add(base, base, mpa_n, mempool);
+
+	mpa_exp_mod(tmp_dest, base, mpa_op2, mpa_n, r_modn, r2_modn, n_inv,
+		    mempool);
+	mpa_copy(mpa_dest, tmp_dest);
+
+	mpa_free_static_temp_var(&tmp_dest, mempool);
+	mpa_free_static_temp_var(&base, mempool);
+	if (!mpa_context) {
+		mpa_free_static_temp_var(&r2_modn, mempool);
+		mpa_free_static_temp_var(&r_modn, mempool);
+	}
+
+	return TEE_SUCCESS;
+}
+
 /*************************************************************
  * OTHER ARITHMETIC OPERATIONS
  *************************************************************/
@@ -557,6 +557,44 @@ void TEE_BigIntInvMod(TEE_BigInt *dest, const TEE_BigInt *op,
 		mbedtls_mpi_free(&mpi_op);
 }
 
+TEE_Result TEE_BigIntExpMod(TEE_BigInt *dest, const TEE_BigInt *op1,
+			    const TEE_BigInt *op2, const TEE_BigInt *n,
+			    const TEE_BigIntFMMContext *context __unused)
+{
+	mbedtls_mpi mpi_dest;
+	mbedtls_mpi mpi_op1;
+	mbedtls_mpi mpi_op2;
+	mbedtls_mpi mpi_n;
+
+	if (TEE_BigIntCmpS32(n, 2) < 0)
+		API_PANIC("Modulus is too short");
+
+	get_mpi(&mpi_n, n);
+	if (!mbedtls_mpi_get_bit(&mpi_n, 0)) {
+		mbedtls_mpi_free(&mpi_n);
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+
+	/*
+	 * mbedtls_mpi_exp_mod() uses the result as accumulator while the
+	 * exponent is still read, so the result is never aliased.
+	 */
+	get_mpi(&mpi_dest, NULL);
+	get_mpi(&mpi_op1, op1);
+	get_mpi(&mpi_op2, op2);
+
+	MPI_CHECK(mbedtls_mpi_exp_mod(&mpi_dest, &mpi_op1, &mpi_op2, &mpi_n,
+				      NULL));
+
+	MPI_CHECK(copy_mpi_to_bigint(&mpi_dest, dest));
+	mbedtls_mpi_free(&mpi_dest);
+	mbedtls_mpi_free(&mpi_op1);
+	mbedtls_mpi_free(&mpi_op2);
+	mbedtls_mpi_free(&mpi_n);
+
+	return TEE_SUCCESS;
+}
+
 bool TEE_BigIntRelativePrime(const TEE_BigInt *op1, const TEE_BigInt *op2)
 {
 	bool rc;
@@ -6,6 +6,7 @@
 #include <string.h>
 
 #include <tee_api.h>
+#include <tee_internal_api_extensions.h>
 #include <utee_syscalls.h>
 #include "tee_api_private.h"
 
@@ -261,21 +262,13 @@ TEE_Result TEE_PopulateTransientObject(TEE_ObjectHandle object,
 				       uint32_t attrCount)
 {
 	TEE_Result res;
-	TEE_ObjectInfo info;
 	struct utee_attribute ua[attrCount];
 
-	res = utee_cryp_obj_get_info((unsigned long)object, &info);
-	if (res != TEE_SUCCESS)
-		TEE_Panic(res);
-
-	/* Must be a transient object */
-	if ((info.handleFlags & TEE_HANDLE_FLAG_PERSISTENT) != 0)
-		TEE_Panic(0);
-
-	/* Must not be initialized already */
-	if ((info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) != 0)
-		TEE_Panic(0);
-
+	/*
+	 * The TEE Core checks that the object is a transient object which
+	 * isn't initialized already, any other error than
+	 * TEE_ERROR_BAD_PARAMETERS is a panic.
+	 */
 	__utee_from_attr(ua, attrs, attrCount);
 	res = utee_cryp_obj_populate((unsigned long)object, ua, attrCount);
 	if (res != TEE_SUCCESS && res != TEE_ERROR_BAD_PARAMETERS)
@@ -332,30 +325,14 @@ TEE_Result TEE_CopyObjectAttributes1(TEE_ObjectHandle destObject,
 			      TEE_ObjectHandle srcObject)
 {
 	TEE_Result res;
-	TEE_ObjectInfo dst_info;
-	TEE_ObjectInfo src_info;
-
-	res = utee_cryp_obj_get_info((unsigned long)destObject, &dst_info);
-	if (res != TEE_SUCCESS)
-		goto exit;
-
-	res = utee_cryp_obj_get_info((unsigned long)srcObject, &src_info);
-	if (res != TEE_SUCCESS)
-		goto exit;
-
-	if (!(src_info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED))
-		TEE_Panic(0);
-
-	if ((dst_info.handleFlags & TEE_HANDLE_FLAG_PERSISTENT))
-		TEE_Panic(0);
-
-	if ((dst_info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED))
-		TEE_Panic(0);
 
+	/*
+	 * The TEE Core checks that the source object is initialized and
+	 * that the destination is a transient object which isn't
+	 * initialized already, a failed check is a panic.
+	 */
 	res = utee_cryp_obj_copy((unsigned long)destObject,
 				 (unsigned long)srcObject);
-
-exit:
 	if (res != TEE_SUCCESS &&
 	    res != TEE_ERROR_CORRUPT_OBJECT &&
 	    res != TEE_ERROR_STORAGE_NOT_AVAILABLE)
@@ -636,6 +613,42 @@ out:
 	return res;
 }
 
+TEE_Result TEE_GetNextPersistentObjects(TEE_ObjectEnumHandle objectEnumerator,
+					TEE_ObjectEnumEntry *entries,
+					uint32_t *count)
+{
+	TEE_Result res;
+	uint64_t cnt = 0;
+	uint32_t n = 0;
+
+	if (!entries || !count || !*count) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	res = utee_storage_next_enum_batch((unsigned long)objectEnumerator,
+					   entries, *count, &cnt);
+	if (res == TEE_SUCCESS) {
+		*count = cnt;
+		for (n = 0; n < cnt; n++)
+			if (entries[n].res != TEE_SUCCESS &&
+			    entries[n].res != TEE_ERROR_CORRUPT_OBJECT &&
+			    entries[n].res != TEE_ERROR_STORAGE_NOT_AVAILABLE)
+				TEE_Panic(entries[n].res);
+	} else {
+		*count = 0;
+	}
+
+out:
+	if (res != TEE_SUCCESS &&
+	    res != TEE_ERROR_ITEM_NOT_FOUND &&
+	    res != TEE_ERROR_CORRUPT_OBJECT &&
+	    res != TEE_ERROR_STORAGE_NOT_AVAILABLE)
+		TEE_Panic(res);
+
+	return res;
+}
+
 /* Data and Key Storage API  - Data Stream Access Functions */
 
 TEE_Result TEE_ReadObjectData(TEE_ObjectHandle object, void *buffer,
@@ -691,6 +704,112 @@ out:
 	return res;
 }
 
+TEE_Result TEE_ReadObjectDataAsync(TEE_ObjectHandle object, void *buffer,
+				   uint32_t size)
+{
+	TEE_Result res;
+
+	if (object == TEE_HANDLE_NULL) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	res = utee_storage_obj_submit((unsigned long)object, false, buffer,
+				      size);
+
+out:
+	if (res != TEE_SUCCESS &&
+	    res != TEE_ERROR_OUT_OF_MEMORY)
+		TEE_Panic(res);
+
+	return res;
+}
+
+TEE_Result TEE_WriteObjectDataAsync(TEE_ObjectHandle object,
+				    const void *buffer, uint32_t size)
+{
+	TEE_Result res;
+
+	if (object == TEE_HANDLE_NULL) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	if (size > TEE_DATA_MAX_POSITION) {
+		res = TEE_ERROR_OVERFLOW;
+		goto out;
+	}
+
+	res = utee_storage_obj_submit((unsigned long)object, true, buffer,
+				      size);
+
+out:
+	if (res != TEE_SUCCESS &&
+	    res != TEE_ERROR_OUT_OF_MEMORY &&
+	    res != TEE_ERROR_OVERFLOW)
+		TEE_Panic(res);
+
+	return res;
+}
+
+TEE_Result TEE_WaitObjectData(TEE_ObjectHandle object, bool wait,
+			      uint32_t *count)
+{
+	TEE_Result res;
+	uint64_t cnt64 = 0;
+
+	if (object == TEE_HANDLE_NULL) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	res = utee_storage_obj_wait((unsigned long)object, wait, &cnt64);
+	if (count)
+		*count = cnt64;
+
+out:
+	if (res != TEE_SUCCESS &&
+	    res != TEE_ERROR_BUSY &&
+	    res != TEE_ERROR_STORAGE_NO_SPACE &&
+	    res != TEE_ERROR_CORRUPT_OBJECT &&
+	    res != TEE_ERROR_STORAGE_NOT_AVAILABLE)
+		TEE_Panic(res);
+
+	return res;
+}
+
+TEE_Result TEE_BeginPersistentObjectTransaction(uint32_t storageID)
+{
+	TEE_Result res = utee_storage_txn(storageID, true);
+
+	if (res != TEE_SUCCESS &&
+	    res != TEE_ERROR_ITEM_NOT_FOUND &&
+	    res != TEE_ERROR_NOT_SUPPORTED &&
+	    res != TEE_ERROR_BAD_STATE &&
+	    res != TEE_ERROR_OUT_OF_MEMORY &&
+	    res != TEE_ERROR_CORRUPT_OBJECT &&
+	    res != TEE_ERROR_STORAGE_NOT_AVAILABLE)
+		TEE_Panic(res);
+
+	return res;
+}
+
+TEE_Result TEE_CommitPersistentObjectTransaction(uint32_t storageID)
+{
+	TEE_Result res = utee_storage_txn(storageID, false);
+
+	if (res != TEE_SUCCESS &&
+	    res != TEE_ERROR_ITEM_NOT_FOUND &&
+	    res != TEE_ERROR_BAD_STATE &&
+	    res != TEE_ERROR_OUT_OF_MEMORY &&
+	    res != TEE_ERROR_STORAGE_NO_SPACE &&
+	    res != TEE_ERROR_CORRUPT_OBJECT &&
+	    res != TEE_ERROR_STORAGE_NOT_AVAILABLE)
+		TEE_Panic(res);
+
+	return res;
+}
+
 TEE_Result TEE_TruncateObjectData(TEE_ObjectHandle object, uint32_t size)
 {
 	TEE_Result res;
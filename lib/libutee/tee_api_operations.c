@@ -23,6 +23,7 @@ struct __TEE_OperationHandle {
 	bool buffer_two_blocks;	/* True if two blocks need to be buffered */
 	size_t block_size;	/* Block size of cipher */
 	size_t buffer_offs;	/* Offset in buffer */
+	bool hash_init_pending;	/* True if state is to be initialized */
 	uint32_t state;		/* Handle to state in TEE Core */
 	uint32_t ae_tag_len;	/*
 				 * tag_len in bytes for AE operation else unused
@@ -100,6 +101,13 @@ TEE_Result TEE_AllocateOperation(TEE_OperationHandle *operation,
 			return TEE_ERROR_NOT_SUPPORTED;
 		break;
 
+	case TEE_ALG_CHACHA20_POLY1305:
+	case TEE_ALG_X25519:
+	case TEE_ALG_ED25519:
+		if (maxKeySize != 256)
+			return TEE_ERROR_NOT_SUPPORTED;
+		break;
+
 	default:
 		break;
 	}
@@ -124,6 +132,7 @@ TEE_Result TEE_AllocateOperation(TEE_OperationHandle *operation,
 		/* FALLTHROUGH */
 	case TEE_ALG_AES_CTR:
 	case TEE_ALG_AES_GCM:
+	case TEE_ALG_CHACHA20_POLY1305:
 		if (mode == TEE_MODE_ENCRYPT)
 			req_key_usage = TEE_USAGE_ENCRYPT;
 		else if (mode == TEE_MODE_DECRYPT)
@@ -154,6 +163,7 @@ TEE_Result TEE_AllocateOperation(TEE_OperationHandle *operation,
 	case TEE_ALG_ECDSA_P256:
 	case TEE_ALG_ECDSA_P384:
 	case TEE_ALG_ECDSA_P521:
+	case TEE_ALG_ED25519:
 		if (mode == TEE_MODE_SIGN) {
 			with_private_key = true;
 			req_key_usage = TEE_USAGE_SIGN;
@@ -197,6 +207,7 @@ TEE_Result TEE_AllocateOperation(TEE_OperationHandle *operation,
 	case TEE_ALG_ECDH_P256:
 	case TEE_ALG_ECDH_P384:
 	case TEE_ALG_ECDH_P521:
+	case TEE_ALG_X25519:
 	case TEE_ALG_HKDF_MD5_DERIVE_KEY:
 	case TEE_ALG_HKDF_SHA1_DERIVE_KEY:
 	case TEE_ALG_HKDF_SHA224_DERIVE_KEY:
@@ -477,8 +488,6 @@ out:
 
 void TEE_ResetOperation(TEE_OperationHandle operation)
 {
-	TEE_Result res;
-
 	if (operation == TEE_HANDLE_NULL)
 		TEE_Panic(0);
 
@@ -488,11 +497,11 @@ void TEE_ResetOperation(TEE_OperationHandle operation)
 	operation->operationState = TEE_OPERATION_STATE_INITIAL;
 
 	if (operation->info.operationClass == TEE_OPERATION_DIGEST) {
-		res = utee_hash_init(operation->state, NULL, 0);
-		if (res != TEE_SUCCESS)
-			TEE_Panic(res);
+		/* Initialized with the next update or final */
+		operation->hash_init_pending = true;
 		operation->info.handleState |= TEE_HANDLE_FLAG_INITIALIZED;
 	} else {
+		operation->hash_init_pending = false;
 		operation->info.handleState &= ~TEE_HANDLE_FLAG_INITIALIZED;
 	}
 }
@@ -739,6 +748,7 @@ void TEE_CopyOperation(TEE_OperationHandle dst_op, TEE_OperationHandle src_op)
 	} else if (src_op->buffer != NULL) {
 		TEE_Panic(0);
 	}
+	dst_op->hash_init_pending = src_op->hash_init_pending;
 
 	res = utee_cryp_state_copy(dst_op->state, src_op->state);
 	if (res != TEE_SUCCESS)
@@ -760,9 +770,47 @@ static void init_hash_operation(TEE_OperationHandle operation, const void *IV,
 	if (res != TEE_SUCCESS)
 		TEE_Panic(res);
 	operation->buffer_offs = 0;
+	operation->hash_init_pending = false;
 	operation->info.handleState |= TEE_HANDLE_FLAG_INITIALIZED;
 }
 
+/*
+ * A digest or MAC operation which is only initialized and finalized in
+ * one go is done with a single call to utee_hash_init_final(), the
+ * initialization is deferred until then. Updates need it done first.
+ */
+static void defer_init_hash_operation(TEE_OperationHandle operation)
+{
+	operation->buffer_offs = 0;
+	operation->hash_init_pending = true;
+	operation->info.handleState |= TEE_HANDLE_FLAG_INITIALIZED;
+}
+
+static void flush_init_hash_operation(TEE_OperationHandle operation)
+{
+	if (operation->hash_init_pending)
+		init_hash_operation(operation, NULL, 0);
+}
+
+static TEE_Result hash_final(TEE_OperationHandle operation, const void *chunk,
+			     uint32_t chunk_len, void *hash, uint32_t *hash_len)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	uint64_t hl = *hash_len;
+
+	if (operation->hash_init_pending) {
+		res = utee_hash_init_final(operation->state, chunk, chunk_len,
+					   hash, &hl);
+		operation->hash_init_pending = false;
+	} else {
+		res = utee_hash_final(operation->state, chunk, chunk_len,
+				      hash, &hl);
+	}
+	*hash_len = hl;
+
+	return res;
+}
+
 void TEE_DigestUpdate(TEE_OperationHandle operation,
 		      const void *chunk, uint32_t chunkSize)
 {
@@ -774,6 +822,7 @@ void TEE_DigestUpdate(TEE_OperationHandle operation,
 
 	operation->operationState = TEE_OPERATION_STATE_ACTIVE;
 
+	flush_init_hash_operation(operation);
 	res = utee_hash_update(operation->state, chunk, chunkSize);
 	if (res != TEE_SUCCESS)
 		TEE_Panic(res);
@@ -783,7 +832,6 @@ TEE_Result TEE_DigestDoFinal(TEE_OperationHandle operation, const void *chunk,
 			     uint32_t chunkLen, void *hash, uint32_t *hashLen)
 {
 	TEE_Result res;
-	uint64_t hl;
 
 	if ((operation == TEE_HANDLE_NULL) ||
 	    (!chunk && chunkLen) ||
@@ -794,14 +842,12 @@ TEE_Result TEE_DigestDoFinal(TEE_OperationHandle operation, const void *chunk,
 		goto out;
 	}
 
-	hl = *hashLen;
-	res = utee_hash_final(operation->state, chunk, chunkLen, hash, &hl);
-	*hashLen = hl;
+	res = hash_final(operation, chunk, chunkLen, hash, hashLen);
 	if (res != TEE_SUCCESS)
 		goto out;
 
 	/* Reset operation state */
-	init_hash_operation(operation, NULL, 0);
+	defer_init_hash_operation(operation);
 
 	operation->operationState = TEE_OPERATION_STATE_INITIAL;
 
@@ -1024,6 +1070,116 @@ out:
 	return res;
 }
 
+/* Number of updates passed at a time to utee_cryp_update_vec() */
+#define CRYPTO_UPDATE_VEC_BATCH	16
+
+/*
+ * Returns true if @u can be passed directly to the TEE core, panics if
+ * it's invalid in a way that TEE_CipherUpdate() wouldn't return.
+ */
+static bool can_batch_update(TEE_CryptoUpdate *u)
+{
+	TEE_OperationHandle op = u->operation;
+
+	if (op == TEE_HANDLE_NULL || (!u->src && u->srcLen))
+		TEE_Panic(0);
+
+	switch (op->info.operationClass) {
+	case TEE_OPERATION_DIGEST:
+		return true;
+	case TEE_OPERATION_MAC:
+		if (!(op->info.handleState & TEE_HANDLE_FLAG_INITIALIZED) ||
+		    op->operationState != TEE_OPERATION_STATE_ACTIVE)
+			TEE_Panic(0);
+		return true;
+	case TEE_OPERATION_CIPHER:
+		/* Leave everything else to TEE_CipherUpdate() */
+		return (op->info.handleState & TEE_HANDLE_FLAG_INITIALIZED) &&
+		       op->operationState == TEE_OPERATION_STATE_ACTIVE &&
+		       !op->buffer_two_blocks && !op->buffer_offs &&
+		       !(u->srcLen % op->block_size) &&
+		       u->destLen >= u->srcLen;
+	default:
+		TEE_Panic(0);
+		return false;
+	}
+}
+
+static void flush_updates(struct utee_cryp_update *cu, TEE_CryptoUpdate **u,
+			  size_t num)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	if (!num)
+		return;
+
+	res = utee_cryp_update_vec(cu, num);
+	if (res != TEE_SUCCESS)
+		TEE_Panic(res);
+
+	for (n = 0; n < num; n++) {
+		if (u[n]->operation->info.operationClass ==
+		    TEE_OPERATION_CIPHER)
+			u[n]->destLen = cu[n].dst_len;
+	}
+}
+
+TEE_Result TEE_CryptoUpdateVec(TEE_CryptoUpdate *updates,
+			       uint32_t numUpdates)
+{
+	struct utee_cryp_update cu[CRYPTO_UPDATE_VEC_BATCH] = { };
+	TEE_CryptoUpdate *u[CRYPTO_UPDATE_VEC_BATCH] = { };
+	TEE_OperationHandle op = TEE_HANDLE_NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t num = 0;
+	size_t n = 0;
+
+	if (!updates && numUpdates)
+		TEE_Panic(0);
+
+	for (n = 0; n < numUpdates; n++) {
+		op = updates[n].operation;
+
+		if (!can_batch_update(updates + n)) {
+			flush_updates(cu, u, num);
+			num = 0;
+			res = TEE_CipherUpdate(op, updates[n].src,
+					       updates[n].srcLen,
+					       updates[n].dest,
+					       &updates[n].destLen);
+			if (res != TEE_SUCCESS)
+				return res;
+			continue;
+		}
+
+		if (op->info.operationClass == TEE_OPERATION_DIGEST)
+			op->operationState = TEE_OPERATION_STATE_ACTIVE;
+		if (op->info.operationClass != TEE_OPERATION_CIPHER)
+			flush_init_hash_operation(op);
+
+		cu[num] = (struct utee_cryp_update){
+			.src = (vaddr_t)updates[n].src,
+			.src_len = updates[n].srcLen,
+			.state = op->state,
+		};
+		if (op->info.operationClass == TEE_OPERATION_CIPHER) {
+			cu[num].dst = (vaddr_t)updates[n].dest;
+			cu[num].dst_len = updates[n].destLen;
+		}
+		u[num] = updates + n;
+		num++;
+
+		if (num == CRYPTO_UPDATE_VEC_BATCH) {
+			flush_updates(cu, u, num);
+			num = 0;
+		}
+	}
+
+	flush_updates(cu, u, num);
+	return TEE_SUCCESS;
+}
+
 TEE_Result TEE_CipherDoFinal(TEE_OperationHandle operation,
 			     const void *srcData, uint32_t srcLen,
 			     void *destData, uint32_t *destLen)
@@ -1091,7 +1247,8 @@ TEE_Result TEE_CipherDoFinal(TEE_OperationHandle operation,
 	}
 
 	tmp_dlen = *destLen - acc_dlen;
-	if (operation->block_size > 1) {
+	if (operation->block_size > 1 &&
+	    (operation->buffer_offs || operation->buffer_two_blocks)) {
 		res = tee_buffer_update(operation, utee_cipher_update,
 					srcData, srcLen, dst, &tmp_dlen);
 		if (res != TEE_SUCCESS)
@@ -1104,6 +1261,10 @@ TEE_Result TEE_CipherDoFinal(TEE_OperationHandle operation,
 		res = utee_cipher_final(operation->state, operation->buffer,
 					operation->buffer_offs, dst, &tmp_dlen);
 	} else {
+		/*
+		 * Nothing buffered, the TEE Core can process all the data
+		 * at once.
+		 */
 		res = utee_cipher_final(operation->state, srcData,
 					srcLen, dst, &tmp_dlen);
 	}
@@ -1127,7 +1288,8 @@ out:
 
 /* Cryptographic Operations API - MAC Functions */
 
-void TEE_MACInit(TEE_OperationHandle operation, const void *IV, uint32_t IVLen)
+void TEE_MACInit(TEE_OperationHandle operation, const void *IV __unused,
+		 uint32_t IVLen __unused)
 {
 	if (operation == TEE_HANDLE_NULL)
 		TEE_Panic(0);
@@ -1144,7 +1306,8 @@ void TEE_MACInit(TEE_OperationHandle operation, const void *IV, uint32_t IVLen)
 
 	operation->operationState = TEE_OPERATION_STATE_ACTIVE;
 
-	init_hash_operation(operation, IV, IVLen);
+	/* IV is ignored, see init_hash_operation() */
+	defer_init_hash_operation(operation);
 }
 
 void TEE_MACUpdate(TEE_OperationHandle operation, const void *chunk,
@@ -1164,6 +1327,7 @@ void TEE_MACUpdate(TEE_OperationHandle operation, const void *chunk,
 	if (operation->operationState != TEE_OPERATION_STATE_ACTIVE)
 		TEE_Panic(0);
 
+	flush_init_hash_operation(operation);
 	res = utee_hash_update(operation->state, chunk, chunkSize);
 	if (res != TEE_SUCCESS)
 		TEE_Panic(res);
@@ -1174,7 +1338,6 @@ TEE_Result TEE_MACComputeFinal(TEE_OperationHandle operation,
 			       void *mac, uint32_t *macLen)
 {
 	TEE_Result res;
-	uint64_t ml;
 
 	if (operation == TEE_HANDLE_NULL ||
 	    (message == NULL && messageLen != 0) ||
@@ -1199,9 +1362,7 @@ TEE_Result TEE_MACComputeFinal(TEE_OperationHandle operation,
 		goto out;
 	}
 
-	ml = *macLen;
-	res = utee_hash_final(operation->state, message, messageLen, mac, &ml);
-	*macLen = ml;
+	res = hash_final(operation, message, messageLen, mac, macLen);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -1304,6 +1465,13 @@ TEE_Result TEE_AEInit(TEE_OperationHandle operation, const void *nonce,
 		}
 	}
 
+	/* RFC 8439 only defines the full 128-bit Poly1305 tag */
+	if (operation->info.algorithm == TEE_ALG_CHACHA20_POLY1305 &&
+	    tagLen != 128) {
+		res = TEE_ERROR_NOT_SUPPORTED;
+		goto out;
+	}
+
 	res = utee_authenc_init(operation->state, nonce, nonceLen,
 				tagLen / 8, AADLen, payloadLen);
 	if (res != TEE_SUCCESS)
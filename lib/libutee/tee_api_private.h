@@ -15,6 +15,11 @@ void __utee_from_attr(struct utee_attribute *ua, const TEE_Attribute *attrs,
 TEE_Result __utee_entry(unsigned long func, unsigned long session_id,
 			struct utee_params *up, unsigned long cmd_id);
 
+/* Selects the session the cached client properties are looked up for */
+void __utee_prop_cache_set_session(uint32_t session_id);
+/* Drops the cached client properties of a closed session */
+void __utee_prop_cache_remove_session(uint32_t session_id);
+
 
 #if defined(CFG_TA_GPROF_SUPPORT)
 void __utee_gprof_init(void);
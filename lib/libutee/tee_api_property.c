@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/queue.h>
 #include <tee_api_defines.h>
 #include <tee_api.h>
 #include <tee_api_types.h>
@@ -19,6 +20,7 @@
 
 #include "string_ext.h"
 #include "base64.h"
+#include "tee_api_private.h"
 
 #define PROP_STR_MAX    80
 
@@ -29,6 +31,26 @@ struct prop_enumerator {
 	TEE_PropSetHandle prop_set;	/* part of TEE_PROPSET_xxx */
 };
 
+/*
+ * Properties supplied by the TEE Core don't change during the lifetime of
+ * the TA instance, except for the client properties which are fixed for
+ * a session only. They're cached on the first lookup by name, the client
+ * properties along with the session they belong to.
+ */
+struct prop_cache_entry {
+	TEE_PropSetHandle prop_set;
+	uint32_t session_id;
+	enum user_ta_prop_type type;
+	uint32_t len;
+	char *name;
+	SLIST_ENTRY(prop_cache_entry) link;
+	uint8_t value[];
+};
+
+static SLIST_HEAD(prop_cache_head, prop_cache_entry) prop_cache =
+	SLIST_HEAD_INITIALIZER(prop_cache);
+static uint32_t prop_cache_session_id;
+
 const struct user_ta_property tee_props[] = {
 	{
 		"gpd.tee.arith.maxBigIntSize",
@@ -123,6 +145,93 @@ static TEE_Result propget_get_ext_prop(const struct user_ta_property *ep,
 	return TEE_SUCCESS;
 }
 
+void __utee_prop_cache_set_session(uint32_t session_id)
+{
+	prop_cache_session_id = session_id;
+}
+
+void __utee_prop_cache_remove_session(uint32_t session_id)
+{
+	struct prop_cache_entry *pce = SLIST_FIRST(&prop_cache);
+	struct prop_cache_entry *prev = NULL;
+	struct prop_cache_entry *next = NULL;
+
+	while (pce) {
+		next = SLIST_NEXT(pce, link);
+		if (pce->prop_set == TEE_PROPSET_CURRENT_CLIENT &&
+		    pce->session_id == session_id) {
+			if (prev)
+				SLIST_REMOVE_AFTER(prev, link);
+			else
+				SLIST_REMOVE_HEAD(&prop_cache, link);
+			TEE_Free(pce->name);
+			TEE_Free(pce);
+		} else {
+			prev = pce;
+		}
+		pce = next;
+	}
+}
+
+static struct prop_cache_entry *prop_cache_find(TEE_PropSetHandle h,
+						const char *name)
+{
+	struct prop_cache_entry *pce = NULL;
+
+	SLIST_FOREACH(pce, &prop_cache, link) {
+		if (pce->prop_set != h)
+			continue;
+		if (h == TEE_PROPSET_CURRENT_CLIENT &&
+		    pce->session_id != prop_cache_session_id)
+			continue;
+		if (!strcmp(pce->name, name))
+			return pce;
+	}
+
+	return NULL;
+}
+
+/* The cache is only an optimization, failing to add an entry is ignored */
+static void prop_cache_add(TEE_PropSetHandle h, const char *name,
+			   enum user_ta_prop_type type, const void *buf,
+			   uint32_t len)
+{
+	struct prop_cache_entry *pce = NULL;
+	size_t name_len = strlen(name) + 1;
+
+	pce = TEE_Malloc(sizeof(*pce) + len, TEE_USER_MEM_HINT_NO_FILL_ZERO);
+	if (!pce)
+		return;
+	pce->name = TEE_Malloc(name_len, TEE_USER_MEM_HINT_NO_FILL_ZERO);
+	if (!pce->name) {
+		TEE_Free(pce);
+		return;
+	}
+
+	memcpy(pce->name, name, name_len);
+	memcpy(pce->value, buf, len);
+	pce->prop_set = h;
+	pce->session_id = prop_cache_session_id;
+	pce->type = type;
+	pce->len = len;
+	SLIST_INSERT_HEAD(&prop_cache, pce, link);
+}
+
+static TEE_Result prop_cache_get(struct prop_cache_entry *pce,
+				 enum user_ta_prop_type *type, void *buf,
+				 uint32_t *len)
+{
+	*type = pce->type;
+	if (*len < pce->len) {
+		*len = pce->len;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	*len = pce->len;
+	memcpy(buf, pce->value, pce->len);
+	return TEE_SUCCESS;
+}
+
 static TEE_Result propget_get_property(TEE_PropSetHandle h, const char *name,
 				       enum user_ta_prop_type *type,
 				       void *buf, uint32_t *len)
@@ -135,6 +244,7 @@ static TEE_Result propget_get_property(TEE_PropSetHandle h, const char *name,
 
 	if (h == TEE_PROPSET_CURRENT_TA || h == TEE_PROPSET_CURRENT_CLIENT ||
 	    h == TEE_PROPSET_TEE_IMPLEMENTATION) {
+		struct prop_cache_entry *pce = NULL;
 		size_t n;
 
 		res = propset_get(h, &eps, &eps_len);
@@ -147,6 +257,10 @@ static TEE_Result propget_get_property(TEE_PropSetHandle h, const char *name,
 							    buf, len);
 		}
 
+		pce = prop_cache_find(h, name);
+		if (pce)
+			return prop_cache_get(pce, type, buf, len);
+
 		/* get the index from the name */
 		res = utee_get_property_name_to_index((unsigned long)h, name,
 						strlen(name) + 1, &index);
@@ -154,6 +268,8 @@ static TEE_Result propget_get_property(TEE_PropSetHandle h, const char *name,
 			return res;
 		res = utee_get_property((unsigned long)h, index, NULL, NULL,
 					buf, len, &prop_type);
+		if (res == TEE_SUCCESS)
+			prop_cache_add(h, name, prop_type, buf, *len);
 	} else {
 		struct prop_enumerator *pe = (struct prop_enumerator *)h;
 		uint32_t idx = pe->idx;
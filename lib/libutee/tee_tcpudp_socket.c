@@ -4,17 +4,32 @@
  */
 
 #include <pta_socket.h>
+#include <string.h>
 #include <tee_internal_api.h>
 #include <tee_isocket.h>
 #include <tee_tcpsocket.h>
 #include <__tee_tcpsocket_defines_extensions.h>
 #include <tee_udpsocket.h>
+#include <util.h>
 
 #include "tee_socket_private.h"
 
+static const uint32_t recv_buf_size = CFG_TA_SOCKET_RECV_BUF_SIZE;
+
+/*
+ * struct socket_ctx - State of a socket
+ * @handle:		Handle of the socket in the socket PTA
+ * @proto_error:	Result of the last operation
+ * @rbuf:		TCP read-ahead buffer, allocated on first use
+ * @rbuf_offs:		Offset of the first byte not yet received by the TA
+ * @rbuf_len:		Number of bytes not yet received by the TA
+ */
 struct socket_ctx {
 	uint32_t handle;
 	uint32_t proto_error;
+	uint8_t *rbuf;
+	uint32_t rbuf_offs;
+	uint32_t rbuf_len;
 };
 
 static TEE_Result tcp_open(TEE_iSocketHandle *ctx, void *setup,
@@ -104,6 +119,7 @@ static TEE_Result sock_close(TEE_iSocketHandle ctx)
 		return TEE_SUCCESS;
 
 	res = __tee_socket_pta_close(sock_ctx->handle);
+	TEE_Free(sock_ctx->rbuf);
 	TEE_Free(sock_ctx);
 
 	return res;
@@ -139,6 +155,55 @@ static TEE_Result sock_recv(TEE_iSocketHandle ctx, void *buf, uint32_t *length,
 	return res;
 }
 
+/*
+ * TCP is a stream so a receive may return less than what was read from
+ * the socket, the rest is kept for the next receives. Buffered data is
+ * returned without calling the socket PTA, receives at least as large as
+ * the buffer bypass it.
+ */
+static TEE_Result tcp_recv(TEE_iSocketHandle ctx, void *buf, uint32_t *length,
+			   uint32_t timeout)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	struct socket_ctx *sock_ctx = (struct socket_ctx *)ctx;
+	uint32_t len = recv_buf_size;
+
+	if (ctx == TEE_HANDLE_NULL || !length || (!buf && *length))
+		TEE_Panic(0);
+
+	if (sock_ctx->rbuf_len) {
+		len = MIN(*length, sock_ctx->rbuf_len);
+		memcpy(buf, sock_ctx->rbuf + sock_ctx->rbuf_offs, len);
+		sock_ctx->rbuf_offs += len;
+		sock_ctx->rbuf_len -= len;
+		*length = len;
+		sock_ctx->proto_error = TEE_SUCCESS;
+		return TEE_SUCCESS;
+	}
+
+	if (!*length || *length >= recv_buf_size)
+		return sock_recv(ctx, buf, length, timeout);
+
+	if (!sock_ctx->rbuf) {
+		sock_ctx->rbuf = TEE_Malloc(recv_buf_size, TEE_MALLOC_FILL_ZERO);
+		if (!sock_ctx->rbuf)
+			return sock_recv(ctx, buf, length, timeout);
+	}
+
+	res = __tee_socket_pta_recv(sock_ctx->handle, sock_ctx->rbuf, &len,
+				    timeout);
+	sock_ctx->proto_error = res;
+	if (len > recv_buf_size)
+		len = 0;
+
+	*length = MIN(*length, len);
+	memcpy(buf, sock_ctx->rbuf, *length);
+	sock_ctx->rbuf_offs = *length;
+	sock_ctx->rbuf_len = len - *length;
+
+	return res;
+}
+
 static uint32_t sock_error(TEE_iSocketHandle ctx)
 {
 	struct socket_ctx *sock_ctx = (struct socket_ctx *)ctx;
@@ -211,7 +276,7 @@ static TEE_iSocket tcp_socket_instance = {
 	.open = &tcp_open,
 	.close = &sock_close,
 	.send = &sock_send,
-	.recv = &sock_recv,
+	.recv = &tcp_recv,
 	.error = &sock_error,
 	.ioctl = &tcp_ioctl,
 };
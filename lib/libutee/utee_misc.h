@@ -5,6 +5,18 @@
 #ifndef UTEE_MISC_H
 #define UTEE_MISC_H
 
+#include <stdbool.h>
+#include <tee_api_types.h>
+
 unsigned int utee_get_ta_exec_id(void);
 
+/*
+ * utee_get_fast_sys_time() - Get the system time without a syscall
+ * @time:	Output time
+ *
+ * Returns false if the system time can't be read from user mode, the
+ * syscall must be used instead.
+ */
+bool utee_get_fast_sys_time(TEE_Time *time);
+
 #endif
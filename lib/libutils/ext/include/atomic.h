@@ -9,9 +9,19 @@
 #include <compiler.h>
 #include <types_ext.h>
 
+/* Return the new value of *@v */
 uint32_t atomic_inc32(volatile uint32_t *v);
 uint32_t atomic_dec32(volatile uint32_t *v);
 
+#ifdef __aarch64__
+/*
+ * Non-zero if atomic_inc32() and atomic_dec32() are to use the ARMv8.1
+ * LSE instructions instead of exclusive load/store loops. Only the core,
+ * which can read ID_AA64ISAR0_EL1, sets it.
+ */
+extern uint32_t atomic_have_lse;
+#endif
+
 static inline bool atomic_cas_uint(unsigned int *p, unsigned int *oval,
 				   unsigned int nval)
 {
@@ -53,4 +63,10 @@ static inline void atomic_store_u32(uint32_t *p, uint32_t val)
 	__compiler_atomic_store(p, val);
 }
 
+/* Atomically ORs @val into *@p and returns the previous value */
+static inline uint32_t atomic_fetch_or_u32(uint32_t *p, uint32_t val)
+{
+	return __compiler_atomic_fetch_or(p, val);
+}
+
 #endif /*__ATOMIC_H*/
@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+#ifndef RECIPROCAL_DIV_H
+#define RECIPROCAL_DIV_H
+
+#include <stdint.h>
+
+/*
+ * Division of 64-bit values by an invariant 32-bit divisor, replacing the
+ * division by a multiplication with a precomputed reciprocal. The
+ * reciprocal underestimates the quotient by at most 2 which is corrected
+ * with the remainder, the result is exact.
+ */
+struct reciprocal_div {
+	uint64_t mult;
+	uint32_t div;
+};
+
+static inline uint64_t reciprocal_mul_hi(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+	return ((unsigned __int128)a * b) >> 64;
+#else
+	uint64_t al = (uint32_t)a;
+	uint64_t ah = a >> 32;
+	uint64_t bl = (uint32_t)b;
+	uint64_t bh = b >> 32;
+	uint64_t lh = al * bh;
+	uint64_t hl = ah * bl;
+	uint64_t mid = ((al * bl) >> 32) + (uint32_t)lh + (uint32_t)hl;
+
+	return ah * bh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+/* @div must not be 0, this is the only division done */
+static inline void reciprocal_div_init(struct reciprocal_div *r, uint32_t div)
+{
+	r->div = div;
+	r->mult = UINT64_MAX / div;
+}
+
+/* Returns @n / @r->div, the remainder is returned in @rem if not NULL */
+static inline uint64_t reciprocal_divide(uint64_t n,
+					 const struct reciprocal_div *r,
+					 uint32_t *rem)
+{
+	uint64_t q = reciprocal_mul_hi(n, r->mult);
+	uint64_t m = n - q * r->div;
+
+	while (m >= r->div) {
+		q++;
+		m -= r->div;
+	}
+	if (rem)
+		*rem = m;
+
+	return q;
+}
+
+#endif /*RECIPROCAL_DIV_H*/
@@ -38,6 +38,23 @@ void trace_printf(const char *func, int line, int level, bool level_ok,
 	trace_printf(__func__, __LINE__, (level), (level_ok), \
 		     __VA_ARGS__)
 
+#if defined(__KERNEL__) && defined(CFG_CORE_BINARY_TRACE)
+/*
+ * With CFG_CORE_BINARY_TRACE=y IMSG(), DMSG() and FMSG() in the core
+ * aren't formatted, the address of the format string and the arguments
+ * are logged in a binary record which is formatted offline, see
+ * PTA_TRACE_GET_LOG in <pta_trace.h>.
+ */
+void trace_bin_printf(const char *func, int line, int level,
+		      const char *fmt, ...) __printf(4, 5);
+
+#define trace_printf_helper_bin(level, ...) \
+	trace_bin_printf(__func__, __LINE__, (level), __VA_ARGS__)
+#else
+#define trace_printf_helper_bin(level, ...) \
+	trace_printf_helper((level), true, __VA_ARGS__)
+#endif
+
 /* Formatted trace tagged with level independent */
 #if (TRACE_LEVEL <= 0)
 #define MSG(...)   (void)0
@@ -56,21 +73,21 @@ void trace_printf(const char *func, int line, int level, bool level_ok,
 #if (TRACE_LEVEL < TRACE_INFO)
 #define IMSG(...)   (void)0
 #else
-#define IMSG(...)   trace_printf_helper(TRACE_INFO, true, __VA_ARGS__)
+#define IMSG(...)   trace_printf_helper_bin(TRACE_INFO, __VA_ARGS__)
 #endif
 
 /* Formatted trace tagged with TRACE_DEBUG level */
 #if (TRACE_LEVEL < TRACE_DEBUG)
 #define DMSG(...)   (void)0
 #else
-#define DMSG(...)   trace_printf_helper(TRACE_DEBUG, true, __VA_ARGS__)
+#define DMSG(...)   trace_printf_helper_bin(TRACE_DEBUG, __VA_ARGS__)
 #endif
 
 /* Formatted trace tagged with TRACE_FLOW level */
 #if (TRACE_LEVEL < TRACE_FLOW)
 #define FMSG(...)   (void)0
 #else
-#define FMSG(...)   trace_printf_helper(TRACE_FLOW, true, __VA_ARGS__)
+#define FMSG(...)   trace_printf_helper_bin(TRACE_FLOW, __VA_ARGS__)
 #endif
 
 /* Formatted trace tagged with TRACE_FLOW level and prefix with '> ' */
@@ -90,6 +90,7 @@
 #if defined(__KERNEL__)
 /* Compiling for TEE Core */
 #include <kernel/asan.h>
+#include <kernel/misc.h>
 #include <kernel/thread.h>
 #include <kernel/spinlock.h>
 
@@ -345,6 +346,35 @@ static bool bpool_foreach(struct malloc_ctx *ctx,
 	for (bpool_foreach_iterator_init((ctx),(iterator));   \
 	     bpool_foreach((ctx),(iterator), (bp));)
 
+#ifdef __KERNEL__
+static bool grow_pool(struct malloc_ctx *ctx __unused, size_t size __unused)
+{
+	return false;
+}
+#else /*__KERNEL__*/
+static bool (*malloc_pool_grow)(size_t size);
+
+/*
+ * Called with the size of a failed allocation from the default heap to
+ * ask malloc_pool_grow() to add another pool. Adding the pool allocates
+ * from the heap too, so nested calls are refused.
+ */
+static bool grow_pool(struct malloc_ctx *ctx, size_t size)
+{
+	static bool busy;
+	bool res = false;
+
+	if (ctx != &malloc_ctx || !malloc_pool_grow || busy)
+		return false;
+
+	busy = true;
+	res = malloc_pool_grow(size);
+	busy = false;
+
+	return res;
+}
+#endif /*__KERNEL__*/
+
 static void *raw_malloc(size_t hdr_size, size_t ftr_size, size_t pl_size,
 			struct malloc_ctx *ctx)
 {
@@ -371,6 +401,8 @@ static void *raw_malloc(size_t hdr_size, size_t ftr_size, size_t pl_size,
 		s++;
 
 	ptr = bget(s, &ctx->poolset);
+	if (!ptr && grow_pool(ctx, s))
+		ptr = bget(s, &ctx->poolset);
 out:
 	raw_malloc_return_hook(ptr, pl_size, ctx);
 
@@ -406,6 +438,8 @@ static void *raw_calloc(size_t hdr_size, size_t ftr_size, size_t pl_nmemb,
 		s++;
 
 	ptr = bgetz(s, &ctx->poolset);
+	if (!ptr && grow_pool(ctx, s))
+		ptr = bgetz(s, &ctx->poolset);
 out:
 	raw_malloc_return_hook(ptr, pl_nmemb * pl_size, ctx);
 
@@ -431,6 +465,8 @@ static void *raw_realloc(void *ptr, size_t hdr_size, size_t ftr_size,
 		s++;
 
 	p = bgetr(ptr, s, &ctx->poolset);
+	if (!p && grow_pool(ctx, s))
+		p = bgetr(ptr, s, &ctx->poolset);
 out:
 	raw_malloc_return_hook(p, pl_size, ctx);
 
@@ -459,6 +495,468 @@ static __maybe_unused bufsize bget_buf_size(void *buf)
 	return osize;
 }
 
+#if (defined(__KERNEL__) && defined(CFG_CORE_MALLOC_CACHE)) || \
+	(!defined(__KERNEL__) && defined(CFG_TA_MALLOC_CACHE))
+/*
+ * Caches of freed small buffers in front of bget. Each cache holds a
+ * stack of buffers per size class. In the core there's one cache per CPU,
+ * only accessed by its own CPU with all exceptions masked, so a hit in
+ * the cache needs no lock. In user space there's a single cache since a
+ * TA is single threaded. A miss allocates the full size of the class from
+ * bget so the buffer can be cached again when freed, buffers larger than
+ * the largest class always go directly to bget. Reusing buffers of the
+ * same size also keeps small short lived allocations from fragmenting
+ * the heap.
+ *
+ * Cached buffers are still allocated as far as bget is concerned.
+ */
+static const uint16_t malloc_cache_class_size[] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512,
+};
+
+#define MALLOC_CACHE_NUM_CLASSES	ARRAY_SIZE(malloc_cache_class_size)
+
+#ifdef __KERNEL__
+#define MALLOC_CACHE_NUM	CFG_TEE_CORE_NB_CORE
+#define MALLOC_CACHE_DEPTH	CFG_CORE_MALLOC_CACHE_DEPTH
+#else
+#define MALLOC_CACHE_NUM	1
+#define MALLOC_CACHE_DEPTH	CFG_TA_MALLOC_CACHE_DEPTH
+#endif
+
+struct malloc_cache {
+	void *bufs[MALLOC_CACHE_NUM_CLASSES][MALLOC_CACHE_DEPTH];
+	unsigned int count[MALLOC_CACHE_NUM_CLASSES];
+#ifdef BufStats
+	struct malloc_cache_stats stats;
+#endif
+};
+
+static struct malloc_cache malloc_caches[MALLOC_CACHE_NUM];
+
+#ifdef BufStats
+#define MALLOC_CACHE_STAT_INC(mc, name)	((mc)->stats.name++)
+#define MALLOC_CACHE_STAT_DEC(mc, name)	((mc)->stats.name--)
+#else
+#define MALLOC_CACHE_STAT_INC(mc, name)	do { } while (0)
+#define MALLOC_CACHE_STAT_DEC(mc, name)	do { } while (0)
+#endif
+
+#ifdef __KERNEL__
+/* Returns the cache of the current CPU, masking exceptions */
+static struct malloc_cache *malloc_cache_lock(uint32_t *exceptions)
+{
+	*exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	return malloc_caches + get_core_pos();
+}
+
+static void malloc_cache_unlock(uint32_t exceptions)
+{
+	thread_unmask_exceptions(exceptions);
+}
+
+/* Called with the malloc lock held which keeps the thread on this CPU */
+static struct malloc_cache *malloc_cache_current(void)
+{
+	return malloc_caches + get_core_pos();
+}
+#else
+static struct malloc_cache *malloc_cache_lock(uint32_t *exceptions)
+{
+	*exceptions = 0;
+	return malloc_caches;
+}
+
+static void malloc_cache_unlock(uint32_t exceptions __unused)
+{
+}
+
+static struct malloc_cache *malloc_cache_current(void)
+{
+	return malloc_caches;
+}
+#endif
+
+/* Returns the smallest class that can hold @size or -1 if too large */
+static int malloc_cache_alloc_class(size_t size)
+{
+	size_t n = 0;
+
+	for (n = 0; n < MALLOC_CACHE_NUM_CLASSES; n++)
+		if (size <= malloc_cache_class_size[n])
+			return n;
+
+	return -1;
+}
+
+/*
+ * Returns the class a buffer with capacity @size belongs to or -1 if it
+ * shouldn't be cached. bget only leaves some extra bytes at the end of
+ * a buffer when the remainder is too small to be split off as a free
+ * block, a larger excess means that the buffer wasn't allocated for the
+ * class.
+ */
+static int malloc_cache_free_class(size_t size)
+{
+	size_t n = MALLOC_CACHE_NUM_CLASSES;
+
+	while (n) {
+		n--;
+		if (size >= malloc_cache_class_size[n]) {
+			if (size - malloc_cache_class_size[n] >
+			    sizeof(struct bfhead))
+				return -1;
+			return n;
+		}
+	}
+
+	return -1;
+}
+
+/* Returns the number of bytes to ask bget for to serve @size */
+static size_t malloc_cache_alloc_size(size_t size)
+{
+	int c = malloc_cache_alloc_class(size);
+
+	if (c < 0)
+		return size;
+	return malloc_cache_class_size[c];
+}
+
+static void *malloc_cache_get(size_t size)
+{
+	int c = malloc_cache_alloc_class(size);
+	struct malloc_cache *mc = NULL;
+	uint32_t exceptions = 0;
+	void *p = NULL;
+
+	if (c < 0)
+		return NULL;
+
+	mc = malloc_cache_lock(&exceptions);
+	if (mc->count[c]) {
+		mc->count[c]--;
+		p = mc->bufs[c][mc->count[c]];
+		MALLOC_CACHE_STAT_INC(mc, hits);
+		MALLOC_CACHE_STAT_DEC(mc, cached);
+	} else {
+		MALLOC_CACHE_STAT_INC(mc, misses);
+	}
+	malloc_cache_unlock(exceptions);
+
+	if (p)
+		tag_asan_alloced(p, bget_buf_size(p));
+
+	return p;
+}
+
+static bool malloc_cache_put(void *ptr)
+{
+	size_t size = bget_buf_size(ptr);
+	int c = malloc_cache_free_class(size);
+	struct malloc_cache *mc = NULL;
+	uint32_t exceptions = 0;
+	bool cached = false;
+
+	if (c < 0)
+		return false;
+
+	mc = malloc_cache_lock(&exceptions);
+	if (mc->count[c] < MALLOC_CACHE_DEPTH) {
+		mc->bufs[c][mc->count[c]] = ptr;
+		mc->count[c]++;
+		MALLOC_CACHE_STAT_INC(mc, cached_frees);
+		MALLOC_CACHE_STAT_INC(mc, cached);
+		cached = true;
+	}
+	malloc_cache_unlock(exceptions);
+
+	if (cached)
+		tag_asan_free(ptr, size);
+
+	return cached;
+}
+
+/*
+ * Releases all buffers in the cache of the current CPU to bget, called
+ * with the malloc lock held.
+ */
+static bool malloc_cache_drain_locked(struct malloc_ctx *ctx)
+{
+	struct malloc_cache *mc = malloc_cache_current();
+	bool drained = false;
+	size_t n = 0;
+
+	for (n = 0; n < MALLOC_CACHE_NUM_CLASSES; n++) {
+		while (mc->count[n]) {
+			mc->count[n]--;
+			/* Unpoison since brel() writes to the buffer */
+			tag_asan_alloced(mc->bufs[n][mc->count[n]],
+					 bget_buf_size(mc->bufs[n][mc->count[n]]));
+			raw_free(mc->bufs[n][mc->count[n]], ctx, false);
+			MALLOC_CACHE_STAT_DEC(mc, cached);
+			drained = true;
+		}
+	}
+
+	return drained;
+}
+
+#ifdef BufStats
+void malloc_get_cache_stats(struct malloc_cache_stats *stats)
+{
+	size_t n = 0;
+
+	*stats = (struct malloc_cache_stats){ };
+	for (n = 0; n < ARRAY_SIZE(malloc_caches); n++) {
+		stats->hits += malloc_caches[n].stats.hits;
+		stats->misses += malloc_caches[n].stats.misses;
+		stats->cached_frees += malloc_caches[n].stats.cached_frees;
+		stats->cached += malloc_caches[n].stats.cached;
+	}
+}
+#endif /*BufStats*/
+
+#else /*CFG_CORE_MALLOC_CACHE || CFG_TA_MALLOC_CACHE*/
+
+static size_t malloc_cache_alloc_size(size_t size)
+{
+	return size;
+}
+
+static void *malloc_cache_get(size_t size __unused)
+{
+	return NULL;
+}
+
+static bool malloc_cache_put(void *ptr __unused)
+{
+	return false;
+}
+
+static bool malloc_cache_drain_locked(struct malloc_ctx *ctx __unused)
+{
+	return false;
+}
+#endif /*CFG_CORE_MALLOC_CACHE || CFG_TA_MALLOC_CACHE*/
+
+#if defined(__KERNEL__) && defined(CFG_CORE_MALLOC_PROFILE)
+/*
+ * Sampling heap profiler. Each CPU counts down the bytes it allocates and
+ * samples the allocation which reaches CFG_CORE_MALLOC_PROFILE_PERIOD
+ * bytes. A sample accounts for that many bytes, or its own size if
+ * larger, to the allocation site which is identified by the return
+ * address of the call to malloc(), calloc() or realloc(). Sampled buffers
+ * are kept in a hash table until freed so the live bytes of the site can
+ * be decreased again.
+ */
+#define MALLOC_PROFILE_SLOTS_SHIFT	9
+#define MALLOC_PROFILE_SLOTS		BIT(MALLOC_PROFILE_SLOTS_SHIFT)
+/* Keep the hash table at most half full */
+#define MALLOC_PROFILE_MAX_LIVE		(MALLOC_PROFILE_SLOTS / 2)
+
+struct malloc_profile_sample {
+	void *ptr;
+	uint32_t bytes;
+	uint16_t site_idx;
+};
+
+static struct malloc_site_profile
+	malloc_profile_sites[CFG_CORE_MALLOC_PROFILE_SITES];
+static struct malloc_profile_sample
+	malloc_profile_samples[MALLOC_PROFILE_SLOTS];
+static size_t malloc_profile_live;
+static size_t malloc_profile_countdown[CFG_TEE_CORE_NB_CORE];
+static unsigned int malloc_profile_spinlock = SPINLOCK_UNLOCK;
+
+static size_t malloc_profile_slot(void *ptr)
+{
+	uint32_t h = (vaddr_t)ptr / SizeQuant;
+
+	return (h * 0x9e3779b1U) >> (32 - MALLOC_PROFILE_SLOTS_SHIFT);
+}
+
+static struct malloc_site_profile *malloc_profile_get_site(void *site)
+{
+	struct malloc_site_profile *free_sp = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(malloc_profile_sites); n++) {
+		struct malloc_site_profile *sp = malloc_profile_sites + n;
+
+		if (sp->site == (vaddr_t)site)
+			return sp;
+		if (!sp->site && !free_sp)
+			free_sp = sp;
+	}
+
+	if (free_sp)
+		*free_sp = (struct malloc_site_profile){ .site = (vaddr_t)site };
+
+	return free_sp;
+}
+
+static void malloc_profile_alloc(void *ptr, size_t size, void *site)
+{
+	struct malloc_site_profile *sp = NULL;
+	size_t bytes = MAX(size, (size_t)CFG_CORE_MALLOC_PROFILE_PERIOD);
+	uint32_t exceptions = 0;
+	size_t *countdown = NULL;
+	bool sample = false;
+	size_t n = 0;
+
+	if (!ptr)
+		return;
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	countdown = malloc_profile_countdown + get_core_pos();
+	if (size >= *countdown) {
+		*countdown = CFG_CORE_MALLOC_PROFILE_PERIOD;
+		sample = true;
+	} else {
+		*countdown -= size;
+	}
+	thread_unmask_exceptions(exceptions);
+
+	if (!sample)
+		return;
+
+	exceptions = cpu_spin_lock_xsave(&malloc_profile_spinlock);
+
+	if (malloc_profile_live >= MALLOC_PROFILE_MAX_LIVE)
+		goto out;
+	sp = malloc_profile_get_site(site);
+	if (!sp)
+		goto out;
+
+	n = malloc_profile_slot(ptr);
+	while (malloc_profile_samples[n].ptr)
+		n = (n + 1) & (MALLOC_PROFILE_SLOTS - 1);
+	malloc_profile_samples[n] = (struct malloc_profile_sample){
+		.ptr = ptr,
+		.bytes = bytes,
+		.site_idx = sp - malloc_profile_sites,
+	};
+	malloc_profile_live++;
+
+	sp->samples++;
+	sp->alloc_bytes += bytes;
+	sp->live_bytes += bytes;
+	if (sp->live_bytes > sp->peak_bytes)
+		sp->peak_bytes = sp->live_bytes;
+out:
+	cpu_spin_unlock_xrestore(&malloc_profile_spinlock, exceptions);
+}
+
+/*
+ * Removes the sample in slot @idx, later samples of the same probe
+ * sequence are moved back so lookups don't stop at the freed slot.
+ */
+static void malloc_profile_remove_sample(size_t idx)
+{
+	size_t n = idx;
+	size_t home = 0;
+
+	while (true) {
+		n = (n + 1) & (MALLOC_PROFILE_SLOTS - 1);
+		if (!malloc_profile_samples[n].ptr)
+			break;
+		home = malloc_profile_slot(malloc_profile_samples[n].ptr);
+		if (n > idx ? (home <= idx || home > n) :
+			      (home <= idx && home > n)) {
+			malloc_profile_samples[idx] = malloc_profile_samples[n];
+			idx = n;
+		}
+	}
+	malloc_profile_samples[idx].ptr = NULL;
+}
+
+static void malloc_profile_free(void *ptr)
+{
+	struct malloc_profile_sample *smp = NULL;
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	/*
+	 * A sampled buffer is added to the table before it's returned by
+	 * malloc() so the check can't miss it here.
+	 */
+	if (!ptr || !malloc_profile_live)
+		return;
+
+	exceptions = cpu_spin_lock_xsave(&malloc_profile_spinlock);
+
+	n = malloc_profile_slot(ptr);
+	while (malloc_profile_samples[n].ptr) {
+		smp = malloc_profile_samples + n;
+		if (smp->ptr == ptr) {
+			malloc_profile_sites[smp->site_idx].live_bytes -=
+				smp->bytes;
+			malloc_profile_remove_sample(n);
+			malloc_profile_live--;
+			break;
+		}
+		n = (n + 1) & (MALLOC_PROFILE_SLOTS - 1);
+	}
+
+	cpu_spin_unlock_xrestore(&malloc_profile_spinlock, exceptions);
+}
+
+bool malloc_get_profile(struct malloc_site_profile *prof, size_t *count,
+			bool reset)
+{
+	uint32_t exceptions = 0;
+	bool ret = true;
+	size_t num = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&malloc_profile_spinlock);
+
+	for (n = 0; n < ARRAY_SIZE(malloc_profile_sites); n++)
+		if (malloc_profile_sites[n].site)
+			num++;
+	if (*count < num) {
+		ret = false;
+		goto out;
+	}
+
+	num = 0;
+	for (n = 0; n < ARRAY_SIZE(malloc_profile_sites); n++) {
+		struct malloc_site_profile *sp = malloc_profile_sites + n;
+
+		if (!sp->site)
+			continue;
+		prof[num] = *sp;
+		num++;
+
+		if (reset) {
+			/* Sites without live buffers aren't referenced */
+			if (!sp->live_bytes) {
+				sp->site = 0;
+			} else {
+				sp->samples = 0;
+				sp->alloc_bytes = 0;
+				sp->peak_bytes = sp->live_bytes;
+			}
+		}
+	}
+out:
+	*count = num;
+	cpu_spin_unlock_xrestore(&malloc_profile_spinlock, exceptions);
+
+	return ret;
+}
+#else /*__KERNEL__ && CFG_CORE_MALLOC_PROFILE*/
+static void malloc_profile_alloc(void *ptr __unused, size_t size __unused,
+				 void *site __unused)
+{
+}
+
+static void malloc_profile_free(void *ptr __unused)
+{
+}
+#endif /*__KERNEL__ && CFG_CORE_MALLOC_PROFILE*/
+
 #ifdef ENABLE_MDBG
 
 struct mdbg_hdr {
@@ -552,8 +1050,11 @@ static void gen_mdbg_free(struct malloc_ctx *ctx, void *ptr, bool wipe)
 
 static void free_helper(void *ptr, bool wipe)
 {
-	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	uint32_t exceptions = 0;
 
+	malloc_profile_free(ptr);
+
+	exceptions = malloc_lock(&malloc_ctx);
 	gen_mdbg_free(&malloc_ctx, ptr, wipe);
 	malloc_unlock(&malloc_ctx, exceptions);
 }
@@ -645,17 +1146,29 @@ static void gen_mdbg_check(struct malloc_ctx *ctx, int bufdump)
 
 void *mdbg_malloc(const char *fname, int lineno, size_t size)
 {
-	return gen_mdbg_malloc(&malloc_ctx, fname, lineno, size);
+	void *p = gen_mdbg_malloc(&malloc_ctx, fname, lineno, size);
+
+	malloc_profile_alloc(p, size, __builtin_return_address(0));
+	return p;
 }
 
 void *mdbg_calloc(const char *fname, int lineno, size_t nmemb, size_t size)
 {
-	return gen_mdbg_calloc(&malloc_ctx, fname, lineno, nmemb, size);
+	void *p = gen_mdbg_calloc(&malloc_ctx, fname, lineno, nmemb, size);
+
+	malloc_profile_alloc(p, nmemb * size, __builtin_return_address(0));
+	return p;
 }
 
 void *mdbg_realloc(const char *fname, int lineno, void *ptr, size_t size)
 {
-	return gen_mdbg_realloc(&malloc_ctx, fname, lineno, ptr, size);
+	void *p = NULL;
+
+	/* Done first since @ptr may be reused by others once reallocated */
+	malloc_profile_free(ptr);
+	p = gen_mdbg_realloc(&malloc_ctx, fname, lineno, ptr, size);
+	malloc_profile_alloc(p, size, __builtin_return_address(0));
+	return p;
 }
 
 void mdbg_check(int bufdump)
@@ -667,17 +1180,33 @@ void mdbg_check(int bufdump)
 void *malloc(size_t size)
 {
 	void *p;
-	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	uint32_t exceptions = 0;
+
+	p = malloc_cache_get(size);
+	if (p)
+		goto out;
 
-	p = raw_malloc(0, 0, size, &malloc_ctx);
+	exceptions = malloc_lock(&malloc_ctx);
+	p = raw_malloc(0, 0, malloc_cache_alloc_size(size), &malloc_ctx);
+	if (!p && malloc_cache_drain_locked(&malloc_ctx))
+		p = raw_malloc(0, 0, malloc_cache_alloc_size(size),
+			       &malloc_ctx);
 	malloc_unlock(&malloc_ctx, exceptions);
+out:
+	malloc_profile_alloc(p, size, __builtin_return_address(0));
 	return p;
 }
 
 static void free_helper(void *ptr, bool wipe)
 {
-	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	uint32_t exceptions = 0;
 
+	malloc_profile_free(ptr);
+
+	if (ptr && !wipe && malloc_cache_put(ptr))
+		return;
+
+	exceptions = malloc_lock(&malloc_ctx);
 	raw_free(ptr, &malloc_ctx, wipe);
 	malloc_unlock(&malloc_ctx, exceptions);
 }
@@ -685,10 +1214,26 @@ static void free_helper(void *ptr, bool wipe)
 void *calloc(size_t nmemb, size_t size)
 {
 	void *p;
-	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	uint32_t exceptions = 0;
+	size_t s = 0;
 
+	if (!MUL_OVERFLOW(nmemb, size, &s)) {
+		p = malloc_cache_get(s);
+		if (p) {
+			memset(p, 0, s);
+			goto out;
+		}
+		nmemb = 1;
+		size = malloc_cache_alloc_size(s);
+	}
+
+	exceptions = malloc_lock(&malloc_ctx);
 	p = raw_calloc(0, 0, nmemb, size, &malloc_ctx);
+	if (!p && malloc_cache_drain_locked(&malloc_ctx))
+		p = raw_calloc(0, 0, nmemb, size, &malloc_ctx);
 	malloc_unlock(&malloc_ctx, exceptions);
+out:
+	malloc_profile_alloc(p, s, __builtin_return_address(0));
 	return p;
 }
 
@@ -701,10 +1246,15 @@ static void *realloc_unlocked(struct malloc_ctx *ctx, void *ptr,
 void *realloc(void *ptr, size_t size)
 {
 	void *p;
-	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	uint32_t exceptions = 0;
+
+	/* Done first since @ptr may be reused by others once reallocated */
+	malloc_profile_free(ptr);
 
+	exceptions = malloc_lock(&malloc_ctx);
 	p = realloc_unlocked(&malloc_ctx, ptr, size);
 	malloc_unlock(&malloc_ctx, exceptions);
+	malloc_profile_alloc(p, size, __builtin_return_address(0));
 	return p;
 }
 
@@ -831,6 +1381,58 @@ out:
 	return ret;
 }
 
+#ifndef __KERNEL__
+static bool gen_malloc_remove_pool(struct malloc_ctx *ctx, void *buf)
+{
+	struct bfhead *b = NULL;
+	bool ret = false;
+	size_t n = 0;
+	uint32_t exceptions = malloc_lock(ctx);
+
+	raw_malloc_validate_pools(ctx);
+
+	for (n = 0; n < ctx->pool_len; n++)
+		if (ctx->pool[n].buf == buf)
+			break;
+	if (n == ctx->pool_len)
+		goto out;
+
+	/*
+	 * A pool without allocated buffers consists of a single free
+	 * block spanning all of it up to the end sentinel, see bpool().
+	 */
+	b = BFH(buf);
+	if (b->bh.bsize !=
+	    (bufsize)(ctx->pool[n].len - sizeof(struct bhead)))
+		goto out;
+
+	b->ql.blink->ql.flink = b->ql.flink;
+	b->ql.flink->ql.blink = b->ql.blink;
+
+#ifdef BufStats
+	ctx->mstats.size -= ctx->pool[n].len;
+#endif
+	ctx->pool_len--;
+	memmove(ctx->pool + n, ctx->pool + n + 1,
+		(ctx->pool_len - n) * sizeof(struct malloc_pool));
+	ret = true;
+out:
+	malloc_unlock(ctx, exceptions);
+
+	return ret;
+}
+
+bool malloc_remove_pool(void *buf)
+{
+	return gen_malloc_remove_pool(&malloc_ctx, buf);
+}
+
+void malloc_set_pool_grow(bool (*grow)(size_t size))
+{
+	malloc_pool_grow = grow;
+}
+#endif /*__KERNEL__*/
+
 void malloc_add_pool(void *buf, size_t len)
 {
 	gen_malloc_add_pool(&malloc_ctx, buf, len);
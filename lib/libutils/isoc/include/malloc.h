@@ -56,6 +56,26 @@ bool malloc_buffer_overlaps_heap(void *buf, size_t len);
  */
 void malloc_add_pool(void *buf, size_t len);
 
+#ifndef __KERNEL__
+/*
+ * Removes a pool previously added with malloc_add_pool() starting at @buf.
+ * Returns false, leaving the pool in place, if any buffer is still
+ * allocated from it. Once removed the memory of the pool can be unmapped.
+ *
+ * Used internally by TAs
+ */
+bool malloc_remove_pool(void *buf);
+
+/*
+ * Sets a function called when an allocation fails. The function is
+ * supplied the number of bytes needed and returns true if it has added
+ * a pool with malloc_add_pool(), in which case the allocation is retried.
+ *
+ * Used internally by TAs
+ */
+void malloc_set_pool_grow(bool (*grow)(size_t size));
+#endif
+
 #ifdef CFG_WITH_STATS
 /*
  * Get/reset allocation statistics
@@ -74,6 +94,72 @@ struct malloc_stats {
 
 void malloc_get_stats(struct malloc_stats *stats);
 void malloc_reset_stats(void);
+
+/*
+ * struct malloc_cache_stats - Statistics of the malloc caches
+ * @hits:		Allocations served from a cache
+ * @misses:		Allocations of a cached size class served by bget
+ * @cached_frees:	Frees that put the buffer in a cache
+ * @cached:		Number of buffers currently in the caches
+ *
+ * In the core all counters are summed over all CPUs and count since boot.
+ */
+struct malloc_cache_stats {
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t cached_frees;
+	uint32_t cached;
+};
+
+#if (defined(__KERNEL__) && defined(CFG_CORE_MALLOC_CACHE)) || \
+	(!defined(__KERNEL__) && defined(CFG_TA_MALLOC_CACHE))
+void malloc_get_cache_stats(struct malloc_cache_stats *stats);
+#else
+static inline void malloc_get_cache_stats(struct malloc_cache_stats *stats)
+{
+	*stats = (struct malloc_cache_stats){ };
+}
+#endif
+
+/*
+ * struct malloc_site_profile - Sampled heap usage of an allocation site
+ * @site:		Return address of the call to malloc(), calloc() or
+ *			realloc()
+ * @samples:		Number of sampled allocations
+ * @alloc_bytes:	Estimated number of bytes allocated
+ * @live_bytes:		Estimated number of bytes currently allocated
+ * @peak_bytes:		Largest value of @live_bytes
+ *
+ * @samples, @alloc_bytes and @peak_bytes count since the last reset.
+ */
+struct malloc_site_profile {
+	uint64_t site;
+	uint32_t samples;
+	uint32_t alloc_bytes;
+	uint32_t live_bytes;
+	uint32_t peak_bytes;
+};
+
+/*
+ * malloc_get_profile() - Get the sampled heap profile of the core heap
+ * @prof:	Array to fill in with one entry per allocation site
+ * @count:	Number of entries in @prof on input, number of allocation
+ *		sites on output
+ * @reset:	If true, restarts counting after @prof is filled in
+ *
+ * Returns false if @prof is too small, true otherwise.
+ */
+#if defined(__KERNEL__) && defined(CFG_CORE_MALLOC_PROFILE)
+bool malloc_get_profile(struct malloc_site_profile *prof, size_t *count,
+			bool reset);
+#else
+static inline bool malloc_get_profile(struct malloc_site_profile *prof __unused,
+				      size_t *count, bool reset __unused)
+{
+	*count = 0;
+	return true;
+}
+#endif
 #endif /* CFG_WITH_STATS */
 
 
@@ -5,10 +5,12 @@ cflags-remove-y += -Wcast-align
 srcs-y += abs.c
 srcs-y += bcmp.c
 srcs-y += memchr.c
+ifneq ($(libutils-string-asm),y)
 srcs-y += memcmp.c
 srcs-y += memcpy.c
-srcs-y += memmove.c
 srcs-y += memset.c
+endif
+srcs-y += memmove.c
 srcs-y += strchr.c
 srcs-y += strcmp.c
 srcs-y += strcpy.c
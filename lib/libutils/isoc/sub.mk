@@ -27,5 +27,16 @@ srcs-y += isprint.c
 srcs-y += ispunct.c
 srcs-y += toupper.c
 
+# The assembly versions of memcpy(), memset() and memcmp() replace the
+# newlib ones. They are not instrumented so a core with KASAN keeps the C
+# versions.
+libutils-string-asm := $(CFG_LIBUTILS_STRING_ASM)
+ifneq ($(arch_arm),y)
+libutils-string-asm := n
+endif
+ifeq ($(sm)-$(CFG_CORE_SANITIZE_KADDRESS),core-y)
+libutils-string-asm := n
+endif
+
 subdirs-y += newlib
 subdirs-$(arch_arm) += arch/$(ARCH)
@@ -93,6 +93,12 @@ CFG_WITH_SOFTWARE_PRNG ?= y
 
 # Number of threads
 CFG_NUM_THREADS ?= 2
+# Number of threads with a stack reserved at build time, at least one. The
+# stacks of the other threads, up to CFG_NUM_THREADS, are allocated from
+# the heap when they are needed and freed again once fewer than
+# CFG_NUM_THREADS_STATIC threads are busy. Ignored with CFG_WITH_PAGER=y
+# where physical pages are only used by busy threads anyway.
+CFG_NUM_THREADS_STATIC ?= $(CFG_NUM_THREADS)
 
 # API implementation version
 CFG_TEE_API_VERSION ?= GPD-1.1-dev
@@ -133,14 +139,95 @@ CFG_TEE_FW_MANUFACTURER ?= FW_MAN_UNDEF
 # TEE_STORAGE_PRIVATE is passed to the trusted storage API)
 CFG_REE_FS ?= y
 
+# Size of the data blocks of REE FS files as a power of 2, from 12 (4 KiB)
+# to 16 (64 KiB). Each block has its own hash tree node, authentication tag
+# and RPC, larger blocks make large objects more compact and faster to read
+# and write sequentially while each access to an object still costs at
+# least one whole block. The block size determines the layout of all REE
+# FS files, dirf.db included, a file stored with another block size fails
+# authentication and is treated as corrupt. It must not be changed on a
+# device with existing secure storage.
+CFG_REE_FS_BLOCK_SHIFT ?= 12
+
+# REE FS objects with a total content (object header, attributes and data)
+# of at most this many bytes are stored in their dirf.db entry instead of
+# in a file of their own, saving the RPCs to open, read and close it and
+# the space of a whole data block. An object moves to a file of its own
+# when it outgrows the entry. Each dirf.db entry grows by this size, so
+# like CFG_REE_FS_BLOCK_SHIFT it must not be changed on a device with
+# existing secure storage. 0 disables inline objects.
+CFG_REE_FS_INLINE_SIZE ?= 0
+
+# Number of decrypted data blocks (see CFG_REE_FS_BLOCK_SHIFT) cached per
+# open REE FS object. Blocks are read ahead with a single RPC when an
+# object is read sequentially and modified blocks are only encrypted and
+# written when evicted or when the object is committed. The cache is
+# allocated from the core heap on first access of an object, 0 disables
+# it.
+CFG_REE_FS_BLOCK_CACHE_BLOCKS ?= 0
+
+# Number of closed REE FS objects whose verified hash tree is kept in
+# memory. Opening such an object again only checks that its hash in the
+# dirfile is unchanged instead of reading and verifying the hash tree. Each
+# kept object also keeps its file open in normal world, 0 disables it.
+CFG_REE_FS_HANDLE_CACHE ?= 0
+
+# Keep the REE FS directory file (dirf.db) open when no object is open
+# instead of reading and verifying it again on next access.
+CFG_REE_FS_DIRFILE_RESIDENT ?= n
+
+# Number of object creations, removals and renames whose update of the REE
+# FS directory file may be committed as one. Other changes commit all
+# pending ones. Up to this number minus one of such operations which have
+# returned successfully are lost on power failure. Implies a resident
+# directory file, 0 commits each operation on its own.
+CFG_REE_FS_DIRFILE_BATCH ?= 0
+
+# Verify the hash tree of a REE FS object on demand instead of when the
+# object is opened. Nodes are read and authenticated against their parent
+# the first time they are used, so open time doesn't depend on the size of
+# the object. A corrupt object may then be reported by a later read or
+# write instead of by the open.
+CFG_FS_HTREE_LAZY_VERIFY ?= n
+
 # RPMB file system support
 CFG_RPMB_FS ?= n
 
+# Number of FS RPC payload buffers, of different sizes, each thread caches
+# for the REE FS and RPMB FS RPCs. Must be at least 2.
+CFG_TEE_FS_RPC_CACHE_ENTRIES ?= 3
+
 # Device identifier used when CFG_RPMB_FS = y.
 # The exact meaning of this value is platform-dependent. On Linux, the
 # tee-supplicant process will open /dev/mmcblk<id>rpmb
 CFG_RPMB_FS_DEV_ID ?= 0
 
+# Keeps a RAM copy of the RPMB FS FAT, and of the RPMB space in use, so
+# that looking up, creating, listing and growing files doesn't read the
+# FAT over RPMB each time. Costs 256 bytes of heap per FAT entry.
+CFG_RPMB_FS_FAT_CACHE ?= n
+
+# Lets RPMB writes carry as many data frames per request as the reliable
+# write sector count of the device allows, instead of one frame per
+# request. Only enable this if the normal world RPMB driver handles
+# multi-frame writes, older Linux kernels don't.
+CFG_RPMB_DRIVER_MULTIPLE_WRITE_FIXED ?= n
+
+# Size in bytes of a write-back buffer for RPMB FS file data, 0 (default)
+# disables it. This is an explicitly non-durable mode which breaks the GP
+# guarantee that TEE_WriteObjectData() is persistent once it returns, only
+# enable it if the TAs using RPMB storage can live with that. It applies to
+# the objects of TEE_STORAGE_PRIVATE_RPMB, and of TEE_STORAGE_PRIVATE when
+# that is served by the RPMB FS (CFG_REE_FS=n). Objects of
+# TEE_STORAGE_PRIVATE_REE and the RPMB files used internally, like the REE
+# FS dirfile hash, are always written right away. Consecutive writes to the
+# same object are collected and stored with a single RPMB write when the
+# buffer is full or before any other RPMB FS operation, including closing
+# the object. Data written since then is lost on power failure, and an
+# error storing it is only reported if the next operation is done through
+# the same object.
+CFG_RPMB_FS_WRITE_BACK_SIZE ?= 0
+
 # Enables RPMB key programming by the TEE, in case the RPMB partition has not
 # been configured yet.
 # !!! Security warning !!!
@@ -222,6 +309,50 @@ CFG_TA_ASLR ?= n
 CFG_TA_ASLR_MIN_OFFSET_PAGES ?= 0
 CFG_TA_ASLR_MAX_OFFSET_PAGES ?= 128
 
+# Bind the PLT entries of TAs and TA shared libraries on first call instead
+# of when they are loaded. Only used when ldelf and the TA have the same
+# register width, that is never for 32-bit TAs on a 64-bit core. ELFs linked
+# with -z now are always bound at load time.
+CFG_TA_LAZY_BINDING ?= n
+
+# Link TAs and TA shared libraries with -z pack-relative-relocs, which stores
+# the relative relocations in a compact SHT_RELR table. Requires binutils
+# 2.38 or later (or LLD) to build the TAs.
+CFG_TA_RELR ?= n
+
+# Use the assembly versions of memcpy(), memset() and memcmp() in
+# lib/libutils/isoc/arch/arm instead of the generic C versions from newlib,
+# for the core, ldelf and TAs. They copy, set and compare 64 bytes
+# (AArch64) or 32 bytes (AArch32) per iteration when the buffers are
+# aligned. Ignored for the core with CFG_CORE_SANITIZE_KADDRESS=y.
+CFG_LIBUTILS_STRING_ASM ?= n
+
+# Keep only the first CFG_TA_HEAP_GROW_INITIAL bytes of the TA heap
+# (TA_DATA_SIZE) in bss. The rest is mapped by libutee with the system PTA
+# in chunks of at least CFG_TA_HEAP_GROW_SIZE bytes when malloc() runs out
+# of memory, so physical memory is only committed for the heap actually
+# used. tee_heap_trim() unmaps chunks which have become unused.
+CFG_TA_HEAP_GROW ?= n
+CFG_TA_HEAP_GROW_INITIAL ?= 16384
+CFG_TA_HEAP_GROW_SIZE ?= 65536
+
+# Cache of freed small buffers in front of the TA heap. With y malloc() and
+# free() of buffers of up to 512 bytes are served from a stack per size
+# class holding up to CFG_TA_MALLOC_CACHE_DEPTH buffers, instead of
+# searching the free list of the heap.
+CFG_TA_MALLOC_CACHE ?= y
+CFG_TA_MALLOC_CACHE_DEPTH ?= 8
+ifeq ($(CFG_TEE_TA_MALLOC_DEBUG),y)
+$(call force,CFG_TA_MALLOC_CACHE,n)
+endif
+
+# Number of user TA contexts kept ready with ldelf already loaded. A context
+# is taken from the pool when a session to a non-resident user TA is opened
+# and the pool is refilled when a user TA context is destroyed, which moves
+# the ldelf setup out of the session opening path. Each pooled context holds
+# an ASID and the ldelf stack, code and data pages in TA RAM.
+CFG_USER_TA_CTX_POOL_SIZE ?= 0
+
 # Load user TAs from the REE filesystem via tee-supplicant
 CFG_REE_FS_TA ?= y
 
@@ -235,6 +366,15 @@ CFG_REE_FS_TA ?= y
 CFG_REE_FS_TA_BUFFERED ?= n
 $(eval $(call cfg-depends-all,CFG_REE_FS_TA_BUFFERED,CFG_REE_FS_TA))
 
+# Number of verified TA binaries kept in the "Secure DDR" pool once their
+# last handle is closed. Loading a cached TA again skips both the transfer
+# from tee-supplicant and the signature check. Unused entries are dropped,
+# least recently used first, when the pool runs out of memory.
+CFG_REE_FS_TA_CACHE_ENTRIES ?= 0
+ifneq ($(CFG_REE_FS_TA_BUFFERED),y)
+$(call force,CFG_REE_FS_TA_CACHE_ENTRIES,0)
+endif
+
 # Support for loading user TAs from a special section in the TEE binary.
 # Such TAs are available even before tee-supplicant is available (hence their
 # name), but note that many services exported to TAs may need tee-supplicant,
@@ -261,13 +401,29 @@ $(call force,CFG_EARLY_TA,y)
 else
 CFG_EARLY_TA ?= n
 endif
+# Early TAs are compressed with DEFLATE, or with CFG_EARLY_TA_COMPRESS_LZ4=y
+# in blocks with LZ4 which is faster to decompress but compresses less.
+CFG_EARLY_TA_COMPRESS_LZ4 ?= n
+# With CFG_EARLY_TA_XIP=y early TAs are stored uncompressed and page
+# aligned instead. Their read-only segments are then mapped directly from
+# the TEE binary into the TA instead of being copied into TA memory. This
+# needs CFG_WITH_PAGER=n since the TEE binary itself is paged otherwise.
+CFG_EARLY_TA_XIP ?= n
 ifeq ($(CFG_EARLY_TA),y)
+ifeq ($(CFG_EARLY_TA_COMPRESS_LZ4),y)
+$(call force,CFG_LZ4,y)
+else
 $(call force,CFG_ZLIB,y)
 endif
+endif
 
 # Enable paging, requires SRAM, can't be enabled by default
 CFG_WITH_PAGER ?= n
 
+ifeq ($(CFG_EARLY_TA_XIP)-$(CFG_WITH_PAGER),y-y)
+$(error CFG_EARLY_TA_XIP and CFG_WITH_PAGER are incompatible)
+endif
+
 # Runtime lock dependency checker: ensures that a proper locking hierarchy is
 # used in the TEE core when acquiring and releasing mutexes. Any violation will
 # cause a panic as soon as the invalid locking condition is detected. If
@@ -276,13 +432,83 @@ CFG_WITH_PAGER ?= n
 # Expect a significant performance impact when enabling this.
 CFG_LOCKDEP ?= n
 
+# Number of iterations a thread spins waiting for a mutex while the thread
+# holding it is executing on another CPU, before sleeping in normal world.
+# Sleeping and being woken up costs one RPC each, short critical sections
+# are usually left within the spin. 0 disables spinning.
+CFG_MUTEX_SPIN_COUNT ?= 1000
+
 # BestFit algorithm in bget reduces the fragmentation of the heap when running
 # with the pager enabled or lockdep
 CFG_CORE_BGET_BESTFIT ?= $(call cfg-one-enabled, CFG_WITH_PAGER CFG_LOCKDEP)
 
+# Number of pages following a faulting page of a read-only (code and
+# read-only data) or read-write pageable area which are loaded by the same
+# fault, as long as there are free physical pages. Such a page is only
+# mapped on first access, which doesn't need to load it. Loading takes
+# place with exceptions masked, keep the numbers small. 0 disables.
+CFG_PAGER_FAULT_AROUND_RO ?= 0
+CFG_PAGER_FAULT_AROUND_RW ?= 0
+
+# Page replacement of the pager. With y pages are only unmapped to track
+# their use when they're considered for eviction (CLOCK), instead of
+# unmapping the oldest third of the pages on each page fault. This gives
+# fewer TLB invalidations and aborts on hidden pages.
+CFG_PAGER_CLOCK ?= n
+
+# Compressed store for read-write paged memory. With y a page is
+# compressed with LZ4 before it's encrypted and stored in a variable-size
+# slot of a pool of CFG_PAGER_RWP_COMPRESS_POOL_SIZE bytes reserved from
+# TA RAM at boot, instead of a full page per page of each read-write
+# paged fobj. All-zero pages only keep a flag. The core panics if the
+# pool is exhausted when a page is saved.
+CFG_PAGER_RWP_COMPRESS ?= n
+CFG_PAGER_RWP_COMPRESS_POOL_SIZE ?= 0x100000
+ifeq ($(CFG_PAGER_RWP_COMPRESS),y)
+$(call force,CFG_LZ4,y)
+endif
+
+# Records for each page of the paged core areas the number of times it's
+# been loaded on a fault and the order of its first fault. The profile is
+# read with the stats pseudo TA (CFG_WITH_STATS=y) and is meant to guide
+# the layout of the paged part of the core image.
+CFG_PAGER_PROFILE ?= n
+
+# Hash check of the pageable part of the core at boot. With
+# CFG_PAGER_LAZY_HASH_CHECK=y only the init part, which is in use without
+# being paged in, is checked before paging starts. The other pages are
+# only checked when loaded on a page fault, which is done in any case.
+# With CFG_PAGER_BG_HASH_CHECK=y these pages are also all checked once
+# by deferred work after boot, to detect a corrupted image early.
+CFG_PAGER_LAZY_HASH_CHECK ?= n
+CFG_PAGER_BG_HASH_CHECK ?= n
+$(eval $(call cfg-depends-all,CFG_PAGER_LAZY_HASH_CHECK,CFG_WITH_PAGER))
+$(eval $(call cfg-depends-all,CFG_PAGER_BG_HASH_CHECK,CFG_PAGER_LAZY_HASH_CHECK))
+
 # Use the pager for user TAs
 CFG_PAGED_USER_TA ?= $(CFG_WITH_PAGER)
 
+# Maximum number of pages each paged user TA can pin resident with
+# PTA_SYSTEM_PIN_RANGE to avoid page faults in latency critical code.
+# At most half of the pages of the pager can be pinned in total.
+CFG_PAGED_USER_TA_PIN_QUOTA ?= 16
+
+# Number of translation tables for user TAs shared by all threads, 0 means
+# two per thread but at least four. With CFG_PAGED_USER_TA=y tables of
+# inactive contexts are kept with their entries for as long as they aren't
+# needed by another context, a table only uses a physical page while it's
+# in use or kept.
+CFG_PGT_CACHE_ENTRIES ?= 0
+
+# When a TA invokes another TA, memory references covering whole pages of
+# the private memory of the calling TA are mapped in the called TA instead
+# of being copied through a temporary buffer, input buffers read-only.
+# Other memory references are still copied. Not supported with paged TAs.
+CFG_TA_PARAM_ZERO_COPY ?= n
+ifeq ($(CFG_PAGED_USER_TA),y)
+$(call force,CFG_TA_PARAM_ZERO_COPY,n,not supported with CFG_PAGED_USER_TA)
+endif
+
 # Enable support for detected undefined behavior in C
 # Uses a lot of memory, can't be enabled by default
 CFG_CORE_SANITIZE_UNDEFINED ?= n
@@ -336,9 +562,121 @@ CFG_TEE_CORE_EMBED_INTERNAL_TESTS ?= y
 # with specific core number and non-secure entry address.
 CFG_BOOT_SECONDARY_REQUEST ?= n
 
+# Parallel boot initialization: with CFG_BOOT_SYNC_CPU=y the secondary
+# cores are released as soon as the primary core has enabled its MMU,
+# instead of when it's done with its initialization, and take part in the
+# jobs of boot_parallel_run(), such as checking the hashes of the pageable
+# area. Not available when the secondary cores are started by ARM Trusted
+# Firmware, which only happens once normal world is booted.
+CFG_BOOT_PARALLEL_INIT ?= n
+$(eval $(call cfg-depends-all,CFG_BOOT_PARALLEL_INIT,CFG_BOOT_SYNC_CPU CFG_ARM32_core))
+
 # Default heap size for Core, 64 kB
 CFG_CORE_HEAP_SIZE ?= 65536
 
+# Per-CPU caches of freed small buffers in front of the core heap. With y
+# malloc() and free() of buffers of up to 512 bytes are served from a
+# cache of the current CPU without taking the heap lock, each CPU keeps up
+# to CFG_CORE_MALLOC_CACHE_DEPTH buffers per size class. Statistics are
+# available with the stats pseudo TA (CFG_WITH_STATS=y).
+CFG_CORE_MALLOC_CACHE ?= n
+CFG_CORE_MALLOC_CACHE_DEPTH ?= 4
+ifneq ($(filter y,$(CFG_VIRTUALIZATION) $(CFG_TEE_CORE_MALLOC_DEBUG)),)
+$(call force,CFG_CORE_MALLOC_CACHE,n)
+endif
+
+# Sampling profiler of the core heap. About one allocation per
+# CFG_CORE_MALLOC_PROFILE_PERIOD allocated bytes is sampled, sampled
+# bytes allocated, live and at peak are accounted per allocation site (up
+# to CFG_CORE_MALLOC_PROFILE_SITES sites). The profile is read with the
+# stats pseudo TA, which requires CFG_WITH_STATS=y.
+CFG_CORE_MALLOC_PROFILE ?= n
+CFG_CORE_MALLOC_PROFILE_PERIOD ?= 4096
+CFG_CORE_MALLOC_PROFILE_SITES ?= 64
+$(eval $(call cfg-depends-all,CFG_CORE_MALLOC_PROFILE,CFG_WITH_STATS))
+
+# Per TA (UUID) counters and log2 latency histograms of the system calls
+# made by user TAs, read with the stats pseudo TA which requires
+# CFG_WITH_STATS=y.
+CFG_SYSCALL_STATS ?= n
+$(eval $(call cfg-depends-all,CFG_SYSCALL_STATS,CFG_WITH_STATS))
+
+# Counters and time spent in normal world of the RPCs issued by the core,
+# per RPC command, globally and per session. Read with the stats pseudo TA
+# which requires CFG_WITH_STATS=y.
+CFG_THREAD_RPC_STATS ?= n
+$(eval $(call cfg-depends-all,CFG_THREAD_RPC_STATS,CFG_WITH_STATS))
+
+# Time slices of the threads running std calls. Once a thread has run
+# CFG_THREAD_QUANTUM_US since it last entered secure world, thread_yield()
+# called at safe points of long operations (such as RSA key generation)
+# returns to normal world as for a foreign interrupt, to let its scheduler
+# run other tasks. The time run in secure world is also accounted per
+# session, read with the stats pseudo TA.
+CFG_THREAD_QUANTUM ?= n
+CFG_THREAD_QUANTUM_US ?= 2000
+
+# Number of calls and time spent in each interrupt handler. Read with the
+# stats pseudo TA which requires CFG_WITH_STATS=y.
+CFG_ITR_STATS ?= n
+$(eval $(call cfg-depends-all,CFG_ITR_STATS,CFG_WITH_STATS))
+
+# Statistical sampler of the core. Every CFG_CORE_PROFILER_PERIOD_MS the
+# secure physical timer (interrupt CFG_CORE_PROFILER_IT) samples the
+# interrupted PC, thread and session, unwinds the call stack and folds it
+# into a table of CFG_CORE_PROFILER_STACKS unique call stacks. The table
+# is read with the stats pseudo TA which requires CFG_WITH_STATS=y. Only
+# the boot CPU is sampled and the secure physical timer must not be used
+# by the platform for anything else.
+CFG_CORE_PROFILER ?= n
+CFG_CORE_PROFILER_PERIOD_MS ?= 1
+CFG_CORE_PROFILER_IT ?= 29
+CFG_CORE_PROFILER_STACKS ?= 128
+$(eval $(call cfg-depends-all,CFG_CORE_PROFILER,CFG_WITH_STATS CFG_ARM64_core CFG_UNWIND))
+ifeq ($(CFG_WITH_PAGER),y)
+$(call force,CFG_CORE_PROFILER,n)
+endif
+
+# PMU counters (cycles, instructions, cache, TLB refills and branch
+# mispredicts) accumulated per session while a TA executes in user mode,
+# read with the stats pseudo TA which requires CFG_WITH_STATS=y. Counting
+# in secure state must be permitted by EL3 (MDCR_EL3.SPME).
+CFG_TA_PMU_STATS ?= n
+$(eval $(call cfg-depends-all,CFG_TA_PMU_STATS,CFG_WITH_STATS CFG_ARM64_core))
+
+# Asynchronous console: once boot is completed, the log messages of the
+# core are queued in a ring of CFG_CORE_ASYNC_LOG_SIZE bytes per CPU
+# instead of being written to the UART with interrupts masked. Deferred
+# work writes them to the console. Messages are dropped and counted when
+# a ring is full. A panic writes the queued messages synchronously.
+CFG_CORE_ASYNC_LOG ?= n
+CFG_CORE_ASYNC_LOG_SIZE ?= 4096
+ifeq ($(CFG_VIRTUALIZATION),y)
+$(call force,CFG_CORE_ASYNC_LOG,n)
+endif
+
+# Lock contention statistics: acquisitions, contended acquisitions, wait
+# and hold times of mutexes and of the pager spinlock, per lock and call
+# site (up to CFG_LOCK_STATS_SITES sites). Read with the stats pseudo TA
+# which requires CFG_WITH_STATS=y. The call sites of mutexes are only
+# known with CFG_MUTEX_DEBUG=y, which is enabled too.
+CFG_LOCK_STATS ?= n
+CFG_LOCK_STATS_SITES ?= 128
+$(eval $(call cfg-depends-all,CFG_LOCK_STATS,CFG_WITH_STATS))
+ifeq ($(CFG_LOCK_STATS),y)
+$(call force,CFG_MUTEX_DEBUG,y)
+endif
+
+# Boot time profiling: the boot phases of the primary CPU and each
+# initcall are timestamped with the system counter. The timings are
+# printed in the boot log and can be read with the stats pseudo TA when
+# CFG_WITH_STATS=y. Up to CFG_BOOT_PROFILE_ENTRIES phases are recorded.
+CFG_BOOT_PROFILE ?= n
+CFG_BOOT_PROFILE_ENTRIES ?= 64
+ifeq ($(CFG_VIRTUALIZATION),y)
+$(call force,CFG_BOOT_PROFILE,n)
+endif
+
 # Default size of nexus heap. 16 kB. Used only if CFG_VIRTUALIZATION
 # is enabled
 CFG_CORE_NEX_HEAP_SIZE ?= 16384
@@ -363,6 +701,14 @@ CFG_TA_FTRACE_SUPPORT ?= n
 #     display it in milliseconds
 CFG_FTRACE_US_MS ?= 10000
 
+# Function tracing: stream the records through a ring buffer shared with the
+# core instead of formatting them in a fixed size buffer in the TA. The core
+# drains the ring when the TA makes a syscall while it's half full and each
+# time the TA returns, so traces of long running TAs aren't truncated.
+# Function entries are dropped and counted when the ring is full.
+CFG_TA_FTRACE_STREAM ?= n
+$(eval $(call cfg-depends-all,CFG_TA_FTRACE_STREAM,CFG_TA_FTRACE_SUPPORT))
+
 # Enable to compile user TA libraries with profiling (-pg).
 # Depends on CFG_TA_GPROF_SUPPORT or CFG_TA_FTRACE_SUPPORT.
 CFG_ULIBS_MCOUNT ?= n
@@ -402,10 +748,33 @@ endif
 # Enable Global Platform Sockets support
 CFG_GP_SOCKETS ?= y
 
+# Size in bytes of the buffer each TCP socket of a TA reads ahead into.
+# Small receives, as when a TLS record header is read, are then served
+# from the buffer instead of each making a round trip to tee-supplicant.
+# 0 disables the read-ahead.
+CFG_TA_SOCKET_RECV_BUF_SIZE ?= 4096
+
 # Enable Secure Data Path support in OP-TEE core (TA may be invoked with
 # invocation parameters referring to specific secure memories).
 CFG_SECURE_DATA_PATH ?= n
 
+# Lets normal world allocate physically contiguous buffers from the
+# Secure Data Path carve-outs with OPTEE_MSG_CMD_SDP_ALLOC and pass them
+# to TAs as registered memory references. Released buffers are recycled
+# for later allocations of the same size class.
+CFG_SDP_POOL ?= n
+$(eval $(call cfg-depends-all,CFG_SDP_POOL,CFG_SECURE_DATA_PATH CFG_CORE_DYN_SHM))
+
+# Lets normal world register, with OPTEE_MSG_CMD_SET_TELEMETRY, a buffer in
+# registered shared memory which secure world keeps updated with thread,
+# heap, pager, RPC and per core busy time statistics. Normal world reads
+# it without calling secure world. The buffer is refreshed at the end of
+# standard calls, at most once every CFG_CORE_TELEMETRY_PERIOD_MS.
+# Heap statistics are only available with CFG_WITH_STATS=y.
+CFG_CORE_TELEMETRY ?= n
+CFG_CORE_TELEMETRY_PERIOD_MS ?= 100
+$(eval $(call cfg-depends-all,CFG_CORE_TELEMETRY,CFG_CORE_DYN_SHM))
+
 # Enable storage for TAs in secure storage, depends on CFG_REE_FS=y
 # TA binaries are stored encrypted in the REE FS and are protected by
 # metadata in secure storage.
@@ -419,11 +788,30 @@ $(eval $(call cfg-depends-all,CFG_SECSTOR_TA_MGMT_PTA,CFG_SECSTOR_TA))
 # Enable the pseudo TA for misc. auxilary services, extending existing
 # GlobalPlatform Core API (for example, re-seeding RNG entropy pool etc.)
 CFG_SYSTEM_PTA ?= y
+$(eval $(call cfg-depends-all,CFG_TA_HEAP_GROW,CFG_SYSTEM_PTA))
 
 # Enable the pseudo TA for enumeration of TEE based devices for the normal
 # world OS.
 CFG_DEVICE_ENUM_PTA ?= y
 
+# Static tracepoints at standard call entry/exit, RPC out/in, pager
+# faults, user TA entry/exit, system call entry/exit and REE FS requests.
+# They're enabled per category at runtime with the trace pseudo TA and log
+# timestamped events to per-CPU rings in shared memory read by normal
+# world, see lib/libutee/include/pta_trace.h.
+CFG_CORE_TRACEPOINTS ?= n
+
+# Log IMSG(), DMSG() and FMSG() messages of the core as binary records,
+# the address of the format string and the raw arguments, instead of
+# formatting them. The records are kept in a ring of
+# CFG_CORE_BINARY_TRACE_SIZE bytes per CPU, a power of two, and read with
+# PTA_TRACE_GET_LOG of the trace pseudo TA. scripts/decode_trace_log.py
+# formats them with the strings in tee.elf. Records are dropped while a
+# ring is full. EMSG() and MSG() are still written to the console.
+CFG_CORE_BINARY_TRACE ?= n
+CFG_CORE_BINARY_TRACE_SIZE ?= 16384
+$(eval $(call cfg-depends-all,CFG_CORE_BINARY_TRACE,CFG_CORE_TRACEPOINTS))
+
 # Define the number of cores per cluster used in calculating core position.
 # The cluster number is shifted by this value and added to the core ID,
 # so its value represents log2(cores/cluster).
@@ -434,6 +822,43 @@ CFG_CORE_CLUSTER_SHIFT ?= 2
 # non-secure memory).
 CFG_CORE_DYN_SHM ?= y
 
+# Enable asynchronous notifications from secure world to normal world,
+# signalled with the interrupt CFG_CORE_ASYNC_NOTIF_GIC_INTID. This also
+# enables asynchronous invocation of commands, OPTEE_MSG_CMD_INVOKE_ASYNC.
+CFG_CORE_ASYNC_NOTIF ?= n
+ifeq ($(CFG_CORE_ASYNC_NOTIF),y)
+ifeq ($(CFG_CORE_ASYNC_NOTIF_GIC_INTID),)
+$(error CFG_CORE_ASYNC_NOTIF=y requires CFG_CORE_ASYNC_NOTIF_GIC_INTID)
+endif
+endif
+# Seconds after which the result of a completed asynchronous command which
+# normal world hasn't retrieved is discarded and its ticket released.
+CFG_CORE_ASYNC_RESULT_TIMEOUT ?= 10
+
+# Serve random bytes to normal world with the fast call OPTEE_SMC_GET_RANDOM,
+# without allocating a thread. The bytes come from a pool of
+# CFG_CORE_FAST_RANDOM_POOL_SIZE bytes refilled from the RNG by a work, so
+# normal world must support OPTEE_MSG_CMD_DO_WORK for the pool to be
+# refilled after boot. The secure system time is always available with
+# OPTEE_SMC_GET_SYSTEM_TIME when CFG_SECURE_TIME_SOURCE_CNTPCT=y.
+CFG_CORE_FAST_RANDOM ?= n
+CFG_CORE_FAST_RANDOM_POOL_SIZE ?= 256
+
+# Cache the offset between REE time and system time for this many
+# milliseconds of system time, TEE_GetREETime() is then served without an
+# RPC to normal world until the cache expires. REE time adjustments done in
+# normal world are only seen when the cache is refreshed. 0 disables the
+# cache.
+CFG_CORE_REE_TIME_CACHE_MS ?= 0
+
+# Let TEE_GetSystemTime() read the physical counter directly in the TA
+# instead of making a syscall. This gives TAs access to CNTPCT and CNTFRQ,
+# a high resolution timer which may help timing side channel attacks.
+# Requires CFG_SECURE_TIME_SOURCE_CNTPCT=y so the TA and the core agree on
+# the system time.
+CFG_TA_FAST_SYSTEM_TIME ?= n
+$(eval $(call cfg-depends-all,CFG_TA_FAST_SYSTEM_TIME,CFG_SECURE_TIME_SOURCE_CNTPCT))
+
 # Enable support for reserved shared memory (shared memory in a carved out
 # memory area).
 CFG_CORE_RESERVED_SHM ?= y
@@ -455,6 +880,21 @@ CFG_TA_BIGNUM_MAX_BITS ?= 2048
 # Set this to a lower value to reduce the memory footprint.
 CFG_CORE_BIGNUM_MAX_BITS ?= 4096
 
+# Size in bytes of the buffer of random bytes each thread generates ahead
+# with its Fortuna output generator. Requests of up to a quarter of the
+# buffer, such as IVs and nonces, are copied from it, the bytes handed out
+# are wiped from the buffer.
+CFG_CORE_RNG_BUF_SIZE ?= 256
+
+# Generate ECC and DH key pairs ahead of use, from the deferred work queue,
+# for the curves and DH groups TAs generate key pairs for.
+# TEE_GenerateKey() is then served from the pool of
+# CFG_CORE_KEYGEN_POOL_DEPTH key pairs kept for each of up to
+# CFG_CORE_KEYGEN_POOL_GROUPS curves and groups.
+CFG_CORE_KEYGEN_POOL ?= n
+CFG_CORE_KEYGEN_POOL_DEPTH ?= 2
+CFG_CORE_KEYGEN_POOL_GROUPS ?= 4
+
 # Compiles mbedTLS for TA usage
 CFG_TA_MBEDTLS ?= y
 
@@ -495,6 +935,13 @@ endif
 # Enables backwards compatible derivation of RPMB and SSK keys
 CFG_CORE_HUK_SUBKEY_COMPAT ?= y
 
+# Caches subkeys derived from the hardware unique key by usage and
+# constant data, so deriving the same subkey again reads neither the HUK
+# nor computes an HMAC. The cache holds CFG_CORE_HUK_SUBKEY_CACHE_ENTRIES
+# subkeys in secure memory and is wiped when the system suspends.
+CFG_CORE_HUK_SUBKEY_CACHE ?= n
+CFG_CORE_HUK_SUBKEY_CACHE_ENTRIES ?= 8
+
 # Compress and encode conf.mk into the TEE core, and show the encoded string on
 # boot (with severity TRACE_INFO).
 CFG_SHOW_CONF_ON_BOOT ?= n
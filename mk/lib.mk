@@ -63,7 +63,9 @@ $(lib-shlibfile): $(objs) $(lib-needed-so-files)
 	@$(cmd-echo-silent) '  LD      $$@'
 	@mkdir -p $$(dir $$@)
 	$$(q)$$(LD$(sm)) $(lib-ldflags) $(lib-Ll-args) -shared \
-		-z max-page-size=4096 --soname=$(libuuid) -o $$@ $$^
+		-z max-page-size=4096 --hash-style=both \
+		$(if $(filter y,$(CFG_TA_RELR)),-z pack-relative-relocs) \
+		--soname=$(libuuid) -o $$@ $$^
 
 $(lib-shlibstrippedfile): $(lib-shlibfile)
 	@$(cmd-echo-silent) '  OBJCOPY $$@'
@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Copyright (c) 2026, Linaro Limited
+#
+# Formats the binary log records of the core (CFG_CORE_BINARY_TRACE=y), as
+# read with PTA_TRACE_GET_LOG of the trace pseudo TA, using the format
+# strings in tee.elf. See struct pta_trace_log_hdr and struct
+# pta_trace_log_rec in lib/libutee/include/pta_trace.h.
+#
+
+import argparse
+import re
+import struct
+import sys
+try:
+    from elftools.elf.elffile import ELFFile
+except ImportError:
+    print("""
+***
+Can't find elftools module. Probably it is not installed on your system.
+You can install this module with
+
+$ apt install python3-pyelftools
+
+if you are using Ubuntu. Or try to search for "pyelftools" or "elftools" in
+your package manager if you are using some other distribution.
+***
+""")
+    raise
+
+LOG_HDR = struct.Struct('<IIII')
+LOG_REC = struct.Struct('<HBBIQQQ')
+
+LEVELS = {1: 'E', 2: 'I', 3: 'D', 4: 'F'}
+
+CONV_RE = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?'
+                     r'(hh|h|ll|l|q|j|z|t)?(pUl|[diouxXcsDOUp%])')
+
+# long, size_t and ptrdiff_t follow the ELF class
+SIZE_BITS = {None: 32, 'hh': 8, 'h': 16, 'll': 64, 'q': 64, 'j': 64}
+
+
+class Image:
+    def __init__(self, elf_name):
+        self.segments = []
+        with open(elf_name, 'rb') as f:
+            elf = ELFFile(f)
+            self.long_bits = 64 if elf.elfclass == 64 else 32
+            for seg in elf.iter_segments():
+                if seg['p_type'] == 'PT_LOAD':
+                    self.segments.append((seg['p_vaddr'], seg.data()))
+
+    def get_str(self, va):
+        for start, data in self.segments:
+            if start <= va < start + len(data):
+                end = data.find(b'\0', va - start)
+                if end < 0:
+                    end = len(data)
+                return data[va - start:end].decode('utf-8', 'replace')
+        return None
+
+
+class Args:
+    def __init__(self, data):
+        self.data = data
+        self.offs = 0
+
+    def take(self, size):
+        if self.offs + size > len(self.data):
+            raise IndexError
+        val = self.data[self.offs:self.offs + size]
+        self.offs += size
+        return val
+
+    def u64(self):
+        return struct.unpack('<Q', self.take(8))[0]
+
+    def s64(self):
+        return struct.unpack('<q', self.take(8))[0]
+
+    def str(self):
+        size = struct.unpack('<H', self.take(2))[0]
+        return self.take(size).decode('utf-8', 'replace')
+
+
+def uuid_str(b):
+    lo, mid, hi_ver = struct.unpack('<IHH', b[:8])
+    return '{:08x}-{:04x}-{:04x}-{}-{}'.format(lo, mid, hi_ver,
+                                               b[8:10].hex(), b[10:].hex())
+
+
+def format_msg(img, fmt, args):
+    out = []
+    pos = 0
+    try:
+        for m in CONV_RE.finditer(fmt):
+            out.append(fmt[pos:m.start()])
+            pos = m.end()
+            flags, width, prec, size, conv = m.groups()
+            if conv == '%':
+                out.append('%')
+                continue
+            if width == '*':
+                width = str(args.s64())
+            if prec == '*':
+                prec = str(args.s64())
+            spec = '%' + flags + (width or '')
+            if prec is not None:
+                spec += '.' + prec
+            if conv == 'pUl':
+                out.append(uuid_str(args.take(16)))
+            elif conv == 's':
+                out.append((spec + 's') % args.str())
+            elif conv == 'p':
+                out.append('0x%x' % args.u64())
+            elif conv == 'c':
+                out.append((spec + 'c') % (args.u64() & 0xff))
+            elif conv in 'di' or conv == 'D':
+                out.append((spec + 'd') % args.s64())
+            else:
+                if conv in 'OU' or size in ('l', 'z', 't'):
+                    bits = img.long_bits
+                else:
+                    bits = SIZE_BITS[size]
+                val = args.u64() & ((1 << bits) - 1)
+                out.append((spec + {'U': 'd', 'u': 'd', 'O': 'o'}.get(
+                    conv, conv)) % val)
+    except IndexError:
+        out.append('<truncated>')
+        return ''.join(out)
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+
+def decode_recs(img, cpu, cntfrq, data, outf):
+    offs = 0
+    while offs + LOG_REC.size <= len(data):
+        (rec_len, level, thread, line, stamp, fmt_va,
+         func_va) = LOG_REC.unpack_from(data, offs)
+        if rec_len < LOG_REC.size or offs + rec_len > len(data):
+            print('Corrupt record at offset {}'.format(offs),
+                  file=sys.stderr)
+            return
+        args = Args(data[offs + LOG_REC.size:offs + rec_len])
+        offs += rec_len
+
+        fmt = img.get_str(fmt_va)
+        if fmt is None:
+            msg = '<unknown format at 0x{:x}>'.format(fmt_va)
+        else:
+            msg = format_msg(img, fmt, args)
+        func = img.get_str(func_va) or '?'
+        thr = '' if thread == 0xff else str(thread)
+        if cntfrq:
+            ts = '[{:.6f}] '.format(stamp / cntfrq)
+        else:
+            ts = ''
+        outf.write('{}{}/TC:{} {} {}:{} {}\n'.format(
+                   ts, LEVELS.get(level, 'U'), cpu, thr, func, line,
+                   msg.rstrip('\n')))
+
+
+def get_args():
+    parser = argparse.ArgumentParser(
+        description='Formats the binary log records read with '
+                    'PTA_TRACE_GET_LOG. The input is the concatenation '
+                    'of the output buffers of one or more reads.')
+    parser.add_argument('--elf', required=True,
+                        help='The tee.elf the records were logged by')
+    parser.add_argument('--input', type=argparse.FileType('rb'),
+                        default=sys.stdin.buffer,
+                        help='Binary log, default stdin')
+    parser.add_argument('--output', type=argparse.FileType('w'),
+                        default=sys.stdout,
+                        help='Formatted log, default stdout')
+    return parser.parse_args()
+
+
+def main():
+    args = get_args()
+    img = Image(args.elf)
+    data = args.input.read()
+    dropped = {}
+    offs = 0
+
+    while offs + LOG_HDR.size <= len(data):
+        cpu, length, drop, cntfrq = LOG_HDR.unpack_from(data, offs)
+        offs += LOG_HDR.size
+        decode_recs(img, cpu, cntfrq, data[offs:offs + length],
+                    args.output)
+        offs += length
+        if drop != dropped.get(cpu, 0):
+            args.output.write('*** CPU {}: {} records dropped\n'.format(
+                              cpu, drop - dropped.get(cpu, 0)))
+            dropped[cpu] = drop
+
+
+if __name__ == "__main__":
+    main()
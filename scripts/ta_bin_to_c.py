@@ -8,9 +8,23 @@ import argparse
 import array
 import os
 import re
+import struct
 import uuid
 import zlib
 
+# Must match EARLY_TA_LZ4_BLOCK_SIZE and EARLY_TA_LZ4_STORED in
+# core/arch/arm/include/kernel/early_ta.h
+LZ4_BLOCK_SIZE = 4096
+LZ4_STORED = 1 << 31
+# Must match EARLY_TA_XIP_ALIGN in core/arch/arm/include/kernel/early_ta.h
+XIP_ALIGN = 4096
+
+LZ4_MIN_MATCH = 4
+LZ4_MFLIMIT = 12
+LZ4_LAST_LITERALS = 5
+LZ4_MAX_OFFSET = 0xffff
+LZ4_RUN_MASK = 15
+
 
 def get_args():
 
@@ -31,13 +45,78 @@ def get_args():
     parser.add_argument(
         '--compress',
         dest="compress",
-        action="store_true",
+        nargs='?',
+        const='deflate',
+        choices=['deflate', 'lz4'],
         help='Compress the TA using the DEFLATE '
-        'algorithm')
+        'algorithm (default) or LZ4 blocks')
 
     return parser.parse_args()
 
 
+def lz4_len(n):
+    b = bytearray()
+    n -= LZ4_RUN_MASK
+    while n >= 255:
+        b.append(255)
+        n -= 255
+    b.append(n)
+    return b
+
+
+def lz4_sequence(literals, offset, match_len):
+    lit_len = len(literals)
+    ml = match_len - LZ4_MIN_MATCH if match_len else 0
+    b = bytearray()
+    b.append(min(lit_len, LZ4_RUN_MASK) << 4 | min(ml, LZ4_RUN_MASK))
+    if lit_len >= LZ4_RUN_MASK:
+        b += lz4_len(lit_len)
+    b += literals
+    if match_len:
+        b += struct.pack('<H', offset)
+        if ml >= LZ4_RUN_MASK:
+            b += lz4_len(ml)
+    return b
+
+
+def lz4_compress_block(data):
+    # Greedy compression in the LZ4 block format, see core/lib/lz4/lz4.c
+    n = len(data)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+    while i < n - LZ4_MFLIMIT:
+        seq = data[i:i + LZ4_MIN_MATCH]
+        cand = table.get(seq)
+        table[seq] = i
+        if cand is None or i - cand > LZ4_MAX_OFFSET:
+            i += 1
+            continue
+        match_len = LZ4_MIN_MATCH
+        max_len = n - LZ4_LAST_LITERALS - i
+        while (match_len < max_len and
+               data[cand + match_len] == data[i + match_len]):
+            match_len += 1
+        out += lz4_sequence(data[anchor:i], i - cand, match_len)
+        i += match_len
+        anchor = i
+    out += lz4_sequence(data[anchor:], 0, 0)
+    return out
+
+
+def lz4_compress(data):
+    out = bytearray()
+    for i in range(0, len(data), LZ4_BLOCK_SIZE):
+        block = data[i:i + LZ4_BLOCK_SIZE]
+        c = lz4_compress_block(block)
+        if len(c) < len(block):
+            out += struct.pack('<I', len(c)) + c
+        else:
+            out += struct.pack('<I', len(block) | LZ4_STORED) + block
+    return bytes(out)
+
+
 def main():
 
     args = get_args()
@@ -47,7 +126,9 @@ def main():
     with open(args.ta, 'rb') as ta:
         bytes = ta.read()
         uncompressed_size = len(bytes)
-        if args.compress:
+        if args.compress == 'lz4':
+            bytes = lz4_compress(bytes)
+        elif args.compress:
             bytes = zlib.compress(bytes)
         size = len(bytes)
 
@@ -56,8 +137,25 @@ def main():
             os.path.basename(__file__) + ' */\n\n')
     f.write('#include <compiler.h>\n')
     f.write('#include <kernel/early_ta.h>\n\n')
-    f.write('__extension__ const struct early_ta __early_ta_' +
-            ta_uuid.hex +
+    if args.compress:
+        f.write('static const uint8_t ta_bin_' + ta_uuid.hex + '[] = {\n')
+    else:
+        # Padded with zeroes to whole pages which can be mapped into the TA
+        f.write('static const uint8_t ta_bin_' + ta_uuid.hex + '[' +
+                str((size + XIP_ALIGN - 1) // XIP_ALIGN * XIP_ALIGN) +
+                ']\n__aligned(EARLY_TA_XIP_ALIGN) = {\n')
+    i = 0
+    while i < size:
+        if i % 8 == 0:
+            f.write('\t')
+        f.write(hex(bytes[i]) + ',')
+        i = i + 1
+        if i % 8 == 0 or i == size:
+            f.write('\n')
+        else:
+            f.write(' ')
+    f.write('};\n\n')
+    f.write('const struct early_ta __early_ta_' + ta_uuid.hex +
             '\n__early_ta __aligned(__alignof__(struct early_ta)) = {\n')
     f.write('\t.uuid = {\n')
     f.write('\t\t.timeLow = 0x{:08x},\n'.format(ta_uuid.time_low))
@@ -74,18 +172,7 @@ def main():
     if args.compress:
         f.write('\t.uncompressed_size = '
                 '{:d},\n'.format(uncompressed_size))
-    f.write('\t.ta = {\n')
-    i = 0
-    while i < size:
-        if i % 8 == 0:
-            f.write('\t\t')
-        f.write(hex(bytes[i]) + ',')
-        i = i + 1
-        if i % 8 == 0 or i == size:
-            f.write('\n')
-        else:
-            f.write(' ')
-    f.write('\t},\n')
+    f.write('\t.ta = ta_bin_' + ta_uuid.hex + ',\n')
     f.write('};\n')
     f.close()
 
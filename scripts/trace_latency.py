@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Copyright (c) 2026, Linaro Limited
+#
+# Breaks down the time spent in the core per layer from the records of the
+# core tracepoints (CFG_CORE_TRACEPOINTS=y). The input is the list of
+# events returned by PTA_TRACE_GET_EVENTS of the trace pseudo TA and a copy
+# of the trace buffer, see struct pta_trace_buf in
+# lib/libutee/include/pta_trace.h. Used together with the benchmark TA in
+# ta/bench.
+#
+
+import argparse
+import struct
+import sys
+
+EVENT_DESC = struct.Struct('<II24s')
+BUF_HDR = struct.Struct('<IIII')
+RING_HDR = struct.Struct('<QQ')
+REC = struct.Struct('<QIHHQQ')
+
+# Events opening and closing a layer, by name
+LAYERS = {
+    'std_entry': ('std_exit', 'std call'),
+    'ta_enter': ('ta_exit', 'user TA'),
+    'syscall_enter': ('syscall_exit', 'syscall'),
+    'rpc_out': ('rpc_in', 'normal world (RPC)'),
+    'fs_request': ('fs_done', 'REE FS'),
+}
+CLOSERS = {v[0]: k for k, v in LAYERS.items()}
+
+
+class Stats:
+    def __init__(self):
+        self.count = 0
+        self.total = 0
+        self.self_total = 0
+        self.min = None
+        self.max = 0
+
+    def add(self, duration, self_duration):
+        self.count += 1
+        self.total += duration
+        self.self_total += self_duration
+        if self.min is None or duration < self.min:
+            self.min = duration
+        self.max = max(self.max, duration)
+
+
+def read_events(f):
+    data = f.read()
+    names = {}
+    for offs in range(0, len(data) - EVENT_DESC.size + 1, EVENT_DESC.size):
+        ev_id, _, name = EVENT_DESC.unpack_from(data, offs)
+        names[ev_id] = name.split(b'\0', 1)[0].decode('utf-8', 'replace')
+    return names
+
+
+def read_records(f):
+    data = f.read()
+    num_cpus, num_recs, cntfrq, _ = BUF_HDR.unpack_from(data, 0)
+    ring_size = RING_HDR.size + num_recs * REC.size
+    recs = []
+    lost = 0
+
+    for cpu in range(num_cpus):
+        offs = BUF_HDR.size + cpu * ring_size
+        head = RING_HDR.unpack_from(data, offs)[0]
+        first = max(0, head - num_recs)
+        lost += first
+        for n in range(first, head):
+            recs.append(REC.unpack_from(data, offs + RING_HDR.size +
+                                        (n % num_recs) * REC.size))
+
+    recs.sort(key=lambda r: r[0])
+    return cntfrq, recs, lost
+
+
+def analyze(names, recs):
+    stats = {}
+    stacks = {}
+    unmatched = 0
+
+    for stamp, ev_id, thread, _, _, _ in recs:
+        name = names.get(ev_id)
+        stack = stacks.setdefault(thread, [])
+        if name in LAYERS:
+            # [opening event, start stamp, time spent in nested layers]
+            stack.append([name, stamp, 0])
+        elif name in CLOSERS:
+            if not stack or stack[-1][0] != CLOSERS[name]:
+                # Opened before the buffer was enabled or overwritten
+                stack.clear()
+                unmatched += 1
+                continue
+            opener, start, nested = stack.pop()
+            duration = stamp - start
+            stats.setdefault(opener, Stats()).add(duration,
+                                                  duration - nested)
+            if stack:
+                stack[-1][2] += duration
+
+    return stats, unmatched
+
+
+def get_args():
+    parser = argparse.ArgumentParser(
+        description='Prints the time spent per layer of the core from the '
+                    'records of the core tracepoints.')
+    parser.add_argument('--events', required=True,
+                        type=argparse.FileType('rb'),
+                        help='Output of PTA_TRACE_GET_EVENTS')
+    parser.add_argument('--buf', required=True, type=argparse.FileType('rb'),
+                        help='Copy of the trace buffer')
+    return parser.parse_args()
+
+
+def main():
+    args = get_args()
+    names = read_events(args.events)
+    cntfrq, recs, lost = read_records(args.buf)
+    stats, unmatched = analyze(names, recs)
+
+    def us(ticks):
+        return ticks * 1000000 / cntfrq
+
+    print('{:<20} {:>8} {:>12} {:>12} {:>12} {:>12}'.format(
+          'layer', 'count', 'mean us', 'self us', 'min us', 'max us'))
+    for opener, (_, label) in LAYERS.items():
+        s = stats.get(opener)
+        if not s:
+            continue
+        print('{:<20} {:>8} {:>12.2f} {:>12.2f} {:>12.2f} {:>12.2f}'.format(
+              label, s.count, us(s.total / s.count),
+              us(s.self_total / s.count), us(s.min), us(s.max)))
+    print('"self" excludes the time spent in nested layers')
+    if lost or unmatched:
+        print('{} records overwritten, {} unmatched'.format(lost, unmatched),
+              file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -21,6 +21,10 @@ link-ldflags += -Map=$(link-out-dir$(sm))/$(user-ta-uuid).map
 link-ldflags += --sort-section=alignment
 link-ldflags += -z max-page-size=4096 # OP-TEE always uses 4K alignment
 link-ldflags += --as-needed # Do not add dependency on unused shlib
+link-ldflags += --hash-style=both # ldelf prefers DT_GNU_HASH
+ifeq ($(CFG_TA_RELR),y)
+link-ldflags += -z pack-relative-relocs
+endif
 link-ldflags += $(link-ldflags$(sm))
 
 ifeq ($(CFG_TA_FTRACE_SUPPORT),y)
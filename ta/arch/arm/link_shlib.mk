@@ -20,6 +20,10 @@ cleanfiles += $(link-out-dir)/$(shlibuuid).ta
 shlink-ldflags  = $(LDFLAGS)
 shlink-ldflags += -shared -z max-page-size=4096
 shlink-ldflags += --as-needed # Do not add dependency on unused shlib
+shlink-ldflags += --hash-style=both # ldelf prefers DT_GNU_HASH
+ifeq ($(CFG_TA_RELR),y)
+shlink-ldflags += -z pack-relative-relocs
+endif
 
 shlink-ldadd  = $(LDADD)
 shlink-ldadd += $(addprefix -L,$(libdirs))
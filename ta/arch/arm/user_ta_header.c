@@ -89,8 +89,18 @@ const struct ta_head ta_head __section(".ta_head") = {
 	.depr_entry = UINT64_MAX,
 };
 
+#ifdef CFG_TA_HEAP_GROW
+/*
+ * Keeping the start of the heap in bss, the rest is mapped on demand by
+ * libutee up to a total of TA_DATA_SIZE.
+ */
+uint8_t ta_heap[TA_DATA_SIZE < CFG_TA_HEAP_GROW_INITIAL ?
+		TA_DATA_SIZE : CFG_TA_HEAP_GROW_INITIAL];
+const size_t ta_heap_max_size = TA_DATA_SIZE;
+#else
 /* Keeping the heap in bss */
 uint8_t ta_heap[TA_DATA_SIZE];
+#endif
 const size_t ta_heap_size = sizeof(ta_heap);
 
 const struct user_ta_property ta_props[] = {
@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (c) 2026, Linaro Limited */
+
+#include <ta_bench.h>
+#include <tee_internal_api.h>
+#include <tee_internal_api_extensions.h>
+#include <utee_defines.h>
+#include <utee_syscalls.h>
+#include <utee_types.h>
+#include <util.h>
+
+/* Smallest page size of the TA mappings */
+#define TOUCH_STRIDE	4096
+
+#ifdef CFG_TA_FAST_SYSTEM_TIME
+#include <arm_user_sysreg.h>
+
+static uint64_t get_ticks(void)
+{
+	return read_cntpct();
+}
+
+static uint32_t get_tick_freq(void)
+{
+	return read_cntfrq();
+}
+#else
+static uint64_t get_ticks(void)
+{
+	TEE_Time t = { };
+
+	TEE_GetSystemTime(&t);
+
+	return (uint64_t)t.seconds * TEE_TIME_MILLIS_BASE + t.millis;
+}
+
+static uint32_t get_tick_freq(void)
+{
+	return TEE_TIME_MILLIS_BASE;
+}
+#endif
+
+static void set_result(TEE_Param params[TEE_NUM_PARAMS], uint64_t ticks)
+{
+	reg_pair_from_64(ticks, &params[1].value.a, &params[1].value.b);
+	params[2].value.a = get_tick_freq();
+	params[2].value.b = 0;
+}
+
+static bool is_loop_pt(uint32_t pt)
+{
+	return pt == TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+				     TEE_PARAM_TYPE_VALUE_OUTPUT,
+				     TEE_PARAM_TYPE_VALUE_OUTPUT,
+				     TEE_PARAM_TYPE_NONE);
+}
+
+static TEE_Result touch_memref(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
+{
+	volatile const uint8_t *buf = params[0].memref.buffer;
+	size_t size = params[0].memref.size;
+	size_t n = 0;
+
+	if (pt != TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INPUT,
+				  TEE_PARAM_TYPE_NONE, TEE_PARAM_TYPE_NONE,
+				  TEE_PARAM_TYPE_NONE))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	for (n = 0; n < size; n += TOUCH_STRIDE)
+		(void)buf[n];
+	if (size)
+		(void)buf[size - 1];
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result bench_syscall(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
+{
+	TEE_Time t = { };
+	uint64_t start = 0;
+	uint32_t n = 0;
+
+	if (!is_loop_pt(pt))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	start = get_ticks();
+	/* Not TEE_GetSystemTime() which may not make a system call */
+	for (n = 0; n < params[0].value.a; n++)
+		utee_get_time(UTEE_TIME_CAT_SYSTEM, &t);
+	set_result(params, get_ticks() - start);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result bench_ta2ta(uint32_t pt, TEE_Param params[TEE_NUM_PARAMS])
+{
+	const TEE_UUID uuid = TA_BENCH_UUID;
+	TEE_TASessionHandle sess = TEE_HANDLE_NULL;
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t ret_orig = 0;
+	uint64_t start = 0;
+	uint32_t n = 0;
+
+	if (!is_loop_pt(pt))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	res = TEE_OpenTASession(&uuid, TEE_TIMEOUT_INFINITE, 0, NULL, &sess,
+				&ret_orig);
+	if (res)
+		return res;
+
+	start = get_ticks();
+	for (n = 0; n < params[0].value.a; n++) {
+		res = TEE_InvokeTACommand(sess, TEE_TIMEOUT_INFINITE,
+					  TA_BENCH_CMD_NOP, 0, NULL,
+					  &ret_orig);
+		if (res)
+			goto out;
+	}
+	set_result(params, get_ticks() - start);
+out:
+	TEE_CloseTASession(sess);
+
+	return res;
+}
+
+TEE_Result TA_CreateEntryPoint(void)
+{
+	return TEE_SUCCESS;
+}
+
+void TA_DestroyEntryPoint(void)
+{
+}
+
+TEE_Result TA_OpenSessionEntryPoint(uint32_t pt __unused,
+				    TEE_Param params[4] __unused,
+				    void **session __unused)
+{
+	return TEE_SUCCESS;
+}
+
+void TA_CloseSessionEntryPoint(void *sess __unused)
+{
+}
+
+TEE_Result TA_InvokeCommandEntryPoint(void *sess __unused, uint32_t cmd,
+				      uint32_t pt,
+				      TEE_Param params[TEE_NUM_PARAMS])
+{
+	switch (cmd) {
+	case TA_BENCH_CMD_NOP:
+		return TEE_SUCCESS;
+	case TA_BENCH_CMD_TOUCH_MEMREF:
+		return touch_memref(pt, params);
+	case TA_BENCH_CMD_SYSCALL:
+		return bench_syscall(pt, params);
+	case TA_BENCH_CMD_TA2TA:
+		return bench_ta2ta(pt, params);
+	default:
+		return TEE_ERROR_NOT_IMPLEMENTED;
+	}
+}
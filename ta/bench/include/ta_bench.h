@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/* Copyright (c) 2026, Linaro Limited */
+
+#ifndef __TA_BENCH_H
+#define __TA_BENCH_H
+
+/*
+ * Reference TA measuring the overhead of OP-TEE itself.
+ *
+ * The client times TA_BENCH_CMD_NOP and TA_BENCH_CMD_TOUCH_MEMREF from
+ * normal world, with no parameters for an empty invoke or with temporary,
+ * registered or non-contiguous memory references of the sizes of
+ * interest. The TA times the paths which don't leave secure world itself
+ * and reports the elapsed time as a number of ticks together with the
+ * frequency of the ticks. The ticks are those of the counter used for the
+ * stamps of the core tracepoints with CFG_TA_FAST_SYSTEM_TIME=y, else
+ * milliseconds of the system time, so run enough iterations.
+ *
+ * With CFG_CORE_TRACEPOINTS=y the time is broken down per layer by
+ * scripts/trace_latency.py from the records of the trace pseudo TA.
+ */
+
+#define TA_BENCH_UUID { 0x8a1e72f7, 0xd818, 0x4520, \
+			{ 0x87, 0xf6, 0xd0, 0x1c, 0x68, 0xf2, 0x89, 0xc1 } }
+
+/*
+ * Returns at once, whatever the parameters.
+ */
+#define TA_BENCH_CMD_NOP		0
+
+/*
+ * Reads one byte in each page of a buffer, so that mapping it is included.
+ *
+ * in	params[0].memref:	buffer
+ */
+#define TA_BENCH_CMD_TOUCH_MEMREF	1
+
+/*
+ * Makes a system call which only reads the system time, repeatedly.
+ *
+ * in	params[0].value.a:	number of iterations
+ * out	params[1].value.a:	upper 32 bits of elapsed ticks
+ * out	params[1].value.b:	lower 32 bits of elapsed ticks
+ * out	params[2].value.a:	ticks per second
+ */
+#define TA_BENCH_CMD_SYSCALL		2
+
+/*
+ * Invokes TA_BENCH_CMD_NOP in another instance of this TA repeatedly,
+ * opening and closing the session isn't included.
+ *
+ * in	params[0].value.a:	number of iterations
+ * out	params[1].value.a:	upper 32 bits of elapsed ticks
+ * out	params[1].value.b:	lower 32 bits of elapsed ticks
+ * out	params[2].value.a:	ticks per second
+ */
+#define TA_BENCH_CMD_TA2TA		3
+
+#endif /*__TA_BENCH_H*/
@@ -0,0 +1 @@
+user-ta-uuid := 8a1e72f7-d818-4520-87f6-d01c68f289c1
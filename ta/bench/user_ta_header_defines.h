@@ -0,0 +1,20 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/* Copyright (c) 2026, Linaro Limited */
+
+#ifndef __USER_TA_HEADER_DEFINES_H
+#define __USER_TA_HEADER_DEFINES_H
+
+#include <ta_bench.h>
+
+#define TA_UUID				TA_BENCH_UUID
+
+/*
+ * Not single instance, TA_BENCH_CMD_TA2TA opens a session to a second
+ * instance of this TA.
+ */
+#define TA_FLAGS			TA_FLAG_MULTI_SESSION
+
+#define TA_STACK_SIZE			(4 * 1024)
+#define TA_DATA_SIZE			(16 * 1024)
+
+#endif /*__USER_TA_HEADER_DEFINES_H*/
@@ -36,8 +36,14 @@ ta-mk-file-export-vars-$(sm) += CFG_SYSTEM_PTA
 ta-mk-file-export-vars-$(sm) += CFG_TA_DYNLINK
 ta-mk-file-export-vars-$(sm) += CFG_TEE_TA_LOG_LEVEL
 ta-mk-file-export-vars-$(sm) += CFG_TA_FTRACE_SUPPORT
+ta-mk-file-export-vars-$(sm) += CFG_TA_FTRACE_STREAM
+ta-mk-file-export-vars-$(sm) += CFG_TA_FAST_SYSTEM_TIME
 ta-mk-file-export-vars-$(sm) += CFG_UNWIND
 ta-mk-file-export-vars-$(sm) += CFG_TA_MCOUNT
+ta-mk-file-export-vars-$(sm) += CFG_TA_RELR
+ta-mk-file-export-vars-$(sm) += CFG_TA_HEAP_GROW
+ta-mk-file-export-vars-$(sm) += CFG_TA_HEAP_GROW_INITIAL
+ta-mk-file-export-vars-$(sm) += CFG_TA_HEAP_GROW_SIZE
 
 # Expand platform flags here as $(sm) will change if we have several TA
 # targets. Platform flags should not change after inclusion of ta/ta.mk.